@@ -0,0 +1,78 @@
+#pragma once
+
+#include <cstdint>
+
+// Wire format shared by DrawCommandList, the DrawService replayer and draw trace captures.
+// Only depends on <cstdint> so host-side tools can include it without the game SDK.
+
+/// Command opcodes. Values are part of the wire format; append only.
+enum class DrawCommandOp : uint16_t {
+    Invalid = 0,
+    SetHighlightColor,
+    SetRenderStateHighlight,
+    SetModelTransform,
+    ResetModelViewTransform,
+    SetShade,
+    ResetShade,
+    SetDefaultRenderState,
+    SetDefaultRenderStateUnilaterally,
+    RenderMesh,
+    RenderModelInstance,
+    SetTexWrapModes,
+    SetTexFiltering,
+    SetTexture,
+    EnableTextureStateFlag,
+    SetTexColor,
+    SetTexEnvMode,
+    SetTexCoord,
+    EnableBlendStateFlag,
+    EnableAlphaTestFlag,
+    EnableColorMaskFlag,
+    EnableCullFaceFlag,
+    EnableDepthMaskFlag,
+    EnableDepthTestFlag,
+    SetBlendFunc,
+    SetAlphaFunc,
+    SetDepthFunc,
+    SetDepthOffset,
+    SetTransparency,
+    ResetTransparency,
+    SetLighting,
+    SetFog,
+    DrawBoundingBox,
+    DrawPrims,
+    DrawPrimsIndexed,
+    DrawBufferPrimitives,
+    DrawBufferIndexedPrimitives,
+};
+
+/// Every command starts with this header. `size` covers the header and payload and is a multiple of 4.
+struct DrawCommandHeader {
+    DrawCommandOp op;
+    uint16_t size;
+};
+
+/// Payload layouts, one per opcode that takes arguments.
+namespace DrawCommandPayload {
+    struct HighlightColor { int32_t highlightType; float rgba[4]; };
+    struct RenderStateHighlight { int32_t highlightType; };
+    struct ModelTransform { float matrix[16]; };
+    struct Color { float rgba[4]; };
+    struct Pointer { void* ptr; };
+    struct ModelInstance { int* modelCount; int* modelList; uint8_t* drawInfo; uint32_t previewOnly; };
+    struct StagePair { int32_t first; int32_t second; int32_t stage; };
+    struct StageValue { uint32_t value; int32_t stage; };
+    struct Flag { uint32_t enabled; };
+    struct BlendFunc { uint32_t srcFactor; uint32_t dstFactor; };
+    struct AlphaFunc { uint32_t alphaFunc; float alphaRef; };
+    struct Value { uint32_t value; };
+    struct Fog { uint32_t enabled; float rgb[3]; float start; float end; };
+    struct BoundingBox { float bbox[6]; float rgba[4]; };
+    struct Prims { uint32_t primType; uint32_t startVertex; uint32_t primitiveCount; uint32_t flags; };
+    struct PrimsIndexed { uint32_t primType; int32_t indexStart; int32_t indexCount; };
+    struct BufferPrims { uint32_t bufferId; uint32_t primType; uint32_t startVertex; uint32_t vertexCount; };
+    struct BufferPrimsIndexed {
+        uint32_t bufferId; uint32_t primType; uint32_t startVertex; uint32_t vertexCount;
+        uint32_t startIndex; uint32_t indexCount;
+    };
+}
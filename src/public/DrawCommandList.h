@@ -0,0 +1,189 @@
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+#include <vector>
+
+#include "DrawCommandFormat.h"
+#include "cIGZDrawService.h"
+
+// Compact binary command list for deferred DrawService work.
+//
+// Record state changes, transforms, mesh/model renders and primitive draws from any thread, then hand the finished
+// list to cIGZDrawService::SubmitDrawCommandList. The service copies the bytes and replays them on the render thread
+// against the active renderer draw context during the requested pass. Recording into the same list for the next
+// frame while the previous submission replays is safe; the service double-buffers submissions per list ID.
+//
+// Pointer arguments (meshes, model lists) are stored by value and must stay alive until the list is replaced.
+// Pooled vertex buffers are recorded by handle; a buffer released before replay is skipped.
+//
+// Thread safety: a single DrawCommandList instance is not thread-safe; use one per recording thread.
+//
+// Example usage:
+//   DrawCommandList list;
+//   list.EnableDepthTestFlag(true);
+//   list.SetBlendFunc(D3DBLEND_SRCALPHA, D3DBLEND_INVSRCALPHA);
+//   list.DrawPrims(primType, 0, triangleCount, 0);
+//   list.Submit(drawService, DrawServicePass::PreDynamic, kMyListId);
+//
+
+class DrawCommandList
+{
+public:
+    /// Drops all recorded commands but keeps the allocation for the next frame.
+    void Reset() {
+        bytes_.clear();
+        commandCount_ = 0;
+    }
+
+    void Reserve(const size_t byteCount) {
+        bytes_.reserve(byteCount);
+    }
+
+    [[nodiscard]] const void* Data() const { return bytes_.data(); }
+    [[nodiscard]] uint32_t SizeBytes() const { return static_cast<uint32_t>(bytes_.size()); }
+    [[nodiscard]] uint32_t CommandCount() const { return commandCount_; }
+    [[nodiscard]] bool Empty() const { return commandCount_ == 0; }
+
+    /// Copies the list into the service for replay during `pass`. Returns false if the service rejected it.
+    bool Submit(cIGZDrawService* service, const DrawServicePass pass, const uint32_t listId,
+                const bool replayAtBegin = false) const {
+        return service && service->SubmitDrawCommandList(pass, listId, replayAtBegin, bytes_.data(), SizeBytes());
+    }
+
+    void SetHighlightColor(const int highlightType, const float r, const float g, const float b, const float a) {
+        Push_(DrawCommandOp::SetHighlightColor, DrawCommandPayload::HighlightColor{highlightType, {r, g, b, a}});
+    }
+    void SetRenderStateHighlight(const int highlightType) {
+        Push_(DrawCommandOp::SetRenderStateHighlight, DrawCommandPayload::RenderStateHighlight{highlightType});
+    }
+    void SetModelTransform(const float* transform4x4) {
+        DrawCommandPayload::ModelTransform payload{};
+        std::memcpy(payload.matrix, transform4x4, sizeof(payload.matrix));
+        Push_(DrawCommandOp::SetModelTransform, payload);
+    }
+    void ResetModelViewTransform() { Push_(DrawCommandOp::ResetModelViewTransform); }
+    void SetShade(const float* rgba) {
+        DrawCommandPayload::Color payload{};
+        std::memcpy(payload.rgba, rgba, sizeof(payload.rgba));
+        Push_(DrawCommandOp::SetShade, payload);
+    }
+    void ResetShade() { Push_(DrawCommandOp::ResetShade); }
+    void SetDefaultRenderState() { Push_(DrawCommandOp::SetDefaultRenderState); }
+    void SetDefaultRenderStateUnilaterally() { Push_(DrawCommandOp::SetDefaultRenderStateUnilaterally); }
+    void RenderMesh(void* mesh) {
+        Push_(DrawCommandOp::RenderMesh, DrawCommandPayload::Pointer{mesh});
+    }
+    void RenderModelInstance(int* modelCount, int* modelList, uint8_t* drawInfo, const bool previewOnly) {
+        Push_(DrawCommandOp::RenderModelInstance,
+              DrawCommandPayload::ModelInstance{modelCount, modelList, drawInfo, previewOnly ? 1u : 0u});
+    }
+
+    void SetTexWrapModes(const int uMode, const int vMode, const int stage) {
+        Push_(DrawCommandOp::SetTexWrapModes, DrawCommandPayload::StagePair{uMode, vMode, stage});
+    }
+    void SetTexFiltering(const int minFilter, const int magFilter, const int stage) {
+        Push_(DrawCommandOp::SetTexFiltering, DrawCommandPayload::StagePair{minFilter, magFilter, stage});
+    }
+    void SetTexture(const uint32_t texture, const int stage) {
+        Push_(DrawCommandOp::SetTexture, DrawCommandPayload::StageValue{texture, stage});
+    }
+    void EnableTextureStateFlag(const bool enable, const int stage) {
+        Push_(DrawCommandOp::EnableTextureStateFlag, DrawCommandPayload::StageValue{enable ? 1u : 0u, stage});
+    }
+    void SetTexColor(const float r, const float g, const float b, const float a) {
+        Push_(DrawCommandOp::SetTexColor, DrawCommandPayload::Color{{r, g, b, a}});
+    }
+    void SetTexEnvMode(const uint32_t envMode, const int stage) {
+        Push_(DrawCommandOp::SetTexEnvMode, DrawCommandPayload::StageValue{envMode, stage});
+    }
+    void SetTexCoord(const int texCoord, const int stage) {
+        Push_(DrawCommandOp::SetTexCoord, DrawCommandPayload::StageValue{static_cast<uint32_t>(texCoord), stage});
+    }
+
+    void EnableBlendStateFlag(const bool enabled) { PushFlag_(DrawCommandOp::EnableBlendStateFlag, enabled); }
+    void EnableAlphaTestFlag(const bool enabled) { PushFlag_(DrawCommandOp::EnableAlphaTestFlag, enabled); }
+    void EnableColorMaskFlag(const bool enabled) { PushFlag_(DrawCommandOp::EnableColorMaskFlag, enabled); }
+    void EnableCullFaceFlag(const bool enabled) { PushFlag_(DrawCommandOp::EnableCullFaceFlag, enabled); }
+    void EnableDepthMaskFlag(const bool enabled) { PushFlag_(DrawCommandOp::EnableDepthMaskFlag, enabled); }
+    void EnableDepthTestFlag(const bool enabled) { PushFlag_(DrawCommandOp::EnableDepthTestFlag, enabled); }
+    void SetBlendFunc(const uint32_t srcFactor, const uint32_t dstFactor) {
+        Push_(DrawCommandOp::SetBlendFunc, DrawCommandPayload::BlendFunc{srcFactor, dstFactor});
+    }
+    void SetAlphaFunc(const uint32_t alphaFunc, const float alphaRef) {
+        Push_(DrawCommandOp::SetAlphaFunc, DrawCommandPayload::AlphaFunc{alphaFunc, alphaRef});
+    }
+    void SetDepthFunc(const uint32_t depthFunc) {
+        Push_(DrawCommandOp::SetDepthFunc, DrawCommandPayload::Value{depthFunc});
+    }
+    void SetDepthOffset(const int depthOffset) {
+        Push_(DrawCommandOp::SetDepthOffset, DrawCommandPayload::Value{static_cast<uint32_t>(depthOffset)});
+    }
+    void SetTransparency() { Push_(DrawCommandOp::SetTransparency); }
+    void ResetTransparency() { Push_(DrawCommandOp::ResetTransparency); }
+    void SetLighting(const bool enableLighting) { PushFlag_(DrawCommandOp::SetLighting, enableLighting); }
+    void SetFog(const bool enableFog, const float* fogColorRgb, const float fogStart, const float fogEnd) {
+        DrawCommandPayload::Fog payload{enableFog ? 1u : 0u, {0.0f, 0.0f, 0.0f}, fogStart, fogEnd};
+        if (fogColorRgb) {
+            std::memcpy(payload.rgb, fogColorRgb, sizeof(payload.rgb));
+        }
+        Push_(DrawCommandOp::SetFog, payload);
+    }
+
+    void DrawBoundingBox(const float* bbox6, const float r, const float g, const float b, const float a) {
+        DrawCommandPayload::BoundingBox payload{{}, {r, g, b, a}};
+        std::memcpy(payload.bbox, bbox6, sizeof(payload.bbox));
+        Push_(DrawCommandOp::DrawBoundingBox, payload);
+    }
+    void DrawPrims(const uint32_t primType, const uint32_t startVertex, const uint32_t primitiveCount,
+                   const uint32_t flags) {
+        Push_(DrawCommandOp::DrawPrims, DrawCommandPayload::Prims{primType, startVertex, primitiveCount, flags});
+    }
+    void DrawPrimsIndexed(const uint8_t primType, const long indexStart, const long indexCount) {
+        Push_(DrawCommandOp::DrawPrimsIndexed,
+              DrawCommandPayload::PrimsIndexed{primType, static_cast<int32_t>(indexStart),
+                                               static_cast<int32_t>(indexCount)});
+    }
+    /// Pooled vertex buffer draws, see cIGZDrawService::DrawBufferPrimitives. The handle is resolved at replay.
+    void DrawBufferPrimitives(const DrawBufferHandle buffer, const uint32_t primType, const uint32_t startVertex,
+                              const uint32_t vertexCount) {
+        Push_(DrawCommandOp::DrawBufferPrimitives,
+              DrawCommandPayload::BufferPrims{buffer.id, primType, startVertex, vertexCount});
+    }
+    void DrawBufferIndexedPrimitives(const DrawBufferHandle buffer, const uint32_t primType,
+                                     const uint32_t startVertex, const uint32_t vertexCount,
+                                     const uint32_t startIndex, const uint32_t indexCount) {
+        Push_(DrawCommandOp::DrawBufferIndexedPrimitives,
+              DrawCommandPayload::BufferPrimsIndexed{buffer.id, primType, startVertex, vertexCount, startIndex,
+                                                     indexCount});
+    }
+
+private:
+    void Push_(const DrawCommandOp op) {
+        const DrawCommandHeader header{op, static_cast<uint16_t>(sizeof(DrawCommandHeader))};
+        Append_(&header, sizeof(header));
+        ++commandCount_;
+    }
+
+    template <typename T>
+    void Push_(const DrawCommandOp op, const T& payload) {
+        static_assert(std::is_trivially_copyable_v<T> && sizeof(T) % 4 == 0, "payloads must be 4-byte packed PODs");
+        const DrawCommandHeader header{op, static_cast<uint16_t>(sizeof(DrawCommandHeader) + sizeof(T))};
+        Append_(&header, sizeof(header));
+        Append_(&payload, sizeof(payload));
+        ++commandCount_;
+    }
+
+    void PushFlag_(const DrawCommandOp op, const bool enabled) {
+        Push_(op, DrawCommandPayload::Flag{enabled ? 1u : 0u});
+    }
+
+    void Append_(const void* data, const size_t size) {
+        const auto* begin = static_cast<const uint8_t*>(data);
+        bytes_.insert(bytes_.end(), begin, begin + size);
+    }
+
+    std::vector<uint8_t> bytes_;
+    uint32_t commandCount_ = 0;
+};
@@ -0,0 +1,100 @@
+#pragma once
+
+#include <cmath>
+#include <cstdint>
+
+#include "ViewFrustum.h"
+
+// Plain copy of the camera state, safe to use from any thread.
+//
+// cIGZS3DCameraService methods call into the live game camera and must stay on the main thread. The service captures
+// the active renderer camera into one of these on every tick where the camera changed (and whenever CaptureSnapshot
+// is called) and publishes it through a lock-free triple buffer. Worker threads fetch the latest copy with
+// GetLatestSnapshot and use the pure functions below for projection work; nothing here touches game memory.
+//
+// The game does not expose its view and projection matrices in a usable layout, so the snapshot carries the combined
+// world -> screen transform fitted by the service (the same one ProjectBatch uses), expressed relative to `origin`
+// and scaled by `invScale` for precision.
+//
+// Example usage:
+//   S3DCameraSnapshot snapshot{};
+//   if (cameraService->GetLatestSnapshot(snapshot)) {
+//       float screen[3];
+//       if (SnapshotProject(snapshot, worldXYZ, screen)) { ... }
+//   }
+//
+
+struct S3DCameraSnapshot {
+    uint32_t sequence;              // Increments with every capture; 0 means no capture yet.
+    float position[3];              // GetPosition at capture time.
+    float lookAt[3];                // GetLookAt at capture time.
+    float viewportWidth;            // Screen space size the transform and frustum were built for.
+    float viewportHeight;
+    float worldToScreen[4][4];      // worldToScreen[c] = contribution of local x, y, z, 1 to screen (x, y, depth, w).
+    float screenToWorld[4][4];      // Same layout for screen (x, y, depth, 1) -> local (x, y, z, w).
+    float origin[3];
+    float invScale;
+    ViewFrustum frustum;
+};
+
+namespace S3DCameraSnapshotDetail {
+    inline float Transform(const float (&columns)[4][4], const float x, const float y, const float z, float (&out)[3]) {
+        float r[4];
+        for (int k = 0; k < 4; ++k) {
+            r[k] = columns[0][k] * x + columns[1][k] * y + columns[2][k] * z + columns[3][k];
+        }
+        const float invW = std::fabs(r[3]) > 1.0e-6f ? 1.0f / r[3] : 0.0f;
+        out[0] = r[0] * invW;
+        out[1] = r[1] * invW;
+        out[2] = r[2] * invW;
+        return r[3];
+    }
+}
+
+/// World -> screen x, y and depth. Returns false for points behind the camera. Matches Project for on-screen points
+/// to a fraction of a pixel, but does not reject points outside the viewport.
+inline bool SnapshotProject(const S3DCameraSnapshot& snapshot, const float* world, float* outScreen) {
+    float result[3];
+    const float w = S3DCameraSnapshotDetail::Transform(snapshot.worldToScreen,
+                                                       (world[0] - snapshot.origin[0]) * snapshot.invScale,
+                                                       (world[1] - snapshot.origin[1]) * snapshot.invScale,
+                                                       (world[2] - snapshot.origin[2]) * snapshot.invScale, result);
+    outScreen[0] = result[0];
+    outScreen[1] = result[1];
+    outScreen[2] = result[2];
+    return w > 1.0e-6f;
+}
+
+/// Screen x, y and depth -> world. Returns false if the screen point maps to infinity.
+inline bool SnapshotUnProject(const S3DCameraSnapshot& snapshot, const float* screen, float* outWorld) {
+    float local[3];
+    const float w = S3DCameraSnapshotDetail::Transform(snapshot.screenToWorld, screen[0], screen[1], screen[2], local);
+    const float scale = 1.0f / snapshot.invScale;
+    for (int k = 0; k < 3; ++k) {
+        outWorld[k] = local[k] * scale + snapshot.origin[k];
+    }
+    return std::fabs(w) > 1.0e-6f;
+}
+
+/// Ray through a screen position, starting at depth 0 and pointing toward increasing depth. Unlike GetEyeRay the
+/// origin lies on the near plane rather than at the eye; the ray itself is the same line.
+inline bool SnapshotGetEyeRay(const S3DCameraSnapshot& snapshot, const float screenX, const float screenY,
+                              float* outOrigin, float* outDirection) {
+    const float nearPoint[3] = {screenX, screenY, 0.0f};
+    const float farPoint[3] = {screenX, screenY, 1.0f};
+    float farWorld[3];
+    if (!SnapshotUnProject(snapshot, nearPoint, outOrigin) || !SnapshotUnProject(snapshot, farPoint, farWorld)) {
+        return false;
+    }
+    const float dx = farWorld[0] - outOrigin[0];
+    const float dy = farWorld[1] - outOrigin[1];
+    const float dz = farWorld[2] - outOrigin[2];
+    const float length = std::sqrt(dx * dx + dy * dy + dz * dz);
+    if (!(length > 0.0f)) {
+        return false;
+    }
+    outDirection[0] = dx / length;
+    outDirection[1] = dy / length;
+    outDirection[2] = dz / length;
+    return true;
+}
@@ -0,0 +1,135 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+
+#if defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2) || defined(__SSE2__)
+#define TERRAIN_HEIGHTFIELD_SSE2 1
+#include <emmintrin.h>
+#else
+#define TERRAIN_HEIGHTFIELD_SSE2 0
+#endif
+
+// Read-only copy of the city's terrain height grid, safe to sample from any thread.
+//
+// cISTETerrain answers one height per virtual call and must stay on the main thread. The terrain service keeps a flat
+// float copy of the altitude at every grid vertex, refreshes it from the game a few rows per tick and around regions
+// clients mark dirty, and publishes each change as a new immutable version. AcquireHeightfield pins the latest
+// version without locking; the data stays valid and unchanged until the view is passed to ReleaseHeightfield, however
+// many versions are published meanwhile. Hold views for a batch of work, not across frames.
+//
+// Heights are stored row by row (z major). Each row starts on a 64-byte boundary, `rowStride` floats apart. Between
+// vertices the functions below interpolate bilinearly, the same surface the road-decal conformer and native terrain
+// picking use.
+//
+// Example usage:
+//   TerrainHeightfieldView view{};
+//   if (terrainService->AcquireHeightfield(view)) {
+//       SampleHeightfieldBatch(view, &points[0].x, points.size(), sizeof(points[0]), 0.05f);
+//       terrainService->ReleaseHeightfield(view);
+//   }
+//
+
+struct TerrainHeightfieldView {
+    const float* heights;   // verticesZ rows of verticesX heights.
+    uint32_t verticesX;     // Cells + 1 along world x.
+    uint32_t verticesZ;     // Cells + 1 along world z.
+    uint32_t rowStride;     // Floats between the starts of consecutive rows.
+    float gridSpacing;      // World units between vertices.
+    uint32_t version;       // Increments with every published change; 0 means no heightfield.
+    uint32_t slot;          // Internal; identifies the pinned copy to ReleaseHeightfield.
+};
+
+/// Height stored for grid vertex (x, z). No bounds checks.
+inline float GetHeightfieldVertex(const TerrainHeightfieldView& view, const uint32_t x, const uint32_t z) {
+    return view.heights[static_cast<size_t>(z) * view.rowStride + x];
+}
+
+/// True if the world position lies over the grid.
+inline bool HeightfieldContains(const TerrainHeightfieldView& view, const float worldX, const float worldZ) {
+    const float maxX = static_cast<float>(view.verticesX - 1) * view.gridSpacing;
+    const float maxZ = static_cast<float>(view.verticesZ - 1) * view.gridSpacing;
+    return worldX >= 0.0f && worldZ >= 0.0f && worldX <= maxX && worldZ <= maxZ;
+}
+
+/// Height of the grid vertex nearest to a world position, clamped to the grid.
+inline float SampleHeightfieldNearest(const TerrainHeightfieldView& view, const float worldX, const float worldZ) {
+    const float fx = std::clamp(worldX / view.gridSpacing + 0.5f, 0.0f, static_cast<float>(view.verticesX - 1));
+    const float fz = std::clamp(worldZ / view.gridSpacing + 0.5f, 0.0f, static_cast<float>(view.verticesZ - 1));
+    return GetHeightfieldVertex(view, static_cast<uint32_t>(fx), static_cast<uint32_t>(fz));
+}
+
+/// Bilinear height at a world position, clamped to the grid.
+inline float SampleHeightfield(const TerrainHeightfieldView& view, const float worldX, const float worldZ) {
+    const uint32_t cellsX = view.verticesX - 1;
+    const uint32_t cellsZ = view.verticesZ - 1;
+    const float fx = std::clamp(worldX / view.gridSpacing, 0.0f, static_cast<float>(cellsX));
+    const float fz = std::clamp(worldZ / view.gridSpacing, 0.0f, static_cast<float>(cellsZ));
+    const uint32_t x = (std::min)(static_cast<uint32_t>(fx), cellsX - 1);
+    const uint32_t z = (std::min)(static_cast<uint32_t>(fz), cellsZ - 1);
+    const float tx = fx - static_cast<float>(x);
+    const float tz = fz - static_cast<float>(z);
+    const float* row0 = view.heights + static_cast<size_t>(z) * view.rowStride;
+    const float* row1 = row0 + view.rowStride;
+    const float h0 = row0[x] + (row0[x + 1] - row0[x]) * tx;
+    const float h1 = row1[x] + (row1[x + 1] - row1[x]) * tx;
+    return h0 + (h1 - h0) * tz;
+}
+
+/// Sets y of `count` points to the bilinear terrain height plus `yOffset`. Each point starts with x, y, z floats and
+/// points are `strideBytes` apart, so arrays of xyz triples and of larger vertex structs work in place. Processes four
+/// points per step with SSE2 when available; results match SampleHeightfield exactly.
+inline void SampleHeightfieldBatch(const TerrainHeightfieldView& view, float* xyz, const size_t count,
+                                   const size_t strideBytes, const float yOffset = 0.0f) {
+    const auto point = [&](const size_t i) {
+        return reinterpret_cast<float*>(reinterpret_cast<unsigned char*>(xyz) + i * strideBytes);
+    };
+    size_t i = 0;
+#if TERRAIN_HEIGHTFIELD_SSE2
+    // Division rather than a multiply by the reciprocal keeps the cell choice identical to the scalar path.
+    const __m128 spacing = _mm_set1_ps(view.gridSpacing);
+    const __m128 zero = _mm_setzero_ps();
+    const __m128 maxFx = _mm_set1_ps(static_cast<float>(view.verticesX - 1));
+    const __m128 maxFz = _mm_set1_ps(static_cast<float>(view.verticesZ - 1));
+    const __m128 lastCellX = _mm_set1_ps(static_cast<float>(view.verticesX - 2));
+    const __m128 lastCellZ = _mm_set1_ps(static_cast<float>(view.verticesZ - 2));
+    const __m128 stride = _mm_set1_ps(static_cast<float>(view.rowStride));
+    const __m128 offset = _mm_set1_ps(yOffset);
+    for (; i + 4 <= count; i += 4) {
+        float* p[4] = {point(i), point(i + 1), point(i + 2), point(i + 3)};
+        const __m128 fx = _mm_min_ps(_mm_max_ps(_mm_div_ps(_mm_setr_ps(p[0][0], p[1][0], p[2][0], p[3][0]), spacing),
+                                                zero), maxFx);
+        const __m128 fz = _mm_min_ps(_mm_max_ps(_mm_div_ps(_mm_setr_ps(p[0][2], p[1][2], p[2][2], p[3][2]), spacing),
+                                                zero), maxFz);
+        const __m128 cellX = _mm_min_ps(_mm_cvtepi32_ps(_mm_cvttps_epi32(fx)), lastCellX);
+        const __m128 cellZ = _mm_min_ps(_mm_cvtepi32_ps(_mm_cvttps_epi32(fz)), lastCellZ);
+        const __m128 tx = _mm_sub_ps(fx, cellX);
+        const __m128 tz = _mm_sub_ps(fz, cellZ);
+        // Vertex offsets stay far below 2^24, so float arithmetic is exact here.
+        alignas(16) int32_t index[4];
+        _mm_store_si128(reinterpret_cast<__m128i*>(index),
+                        _mm_cvttps_epi32(_mm_add_ps(_mm_mul_ps(cellZ, stride), cellX)));
+        const float* r0[4];
+        for (int k = 0; k < 4; ++k) {
+            r0[k] = view.heights + index[k];
+        }
+        const size_t s = view.rowStride;
+        const __m128 h00 = _mm_setr_ps(r0[0][0], r0[1][0], r0[2][0], r0[3][0]);
+        const __m128 h10 = _mm_setr_ps(r0[0][1], r0[1][1], r0[2][1], r0[3][1]);
+        const __m128 h01 = _mm_setr_ps(r0[0][s], r0[1][s], r0[2][s], r0[3][s]);
+        const __m128 h11 = _mm_setr_ps(r0[0][s + 1], r0[1][s + 1], r0[2][s + 1], r0[3][s + 1]);
+        const __m128 h0 = _mm_add_ps(h00, _mm_mul_ps(_mm_sub_ps(h10, h00), tx));
+        const __m128 h1 = _mm_add_ps(h01, _mm_mul_ps(_mm_sub_ps(h11, h01), tx));
+        alignas(16) float heights[4];
+        _mm_store_ps(heights, _mm_add_ps(_mm_add_ps(h0, _mm_mul_ps(_mm_sub_ps(h1, h0), tz)), offset));
+        for (int k = 0; k < 4; ++k) {
+            p[k][1] = heights[k];
+        }
+    }
+#endif
+    for (; i < count; ++i) {
+        float* p = point(i);
+        p[1] = SampleHeightfield(view, p[0], p[2]) + yOffset;
+    }
+}
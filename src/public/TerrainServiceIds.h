@@ -0,0 +1,5 @@
+#pragma once
+
+// Unique IDs for the Terrain service and its interface.
+static constexpr auto kTerrainServiceID = 0x7E4A11C5;        // Random unique service ID
+static constexpr auto GZIID_cIGZTerrainService = 0x5B92D3F0;  // Random unique IID
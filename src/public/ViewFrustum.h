@@ -0,0 +1,272 @@
+#pragma once
+
+#include <bit>
+#include <cmath>
+#include <cstdint>
+
+// View frustum planes and batch visibility tests for plugin-side world geometry.
+//
+// Build a frustum once per frame, either from the active camera via cIGZS3DCameraService::GetViewFrustum or from a
+// row-vector (D3D style) view x projection matrix, then cull boxes or spheres in bulk before calling WorldToScreen or
+// issuing draws. The batch tests write one visibility bit per input and return the visible count; the loops are
+// branch-free over the inputs so the compiler can vectorize them.
+//
+// Tests are conservative: an object reported visible may still be just outside a frustum corner, but an object
+// reported culled is never on screen.
+//
+// Example usage:
+//   ViewFrustum frustum{};
+//   cameraService->GetViewFrustum(handle, io.DisplaySize.x, io.DisplaySize.y, frustum);
+//   std::vector<uint32_t> bits(ViewFrustumBitWords(count));
+//   CullBoxes(frustum, boxes.data(), count, bits.data());
+//   if (IsViewFrustumBitSet(bits.data(), i)) { ... }
+//
+
+/// Plane `nx*x + ny*y + nz*z + d = 0` with a unit normal pointing into the frustum.
+struct ViewFrustumPlane {
+    float nx;
+    float ny;
+    float nz;
+    float d;
+};
+
+enum ViewFrustumPlaneIndex : uint32_t {
+    kViewFrustumLeft = 0,
+    kViewFrustumRight,
+    kViewFrustumBottom,
+    kViewFrustumTop,
+    kViewFrustumNear,
+    kViewFrustumFar,
+    kViewFrustumPlaneCount
+};
+
+struct ViewFrustum {
+    ViewFrustumPlane planes[kViewFrustumPlaneCount];
+};
+
+/// Axis-aligned box in world space.
+struct CullBox {
+    float minX;
+    float minY;
+    float minZ;
+    float maxX;
+    float maxY;
+    float maxZ;
+};
+
+struct CullSphere {
+    float x;
+    float y;
+    float z;
+    float radius;
+};
+
+/// Plane that accepts every point. Used for the far plane when the camera does not expose one.
+constexpr ViewFrustumPlane kViewFrustumOpenPlane{0.0f, 0.0f, 0.0f, 1.0f};
+
+/// Number of 32-bit words needed for `count` visibility bits.
+constexpr uint32_t ViewFrustumBitWords(const uint32_t count) {
+    return (count + 31) / 32;
+}
+
+constexpr bool IsViewFrustumBitSet(const uint32_t* bits, const uint32_t index) {
+    return (bits[index >> 5] >> (index & 31)) & 1u;
+}
+
+inline ViewFrustumPlane NormalizeViewFrustumPlane(const float nx, const float ny, const float nz, const float d) {
+    const float length = std::sqrt(nx * nx + ny * ny + nz * nz);
+    if (length <= 0.0f) {
+        return kViewFrustumOpenPlane;
+    }
+    const float inv = 1.0f / length;
+    return {nx * inv, ny * inv, nz * inv, d * inv};
+}
+
+/// Extracts the planes of a row-vector view x projection matrix (clip = world * m, D3D depth range 0..w).
+inline void BuildViewFrustumFromMatrix(const float* m, ViewFrustum& out) {
+    const auto column = [m](const int c, const int r) { return m[r * 4 + c]; };
+    const auto combine = [&](const int c, const float sign) {
+        return NormalizeViewFrustumPlane(column(3, 0) + sign * column(c, 0), column(3, 1) + sign * column(c, 1),
+                                         column(3, 2) + sign * column(c, 2), column(3, 3) + sign * column(c, 3));
+    };
+    out.planes[kViewFrustumLeft] = combine(0, 1.0f);
+    out.planes[kViewFrustumRight] = combine(0, -1.0f);
+    out.planes[kViewFrustumBottom] = combine(1, 1.0f);
+    out.planes[kViewFrustumTop] = combine(1, -1.0f);
+    out.planes[kViewFrustumNear] = NormalizeViewFrustumPlane(column(2, 0), column(2, 1), column(2, 2), column(2, 3));
+    out.planes[kViewFrustumFar] = combine(2, -1.0f);
+}
+
+/// Builds the frustum from eye rays through the viewport corners (top-left, top-right, bottom-right, bottom-left) and
+/// the viewport center. Works for perspective and orthographic cameras. The near plane passes through the center ray
+/// origin; the far plane is open. Returns false if the rays are degenerate.
+inline bool BuildViewFrustumFromRays(const float (&cornerOrigins)[4][3], const float (&cornerDirections)[4][3],
+                                     const float (&centerOrigin)[3], const float (&centerDirection)[3],
+                                     ViewFrustum& out) {
+    const auto length = [](const float (&v)[3]) { return std::sqrt(v[0] * v[0] + v[1] * v[1] + v[2] * v[2]); };
+    const float centerLength = length(centerDirection);
+    if (!(centerLength > 0.0f)) {
+        return false;
+    }
+
+    float dir[4][3];
+    for (int i = 0; i < 4; ++i) {
+        const float l = length(cornerDirections[i]);
+        if (!(l > 0.0f)) {
+            return false;
+        }
+        for (int k = 0; k < 3; ++k) {
+            dir[i][k] = cornerDirections[i][k] / l;
+        }
+    }
+
+    // A point one unit down the center ray is inside every side plane; use it to orient the normals.
+    const float inside[3] = {
+        centerOrigin[0] + centerDirection[0] / centerLength,
+        centerOrigin[1] + centerDirection[1] / centerLength,
+        centerOrigin[2] + centerDirection[2] / centerLength,
+    };
+
+    const auto sidePlane = [&](const int a, const int b, ViewFrustumPlane& plane) {
+        const float* oA = cornerOrigins[a];
+        const float* oB = cornerOrigins[b];
+        const float u[3] = {dir[a][0], dir[a][1], dir[a][2]};
+        const float v[3] = {oB[0] + dir[b][0] - oA[0], oB[1] + dir[b][1] - oA[1], oB[2] + dir[b][2] - oA[2]};
+        const float nx = u[1] * v[2] - u[2] * v[1];
+        const float ny = u[2] * v[0] - u[0] * v[2];
+        const float nz = u[0] * v[1] - u[1] * v[0];
+        plane = NormalizeViewFrustumPlane(nx, ny, nz, -(nx * oA[0] + ny * oA[1] + nz * oA[2]));
+        if (plane.nx == 0.0f && plane.ny == 0.0f && plane.nz == 0.0f) {
+            return false;
+        }
+        if (plane.nx * inside[0] + plane.ny * inside[1] + plane.nz * inside[2] + plane.d < 0.0f) {
+            plane = {-plane.nx, -plane.ny, -plane.nz, -plane.d};
+        }
+        return true;
+    };
+
+    if (!sidePlane(0, 3, out.planes[kViewFrustumLeft]) ||
+        !sidePlane(1, 2, out.planes[kViewFrustumRight]) ||
+        !sidePlane(3, 2, out.planes[kViewFrustumBottom]) ||
+        !sidePlane(0, 1, out.planes[kViewFrustumTop])) {
+        return false;
+    }
+
+    out.planes[kViewFrustumNear] = NormalizeViewFrustumPlane(
+        centerDirection[0], centerDirection[1], centerDirection[2],
+        -(centerDirection[0] * centerOrigin[0] + centerDirection[1] * centerOrigin[1] +
+          centerDirection[2] * centerOrigin[2]));
+    out.planes[kViewFrustumFar] = kViewFrustumOpenPlane;
+    return true;
+}
+
+inline bool TestViewFrustumBox(const ViewFrustum& frustum, const CullBox& box) {
+    const float cx = (box.minX + box.maxX) * 0.5f;
+    const float cy = (box.minY + box.maxY) * 0.5f;
+    const float cz = (box.minZ + box.maxZ) * 0.5f;
+    const float ex = (box.maxX - box.minX) * 0.5f;
+    const float ey = (box.maxY - box.minY) * 0.5f;
+    const float ez = (box.maxZ - box.minZ) * 0.5f;
+    for (const auto& p : frustum.planes) {
+        const float reach = std::fabs(p.nx) * ex + std::fabs(p.ny) * ey + std::fabs(p.nz) * ez;
+        if (p.nx * cx + p.ny * cy + p.nz * cz + p.d + reach < 0.0f) {
+            return false;
+        }
+    }
+    return true;
+}
+
+inline bool TestViewFrustumSphere(const ViewFrustum& frustum, const CullSphere& sphere) {
+    for (const auto& p : frustum.planes) {
+        if (p.nx * sphere.x + p.ny * sphere.y + p.nz * sphere.z + p.d + sphere.radius < 0.0f) {
+            return false;
+        }
+    }
+    return true;
+}
+
+namespace ViewFrustumDetail {
+    /// Packs 0/1 flags into a bit word. Kept separate from the distance loops so those stay vectorizable.
+    inline uint32_t PackBits(const uint8_t* flags, const uint32_t count) {
+        uint32_t word = 0;
+        for (uint32_t i = 0; i < count; ++i) {
+            word |= static_cast<uint32_t>(flags[i]) << i;
+        }
+        return word;
+    }
+}
+
+/// Sets bit i of `outVisibleBits` (ViewFrustumBitWords(count) words) when box i intersects the frustum.
+/// Returns the number of visible boxes.
+inline uint32_t CullBoxes(const ViewFrustum& frustum, const CullBox* boxes, const uint32_t count,
+                          uint32_t* outVisibleBits) {
+    // Hoist |n| so the per-box work is the same multiply-adds for every plane.
+    float absN[kViewFrustumPlaneCount][3];
+    for (uint32_t p = 0; p < kViewFrustumPlaneCount; ++p) {
+        absN[p][0] = std::fabs(frustum.planes[p].nx);
+        absN[p][1] = std::fabs(frustum.planes[p].ny);
+        absN[p][2] = std::fabs(frustum.planes[p].nz);
+    }
+
+    // Per block: convert to center/extent in SoA form, then run each plane over the whole block. Every loop has a
+    // fixed shape with no early-outs, which is what lets the compiler vectorize it.
+    uint32_t visibleCount = 0;
+    float cx[32], cy[32], cz[32], ex[32], ey[32], ez[32];
+    float worst[32];
+    uint8_t inside[32];
+    for (uint32_t base = 0; base < count; base += 32) {
+        const uint32_t blockCount = count - base < 32 ? count - base : 32;
+        const CullBox* block = boxes + base;
+        for (uint32_t i = 0; i < blockCount; ++i) {
+            cx[i] = (block[i].minX + block[i].maxX) * 0.5f;
+            cy[i] = (block[i].minY + block[i].maxY) * 0.5f;
+            cz[i] = (block[i].minZ + block[i].maxZ) * 0.5f;
+            ex[i] = (block[i].maxX - block[i].minX) * 0.5f;
+            ey[i] = (block[i].maxY - block[i].minY) * 0.5f;
+            ez[i] = (block[i].maxZ - block[i].minZ) * 0.5f;
+            worst[i] = 0.0f;
+        }
+        for (uint32_t p = 0; p < kViewFrustumPlaneCount; ++p) {
+            const ViewFrustumPlane plane = frustum.planes[p];
+            const float ax = absN[p][0];
+            const float ay = absN[p][1];
+            const float az = absN[p][2];
+            for (uint32_t i = 0; i < blockCount; ++i) {
+                const float distance = plane.nx * cx[i] + plane.ny * cy[i] + plane.nz * cz[i] + plane.d +
+                    ax * ex[i] + ay * ey[i] + az * ez[i];
+                worst[i] = distance < worst[i] ? distance : worst[i];
+            }
+        }
+        for (uint32_t i = 0; i < blockCount; ++i) {
+            inside[i] = worst[i] >= 0.0f ? 1 : 0;
+        }
+        const uint32_t word = ViewFrustumDetail::PackBits(inside, blockCount);
+        outVisibleBits[base >> 5] = word;
+        visibleCount += static_cast<uint32_t>(std::popcount(word));
+    }
+    return visibleCount;
+}
+
+/// Sphere variant of CullBoxes.
+inline uint32_t CullSpheres(const ViewFrustum& frustum, const CullSphere* spheres, const uint32_t count,
+                            uint32_t* outVisibleBits) {
+    uint32_t visibleCount = 0;
+    uint8_t inside[32];
+    for (uint32_t base = 0; base < count; base += 32) {
+        const uint32_t blockCount = count - base < 32 ? count - base : 32;
+        const CullSphere* block = spheres + base;
+        for (uint32_t i = 0; i < blockCount; ++i) {
+            bool visible = true;
+            for (const auto& plane : frustum.planes) {
+                const float distance = plane.nx * block[i].x + plane.ny * block[i].y + plane.nz * block[i].z +
+                    plane.d + block[i].radius;
+                visible = visible & (distance >= 0.0f);
+            }
+            inside[i] = visible ? 1 : 0;
+        }
+        const uint32_t word = ViewFrustumDetail::PackBits(inside, blockCount);
+        outVisibleBits[base >> 5] = word;
+        visibleCount += static_cast<uint32_t>(std::popcount(word));
+    }
+    return visibleCount;
+}
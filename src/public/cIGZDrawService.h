@@ -27,6 +27,31 @@ enum class DrawServicePass : uint8_t {
 /// Callback invoked before and after a render pass.
 using DrawPassCallback = void (*)(DrawServicePass pass, bool begin, void* userData);
 
+/// Redundant state filter counters for the most recently completed frame.
+struct DrawStateFilterStats {
+    uint32_t forwardedCalls; ///< Filterable setter calls forwarded to the game.
+    uint32_t elidedCalls;    ///< Filterable setter calls skipped because the value was unchanged.
+};
+
+/// How a pooled vertex buffer is updated.
+enum class DrawBufferUsage : uint8_t {
+    Static = 0, ///< Written rarely. Kept on the device and recreated from a retained copy after device loss.
+    Dynamic,    ///< Rewritten every frame. Writes append to a ring and are not retained across device loss.
+};
+
+/// Opaque handle to a pooled vertex buffer. id 0 is invalid.
+struct DrawBufferHandle {
+    uint32_t id;
+};
+
+/// Pooled vertex buffer creation descriptor.
+struct DrawBufferDesc {
+    DrawBufferUsage usage;
+    uint32_t fvf;            ///< D3DFVF_* vertex format.
+    uint32_t vertexStride;   ///< Bytes per vertex; must match fvf.
+    uint32_t vertexCapacity; ///< Initial size in vertices (ring size for dynamic buffers), at most 65535.
+};
+
 // ReSharper disable once CppPolymorphicClassWithNonVirtualPublicDestructor
 /// Draw service interface.
 class cIGZDrawService : public cIGZUnknown {
@@ -128,4 +153,63 @@ public:
                                      uint32_t indexCount, uint32_t flags) = 0;
     virtual void DrawRect(SC4DrawContextHandle handle, void* drawTarget, int* rect) = 0;
     ///@}
+
+    /** @name Redundant State Filtering */
+    ///@{
+    /// Enables or disables skipping state setters whose value matches the last one set through the service.
+    /// Filtering only applies inside draw pass callbacks; the cache is reset at every pass boundary.
+    virtual void SetStateFilterEnabled(bool enabled) = 0;
+    /// Returns true when redundant state filtering is enabled.
+    [[nodiscard]] virtual bool IsStateFilterEnabled() const = 0;
+    /// Returns the forwarded/elided setter counts of the last completed frame.
+    [[nodiscard]] virtual DrawStateFilterStats GetStateFilterStats() const = 0;
+    ///@}
+
+    /** @name Deferred Command Lists */
+    ///@{
+    /// Submits a command list recorded with DrawCommandList (see DrawCommandList.h). Callable from any thread.
+    /// The bytes are copied; the list replays on the render thread against the active renderer draw context every
+    /// time `pass` runs (before the game pass if replayAtBegin, after it otherwise) until it is replaced by another
+    /// submission with the same listId or cleared.
+    virtual bool SubmitDrawCommandList(DrawServicePass pass, uint32_t listId, bool replayAtBegin,
+                                       const void* data, uint32_t sizeBytes) = 0;
+    /// Stops replaying a submitted command list.
+    virtual void ClearDrawCommandList(uint32_t listId) = 0;
+    ///@}
+
+    /** @name Frame Capture */
+    ///@{
+    /// Records every call made through the service to a binary trace at `path`, starting with the next frame.
+    /// All draw passes are hooked while capturing so pass boundaries appear in the trace. Inspect captures with
+    /// tools/draw-trace-analyzer. Returns false if a capture is already running.
+    virtual bool StartDrawCapture(const char* path) = 0;
+    /// Ends the capture at the next frame boundary and flushes the file.
+    virtual void StopDrawCapture() = 0;
+    /// Returns true from StartDrawCapture until the capture has been stopped.
+    [[nodiscard]] virtual bool IsDrawCaptureActive() const = 0;
+    ///@}
+
+    /** @name Vertex Buffer Pool */
+    ///@{
+    /// Service-owned IDirect3DVertexBuffer7 objects drawn with DrawPrimitiveVB / DrawIndexedPrimitiveVB, so geometry
+    /// does not have to be re-sent from system memory every frame. These talk to the D3D7 device directly and do
+    /// not touch the game draw context state. Thread safety: render thread only.
+    virtual DrawBufferHandle CreateDrawBuffer(const DrawBufferDesc& desc) = 0;
+    /// Releases a buffer. Safe to call with invalid handles (no-op).
+    virtual void ReleaseDrawBuffer(DrawBufferHandle buffer) = 0;
+    /// Static buffers: replaces the contents (growing as needed) and returns 0 in outStartVertex.
+    /// Dynamic buffers: appends to the ring and returns where the vertices landed. Draw them before the next write;
+    /// a write that wraps the ring discards earlier contents.
+    virtual bool WriteDrawBuffer(DrawBufferHandle buffer, const void* vertices, uint32_t vertexCount,
+                                 uint32_t* outStartVertex) = 0;
+    /// Sets the indices used by DrawBufferIndexedPrimitives. D3D7 has no index buffers, so the service retains them.
+    virtual bool SetDrawBufferIndices(DrawBufferHandle buffer, const uint16_t* indices, uint32_t indexCount) = 0;
+    /// Draws vertices [startVertex, startVertex + vertexCount) with the current device state. Fails if the range goes
+    /// past the vertices last written to a static buffer, or past the ring of a dynamic one.
+    virtual bool DrawBufferPrimitives(DrawBufferHandle buffer, uint32_t primType, uint32_t startVertex,
+                                      uint32_t vertexCount) = 0;
+    /// Indexed draw; indices are relative to startVertex and must be below vertexCount, or the draw fails.
+    virtual bool DrawBufferIndexedPrimitives(DrawBufferHandle buffer, uint32_t primType, uint32_t startVertex,
+                                             uint32_t vertexCount, uint32_t startIndex, uint32_t indexCount) = 0;
+    ///@}
 };
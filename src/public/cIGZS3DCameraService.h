@@ -4,6 +4,8 @@
 #include "cIS3DModelInstance.h"
 #include "cS3DVector2.h"
 #include "cS3DVector3.h"
+#include "S3DCameraSnapshot.h"
+#include "ViewFrustum.h"
 
 /// Opaque handle returned by the camera service. Version tag guards cross-build use.
 struct S3DCameraHandle {
@@ -12,6 +14,17 @@ struct S3DCameraHandle {
     bool owned; // true if service created the camera and may destroy it
 };
 
+/// Terrain hit returned by cIGZS3DCameraService::PickTerrain.
+struct S3DTerrainPick {
+    float position[3];
+    float normal[3];    // Unit surface normal, y up.
+    float distance;     // Along the eye ray, in world units.
+};
+
+/// Callback invoked on the main thread after the active renderer camera changed. `generation` is the new value of
+/// GetCameraGeneration().
+using S3DCameraChangedCallback = void (*)(uint32_t generation, void* userData);
+
 // ReSharper disable once CppPolymorphicClassWithNonVirtualPublicDestructor
 /// S3D camera service interface.
 class cIGZS3DCameraService : public cIGZUnknown {
@@ -78,4 +91,43 @@ public:
     virtual void SetDepthOffset(S3DCameraHandle handle, float offset) = 0;
     /// Returns the view state for the camera.
     virtual int GetViewState(S3DCameraHandle handle) = 0;
+
+    /// Builds the camera's view frustum from eye rays through the corners of a viewport of the given size (the
+    /// same screen space Project returns). The far plane is open. Call once per frame and cull with the batch helpers
+    /// in ViewFrustum.h.
+    virtual bool GetViewFrustum(S3DCameraHandle handle, float viewportWidth, float viewportHeight,
+                                ViewFrustum& outFrustum) = 0;
+
+    /// Projects `count` world points (xyz triples) to screen x, y and depth in `outXYZ`. Uses a native copy of the
+    /// camera transform that is re-checked against Project on every call, so results match Project to a fraction of
+    /// a pixel. `outVisible` (optional) receives 1 for points in front of the camera; unlike Project, off-viewport
+    /// points are not rejected. Falls back to per-point Project if the camera cannot be fitted.
+    virtual bool ProjectBatch(S3DCameraHandle handle, const float* xyz, size_t count, float* outXYZ,
+                              uint8_t* outVisible) = 0;
+    /// Inverse of ProjectBatch: screen x, y, depth triples to world positions. `outValid` is optional.
+    virtual bool UnProjectBatch(S3DCameraHandle handle, const float* xyz, size_t count, float* outXYZ,
+                                uint8_t* outValid) = 0;
+
+    /// Captures the camera into the snapshot buffer for a screen space of the given size. The service already
+    /// captures the active renderer camera whenever it changes; call this for other cameras or sizes. Main thread
+    /// only.
+    virtual bool CaptureSnapshot(S3DCameraHandle handle, float viewportWidth, float viewportHeight) = 0;
+    /// Copies the most recently captured snapshot. Safe from any thread and never blocks the capturing thread.
+    /// Returns false if nothing has been captured yet.
+    virtual bool GetLatestSnapshot(S3DCameraSnapshot& outSnapshot) = 0;
+
+    /// Returns a counter that increments whenever the active renderer camera's view, projection or viewport changes.
+    /// The service compares a hash of the camera state once per tick. Cache camera-dependent results together with
+    /// the generation and reuse them while it stays the same. 0 means the camera has not been seen yet. Any thread.
+    [[nodiscard]] virtual uint32_t GetCameraGeneration() const = 0;
+    /// Registers a callback invoked once per tick in which the camera generation changed.
+    virtual bool RegisterCameraChangedCallback(S3DCameraChangedCallback callback, void* userData,
+                                               uint32_t* outToken) = 0;
+    /// Unregisters a previously registered callback token. Safe to call from inside the callback.
+    virtual void UnregisterCameraChangedCallback(uint32_t token) = 0;
+
+    /// Picks the terrain under a screen position without the game's ray cast: the eye ray is marched over a native
+    /// copy of the city height grid. Results are shared per pixel until the camera moves or the next tick, so plugins
+    /// picking the same pixel in one frame pay once. Returns false off the map or outside a city. Main thread only.
+    virtual bool PickTerrain(S3DCameraHandle handle, int32_t screenX, int32_t screenY, S3DTerrainPick& outPick) = 0;
 };
@@ -0,0 +1,27 @@
+#pragma once
+
+#include "cIGZUnknown.h"
+#include "TerrainHeightfield.h"
+
+// ReSharper disable once CppPolymorphicClassWithNonVirtualPublicDestructor
+/// Terrain service interface: a shared, lock-free copy of the city's height grid.
+class cIGZTerrainService : public cIGZUnknown {
+public:
+    /// Returns the service ID (kTerrainServiceID).
+    [[nodiscard]] virtual uint32_t GetServiceID() const = 0;
+
+    /// Pins the latest heightfield. Safe from any thread and never blocks. Returns false (and leaves `outView`
+    /// empty) while no city is loaded or before the first copy. Every successful call must be paired with
+    /// ReleaseHeightfield.
+    virtual bool AcquireHeightfield(TerrainHeightfieldView& outView) = 0;
+    /// Unpins a view returned by AcquireHeightfield. Safe from any thread.
+    virtual void ReleaseHeightfield(const TerrainHeightfieldView& view) = 0;
+    /// Returns the version AcquireHeightfield would return now, or 0 if none. Cache terrain-dependent results together
+    /// with this value and rebuild them when it changes.
+    [[nodiscard]] virtual uint32_t GetHeightfieldVersion() const = 0;
+
+    /// Asks the service to re-read the terrain inside the world-space rectangle on the next tick, ahead of the
+    /// rolling refresh. Call after terraforming or when a live terrain query disagrees with the copy. Safe from any
+    /// thread.
+    virtual void MarkTerrainDirty(float minX, float minZ, float maxX, float maxZ) = 0;
+};
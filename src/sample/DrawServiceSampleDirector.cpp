@@ -1218,6 +1218,23 @@ namespace {
             }
 
             ImGui::SeparatorText("Render State");
+            bool stateFilter = drawService_->IsStateFilterEnabled();
+            if (ImGui::Checkbox("Redundant state filter", &stateFilter)) {
+                drawService_->SetStateFilterEnabled(stateFilter);
+            }
+            const DrawStateFilterStats filterStats = drawService_->GetStateFilterStats();
+            ImGui::Text("Last frame: forwarded=%u elided=%u", filterStats.forwardedCalls, filterStats.elidedCalls);
+            if (!drawService_->IsDrawCaptureActive()) {
+                if (ImGui::Button("Start Draw Capture")) {
+                    SetStatus(drawService_->StartDrawCapture("DrawServiceSample.dstrace")
+                                  ? "Capturing to DrawServiceSample.dstrace"
+                                  : "StartDrawCapture failed");
+                }
+            }
+            else if (ImGui::Button("Stop Draw Capture")) {
+                drawService_->StopDrawCapture();
+                SetStatus("Draw capture stopped");
+            }
             if (ImGui::Button("Default Render State")) {
                 drawService_->SetDefaultRenderState(drawContext_);
                 SetStatus("SetDefaultRenderState called");
@@ -260,6 +260,30 @@ namespace {
                 SetStatus("Depth offset applied");
             }
 
+            ImGui::SeparatorText("Snapshot");
+            if (ImGui::Button("Capture Snapshot")) {
+                const ImVec2 display = ImGui::GetIO().DisplaySize;
+                SetStatus(cameraService_->CaptureSnapshot(handle, display.x, display.y)
+                              ? "Snapshot captured"
+                              : "CaptureSnapshot failed");
+            }
+            S3DCameraSnapshot snapshot{};
+            if (cameraService_->GetLatestSnapshot(snapshot)) {
+                ImGui::Text("Sequence: %u | Viewport: %.0f x %.0f", snapshot.sequence, snapshot.viewportWidth,
+                            snapshot.viewportHeight);
+                ImGui::Text("Position: (%.3f, %.3f, %.3f)", snapshot.position[0], snapshot.position[1],
+                            snapshot.position[2]);
+                float snapshotScreen[3];
+                if (SnapshotProject(snapshot, worldPos_, snapshotScreen)) {
+                    ImGui::Text("SnapshotProject(World): (%.3f, %.3f, %.5f)", snapshotScreen[0], snapshotScreen[1],
+                                snapshotScreen[2]);
+                } else {
+                    ImGui::TextUnformatted("SnapshotProject(World): behind camera");
+                }
+            } else {
+                ImGui::TextUnformatted("No snapshot published yet.");
+            }
+
             ImGui::Text("Results: Project=%s | UnProject=%s | WorldToScreen=%s | EyeRay=%s",
                         BoolLabel(projectOk_), BoolLabel(unprojectOk_), BoolLabel(worldToScreenOk_), BoolLabel(eyeRayOk_));
 
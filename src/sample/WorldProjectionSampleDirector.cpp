@@ -12,10 +12,17 @@
 #include "GZServPtrs.h"
 #include "imgui.h"
 #include "public/ImGuiTexture.h"
+#include "public/cIGZDrawService.h"
 #include "public/cIGZImGuiService.h"
 #include "public/ImGuiServiceIds.h"
 #include "public/cIGZS3DCameraService.h"
+#include "public/ViewFrustum.h"
 #include "public/S3DCameraServiceIds.h"
+#include "public/TerrainServiceIds.h"
+#include "public/cIGZTerrainService.h"
+#include "sample/world-projection/WorldBillboardLayer.hpp"
+#include "sample/world-projection/WorldLabelLayer.hpp"
+#include "sample/world-projection/WorldOverlayPass.hpp"
 #ifndef NOMINMAX
 #define NOMINMAX 1
 #endif
@@ -57,6 +64,10 @@ namespace {
         bool conformToTerrain = false;
         bool terrainSnapToGrid = true;
         int terrainSampleStep = 16;
+        bool frustumCull = true;
+        uint32_t gridSegmentsTotal = 0;
+        uint32_t gridSegmentsVisible = 0;
+        bool gridProjectionReused = false;
         bool drawText = true;
         bool textBillboard = true;
         float textDepthScale = 0.002f;
@@ -73,7 +84,6 @@ namespace {
         float imageSize = 64.0f;
         float imageOffsetX = 0.0f;
         float imageOffsetY = 0.0f;
-        ImGuiTexture imageTexture;
         std::vector<uint8_t> imagePixels;
         uint32_t imageWidth = 0;
         uint32_t imageHeight = 0;
@@ -81,300 +91,107 @@ namespace {
         cIGZImGuiService* imguiService = nullptr;
     };
 
-    struct DepthDebugState {
-        cIGZImGuiService* imguiService = nullptr;
-        ImGuiTexture depthTexture;
-        ImGuiTexture maskedOverlayTexture;
-        std::vector<uint8_t> rgbaPixels;
-        std::vector<uint32_t> depthRaw;
-        std::vector<float> histogram; // normalized 0..1 values, 256 bins
-        uint32_t texWidth = 0;
-        uint32_t texHeight = 0;
-        float minDepth = 0.0f;
-        float maxDepth = 0.0f;
-        bool lastCaptureOk = false;
-        char status[128] = "Idle";
-        bool autoRefresh = false; // safer default
-        // Demo overlay settings
-        bool showMaskedOverlay = true;
-        float overlaySize = 96.0f;
-        float overlayBias = 80.0f; // depth units; tune to avoid z-fighting
-        ImVec4 overlayColor = ImVec4(0.2f, 0.8f, 1.0f, 1.0f);
+    struct GridPoint {
+        float x;
+        float y;
+        float z;
     };
+    static_assert(sizeof(GridPoint) == sizeof(float) * 3, "GridPoint arrays are passed as xyz triples");
+
+    // Grid settings the projected lines depend on, besides the camera.
+    struct GridCacheKey {
+        int gridSpacing = 0;
+        int gridExtent = 0;
+        float centerX = 0.0f;
+        float centerY = 0.0f;
+        float centerZ = 0.0f;
+        bool frustumCull = false;
+        float displayWidth = 0.0f;
+        float displayHeight = 0.0f;
+        bool conformToTerrain = false;
+        bool terrainSnapToGrid = false;
+        int terrainSampleStep = 0;
+        uint32_t heightfieldVersion = 0;
 
-    struct WorldProjectionData {
-        GridConfig grid;
-        DepthDebugState depth;
-        cIGZS3DCameraService* cameraService = nullptr;
-        S3DCameraHandle cameraHandle{nullptr, 0, false};
+        bool operator==(const GridCacheKey&) const = default;
     };
 
-    float ClampFloat(float value, float minValue, float maxValue);
-
-    ImU32 DepthColorRamp(float t) {
-        // Blue -> Cyan -> Green -> Yellow -> Red
-        t = ClampFloat(t, 0.0f, 1.0f);
-        float r = 0.0f, g = 0.0f, b = 0.0f;
-        if (t < 0.25f) {
-            const float k = t / 0.25f;
-            r = 0.0f;
-            g = k;
-            b = 1.0f;
-        }
-        else if (t < 0.5f) {
-            const float k = (t - 0.25f) / 0.25f;
-            r = 0.0f;
-            g = 1.0f;
-            b = 1.0f - k;
-        }
-        else if (t < 0.75f) {
-            const float k = (t - 0.5f) / 0.25f;
-            r = k;
-            g = 1.0f;
-            b = 0.0f;
-        }
-        else {
-            const float k = (t - 0.75f) / 0.25f;
-            r = 1.0f;
-            g = 1.0f - k;
-            b = 0.0f;
-        }
-        return IM_COL32(static_cast<int>(r * 255.0f),
-                        static_cast<int>(g * 255.0f),
-                        static_cast<int>(b * 255.0f),
-                        255);
-    }
-
-    bool CaptureDepthBuffer(DepthDebugState& state) {
-        if (!state.imguiService || !state.imguiService->IsDeviceReady()) {
-            sprintf_s(state.status, "ImGui device not ready");
-            state.lastCaptureOk = false;
-            return false;
-        }
-
-        IDirect3DDevice7* device = nullptr;
-        IDirectDraw7* dd = nullptr;
-        if (!state.imguiService->AcquireD3DInterfaces(&device, &dd) || !device || !dd) {
-            sprintf_s(state.status, "D3D/Draw not ready");
-            if (device) device->Release();
-            if (dd) dd->Release();
-            state.lastCaptureOk = false;
-            return false;
-        }
-
-        const HRESULT coop = dd->TestCooperativeLevel();
-        if (coop == DDERR_SURFACELOST || coop == DDERR_WRONGMODE || coop == DDERR_EXCLUSIVEMODEALREADYSET) {
-            sprintf_s(state.status, "Device not ready (0x%08X)", static_cast<uint32_t>(coop));
-            device->Release();
-            dd->Release();
-            state.lastCaptureOk = false;
-            return false;
-        }
-
-        IDirectDrawSurface7* colorSurface = nullptr;
-        HRESULT hr = device->GetRenderTarget(&colorSurface);
-        if (FAILED(hr) || !colorSurface) {
-            sprintf_s(state.status, "GetRenderTarget failed (0x%08X)", static_cast<uint32_t>(hr));
-            if (colorSurface) colorSurface->Release();
-            device->Release();
-            dd->Release();
-            state.lastCaptureOk = false;
-            return false;
-        }
-
-        DDSCAPS2 caps{};
-        caps.dwCaps = DDSCAPS_ZBUFFER;
-        IDirectDrawSurface7* zBuffer = nullptr;
-        hr = colorSurface->GetAttachedSurface(&caps, &zBuffer);
-        colorSurface->Release();
-        if (FAILED(hr) || !zBuffer) {
-            sprintf_s(state.status, "GetAttachedSurface(Z) failed (0x%08X)", static_cast<uint32_t>(hr));
-            if (zBuffer) zBuffer->Release();
-            device->Release();
-            dd->Release();
-            state.lastCaptureOk = false;
-            return false;
-        }
-
-        DDSURFACEDESC2 desc{};
-        desc.dwSize = sizeof(desc);
-        HRESULT hr2 = zBuffer->Lock(nullptr, &desc, DDLOCK_READONLY | DDLOCK_WAIT, nullptr);
-        if (FAILED(hr2)) {
-            sprintf_s(state.status, "Lock failed (0x%08X)", static_cast<uint32_t>(hr2));
-            zBuffer->Release();
-            device->Release();
-            dd->Release();
-            state.lastCaptureOk = false;
-            return false;
-        }
-
-        const uint32_t width = desc.dwWidth;
-        const uint32_t height = desc.dwHeight;
-        const uint32_t bitDepth = desc.ddpfPixelFormat.dwZBufferBitDepth;
-        const uint32_t bytesPerPixel = (bitDepth + 7) / 8;
-
-        if (bytesPerPixel != 2 && bytesPerPixel != 3 && bytesPerPixel != 4) {
-            sprintf_s(state.status, "Unsupported Z format: %u bpp", bitDepth);
-            zBuffer->Unlock(nullptr);
-            zBuffer->Release();
-            device->Release();
-            dd->Release();
-            state.lastCaptureOk = false;
-            return false;
-        }
-
-        uint32_t minVal = (std::numeric_limits<uint32_t>::max)();
-        uint32_t maxVal = 0;
-
-        auto* base = static_cast<uint8_t*>(desc.lpSurface);
-        state.depthRaw.resize(static_cast<size_t>(width) * height);
-
-        for (uint32_t y = 0; y < height; ++y) {
-            const uint8_t* row = base + y * desc.lPitch;
-            for (uint32_t x = 0; x < width; ++x) {
-                uint32_t value = 0;
-                switch (bytesPerPixel) {
-                case 2: value = reinterpret_cast<const uint16_t*>(row)[x];
-                    break;
-                case 3: {
-                    const uint8_t* p = row + x * 3;
-                    value = static_cast<uint32_t>(p[0]) | (static_cast<uint32_t>(p[1]) << 8) |
-                        (static_cast<uint32_t>(p[2]) << 16);
-                    break;
-                }
-                case 4: value = reinterpret_cast<const uint32_t*>(row)[x];
-                    break;
-                }
-                minVal = (std::min)(minVal, value);
-                maxVal = (std::max)(maxVal, value);
-            }
-        }
-
-        if (minVal == (std::numeric_limits<uint32_t>::max)()) {
-            sprintf_s(state.status, "No depth data");
-            zBuffer->Unlock(nullptr);
-            zBuffer->Release();
-            device->Release();
-            dd->Release();
-            state.lastCaptureOk = false;
-            return false;
-        }
-
-        const float denom = maxVal > minVal ? static_cast<float>(maxVal - minVal) : 1.0f;
-
-        state.rgbaPixels.resize(static_cast<size_t>(width) * height * 4);
-        std::vector<uint32_t> histogramCounts(256, 0);
-        uint32_t maxCount = 1;
-
-        for (uint32_t y = 0; y < height; ++y) {
-            const uint8_t* row = base + y * desc.lPitch;
-            for (uint32_t x = 0; x < width; ++x) {
-                uint32_t value = 0;
-                switch (bytesPerPixel) {
-                case 2: value = reinterpret_cast<const uint16_t*>(row)[x];
-                    break;
-                case 3: {
-                    const uint8_t* p = row + x * 3;
-                    value = static_cast<uint32_t>(p[0]) | (static_cast<uint32_t>(p[1]) << 8) |
-                        (static_cast<uint32_t>(p[2]) << 16);
-                    break;
-                }
-                case 4: value = reinterpret_cast<const uint32_t*>(row)[x];
-                    break;
-                }
-
-                state.depthRaw[static_cast<size_t>(y) * width + x] = value;
-
-                const float t = ClampFloat(static_cast<float>(value - minVal) / denom, 0.0f, 1.0f);
-                const ImU32 color = DepthColorRamp(t);
-                const size_t idx = (static_cast<size_t>(y) * width + x) * 4;
-                state.rgbaPixels[idx + 0] = static_cast<uint8_t>((color >> IM_COL32_R_SHIFT) & 0xFF);
-                state.rgbaPixels[idx + 1] = static_cast<uint8_t>((color >> IM_COL32_G_SHIFT) & 0xFF);
-                state.rgbaPixels[idx + 2] = static_cast<uint8_t>((color >> IM_COL32_B_SHIFT) & 0xFF);
-                state.rgbaPixels[idx + 3] = 255;
-
-                const uint32_t bin = (std::min)(255u, static_cast<uint32_t>(t * 255.0f + 0.5f));
-                maxCount = (std::max)(maxCount, ++histogramCounts[bin]);
-            }
-        }
+    // Reused between frames so the grid does not reallocate while the camera moves.
+    struct GridScratch {
+        std::vector<GridPoint> points;
+        std::vector<uint32_t> segmentStarts;
+        std::vector<CullBox> segmentBounds;
+        std::vector<uint32_t> visibleBits;
+        std::vector<uint32_t> screenIndex;
+        std::vector<GridPoint> projectInput;
+        std::vector<GridPoint> projectOutput;     // Screen x, y and depth.
+        std::vector<uint8_t> projectVisible;
+        std::vector<ImVec2> lines;                // Screen-space segment endpoints from the last rebuild.
+        GridCacheKey linesKey{};
+        uint32_t linesGeneration = 0;             // Camera generation the lines were projected with; 0 = stale.
+    };
 
-        zBuffer->Unlock(nullptr);
-        zBuffer->Release();
-        device->Release();
-        dd->Release();
+    GridScratch gGridScratch;
 
-        state.histogram.resize(256);
-        for (size_t i = 0; i < histogramCounts.size(); ++i) {
-            state.histogram[i] = static_cast<float>(histogramCounts[i]) / static_cast<float>(maxCount);
-        }
+    // Settings that generated stress labels and sprites depend on.
+    struct StressKey {
+        int gridExtent = 0;
+        float centerX = 0.0f;
+        float centerY = 0.0f;
+        float centerZ = 0.0f;
+        int count = 0;
+        uint32_t heightfieldVersion = 0;
 
-        state.texWidth = width;
-        state.texHeight = height;
-        state.minDepth = static_cast<float>(minVal);
-        state.maxDepth = static_cast<float>(maxVal);
-
-        state.depthTexture.Release();
-        if (!state.depthTexture.Create(state.imguiService, width, height, state.rgbaPixels.data(), true)) {
-            sprintf_s(state.status, "Texture upload failed");
-            state.lastCaptureOk = false;
-            return false;
-        }
+        bool operator==(const StressKey&) const = default;
+    };
 
-        sprintf_s(state.status, "Captured %ux%u, %u bpp", width, height, bitDepth);
-        state.lastCaptureOk = true;
-        return true;
-    }
+    struct WorldLabelState {
+        WorldLabelLayer layer;
+        bool initialized = false;
+        bool declutter = true;
+        bool occlusion = true;
+        WorldLabelLayer::LabelId textLabel = WorldLabelLayer::kInvalidLabel;
+        int stressLabelCount = 0;
+        std::vector<WorldLabelLayer::LabelId> stressLabels;
+        StressKey stressKey{};
+    };
 
-    void BuildMaskedOverlay(const DepthDebugState& depth, float screenX, float screenY) {
-        if (depth.texWidth == 0 || depth.texHeight == 0 || depth.depthRaw.empty() || !depth.imguiService) {
-            return;
-        }
+    struct WorldBillboardState {
+        static constexpr int kIconCount = 4;
+
+        WorldBillboardLayer layer;
+        bool initialized = false;
+        WorldBillboardLayer::ImageId image = WorldBillboardLayer::kInvalidImage;
+        WorldBillboardLayer::ImageId icons[kIconCount]{};
+        WorldBillboardLayer::SpriteId imageSprite = WorldBillboardLayer::kInvalidSprite;
+        int stressSpriteCount = 0;
+        float stressSpriteSize = 20.0f;
+        std::vector<WorldBillboardLayer::SpriteId> stressSprites;
+        StressKey stressKey{};
+    };
 
-        const int sizePx = static_cast<int>(depth.overlaySize);
-        const int half = sizePx / 2;
-
-        std::vector<uint8_t> maskPixels(static_cast<size_t>(sizePx) * sizePx * 4, 0);
-        const float r = depth.overlayColor.x;
-        const float g = depth.overlayColor.y;
-        const float b = depth.overlayColor.z;
-        const uint32_t pitch = depth.texWidth;
-
-        const int baseX = static_cast<int>(screenX) - half;
-        const int baseY = static_cast<int>(screenY) - half;
-        const uint32_t bias = depth.overlayBias > 0.0f ? static_cast<uint32_t>(depth.overlayBias) : 0u;
-        const int centerX = std::clamp(static_cast<int>(screenX), 0, static_cast<int>(depth.texWidth) - 1);
-        const int centerY = std::clamp(static_cast<int>(screenY), 0, static_cast<int>(depth.texHeight) - 1);
-        const uint32_t overlayDepth = depth.depthRaw[static_cast<size_t>(centerY) * pitch + static_cast<size_t>(
-            centerX)];
-
-        for (int y = 0; y < sizePx; ++y) {
-            int srcY = baseY + y;
-            if (srcY < 0 || srcY >= static_cast<int>(depth.texHeight)) {
-                continue;
-            }
-            for (int x = 0; x < sizePx; ++x) {
-                int srcX = baseX + x;
-                if (srcX < 0 || srcX >= static_cast<int>(depth.texWidth)) {
-                    continue;
-                }
-                const uint32_t sceneDepth = depth.depthRaw[static_cast<size_t>(srcY) * pitch + static_cast<size_t>(
-                    srcX)];
-                // Scene pixel is in front if it is closer (smaller depth) than our overlay center minus bias.
-                const bool sceneInFront = sceneDepth + bias < overlayDepth;
-
-                const size_t idx = (static_cast<size_t>(y) * sizePx + x) * 4;
-                maskPixels[idx + 0] = static_cast<uint8_t>(r * 255.0f);
-                maskPixels[idx + 1] = static_cast<uint8_t>(g * 255.0f);
-                maskPixels[idx + 2] = static_cast<uint8_t>(b * 255.0f);
-                maskPixels[idx + 3] = sceneInFront ? 0 : 255; // hide where building is in front
-            }
-        }
+    // Geometry drawn in the game's PreDynamic pass against its z-buffer, so buildings and hills hide it.
+    struct WorldOverlayState {
+        WorldOverlayPass pass;
+        cIGZDrawService* drawService = nullptr;
+        bool depthTestGrid = true;
+        float gridLineWidth = 2.0f;         // World units.
+        int zBias = 1;
+        bool depthTest = true;
+        bool drawMarker = true;
+        float markerSize = 96.0f;           // World units.
+        ImVec4 markerColor = ImVec4(0.2f, 0.8f, 1.0f, 0.8f);
+    };
 
-        auto* service = depth.imguiService;
-        ImGuiTexture* tex = const_cast<ImGuiTexture*>(&depth.maskedOverlayTexture);
-        tex->Release();
-        tex->Create(service, sizePx, sizePx, maskPixels.data(), true);
-    }
+    struct WorldProjectionData {
+        GridConfig grid;
+        WorldLabelState labels;
+        WorldBillboardState billboards;
+        WorldOverlayState overlay;
+        cIGZS3DCameraService* cameraService = nullptr;
+        cIGZTerrainService* terrainService = nullptr;
+        S3DCameraHandle cameraHandle{nullptr, 0, false};
+    };
 
     bool IsCityView() {
         const cISC4AppPtr app;
@@ -459,7 +276,9 @@ namespace {
         return true;
     }
 
-    void DrawWorldGrid(cS3DCamera* camera, cISTETerrain* terrain, const GridConfig& config) {
+    // With a world list, visible segments become depth-tested ribbons instead of screen-space lines.
+    void DrawWorldGrid(cS3DCamera* camera, cISTETerrain* terrain, const TerrainHeightfieldView* heightfield,
+                       GridConfig& config, WorldOverlayDrawList* worldList, const float worldLineWidth) {
         if (!camera || !config.enabled) {
             return;
         }
@@ -468,108 +287,158 @@ namespace {
         const ImU32 color = ImGui::ColorConvertFloat4ToU32(config.gridColor);
         const int stepValue = config.terrainSampleStep > 0 ? config.terrainSampleStep : 16;
         const float sampleStep = static_cast<float>(stepValue);
-
-        // Draw grid lines parallel to X axis (running along X direction)
-        for (float z = -config.gridExtent; z <= config.gridExtent; z += config.gridSpacing) {
-            float worldZ = config.centerZ + z;
-
-            // Start and end points along X axis
-            float startX = config.centerX - config.gridExtent;
-            float endX = config.centerX + config.gridExtent;
-
-            if (!config.conformToTerrain || !terrain) {
-                float screenX1, screenY1, screenX2, screenY2;
-                bool visible1 = gCameraService->WorldToScreen(gCameraHandle, startX, config.centerY, worldZ, screenX1,
-                                                              screenY1);
-                bool visible2 = gCameraService->WorldToScreen(gCameraHandle, endX, config.centerY, worldZ, screenX2,
-                                                              screenY2);
-
-                if (visible1 && visible2) {
-                    drawList->AddLine(
-                        ImVec2(screenX1, screenY1),
-                        ImVec2(screenX2, screenY2),
-                        color,
-                        config.lineThickness
-                    );
+        const bool conform = config.conformToTerrain && (heightfield || terrain);
+
+        // The projected lines only depend on the camera, the grid settings and, when conforming, the terrain, so
+        // frames with a static camera reuse them. Without the shared heightfield there is no cheap way to tell whether
+        // the terrain changed, so terrain-conforming grids are then rebuilt every frame.
+        auto& scratch = gGridScratch;
+        const ImVec2 displaySize = ImGui::GetIO().DisplaySize;
+        const GridCacheKey key{
+            config.gridSpacing, config.gridExtent, config.centerX, config.centerY, config.centerZ, config.frustumCull,
+            displaySize.x, displaySize.y, conform, conform && config.terrainSnapToGrid, conform ? stepValue : 0,
+            conform && heightfield ? heightfield->version : 0
+        };
+        const bool cacheable = !conform || heightfield;
+        const uint32_t generation = gCameraService->GetCameraGeneration();
+        config.gridProjectionReused = cacheable && generation != 0 && generation == scratch.linesGeneration &&
+                                      key == scratch.linesKey;
+        if (!config.gridProjectionReused) {
+            // Collect every grid segment first so the whole grid is culled in one batch before any WorldToScreen call.
+            scratch.points.clear();
+            scratch.segmentStarts.clear();
+            scratch.segmentBounds.clear();
+
+            const auto addLine = [&](const float startX, const float startZ, const float dirX, const float dirZ,
+                                     const float length) {
+                const float step = conform ? sampleStep : length;
+                if (!(step > 0.0f)) {
+                    return;
                 }
-                continue;
-            }
-
-            bool hasPrev = false;
-            ImVec2 prevPos{};
-            for (float x = startX; x <= endX; x += sampleStep) {
-                if (!terrain->LocationIsInBounds(x, worldZ)) {
-                    hasPrev = false;
-                    continue;
+                bool hasPrev = false;
+                for (float t = 0.0f; t <= length; t += step) {
+                    const float x = startX + dirX * t;
+                    const float z = startZ + dirZ * t;
+                    if (conform && !(heightfield ? HeightfieldContains(*heightfield, x, z)
+                                                 : terrain->LocationIsInBounds(x, z))) {
+                        hasPrev = false;
+                        continue;
+                    }
+
+                    // Heights from the shared heightfield are filled in below in one batch.
+                    float y = config.centerY;
+                    if (conform && !heightfield) {
+                        y = config.terrainSnapToGrid
+                                ? terrain->GetAltitudeAtNearestGrid(x, z)
+                                : terrain->GetAltitude(x, z);
+                    }
+
+                    const auto index = static_cast<uint32_t>(scratch.points.size());
+                    scratch.points.push_back({x, y, z});
+                    if (hasPrev) {
+                        scratch.segmentStarts.push_back(index - 1);
+                    }
+                    hasPrev = true;
                 }
+            };
 
-                const float y = config.terrainSnapToGrid
-                                    ? terrain->GetAltitudeAtNearestGrid(x, worldZ)
-                                    : terrain->GetAltitude(x, worldZ);
-                float sx, sy;
-                if (!gCameraService->WorldToScreen(gCameraHandle, x, y, worldZ, sx, sy)) {
-                    hasPrev = false;
-                    continue;
-                }
+            const float extent = static_cast<float>(config.gridExtent);
+            const float spacing = static_cast<float>((std::max)(config.gridSpacing, 1));
+            // Grid lines parallel to X axis (running along X direction)
+            for (float z = -extent; z <= extent; z += spacing) {
+                addLine(config.centerX - extent, config.centerZ + z, 1.0f, 0.0f, extent * 2.0f);
+            }
+            // Grid lines parallel to Z axis (running along Z direction)
+            for (float x = -extent; x <= extent; x += spacing) {
+                addLine(config.centerX + x, config.centerZ - extent, 0.0f, 1.0f, extent * 2.0f);
+            }
 
-                const ImVec2 curPos(sx, sy);
-                if (hasPrev) {
-                    drawList->AddLine(prevPos, curPos, color, config.lineThickness);
+            if (conform && heightfield) {
+                if (config.terrainSnapToGrid) {
+                    for (GridPoint& p : scratch.points) {
+                        p.y = SampleHeightfieldNearest(*heightfield, p.x, p.z);
+                    }
+                }
+                else if (!scratch.points.empty()) {
+                    SampleHeightfieldBatch(*heightfield, &scratch.points[0].x, scratch.points.size(),
+                                           sizeof(GridPoint));
                 }
-                prevPos = curPos;
-                hasPrev = true;
             }
-        }
+            for (const uint32_t start : scratch.segmentStarts) {
+                const GridPoint& a = scratch.points[start];
+                const GridPoint& b = scratch.points[start + 1];
+                scratch.segmentBounds.push_back({
+                    (std::min)(a.x, b.x), (std::min)(a.y, b.y), (std::min)(a.z, b.z),
+                    (std::max)(a.x, b.x), (std::max)(a.y, b.y), (std::max)(a.z, b.z)
+                });
+            }
 
-        // Draw grid lines parallel to Z axis (running along Z direction)
-        for (float x = -config.gridExtent; x <= config.gridExtent; x += config.gridSpacing) {
-            float worldX = config.centerX + x;
-
-            // Start and end points along Z axis
-            float startZ = config.centerZ - config.gridExtent;
-            float endZ = config.centerZ + config.gridExtent;
-
-            if (!config.conformToTerrain || !terrain) {
-                float screenX1, screenY1, screenX2, screenY2;
-                bool visible1 = gCameraService->WorldToScreen(gCameraHandle, worldX, config.centerY, startZ, screenX1,
-                                                              screenY1);
-                bool visible2 = gCameraService->WorldToScreen(gCameraHandle, worldX, config.centerY, endZ, screenX2,
-                                                              screenY2);
-
-                if (visible1 && visible2) {
-                    drawList->AddLine(
-                        ImVec2(screenX1, screenY1),
-                        ImVec2(screenX2, screenY2),
-                        color,
-                        config.lineThickness
-                    );
-                }
-                continue;
+            const auto segmentCount = static_cast<uint32_t>(scratch.segmentBounds.size());
+            scratch.visibleBits.assign(ViewFrustumBitWords(segmentCount), ~0u);
+            config.gridSegmentsTotal = segmentCount;
+            config.gridSegmentsVisible = segmentCount;
+
+            ViewFrustum frustum{};
+            if (config.frustumCull &&
+                gCameraService->GetViewFrustum(gCameraHandle, displaySize.x, displaySize.y, frustum)) {
+                config.gridSegmentsVisible = CullBoxes(frustum, scratch.segmentBounds.data(), segmentCount,
+                                                       scratch.visibleBits.data());
             }
 
-            bool hasPrev = false;
-            ImVec2 prevPos{};
-            for (float z = startZ; z <= endZ; z += sampleStep) {
-                if (!terrain->LocationIsInBounds(worldX, z)) {
-                    hasPrev = false;
+            // Only endpoints of visible segments are projected, shared endpoints once, all in a single batch call.
+            constexpr uint32_t kNotProjected = (std::numeric_limits<uint32_t>::max)();
+            const size_t pointCount = scratch.points.size();
+            scratch.screenIndex.assign(pointCount, kNotProjected);
+            scratch.projectInput.clear();
+            for (uint32_t s = 0; s < segmentCount; ++s) {
+                if (!IsViewFrustumBitSet(scratch.visibleBits.data(), s)) {
                     continue;
                 }
+                for (const uint32_t index : {scratch.segmentStarts[s], scratch.segmentStarts[s] + 1}) {
+                    if (scratch.screenIndex[index] == kNotProjected) {
+                        scratch.screenIndex[index] = static_cast<uint32_t>(scratch.projectInput.size());
+                        scratch.projectInput.push_back(scratch.points[index]);
+                    }
+                }
+            }
 
-                const float y = config.terrainSnapToGrid
-                                    ? terrain->GetAltitudeAtNearestGrid(worldX, z)
-                                    : terrain->GetAltitude(worldX, z);
-                float sx, sy;
-                if (!gCameraService->WorldToScreen(gCameraHandle, worldX, y, z, sx, sy)) {
-                    hasPrev = false;
+            const size_t projectCount = scratch.projectInput.size();
+            scratch.projectOutput.resize(projectCount);
+            scratch.projectVisible.resize(projectCount);
+            const bool projected = projectCount > 0 &&
+                gCameraService->ProjectBatch(gCameraHandle, &scratch.projectInput[0].x, projectCount,
+                                             &scratch.projectOutput[0].x, scratch.projectVisible.data());
+
+            scratch.lines.clear();
+            for (uint32_t s = 0; projected && s < segmentCount; ++s) {
+                if (!IsViewFrustumBitSet(scratch.visibleBits.data(), s)) {
                     continue;
                 }
+                const uint32_t a = scratch.screenIndex[scratch.segmentStarts[s]];
+                const uint32_t b = scratch.screenIndex[scratch.segmentStarts[s] + 1];
+                if (scratch.projectVisible[a] && scratch.projectVisible[b]) {
+                    const GridPoint& pa = scratch.projectOutput[a];
+                    const GridPoint& pb = scratch.projectOutput[b];
+                    scratch.lines.emplace_back(pa.x, pa.y);
+                    scratch.lines.emplace_back(pb.x, pb.y);
+                }
+            }
+            scratch.linesKey = key;
+            scratch.linesGeneration = (projected || projectCount == 0) && cacheable ? generation : 0;
+        }
 
-                const ImVec2 curPos(sx, sy);
-                if (hasPrev) {
-                    drawList->AddLine(prevPos, curPos, color, config.lineThickness);
+        if (worldList) {
+            for (uint32_t s = 0; s < config.gridSegmentsTotal; ++s) {
+                if (IsViewFrustumBitSet(scratch.visibleBits.data(), s) &&
+                    !worldList->AddLine(&scratch.points[scratch.segmentStarts[s]].x,
+                                        &scratch.points[scratch.segmentStarts[s] + 1].x, worldLineWidth, color)) {
+                    break;
                 }
-                prevPos = curPos;
-                hasPrev = true;
+            }
+        }
+        else {
+            for (size_t i = 0; i + 1 < scratch.lines.size(); i += 2) {
+                drawList->AddLine(scratch.lines[i], scratch.lines[i + 1], color, config.lineThickness);
             }
         }
 
@@ -603,149 +472,267 @@ namespace {
         }
     }
 
-    void DrawWorldText(cS3DCamera* camera, const GridConfig& config) {
-        if (!camera || !config.drawText) {
-            return;
+    // Two crossed upright quads on a ground square at the grid center. Drawn in the world pass, so buildings and
+    // hills in front of it cover it without any depth readback.
+    void AddWorldMarker(WorldOverlayDrawList& list, const GridConfig& config, const WorldOverlayState& state) {
+        const float x = config.centerX;
+        const float y = config.centerY;
+        const float z = config.centerZ;
+        const float half = state.markerSize * 0.5f;
+        const float top = y + state.markerSize;
+        const ImU32 color = ImGui::ColorConvertFloat4ToU32(state.markerColor);
+        const ImU32 groundColor = ImGui::ColorConvertFloat4ToU32(
+            ImVec4(state.markerColor.x, state.markerColor.y, state.markerColor.z, state.markerColor.w * 0.4f));
+
+        const float ground[12] = {x - half, y, z - half, x + half, y, z - half,
+                                  x + half, y, z + half, x - half, y, z + half};
+        const float alongX[12] = {x - half, top, z, x + half, top, z, x + half, y, z, x - half, y, z};
+        const float alongZ[12] = {x, top, z - half, x, top, z + half, x, y, z + half, x, y, z - half};
+        list.SetTexture(nullptr);
+        list.AddQuad(ground, groundColor);
+        list.AddQuad(alongX, color);
+        list.AddQuad(alongZ, color);
+    }
+
+    // Scatters `stressLabelCount` labels over the grid area, each keeping a fixed pseudo-random spot and priority.
+    void RebuildStressLabels(WorldLabelState& state, const GridConfig& config,
+                             const TerrainHeightfieldView* heightfield) {
+        for (const WorldLabelLayer::LabelId id : state.stressLabels) {
+            state.layer.Remove(id);
+        }
+        state.stressLabels.clear();
+
+        char text[32];
+        WorldLabelDesc desc{};
+        desc.text = text;
+        desc.offsetY = -6.0f;
+        desc.flags = kWorldLabelOutline;
+        const auto extent = static_cast<float>(config.gridExtent);
+        for (int i = 0; i < state.stressLabelCount; ++i) {
+            uint32_t hash = static_cast<uint32_t>(i + 1) * 2654435761u;
+            const auto next = [&hash]() {
+                hash ^= hash >> 15;
+                hash *= 0x2C1B3C6Du;
+                hash ^= hash >> 12;
+                return static_cast<float>(hash & 0xFFFF) / 65535.0f;
+            };
+            const float x = config.centerX + (next() * 2.0f - 1.0f) * extent;
+            const float z = config.centerZ + (next() * 2.0f - 1.0f) * extent;
+            desc.position[0] = x;
+            desc.position[1] = heightfield && HeightfieldContains(*heightfield, x, z)
+                                   ? SampleHeightfield(*heightfield, x, z)
+                                   : config.centerY;
+            desc.position[2] = z;
+            desc.priority = static_cast<int32_t>(hash % 4);
+            desc.color = desc.priority == 3 ? IM_COL32(255, 220, 80, 255) : IM_COL32(230, 230, 230, 255);
+            std::snprintf(text, sizeof(text), "Lot %d", i + 1);
+            state.stressLabels.push_back(state.layer.Add(desc));
         }
+    }
 
-        float screenX = 0.0f;
-        float screenY = 0.0f;
-        float depth = 0.0f;
-        if (!gCameraService->WorldToScreen(gCameraHandle, config.centerX, config.centerY, config.centerZ, screenX,
-                                           screenY, &depth)) {
+    void DrawWorldLabels(cS3DCamera* camera, WorldLabelState& state, const GridConfig& config,
+                         const TerrainHeightfieldView* heightfield) {
+        if (!camera || !config.imguiService) {
             return;
         }
-
-        ImDrawList* drawList = ImGui::GetBackgroundDrawList();
-        float alpha = config.textColor.w;
-        if (!config.textBillboard) {
-            const float fade = 1.0f / (1.0f + depth * config.textDepthScale);
-            alpha *= ClampFloat(fade, 0.2f, 1.0f);
+        if (!state.initialized) {
+            state.initialized = state.layer.Init(config.imguiService);
+            if (!state.initialized) {
+                return;
+            }
         }
 
-        ImVec4 textColorF = config.textColor;
-        textColorF.w = ClampFloat(alpha, 0.0f, 1.0f);
-        const ImU32 textColor = ImGui::ColorConvertFloat4ToU32(textColorF);
-        const ImU32 outlineColor = IM_COL32(0, 0, 0, 210);
-        const ImU32 shadowColor = IM_COL32(0, 0, 0, 160);
-        const ImU32 leaderColor = IM_COL32(0, 0, 0, 180);
-
-        const char* label = config.text;
-        const ImVec2 labelSize = ImGui::CalcTextSize(label);
-
-        const ImVec2 anchor(screenX, screenY);
-        ImVec2 textPos = ImVec2(
-            screenX + config.textOffsetX - labelSize.x * 0.5f,
-            screenY + config.textOffsetY - labelSize.y
-        );
-
-        if (config.textLeaderLine && (config.textOffsetX != 0.0f || config.textOffsetY != 0.0f)) {
-            drawList->AddLine(anchor,
-                              ImVec2(textPos.x + labelSize.x * 0.5f, textPos.y + labelSize.y),
-                              leaderColor,
-                              1.5f);
+        // The panel's own label follows the settings; it always wins declutter so it stays visible among the others.
+        if (config.drawText) {
+            WorldLabelDesc desc{};
+            desc.position[0] = config.centerX;
+            desc.position[1] = config.centerY;
+            desc.position[2] = config.centerZ;
+            desc.text = config.text;
+            desc.color = ImGui::ColorConvertFloat4ToU32(config.textColor);
+            desc.priority = 1000;
+            desc.offsetX = config.textOffsetX;
+            desc.offsetY = config.textOffsetY;
+            desc.flags = (config.textOutline ? kWorldLabelOutline : 0u) | (config.textShadow ? kWorldLabelShadow : 0u) |
+                         (config.textBackground ? kWorldLabelBackground : 0u) |
+                         (config.textLeaderLine ? kWorldLabelLeaderLine : 0u) | kWorldLabelNoOcclusion;
+            if (state.textLabel == WorldLabelLayer::kInvalidLabel) {
+                state.textLabel = state.layer.Add(desc);
+            }
+            else {
+                state.layer.Update(state.textLabel, desc);
+            }
         }
-
-        if (config.textBackground) {
-            const ImVec2 pad(4.0f, 2.0f);
-            drawList->AddRectFilled(
-                ImVec2(textPos.x - pad.x, textPos.y - pad.y),
-                ImVec2(textPos.x + labelSize.x + pad.x, textPos.y + labelSize.y + pad.y),
-                IM_COL32(0, 0, 0, 140),
-                4.0f
-            );
+        else if (state.textLabel != WorldLabelLayer::kInvalidLabel) {
+            state.layer.Remove(state.textLabel);
+            state.textLabel = WorldLabelLayer::kInvalidLabel;
         }
 
-        if (config.textShadow) {
-            drawList->AddText(ImVec2(textPos.x + 2.0f, textPos.y + 2.0f), shadowColor, label);
-        }
-        if (config.textOutline) {
-            drawList->AddText(ImVec2(textPos.x + 1.0f, textPos.y), outlineColor, label);
-            drawList->AddText(ImVec2(textPos.x - 1.0f, textPos.y), outlineColor, label);
-            drawList->AddText(ImVec2(textPos.x, textPos.y + 1.0f), outlineColor, label);
-            drawList->AddText(ImVec2(textPos.x, textPos.y - 1.0f), outlineColor, label);
+        const StressKey stressKey{config.gridExtent, config.centerX, config.centerY, config.centerZ,
+                                   state.stressLabelCount, heightfield ? heightfield->version : 0};
+        if (stressKey != state.stressKey) {
+            RebuildStressLabels(state, config, heightfield);
+            state.stressKey = stressKey;
         }
 
-        drawList->AddText(textPos, textColor, label);
+        const ImVec2 displaySize = ImGui::GetIO().DisplaySize;
+        WorldLabelDrawOptions options{};
+        options.displayWidth = displaySize.x;
+        options.displayHeight = displaySize.y;
+        options.heightfield = state.occlusion ? heightfield : nullptr;
+        options.declutter = state.declutter;
+        options.depthFadeScale = config.textBillboard ? 0.0f : config.textDepthScale;
+        state.layer.Draw(gCameraService, gCameraHandle, ImGui::GetBackgroundDrawList(), options);
     }
 
-    void DrawWorldImage(cS3DCamera* camera, cISTETerrain* terrain, GridConfig& config) {
-        if (!camera || !config.drawImage || !config.imguiService) {
-            return;
-        }
-
-        float screenX = 0.0f;
-        float screenY = 0.0f;
-        float depth = 0.0f;
-        if (!gCameraService->WorldToScreen(gCameraHandle, config.centerX, config.centerY, config.centerZ, screenX,
-                                           screenY, &depth)) {
-            return;
+    // Box-filters an image down until neither side exceeds `maxSide`, so it fits comfortably on an atlas page.
+    void ShrinkImage(std::vector<uint8_t>& pixels, uint32_t& width, uint32_t& height, const uint32_t maxSide) {
+        while (width > maxSide || height > maxSide) {
+            const uint32_t newWidth = (std::max)(width / 2, 1u);
+            const uint32_t newHeight = (std::max)(height / 2, 1u);
+            std::vector<uint8_t> shrunk(static_cast<size_t>(newWidth) * newHeight * 4);
+            for (uint32_t y = 0; y < newHeight; ++y) {
+                for (uint32_t x = 0; x < newWidth; ++x) {
+                    const uint32_t x0 = (std::min)(x * 2, width - 1);
+                    const uint32_t x1 = (std::min)(x * 2 + 1, width - 1);
+                    const uint32_t y0 = (std::min)(y * 2, height - 1);
+                    const uint32_t y1 = (std::min)(y * 2 + 1, height - 1);
+                    for (uint32_t c = 0; c < 4; ++c) {
+                        const uint32_t sum = pixels[(static_cast<size_t>(y0) * width + x0) * 4 + c] +
+                                             pixels[(static_cast<size_t>(y0) * width + x1) * 4 + c] +
+                                             pixels[(static_cast<size_t>(y1) * width + x0) * 4 + c] +
+                                             pixels[(static_cast<size_t>(y1) * width + x1) * 4 + c];
+                        shrunk[(static_cast<size_t>(y) * newWidth + x) * 4 + c] = static_cast<uint8_t>((sum + 2) / 4);
+                    }
+                }
+            }
+            pixels = std::move(shrunk);
+            width = newWidth;
+            height = newHeight;
         }
+    }
 
-        if (!config.imageLoaded) {
-            config.imageLoaded = LoadJpegToBgra(kBillboardImagePath, config.imagePixels,
-                                                config.imageWidth, config.imageHeight);
-            if (config.imageLoaded) {
-                config.imageTexture.Create(config.imguiService, config.imageWidth,
-                                           config.imageHeight, config.imagePixels.data());
+    // A round map pin with a white rim, for the stress sprites.
+    std::vector<uint8_t> MakePinIcon(const uint32_t size, const ImVec4& color) {
+        std::vector<uint8_t> pixels(static_cast<size_t>(size) * size * 4, 0);
+        const float radius = static_cast<float>(size) * 0.5f - 1.0f;
+        const float center = static_cast<float>(size) * 0.5f;
+        for (uint32_t y = 0; y < size; ++y) {
+            for (uint32_t x = 0; x < size; ++x) {
+                const float dx = static_cast<float>(x) + 0.5f - center;
+                const float dy = static_cast<float>(y) + 0.5f - center;
+                const float distance = std::sqrt(dx * dx + dy * dy);
+                const float coverage = ClampFloat(radius - distance + 0.5f, 0.0f, 1.0f);
+                const bool rim = distance > radius - 2.5f;
+                uint8_t* pixel = pixels.data() + (static_cast<size_t>(y) * size + x) * 4;
+                pixel[0] = rim ? 255 : static_cast<uint8_t>(color.x * 255.0f);
+                pixel[1] = rim ? 255 : static_cast<uint8_t>(color.y * 255.0f);
+                pixel[2] = rim ? 255 : static_cast<uint8_t>(color.z * 255.0f);
+                pixel[3] = static_cast<uint8_t>(coverage * 255.0f);
             }
         }
+        return pixels;
+    }
 
-        void* texId = config.imageTexture.GetID();
-        if (!texId && config.imageLoaded) {
-            config.imageTexture.Create(config.imguiService, config.imageWidth,
-                                       config.imageHeight, config.imagePixels.data());
-            texId = config.imageTexture.GetID();
+    bool InitWorldBillboards(WorldBillboardState& state, GridConfig& config) {
+        if (!state.layer.Init(config.imguiService)) {
+            return false;
+        }
+        if (config.imageLoaded) {
+            ShrinkImage(config.imagePixels, config.imageWidth, config.imageHeight, 256);
+            state.image = state.layer.AddImage(config.imagePixels.data(), config.imageWidth, config.imageHeight);
+        }
+        const ImVec4 iconColors[WorldBillboardState::kIconCount] = {
+            ImVec4(0.85f, 0.2f, 0.2f, 1.0f), ImVec4(0.2f, 0.6f, 0.95f, 1.0f),
+            ImVec4(0.25f, 0.8f, 0.3f, 1.0f), ImVec4(0.95f, 0.75f, 0.15f, 1.0f),
+        };
+        for (int i = 0; i < WorldBillboardState::kIconCount; ++i) {
+            const std::vector<uint8_t> icon = MakePinIcon(32, iconColors[i]);
+            state.icons[i] = state.layer.AddImage(icon.data(), 32, 32);
         }
+        return true;
+    }
 
-        if (!texId) {
-            return;
+    // Scatters `stressSpriteCount` pins over the grid area, standing on the terrain when the heightfield is available.
+    void RebuildStressSprites(WorldBillboardState& state, const GridConfig& config,
+                              const TerrainHeightfieldView* heightfield) {
+        for (const WorldBillboardLayer::SpriteId id : state.stressSprites) {
+            state.layer.Remove(id);
+        }
+        state.stressSprites.clear();
+
+        WorldBillboardDesc desc{};
+        desc.size = state.stressSpriteSize;
+        desc.offsetY = -state.stressSpriteSize * 0.5f;
+        const auto extent = static_cast<float>(config.gridExtent);
+        for (int i = 0; i < state.stressSpriteCount; ++i) {
+            uint32_t hash = static_cast<uint32_t>(i + 1) * 0x9E3779B1u;
+            const auto next = [&hash]() {
+                hash ^= hash >> 16;
+                hash *= 0x7FEB352Du;
+                hash ^= hash >> 15;
+                return static_cast<float>(hash & 0xFFFF) / 65535.0f;
+            };
+            const float x = config.centerX + (next() * 2.0f - 1.0f) * extent;
+            const float z = config.centerZ + (next() * 2.0f - 1.0f) * extent;
+            desc.position[0] = x;
+            desc.position[1] = heightfield && HeightfieldContains(*heightfield, x, z)
+                                   ? SampleHeightfield(*heightfield, x, z)
+                                   : config.centerY;
+            desc.position[2] = z;
+            desc.image = state.icons[hash % WorldBillboardState::kIconCount];
+            state.stressSprites.push_back(state.layer.Add(desc));
         }
+    }
 
-        ImDrawList* drawList = ImGui::GetBackgroundDrawList();
-        if (config.imageBillboard) {
-            const float size = config.imageSize;
-            const ImVec2 center(screenX + config.imageOffsetX, screenY + config.imageOffsetY);
-            const ImVec2 half(size * 0.5f, size * 0.5f);
-            const ImVec2 minPos(center.x - half.x, center.y - half.y);
-            const ImVec2 maxPos(center.x + half.x, center.y + half.y);
-            drawList->AddImage(texId, minPos, maxPos);
+    void DrawWorldBillboards(cS3DCamera* camera, WorldBillboardState& state, GridConfig& config,
+                             const TerrainHeightfieldView* heightfield) {
+        if (!camera || !config.imguiService) {
             return;
         }
-
-        const float worldX = config.centerX + config.imageOffsetX;
-        const float worldZ = config.centerZ + config.imageOffsetY;
-        const float halfSize = config.imageSize * 0.5f;
-
-        auto sampleHeight = [&](float x, float z) -> float {
-            if (!config.conformToTerrain || !terrain || !terrain->LocationIsInBounds(x, z)) {
-                return config.centerY;
+        if (!state.initialized) {
+            state.initialized = InitWorldBillboards(state, config);
+            if (!state.initialized) {
+                return;
             }
-            return config.terrainSnapToGrid
-                       ? terrain->GetAltitudeAtNearestGrid(x, z)
-                       : terrain->GetAltitude(x, z);
-        };
+        }
 
-        const float y1 = sampleHeight(worldX - halfSize, worldZ - halfSize);
-        const float y2 = sampleHeight(worldX + halfSize, worldZ - halfSize);
-        const float y3 = sampleHeight(worldX + halfSize, worldZ + halfSize);
-        const float y4 = sampleHeight(worldX - halfSize, worldZ + halfSize);
+        if (config.drawImage && state.image != WorldBillboardLayer::kInvalidImage) {
+            WorldBillboardDesc desc{};
+            desc.position[0] = config.centerX;
+            desc.position[1] = config.centerY;
+            desc.position[2] = config.centerZ;
+            desc.image = state.image;
+            desc.size = config.imageSize;
+            desc.offsetX = config.imageOffsetX;
+            desc.offsetY = config.imageOffsetY;
+            desc.mode = config.imageBillboard ? WorldBillboardMode::Screen : WorldBillboardMode::Ground;
+            if (state.imageSprite == WorldBillboardLayer::kInvalidSprite) {
+                state.imageSprite = state.layer.Add(desc);
+            }
+            else {
+                state.layer.Update(state.imageSprite, desc);
+            }
+        }
+        else if (state.imageSprite != WorldBillboardLayer::kInvalidSprite) {
+            state.layer.Remove(state.imageSprite);
+            state.imageSprite = WorldBillboardLayer::kInvalidSprite;
+        }
 
-        float p1x, p1y, p2x, p2y, p3x, p3y, p4x, p4y;
-        if (!gCameraService->WorldToScreen(gCameraHandle, worldX - halfSize, y1, worldZ - halfSize, p1x, p1y) ||
-            !gCameraService->WorldToScreen(gCameraHandle, worldX + halfSize, y2, worldZ - halfSize, p2x, p2y) ||
-            !gCameraService->WorldToScreen(gCameraHandle, worldX + halfSize, y3, worldZ + halfSize, p3x, p3y) ||
-            !gCameraService->WorldToScreen(gCameraHandle, worldX - halfSize, y4, worldZ + halfSize, p4x, p4y)) {
-            return;
+        const StressKey stressKey{config.gridExtent, config.centerX, config.centerY, config.centerZ,
+                                  state.stressSpriteCount, heightfield ? heightfield->version : 0};
+        if (stressKey != state.stressKey) {
+            RebuildStressSprites(state, config, heightfield);
+            state.stressKey = stressKey;
         }
 
-        drawList->AddImageQuad(
-            texId,
-            ImVec2(p1x, p1y),
-            ImVec2(p2x, p2y),
-            ImVec2(p3x, p3y),
-            ImVec2(p4x, p4y)
-        );
+        const ImVec2 displaySize = ImGui::GetIO().DisplaySize;
+        WorldBillboardDrawOptions options{};
+        options.displayWidth = displaySize.x;
+        options.displayHeight = displaySize.y;
+        options.heightfield = config.conformToTerrain ? heightfield : nullptr;
+        options.snapToGrid = config.terrainSnapToGrid;
+        state.layer.Draw(gCameraService, gCameraHandle, ImGui::GetBackgroundDrawList(), options);
     }
 
     void RenderWorldProjectionPanel(void* userData) {
@@ -758,10 +745,7 @@ namespace {
             return;
         }
         auto& config = data->grid;
-        auto& depth = data->depth;
-
-        float overlayScreenX = 0.0f, overlayScreenY = 0.0f;
-        bool overlayHasPos = false;
+        auto& overlay = data->overlay;
 
         // Refresh camera handle from service each frame (handles device/lifetime changes).
         if (data->cameraService) {
@@ -784,27 +768,26 @@ namespace {
             }
         }
 
-        if (camera) {
-            DrawWorldGrid(camera, terrain, config);
-            DrawWorldText(camera, config);
-            DrawWorldImage(camera, terrain, config);
-            overlayHasPos = gCameraService->WorldToScreen(gCameraHandle, config.centerX, config.centerY, config.centerZ,
-                                                          overlayScreenX, overlayScreenY, nullptr);
-        }
+        // One heightfield view per frame keeps the grid and the image on the same terrain version.
+        TerrainHeightfieldView heightfieldView{};
+        const TerrainHeightfieldView* heightfield =
+            data->terrainService && data->terrainService->AcquireHeightfield(heightfieldView) ? &heightfieldView
+                                                                                              : nullptr;
 
-        if (depth.autoRefresh) {
-            CaptureDepthBuffer(depth);
+        // The world list is recorded here and drawn by the next PreDynamic pass.
+        WorldOverlayDrawList* worldList = overlay.pass.IsReady() ? &overlay.pass.Begin() : nullptr;
+        if (camera) {
+            DrawWorldGrid(camera, terrain, heightfield, config, overlay.depthTestGrid ? worldList : nullptr,
+                          overlay.gridLineWidth);
+            DrawWorldLabels(camera, data->labels, config, heightfield);
+            DrawWorldBillboards(camera, data->billboards, config, heightfield);
+            if (worldList && overlay.drawMarker) {
+                AddWorldMarker(*worldList, config, overlay);
+            }
         }
 
-        if (depth.showMaskedOverlay && depth.lastCaptureOk && overlayHasPos) {
-            BuildMaskedOverlay(depth, overlayScreenX, overlayScreenY);
-            if (void* maskTex = depth.maskedOverlayTexture.GetID()) {
-                const float half = depth.overlaySize * 0.5f;
-                ImGui::GetBackgroundDrawList()->AddImage(
-                    maskTex,
-                    ImVec2(overlayScreenX - half, overlayScreenY - half),
-                    ImVec2(overlayScreenX + half, overlayScreenY + half));
-            }
+        if (heightfield) {
+            data->terrainService->ReleaseHeightfield(heightfieldView);
         }
 
         // Control panel
@@ -822,6 +805,9 @@ namespace {
             ImGui::SliderInt("Spacing", &config.gridSpacing, 8, 256);
             ImGui::SliderInt("Extent", &config.gridExtent, 64, 2048);
             ImGui::SliderFloat("Line thickness", &config.lineThickness, 1.0f, 5.0f, "%.1f");
+            ImGui::Checkbox("Frustum cull", &config.frustumCull);
+            ImGui::Text("Segments drawn: %u / %u%s", config.gridSegmentsVisible, config.gridSegmentsTotal,
+                        config.gridProjectionReused ? " (cached, camera and terrain unchanged)" : "");
 
             ImGui::Spacing();
             ImGui::Text("Grid center");
@@ -870,6 +856,17 @@ namespace {
                 ImGui::Checkbox("Outline", &config.textOutline);
                 ImGui::Checkbox("Shadow", &config.textShadow);
             }
+            ImGui::SliderInt("Stress labels", &data->labels.stressLabelCount, 0, 5000);
+            ImGui::Checkbox("Declutter", &data->labels.declutter);
+            ImGui::SameLine();
+            ImGui::Checkbox("Hide behind terrain", &data->labels.occlusion);
+            const WorldLabelFrameStats& labelStats = data->labels.layer.Stats();
+            ImGui::Text("Labels drawn: %u / %u (off screen %u, occluded %u, decluttered %u)", labelStats.drawn,
+                        labelStats.total, labelStats.total - labelStats.onScreen, labelStats.occluded,
+                        labelStats.decluttered);
+            if (labelStats.vertexLimitReached) {
+                ImGui::TextColored(ImVec4(1.0f, 0.6f, 0.2f, 1.0f), "Vertex limit reached; some labels dropped");
+            }
 
             ImGui::Spacing();
             ImGui::Text("Billboard image");
@@ -893,50 +890,43 @@ namespace {
                     ImGui::DragFloat2("Image offset (world X/Z)", &config.imageOffsetX, 1.0f, -512.0f, 512.0f, "%.1f");
                 }
             }
+            ImGui::SliderInt("Stress icons", &data->billboards.stressSpriteCount, 0, 16000);
+            const WorldBillboardFrameStats& spriteStats = data->billboards.layer.Stats();
+            ImGui::Text("Sprites drawn: %u / %u in %u draw(s), %u re-draped", spriteStats.drawn, spriteStats.total,
+                        spriteStats.pages, spriteStats.draped);
+            if (spriteStats.vertexLimitReached) {
+                ImGui::TextColored(ImVec4(1.0f, 0.6f, 0.2f, 1.0f), "Vertex limit reached; farthest sprites dropped");
+            }
         }
 
         ImGui::Spacing();
         ImGui::Separator();
-        ImGui::Text("Depth buffer");
-        ImGui::Checkbox("Auto refresh each frame", &depth.autoRefresh);
-        ImGui::SameLine();
-        if (ImGui::Button("Capture now")) {
-            CaptureDepthBuffer(depth);
+        ImGui::Text("Depth-tested overlay");
+        if (!overlay.pass.IsReady()) {
+            ImGui::TextColored(ImVec4(1.0f, 0.6f, 0.2f, 1.0f), "Draw service not available");
         }
-        ImGui::TextColored(depth.lastCaptureOk ? ImVec4(0.2f, 1.0f, 0.2f, 1.0f) : ImVec4(1.0f, 0.6f, 0.2f, 1.0f),
-                           "%s", depth.status);
-        ImGui::Text("Min depth: %.0f   Max depth: %.0f", depth.minDepth, depth.maxDepth);
-
-        if (!depth.histogram.empty()) {
-            ImGui::PlotHistogram("Depth histogram", depth.histogram.data(),
-                                 static_cast<int>(depth.histogram.size()), 0,
-                                 nullptr, 0.0f, 1.0f, ImVec2(0, 80));
+        ImGui::BeginDisabled(!overlay.pass.IsReady());
+        ImGui::Checkbox("Depth-test grid", &overlay.depthTestGrid);
+        if (overlay.depthTestGrid) {
+            ImGui::SliderFloat("Line width (world)", &overlay.gridLineWidth, 0.5f, 16.0f, "%.1f");
         }
-
-        if (void* texId = depth.depthTexture.GetID()) {
-            const float aspect = depth.texHeight > 0
-                                     ? static_cast<float>(depth.texHeight) / static_cast<float>(depth.texWidth)
-                                     : 1.0f;
-            const float displayWidth = 512.0f;
-            ImGui::Image(texId, ImVec2(displayWidth, displayWidth * aspect));
+        ImGui::Checkbox("Draw marker post", &overlay.drawMarker);
+        if (overlay.drawMarker) {
+            ImGui::SliderFloat("Marker post size", &overlay.markerSize, 8.0f, 256.0f, "%.0f");
+            ImGui::ColorEdit4("Marker post color", reinterpret_cast<float*>(&overlay.markerColor));
         }
-        else {
-            ImGui::TextUnformatted("Depth texture not available yet.");
+        if (ImGui::Checkbox("Depth test", &overlay.depthTest)) {
+            overlay.pass.SetDepthTest(overlay.depthTest);
         }
-
-        ImGui::Spacing();
-        ImGui::Text("Masked overlay PoC");
-        ImGui::Checkbox("Show masked overlay in scene", &depth.showMaskedOverlay);
-        ImGui::SliderFloat("Overlay size (px)", &depth.overlaySize, 32.0f, 256.0f, "%.0f");
-        ImGui::SliderFloat("Depth bias", &depth.overlayBias, 0.0f, 400.0f, "%.0f");
-        ImGui::ColorEdit4("Overlay color", reinterpret_cast<float*>(&depth.overlayColor));
-        if (void* masked = depth.maskedOverlayTexture.GetID()) {
-            ImGui::TextUnformatted("Preview:");
-            ImGui::Image(masked, ImVec2(depth.overlaySize, depth.overlaySize));
+        if (ImGui::SliderInt("Z bias", &overlay.zBias, 0, WorldOverlayPass::kMaxZBias)) {
+            overlay.pass.SetZBias(overlay.zBias);
         }
-        else {
-            ImGui::TextUnformatted("Preview: (capture first)");
+        const WorldOverlayFrameStats overlayStats = overlay.pass.Stats();
+        ImGui::Text("World overlay: %u vertices in %u draw(s)", overlayStats.vertices, overlayStats.draws);
+        if (overlayStats.vertexLimitReached) {
+            ImGui::TextColored(ImVec4(1.0f, 0.6f, 0.2f, 1.0f), "Vertex limit reached; some geometry dropped");
         }
+        ImGui::EndDisabled();
 
         ImGui::End();
     }
@@ -944,13 +934,21 @@ namespace {
     void ShutdownWorldProjection(void* userData) {
         auto* data = static_cast<WorldProjectionData*>(userData);
         if (data) {
-            data->grid.imageTexture.Release();
-            data->depth.depthTexture.Release();
-            data->depth.maskedOverlayTexture.Release();
+            data->billboards.layer.Shutdown();
+            data->labels.layer.Shutdown();
+            data->overlay.pass.Shutdown();
+            if (data->overlay.drawService) {
+                data->overlay.drawService->Release();
+                data->overlay.drawService = nullptr;
+            }
             if (data->cameraService) {
                 data->cameraService->Release();
                 data->cameraService = nullptr;
             }
+            if (data->terrainService) {
+                data->terrainService->Release();
+                data->terrainService = nullptr;
+            }
             gCameraService = nullptr;
             gCameraHandle = {nullptr, 0, false};
         }
@@ -1004,12 +1002,30 @@ public:
             LOG_WARN("WorldProjectionSample: Camera service not available");
         }
 
+        // Terrain service (optional; terrain-conforming grids query the game per point without it)
+        cIGZTerrainService* terrainService = nullptr;
+        if (!mpFrameWork->GetSystemService(kTerrainServiceID, GZIID_cIGZTerrainService,
+                                           reinterpret_cast<void**>(&terrainService))) {
+            LOG_WARN("WorldProjectionSample: Terrain service not available");
+        }
+
+        // Draw service (optional; the depth-tested world overlay is disabled without it)
+        cIGZDrawService* drawService = nullptr;
+        if (!mpFrameWork->GetSystemService(kDrawServiceID, GZIID_cIGZDrawService,
+                                           reinterpret_cast<void**>(&drawService))) {
+            LOG_WARN("WorldProjectionSample: Draw service not available");
+        }
+
         LOG_INFO("WorldProjectionSample: obtained ImGui service");
 
         auto* data = new WorldProjectionData();
         data->grid.imguiService = service;
-        data->depth.imguiService = service;
         data->cameraService = cameraService;
+        data->terrainService = terrainService;
+        data->overlay.drawService = drawService;
+        if (drawService && !data->overlay.pass.Init(service, drawService)) {
+            LOG_WARN("WorldProjectionSample: failed to register the world overlay pass");
+        }
         ImGuiPanelDesc desc{};
         desc.id = kWorldProjectionPanelId;
         desc.order = 200; // Render after other panels
@@ -1031,6 +1047,12 @@ public:
         if (!StartGdiplus()) {
             LOG_WARN("WorldProjectionSample: failed to start GDI+");
         }
+        // Decode the billboard image once here rather than on the first frame that draws it.
+        data->grid.imageLoaded = LoadJpegToBgra(kBillboardImagePath, data->grid.imagePixels, data->grid.imageWidth,
+                                                data->grid.imageHeight);
+        if (!data->grid.imageLoaded) {
+            LOG_WARN("WorldProjectionSample: failed to load the billboard image");
+        }
         return true;
     }
 
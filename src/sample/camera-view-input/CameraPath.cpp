@@ -0,0 +1,212 @@
+#include "sample/camera-view-input/CameraPath.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <fstream>
+#include <utility>
+
+namespace
+{
+    constexpr float kTwoPi = 6.28318530717958647692f;
+    constexpr uint32_t kMaxFileSamples = 1u << 24;
+
+    struct CameraPathFileHeader
+    {
+        uint32_t magic;
+        uint32_t version;
+        uint32_t sampleCount;
+        uint32_t sampleSize;
+    };
+
+    bool IsFinite(const CameraPathSample& sample)
+    {
+        return std::isfinite(sample.time) && std::isfinite(sample.target[0]) && std::isfinite(sample.target[1]) &&
+               std::isfinite(sample.target[2]) && std::isfinite(sample.heading) && std::isfinite(sample.pitch) &&
+               std::isfinite(sample.zoomScale);
+    }
+
+    float Lerp(const float a, const float b, const float t)
+    {
+        return a + (b - a) * t;
+    }
+
+    // Nearest-rank percentile of an ascending list.
+    double Percentile(const std::vector<double>& sorted, const double percent)
+    {
+        const auto rank = static_cast<size_t>(std::ceil(percent / 100.0 * static_cast<double>(sorted.size())));
+        return sorted[std::clamp<size_t>(rank, 1, sorted.size()) - 1];
+    }
+}
+
+void CameraPath::Clear()
+{
+    samples_.clear();
+}
+
+float CameraPath::Duration() const
+{
+    return samples_.empty() ? 0.0f : samples_.back().time - samples_.front().time;
+}
+
+bool CameraPath::Append(const CameraPathSample& sample)
+{
+    if (!IsFinite(sample) || (!samples_.empty() && sample.time < samples_.back().time)) {
+        return false;
+    }
+
+    CameraPathSample stored = sample;
+    stored.reserved = 0.0f;
+    if (!samples_.empty()) {
+        const float previous = samples_.back().heading;
+        stored.heading -= kTwoPi * std::round((stored.heading - previous) / kTwoPi);
+    }
+    samples_.push_back(stored);
+    return true;
+}
+
+bool CameraPath::Evaluate(const float time, CameraPathSample& outSample) const
+{
+    if (samples_.empty()) {
+        return false;
+    }
+    if (time <= samples_.front().time) {
+        outSample = samples_.front();
+        return true;
+    }
+    if (time >= samples_.back().time) {
+        outSample = samples_.back();
+        return true;
+    }
+
+    const auto next = std::upper_bound(samples_.begin(), samples_.end(), time,
+                                       [](const float t, const CameraPathSample& s) { return t < s.time; });
+    const CameraPathSample& b = *next;
+    const CameraPathSample& a = *(next - 1);
+    const float span = b.time - a.time;
+    const float t = span > 0.0f ? (time - a.time) / span : 1.0f;
+
+    outSample.time = time;
+    for (int i = 0; i < 3; ++i) {
+        outSample.target[i] = Lerp(a.target[i], b.target[i], t);
+    }
+    outSample.heading = Lerp(a.heading, b.heading, t);
+    outSample.pitch = Lerp(a.pitch, b.pitch, t);
+    outSample.zoomScale = Lerp(a.zoomScale, b.zoomScale, t);
+    outSample.reserved = 0.0f;
+    return true;
+}
+
+bool CameraPath::SaveToFile(const char* filepath) const
+{
+    if (!filepath || !filepath[0]) {
+        return false;
+    }
+    std::ofstream out(filepath, std::ios::binary | std::ios::trunc);
+    if (!out.is_open()) {
+        return false;
+    }
+
+    const CameraPathFileHeader header{kFileMagic, kFileVersion, static_cast<uint32_t>(samples_.size()),
+                                      static_cast<uint32_t>(sizeof(CameraPathSample))};
+    out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    out.write(reinterpret_cast<const char*>(samples_.data()),
+              static_cast<std::streamsize>(samples_.size() * sizeof(CameraPathSample)));
+    return out.good();
+}
+
+bool CameraPath::LoadFromFile(const char* filepath)
+{
+    if (!filepath || !filepath[0]) {
+        return false;
+    }
+    std::ifstream in(filepath, std::ios::binary);
+    if (!in.is_open()) {
+        return false;
+    }
+
+    CameraPathFileHeader header{};
+    if (!in.read(reinterpret_cast<char*>(&header), sizeof(header)) || header.magic != kFileMagic ||
+        header.version != kFileVersion || header.sampleSize != sizeof(CameraPathSample) ||
+        header.sampleCount > kMaxFileSamples) {
+        return false;
+    }
+
+    std::vector<CameraPathSample> samples(header.sampleCount);
+    if (!in.read(reinterpret_cast<char*>(samples.data()),
+                 static_cast<std::streamsize>(samples.size() * sizeof(CameraPathSample)))) {
+        return false;
+    }
+    for (size_t i = 0; i < samples.size(); ++i) {
+        if (!IsFinite(samples[i]) || (i > 0 && samples[i].time < samples[i - 1].time)) {
+            return false;
+        }
+    }
+
+    samples_ = std::move(samples);
+    return true;
+}
+
+void FrameTimeLog::Clear()
+{
+    pathTime_.clear();
+    frameMs_.clear();
+}
+
+void FrameTimeLog::Reserve(const size_t frames)
+{
+    pathTime_.reserve(frames);
+    frameMs_.reserve(frames);
+}
+
+void FrameTimeLog::Add(const float pathTime, const double frameMs)
+{
+    pathTime_.push_back(pathTime);
+    frameMs_.push_back(frameMs);
+}
+
+FrameTimeSummary FrameTimeLog::Summarize() const
+{
+    FrameTimeSummary summary{};
+    if (frameMs_.empty()) {
+        return summary;
+    }
+
+    std::vector<double> sorted = frameMs_;
+    std::sort(sorted.begin(), sorted.end());
+    for (const double ms : sorted) {
+        summary.totalMs += ms;
+    }
+    summary.frames = static_cast<uint32_t>(sorted.size());
+    summary.meanMs = summary.totalMs / static_cast<double>(sorted.size());
+    summary.minMs = sorted.front();
+    summary.p50Ms = Percentile(sorted, 50.0);
+    summary.p90Ms = Percentile(sorted, 90.0);
+    summary.p95Ms = Percentile(sorted, 95.0);
+    summary.p99Ms = Percentile(sorted, 99.0);
+    summary.maxMs = sorted.back();
+    return summary;
+}
+
+bool FrameTimeLog::WriteCsv(const char* filepath, const char* pathName) const
+{
+    if (!filepath || !filepath[0]) {
+        return false;
+    }
+    std::FILE* file = std::fopen(filepath, "w");
+    if (!file) {
+        return false;
+    }
+
+    const FrameTimeSummary s = Summarize();
+    std::fprintf(file, "# path: %s\n", pathName ? pathName : "");
+    std::fprintf(file, "# frames: %u total_ms: %.3f mean_ms: %.3f\n", s.frames, s.totalMs, s.meanMs);
+    std::fprintf(file, "# min_ms: %.3f p50_ms: %.3f p90_ms: %.3f p95_ms: %.3f p99_ms: %.3f max_ms: %.3f\n", s.minMs,
+                 s.p50Ms, s.p90Ms, s.p95Ms, s.p99Ms, s.maxMs);
+    std::fprintf(file, "frame,path_time_s,frame_ms\n");
+    for (size_t i = 0; i < frameMs_.size(); ++i) {
+        std::fprintf(file, "%zu,%.4f,%.4f\n", i, pathTime_[i], frameMs_[i]);
+    }
+    const bool ok = std::ferror(file) == 0;
+    return std::fclose(file) == 0 && ok;
+}
@@ -0,0 +1,81 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Recorded camera fly-through for repeatable benchmark runs.
+//
+// A path is a list of timestamped camera states. Heading is stored as the absolute view yaw (the camera control's
+// yaw plus a quarter turn per rotation step), unwrapped so consecutive samples never jump by a full turn, and zoom is
+// stored as a single log2 scale (zoom level plus log2 of the custom magnification). Both can then be interpolated
+// linearly, which keeps playback smooth across the game's rotation and zoom steps. This file does not depend on the
+// game, so paths and frame reports can also be read by host tools.
+struct CameraPathSample
+{
+    float time;             // Seconds since the start of the recording.
+    float target[3];        // View target position, world units.
+    float heading;          // Absolute yaw in radians, unwrapped.
+    float pitch;            // Radians.
+    float zoomScale;        // zoom + log2(customMagnification).
+    float reserved;
+};
+
+static_assert(sizeof(CameraPathSample) == 32);
+
+class CameraPath
+{
+public:
+    static constexpr uint32_t kFileMagic = 0x48545043; // CPTH
+    static constexpr uint32_t kFileVersion = 1;
+
+    void Clear();
+    [[nodiscard]] bool Empty() const { return samples_.empty(); }
+    [[nodiscard]] size_t Size() const { return samples_.size(); }
+    [[nodiscard]] float Duration() const;
+    [[nodiscard]] const std::vector<CameraPathSample>& Samples() const { return samples_; }
+
+    /// Appends a sample. Time must not go backwards; the heading is unwrapped against the previous sample.
+    bool Append(const CameraPathSample& sample);
+
+    /// Interpolated state at `time`, clamped to the recorded range. Returns false if the path is empty.
+    bool Evaluate(float time, CameraPathSample& outSample) const;
+
+    bool SaveToFile(const char* filepath) const;
+    bool LoadFromFile(const char* filepath);
+
+private:
+    std::vector<CameraPathSample> samples_{};
+};
+
+struct FrameTimeSummary
+{
+    uint32_t frames = 0;
+    double totalMs = 0.0;
+    double meanMs = 0.0;
+    double minMs = 0.0;
+    double p50Ms = 0.0;
+    double p90Ms = 0.0;
+    double p95Ms = 0.0;
+    double p99Ms = 0.0;
+    double maxMs = 0.0;
+};
+
+// Per-frame times collected while a path plays back, with nearest-rank percentiles over the whole run.
+class FrameTimeLog
+{
+public:
+    void Clear();
+    void Reserve(size_t frames);
+    void Add(float pathTime, double frameMs);
+    [[nodiscard]] size_t Size() const { return frameMs_.size(); }
+
+    [[nodiscard]] FrameTimeSummary Summarize() const;
+
+    /// Writes a summary comment block followed by one "frame,path_time_s,frame_ms" row per frame.
+    bool WriteCsv(const char* filepath, const char* pathName) const;
+
+private:
+    std::vector<float> pathTime_{};
+    std::vector<double> frameMs_{};
+};
@@ -11,6 +11,7 @@
 #include <Windows.h>
 
 #include <algorithm>
+#include <chrono>
 #include <cstddef>
 #include <cmath>
 #include <utility>
@@ -26,6 +27,10 @@ namespace
 {
     constexpr uint32_t kModifierAlt = 0x40000;
     constexpr float kMagnificationWheelScalePerNotch = 1.04f;
+    constexpr float kQuarterTurn = SC4CameraControl::kPi * 0.5f;
+    constexpr double kMaxInputDelay = 0.05;       // Interpolation never lags the mouse by more than this.
+    constexpr double kMaxFrameStep = 0.1;         // Longer frames smooth as if they were this long.
+    constexpr float kSettledRadians = 1.0e-4f;
 
     constexpr float kPi = SC4CameraControl::kPi;
     constexpr float kPitchMinRadians = SC4CameraControl::kPitchMinRadians;
@@ -60,6 +65,23 @@ CameraViewInputControl::CameraViewInputControl()
     , wheelZoomStep_(24.0f)
     , keyboardPanStep_(10.0f)
     , invertPitch_(false)
+    , subFrameInterpolation_(false)
+    , smoothingHalfLife_(0.0f)
+    , inputHistory_()
+    , inputHistoryCount_(0)
+    , inputHistoryHead_(0)
+    , inputCumulativeX_(0.0)
+    , inputCumulativeZ_(0.0)
+    , consumedX_(0.0)
+    , consumedZ_(0.0)
+    , inputInterval_(1.0 / 125.0)
+    , lastFrameTime_(0.0)
+    , lastSampleTime_(0.0)
+    , anglesActive_(false)
+    , targetHeading_(0.0f)
+    , targetPitch_(0.0f)
+    , smoothedHeading_(0.0f)
+    , smoothedPitch_(0.0f)
 {
 }
 
@@ -136,6 +158,8 @@ bool CameraViewInputControl::OnMouseDownR(const int32_t x, const int32_t z, cons
     rightDragging_ = true;
     lastMouseX_ = x;
     lastMouseZ_ = z;
+    // Anchors interpolation at the press so the idle time before it is not spread over the first movement.
+    RecordMouseDelta_(0, 0);
     SetCapture();
     return true;
 }
@@ -157,14 +181,15 @@ bool CameraViewInputControl::OnMouseMove(const int32_t x, const int32_t z, const
         return false;
     }
 
-    bool handled = rightDragging_ && RotateFromMouse_(x, z);
-
-    if (rightDragging_) {
-        lastMouseX_ = x;
-        lastMouseZ_ = z;
+    if (!rightDragging_) {
+        return false;
     }
 
-    return handled;
+    // High polling rate mice send several moves per frame; ApplyPendingInput turns them into one camera update.
+    RecordMouseDelta_(x - lastMouseX_, z - lastMouseZ_);
+    lastMouseX_ = x;
+    lastMouseZ_ = z;
+    return true;
 }
 
 bool CameraViewInputControl::OnMouseWheel(const int32_t, const int32_t, const uint32_t modifiers, const int32_t wheelDelta)
@@ -237,6 +262,91 @@ void CameraViewInputControl::SetInvertPitch(const bool invertPitch)
     invertPitch_ = invertPitch;
 }
 
+void CameraViewInputControl::SetSubFrameInterpolation(const bool enabled)
+{
+    subFrameInterpolation_ = enabled;
+}
+
+void CameraViewInputControl::SetSmoothingHalfLife(const float seconds)
+{
+    smoothingHalfLife_ = std::max(0.0f, seconds);
+}
+
+bool CameraViewInputControl::ApplyPendingInput()
+{
+    const double now = Now_();
+    const double frameStep = lastFrameTime_ > 0.0 ? std::clamp(now - lastFrameTime_, 0.0, kMaxFrameStep) : 0.0;
+    lastFrameTime_ = now;
+
+    // The delay follows the mouse rate; never let the sample time run backwards, or the drag would reverse.
+    const double delay = subFrameInterpolation_ ? std::min(inputInterval_, kMaxInputDelay) : 0.0;
+    const double sampleTime = std::max(now - delay, lastSampleTime_);
+    lastSampleTime_ = sampleTime;
+    double cumulativeX = 0.0;
+    double cumulativeZ = 0.0;
+    SampleInput_(sampleTime, cumulativeX, cumulativeZ);
+    const double dx = cumulativeX - consumedX_;
+    const double dz = cumulativeZ - consumedZ_;
+    consumedX_ = cumulativeX;
+    consumedZ_ = cumulativeZ;
+
+    if (!IsUsable_()) {
+        anglesActive_ = false;
+        return false;
+    }
+    if (dx == 0.0 && dz == 0.0 && !anglesActive_) {
+        return false;
+    }
+
+    auto* cameraControl = SC4CameraControl::GetActiveCameraControl();
+    if (!cameraControl) {
+        anglesActive_ = false;
+        return false;
+    }
+
+    // Steer the absolute heading so the game's rotation steps, which SetYawPitch rebalances into, never show up as
+    // quarter-turn jumps in the smoothed value.
+    const float rotationOffset = static_cast<float>(cameraControl->rotation) * kQuarterTurn;
+    if (!anglesActive_) {
+        targetHeading_ = cameraControl->yaw + rotationOffset;
+        targetPitch_ = cameraControl->pitch;
+        smoothedHeading_ = targetHeading_;
+        smoothedPitch_ = targetPitch_;
+        anglesActive_ = true;
+    }
+
+    const float pitchScale = invertPitch_ ? 1.0f : -1.0f;
+    targetHeading_ -= static_cast<float>(dx) * rotateSensitivity_;
+    targetPitch_ = Clip(targetPitch_ + static_cast<float>(dz) * pitchSensitivity_ * pitchScale,
+                        kPitchMinRadians, kPitchMaxRadians);
+
+    if (smoothingHalfLife_ > 0.0f) {
+        const auto blend = static_cast<float>(1.0 - std::exp2(-frameStep / smoothingHalfLife_));
+        smoothedHeading_ += (targetHeading_ - smoothedHeading_) * blend;
+        smoothedPitch_ += (targetPitch_ - smoothedPitch_) * blend;
+    }
+    else {
+        smoothedHeading_ = targetHeading_;
+        smoothedPitch_ = targetPitch_;
+    }
+
+    const bool settled = std::fabs(targetHeading_ - smoothedHeading_) < kSettledRadians &&
+                         std::fabs(targetPitch_ - smoothedPitch_) < kSettledRadians;
+    if (settled) {
+        smoothedHeading_ = targetHeading_;
+        smoothedPitch_ = targetPitch_;
+    }
+
+    const bool applied = ApplyCameraAngles_(smoothedHeading_ - rotationOffset, smoothedPitch_, true);
+
+    // Once the drag has ended and the camera caught up, let other controls move the camera again.
+    if (!applied || (settled && !rightDragging_ && consumedX_ == inputCumulativeX_ &&
+                     consumedZ_ == inputCumulativeZ_)) {
+        anglesActive_ = false;
+    }
+    return applied;
+}
+
 bool CameraViewInputControl::IsUsable_() const
 {
     return active_ && view3D && cameraService_;
@@ -244,6 +354,16 @@ bool CameraViewInputControl::IsUsable_() const
 
 bool CameraViewInputControl::PickTerrainAt_(const int32_t screenX, const int32_t screenZ, float& x, float& y, float& z) const
 {
+    // Panning picks twice per mouse move; the service's native pick avoids two game-side ray casts.
+    const S3DCameraHandle camera = cameraService_->WrapActiveRendererCamera();
+    S3DTerrainPick pick{};
+    if (camera.ptr && cameraService_->PickTerrain(camera, screenX, screenZ, pick)) {
+        x = pick.position[0];
+        y = pick.position[1];
+        z = pick.position[2];
+        return true;
+    }
+
     float world[3] = {0.0f, 0.0f, 0.0f};
     if (!view3D->PickTerrain(screenX, screenZ, world, false)) {
         return false;
@@ -272,26 +392,6 @@ bool CameraViewInputControl::PanFromMouse_(const int32_t x, const int32_t z)
     return ApplyCameraPositionDelta_(oldX - newX, 0.0f, oldZ - newZ);
 }
 
-bool CameraViewInputControl::RotateFromMouse_(const int32_t x, const int32_t z)
-{
-    float yaw = 0.0f;
-    float pitch = 0.0f;
-    if (!GetCameraAngles_(yaw, pitch)) {
-        return false;
-    }
-
-    const int32_t dx = x - lastMouseX_;
-    const int32_t dz = z - lastMouseZ_;
-
-    yaw -= static_cast<float>(dx) * rotateSensitivity_;
-
-    const float pitchScale = invertPitch_ ? 1.0f : -1.0f;
-    pitch += static_cast<float>(dz) * pitchSensitivity_ * pitchScale;
-    pitch = Clip(pitch, kPitchMinRadians, kPitchMaxRadians);
-
-    return ApplyCameraAngles_(yaw, pitch, false);
-}
-
 bool CameraViewInputControl::ZoomByWheel_(const int32_t wheelDelta)
 {
     const float notches = static_cast<float>(wheelDelta) / 120.0f;
@@ -394,3 +494,51 @@ bool CameraViewInputControl::ApplyCameraAngles_(const float yaw, const float pit
     SC4CameraControl::QueueYawPitch(yaw, pitch);
     return true;
 }
+
+double CameraViewInputControl::Now_()
+{
+    return std::chrono::duration<double>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+void CameraViewInputControl::RecordMouseDelta_(const int32_t dx, const int32_t dz)
+{
+    const double now = Now_();
+    if (inputHistoryCount_ > 0 && (dx != 0 || dz != 0)) {
+        const double interval = std::min(now - inputHistory_[inputHistoryHead_].time, kMaxInputDelay);
+        inputInterval_ += (interval - inputInterval_) * 0.2;
+    }
+
+    inputCumulativeX_ += dx;
+    inputCumulativeZ_ += dz;
+    inputHistoryHead_ = (inputHistoryHead_ + 1) % kInputHistorySize;
+    inputHistory_[inputHistoryHead_] = {now, inputCumulativeX_, inputCumulativeZ_};
+    inputHistoryCount_ = std::min(inputHistoryCount_ + 1, kInputHistorySize);
+}
+
+void CameraViewInputControl::SampleInput_(const double time, double& cumulativeX, double& cumulativeZ) const
+{
+    cumulativeX = inputCumulativeX_;
+    cumulativeZ = inputCumulativeZ_;
+    if (inputHistoryCount_ == 0 || time >= inputHistory_[inputHistoryHead_].time) {
+        return;
+    }
+
+    // Walk back from the newest sample to the pair that brackets `time`; the history only needs to cover one frame.
+    size_t newer = inputHistoryHead_;
+    for (size_t i = 1; i < inputHistoryCount_; ++i) {
+        const size_t older = (newer + kInputHistorySize - 1) % kInputHistorySize;
+        const InputSample& a = inputHistory_[older];
+        const InputSample& b = inputHistory_[newer];
+        if (time >= a.time) {
+            const double span = b.time - a.time;
+            const double t = span > 0.0 ? (time - a.time) / span : 1.0;
+            cumulativeX = a.cumulativeX + (b.cumulativeX - a.cumulativeX) * t;
+            cumulativeZ = a.cumulativeZ + (b.cumulativeZ - a.cumulativeZ) * t;
+            return;
+        }
+        newer = older;
+    }
+
+    cumulativeX = inputHistory_[newer].cumulativeX;
+    cumulativeZ = inputHistory_[newer].cumulativeZ;
+}
@@ -3,6 +3,7 @@
 #include "cSC4BaseViewInputControl.h"
 #include "public/cIGZS3DCameraService.h"
 
+#include <array>
 #include <cstdint>
 #include <functional>
 
@@ -39,13 +40,31 @@ public:
     void SetWheelZoomStep(float unitsPerWheelStep);
     void SetKeyboardPanStep(float unitsPerPress);
     void SetInvertPitch(bool invertPitch);
+    /// Render the drag one mouse-message interval late, interpolating between messages, so frames that fall between
+    /// messages still move the camera evenly.
+    void SetSubFrameInterpolation(bool enabled);
+    /// Half-life of the exponential smoothing applied to yaw and pitch; 0 disables smoothing.
+    void SetSmoothingHalfLife(float seconds);
+
+    /// Applies the mouse movement received since the last frame as a single camera update. Call once per rendered
+    /// frame; mouse messages only accumulate deltas.
+    bool ApplyPendingInput();
 
 private:
+    struct InputSample
+    {
+        double time;
+        double cumulativeX;
+        double cumulativeZ;
+    };
+
+    static constexpr size_t kInputHistorySize = 32;
+
+    static double Now_();
     bool IsUsable_() const;
     bool PickTerrainAt_(int32_t screenX, int32_t screenZ, float& x, float& y, float& z) const;
 
     bool PanFromMouse_(int32_t x, int32_t z);
-    bool RotateFromMouse_(int32_t x, int32_t z);
     bool ZoomByWheel_(int32_t wheelDelta);
     bool AdjustPitchByWheel_(int32_t wheelDelta);
 
@@ -59,6 +78,9 @@ private:
     bool GetCameraAngles_(float& yawOut, float& pitchOut) const;
     bool ApplyCameraAngles_(float yaw, float pitch, bool updatePitchTables) const;
 
+    void RecordMouseDelta_(int32_t dx, int32_t dz);
+    void SampleInput_(double time, double& cumulativeX, double& cumulativeZ) const;
+
 private:
     cIGZS3DCameraService* cameraService_;
     std::function<void()> onCancel_;
@@ -74,4 +96,25 @@ private:
     float wheelZoomStep_;
     float keyboardPanStep_;
     bool invertPitch_;
+    bool subFrameInterpolation_;
+    float smoothingHalfLife_;
+
+    // Mouse deltas as a running total with receive times; frames consume the total up to their sample time.
+    std::array<InputSample, kInputHistorySize> inputHistory_;
+    size_t inputHistoryCount_;
+    size_t inputHistoryHead_;      // Index of the newest sample.
+    double inputCumulativeX_;
+    double inputCumulativeZ_;
+    double consumedX_;
+    double consumedZ_;
+    double inputInterval_;         // Smoothed time between mouse messages during a drag.
+    double lastFrameTime_;
+    double lastSampleTime_;
+
+    // Absolute heading (yaw plus the rotation step) and pitch being steered toward, and the smoothed values applied.
+    bool anglesActive_;
+    float targetHeading_;
+    float targetPitch_;
+    float smoothedHeading_;
+    float smoothedPitch_;
 };
@@ -9,6 +9,7 @@
 #include "public/S3DCameraServiceIds.h"
 #include "public/cIGZImGuiService.h"
 #include "public/cIGZS3DCameraService.h"
+#include "sample/camera-view-input/CameraPath.hpp"
 #include "sample/camera-view-input/CameraViewInputControl.hpp"
 #include "sample/camera-view-input/SC4CameraControlLayout.hpp"
 #include "utils/Logger.h"
@@ -17,8 +18,10 @@
 
 #include <atomic>
 #include <algorithm>
+#include <chrono>
 #include <cmath>
 #include <cstdint>
+#include <string>
 
 namespace
 {
@@ -30,9 +33,34 @@ namespace
     cIGZS3DCameraService* gCameraService = nullptr;
     std::atomic<bool> gCameraInputEnabled{false};
 
+    constexpr float kQuarterTurn = SC4CameraControl::kPi * 0.5f;
+    constexpr uint32_t kPlaybackWarmupFrames = 30;    // Not timed; covers the jump to the first sample.
+
+    enum class CameraPathMode
+    {
+        Idle,
+        Recording,
+        Playing
+    };
+
+    using PathClock = std::chrono::steady_clock;
+
     float gRotateDegPerPixel = 0.26f;
     float gPitchDegPerPixel = 0.20f;
     bool gInvertPitch = false;
+    bool gSubFrameInterpolation = false;
+    float gSmoothingHalfLifeMs = 0.0f;
+
+    CameraPath gCameraPath;
+    FrameTimeLog gFrameTimes;
+    FrameTimeSummary gLastSummary{};
+    CameraPathMode gPathMode = CameraPathMode::Idle;
+    char gCameraPathFile[260] = "camera_path.cpth";
+    int gPlaybackRateHz = 60;
+    PathClock::time_point gRecordStart{};
+    PathClock::time_point gLastFrameStart{};
+    uint32_t gPlaybackFrame = 0;
+    std::string gPathStatus;
 
     void DisableCameraInputTool();
     void SyncToolSettings();
@@ -42,6 +70,8 @@ namespace
         gRotateDegPerPixel = 0.26f;
         gPitchDegPerPixel = 0.20f;
         gInvertPitch = false;
+        gSubFrameInterpolation = false;
+        gSmoothingHalfLifeMs = 0.0f;
         SyncToolSettings();
         SC4CameraControl::ResetToDefaults();
         SC4CameraControl::RequestViewRedraw();
@@ -61,6 +91,8 @@ namespace
         gCameraInputTool->SetRotateSensitivity(DegToRad(gRotateDegPerPixel));
         gCameraInputTool->SetPitchSensitivity(DegToRad(gPitchDegPerPixel));
         gCameraInputTool->SetInvertPitch(gInvertPitch);
+        gCameraInputTool->SetSubFrameInterpolation(gSubFrameInterpolation);
+        gCameraInputTool->SetSmoothingHalfLife(gSmoothingHalfLifeMs * 0.001f);
     }
 
     int GetZoomMin(const SC4CameraControlLayout& cameraControl)
@@ -136,16 +168,230 @@ namespace
         }
     }
 
+    CameraPathSample CaptureCameraSample(const SC4CameraControlLayout& cameraControl, const float time)
+    {
+        CameraPathSample sample{};
+        sample.time = time;
+        sample.target[0] = cameraControl.viewTargetPosition.fX;
+        sample.target[1] = cameraControl.viewTargetPosition.fY;
+        sample.target[2] = cameraControl.viewTargetPosition.fZ;
+        sample.heading = cameraControl.yaw + static_cast<float>(cameraControl.rotation) * kQuarterTurn;
+        sample.pitch = cameraControl.pitch;
+        sample.zoomScale = static_cast<float>(cameraControl.zoom) +
+                           std::log2(std::max(cameraControl.customMagnification, 0.001f));
+        return sample;
+    }
+
+    // Zoom first, since a zoom step resets the camera control; then heading, which may change the rotation step, and
+    // finally the target, which the game re-clamps to the scroll bounds.
+    bool ApplyCameraSample(const CameraPathSample& sample)
+    {
+        auto* cameraControl = SC4CameraControl::GetActiveCameraControl();
+        if (!cameraControl) {
+            return false;
+        }
+
+        const float currentScale = static_cast<float>(cameraControl->zoom) +
+                                   std::log2(std::max(cameraControl->customMagnification, 0.001f));
+        if (std::fabs(sample.zoomScale - currentScale) > 1.0e-4f) {
+            const float magnification = std::exp2(sample.zoomScale - static_cast<float>(cameraControl->zoom));
+            if (!SC4CameraControl::SetCustomMagnification(magnification)) {
+                return false;
+            }
+            cameraControl = SC4CameraControl::GetActiveCameraControl();
+            if (!cameraControl) {
+                return false;
+            }
+        }
+
+        const float yaw = sample.heading - static_cast<float>(cameraControl->rotation) * kQuarterTurn;
+        if (!SC4CameraControl::SetYawPitch(yaw, sample.pitch)) {
+            return false;
+        }
+
+        const cS3DVector3 target{sample.target[0], sample.target[1], sample.target[2]};
+        if (!SC4CameraControl::SetViewTargetPosition(target)) {
+            return false;
+        }
+        SC4CameraControl::RequestViewRedraw();
+        return true;
+    }
+
+    void StartRecording()
+    {
+        gCameraPath.Clear();
+        gRecordStart = PathClock::now();
+        gPathMode = CameraPathMode::Recording;
+        gPathStatus = "Recording...";
+    }
+
+    void StopRecording()
+    {
+        gPathMode = CameraPathMode::Idle;
+        gPathStatus = "Recorded " + std::to_string(gCameraPath.Size()) + " samples";
+        LOG_INFO("CameraViewInput: recorded {} samples over {:.2f} s", gCameraPath.Size(), gCameraPath.Duration());
+    }
+
+    void StartPlayback()
+    {
+        if (gCameraPath.Empty()) {
+            gPathStatus = "No path to play";
+            return;
+        }
+
+        // The alt camera tool would fight the player for the camera.
+        DisableCameraInputTool();
+        SC4CameraControl::ClearQueuedYawPitch();
+
+        const float step = 1.0f / static_cast<float>(gPlaybackRateHz);
+        gFrameTimes.Clear();
+        gFrameTimes.Reserve(static_cast<size_t>(gCameraPath.Duration() / step) + 1);
+        gPlaybackFrame = 0;
+        gPathMode = CameraPathMode::Playing;
+        gPathStatus = "Playing...";
+    }
+
+    void FinishPlayback(const bool completed)
+    {
+        gPathMode = CameraPathMode::Idle;
+        gLastSummary = gFrameTimes.Summarize();
+        if (!completed) {
+            gPathStatus = "Playback stopped";
+            return;
+        }
+
+        const FrameTimeSummary& s = gLastSummary;
+        LOG_INFO("CameraViewInput: playback of {} finished, {} frames, mean {:.2f} ms, p50 {:.2f} ms, p90 {:.2f} ms, "
+                 "p95 {:.2f} ms, p99 {:.2f} ms, max {:.2f} ms",
+                 gCameraPathFile, s.frames, s.meanMs, s.p50Ms, s.p90Ms, s.p95Ms, s.p99Ms, s.maxMs);
+
+        const std::string reportPath = std::string(gCameraPathFile) + ".frames.csv";
+        if (gFrameTimes.WriteCsv(reportPath.c_str(), gCameraPathFile)) {
+            gPathStatus = "Report written to " + reportPath;
+        }
+        else {
+            gPathStatus = "Failed to write " + reportPath;
+            LOG_WARN("CameraViewInput: failed to write frame report {}", reportPath);
+        }
+    }
+
+    // Called once per rendered frame. Recording samples the camera as the user flies it; playback advances the path
+    // by a fixed step per frame, so every run renders the same camera states no matter how long the frames take, and
+    // times the frames it renders.
+    void UpdateCameraPath()
+    {
+        const PathClock::time_point now = PathClock::now();
+        const double frameMs = std::chrono::duration<double, std::milli>(now - gLastFrameStart).count();
+        gLastFrameStart = now;
+
+        if (gPathMode == CameraPathMode::Recording) {
+            if (const auto* cameraControl = SC4CameraControl::GetActiveCameraControl()) {
+                const float time = std::chrono::duration<float>(now - gRecordStart).count();
+                gCameraPath.Append(CaptureCameraSample(*cameraControl, time));
+            }
+            return;
+        }
+
+        if (gPathMode != CameraPathMode::Playing) {
+            return;
+        }
+
+        // The time since the previous call is the frame that showed the previous state.
+        const float step = 1.0f / static_cast<float>(gPlaybackRateHz);
+        if (gPlaybackFrame > kPlaybackWarmupFrames) {
+            const uint32_t shownFrame = gPlaybackFrame - 1 - kPlaybackWarmupFrames;
+            gFrameTimes.Add(static_cast<float>(shownFrame) * step, frameMs);
+        }
+
+        const uint32_t pathFrame = gPlaybackFrame > kPlaybackWarmupFrames ? gPlaybackFrame - kPlaybackWarmupFrames : 0;
+        const float pathTime = static_cast<float>(pathFrame) * step;
+        if (pathTime > gCameraPath.Duration()) {
+            FinishPlayback(true);
+            return;
+        }
+
+        CameraPathSample sample{};
+        if (!gCameraPath.Evaluate(gCameraPath.Samples().front().time + pathTime, sample) ||
+            !ApplyCameraSample(sample)) {
+            LOG_WARN("CameraViewInput: camera control unavailable, playback stopped");
+            FinishPlayback(false);
+            return;
+        }
+        ++gPlaybackFrame;
+    }
+
+    void DrawCameraPathControls()
+    {
+        ImGui::SeparatorText("Camera Path");
+
+        const bool idle = gPathMode == CameraPathMode::Idle;
+        ImGui::BeginDisabled(!idle);
+        ImGui::InputText("Path File", gCameraPathFile, sizeof(gCameraPathFile));
+        ImGui::SliderInt("Playback Rate (Hz)", &gPlaybackRateHz, 10, 240);
+        ImGui::EndDisabled();
+
+        if (gPathMode == CameraPathMode::Recording) {
+            if (ImGui::Button("Stop Recording")) {
+                StopRecording();
+            }
+        }
+        else if (gPathMode == CameraPathMode::Playing) {
+            if (ImGui::Button("Stop Playback")) {
+                FinishPlayback(false);
+            }
+        }
+        else {
+            if (ImGui::Button("Record")) {
+                StartRecording();
+            }
+            ImGui::SameLine();
+            ImGui::BeginDisabled(gCameraPath.Empty());
+            if (ImGui::Button("Play")) {
+                StartPlayback();
+            }
+            ImGui::SameLine();
+            if (ImGui::Button("Save")) {
+                gPathStatus = gCameraPath.SaveToFile(gCameraPathFile) ? "Saved" : "Save failed";
+            }
+            ImGui::EndDisabled();
+            ImGui::SameLine();
+            if (ImGui::Button("Load")) {
+                gPathStatus = gCameraPath.LoadFromFile(gCameraPathFile) ? "Loaded" : "Load failed";
+            }
+        }
+
+        ImGui::Text("Path: %zu samples, %.2f s", gCameraPath.Size(), gCameraPath.Duration());
+        if (!gPathStatus.empty()) {
+            ImGui::TextUnformatted(gPathStatus.c_str());
+        }
+        if (gLastSummary.frames > 0) {
+            const FrameTimeSummary& s = gLastSummary;
+            ImGui::Text("Frames %u  mean %.2f ms  max %.2f ms", s.frames, s.meanMs, s.maxMs);
+            ImGui::Text("p50 %.2f  p90 %.2f  p95 %.2f  p99 %.2f ms", s.p50Ms, s.p90Ms, s.p95Ms, s.p99Ms);
+        }
+    }
+
     class CameraViewInputPanel final : public ImGuiPanel
     {
     public:
+        void OnUpdate() override
+        {
+            // Mouse messages only accumulate; the camera moves once per frame here.
+            if (gCameraInputTool && gCameraInputEnabled.load(std::memory_order_relaxed)) {
+                gCameraInputTool->ApplyPendingInput();
+            }
+        }
+
         void OnRender() override
         {
             if (SC4CameraControl::FlushQueuedYawPitch()) {
                 SC4CameraControl::RequestViewRedraw();
             }
+            UpdateCameraPath();
 
             ImGui::Begin("Camera View Input", nullptr, ImGuiWindowFlags_AlwaysAutoResize);
+            const bool playing = gPathMode == CameraPathMode::Playing;
+            ImGui::BeginDisabled(playing);
 
             bool enabled = gCameraInputEnabled.load(std::memory_order_relaxed);
             if (ImGui::Checkbox("Enable Alt Camera Control", &enabled)) {
@@ -162,6 +408,8 @@ namespace
             ImGui::SliderFloat("Rotate Sensitivity (deg/px)", &gRotateDegPerPixel, 0.05f, 1.0f, "%.2f");
             ImGui::SliderFloat("Pitch Sensitivity (deg/px)", &gPitchDegPerPixel, 0.05f, 1.0f, "%.2f");
             ImGui::Checkbox("Invert Pitch", &gInvertPitch);
+            ImGui::Checkbox("Sub-frame Interpolation", &gSubFrameInterpolation);
+            ImGui::SliderFloat("Smoothing Half-life (ms)", &gSmoothingHalfLifeMs, 0.0f, 200.0f, "%.0f");
 
             if (ImGui::Button("Reset Defaults")) {
                 ResetAllDefaults();
@@ -214,6 +462,9 @@ namespace
             else {
                 ImGui::TextUnformatted("Camera control unavailable.");
             }
+            ImGui::EndDisabled();
+
+            DrawCameraPathControls();
 
             ImGui::End();
         }
@@ -300,6 +551,9 @@ public:
     {
         auto* standardMessage = static_cast<cIGZMessage2Standard*>(message);
         if (standardMessage && standardMessage->GetType() == kSC4MessagePreSave) {
+            if (gPathMode == CameraPathMode::Playing) {
+                FinishPlayback(false);
+            }
             ResetAllDefaults();
         }
 
@@ -308,6 +562,7 @@ public:
 
     bool PostAppShutdown() override
     {
+        gPathMode = CameraPathMode::Idle;
         DestroyCameraInputTool();
 
         if (subscribedToPreSave_) {
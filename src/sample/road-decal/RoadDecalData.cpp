@@ -2,13 +2,24 @@
 #define NOMINMAX
 
 #include "RoadDecalData.hpp"
+#include "RoadDecalGeometry.hpp"
+#include "RoadDecalGeometryCache.hpp"
+#include "RoadDecalTerrainSampler.hpp"
+#include "RoadDecalWorkerPool.hpp"
+#include "RoadMarkupFile.hpp"
+#include "RoadMarkupJournal.hpp"
+#include "RoadMarkupSpatialIndex.hpp"
+#include "RoadMarkupStore.hpp"
 
 #include <algorithm>
 #include <array>
 #include <atomic>
+#include <chrono>
 #include <cmath>
 #include <cstdint>
 #include <fstream>
+#include <string>
+#include <unordered_map>
 #include <vector>
 
 #ifndef NOMINMAX
@@ -26,7 +37,11 @@
 #include "cIGZOStream.h"
 #include "cIGZSerializable.h"
 #include "cIGZVariant.h"
+#include "public/cIGZDrawService.h"
 #include "public/cIGZImGuiService.h"
+#include "public/cIGZS3DCameraService.h"
+#include "public/cIGZTerrainService.h"
+#include "public/ViewFrustum.h"
 #include "utils/Logger.h"
 
 #ifdef min
@@ -39,24 +54,25 @@
 std::atomic<cIGZImGuiService*> gImGuiServiceForD3DOverlay{nullptr};
 std::vector<RoadMarkupLayer> gRoadMarkupLayers;
 int gActiveLayerIndex = 0;
-int gSelectedLayerIndex = -1;
-int gSelectedStrokeIndex = -1;
+uint32_t gSelectedStrokeId = 0;
 
 namespace
 {
     constexpr float kDecalTerrainOffset = 0.05f;
     constexpr float kTerrainGridSpacing = 16.0f;
     constexpr uint32_t kRoadDecalZBias = 1;
-    constexpr float kMinLen = 1.0e-4f;
-    constexpr float kDoubleYellowSpacing = 0.10f;
     constexpr float kTileSize = 16.0f;
+    constexpr float kDecalChunkSize = 4.0f * kTileSize;
     constexpr float kMinorGridSize = 2.0f;
     constexpr float kGridLineWidth = 0.10f;
     constexpr uint32_t kGridColor = 0x30FFFFFF;
-    constexpr uint32_t kMarkupFileMagic = 0x4B4D4452; // RDMK
-    constexpr uint32_t kMarkupFileVersion = 1;
+    constexpr uint32_t kMarkupFileVersion1 = 1;
+    constexpr float kMarkupFileTileSize = 2.0f * kDecalChunkSize;
+    constexpr auto kMarkupLoadFrameBudget = std::chrono::milliseconds(4);
     constexpr uint32_t kRoadMarkupSerializableClsid = 0xA6D45122;
     constexpr uint32_t kSelectionHighlightColor = 0xF000A5FF;
+    constexpr uint32_t kRoadDecalFVF = D3DFVF_XYZ | D3DFVF_DIFFUSE;
+    constexpr uint32_t kDynamicDecalRingVertices = 8192;
 
     struct RoadDecalStateGuard
     {
@@ -174,287 +190,631 @@ namespace
         IDirectDrawSurface7* texture1 = nullptr;
     };
 
-    struct RoadDecalVertex
+    // The selection outline only changes on edits and lives in a static draw service buffer. The in-progress stroke,
+    // preview segment and grid follow the mouse and share the dynamic ring path. Committed decals are drawn per chunk
+    // (see RoadDecalChunkBuffers).
+    enum RoadDecalGeometrySlot : size_t
     {
-        float x;
-        float y;
-        float z;
-        DWORD diffuse;
+        kDecalSlotSelection = 0,
+        kDecalSlotActive,
+        kDecalSlotPreview,
+        kDecalSlotGrid,
+        kDecalSlotCount
     };
 
-    void BuildStrokeVertices(const RoadMarkupStroke& stroke, std::vector<RoadDecalVertex>& outVerts);
-    void DrawVertexBuffer(IDirect3DDevice7* device, const std::vector<RoadDecalVertex>& verts);
+    struct RoadDecalGpuBuffer
+    {
+        DrawBufferHandle handle{0};
+        uint32_t startVertex = 0;
+        bool dirty = true;
+    };
 
-    std::vector<RoadDecalVertex> gRoadDecalVertices;
-    std::vector<RoadDecalVertex> gRoadDecalActiveVertices;
-    std::vector<RoadDecalVertex> gRoadDecalPreviewVertices;
-    std::vector<RoadDecalVertex> gRoadDecalGridVertices;
-    std::vector<RoadDecalVertex> gRoadDecalSelectionVertices;
+    // Static buffers holding one committed chunk, one per run of the chunk. Re-uploaded only when the chunk's version
+    // moves, so an edit re-sends just the chunks it touched.
+    struct RoadDecalChunkBuffers
+    {
+        std::vector<DrawBufferHandle> handles;
+        uint32_t version = 0;       // Chunk version on the device; 0 until uploaded.
+        uint32_t lastSweep = 0;
+    };
 
-    struct StrokeRef
+    void DrawIndexedVertexBuffer(IDirect3DDevice7* device, const RoadDecalVertex* verts, size_t vertexCount,
+                                 const uint16_t* indices, size_t indexCount);
+    void DrawRoadDecalGeometry(IDirect3DDevice7* device, RoadDecalGeometrySlot slot, const RoadDecalMesh& mesh);
+    void MarkRoadDecalGeometryDirty(RoadDecalGeometrySlot slot);
+    bool GetRoadDecalViewFrustum(IDirect3DDevice7* device, ViewFrustum& frustum);
+    void StreamPendingMarkupLoad(IDirect3DDevice7* device);
+    void DrawRoadDecalChunks(IDirect3DDevice7* device);
+    void ReleaseRoadDecalChunkBuffers(bool keepLiveChunks);
+
+    RoadDecalGeometryCache gRoadDecalGeometryCache{kDecalChunkSize};
+    RoadDecalMesh gRoadDecalActiveMesh;
+    RoadDecalMesh gRoadDecalPreviewMesh;
+    RoadDecalMesh gRoadDecalGridMesh;
+    RoadDecalMesh gRoadDecalSelectionMesh;
+
+    cIGZDrawService* gRoadDecalDrawService = nullptr;
+    cIGZTerrainService* gRoadDecalTerrainService = nullptr;
+    cIGZS3DCameraService* gRoadDecalCameraService = nullptr;
+    std::array<RoadDecalGpuBuffer, kDecalSlotCount> gRoadDecalGpuBuffers{};
+    std::unordered_map<uint64_t, RoadDecalChunkBuffers> gRoadDecalChunkBuffers;
+    std::vector<uint32_t> gRoadDecalChunkVisibleBits;
+    uint32_t gRoadDecalChunkSweep = 0;
+
+    RoadMarkupStore gRoadMarkupStore;
+    RoadMarkupSpatialIndex gRoadMarkupIndex{kTileSize};
+    RoadMarkupStroke gRoadMarkupScratchStroke;
+    std::vector<RoadMarkupStroke> gRoadMarkupRebuildStrokes;
+    RoadDecalWorkerPool gRoadDecalWorkerPool;
+    RoadDecalTerrainSampler gRoadDecalTerrainSampler;
+    RoadDecalTerrainSnapshot gRoadDecalTerrainSnapshot;
+
+    // A version 2 markup file being decoded over several frames: the chunks in view on the first frame, then a few
+    // milliseconds' worth each frame. Edits that change layer contents finish it first.
+    struct RoadMarkupPendingLoad
     {
-        int layerIndex = -1;
-        int strokeIndex = -1;
+        RoadMarkupMappedFile file;
+        RoadMarkupFileReader reader;
+        std::vector<uint32_t> chunks;       // Still to decode; the next one is last.
+        bool visibleDecoded = false;
     };
 
-    constexpr std::array<RoadMarkupProperties, 25> kMarkupProps = {{
-        {RoadMarkupType::SolidWhiteLine, RoadMarkupCategory::LaneDivider, "Solid White", "Continuous white lane divider.", 0.75f, 0.0f, 0xE0FFFFAA, false, false},
-        {RoadMarkupType::DashedWhiteLine, RoadMarkupCategory::LaneDivider, "Dashed White", "Dashed white lane divider.", 0.75f, 0.0f, 0xE0FFFFAA, true, false},
-        {RoadMarkupType::SolidYellowLine, RoadMarkupCategory::LaneDivider, "Solid Yellow", "Continuous yellow centerline.", 0.75f, 0.0f, 0xE0FFD700, false, false},
-        {RoadMarkupType::DashedYellowLine, RoadMarkupCategory::LaneDivider, "Dashed Yellow", "Dashed yellow centerline.", 0.75f, 0.0f, 0xE0FFD700, true, false},
-        {RoadMarkupType::DoubleSolidYellow, RoadMarkupCategory::LaneDivider, "Double Yellow", "Double solid yellow centerline.", 0.75f, 0.0f, 0xE0FFD700, false, true},
-        {RoadMarkupType::SolidWhiteEdgeLine, RoadMarkupCategory::LaneDivider, "Edge Line", "Solid white edge line.", 0.325f, 0.0f, 0xE0FFFFAA, false, true},
-
-        {RoadMarkupType::ArrowStraight, RoadMarkupCategory::DirectionalArrow, "Straight Arrow", "Straight lane arrow.", 1.20f, 3.00f, 0xE0FFFFAA, false, true},
-        {RoadMarkupType::ArrowLeft, RoadMarkupCategory::DirectionalArrow, "Left Arrow", "Left turn arrow.", 1.20f, 3.00f, 0xE0FFFFAA, false, true},
-        {RoadMarkupType::ArrowRight, RoadMarkupCategory::DirectionalArrow, "Right Arrow", "Right turn arrow.", 1.20f, 3.00f, 0xE0FFFAA, false, true},
-        {RoadMarkupType::ArrowLeftRight, RoadMarkupCategory::DirectionalArrow, "Left/Right Arrow", "Left-right arrow.", 1.20f, 3.00f, 0xE0FFFFAA, false, true},
-        {RoadMarkupType::ArrowStraightLeft, RoadMarkupCategory::DirectionalArrow, "Straight+Left", "Straight-left arrow.", 1.20f, 3.00f, 0xE0FFFFAA, false, true},
-        {RoadMarkupType::ArrowStraightRight, RoadMarkupCategory::DirectionalArrow, "Straight+Right", "Straight-right arrow.", 1.20f, 3.00f, 0xE0FFFFAA, false, true},
-        {RoadMarkupType::ArrowUTurn, RoadMarkupCategory::DirectionalArrow, "U-Turn Arrow", "U-turn arrow.", 1.20f, 3.00f, 0xE0FFFFAA, false, true},
-
-        {RoadMarkupType::ZebraCrosswalk, RoadMarkupCategory::Crossing, "Zebra Crosswalk", "Parallel zebra stripes.", 0.50f, 3.00f, 0xE0FFFFAA, false, true},
-        {RoadMarkupType::LadderCrosswalk, RoadMarkupCategory::Crossing, "Ladder Crosswalk", "Zebra with side rails.", 0.50f, 3.00f, 0xE0FFFFAA, false, true},
-        {RoadMarkupType::ContinentalCrosswalk, RoadMarkupCategory::Crossing, "Continental", "Thicker stripe crossing.", 0.80f, 3.00f, 0xE0FFFFAA, false, true},
-        {RoadMarkupType::StopBar, RoadMarkupCategory::Crossing, "Stop Bar", "Stop line bar.", 0.40f, 0.00f, 0xE0FFFFFF, false, true},
-
-        {RoadMarkupType::YieldTriangle, RoadMarkupCategory::ZoneMarking, "Yield Triangle", "Yield marker.", 0.15f, 1.00f, 0xE0FFFFAA, false, true},
-        {RoadMarkupType::ParkingSpace, RoadMarkupCategory::ZoneMarking, "Parking Space", "Parking outline marker.", 0.15f, 5.00f, 0xE0FFFFAA, false, true},
-        {RoadMarkupType::BikeSymbol, RoadMarkupCategory::ZoneMarking, "Bike Symbol", "Bike lane symbol.", 0.20f, 2.50f, 0xE0FFFFAA, false, true},
-        {RoadMarkupType::BusLane, RoadMarkupCategory::ZoneMarking, "Bus Lane", "Bus lane marker.", 0.20f, 6.00f, 0xE0FFFFAA, false, true},
-
-        {RoadMarkupType::TextStop, RoadMarkupCategory::TextLabel, "STOP", "Text marker phase 2.", 0.20f, 3.00f, 0xE0FFFFFF, false, true},
-        {RoadMarkupType::TextSlow, RoadMarkupCategory::TextLabel, "SLOW", "Text marker phase 2.", 0.20f, 3.00f, 0xE0FFFFFF, false, true},
-        {RoadMarkupType::TextSchool, RoadMarkupCategory::TextLabel, "SCHOOL", "Text marker phase 2.", 0.20f, 4.00f, 0xE0FFFFFF, false, true},
-        {RoadMarkupType::TextBusOnly, RoadMarkupCategory::TextLabel, "BUS ONLY", "Text marker phase 2.", 0.20f, 5.00f, 0xE0FFFFFF, false, true},
-    }};
-
-    const RoadMarkupProperties& FindProps(RoadMarkupType type)
+    RoadMarkupPendingLoad gRoadMarkupPendingLoad;
+    RoadMarkupJournal gRoadMarkupJournal;
+    RoadMarkupEdit gRoadMarkupUndoEdit;
+    bool gRoadMarkupAutosaveWarned = false;
+    uint32_t gRoadDecalSeenTerrainVersion = 0;
+
+    cISTETerrain* GetActiveTerrain()
     {
-        for (const auto& props : kMarkupProps) {
-            if (props.type == type) {
-                return props;
+        cISC4AppPtr app;
+        cISC4City* city = app ? app->GetCity() : nullptr;
+        return city ? city->GetTerrain() : nullptr;
+    }
+
+    float AltitudeAtGameGrid(const float x, const float z, void* userData)
+    {
+        return static_cast<cISTETerrain*>(userData)->GetAltitudeAtNearestGrid(x, z);
+    }
+
+    // Holds one terrain source for a batch of conforming: the pinned heightfield, or the game terrain behind a
+    // per-vertex cache. Nested passes reuse the outer one, so a whole rebuild acquires the heightfield once.
+    class RoadDecalTerrainPass
+    {
+    public:
+        RoadDecalTerrainPass()
+        {
+            if (gRoadDecalTerrainSampler.Active()) {
+                return;
+            }
+            owner_ = true;
+            if (gRoadDecalTerrainService && gRoadDecalTerrainService->AcquireHeightfield(view_)) {
+                pinned_ = true;
+                gRoadDecalTerrainSampler.BeginSnapshot(view_);
             }
+            else if (auto* terrain = GetActiveTerrain()) {
+                gRoadDecalTerrainSampler.BeginQueries(&AltitudeAtGameGrid, terrain, kTerrainGridSpacing);
+            }
+        }
+
+        ~RoadDecalTerrainPass()
+        {
+            if (!owner_) {
+                return;
+            }
+            gRoadDecalTerrainSampler.End();
+            if (pinned_) {
+                gRoadDecalTerrainService->ReleaseHeightfield(view_);
+            }
+        }
+
+        RoadDecalTerrainPass(const RoadDecalTerrainPass&) = delete;
+        RoadDecalTerrainPass& operator=(const RoadDecalTerrainPass&) = delete;
+
+        // The pinned heightfield, or nullptr when sampling the game terrain or when this pass is nested.
+        [[nodiscard]] const TerrainHeightfieldView* View() const { return pinned_ ? &view_ : nullptr; }
+
+    private:
+        TerrainHeightfieldView view_{};
+        bool owner_ = false;
+        bool pinned_ = false;
+    };
+
+    bool ConformPointsToTerrain(RoadDecalPoint* points, size_t count)
+    {
+        RoadDecalTerrainPass pass;
+        if (!gRoadDecalTerrainSampler.Active()) {
+            return false;
         }
-        return kMarkupProps[0];
+        gRoadDecalTerrainSampler.Conform(points, count, kDecalTerrainOffset);
+        return true;
     }
 
-    DWORD ApplyOpacity(uint32_t color, float opacity)
+    bool ConformPointsToTerrain(std::vector<RoadDecalPoint>& points)
     {
-        opacity = std::clamp(opacity, 0.0f, 1.0f);
-        const uint32_t baseA = (color >> 24U) & 0xFFU;
-        const uint32_t outA = static_cast<uint32_t>(std::clamp(baseA * opacity, 0.0f, 255.0f));
-        return (color & 0x00FFFFFFU) | (outA << 24U);
+        return ConformPointsToTerrain(points.data(), points.size());
     }
 
-    cISTETerrain* GetActiveTerrain()
+    void ConformStrokePoints(RoadDecalPoint* points, size_t count, void*)
     {
-        cISC4AppPtr app;
-        cISC4City* city = app ? app->GetCity() : nullptr;
-        return city ? city->GetTerrain() : nullptr;
+        ConformPointsToTerrain(points, count);
+    }
+
+    const RoadDecalConformer kTerrainConformer{&ConformStrokePoints, nullptr};
+
+    void ConformToPinnedHeightfield(RoadDecalPoint* points, size_t count, void* userData)
+    {
+        SampleHeightfieldBatch(*static_cast<const TerrainHeightfieldView*>(userData), &points->x, count,
+                               sizeof(RoadDecalPoint), kDecalTerrainOffset);
+    }
+
+    bool ChangedUnderTerrainSnapshot(const CullBox& bounds, void*)
+    {
+        return gRoadDecalTerrainSnapshot.Overlaps(bounds);
     }
 
-    float SampleTerrainHeight(cISTETerrain* terrain, float x, float z)
+    // Cached stroke heights are only valid for the heightfield they were sampled from. When a newer heightfield
+    // differs from the last one only in places, just the strokes over those places are dropped from the cache; the
+    // others keep their geometry. Without a pinned heightfield there is no version, so every rebuild starts cold.
+    uint64_t PrepareRoadDecalTerrainVersion(const RoadDecalTerrainPass& pass)
     {
-        if (!terrain) {
-            return 0.0f;
+        const TerrainHeightfieldView* view = pass.View();
+        if (!view || view->version == 0) {
+            gRoadDecalTerrainSnapshot.Clear();
+            return 0;
+        }
+        const uint32_t previous = gRoadDecalTerrainSnapshot.Version();
+        if (view->version != previous && gRoadDecalTerrainSnapshot.Update(*view, kDecalChunkSize)) {
+            gRoadDecalGeometryCache.InvalidateWhere(previous, view->version, &ChangedUnderTerrainSnapshot, nullptr);
         }
+        return view->version;
+    }
 
-        const float cellX = std::floor(x / kTerrainGridSpacing);
-        const float cellZ = std::floor(z / kTerrainGridSpacing);
-        const float x0 = cellX * kTerrainGridSpacing;
-        const float z0 = cellZ * kTerrainGridSpacing;
-        const float x1 = x0 + kTerrainGridSpacing;
-        const float z1 = z0 + kTerrainGridSpacing;
-        const float tx = std::clamp((x - x0) / kTerrainGridSpacing, 0.0f, 1.0f);
-        const float tz = std::clamp((z - z0) / kTerrainGridSpacing, 0.0f, 1.0f);
+    RoadMarkupLayer* FindLayerById(uint32_t layerId)
+    {
+        for (auto& layer : gRoadMarkupLayers) {
+            if (layer.id == layerId) {
+                return &layer;
+            }
+        }
+        return nullptr;
+    }
 
-        const float h00 = terrain->GetAltitudeAtNearestGrid(x0, z0);
-        const float h10 = terrain->GetAltitudeAtNearestGrid(x1, z0);
-        const float h01 = terrain->GetAltitudeAtNearestGrid(x0, z1);
-        const float h11 = terrain->GetAltitudeAtNearestGrid(x1, z1);
-        const float hx0 = h00 + (h10 - h00) * tx;
-        const float hx1 = h01 + (h11 - h01) * tx;
-        return hx0 + (hx1 - hx0) * tz;
+    bool IsSelectionValid()
+    {
+        return gRoadMarkupStore.Contains(gSelectedStrokeId);
     }
 
-    void ConformPointsToTerrain(std::vector<RoadDecalPoint>& points)
+    void RemoveStroke(uint32_t id)
     {
-        auto* terrain = GetActiveTerrain();
-        if (!terrain) {
+        gRoadMarkupIndex.Remove(id);
+        gRoadMarkupStore.Remove(id);
+    }
+
+    void RefreshSelectionHighlight()
+    {
+        if (!gRoadMarkupStore.Get(gSelectedStrokeId, gRoadMarkupScratchStroke)) {
+            SetRoadDecalSelectedStroke(nullptr);
             return;
         }
-        for (auto& point : points) {
-            point.y = SampleTerrainHeight(terrain, point.x, point.z) + kDecalTerrainOffset;
+        SetRoadDecalSelectedStroke(&gRoadMarkupScratchStroke);
+    }
+
+    void ResetRoadMarkupIndex()
+    {
+        gRoadMarkupIndex.Clear();
+        for (size_t row = 0; row < gRoadMarkupStore.Size(); ++row) {
+            const uint32_t id = gRoadMarkupStore.IdAt(row);
+            const auto points = gRoadMarkupStore.Points(id);
+            gRoadMarkupIndex.Update(id, points.data(), points.size());
         }
     }
 
-    bool GetDirectionXZ(const RoadDecalPoint& a, const RoadDecalPoint& b, float& outTx, float& outTz, float& outLen)
+    bool AcceptPickableStroke(uint32_t id, void*)
     {
-        const float dx = b.x - a.x;
-        const float dz = b.z - a.z;
-        const float len = std::sqrt(dx * dx + dz * dz);
-        if (len <= kMinLen) {
+        if (!gRoadMarkupStore.Visible(id)) {
             return false;
         }
-        outTx = dx / len;
-        outTz = dz / len;
-        outLen = len;
-        return true;
+        const RoadMarkupLayer* layer = FindLayerById(gRoadMarkupStore.LayerId(id));
+        return layer && layer->visible && !layer->locked;
     }
 
-    float Distance3(const RoadDecalPoint& a, const RoadDecalPoint& b)
+    bool IsMarkupLoadPending()
     {
-        const float dx = b.x - a.x;
-        const float dy = b.y - a.y;
-        const float dz = b.z - a.z;
-        return std::sqrt(dx * dx + dy * dy + dz * dz);
+        return gRoadMarkupPendingLoad.file.IsOpen();
     }
 
-    float DistanceXZToSegmentSquared(const RoadDecalPoint& p, const RoadDecalPoint& a, const RoadDecalPoint& b)
-    {
-        const float abX = b.x - a.x;
-        const float abZ = b.z - a.z;
-        const float apX = p.x - a.x;
-        const float apZ = p.z - a.z;
-        const float abLen2 = abX * abX + abZ * abZ;
-        if (abLen2 <= 1.0e-6f) {
-            return apX * apX + apZ * apZ;
-        }
-        const float t = std::clamp((apX * abX + apZ * abZ) / abLen2, 0.0f, 1.0f);
-        const float qx = a.x + abX * t;
-        const float qz = a.z + abZ * t;
-        const float dx = p.x - qx;
-        const float dz = p.z - qz;
-        return dx * dx + dz * dz;
-    }
-
-    float DistanceXZToStrokeSquared(const RoadDecalPoint& p, const RoadMarkupStroke& stroke)
+    void AddLoadedStroke(const uint32_t layerIndex, const uint32_t order, const RoadMarkupStroke& stroke, void*)
     {
-        if (stroke.points.empty()) {
-            return 1.0e12f;
+        const RoadMarkupFileReader& reader = gRoadMarkupPendingLoad.reader;
+        RoadMarkupLayer* layer = FindLayerById(reader.Layers()[layerIndex].id);
+        if (!layer || order >= layer->strokeIds.size() || layer->strokeIds[order] != 0) {
+            return;
         }
-        if (stroke.points.size() == 1) {
-            const float dx = p.x - stroke.points[0].x;
-            const float dz = p.z - stroke.points[0].z;
-            return dx * dx + dz * dz;
+        const uint32_t id = gRoadMarkupStore.Add(stroke);
+        layer->strokeIds[order] = id;
+        gRoadMarkupIndex.Update(id, stroke.points.data(), stroke.points.size());
+        if (static_cast<int32_t>(layerIndex) == reader.Info().selectedLayerIndex &&
+            static_cast<int32_t>(order) == reader.Info().selectedStrokeIndex) {
+            gSelectedStrokeId = id;
         }
+    }
 
-        float best = 1.0e12f;
-        for (size_t i = 1; i < stroke.points.size(); ++i) {
-            best = (std::min)(best, DistanceXZToSegmentSquared(p, stroke.points[i - 1], stroke.points[i]));
+    void DecodeNextMarkupChunk()
+    {
+        auto& load = gRoadMarkupPendingLoad;
+        const uint32_t chunk = load.chunks.back();
+        load.chunks.pop_back();
+        if (!load.reader.DecodeChunk(chunk, &AddLoadedStroke, nullptr)) {
+            LOG_WARN("RoadMarkup: skipped damaged chunk {} of the markup file", chunk);
         }
-        return best;
     }
 
-    StrokeRef GetSelectedStrokeRef()
+    // Closes the file. Strokes of chunks not decoded yet, or damaged, are dropped from their layers.
+    void EndPendingMarkupLoad()
     {
-        if (gSelectedLayerIndex < 0 || gSelectedLayerIndex >= static_cast<int>(gRoadMarkupLayers.size())) {
-            return {};
+        if (!IsMarkupLoadPending()) {
+            return;
         }
-        const auto& layer = gRoadMarkupLayers[static_cast<size_t>(gSelectedLayerIndex)];
-        if (gSelectedStrokeIndex < 0 || gSelectedStrokeIndex >= static_cast<int>(layer.strokes.size())) {
-            return {};
+        for (auto& layer : gRoadMarkupLayers) {
+            std::erase(layer.strokeIds, 0u);
         }
-        return {gSelectedLayerIndex, gSelectedStrokeIndex};
+        gRoadMarkupPendingLoad.chunks.clear();
+        gRoadMarkupPendingLoad.reader.Close();
+        gRoadMarkupPendingLoad.file.Close();
     }
 
-    bool IsSelectionValid()
+    void DecodeRemainingMarkupChunks()
     {
-        const StrokeRef ref = GetSelectedStrokeRef();
-        return ref.layerIndex >= 0 && ref.strokeIndex >= 0;
+        while (!gRoadMarkupPendingLoad.chunks.empty()) {
+            DecodeNextMarkupChunk();
+        }
+        EndPendingMarkupLoad();
     }
 
-    RoadMarkupStroke* GetStrokeByRef(const StrokeRef& ref)
+    void FinishPendingMarkupLoad()
     {
-        if (ref.layerIndex < 0 || ref.strokeIndex < 0) {
-            return nullptr;
-        }
-        auto& layer = gRoadMarkupLayers[static_cast<size_t>(ref.layerIndex)];
-        if (ref.strokeIndex >= static_cast<int>(layer.strokes.size())) {
-            return nullptr;
+        if (!IsMarkupLoadPending()) {
+            return;
         }
-        return &layer.strokes[static_cast<size_t>(ref.strokeIndex)];
+        DecodeRemainingMarkupChunks();
+        RebuildRoadDecalGeometry();
     }
 
-    class FileOStream final : public cIGZOStream
+    // Replaces the markings with the layers of a version 2 file and queues its chunks. Leaves everything as it was if
+    // the file's tables are damaged.
+    bool BeginPendingMarkupLoad()
     {
-    public:
-        explicit FileOStream(std::ofstream& out)
-            : out_(out)
-        {
+        auto& load = gRoadMarkupPendingLoad;
+        if (!load.reader.Open(load.file.Data(), load.file.Size())) {
+            load.file.Close();
+            return false;
         }
 
-        bool QueryInterface(uint32_t riid, void** ppvObj) override
-        {
-            if (!ppvObj) {
-                return false;
+        gRoadMarkupStore.Clear();
+        gRoadMarkupIndex.Clear();
+        gSelectedStrokeId = 0;
+        gRoadMarkupLayers = load.reader.Layers();
+        gActiveLayerIndex = load.reader.Info().activeLayerIndex;
+        const auto chunkCount = static_cast<uint32_t>(load.reader.Chunks().size());
+        load.chunks.resize(chunkCount);
+        for (uint32_t i = 0; i < chunkCount; ++i) {
+            load.chunks[i] = chunkCount - 1 - i;
+        }
+        load.visibleDecoded = false;
+        return true;
+    }
+
+    bool EncodeRoadMarkups(std::vector<uint8_t>& bytes)
+    {
+        EnsureDefaultRoadMarkupLayer();
+        RoadMarkupFileInfo info;
+        info.activeLayerIndex = gActiveLayerIndex;
+        RoadMarkupFileWriter writer(kMarkupFileTileSize);
+        RoadMarkupStroke stroke;
+        for (size_t i = 0; i < gRoadMarkupLayers.size(); ++i) {
+            const auto& layer = gRoadMarkupLayers[i];
+            writer.BeginLayer(layer);
+            for (size_t s = 0; s < layer.strokeIds.size(); ++s) {
+                if (!gRoadMarkupStore.Get(layer.strokeIds[s], stroke)) {
+                    return false;
+                }
+                if (layer.strokeIds[s] == gSelectedStrokeId) {
+                    info.selectedLayerIndex = static_cast<int32_t>(i);
+                    info.selectedStrokeIndex = static_cast<int32_t>(s);
+                }
+                writer.AddStroke(stroke);
             }
-            if (riid == GZIID_cIGZUnknown) {
-                *ppvObj = static_cast<cIGZUnknown*>(this);
-                AddRef();
-                return true;
+        }
+        writer.Finish(info, bytes);
+        return true;
+    }
+
+    // Hands the autosave a new snapshot when it asks for one. Waits for a pending load, as the snapshot must hold
+    // every stroke.
+    void RefreshRoadMarkupAutosave()
+    {
+        if (gRoadMarkupJournal.AutosaveFailed() && !gRoadMarkupAutosaveWarned) {
+            LOG_WARN("RoadMarkup: writing the autosave failed");
+            gRoadMarkupAutosaveWarned = true;
+        }
+        if (!gRoadMarkupJournal.WantsSnapshot() || IsMarkupLoadPending()) {
+            return;
+        }
+        std::vector<uint8_t> bytes;
+        if (EncodeRoadMarkups(bytes)) {
+            gRoadMarkupJournal.Snapshot(std::move(bytes));
+        }
+    }
+
+    int FindLayerIndex(uint32_t layerId)
+    {
+        for (size_t i = 0; i < gRoadMarkupLayers.size(); ++i) {
+            if (gRoadMarkupLayers[i].id == layerId) {
+                return static_cast<int>(i);
             }
-            *ppvObj = nullptr;
+        }
+        return -1;
+    }
+
+    uint32_t StrokeIdAt(uint32_t layerId, uint32_t index)
+    {
+        const RoadMarkupLayer* layer = FindLayerById(layerId);
+        return layer && index < layer->strokeIds.size() ? layer->strokeIds[index] : 0;
+    }
+
+    // Where a committed stroke sits, as edits address it.
+    bool FindStrokePosition(uint32_t id, uint32_t& layerId, uint32_t& index)
+    {
+        const RoadMarkupLayer* layer = FindLayerById(gRoadMarkupStore.LayerId(id));
+        if (!layer) {
             return false;
         }
+        const auto it = std::find(layer->strokeIds.begin(), layer->strokeIds.end(), id);
+        if (it == layer->strokeIds.end()) {
+            return false;
+        }
+        layerId = layer->id;
+        index = static_cast<uint32_t>(it - layer->strokeIds.begin());
+        return true;
+    }
 
-        uint32_t AddRef() override { return ++refCount_; }
-        uint32_t Release() override
-        {
-            const uint32_t n = --refCount_;
-            if (n == 0) {
-                delete this;
-            }
-            return n;
+    void CopyLayerStrokes(const RoadMarkupLayer& layer, std::vector<RoadMarkupStroke>& out)
+    {
+        for (const uint32_t id : layer.strokeIds) {
+            gRoadMarkupStore.Get(id, out.emplace_back());
         }
+    }
 
-        void Flush() override { out_.flush(); }
-        bool SetSint8(int8_t v) override { return WriteRaw_(&v, sizeof(v)); }
-        bool SetUint8(uint8_t v) override { return WriteRaw_(&v, sizeof(v)); }
-        bool SetSint16(int16_t v) override { return WriteRaw_(&v, sizeof(v)); }
-        bool SetUint16(uint16_t v) override { return WriteRaw_(&v, sizeof(v)); }
-        bool SetSint32(int32_t v) override { return WriteRaw_(&v, sizeof(v)); }
-        bool SetUint32(uint32_t v) override { return WriteRaw_(&v, sizeof(v)); }
-        bool SetSint64(int64_t v) override { return WriteRaw_(&v, sizeof(v)); }
-        bool SetUint64(uint64_t v) override { return WriteRaw_(&v, sizeof(v)); }
-        bool SetFloat32(float v) override { return WriteRaw_(&v, sizeof(v)); }
-        bool SetFloat64(double v) override { return WriteRaw_(&v, sizeof(v)); }
-        bool SetRZCharStr(const char*) override { error_ = 1; return false; }
-        bool SetGZStr(cIGZString const&) override { error_ = 1; return false; }
-        bool SetGZSerializable(cIGZSerializable const& sData) override
-        {
-            // cIGZSerializable::Write is non-const in the SDK interface.
-            return const_cast<cIGZSerializable&>(sData).Write(*this);
+    // The stroke's layerId must be the layer's.
+    void InsertStroke(RoadMarkupLayer& layer, size_t index, const RoadMarkupStroke& stroke)
+    {
+        const uint32_t id = gRoadMarkupStore.Add(stroke);
+        layer.strokeIds.insert(layer.strokeIds.begin() + static_cast<std::ptrdiff_t>(index), id);
+        gRoadMarkupIndex.Update(id, stroke.points.data(), stroke.points.size());
+    }
+
+    void EraseStroke(RoadMarkupLayer& layer, size_t index)
+    {
+        const uint32_t id = layer.strokeIds[index];
+        if (gSelectedStrokeId == id) {
+            ClearRoadMarkupSelection();
         }
-        bool SetVoid(void const* pData, uint32_t size) override
-        {
-            return WriteRaw_(pData, size);
+        layer.strokeIds.erase(layer.strokeIds.begin() + static_cast<std::ptrdiff_t>(index));
+        RemoveStroke(id);
+    }
+
+    void EraseLayerStrokes(RoadMarkupLayer& layer)
+    {
+        if (gRoadMarkupStore.LayerId(gSelectedStrokeId) == layer.id) {
+            ClearRoadMarkupSelection();
         }
-        int32_t GetError() override { return error_; }
-        int32_t SetUserData(cIGZVariant* pData) override
-        {
-            userData_ = reinterpret_cast<intptr_t>(pData);
-            return 0;
+        for (const uint32_t id : layer.strokeIds) {
+            RemoveStroke(id);
         }
-        int32_t GetUserData() override { return static_cast<int32_t>(userData_); }
+        layer.strokeIds.clear();
+    }
 
-    private:
-        bool WriteRaw_(void const* pData, uint32_t size)
-        {
-            out_.write(reinterpret_cast<const char*>(pData), size);
-            if (!out_.good()) {
-                error_ = 1;
+    void TranslateStroke(uint32_t id, float deltaX, float deltaZ)
+    {
+        const auto points = gRoadMarkupStore.MutablePoints(id);
+        for (auto& p : points) {
+            p.x += deltaX;
+            p.z += deltaZ;
+        }
+        ConformPointsToTerrain(points.data(), points.size());
+        gRoadMarkupIndex.Update(id, points.data(), points.size());
+    }
+
+    void RotateStroke(uint32_t id, float deltaRadians)
+    {
+        const auto points = gRoadMarkupStore.MutablePoints(id);
+        if (points.empty()) {
+            return;
+        }
+
+        float centerX = 0.0f;
+        float centerZ = 0.0f;
+        for (const auto& p : points) {
+            centerX += p.x;
+            centerZ += p.z;
+        }
+        const float inv = 1.0f / static_cast<float>(points.size());
+        centerX *= inv;
+        centerZ *= inv;
+
+        const float s = std::sin(deltaRadians);
+        const float c = std::cos(deltaRadians);
+        for (auto& p : points) {
+            const float x = p.x - centerX;
+            const float z = p.z - centerZ;
+            p.x = centerX + (x * c - z * s);
+            p.z = centerZ + (x * s + z * c);
+        }
+        gRoadMarkupStore.SetRotation(id, gRoadMarkupStore.Rotation(id) + deltaRadians);
+        ConformPointsToTerrain(points.data(), points.size());
+        gRoadMarkupIndex.Update(id, points.data(), points.size());
+    }
+
+    // Applies an edit, or reverts it. Every change to the markings' contents goes through here, whether it is made,
+    // undone, redone or replayed from the autosave. Fails without changing anything when the edit does not fit the
+    // markings, which only a journal replayed onto the wrong markings can cause.
+    bool ApplyRoadMarkupEdit(const RoadMarkupEdit& edit, bool revert)
+    {
+        using Kind = RoadMarkupEditKind;
+        Kind kind = edit.kind;
+        if (revert) {
+            kind = kind == Kind::AddStroke    ? Kind::DeleteStroke
+                 : kind == Kind::DeleteStroke ? Kind::AddStroke
+                 : kind == Kind::AddLayer     ? Kind::DeleteLayer
+                 : kind == Kind::DeleteLayer  ? Kind::AddLayer
+                                              : kind;
+        }
+        const float sign = revert ? -1.0f : 1.0f;
+
+        switch (kind) {
+        case Kind::AddStroke: {
+            RoadMarkupLayer* layer = FindLayerById(edit.layerId);
+            if (!layer || edit.index > layer->strokeIds.size() || edit.strokes.size() != 1 ||
+                edit.strokes.front().layerId != layer->id) {
                 return false;
             }
+            InsertStroke(*layer, edit.index, edit.strokes.front());
             return true;
         }
+        case Kind::DeleteStroke: {
+            RoadMarkupLayer* layer = FindLayerById(edit.layerId);
+            if (!layer || edit.index >= layer->strokeIds.size()) {
+                return false;
+            }
+            EraseStroke(*layer, edit.index);
+            return true;
+        }
+        case Kind::MoveStroke:
+        case Kind::RotateStroke:
+        case Kind::SetStrokeStyle: {
+            const uint32_t id = StrokeIdAt(edit.layerId, edit.index);
+            if (id == 0) {
+                return false;
+            }
+            if (kind == Kind::MoveStroke) {
+                TranslateStroke(id, sign * edit.deltaX, sign * edit.deltaZ);
+            }
+            else if (kind == Kind::RotateStroke) {
+                RotateStroke(id, sign * edit.radians);
+            }
+            else {
+                gRoadMarkupStore.SetStyle(id, revert ? edit.before : edit.after);
+            }
+            return true;
+        }
+        case Kind::AddLayer: {
+            if (FindLayerById(edit.layerId) || edit.index > gRoadMarkupLayers.size()) {
+                return false;
+            }
+            for (const auto& stroke : edit.strokes) {
+                if (stroke.layerId != edit.layerId) {
+                    return false;
+                }
+            }
+            auto& layer = *gRoadMarkupLayers.insert(gRoadMarkupLayers.begin() + edit.index, edit.layer);
+            layer.id = edit.layerId;
+            layer.strokeIds.clear();
+            for (const auto& stroke : edit.strokes) {
+                InsertStroke(layer, layer.strokeIds.size(), stroke);
+            }
+            return true;
+        }
+        case Kind::DeleteLayer: {
+            const int index = FindLayerIndex(edit.layerId);
+            if (index < 0 || gRoadMarkupLayers.size() <= 1) {
+                return false;
+            }
+            EraseLayerStrokes(gRoadMarkupLayers[static_cast<size_t>(index)]);
+            gRoadMarkupLayers.erase(gRoadMarkupLayers.begin() + index);
+            gActiveLayerIndex = std::clamp(gActiveLayerIndex, 0, static_cast<int>(gRoadMarkupLayers.size()) - 1);
+            return true;
+        }
+        case Kind::MoveLayer: {
+            const uint32_t from = revert ? edit.toIndex : edit.index;
+            const uint32_t to = revert ? edit.index : edit.toIndex;
+            if (from >= gRoadMarkupLayers.size() || to >= gRoadMarkupLayers.size()) {
+                return false;
+            }
+            RoadMarkupLayer moved = std::move(gRoadMarkupLayers[from]);
+            gRoadMarkupLayers.erase(gRoadMarkupLayers.begin() + from);
+            gRoadMarkupLayers.insert(gRoadMarkupLayers.begin() + to, std::move(moved));
+            for (size_t i = 0; i < gRoadMarkupLayers.size(); ++i) {
+                gRoadMarkupLayers[i].renderOrder = static_cast<int>(i);
+            }
+            return true;
+        }
+        case Kind::ClearStrokes:
+            if (!revert) {
+                for (auto& layer : gRoadMarkupLayers) {
+                    if (edit.layerId == 0 || layer.id == edit.layerId) {
+                        EraseLayerStrokes(layer);
+                    }
+                }
+                return true;
+            }
+            for (const auto& stroke : edit.strokes) {
+                if (!FindLayerById(stroke.layerId)) {
+                    return false;
+                }
+            }
+            for (const auto& stroke : edit.strokes) {
+                RoadMarkupLayer& layer = *FindLayerById(stroke.layerId);
+                InsertStroke(layer, layer.strokeIds.size(), stroke);
+            }
+            return true;
+        }
+        return false;
+    }
 
-        std::atomic<uint32_t> refCount_{1};
-        std::ofstream& out_;
-        int32_t error_ = 0;
-        intptr_t userData_ = 0;
-    };
+    bool ReplayRoadMarkupEdit(const RoadMarkupEdit& edit, bool revert, void*)
+    {
+        return ApplyRoadMarkupEdit(edit, revert);
+    }
+
+    // Makes an edit and records it for undo and the autosave.
+    bool CommitRoadMarkupEdit(const RoadMarkupEdit& edit)
+    {
+        if (!ApplyRoadMarkupEdit(edit, false)) {
+            return false;
+        }
+        gRoadMarkupJournal.Record(edit);
+        RefreshRoadMarkupAutosave();
+        return true;
+    }
+
+    // Loads the autosave's snapshot and replays its journal onto it.
+    bool RecoverRoadMarkupAutosave(const char* filepath)
+    {
+        RoadMarkupMappedFile snapshot;
+        if (!snapshot.Open(filepath)) {
+            return false;
+        }
+        if (!LoadMarkupsFromFile(filepath)) {
+            LOG_WARN("RoadMarkup: could not recover the autosave {}", filepath);
+            return false;
+        }
+        FinishPendingMarkupLoad();
+
+        size_t replayed = 0;
+        RoadMarkupMappedFile journal;
+        if (journal.Open((std::string(filepath) + ".journal").c_str())) {
+            replayed = RoadMarkupJournal::Replay(snapshot.Data(), snapshot.Size(), journal.Data(), journal.Size(),
+                                                 &ReplayRoadMarkupEdit, nullptr);
+        }
+        if (!IsSelectionValid()) {
+            ClearRoadMarkupSelection();
+        }
+        RebuildRoadDecalGeometry();
+        LOG_INFO("RoadMarkup: recovered {} markings from the autosave, {} edits from its journal",
+                 GetTotalRoadMarkupStrokeCount(), replayed);
+        return true;
+    }
 
     class FileIStream final : public cIGZIStream
     {
@@ -553,484 +913,31 @@ namespace
             }
             if (riid == GZIID_cIGZUnknown || riid == GZIID_cIGZSerializable) {
                 *ppvObj = static_cast<cIGZSerializable*>(this);
-                AddRef();
-                return true;
-            }
-            *ppvObj = nullptr;
-            return false;
-        }
-
-        uint32_t AddRef() override { return ++refCount_; }
-        uint32_t Release() override
-        {
-            const uint32_t n = --refCount_;
-            if (n == 0) {
-                delete this;
-            }
-            return n;
-        }
-
-        bool Write(cIGZOStream& stream) override;
-        bool Read(cIGZIStream& stream) override;
-        uint32_t GetGZCLSID() override { return kRoadMarkupSerializableClsid; }
-
-    private:
-        std::atomic<uint32_t> refCount_{1};
-    };
-
-    RoadDecalPoint LerpByT(const RoadDecalPoint& a, const RoadDecalPoint& b, float ta, float tb, float t)
-    {
-        const float denom = tb - ta;
-        if (std::fabs(denom) < 1.0e-5f) {
-            return b;
-        }
-        const float wa = (tb - t) / denom;
-        const float wb = (t - ta) / denom;
-        return {
-            wa * a.x + wb * b.x,
-            wa * a.y + wb * b.y,
-            wa * a.z + wb * b.z,
-            false
-        };
-    }
-
-    RoadDecalPoint CentripetalCatmullRomPoint(const RoadDecalPoint& p0,
-                                              const RoadDecalPoint& p1,
-                                              const RoadDecalPoint& p2,
-                                              const RoadDecalPoint& p3,
-                                              float u)
-    {
-        constexpr float kAlpha = 0.5f;
-        const float t0 = 0.0f;
-        const float t1 = t0 + std::pow((std::max)(Distance3(p0, p1), 1.0e-4f), kAlpha);
-        const float t2 = t1 + std::pow((std::max)(Distance3(p1, p2), 1.0e-4f), kAlpha);
-        const float t3 = t2 + std::pow((std::max)(Distance3(p2, p3), 1.0e-4f), kAlpha);
-        const float t = t1 + (t2 - t1) * u;
-
-        const auto a1 = LerpByT(p0, p1, t0, t1, t);
-        const auto a2 = LerpByT(p1, p2, t1, t2, t);
-        const auto a3 = LerpByT(p2, p3, t2, t3, t);
-        const auto b1 = LerpByT(a1, a2, t0, t2, t);
-        const auto b2 = LerpByT(a2, a3, t1, t3, t);
-        return LerpByT(b1, b2, t1, t2, t);
-    }
-
-    RoadDecalPoint ClampPointToSegmentBounds(const RoadDecalPoint& p, const RoadDecalPoint& a, const RoadDecalPoint& b)
-    {
-        const float minX = (std::min)(a.x, b.x);
-        const float maxX = (std::max)(a.x, b.x);
-        const float minZ = (std::min)(a.z, b.z);
-        const float maxZ = (std::max)(a.z, b.z);
-
-        RoadDecalPoint out = p;
-        out.x = std::clamp(out.x, minX, maxX);
-        out.z = std::clamp(out.z, minZ, maxZ);
-        out.hardCorner = false;
-        return out;
-    }
-
-    void BuildSmoothedPolyline(const std::vector<RoadDecalPoint>& points, std::vector<RoadDecalPoint>& outPoints)
-    {
-        outPoints.clear();
-        if (points.size() < 3) {
-            outPoints = points;
-            return;
-        }
-
-        outPoints.reserve(points.size() * 4);
-        outPoints.push_back(points.front());
-
-        for (size_t i = 0; i + 1 < points.size(); ++i) {
-            const auto& p1 = points[i];
-            const auto& p2 = points[i + 1];
-
-            const bool forceLinear = p1.hardCorner || p2.hardCorner;
-            if (forceLinear) {
-                outPoints.push_back(p2);
-                continue;
-            }
-
-            const auto& p0Raw = (i == 0) ? points[i] : points[i - 1];
-            const auto& p3Raw = (i + 2 < points.size()) ? points[i + 2] : points[i + 1];
-            const bool p0Hard = (i > 0) && points[i - 1].hardCorner;
-            const bool p3Hard = (i + 2 < points.size()) && points[i + 2].hardCorner;
-            const auto& p0 = p0Hard ? p1 : p0Raw;
-            const auto& p3 = p3Hard ? p2 : p3Raw;
-
-            const float dx = p2.x - p1.x;
-            const float dz = p2.z - p1.z;
-            const float segmentLength = std::sqrt(dx * dx + dz * dz);
-            const int steps = std::clamp(static_cast<int>(std::ceil(segmentLength / 1.0f)), 3, 12);
-
-            for (int step = 1; step <= steps; ++step) {
-                const float t = static_cast<float>(step) / static_cast<float>(steps);
-                const RoadDecalPoint sample = CentripetalCatmullRomPoint(p0, p1, p2, p3, t);
-                outPoints.push_back(ClampPointToSegmentBounds(sample, p1, p2));
-            }
-        }
-    }
-
-    void EmitTriangle(const RoadDecalPoint& a, const RoadDecalPoint& b, const RoadDecalPoint& c, DWORD color, std::vector<RoadDecalVertex>& outVerts)
-    {
-        outVerts.push_back({a.x, a.y, a.z, color});
-        outVerts.push_back({b.x, b.y, b.z, color});
-        outVerts.push_back({c.x, c.y, c.z, color});
-    }
-
-    void EmitQuad(const RoadDecalPoint& a, const RoadDecalPoint& b, const RoadDecalPoint& c, const RoadDecalPoint& d, DWORD color, std::vector<RoadDecalVertex>& outVerts)
-    {
-        EmitTriangle(a, b, c, color, outVerts);
-        EmitTriangle(a, c, d, color, outVerts);
-    }
-
-    void EmitThickSegmentNoConform(const RoadDecalPoint& a,
-                                   const RoadDecalPoint& b,
-                                   float width,
-                                   DWORD color,
-                                   std::vector<RoadDecalVertex>& outVerts)
-    {
-        float tx = 0.0f;
-        float tz = 0.0f;
-        float len = 0.0f;
-        if (!GetDirectionXZ(a, b, tx, tz, len) || width <= 0.0f) {
-            return;
-        }
-        const float halfWidth = width * 0.5f;
-        const float nx = -tz;
-        const float nz = tx;
-        const RoadDecalPoint aL{a.x - nx * halfWidth, a.y, a.z - nz * halfWidth, false};
-        const RoadDecalPoint aR{a.x + nx * halfWidth, a.y, a.z + nz * halfWidth, false};
-        const RoadDecalPoint bL{b.x - nx * halfWidth, b.y, b.z - nz * halfWidth, false};
-        const RoadDecalPoint bR{b.x + nx * halfWidth, b.y, b.z + nz * halfWidth, false};
-        EmitQuad(aL, bL, bR, aR, color, outVerts);
-    }
-
-    RoadDecalPoint LocalPoint(const RoadDecalPoint& center,
-                              float rightX,
-                              float rightZ,
-                              float fwdX,
-                              float fwdZ,
-                              float lateral,
-                              float forward)
-    {
-        return {
-            center.x + rightX * lateral + fwdX * forward,
-            center.y,
-            center.z + rightZ * lateral + fwdZ * forward,
-            false
-        };
-    }
-
-    void BuildLine(const std::vector<RoadDecalPoint>& points,
-                   float width,
-                   DWORD color,
-                   bool dashed,
-                   float dashLength,
-                   float gapLength,
-                   std::vector<RoadDecalVertex>& outVerts)
-    {
-        if (points.size() < 2 || width <= 0.0f) {
-            return;
-        }
-
-        std::vector<RoadDecalPoint> path;
-        BuildSmoothedPolyline(points, path);
-        if (path.empty()) {
-            path = points;
-        }
-        ConformPointsToTerrain(path);
-
-        dashLength = std::max(0.05f, dashLength);
-        gapLength = std::max(0.0f, gapLength);
-        const float cycleLength = dashLength + gapLength;
-        float cyclePos = 0.0f;
-        const float halfWidth = width * 0.5f;
-
-        for (size_t i = 0; i + 1 < path.size(); ++i) {
-            const auto& p0 = path[i];
-            const auto& p1 = path[i + 1];
-            float tx = 0.0f;
-            float tz = 0.0f;
-            float segLen = 0.0f;
-            if (!GetDirectionXZ(p0, p1, tx, tz, segLen)) {
-                continue;
-            }
-            const float nx = -tz;
-            const float nz = tx;
-
-            auto emitSlice = [&](float t0, float t1) {
-                const RoadDecalPoint a{p0.x + (p1.x - p0.x) * t0, p0.y + (p1.y - p0.y) * t0, p0.z + (p1.z - p0.z) * t0, false};
-                const RoadDecalPoint b{p0.x + (p1.x - p0.x) * t1, p0.y + (p1.y - p0.y) * t1, p0.z + (p1.z - p0.z) * t1, false};
-                const RoadDecalPoint aL{a.x - nx * halfWidth, a.y, a.z - nz * halfWidth, false};
-                const RoadDecalPoint aR{a.x + nx * halfWidth, a.y, a.z + nz * halfWidth, false};
-                const RoadDecalPoint bL{b.x - nx * halfWidth, b.y, b.z - nz * halfWidth, false};
-                const RoadDecalPoint bR{b.x + nx * halfWidth, b.y, b.z + nz * halfWidth, false};
-                EmitQuad(aL, bL, bR, aR, color, outVerts);
-            };
-
-            if (!dashed || cycleLength <= 0.0f) {
-                emitSlice(0.0f, 1.0f);
-                continue;
-            }
-
-            float segPos = 0.0f;
-            while (segPos < segLen) {
-                const float boundary = (cyclePos < dashLength) ? dashLength : cycleLength;
-                float step = boundary - cyclePos;
-                if (step <= 0.0f) {
-                    cyclePos = 0.0f;
-                    continue;
-                }
-                step = (std::min)(step, segLen - segPos);
-
-                if (cyclePos < dashLength) {
-                    emitSlice(segPos / segLen, (segPos + step) / segLen);
-                }
-                segPos += step;
-                cyclePos += step;
-                if (cyclePos >= cycleLength - 1.0e-4f) {
-                    cyclePos = 0.0f;
-                }
+                AddRef();
+                return true;
             }
+            *ppvObj = nullptr;
+            return false;
         }
-    }
 
-    void BuildStraightArrow(const RoadMarkupStroke& stroke, DWORD color, std::vector<RoadDecalVertex>& outVerts)
-    {
-        if (stroke.points.empty()) {
-            return;
-        }
-        const RoadDecalPoint center = stroke.points.front();
-        const float fx = std::cos(stroke.rotation);
-        const float fz = std::sin(stroke.rotation);
-        const float rx = -fz;
-        const float rz = fx;
-        const float width = std::max(0.2f, stroke.width);
-        const float length = std::max(0.8f, stroke.length);
-
-        auto p0 = LocalPoint(center, rx, rz, fx, fz, -0.15f * width, -0.50f * length);
-        auto p1 = LocalPoint(center, rx, rz, fx, fz, -0.15f * width, 0.10f * length);
-        auto p2 = LocalPoint(center, rx, rz, fx, fz, +0.15f * width, 0.10f * length);
-        auto p3 = LocalPoint(center, rx, rz, fx, fz, +0.15f * width, -0.50f * length);
-        auto tip = LocalPoint(center, rx, rz, fx, fz, 0.00f, 0.50f * length);
-        auto hl = LocalPoint(center, rx, rz, fx, fz, -0.50f * width, 0.10f * length);
-        auto hr = LocalPoint(center, rx, rz, fx, fz, +0.50f * width, 0.10f * length);
-
-        std::vector<RoadDecalPoint> shape = {p0, p1, p2, p3, tip, hl, hr};
-        ConformPointsToTerrain(shape);
-        EmitQuad(shape[0], shape[1], shape[2], shape[3], color, outVerts);
-        EmitTriangle(shape[5], shape[4], shape[6], color, outVerts);
-    }
-
-    void BuildTurnArrow(const RoadMarkupStroke& stroke, bool left, bool withStraight, DWORD color, std::vector<RoadDecalVertex>& outVerts)
-    {
-        if (withStraight) {
-            BuildStraightArrow(stroke, color, outVerts);
-        }
-        const RoadDecalPoint center = stroke.points.front();
-        const float fx = std::cos(stroke.rotation);
-        const float fz = std::sin(stroke.rotation);
-        const float rx = -fz;
-        const float rz = fx;
-        const float sign = left ? -1.0f : 1.0f;
-
-        std::vector<RoadDecalPoint> path = {
-            LocalPoint(center, rx, rz, fx, fz, 0.0f, -0.35f * stroke.length),
-            LocalPoint(center, rx, rz, fx, fz, 0.0f, -0.05f * stroke.length),
-            LocalPoint(center, rx, rz, fx, fz, sign * 0.35f * stroke.length, 0.25f * stroke.length),
-        };
-        BuildLine(path, std::max(0.08f, stroke.width * 0.30f), color, false, 0.0f, 0.0f, outVerts);
-
-        RoadMarkupStroke head = stroke;
-        head.points = {path.back()};
-        head.rotation += left ? -1.57f : 1.57f;
-        head.length = std::max(0.5f, stroke.length * 0.35f);
-        head.width = std::max(0.4f, stroke.width * 0.90f);
-        BuildStraightArrow(head, color, outVerts);
-    }
-
-    void BuildUTurnArrow(const RoadMarkupStroke& stroke, DWORD color, std::vector<RoadDecalVertex>& outVerts)
-    {
-        const RoadDecalPoint center = stroke.points.front();
-        const float fx = std::cos(stroke.rotation);
-        const float fz = std::sin(stroke.rotation);
-        const float rx = -fz;
-        const float rz = fx;
-
-        std::vector<RoadDecalPoint> path = {
-            LocalPoint(center, rx, rz, fx, fz, 0.0f, -0.45f * stroke.length),
-            LocalPoint(center, rx, rz, fx, fz, 0.0f, -0.10f * stroke.length),
-        };
-        const float radius = std::max(0.4f, stroke.length * 0.28f);
-        for (int i = 0; i <= 8; ++i) {
-            const float t = static_cast<float>(i) / 8.0f;
-            const float ang = -0.2f * 3.1415926f + (1.35f * 3.1415926f) * t;
-            path.push_back(LocalPoint(center, rx, rz, fx, fz,
-                                      -0.18f * stroke.length + std::cos(ang) * radius,
-                                      +0.08f * stroke.length + std::sin(ang) * radius));
-        }
-        BuildLine(path, std::max(0.08f, stroke.width * 0.30f), color, false, 0.0f, 0.0f, outVerts);
-
-        RoadMarkupStroke head = stroke;
-        head.points = {path.back()};
-        head.rotation += 3.1415926f;
-        head.length = std::max(0.5f, stroke.length * 0.35f);
-        head.width = std::max(0.4f, stroke.width * 0.90f);
-        BuildStraightArrow(head, color, outVerts);
-    }
-
-    void BuildCrosswalk(const RoadMarkupStroke& stroke,
-                        float stripe,
-                        float gap,
-                        bool ladderRails,
-                        DWORD color,
-                        std::vector<RoadDecalVertex>& outVerts)
-    {
-        const auto& start = stroke.points[0];
-        const auto& end = stroke.points[1];
-        float dragTx = 0.0f;
-        float dragTz = 0.0f;
-        float length = 0.0f;
-        if (!GetDirectionXZ(start, end, dragTx, dragTz, length)) {
-            return;
-        }
-        // Treat user drag length as curb-to-curb span.
-        // Stripe orientation follows stroke.rotation (auto-align writes drag direction;
-        // manual rotation works when auto-align is off).
-        float tx = std::cos(stroke.rotation);
-        float tz = std::sin(stroke.rotation);
-        if (std::fabs(tx) < 0.0001f && std::fabs(tz) < 0.0001f) {
-            tx = dragTx;
-            tz = dragTz;
-        }
-        const float perpX = -tz;
-        const float perpZ = tx;
-        // Keep dimensions decoupled:
-        // - drag length controls curb-to-curb span
-        // - stroke.length controls crossing depth (visual width along road)
-        const float span = length;
-        const float depth = std::max(stripe, stroke.length);
-        const int stripes = std::max(1, static_cast<int>(std::floor((depth + gap) / (stripe + gap))));
-        const float usedDepth = static_cast<float>(stripes) * stripe + static_cast<float>(stripes - 1) * gap;
-        const float firstOffset = -0.5f * usedDepth + stripe * 0.5f;
-        const RoadDecalPoint center{
-            (start.x + end.x) * 0.5f,
-            (start.y + end.y) * 0.5f,
-            (start.z + end.z) * 0.5f,
-            false
-        };
-
-        for (int i = 0; i < stripes; ++i) {
-            const float offset = firstOffset + static_cast<float>(i) * (stripe + gap);
-            const RoadDecalPoint a{
-                center.x + perpX * offset - tx * (span * 0.5f),
-                center.y,
-                center.z + perpZ * offset - tz * (span * 0.5f),
-                false
-            };
-            const RoadDecalPoint b{
-                center.x + perpX * offset + tx * (span * 0.5f),
-                center.y,
-                center.z + perpZ * offset + tz * (span * 0.5f),
-                false
-            };
-            BuildLine({a, b}, stripe, color, false, 0.0f, 0.0f, outVerts);
-        }
-
-        if (ladderRails) {
-            const float railLeft = -0.5f * depth;
-            const float railRight = 0.5f * depth;
-            const RoadDecalPoint l0{
-                center.x + perpX * railLeft - tx * (span * 0.5f),
-                center.y,
-                center.z + perpZ * railLeft - tz * (span * 0.5f),
-                false
-            };
-            const RoadDecalPoint l1{
-                center.x + perpX * railLeft + tx * (span * 0.5f),
-                center.y,
-                center.z + perpZ * railLeft + tz * (span * 0.5f),
-                false
-            };
-            const RoadDecalPoint r0{
-                center.x + perpX * railRight - tx * (span * 0.5f),
-                center.y,
-                center.z + perpZ * railRight - tz * (span * 0.5f),
-                false
-            };
-            const RoadDecalPoint r1{
-                center.x + perpX * railRight + tx * (span * 0.5f),
-                center.y,
-                center.z + perpZ * railRight + tz * (span * 0.5f),
-                false
-            };
-            BuildLine({l0, l1}, stripe * 0.5f, color, false, 0.0f, 0.0f, outVerts);
-            BuildLine({r0, r1}, stripe * 0.5f, color, false, 0.0f, 0.0f, outVerts);
+        uint32_t AddRef() override { return ++refCount_; }
+        uint32_t Release() override
+        {
+            const uint32_t n = --refCount_;
+            if (n == 0) {
+                delete this;
+            }
+            return n;
         }
-    }
-}
-
-const RoadMarkupProperties& GetRoadMarkupProperties(RoadMarkupType type)
-{
-    return FindProps(type);
-}
 
-RoadMarkupCategory GetMarkupCategory(RoadMarkupType type)
-{
-    return FindProps(type).category;
-}
+        bool Write(cIGZOStream& stream) override;
+        bool Read(cIGZIStream& stream) override;
+        uint32_t GetGZCLSID() override { return kRoadMarkupSerializableClsid; }
 
-const std::vector<RoadMarkupType>& GetRoadMarkupTypesForCategory(RoadMarkupCategory category)
-{
-    static const std::vector<RoadMarkupType> laneTypes = {
-        RoadMarkupType::SolidWhiteLine,
-        RoadMarkupType::DashedWhiteLine,
-        RoadMarkupType::SolidYellowLine,
-        RoadMarkupType::DashedYellowLine,
-        RoadMarkupType::DoubleSolidYellow,
-        RoadMarkupType::SolidWhiteEdgeLine,
-    };
-    static const std::vector<RoadMarkupType> arrowTypes = {
-        RoadMarkupType::ArrowStraight,
-        RoadMarkupType::ArrowLeft,
-        RoadMarkupType::ArrowRight,
-        RoadMarkupType::ArrowLeftRight,
-        RoadMarkupType::ArrowStraightLeft,
-        RoadMarkupType::ArrowStraightRight,
-        RoadMarkupType::ArrowUTurn,
-    };
-    static const std::vector<RoadMarkupType> crossingTypes = {
-        RoadMarkupType::ZebraCrosswalk,
-        RoadMarkupType::LadderCrosswalk,
-        RoadMarkupType::ContinentalCrosswalk,
-        RoadMarkupType::StopBar,
-    };
-    static const std::vector<RoadMarkupType> zoneTypes = {
-        RoadMarkupType::YieldTriangle,
-        RoadMarkupType::ParkingSpace,
-        RoadMarkupType::BikeSymbol,
-        RoadMarkupType::BusLane,
-    };
-    static const std::vector<RoadMarkupType> textTypes = {
-        RoadMarkupType::TextStop,
-        RoadMarkupType::TextSlow,
-        RoadMarkupType::TextSchool,
-        RoadMarkupType::TextBusOnly,
+    private:
+        std::atomic<uint32_t> refCount_{1};
     };
 
-    switch (category) {
-    case RoadMarkupCategory::LaneDivider:
-        return laneTypes;
-    case RoadMarkupCategory::DirectionalArrow:
-        return arrowTypes;
-    case RoadMarkupCategory::Crossing:
-        return crossingTypes;
-    case RoadMarkupCategory::ZoneMarking:
-        return zoneTypes;
-    case RoadMarkupCategory::TextLabel:
-    default:
-        return textTypes;
-    }
 }
 
 void EnsureDefaultRoadMarkupLayer()
@@ -1054,120 +961,179 @@ RoadMarkupLayer* GetActiveRoadMarkupLayer()
 
 bool AddRoadMarkupLayer(const std::string& name)
 {
+    FinishPendingMarkupLoad();
     EnsureDefaultRoadMarkupLayer();
-    if (gRoadMarkupLayers.size() >= 10) {
-        return false;
-    }
     uint32_t id = 1;
     for (const auto& layer : gRoadMarkupLayers) {
         id = (std::max)(id, layer.id + 1);
     }
-    gRoadMarkupLayers.push_back({id, name.empty() ? "Layer" : name, {}, true, false, static_cast<int>(gRoadMarkupLayers.size())});
+    RoadMarkupEdit edit;
+    edit.kind = RoadMarkupEditKind::AddLayer;
+    edit.layerId = id;
+    edit.index = static_cast<uint32_t>(gRoadMarkupLayers.size());
+    edit.layer = {id, name.empty() ? "Layer" : name, {}, true, false, static_cast<int>(gRoadMarkupLayers.size())};
+    if (!CommitRoadMarkupEdit(edit)) {
+        return false;
+    }
     gActiveLayerIndex = static_cast<int>(gRoadMarkupLayers.size() - 1);
+    RebuildRoadDecalGeometry();
     return true;
 }
 
 void DeleteActiveRoadMarkupLayer()
 {
+    FinishPendingMarkupLoad();
     EnsureDefaultRoadMarkupLayer();
+    const auto& layer = gRoadMarkupLayers[static_cast<size_t>(gActiveLayerIndex)];
+    RoadMarkupEdit edit;
+    edit.layerId = layer.id;
+    edit.index = static_cast<uint32_t>(gActiveLayerIndex);
+    CopyLayerStrokes(layer, edit.strokes);
     if (gRoadMarkupLayers.size() <= 1) {
-        gRoadMarkupLayers[0].strokes.clear();
-        ClearRoadMarkupSelection();
-        return;
+        // The last layer stays, emptied.
+        if (edit.strokes.empty()) {
+            return;
+        }
+        edit.kind = RoadMarkupEditKind::ClearStrokes;
     }
-    if (gSelectedLayerIndex == gActiveLayerIndex) {
-        ClearRoadMarkupSelection();
-    } else if (gSelectedLayerIndex > gActiveLayerIndex) {
-        --gSelectedLayerIndex;
+    else {
+        edit.kind = RoadMarkupEditKind::DeleteLayer;
+        edit.layer = layer;
+        edit.layer.strokeIds.clear();
+    }
+    if (CommitRoadMarkupEdit(edit)) {
+        RebuildRoadDecalGeometry();
     }
-    gRoadMarkupLayers.erase(gRoadMarkupLayers.begin() + gActiveLayerIndex);
-    gActiveLayerIndex = std::clamp(gActiveLayerIndex, 0, static_cast<int>(gRoadMarkupLayers.size()) - 1);
 }
 
-bool AddRoadMarkupStrokeToActiveLayer(const RoadMarkupStroke& stroke)
+bool MoveActiveRoadMarkupLayer(int offset)
 {
-    auto* layer = GetActiveRoadMarkupLayer();
-    if (!layer || layer->locked || layer->strokes.size() >= 100) {
+    FinishPendingMarkupLoad();
+    EnsureDefaultRoadMarkupLayer();
+    const int target = gActiveLayerIndex + offset;
+    if (offset == 0 || target < 0 || target >= static_cast<int>(gRoadMarkupLayers.size())) {
+        return false;
+    }
+    RoadMarkupEdit edit;
+    edit.kind = RoadMarkupEditKind::MoveLayer;
+    edit.layerId = gRoadMarkupLayers[static_cast<size_t>(gActiveLayerIndex)].id;
+    edit.index = static_cast<uint32_t>(gActiveLayerIndex);
+    edit.toIndex = static_cast<uint32_t>(target);
+    if (!CommitRoadMarkupEdit(edit)) {
         return false;
     }
-    auto stored = stroke;
-    stored.layerId = layer->id;
-    layer->strokes.push_back(stored);
+    gActiveLayerIndex = target;
+    RebuildRoadDecalGeometry();
     return true;
 }
 
-void UndoLastRoadMarkupStroke()
+bool AddRoadMarkupStrokeToActiveLayer(const RoadMarkupStroke& stroke)
 {
+    FinishPendingMarkupLoad();
     auto* layer = GetActiveRoadMarkupLayer();
-    if (!layer || layer->strokes.empty()) {
-        return;
+    if (!layer || layer->locked) {
+        return false;
     }
-    if (gSelectedLayerIndex == gActiveLayerIndex &&
-        gSelectedStrokeIndex == static_cast<int>(layer->strokes.size()) - 1) {
-        ClearRoadMarkupSelection();
+    RoadMarkupEdit edit;
+    edit.kind = RoadMarkupEditKind::AddStroke;
+    edit.layerId = layer->id;
+    edit.index = static_cast<uint32_t>(layer->strokeIds.size());
+    edit.strokes.push_back(stroke);
+    edit.strokes.front().layerId = layer->id;
+    if (!CommitRoadMarkupEdit(edit)) {
+        return false;
     }
-    layer->strokes.pop_back();
+    RebuildRoadDecalGeometry();
+    return true;
 }
 
 void ClearAllRoadMarkupStrokes()
 {
+    // Decodes the rest of a pending load first, so clearing can be undone.
+    FinishPendingMarkupLoad();
     EnsureDefaultRoadMarkupLayer();
-    for (auto& layer : gRoadMarkupLayers) {
-        layer.strokes.clear();
+    RoadMarkupEdit edit;
+    edit.kind = RoadMarkupEditKind::ClearStrokes;
+    for (const auto& layer : gRoadMarkupLayers) {
+        CopyLayerStrokes(layer, edit.strokes);
     }
     ClearRoadMarkupSelection();
+    if (!edit.strokes.empty() && CommitRoadMarkupEdit(edit)) {
+        RebuildRoadDecalGeometry();
+    }
 }
 
-size_t GetTotalRoadMarkupStrokeCount()
+bool UndoRoadMarkupEdit()
 {
-    size_t total = 0;
-    for (const auto& layer : gRoadMarkupLayers) {
-        total += layer.strokes.size();
+    FinishPendingMarkupLoad();
+    if (!gRoadMarkupJournal.Undo(gRoadMarkupUndoEdit)) {
+        return false;
+    }
+    if (!ApplyRoadMarkupEdit(gRoadMarkupUndoEdit, true)) {
+        gRoadMarkupJournal.ClearHistory();
+        gRoadMarkupJournal.RequestSnapshot();
+        return false;
     }
-    return total;
+    RefreshRoadMarkupAutosave();
+    RebuildRoadDecalGeometry();
+    return true;
 }
 
-bool SelectRoadMarkupStrokeAtPoint(const RoadDecalPoint& worldPoint, float maxDistanceMeters)
+bool RedoRoadMarkupEdit()
 {
-    EnsureDefaultRoadMarkupLayer();
-    const float maxDistance2 = (std::max)(0.1f, maxDistanceMeters) * (std::max)(0.1f, maxDistanceMeters);
-    float bestDistance2 = maxDistance2;
-    StrokeRef best{};
-
-    for (size_t layerIndex = 0; layerIndex < gRoadMarkupLayers.size(); ++layerIndex) {
-        const auto& layer = gRoadMarkupLayers[layerIndex];
-        if (!layer.visible || layer.locked) {
-            continue;
-        }
-        for (size_t strokeIndex = 0; strokeIndex < layer.strokes.size(); ++strokeIndex) {
-            const auto& stroke = layer.strokes[strokeIndex];
-            if (!stroke.visible) {
-                continue;
-            }
-            const float distance2 = DistanceXZToStrokeSquared(worldPoint, stroke);
-            if (distance2 <= bestDistance2) {
-                bestDistance2 = distance2;
-                best.layerIndex = static_cast<int>(layerIndex);
-                best.strokeIndex = static_cast<int>(strokeIndex);
-            }
-        }
+    FinishPendingMarkupLoad();
+    if (!gRoadMarkupJournal.Redo(gRoadMarkupUndoEdit)) {
+        return false;
+    }
+    if (!ApplyRoadMarkupEdit(gRoadMarkupUndoEdit, false)) {
+        gRoadMarkupJournal.ClearHistory();
+        gRoadMarkupJournal.RequestSnapshot();
+        return false;
     }
+    RefreshRoadMarkupAutosave();
+    RebuildRoadDecalGeometry();
+    return true;
+}
+
+bool CanUndoRoadMarkupEdit()
+{
+    return gRoadMarkupJournal.CanUndo();
+}
+
+bool CanRedoRoadMarkupEdit()
+{
+    return gRoadMarkupJournal.CanRedo();
+}
+
+size_t GetTotalRoadMarkupStrokeCount()
+{
+    return gRoadMarkupStore.Size();
+}
 
-    if (best.layerIndex < 0 || best.strokeIndex < 0) {
+bool SelectRoadMarkupStrokeAtPoint(const RoadDecalPoint& worldPoint, float maxDistanceMeters)
+{
+    EnsureDefaultRoadMarkupLayer();
+    const float maxDistance = (std::max)(0.1f, maxDistanceMeters);
+    const uint32_t id = gRoadMarkupIndex.FindNearest(worldPoint.x, worldPoint.z, maxDistance, &AcceptPickableStroke,
+                                                     nullptr);
+    if (id == 0) {
         return false;
     }
 
-    gSelectedLayerIndex = best.layerIndex;
-    gSelectedStrokeIndex = best.strokeIndex;
-    gActiveLayerIndex = best.layerIndex;
-    SetRoadDecalSelectedStroke(GetSelectedRoadMarkupStrokeConst());
+    gSelectedStrokeId = id;
+    const uint32_t layerId = gRoadMarkupStore.LayerId(id);
+    for (size_t i = 0; i < gRoadMarkupLayers.size(); ++i) {
+        if (gRoadMarkupLayers[i].id == layerId) {
+            gActiveLayerIndex = static_cast<int>(i);
+        }
+    }
+    RefreshSelectionHighlight();
     return true;
 }
 
 void ClearRoadMarkupSelection()
 {
-    gSelectedLayerIndex = -1;
-    gSelectedStrokeIndex = -1;
+    gSelectedStrokeId = 0;
     SetRoadDecalSelectedStroke(nullptr);
 }
 
@@ -1176,80 +1142,73 @@ bool HasRoadMarkupSelection()
     return IsSelectionValid();
 }
 
-RoadMarkupStroke* GetSelectedRoadMarkupStroke()
-{
-    return GetStrokeByRef(GetSelectedStrokeRef());
-}
-
-const RoadMarkupStroke* GetSelectedRoadMarkupStrokeConst()
+bool GetSelectedRoadMarkupStroke(RoadMarkupStroke& out)
 {
-    const StrokeRef ref = GetSelectedStrokeRef();
-    if (ref.layerIndex < 0 || ref.strokeIndex < 0) {
-        return nullptr;
-    }
-    return &gRoadMarkupLayers[static_cast<size_t>(ref.layerIndex)].strokes[static_cast<size_t>(ref.strokeIndex)];
+    return gRoadMarkupStore.Get(gSelectedStrokeId, out);
 }
 
 bool DeleteSelectedRoadMarkupStroke()
 {
-    const StrokeRef ref = GetSelectedStrokeRef();
-    if (ref.layerIndex < 0 || ref.strokeIndex < 0) {
+    FinishPendingMarkupLoad();
+    RoadMarkupEdit edit;
+    if (!FindStrokePosition(gSelectedStrokeId, edit.layerId, edit.index) || FindLayerById(edit.layerId)->locked) {
         return false;
     }
-    auto& layer = gRoadMarkupLayers[static_cast<size_t>(ref.layerIndex)];
-    if (layer.locked || ref.strokeIndex >= static_cast<int>(layer.strokes.size())) {
+    edit.kind = RoadMarkupEditKind::DeleteStroke;
+    gRoadMarkupStore.Get(gSelectedStrokeId, edit.strokes.emplace_back());
+    if (!CommitRoadMarkupEdit(edit)) {
         return false;
     }
-    layer.strokes.erase(layer.strokes.begin() + ref.strokeIndex);
-    ClearRoadMarkupSelection();
     RebuildRoadDecalGeometry();
     return true;
 }
 
 bool MoveSelectedRoadMarkupStroke(float deltaX, float deltaZ)
 {
-    auto* stroke = GetSelectedRoadMarkupStroke();
-    if (!stroke || stroke->points.empty()) {
+    FinishPendingMarkupLoad();
+    RoadMarkupEdit edit;
+    if (!FindStrokePosition(gSelectedStrokeId, edit.layerId, edit.index)) {
         return false;
     }
-    for (auto& p : stroke->points) {
-        p.x += deltaX;
-        p.z += deltaZ;
+    edit.kind = RoadMarkupEditKind::MoveStroke;
+    edit.deltaX = deltaX;
+    edit.deltaZ = deltaZ;
+    if (!CommitRoadMarkupEdit(edit)) {
+        return false;
     }
-    ConformPointsToTerrain(stroke->points);
-    SetRoadDecalSelectedStroke(stroke);
     RebuildRoadDecalGeometry();
     return true;
 }
 
 bool RotateSelectedRoadMarkupStroke(float deltaRadians)
 {
-    auto* stroke = GetSelectedRoadMarkupStroke();
-    if (!stroke || stroke->points.empty()) {
+    FinishPendingMarkupLoad();
+    RoadMarkupEdit edit;
+    if (!FindStrokePosition(gSelectedStrokeId, edit.layerId, edit.index)) {
         return false;
     }
-
-    float centerX = 0.0f;
-    float centerZ = 0.0f;
-    for (const auto& p : stroke->points) {
-        centerX += p.x;
-        centerZ += p.z;
+    edit.kind = RoadMarkupEditKind::RotateStroke;
+    edit.radians = deltaRadians;
+    if (!CommitRoadMarkupEdit(edit)) {
+        return false;
     }
-    const float inv = 1.0f / static_cast<float>(stroke->points.size());
-    centerX *= inv;
-    centerZ *= inv;
+    RebuildRoadDecalGeometry();
+    return true;
+}
 
-    const float s = std::sin(deltaRadians);
-    const float c = std::cos(deltaRadians);
-    for (auto& p : stroke->points) {
-        const float x = p.x - centerX;
-        const float z = p.z - centerZ;
-        p.x = centerX + (x * c - z * s);
-        p.z = centerZ + (x * s + z * c);
+bool SetSelectedRoadMarkupStrokeStyle(const RoadMarkupStrokeStyle& style)
+{
+    FinishPendingMarkupLoad();
+    RoadMarkupEdit edit;
+    if (!FindStrokePosition(gSelectedStrokeId, edit.layerId, edit.index)) {
+        return false;
+    }
+    edit.kind = RoadMarkupEditKind::SetStrokeStyle;
+    edit.before = gRoadMarkupStore.Style(gSelectedStrokeId);
+    edit.after = style;
+    if (!CommitRoadMarkupEdit(edit)) {
+        return false;
     }
-    stroke->rotation += deltaRadians;
-    ConformPointsToTerrain(stroke->points);
-    SetRoadDecalSelectedStroke(stroke);
     RebuildRoadDecalGeometry();
     return true;
 }
@@ -1257,7 +1216,6 @@ bool RotateSelectedRoadMarkupStroke(float deltaRadians)
 void RebuildRoadDecalGeometry()
 {
     EnsureDefaultRoadMarkupLayer();
-    gRoadDecalVertices.clear();
     std::vector<const RoadMarkupLayer*> orderedLayers;
     orderedLayers.reserve(gRoadMarkupLayers.size());
     for (const auto& layer : gRoadMarkupLayers) {
@@ -1268,6 +1226,8 @@ void RebuildRoadDecalGeometry()
                          return a->renderOrder < b->renderOrder;
                      });
 
+    // Copied out in render order, reusing last rebuild's point buffers.
+    size_t strokeCount = 0;
     for (const auto* layer : orderedLayers) {
         if (!layer) {
             continue;
@@ -1275,20 +1235,82 @@ void RebuildRoadDecalGeometry()
         if (!layer->visible) {
             continue;
         }
-        for (const auto& stroke : layer->strokes) {
-            BuildStrokeVertices(stroke, gRoadDecalVertices);
+        for (const uint32_t id : layer->strokeIds) {
+            if (strokeCount == gRoadMarkupRebuildStrokes.size()) {
+                gRoadMarkupRebuildStrokes.emplace_back();
+            }
+            if (gRoadMarkupStore.Get(id, gRoadMarkupRebuildStrokes[strokeCount])) {
+                ++strokeCount;
+            }
+        }
+    }
+
+    // The pinned heightfield is read-only, so new strokes can be conformed on the workers. The game terrain can only
+    // be queried from this thread.
+    RoadDecalTerrainPass terrainPass;
+    const uint64_t terrainVersion = PrepareRoadDecalTerrainVersion(terrainPass);
+    const TerrainHeightfieldView* view = terrainPass.View();
+    const RoadDecalConformer conformer = view
+        ? RoadDecalConformer{&ConformToPinnedHeightfield, const_cast<TerrainHeightfieldView*>(view), true}
+        : kTerrainConformer;
+    if (view && strokeCount >= RoadDecalGeometryCache::kMinParallelStrokes) {
+        gRoadDecalWorkerPool.Start(RoadDecalWorkerPool::DefaultWorkerCount());
+    }
+
+    gRoadDecalGeometryCache.BeginRebuild(terrainVersion);
+    gRoadDecalGeometryCache.AddStrokes(gRoadMarkupRebuildStrokes.data(), strokeCount, conformer,
+                                       gRoadDecalWorkerPool.Started() ? &gRoadDecalWorkerPool : nullptr);
+    gRoadDecalGeometryCache.EndRebuild();
+    ReleaseRoadDecalChunkBuffers(true);
+    RefreshSelectionHighlight();
+}
+
+void SetRoadDecalDrawService(cIGZDrawService* drawService)
+{
+    if (gRoadDecalDrawService) {
+        for (auto& gpu : gRoadDecalGpuBuffers) {
+            gRoadDecalDrawService->ReleaseDrawBuffer(gpu.handle);
+            gpu = {};
         }
+        ReleaseRoadDecalChunkBuffers(false);
+    }
+    gRoadDecalDrawService = drawService;
+}
+
+void SetRoadDecalTerrainService(cIGZTerrainService* terrainService)
+{
+    if (!terrainService) {
+        gRoadDecalWorkerPool.Stop(); // Workers only ever conform against the service's heightfield.
     }
-    SetRoadDecalSelectedStroke(GetSelectedRoadMarkupStrokeConst());
+    gRoadDecalTerrainService = terrainService;
+}
+
+void SetRoadDecalCameraService(cIGZS3DCameraService* cameraService)
+{
+    gRoadDecalCameraService = cameraService;
 }
 
 void DrawRoadDecals()
 {
-    if (gRoadDecalVertices.empty() &&
-        gRoadDecalActiveVertices.empty() &&
-        gRoadDecalPreviewVertices.empty() &&
-        gRoadDecalGridVertices.empty() &&
-        gRoadDecalSelectionVertices.empty()) {
+    // Terrain edits do not go through the decal tools, so pick them up here. Only strokes over changed areas are
+    // re-conformed.
+    if (gRoadDecalTerrainService) {
+        const uint32_t terrainVersion = gRoadDecalTerrainService->GetHeightfieldVersion();
+        if (terrainVersion != gRoadDecalSeenTerrainVersion) {
+            gRoadDecalSeenTerrainVersion = terrainVersion;
+            if (gRoadMarkupStore.Size() > 0) {
+                RebuildRoadDecalGeometry();
+            }
+        }
+    }
+    RefreshRoadMarkupAutosave();
+
+    if (!IsMarkupLoadPending() &&
+        gRoadDecalGeometryCache.Chunks().empty() &&
+        gRoadDecalActiveMesh.Empty() &&
+        gRoadDecalPreviewMesh.Empty() &&
+        gRoadDecalGridMesh.Empty() &&
+        gRoadDecalSelectionMesh.Empty()) {
         return;
     }
 
@@ -1310,6 +1332,10 @@ void DrawRoadDecals()
         return;
     }
 
+    if (IsMarkupLoadPending()) {
+        StreamPendingMarkupLoad(device);
+    }
+
     {
         RoadDecalStateGuard state(device);
         device->SetRenderState(D3DRENDERSTATE_ZENABLE, TRUE);
@@ -1335,11 +1361,11 @@ void DrawRoadDecals()
         device->SetTextureStageState(1, D3DTSS_COLOROP, D3DTOP_DISABLE);
         device->SetTextureStageState(1, D3DTSS_ALPHAOP, D3DTOP_DISABLE);
 
-        DrawVertexBuffer(device, gRoadDecalVertices);
-        DrawVertexBuffer(device, gRoadDecalSelectionVertices);
-        DrawVertexBuffer(device, gRoadDecalActiveVertices);
-        DrawVertexBuffer(device, gRoadDecalPreviewVertices);
-        DrawVertexBuffer(device, gRoadDecalGridVertices);
+        DrawRoadDecalChunks(device);
+        DrawRoadDecalGeometry(device, kDecalSlotSelection, gRoadDecalSelectionMesh);
+        DrawRoadDecalGeometry(device, kDecalSlotActive, gRoadDecalActiveMesh);
+        DrawRoadDecalGeometry(device, kDecalSlotPreview, gRoadDecalPreviewMesh);
+        DrawRoadDecalGeometry(device, kDecalSlotGrid, gRoadDecalGridMesh);
     }
 
     device->Release();
@@ -1347,23 +1373,28 @@ void DrawRoadDecals()
 
 void SetRoadDecalActiveStroke(const RoadMarkupStroke* stroke)
 {
-    gRoadDecalActiveVertices.clear();
+    gRoadDecalActiveMesh.Clear();
+    MarkRoadDecalGeometryDirty(kDecalSlotActive);
     if (stroke) {
-        BuildStrokeVertices(*stroke, gRoadDecalActiveVertices);
+        RoadDecalTerrainPass terrainPass;
+        BuildRoadDecalStrokeMesh(*stroke, kTerrainConformer, gRoadDecalActiveMesh);
     }
 }
 
 void SetRoadDecalPreviewSegment(bool enabled, const RoadMarkupStroke& stroke)
 {
-    gRoadDecalPreviewVertices.clear();
+    gRoadDecalPreviewMesh.Clear();
+    MarkRoadDecalGeometryDirty(kDecalSlotPreview);
     if (enabled) {
-        BuildStrokeVertices(stroke, gRoadDecalPreviewVertices);
+        RoadDecalTerrainPass terrainPass;
+        BuildRoadDecalStrokeMesh(stroke, kTerrainConformer, gRoadDecalPreviewMesh);
     }
 }
 
 void SetRoadDecalSelectedStroke(const RoadMarkupStroke* stroke)
 {
-    gRoadDecalSelectionVertices.clear();
+    gRoadDecalSelectionMesh.Clear();
+    MarkRoadDecalGeometryDirty(kDecalSlotSelection);
     if (!stroke) {
         return;
     }
@@ -1374,12 +1405,14 @@ void SetRoadDecalSelectedStroke(const RoadMarkupStroke* stroke)
     if (GetMarkupCategory(highlight.type) == RoadMarkupCategory::LaneDivider) {
         highlight.width += 0.20f;
     }
-    BuildStrokeVertices(highlight, gRoadDecalSelectionVertices);
+    RoadDecalTerrainPass terrainPass;
+    BuildRoadDecalStrokeMesh(highlight, kTerrainConformer, gRoadDecalSelectionMesh);
 }
 
 void SetRoadDecalGridPreview(bool enabled, const RoadDecalPoint& centerPoint)
 {
-    gRoadDecalGridVertices.clear();
+    gRoadDecalGridMesh.Clear();
+    MarkRoadDecalGeometryDirty(kDecalSlotGrid);
     if (!enabled) {
         return;
     }
@@ -1392,11 +1425,6 @@ void SetRoadDecalGridPreview(bool enabled, const RoadDecalPoint& centerPoint)
     const float minZ = tileZ - kTileSize;
     const float maxZ = tileZ + (2.0f * kTileSize);
 
-    auto* terrain = GetActiveTerrain();
-    if (!terrain) {
-        return;
-    }
-
     const int xCount = static_cast<int>(std::round((maxX - minX) / kMinorGridSize)) + 1;
     const int zCount = static_cast<int>(std::round((maxZ - minZ) / kMinorGridSize)) + 1;
     if (xCount < 2 || zCount < 2) {
@@ -1414,22 +1442,27 @@ void SetRoadDecalGridPreview(bool enabled, const RoadDecalPoint& centerPoint)
             const float x = minX + static_cast<float>(xi) * kMinorGridSize;
             auto& p = at(xi, zi);
             p.x = x;
+            p.y = 0.0f;
             p.z = z;
-            p.y = SampleTerrainHeight(terrain, x, z) + kDecalTerrainOffset;
             p.hardCorner = false;
         }
     }
+    if (!ConformPointsToTerrain(gridPoints)) {
+        return;
+    }
 
-    gRoadDecalGridVertices.reserve(static_cast<size_t>((xCount - 1) * zCount + (zCount - 1) * xCount) * 6);
+    const auto quadCount = static_cast<size_t>((xCount - 1) * zCount + (zCount - 1) * xCount);
+    gRoadDecalGridMesh.vertices.reserve(quadCount * 4);
+    gRoadDecalGridMesh.indices.reserve(quadCount * 6);
 
     for (int zi = 0; zi < zCount; ++zi) {
         for (int xi = 0; xi + 1 < xCount; ++xi) {
-            EmitThickSegmentNoConform(at(xi, zi), at(xi + 1, zi), kGridLineWidth, kGridColor, gRoadDecalGridVertices);
+            EmitRoadDecalSegment(at(xi, zi), at(xi + 1, zi), kGridLineWidth, kGridColor, gRoadDecalGridMesh);
         }
     }
     for (int xi = 0; xi < xCount; ++xi) {
         for (int zi = 0; zi + 1 < zCount; ++zi) {
-            EmitThickSegmentNoConform(at(xi, zi), at(xi, zi + 1), kGridLineWidth, kGridColor, gRoadDecalGridVertices);
+            EmitRoadDecalSegment(at(xi, zi), at(xi, zi + 1), kGridLineWidth, kGridColor, gRoadDecalGridMesh);
         }
     }
 }
@@ -1439,15 +1472,18 @@ bool SaveMarkupsToFile(const char* filepath)
     if (!filepath || !filepath[0]) {
         return false;
     }
-    EnsureDefaultRoadMarkupLayer();
+    FinishPendingMarkupLoad();
+    std::vector<uint8_t> bytes;
+    if (!EncodeRoadMarkups(bytes)) {
+        return false;
+    }
+
     std::ofstream out(filepath, std::ios::binary | std::ios::trunc);
     if (!out.is_open()) {
         return false;
     }
-
-    FileOStream stream(out);
-    RoadMarkupSerializable serializable;
-    return stream.SetGZSerializable(serializable) && stream.GetError() == 0;
+    out.write(reinterpret_cast<const char*>(bytes.data()), static_cast<std::streamsize>(bytes.size()));
+    return out.good();
 }
 
 bool LoadMarkupsFromFile(const char* filepath)
@@ -1455,16 +1491,35 @@ bool LoadMarkupsFromFile(const char* filepath)
     if (!filepath || !filepath[0]) {
         return false;
     }
-    std::ifstream in(filepath, std::ios::binary);
-    if (!in.is_open()) {
-        return false;
-    }
+    FinishPendingMarkupLoad();
 
-    FileIStream stream(in);
-    RoadMarkupSerializable serializable;
-    if (!stream.GetGZSerializable(serializable) || stream.GetError() != 0) {
+    auto& load = gRoadMarkupPendingLoad;
+    if (!load.file.Open(filepath)) {
         return false;
     }
+    if (PeekRoadMarkupFileVersion(load.file.Data(), load.file.Size()) == kRoadMarkupFileVersion) {
+        if (!BeginPendingMarkupLoad()) {
+            return false;
+        }
+        // Without a camera there is no view to fill in first.
+        if (!gRoadDecalCameraService) {
+            DecodeRemainingMarkupChunks();
+        }
+    }
+    else {
+        load.file.Close();
+        std::ifstream in(filepath, std::ios::binary);
+        if (!in.is_open()) {
+            return false;
+        }
+        FileIStream stream(in);
+        RoadMarkupSerializable serializable;
+        if (!stream.GetGZSerializable(serializable) || stream.GetError() != 0) {
+            return false;
+        }
+    }
+    gRoadMarkupJournal.ClearHistory();
+    gRoadMarkupJournal.RequestSnapshot();
 
     EnsureDefaultRoadMarkupLayer();
     gActiveLayerIndex = std::clamp(gActiveLayerIndex, 0, static_cast<int>(gRoadMarkupLayers.size()) - 1);
@@ -1475,70 +1530,31 @@ bool LoadMarkupsFromFile(const char* filepath)
     return true;
 }
 
-namespace
+bool StartRoadMarkupAutosave(const char* filepath)
 {
-    bool RoadMarkupSerializable::Write(cIGZOStream& stream)
-    {
-        if (stream.GetError() != 0) {
-            return false;
-        }
-
-        if (!stream.SetUint32(kMarkupFileMagic) ||
-            !stream.SetUint32(kMarkupFileVersion)) {
-            return false;
-        }
-
-        const uint32_t layerCount = static_cast<uint32_t>(gRoadMarkupLayers.size());
-        if (!stream.SetUint32(layerCount) ||
-            !stream.SetSint32(gActiveLayerIndex) ||
-            !stream.SetSint32(gSelectedLayerIndex) ||
-            !stream.SetSint32(gSelectedStrokeIndex)) {
-            return false;
-        }
-
-        for (const auto& layer : gRoadMarkupLayers) {
-            const uint32_t nameLen = static_cast<uint32_t>(layer.name.size());
-            if (!stream.SetUint32(layer.id) ||
-                !stream.SetUint32(nameLen) ||
-                !stream.SetUint8(layer.visible ? 1 : 0) ||
-                !stream.SetUint8(layer.locked ? 1 : 0) ||
-                !stream.SetSint32(layer.renderOrder) ||
-                !stream.SetUint32(static_cast<uint32_t>(layer.strokes.size()))) {
-                return false;
-            }
-
-            if (nameLen > 0 && !stream.SetVoid(layer.name.data(), nameLen)) {
-                return false;
-            }
-
-            for (const auto& stroke : layer.strokes) {
-                if (!stream.SetUint32(static_cast<uint32_t>(stroke.type)) ||
-                    !stream.SetUint32(static_cast<uint32_t>(stroke.points.size())) ||
-                    !stream.SetFloat32(stroke.width) ||
-                    !stream.SetFloat32(stroke.length) ||
-                    !stream.SetFloat32(stroke.rotation) ||
-                    !stream.SetUint8(stroke.dashed ? 1 : 0) ||
-                    !stream.SetFloat32(stroke.dashLength) ||
-                    !stream.SetFloat32(stroke.gapLength) ||
-                    !stream.SetUint32(stroke.color) ||
-                    !stream.SetFloat32(stroke.opacity) ||
-                    !stream.SetUint8(stroke.visible ? 1 : 0) ||
-                    !stream.SetUint32(stroke.layerId)) {
-                    return false;
-                }
+    StopRoadMarkupAutosave();
+    if (!filepath || !filepath[0]) {
+        return false;
+    }
+    // A clean shutdown deletes the autosave; one still marked as in use was left by a session that crashed.
+    if (RoadMarkupJournal::AutosaveLeftOpen(filepath)) {
+        RecoverRoadMarkupAutosave(filepath);
+    }
+    gRoadMarkupAutosaveWarned = false;
+    return gRoadMarkupJournal.StartAutosave(filepath);
+}
 
-                for (const auto& point : stroke.points) {
-                    if (!stream.SetFloat32(point.x) ||
-                        !stream.SetFloat32(point.y) ||
-                        !stream.SetFloat32(point.z) ||
-                        !stream.SetUint8(point.hardCorner ? 1 : 0)) {
-                        return false;
-                    }
-                }
-            }
-        }
+void StopRoadMarkupAutosave()
+{
+    gRoadMarkupJournal.FinishAutosave();
+}
 
-        return stream.GetError() == 0;
+namespace
+{
+    // Version 1 is only read now. SaveMarkupsToFile writes version 2 through RoadMarkupFileWriter.
+    bool RoadMarkupSerializable::Write(cIGZOStream&)
+    {
+        return false;
     }
 
     bool RoadMarkupSerializable::Read(cIGZIStream& stream)
@@ -1559,13 +1575,15 @@ namespace
             !stream.GetSint32(activeLayerIndex) ||
             !stream.GetSint32(selectedLayerIndex) ||
             !stream.GetSint32(selectedStrokeIndex) ||
-            magic != kMarkupFileMagic ||
-            version != kMarkupFileVersion) {
+            magic != kRoadMarkupFileMagic ||
+            version != kMarkupFileVersion1) {
             return false;
         }
 
         std::vector<RoadMarkupLayer> layers;
+        std::vector<std::vector<RoadMarkupStroke>> layerStrokes;
         layers.reserve(layerCount);
+        layerStrokes.reserve(layerCount);
         for (uint32_t i = 0; i < layerCount; ++i) {
             RoadMarkupLayer layer{};
             uint32_t nameLen = 0;
@@ -1587,7 +1605,8 @@ namespace
                 return false;
             }
 
-            layer.strokes.reserve(strokeCount);
+            auto& strokes = layerStrokes.emplace_back();
+            strokes.reserve(strokeCount);
             for (uint32_t s = 0; s < strokeCount; ++s) {
                 RoadMarkupStroke stroke{};
                 uint32_t type = 0;
@@ -1625,134 +1644,237 @@ namespace
                     point.hardCorner = hardCorner != 0;
                     stroke.points.push_back(point);
                 }
-                layer.strokes.push_back(std::move(stroke));
+                strokes.push_back(std::move(stroke));
             }
             layers.push_back(std::move(layer));
         }
 
+        gRoadMarkupStore.Clear();
+        gSelectedStrokeId = 0;
+        for (size_t i = 0; i < layers.size(); ++i) {
+            auto& ids = layers[i].strokeIds;
+            ids.reserve(layerStrokes[i].size());
+            for (auto& stroke : layerStrokes[i]) {
+                stroke.layerId = layers[i].id;
+                ids.push_back(gRoadMarkupStore.Add(stroke));
+            }
+            if (static_cast<int32_t>(i) == selectedLayerIndex && selectedStrokeIndex >= 0 &&
+                selectedStrokeIndex < static_cast<int32_t>(ids.size())) {
+                gSelectedStrokeId = ids[static_cast<size_t>(selectedStrokeIndex)];
+            }
+        }
         gRoadMarkupLayers = std::move(layers);
         gActiveLayerIndex = activeLayerIndex;
-        gSelectedLayerIndex = selectedLayerIndex;
-        gSelectedStrokeIndex = selectedStrokeIndex;
+        ResetRoadMarkupIndex();
         return stream.GetError() == 0;
     }
 
-    void BuildStrokeVertices(const RoadMarkupStroke& stroke, std::vector<RoadDecalVertex>& outVerts)
+    void DrawIndexedVertexBuffer(IDirect3DDevice7* device,
+                                 const RoadDecalVertex* verts,
+                                 const size_t vertexCount,
+                                 const uint16_t* indices,
+                                 const size_t indexCount)
+    {
+        if (indexCount == 0) {
+            return;
+        }
+
+        const HRESULT hr = device->DrawIndexedPrimitive(D3DPT_TRIANGLELIST,
+                                                        D3DFVF_XYZ | D3DFVF_DIFFUSE,
+                                                        const_cast<RoadDecalVertex*>(verts),
+                                                        static_cast<DWORD>(vertexCount),
+                                                        const_cast<WORD*>(indices),
+                                                        static_cast<DWORD>(indexCount),
+                                                        D3DDP_WAIT);
+        if (FAILED(hr)) {
+            LOG_WARN("RoadMarkup: DrawIndexedPrimitive failed hr=0x{:08X}", static_cast<uint32_t>(hr));
+        }
+    }
+
+    void MarkRoadDecalGeometryDirty(const RoadDecalGeometrySlot slot)
+    {
+        gRoadDecalGpuBuffers[slot].dirty = true;
+    }
+
+    void DrawRoadDecalGeometry(IDirect3DDevice7* device, const RoadDecalGeometrySlot slot, const RoadDecalMesh& mesh)
     {
-        if (!stroke.visible || stroke.points.empty()) {
+        if (mesh.Empty()) {
             return;
         }
 
-        const auto& props = FindProps(stroke.type);
-        const DWORD color = ApplyOpacity(stroke.color != 0 ? stroke.color : props.defaultColor, stroke.opacity);
-        const float dashLength = std::max(0.05f, stroke.dashLength);
-        const float gapLength = std::max(0.0f, stroke.gapLength);
+        auto& gpu = gRoadDecalGpuBuffers[slot];
+        const auto vertexCount = static_cast<uint32_t>(mesh.vertices.size());
+        const auto indexCount = static_cast<uint32_t>(mesh.indices.size());
+        if (gRoadDecalDrawService) {
+            if (gpu.handle.id == 0) {
+                const bool isStatic = slot == kDecalSlotSelection;
+                const DrawBufferDesc desc{
+                    isStatic ? DrawBufferUsage::Static : DrawBufferUsage::Dynamic,
+                    kRoadDecalFVF,
+                    sizeof(RoadDecalVertex),
+                    isStatic ? std::clamp<uint32_t>(vertexCount, 1, D3DMAXNUMVERTICES) : kDynamicDecalRingVertices
+                };
+                gpu.handle = gRoadDecalDrawService->CreateDrawBuffer(desc);
+                gpu.dirty = true;
+            }
 
-        switch (props.category) {
-        case RoadMarkupCategory::LaneDivider:
-            if (stroke.points.size() < 2) {
+            // Upload only when the geometry changed; unchanged decals stay on the device between frames.
+            if (gpu.handle.id != 0 && gpu.dirty) {
+                gpu.dirty = !gRoadDecalDrawService->WriteDrawBuffer(gpu.handle, mesh.vertices.data(), vertexCount,
+                                                                    &gpu.startVertex) ||
+                            !gRoadDecalDrawService->SetDrawBufferIndices(gpu.handle, mesh.indices.data(), indexCount);
+            }
+            if (gpu.handle.id != 0 && !gpu.dirty &&
+                gRoadDecalDrawService->DrawBufferIndexedPrimitives(gpu.handle, D3DPT_TRIANGLELIST, gpu.startVertex,
+                                                                   vertexCount, 0, indexCount)) {
                 return;
             }
-            if (stroke.type == RoadMarkupType::DoubleSolidYellow) {
-                std::vector<RoadDecalPoint> p1 = stroke.points;
-                std::vector<RoadDecalPoint> p2 = stroke.points;
-                const float offset = (stroke.width + kDoubleYellowSpacing) * 0.5f;
-                for (size_t i = 0; i < stroke.points.size(); ++i) {
-                    const auto& prev = stroke.points[(i == 0) ? i : i - 1];
-                    const auto& next = stroke.points[(i + 1 < stroke.points.size()) ? i + 1 : i];
-                    float tx = 0.0f;
-                    float tz = 0.0f;
-                    float len = 0.0f;
-                    if (!GetDirectionXZ(prev, next, tx, tz, len)) {
-                        continue;
-                    }
-                    const float nx = -tz;
-                    const float nz = tx;
-                    p1[i].x += nx * offset;
-                    p1[i].z += nz * offset;
-                    p2[i].x -= nx * offset;
-                    p2[i].z -= nz * offset;
+            // Lost device or oversized geometry: re-upload next frame and draw from system memory for now.
+            gpu.dirty = true;
+        }
+        DrawIndexedVertexBuffer(device, mesh.vertices.data(), vertexCount, mesh.indices.data(), indexCount);
+    }
+
+    // Uploads the chunk if its version moved, then draws it. Returns how many leading runs reached the device, so the
+    // caller can draw the rest from system memory without drawing anything twice.
+    size_t DrawRoadDecalChunkBuffers(const RoadDecalChunk& chunk)
+    {
+        const size_t runCount = chunk.runs.size();
+        auto& gpu = gRoadDecalChunkBuffers[chunk.key];
+        if (gpu.version != chunk.version) {
+            while (gpu.handles.size() > runCount) {
+                gRoadDecalDrawService->ReleaseDrawBuffer(gpu.handles.back());
+                gpu.handles.pop_back();
+            }
+            gpu.version = chunk.version;
+            for (size_t i = 0; i < runCount; ++i) {
+                const RoadDecalChunkRun& run = chunk.runs[i];
+                if (i == gpu.handles.size()) {
+                    gpu.handles.push_back(gRoadDecalDrawService->CreateDrawBuffer(
+                        {DrawBufferUsage::Static, kRoadDecalFVF, sizeof(RoadDecalVertex), run.vertexCount}));
                 }
-                BuildLine(p1, stroke.width, color, false, dashLength, gapLength, outVerts);
-                BuildLine(p2, stroke.width, color, false, dashLength, gapLength, outVerts);
-            } else {
-                const bool dashed = stroke.dashed ||
-                                    stroke.type == RoadMarkupType::DashedWhiteLine ||
-                                    stroke.type == RoadMarkupType::DashedYellowLine;
-                BuildLine(stroke.points, stroke.width, color, dashed, dashLength, gapLength, outVerts);
+                uint32_t startVertex = 0;
+                if (gpu.handles[i].id == 0 ||
+                    !gRoadDecalDrawService->WriteDrawBuffer(gpu.handles[i], chunk.vertices.data() + run.firstVertex,
+                                                            run.vertexCount, &startVertex) ||
+                    !gRoadDecalDrawService->SetDrawBufferIndices(gpu.handles[i], chunk.indices.data() + run.firstIndex,
+                                                                 run.indexCount)) {
+                    gpu.version = 0;
+                    break;
+                }
+            }
+            if (gpu.version == 0) {
+                return 0;
             }
-            break;
-
-        case RoadMarkupCategory::DirectionalArrow:
-            switch (stroke.type) {
-            case RoadMarkupType::ArrowStraight:
-                BuildStraightArrow(stroke, color, outVerts);
-                break;
-            case RoadMarkupType::ArrowLeft:
-                BuildTurnArrow(stroke, true, false, color, outVerts);
-                break;
-            case RoadMarkupType::ArrowRight:
-                BuildTurnArrow(stroke, false, false, color, outVerts);
-                break;
-            case RoadMarkupType::ArrowLeftRight:
-                BuildTurnArrow(stroke, true, false, color, outVerts);
-                BuildTurnArrow(stroke, false, false, color, outVerts);
-                break;
-            case RoadMarkupType::ArrowStraightLeft:
-                BuildTurnArrow(stroke, true, true, color, outVerts);
-                break;
-            case RoadMarkupType::ArrowStraightRight:
-                BuildTurnArrow(stroke, false, true, color, outVerts);
-                break;
-            case RoadMarkupType::ArrowUTurn:
-                BuildUTurnArrow(stroke, color, outVerts);
-                break;
-            default:
-                break;
+        }
+
+        for (size_t i = 0; i < runCount; ++i) {
+            const RoadDecalChunkRun& run = chunk.runs[i];
+            if (!gRoadDecalDrawService->DrawBufferIndexedPrimitives(gpu.handles[i], D3DPT_TRIANGLELIST, 0,
+                                                                    run.vertexCount, 0, run.indexCount)) {
+                gpu.version = 0;
+                return i;
             }
-            break;
+        }
+        return runCount;
+    }
 
-        case RoadMarkupCategory::Crossing:
-            if (stroke.points.size() < 2) {
-                return;
+    bool GetRoadDecalViewFrustum(IDirect3DDevice7* device, ViewFrustum& frustum)
+    {
+        D3DVIEWPORT7 viewport{};
+        if (!gRoadDecalCameraService || FAILED(device->GetViewport(&viewport)) || viewport.dwWidth == 0 ||
+            viewport.dwHeight == 0) {
+            return false;
+        }
+        const S3DCameraHandle camera = gRoadDecalCameraService->WrapActiveRendererCamera();
+        return camera.ptr &&
+               gRoadDecalCameraService->GetViewFrustum(camera, static_cast<float>(viewport.dwWidth),
+                                                       static_cast<float>(viewport.dwHeight), frustum);
+    }
+
+    void StreamPendingMarkupLoad(IDirect3DDevice7* device)
+    {
+        auto& load = gRoadMarkupPendingLoad;
+        ViewFrustum frustum{};
+        if (!load.visibleDecoded && GetRoadDecalViewFrustum(device, frustum)) {
+            // Everything in view now, however long it takes, so the first frame shows the whole view.
+            const auto& chunks = load.reader.Chunks();
+            const auto inView = [&](const uint32_t chunk) { return TestViewFrustumBox(frustum, chunks[chunk].bounds); };
+            std::stable_partition(load.chunks.begin(), load.chunks.end(), [&](const uint32_t c) { return !inView(c); });
+            while (!load.chunks.empty() && inView(load.chunks.back())) {
+                DecodeNextMarkupChunk();
             }
-            switch (stroke.type) {
-            case RoadMarkupType::ZebraCrosswalk:
-                BuildCrosswalk(stroke, 0.5f, 0.5f, false, color, outVerts);
-                break;
-            case RoadMarkupType::LadderCrosswalk:
-                BuildCrosswalk(stroke, 0.5f, 0.5f, true, color, outVerts);
-                break;
-            case RoadMarkupType::ContinentalCrosswalk:
-                BuildCrosswalk(stroke, 0.8f, 0.8f, false, color, outVerts);
-                break;
-            case RoadMarkupType::StopBar:
-                BuildLine(stroke.points, std::max(0.1f, stroke.width), color, false, 0.0f, 0.0f, outVerts);
-                break;
-            default:
-                break;
+        }
+        else {
+            const auto deadline = std::chrono::steady_clock::now() + kMarkupLoadFrameBudget;
+            while (!load.chunks.empty()) {
+                DecodeNextMarkupChunk();
+                if (std::chrono::steady_clock::now() >= deadline) {
+                    break;
+                }
             }
-            break;
-
-        case RoadMarkupCategory::ZoneMarking:
-        case RoadMarkupCategory::TextLabel:
-            break;
         }
+        load.visibleDecoded = true;
+        if (load.chunks.empty()) {
+            EndPendingMarkupLoad();
+        }
+        RebuildRoadDecalGeometry();
     }
 
-    void DrawVertexBuffer(IDirect3DDevice7* device, const std::vector<RoadDecalVertex>& verts)
+    void DrawRoadDecalChunks(IDirect3DDevice7* device)
     {
-        if (verts.empty()) {
+        const auto& chunks = gRoadDecalGeometryCache.Chunks();
+        const auto chunkCount = static_cast<uint32_t>(chunks.size());
+        if (chunkCount == 0) {
             return;
         }
 
-        const HRESULT hr = device->DrawPrimitive(D3DPT_TRIANGLELIST,
-                                                 D3DFVF_XYZ | D3DFVF_DIFFUSE,
-                                                 const_cast<RoadDecalVertex*>(verts.data()),
-                                                 static_cast<DWORD>(verts.size()),
-                                                 D3DDP_WAIT);
-        if (FAILED(hr)) {
-            LOG_WARN("RoadMarkup: DrawPrimitive failed hr=0x{:08X}", static_cast<uint32_t>(hr));
+        // Without a camera, or if the frustum cannot be built, every chunk is drawn.
+        gRoadDecalChunkVisibleBits.assign(ViewFrustumBitWords(chunkCount), ~0u);
+        ViewFrustum frustum{};
+        if (GetRoadDecalViewFrustum(device, frustum)) {
+            CullBoxes(frustum, gRoadDecalGeometryCache.ChunkBounds().data(), chunkCount,
+                      gRoadDecalChunkVisibleBits.data());
+        }
+
+        for (uint32_t i = 0; i < chunkCount; ++i) {
+            const RoadDecalChunk& chunk = chunks[i];
+            if (chunk.runs.empty() || !IsViewFrustumBitSet(gRoadDecalChunkVisibleBits.data(), i)) {
+                continue;
+            }
+            // Lost device or failed upload: retry next frame and draw the rest from system memory for now.
+            const size_t drawn = gRoadDecalDrawService ? DrawRoadDecalChunkBuffers(chunk) : 0;
+            for (size_t r = drawn; r < chunk.runs.size(); ++r) {
+                const RoadDecalChunkRun& run = chunk.runs[r];
+                DrawIndexedVertexBuffer(device, chunk.vertices.data() + run.firstVertex, run.vertexCount,
+                                        chunk.indices.data() + run.firstIndex, run.indexCount);
+            }
+        }
+    }
+
+    // Releases the buffers of chunks that no longer exist, or all of them.
+    void ReleaseRoadDecalChunkBuffers(const bool keepLiveChunks)
+    {
+        const uint32_t sweep = ++gRoadDecalChunkSweep;
+        if (keepLiveChunks) {
+            for (const RoadDecalChunk& chunk : gRoadDecalGeometryCache.Chunks()) {
+                const auto it = gRoadDecalChunkBuffers.find(chunk.key);
+                if (it != gRoadDecalChunkBuffers.end()) {
+                    it->second.lastSweep = sweep;
+                }
+            }
+        }
+        for (auto it = gRoadDecalChunkBuffers.begin(); it != gRoadDecalChunkBuffers.end();) {
+            if (keepLiveChunks && it->second.lastSweep == sweep) {
+                ++it;
+                continue;
+            }
+            if (gRoadDecalDrawService) {
+                for (const DrawBufferHandle handle : it->second.handles) {
+                    gRoadDecalDrawService->ReleaseDrawBuffer(handle);
+                }
+            }
+            it = gRoadDecalChunkBuffers.erase(it);
         }
     }
 
@@ -90,13 +90,27 @@ struct RoadMarkupStroke
     float opacity = 1.0f;
     bool visible = true;
     uint32_t layerId = 0;
+    uint32_t id = 0;        // Road markup store id once committed; not saved.
+};
+
+// The properties of a committed stroke that can be changed in place; its type, shape and layer are not among them.
+struct RoadMarkupStrokeStyle
+{
+    float width = 0.15f;
+    float length = 3.0f;
+    bool dashed = false;
+    float dashLength = 3.0f;
+    float gapLength = 9.0f;
+    uint32_t color = 0;
+    float opacity = 1.0f;
+    bool visible = true;
 };
 
 struct RoadMarkupLayer
 {
     uint32_t id = 0;
     std::string name;
-    std::vector<RoadMarkupStroke> strokes;
+    std::vector<uint32_t> strokeIds;    // In draw order.
     bool visible = true;
     bool locked = false;
     int renderOrder = 0;
@@ -104,8 +118,7 @@ struct RoadMarkupLayer
 
 extern std::vector<RoadMarkupLayer> gRoadMarkupLayers;
 extern int gActiveLayerIndex;
-extern int gSelectedLayerIndex;
-extern int gSelectedStrokeIndex;
+extern uint32_t gSelectedStrokeId;      // 0 when nothing is selected.
 
 const RoadMarkupProperties& GetRoadMarkupProperties(RoadMarkupType type);
 RoadMarkupCategory GetMarkupCategory(RoadMarkupType type);
@@ -113,25 +126,48 @@ const std::vector<RoadMarkupType>& GetRoadMarkupTypesForCategory(RoadMarkupCateg
 
 void EnsureDefaultRoadMarkupLayer();
 RoadMarkupLayer* GetActiveRoadMarkupLayer();
+// Every function below that changes the markings rebuilds the decal geometry itself, as do undo, redo and loading.
 bool AddRoadMarkupLayer(const std::string& name);
 void DeleteActiveRoadMarkupLayer();
+// Moves the active layer by offset places in the draw order, and keeps it active.
+bool MoveActiveRoadMarkupLayer(int offset);
 bool AddRoadMarkupStrokeToActiveLayer(const RoadMarkupStroke& stroke);
-void UndoLastRoadMarkupStroke();
 void ClearAllRoadMarkupStrokes();
+
+// Layer and stroke edits are recorded and can be undone and redone, as far back as a bounded history reaches. Loading a
+// file clears the history.
+bool UndoRoadMarkupEdit();
+bool RedoRoadMarkupEdit();
+bool CanUndoRoadMarkupEdit();
+bool CanRedoRoadMarkupEdit();
 size_t GetTotalRoadMarkupStrokeCount();
 
 bool SelectRoadMarkupStrokeAtPoint(const RoadDecalPoint& worldPoint, float maxDistanceMeters);
 void ClearRoadMarkupSelection();
 bool HasRoadMarkupSelection();
-RoadMarkupStroke* GetSelectedRoadMarkupStroke();
-const RoadMarkupStroke* GetSelectedRoadMarkupStrokeConst();
+bool GetSelectedRoadMarkupStroke(RoadMarkupStroke& out);
 bool DeleteSelectedRoadMarkupStroke();
 bool MoveSelectedRoadMarkupStroke(float deltaX, float deltaZ);
 bool RotateSelectedRoadMarkupStroke(float deltaRadians);
+bool SetSelectedRoadMarkupStrokeStyle(const RoadMarkupStrokeStyle& style);
+
+class cIGZDrawService;
+class cIGZS3DCameraService;
+class cIGZTerrainService;
 
 void RebuildRoadDecalGeometry();
 void DrawRoadDecals();
 
+// Draws decals from draw service vertex buffers when set; pass nullptr to release them before the service goes away.
+void SetRoadDecalDrawService(cIGZDrawService* drawService);
+
+// Conforms decals to the terrain service's shared heightfield when set; otherwise the terrain is queried directly.
+// Large rebuilds tessellate on worker threads while it is set; pass nullptr to stop them before unloading.
+void SetRoadDecalTerrainService(cIGZTerrainService* terrainService);
+
+// Culls committed decal chunks against the active camera's frustum when set; otherwise every chunk is drawn.
+void SetRoadDecalCameraService(cIGZS3DCameraService* cameraService);
+
 // Shows the currently edited stroke (already-placed click points).
 void SetRoadDecalActiveStroke(const RoadMarkupStroke* stroke);
 
@@ -145,5 +181,11 @@ void SetRoadDecalSelectedStroke(const RoadMarkupStroke* stroke);
 bool SaveMarkupsToFile(const char* filepath);
 bool LoadMarkupsFromFile(const char* filepath);
 
+// Keeps an autosave at filepath: a snapshot of the markings plus a journal of the edits since, which a background thread
+// appends to as edits are made. Markings are recovered from it first only if the session that wrote it crashed.
+bool StartRoadMarkupAutosave(const char* filepath);
+// For a clean shutdown: deletes the autosave, so the next start begins without it.
+void StopRoadMarkupAutosave();
+
 // Shows a subtle minor-grid preview centered on the hovered tile (+ adjacent tiles).
 void SetRoadDecalGridPreview(bool enabled, const RoadDecalPoint& centerPoint);
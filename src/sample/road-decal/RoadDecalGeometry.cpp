@@ -0,0 +1,803 @@
+#include "RoadDecalGeometry.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <initializer_list>
+
+#if defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2) || defined(__SSE2__)
+#define ROAD_DECAL_GEOMETRY_SSE2 1
+#include <emmintrin.h>
+#else
+#define ROAD_DECAL_GEOMETRY_SSE2 0
+#endif
+
+namespace
+{
+    constexpr float kMinLen = 1.0e-4f;
+    constexpr float kDoubleYellowSpacing = 0.10f;
+    // Corners sharper than 120 degrees are split instead of mitered, so the miter never reaches past twice the width.
+    constexpr float kMinMiterCos = 0.5f;
+    // Smoothed lines stay within 2 cm of the true curve, and no piece is longer than half a terrain cell so draped
+    // lines still follow the ground between samples.
+    constexpr float kSmoothingTolerance = 0.02f;
+    constexpr float kMaxSmoothingStep = 8.0f;
+    constexpr int kMaxSmoothingSteps = 48;
+
+    constexpr std::array<RoadMarkupProperties, 25> kMarkupProps = {{
+        {RoadMarkupType::SolidWhiteLine, RoadMarkupCategory::LaneDivider, "Solid White", "Continuous white lane divider.", 0.75f, 0.0f, 0xE0FFFFAA, false, false},
+        {RoadMarkupType::DashedWhiteLine, RoadMarkupCategory::LaneDivider, "Dashed White", "Dashed white lane divider.", 0.75f, 0.0f, 0xE0FFFFAA, true, false},
+        {RoadMarkupType::SolidYellowLine, RoadMarkupCategory::LaneDivider, "Solid Yellow", "Continuous yellow centerline.", 0.75f, 0.0f, 0xE0FFD700, false, false},
+        {RoadMarkupType::DashedYellowLine, RoadMarkupCategory::LaneDivider, "Dashed Yellow", "Dashed yellow centerline.", 0.75f, 0.0f, 0xE0FFD700, true, false},
+        {RoadMarkupType::DoubleSolidYellow, RoadMarkupCategory::LaneDivider, "Double Yellow", "Double solid yellow centerline.", 0.75f, 0.0f, 0xE0FFD700, false, true},
+        {RoadMarkupType::SolidWhiteEdgeLine, RoadMarkupCategory::LaneDivider, "Edge Line", "Solid white edge line.", 0.325f, 0.0f, 0xE0FFFFAA, false, true},
+
+        {RoadMarkupType::ArrowStraight, RoadMarkupCategory::DirectionalArrow, "Straight Arrow", "Straight lane arrow.", 1.20f, 3.00f, 0xE0FFFFAA, false, true},
+        {RoadMarkupType::ArrowLeft, RoadMarkupCategory::DirectionalArrow, "Left Arrow", "Left turn arrow.", 1.20f, 3.00f, 0xE0FFFFAA, false, true},
+        {RoadMarkupType::ArrowRight, RoadMarkupCategory::DirectionalArrow, "Right Arrow", "Right turn arrow.", 1.20f, 3.00f, 0xE0FFFAA, false, true},
+        {RoadMarkupType::ArrowLeftRight, RoadMarkupCategory::DirectionalArrow, "Left/Right Arrow", "Left-right arrow.", 1.20f, 3.00f, 0xE0FFFFAA, false, true},
+        {RoadMarkupType::ArrowStraightLeft, RoadMarkupCategory::DirectionalArrow, "Straight+Left", "Straight-left arrow.", 1.20f, 3.00f, 0xE0FFFFAA, false, true},
+        {RoadMarkupType::ArrowStraightRight, RoadMarkupCategory::DirectionalArrow, "Straight+Right", "Straight-right arrow.", 1.20f, 3.00f, 0xE0FFFFAA, false, true},
+        {RoadMarkupType::ArrowUTurn, RoadMarkupCategory::DirectionalArrow, "U-Turn Arrow", "U-turn arrow.", 1.20f, 3.00f, 0xE0FFFFAA, false, true},
+
+        {RoadMarkupType::ZebraCrosswalk, RoadMarkupCategory::Crossing, "Zebra Crosswalk", "Parallel zebra stripes.", 0.50f, 3.00f, 0xE0FFFFAA, false, true},
+        {RoadMarkupType::LadderCrosswalk, RoadMarkupCategory::Crossing, "Ladder Crosswalk", "Zebra with side rails.", 0.50f, 3.00f, 0xE0FFFFAA, false, true},
+        {RoadMarkupType::ContinentalCrosswalk, RoadMarkupCategory::Crossing, "Continental", "Thicker stripe crossing.", 0.80f, 3.00f, 0xE0FFFFAA, false, true},
+        {RoadMarkupType::StopBar, RoadMarkupCategory::Crossing, "Stop Bar", "Stop line bar.", 0.40f, 0.00f, 0xE0FFFFFF, false, true},
+
+        {RoadMarkupType::YieldTriangle, RoadMarkupCategory::ZoneMarking, "Yield Triangle", "Yield marker.", 0.15f, 1.00f, 0xE0FFFFAA, false, true},
+        {RoadMarkupType::ParkingSpace, RoadMarkupCategory::ZoneMarking, "Parking Space", "Parking outline marker.", 0.15f, 5.00f, 0xE0FFFFAA, false, true},
+        {RoadMarkupType::BikeSymbol, RoadMarkupCategory::ZoneMarking, "Bike Symbol", "Bike lane symbol.", 0.20f, 2.50f, 0xE0FFFFAA, false, true},
+        {RoadMarkupType::BusLane, RoadMarkupCategory::ZoneMarking, "Bus Lane", "Bus lane marker.", 0.20f, 6.00f, 0xE0FFFFAA, false, true},
+
+        {RoadMarkupType::TextStop, RoadMarkupCategory::TextLabel, "STOP", "Text marker phase 2.", 0.20f, 3.00f, 0xE0FFFFFF, false, true},
+        {RoadMarkupType::TextSlow, RoadMarkupCategory::TextLabel, "SLOW", "Text marker phase 2.", 0.20f, 3.00f, 0xE0FFFFFF, false, true},
+        {RoadMarkupType::TextSchool, RoadMarkupCategory::TextLabel, "SCHOOL", "Text marker phase 2.", 0.20f, 4.00f, 0xE0FFFFFF, false, true},
+        {RoadMarkupType::TextBusOnly, RoadMarkupCategory::TextLabel, "BUS ONLY", "Text marker phase 2.", 0.20f, 5.00f, 0xE0FFFFFF, false, true},
+    }};
+
+    const RoadMarkupProperties& FindProps(RoadMarkupType type)
+    {
+        for (const auto& props : kMarkupProps) {
+            if (props.type == type) {
+                return props;
+            }
+        }
+        return kMarkupProps[0];
+    }
+
+    uint32_t ApplyOpacity(uint32_t color, float opacity)
+    {
+        opacity = std::clamp(opacity, 0.0f, 1.0f);
+        const uint32_t baseA = (color >> 24U) & 0xFFU;
+        const uint32_t outA = static_cast<uint32_t>(std::clamp(baseA * opacity, 0.0f, 255.0f));
+        return (color & 0x00FFFFFFU) | (outA << 24U);
+    }
+
+    bool GetDirectionXZ(const RoadDecalPoint& a, const RoadDecalPoint& b, float& outTx, float& outTz, float& outLen)
+    {
+        const float dx = b.x - a.x;
+        const float dz = b.z - a.z;
+        const float len = std::sqrt(dx * dx + dz * dz);
+        if (len <= kMinLen) {
+            return false;
+        }
+        outTx = dx / len;
+        outTz = dz / len;
+        outLen = len;
+        return true;
+    }
+
+    float Distance3(const RoadDecalPoint& a, const RoadDecalPoint& b)
+    {
+        const float dx = b.x - a.x;
+        const float dy = b.y - a.y;
+        const float dz = b.z - a.z;
+        return std::sqrt(dx * dx + dy * dy + dz * dz);
+    }
+
+    // Centripetal Catmull-Rom between p1 and p2 as a cubic in u over [0, 1], per axis:
+    // P(u) = ((a * u + b) * u + c) * u + d.
+    struct CatmullRomSegment
+    {
+        std::array<float, 3> a;
+        std::array<float, 3> b;
+        std::array<float, 3> c;
+        std::array<float, 3> d;
+    };
+
+    CatmullRomSegment MakeCentripetalSegment(const RoadDecalPoint& p0,
+                                             const RoadDecalPoint& p1,
+                                             const RoadDecalPoint& p2,
+                                             const RoadDecalPoint& p3)
+    {
+        // Knot spacing is distance^0.5. Computed once per segment; the tangents below fold in the whole knot
+        // pyramid, so evaluating a sample is three Horner steps per axis.
+        const float k01 = std::sqrt((std::max)(Distance3(p0, p1), 1.0e-4f));
+        const float k12 = std::sqrt((std::max)(Distance3(p1, p2), 1.0e-4f));
+        const float k23 = std::sqrt((std::max)(Distance3(p2, p3), 1.0e-4f));
+
+        const std::array<float, 3> v0{p0.x, p0.y, p0.z};
+        const std::array<float, 3> v1{p1.x, p1.y, p1.z};
+        const std::array<float, 3> v2{p2.x, p2.y, p2.z};
+        const std::array<float, 3> v3{p3.x, p3.y, p3.z};
+        CatmullRomSegment segment{};
+        for (size_t axis = 0; axis < 3; ++axis) {
+            const float m1 = ((v1[axis] - v0[axis]) / k01 - (v2[axis] - v0[axis]) / (k01 + k12) +
+                              (v2[axis] - v1[axis]) / k12) * k12;
+            const float m2 = ((v2[axis] - v1[axis]) / k12 - (v3[axis] - v1[axis]) / (k12 + k23) +
+                              (v3[axis] - v2[axis]) / k23) * k12;
+            segment.a[axis] = 2.0f * (v1[axis] - v2[axis]) + m1 + m2;
+            segment.b[axis] = 3.0f * (v2[axis] - v1[axis]) - 2.0f * m1 - m2;
+            segment.c[axis] = m1;
+            segment.d[axis] = v1[axis];
+        }
+        return segment;
+    }
+
+    // Pieces needed for the chords to stay within kSmoothingTolerance of the curve in XZ. A chord over du strays at
+    // most a * du^2 / 8 from a curve whose acceleration across its direction of travel is at most a. Acceleration
+    // along the curve only moves samples along it, so straight segments with uneven point spacing stay one piece.
+    int SmoothingSteps(const CatmullRomSegment& s, const float chordLength)
+    {
+        float bend = 0.0f;
+        for (int k = 0; k <= 3; ++k) {
+            const float u = static_cast<float>(k) / 3.0f;
+            const float vx = (3.0f * s.a[0] * u + 2.0f * s.b[0]) * u + s.c[0];
+            const float vz = (3.0f * s.a[2] * u + 2.0f * s.b[2]) * u + s.c[2];
+            const float ax = 6.0f * s.a[0] * u + 2.0f * s.b[0];
+            const float az = 6.0f * s.a[2] * u + 2.0f * s.b[2];
+            const float speed = std::sqrt(vx * vx + vz * vz);
+            const float across = speed > kMinLen ? std::fabs(vx * az - vz * ax) / speed : std::sqrt(ax * ax + az * az);
+            bend = (std::max)(bend, across);
+        }
+        const float flatSteps = std::sqrt(bend / (8.0f * kSmoothingTolerance));
+        const float lengthSteps = chordLength / kMaxSmoothingStep;
+        const float steps = std::ceil((std::max)(flatSteps, lengthSteps));
+        return static_cast<int>(std::clamp(steps, 1.0f, static_cast<float>(kMaxSmoothingSteps)));
+    }
+
+    // Appends P(step / steps) for step = 1..steps. The last sample is p2 itself.
+    void AppendSegmentSamples(const CatmullRomSegment& s,
+                              const int steps,
+                              const RoadDecalPoint& p2,
+                              std::vector<RoadDecalPoint>& outPoints)
+    {
+        const size_t first = outPoints.size();
+        outPoints.resize(first + static_cast<size_t>(steps));
+        RoadDecalPoint* out = outPoints.data() + first;
+        const float invSteps = 1.0f / static_cast<float>(steps);
+
+        int step = 1;
+#if ROAD_DECAL_GEOMETRY_SSE2
+        for (; step + 3 < steps; step += 4) {
+            const auto fs = static_cast<float>(step);
+            const __m128 u = _mm_mul_ps(_mm_setr_ps(fs, fs + 1.0f, fs + 2.0f, fs + 3.0f), _mm_set1_ps(invSteps));
+            alignas(16) float axes[3][4];
+            for (size_t axis = 0; axis < 3; ++axis) {
+                __m128 v = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(s.a[axis]), u), _mm_set1_ps(s.b[axis]));
+                v = _mm_add_ps(_mm_mul_ps(v, u), _mm_set1_ps(s.c[axis]));
+                v = _mm_add_ps(_mm_mul_ps(v, u), _mm_set1_ps(s.d[axis]));
+                _mm_store_ps(axes[axis], v);
+            }
+            for (int k = 0; k < 4; ++k) {
+                out[step - 1 + k] = {axes[0][k], axes[1][k], axes[2][k], false};
+            }
+        }
+#endif
+        for (; step < steps; ++step) {
+            const float u = static_cast<float>(step) * invSteps;
+            out[step - 1] = {((s.a[0] * u + s.b[0]) * u + s.c[0]) * u + s.d[0],
+                             ((s.a[1] * u + s.b[1]) * u + s.c[1]) * u + s.d[1],
+                             ((s.a[2] * u + s.b[2]) * u + s.c[2]) * u + s.d[2],
+                             false};
+        }
+        out[steps - 1] = {p2.x, p2.y, p2.z, false};
+    }
+
+    bool HasRoom(const RoadDecalMesh& mesh, const size_t vertexCount)
+    {
+        return mesh.vertices.size() + vertexCount <= RoadDecalMesh::kMaxVertices;
+    }
+
+    void EmitIndices(RoadDecalMesh& mesh, const std::initializer_list<size_t> indices)
+    {
+        for (const size_t index : indices) {
+            mesh.indices.push_back(static_cast<uint16_t>(index));
+        }
+    }
+
+    void EmitTriangle(const RoadDecalPoint& a, const RoadDecalPoint& b, const RoadDecalPoint& c, uint32_t color, RoadDecalMesh& outMesh)
+    {
+        if (!HasRoom(outMesh, 3)) {
+            return;
+        }
+        const size_t base = outMesh.vertices.size();
+        outMesh.vertices.push_back({a.x, a.y, a.z, color});
+        outMesh.vertices.push_back({b.x, b.y, b.z, color});
+        outMesh.vertices.push_back({c.x, c.y, c.z, color});
+        EmitIndices(outMesh, {base, base + 1, base + 2});
+    }
+
+    void EmitQuad(const RoadDecalPoint& a, const RoadDecalPoint& b, const RoadDecalPoint& c, const RoadDecalPoint& d, uint32_t color, RoadDecalMesh& outMesh)
+    {
+        if (!HasRoom(outMesh, 4)) {
+            return;
+        }
+        const size_t base = outMesh.vertices.size();
+        outMesh.vertices.push_back({a.x, a.y, a.z, color});
+        outMesh.vertices.push_back({b.x, b.y, b.z, color});
+        outMesh.vertices.push_back({c.x, c.y, c.z, color});
+        outMesh.vertices.push_back({d.x, d.y, d.z, color});
+        EmitIndices(outMesh, {base, base + 1, base + 2, base, base + 2, base + 3});
+    }
+
+    // Writes a line as strips of left/right vertex pairs. Each pair after the first of a strip closes the quad
+    // back to the previous pair, so the quads of a strip share their edges.
+    class LineStripWriter
+    {
+    public:
+        LineStripWriter(RoadDecalMesh& mesh, const float halfWidth, const uint32_t color)
+            : mesh_(mesh)
+            , halfWidth_(halfWidth)
+            , color_(color)
+        {
+        }
+
+        // Adds a pair at c, offset by halfWidth * scale along the unit normal (nx, nz).
+        void AddPair(const RoadDecalPoint& c, const float nx, const float nz, const float scale, const bool join)
+        {
+            if (!HasRoom(mesh_, 2)) {
+                open_ = false;
+                return;
+            }
+            const float ox = nx * halfWidth_ * scale;
+            const float oz = nz * halfWidth_ * scale;
+            const size_t left = mesh_.vertices.size();
+            mesh_.vertices.push_back({c.x - ox, c.y, c.z - oz, color_});
+            mesh_.vertices.push_back({c.x + ox, c.y, c.z + oz, color_});
+            if (join && open_) {
+                // Same winding as EmitQuad(aL, bL, bR, aR).
+                EmitIndices(mesh_, {left - 2, left, left + 1, left - 2, left + 1, left - 1});
+            }
+            open_ = true;
+        }
+
+    private:
+        RoadDecalMesh& mesh_;
+        float halfWidth_;
+        uint32_t color_;
+        bool open_ = false;
+    };
+
+    void EmitThickSegmentNoConform(const RoadDecalPoint& a,
+                                   const RoadDecalPoint& b,
+                                   float width,
+                                   uint32_t color,
+                                   RoadDecalMesh& outMesh)
+    {
+        float tx = 0.0f;
+        float tz = 0.0f;
+        float len = 0.0f;
+        if (!GetDirectionXZ(a, b, tx, tz, len) || width <= 0.0f) {
+            return;
+        }
+        const float halfWidth = width * 0.5f;
+        const float nx = -tz;
+        const float nz = tx;
+        const RoadDecalPoint aL{a.x - nx * halfWidth, a.y, a.z - nz * halfWidth, false};
+        const RoadDecalPoint aR{a.x + nx * halfWidth, a.y, a.z + nz * halfWidth, false};
+        const RoadDecalPoint bL{b.x - nx * halfWidth, b.y, b.z - nz * halfWidth, false};
+        const RoadDecalPoint bR{b.x + nx * halfWidth, b.y, b.z + nz * halfWidth, false};
+        EmitQuad(aL, bL, bR, aR, color, outMesh);
+    }
+
+    RoadDecalPoint LocalPoint(const RoadDecalPoint& center,
+                              float rightX,
+                              float rightZ,
+                              float fwdX,
+                              float fwdZ,
+                              float lateral,
+                              float forward)
+    {
+        return {
+            center.x + rightX * lateral + fwdX * forward,
+            center.y,
+            center.z + rightZ * lateral + fwdZ * forward,
+            false
+        };
+    }
+
+    void BuildLine(const std::vector<RoadDecalPoint>& points,
+                   float width,
+                   uint32_t color,
+                   bool dashed,
+                   float dashLength,
+                   float gapLength,
+                   const RoadDecalConformer& conformer,
+                   RoadDecalMesh& outMesh)
+    {
+        if (points.size() < 2 || width <= 0.0f) {
+            return;
+        }
+
+        std::vector<RoadDecalPoint> path;
+        BuildRoadDecalSmoothedPath(points, path);
+        if (path.empty()) {
+            path = points;
+        }
+        conformer(path);
+
+        // Drop points that would start a segment too short to have a direction.
+        std::vector<RoadDecalPoint> nodes;
+        std::vector<float> arc;         // Distance along the line in XZ, per node.
+        std::vector<float> segX;        // Unit direction of the segment starting at each node.
+        std::vector<float> segZ;
+        nodes.reserve(path.size());
+        for (const auto& p : path) {
+            float tx = 0.0f;
+            float tz = 0.0f;
+            float len = 0.0f;
+            if (nodes.empty()) {
+                nodes.push_back(p);
+                arc.push_back(0.0f);
+            }
+            else if (GetDirectionXZ(nodes.back(), p, tx, tz, len)) {
+                segX.push_back(tx);
+                segZ.push_back(tz);
+                nodes.push_back(p);
+                arc.push_back(arc.back() + len);
+            }
+        }
+        if (nodes.size() < 2) {
+            return;
+        }
+        const size_t segCount = nodes.size() - 1;
+        const float total = arc.back();
+
+        dashLength = std::max(0.05f, dashLength);
+        gapLength = std::max(0.0f, gapLength);
+        const float cycleLength = dashLength + gapLength;
+        LineStripWriter strip(outMesh, width * 0.5f, color);
+
+        const auto pointAt = [&](const size_t seg, const float s) {
+            const float t = std::clamp((s - arc[seg]) / (arc[seg + 1] - arc[seg]), 0.0f, 1.0f);
+            const auto& p0 = nodes[seg];
+            const auto& p1 = nodes[seg + 1];
+            return RoadDecalPoint{p0.x + (p1.x - p0.x) * t, p0.y + (p1.y - p0.y) * t, p0.z + (p1.z - p0.z) * t, false};
+        };
+
+        // One strip from s0 to s1, with a shared pair at every node in between.
+        size_t seg = 0;
+        const auto emitRun = [&](const float s0, const float s1) {
+            while (seg + 1 < segCount && arc[seg + 1] <= s0) {
+                ++seg;
+            }
+            strip.AddPair(pointAt(seg, s0), -segZ[seg], segX[seg], 1.0f, false);
+            while (seg + 1 < segCount && arc[seg + 1] < s1) {
+                // Miter the corner: the pair sits on the bisector of both normals, pushed out to keep the width.
+                const size_t next = seg + 1;
+                const float mx = -segZ[seg] - segZ[next];
+                const float mz = segX[seg] + segX[next];
+                const float mLen = std::sqrt(mx * mx + mz * mz);
+                const float cosHalf = mLen * 0.5f;
+                if (cosHalf < kMinMiterCos) {
+                    // Too sharp to miter: end the strip on this segment and start a new one on the next.
+                    strip.AddPair(nodes[next], -segZ[seg], segX[seg], 1.0f, true);
+                    strip.AddPair(nodes[next], -segZ[next], segX[next], 1.0f, false);
+                }
+                else {
+                    strip.AddPair(nodes[next], mx / mLen, mz / mLen, 1.0f / cosHalf, true);
+                }
+                seg = next;
+            }
+            strip.AddPair(pointAt(seg, s1), -segZ[seg], segX[seg], 1.0f, true);
+        };
+
+        if (!dashed || cycleLength <= 0.0f) {
+            emitRun(0.0f, total);
+            return;
+        }
+        for (float s = 0.0f; s < total; s += cycleLength) {
+            emitRun(s, (std::min)(s + dashLength, total));
+        }
+    }
+
+    void BuildStraightArrow(const RoadMarkupStroke& stroke,
+                            uint32_t color,
+                            const RoadDecalConformer& conformer,
+                            RoadDecalMesh& outMesh)
+    {
+        if (stroke.points.empty()) {
+            return;
+        }
+        const RoadDecalPoint center = stroke.points.front();
+        const float fx = std::cos(stroke.rotation);
+        const float fz = std::sin(stroke.rotation);
+        const float rx = -fz;
+        const float rz = fx;
+        const float width = std::max(0.2f, stroke.width);
+        const float length = std::max(0.8f, stroke.length);
+
+        auto p0 = LocalPoint(center, rx, rz, fx, fz, -0.15f * width, -0.50f * length);
+        auto p1 = LocalPoint(center, rx, rz, fx, fz, -0.15f * width, 0.10f * length);
+        auto p2 = LocalPoint(center, rx, rz, fx, fz, +0.15f * width, 0.10f * length);
+        auto p3 = LocalPoint(center, rx, rz, fx, fz, +0.15f * width, -0.50f * length);
+        auto tip = LocalPoint(center, rx, rz, fx, fz, 0.00f, 0.50f * length);
+        auto hl = LocalPoint(center, rx, rz, fx, fz, -0.50f * width, 0.10f * length);
+        auto hr = LocalPoint(center, rx, rz, fx, fz, +0.50f * width, 0.10f * length);
+
+        std::vector<RoadDecalPoint> shape = {p0, p1, p2, p3, tip, hl, hr};
+        conformer(shape);
+        EmitQuad(shape[0], shape[1], shape[2], shape[3], color, outMesh);
+        EmitTriangle(shape[5], shape[4], shape[6], color, outMesh);
+    }
+
+    void BuildTurnArrow(const RoadMarkupStroke& stroke,
+                        bool left,
+                        bool withStraight,
+                        uint32_t color,
+                        const RoadDecalConformer& conformer,
+                        RoadDecalMesh& outMesh)
+    {
+        if (withStraight) {
+            BuildStraightArrow(stroke, color, conformer, outMesh);
+        }
+        const RoadDecalPoint center = stroke.points.front();
+        const float fx = std::cos(stroke.rotation);
+        const float fz = std::sin(stroke.rotation);
+        const float rx = -fz;
+        const float rz = fx;
+        const float sign = left ? -1.0f : 1.0f;
+
+        std::vector<RoadDecalPoint> path = {
+            LocalPoint(center, rx, rz, fx, fz, 0.0f, -0.35f * stroke.length),
+            LocalPoint(center, rx, rz, fx, fz, 0.0f, -0.05f * stroke.length),
+            LocalPoint(center, rx, rz, fx, fz, sign * 0.35f * stroke.length, 0.25f * stroke.length),
+        };
+        BuildLine(path, std::max(0.08f, stroke.width * 0.30f), color, false, 0.0f, 0.0f, conformer, outMesh);
+
+        RoadMarkupStroke head = stroke;
+        head.points = {path.back()};
+        head.rotation += left ? -1.57f : 1.57f;
+        head.length = std::max(0.5f, stroke.length * 0.35f);
+        head.width = std::max(0.4f, stroke.width * 0.90f);
+        BuildStraightArrow(head, color, conformer, outMesh);
+    }
+
+    void BuildUTurnArrow(const RoadMarkupStroke& stroke,
+                         uint32_t color,
+                         const RoadDecalConformer& conformer,
+                         RoadDecalMesh& outMesh)
+    {
+        const RoadDecalPoint center = stroke.points.front();
+        const float fx = std::cos(stroke.rotation);
+        const float fz = std::sin(stroke.rotation);
+        const float rx = -fz;
+        const float rz = fx;
+
+        std::vector<RoadDecalPoint> path = {
+            LocalPoint(center, rx, rz, fx, fz, 0.0f, -0.45f * stroke.length),
+            LocalPoint(center, rx, rz, fx, fz, 0.0f, -0.10f * stroke.length),
+        };
+        const float radius = std::max(0.4f, stroke.length * 0.28f);
+        for (int i = 0; i <= 8; ++i) {
+            const float t = static_cast<float>(i) / 8.0f;
+            const float ang = -0.2f * 3.1415926f + (1.35f * 3.1415926f) * t;
+            path.push_back(LocalPoint(center, rx, rz, fx, fz,
+                                      -0.18f * stroke.length + std::cos(ang) * radius,
+                                      +0.08f * stroke.length + std::sin(ang) * radius));
+        }
+        BuildLine(path, std::max(0.08f, stroke.width * 0.30f), color, false, 0.0f, 0.0f, conformer, outMesh);
+
+        RoadMarkupStroke head = stroke;
+        head.points = {path.back()};
+        head.rotation += 3.1415926f;
+        head.length = std::max(0.5f, stroke.length * 0.35f);
+        head.width = std::max(0.4f, stroke.width * 0.90f);
+        BuildStraightArrow(head, color, conformer, outMesh);
+    }
+
+    void BuildCrosswalk(const RoadMarkupStroke& stroke,
+                        float stripe,
+                        float gap,
+                        bool ladderRails,
+                        uint32_t color,
+                        const RoadDecalConformer& conformer,
+                        RoadDecalMesh& outMesh)
+    {
+        const auto& start = stroke.points[0];
+        const auto& end = stroke.points[1];
+        float dragTx = 0.0f;
+        float dragTz = 0.0f;
+        float length = 0.0f;
+        if (!GetDirectionXZ(start, end, dragTx, dragTz, length)) {
+            return;
+        }
+        // Treat user drag length as curb-to-curb span.
+        // Stripe orientation follows stroke.rotation (auto-align writes drag direction;
+        // manual rotation works when auto-align is off).
+        float tx = std::cos(stroke.rotation);
+        float tz = std::sin(stroke.rotation);
+        if (std::fabs(tx) < 0.0001f && std::fabs(tz) < 0.0001f) {
+            tx = dragTx;
+            tz = dragTz;
+        }
+        const float perpX = -tz;
+        const float perpZ = tx;
+        // Keep dimensions decoupled:
+        // - drag length controls curb-to-curb span
+        // - stroke.length controls crossing depth (visual width along road)
+        const float span = length;
+        const float depth = std::max(stripe, stroke.length);
+        const int stripes = std::max(1, static_cast<int>(std::floor((depth + gap) / (stripe + gap))));
+        const float usedDepth = static_cast<float>(stripes) * stripe + static_cast<float>(stripes - 1) * gap;
+        const float firstOffset = -0.5f * usedDepth + stripe * 0.5f;
+        const RoadDecalPoint center{
+            (start.x + end.x) * 0.5f,
+            (start.y + end.y) * 0.5f,
+            (start.z + end.z) * 0.5f,
+            false
+        };
+
+        for (int i = 0; i < stripes; ++i) {
+            const float offset = firstOffset + static_cast<float>(i) * (stripe + gap);
+            const RoadDecalPoint a{
+                center.x + perpX * offset - tx * (span * 0.5f),
+                center.y,
+                center.z + perpZ * offset - tz * (span * 0.5f),
+                false
+            };
+            const RoadDecalPoint b{
+                center.x + perpX * offset + tx * (span * 0.5f),
+                center.y,
+                center.z + perpZ * offset + tz * (span * 0.5f),
+                false
+            };
+            BuildLine({a, b}, stripe, color, false, 0.0f, 0.0f, conformer, outMesh);
+        }
+
+        if (ladderRails) {
+            const float railLeft = -0.5f * depth;
+            const float railRight = 0.5f * depth;
+            const RoadDecalPoint l0{
+                center.x + perpX * railLeft - tx * (span * 0.5f),
+                center.y,
+                center.z + perpZ * railLeft - tz * (span * 0.5f),
+                false
+            };
+            const RoadDecalPoint l1{
+                center.x + perpX * railLeft + tx * (span * 0.5f),
+                center.y,
+                center.z + perpZ * railLeft + tz * (span * 0.5f),
+                false
+            };
+            const RoadDecalPoint r0{
+                center.x + perpX * railRight - tx * (span * 0.5f),
+                center.y,
+                center.z + perpZ * railRight - tz * (span * 0.5f),
+                false
+            };
+            const RoadDecalPoint r1{
+                center.x + perpX * railRight + tx * (span * 0.5f),
+                center.y,
+                center.z + perpZ * railRight + tz * (span * 0.5f),
+                false
+            };
+            BuildLine({l0, l1}, stripe * 0.5f, color, false, 0.0f, 0.0f, conformer, outMesh);
+            BuildLine({r0, r1}, stripe * 0.5f, color, false, 0.0f, 0.0f, conformer, outMesh);
+        }
+    }
+}
+
+const RoadMarkupProperties& GetRoadMarkupProperties(RoadMarkupType type)
+{
+    return FindProps(type);
+}
+
+RoadMarkupCategory GetMarkupCategory(RoadMarkupType type)
+{
+    return FindProps(type).category;
+}
+
+const std::vector<RoadMarkupType>& GetRoadMarkupTypesForCategory(RoadMarkupCategory category)
+{
+    static const std::vector<RoadMarkupType> laneTypes = {
+        RoadMarkupType::SolidWhiteLine,
+        RoadMarkupType::DashedWhiteLine,
+        RoadMarkupType::SolidYellowLine,
+        RoadMarkupType::DashedYellowLine,
+        RoadMarkupType::DoubleSolidYellow,
+        RoadMarkupType::SolidWhiteEdgeLine,
+    };
+    static const std::vector<RoadMarkupType> arrowTypes = {
+        RoadMarkupType::ArrowStraight,
+        RoadMarkupType::ArrowLeft,
+        RoadMarkupType::ArrowRight,
+        RoadMarkupType::ArrowLeftRight,
+        RoadMarkupType::ArrowStraightLeft,
+        RoadMarkupType::ArrowStraightRight,
+        RoadMarkupType::ArrowUTurn,
+    };
+    static const std::vector<RoadMarkupType> crossingTypes = {
+        RoadMarkupType::ZebraCrosswalk,
+        RoadMarkupType::LadderCrosswalk,
+        RoadMarkupType::ContinentalCrosswalk,
+        RoadMarkupType::StopBar,
+    };
+    static const std::vector<RoadMarkupType> zoneTypes = {
+        RoadMarkupType::YieldTriangle,
+        RoadMarkupType::ParkingSpace,
+        RoadMarkupType::BikeSymbol,
+        RoadMarkupType::BusLane,
+    };
+    static const std::vector<RoadMarkupType> textTypes = {
+        RoadMarkupType::TextStop,
+        RoadMarkupType::TextSlow,
+        RoadMarkupType::TextSchool,
+        RoadMarkupType::TextBusOnly,
+    };
+
+    switch (category) {
+    case RoadMarkupCategory::LaneDivider:
+        return laneTypes;
+    case RoadMarkupCategory::DirectionalArrow:
+        return arrowTypes;
+    case RoadMarkupCategory::Crossing:
+        return crossingTypes;
+    case RoadMarkupCategory::ZoneMarking:
+        return zoneTypes;
+    case RoadMarkupCategory::TextLabel:
+    default:
+        return textTypes;
+    }
+}
+
+void BuildRoadDecalSmoothedPath(const std::vector<RoadDecalPoint>& points, std::vector<RoadDecalPoint>& outPoints)
+{
+    outPoints.clear();
+    if (points.size() < 3) {
+        outPoints = points;
+        return;
+    }
+
+    outPoints.reserve(points.size() * 4);
+    outPoints.push_back(points.front());
+
+    for (size_t i = 0; i + 1 < points.size(); ++i) {
+        const auto& p1 = points[i];
+        const auto& p2 = points[i + 1];
+
+        const bool forceLinear = p1.hardCorner || p2.hardCorner;
+        if (forceLinear) {
+            outPoints.push_back(p2);
+            continue;
+        }
+
+        const auto& p0Raw = (i == 0) ? points[i] : points[i - 1];
+        const auto& p3Raw = (i + 2 < points.size()) ? points[i + 2] : points[i + 1];
+        const bool p0Hard = (i > 0) && points[i - 1].hardCorner;
+        const bool p3Hard = (i + 2 < points.size()) && points[i + 2].hardCorner;
+        const auto& p0 = p0Hard ? p1 : p0Raw;
+        const auto& p3 = p3Hard ? p2 : p3Raw;
+
+        const float dx = p2.x - p1.x;
+        const float dz = p2.z - p1.z;
+        const CatmullRomSegment segment = MakeCentripetalSegment(p0, p1, p2, p3);
+        AppendSegmentSamples(segment, SmoothingSteps(segment, std::sqrt(dx * dx + dz * dz)), p2, outPoints);
+    }
+}
+
+void BuildRoadDecalStrokeMesh(const RoadMarkupStroke& stroke,
+                              const RoadDecalConformer& conformer,
+                              RoadDecalMesh& outMesh)
+{
+    if (!stroke.visible || stroke.points.empty()) {
+        return;
+    }
+
+    const auto& props = FindProps(stroke.type);
+    const uint32_t color = ApplyOpacity(stroke.color != 0 ? stroke.color : props.defaultColor, stroke.opacity);
+    const float dashLength = std::max(0.05f, stroke.dashLength);
+    const float gapLength = std::max(0.0f, stroke.gapLength);
+
+    switch (props.category) {
+    case RoadMarkupCategory::LaneDivider:
+        if (stroke.points.size() < 2) {
+            return;
+        }
+        if (stroke.type == RoadMarkupType::DoubleSolidYellow) {
+            std::vector<RoadDecalPoint> p1 = stroke.points;
+            std::vector<RoadDecalPoint> p2 = stroke.points;
+            const float offset = (stroke.width + kDoubleYellowSpacing) * 0.5f;
+            for (size_t i = 0; i < stroke.points.size(); ++i) {
+                const auto& prev = stroke.points[(i == 0) ? i : i - 1];
+                const auto& next = stroke.points[(i + 1 < stroke.points.size()) ? i + 1 : i];
+                float tx = 0.0f;
+                float tz = 0.0f;
+                float len = 0.0f;
+                if (!GetDirectionXZ(prev, next, tx, tz, len)) {
+                    continue;
+                }
+                const float nx = -tz;
+                const float nz = tx;
+                p1[i].x += nx * offset;
+                p1[i].z += nz * offset;
+                p2[i].x -= nx * offset;
+                p2[i].z -= nz * offset;
+            }
+            BuildLine(p1, stroke.width, color, false, dashLength, gapLength, conformer, outMesh);
+            BuildLine(p2, stroke.width, color, false, dashLength, gapLength, conformer, outMesh);
+        } else {
+            const bool dashed = stroke.dashed ||
+                                stroke.type == RoadMarkupType::DashedWhiteLine ||
+                                stroke.type == RoadMarkupType::DashedYellowLine;
+            BuildLine(stroke.points, stroke.width, color, dashed, dashLength, gapLength, conformer, outMesh);
+        }
+        break;
+
+    case RoadMarkupCategory::DirectionalArrow:
+        switch (stroke.type) {
+        case RoadMarkupType::ArrowStraight:
+            BuildStraightArrow(stroke, color, conformer, outMesh);
+            break;
+        case RoadMarkupType::ArrowLeft:
+            BuildTurnArrow(stroke, true, false, color, conformer, outMesh);
+            break;
+        case RoadMarkupType::ArrowRight:
+            BuildTurnArrow(stroke, false, false, color, conformer, outMesh);
+            break;
+        case RoadMarkupType::ArrowLeftRight:
+            BuildTurnArrow(stroke, true, false, color, conformer, outMesh);
+            BuildTurnArrow(stroke, false, false, color, conformer, outMesh);
+            break;
+        case RoadMarkupType::ArrowStraightLeft:
+            BuildTurnArrow(stroke, true, true, color, conformer, outMesh);
+            break;
+        case RoadMarkupType::ArrowStraightRight:
+            BuildTurnArrow(stroke, false, true, color, conformer, outMesh);
+            break;
+        case RoadMarkupType::ArrowUTurn:
+            BuildUTurnArrow(stroke, color, conformer, outMesh);
+            break;
+        default:
+            break;
+        }
+        break;
+
+    case RoadMarkupCategory::Crossing:
+        if (stroke.points.size() < 2) {
+            return;
+        }
+        switch (stroke.type) {
+        case RoadMarkupType::ZebraCrosswalk:
+            BuildCrosswalk(stroke, 0.5f, 0.5f, false, color, conformer, outMesh);
+            break;
+        case RoadMarkupType::LadderCrosswalk:
+            BuildCrosswalk(stroke, 0.5f, 0.5f, true, color, conformer, outMesh);
+            break;
+        case RoadMarkupType::ContinentalCrosswalk:
+            BuildCrosswalk(stroke, 0.8f, 0.8f, false, color, conformer, outMesh);
+            break;
+        case RoadMarkupType::StopBar:
+            BuildLine(stroke.points, std::max(0.1f, stroke.width), color, false, 0.0f, 0.0f, conformer, outMesh);
+            break;
+        default:
+            break;
+        }
+        break;
+
+    case RoadMarkupCategory::ZoneMarking:
+    case RoadMarkupCategory::TextLabel:
+        break;
+    }
+}
+
+void EmitRoadDecalSegment(const RoadDecalPoint& a,
+                          const RoadDecalPoint& b,
+                          float width,
+                          uint32_t color,
+                          RoadDecalMesh& outMesh)
+{
+    EmitThickSegmentNoConform(a, b, width, color, outMesh);
+}
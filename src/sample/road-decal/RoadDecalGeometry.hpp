@@ -0,0 +1,81 @@
+#pragma once
+
+#include "RoadDecalData.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Stroke tessellation for road markings, independent of the game so host tools can build and time it.
+//
+// Strokes become indexed D3DFVF_XYZ | D3DFVF_DIFFUSE triangle lists in world space. Lines are strips: each point
+// along a line is one left/right vertex pair shared by the quads on both sides of it, joined with a miter, so a line
+// of n points costs 2n vertices instead of 6 per segment. Heights come from the conformer, which the plugin points at
+// the terrain; tools can plug in a synthetic surface.
+//
+// Example usage:
+//   RoadDecalConformer conformer{};
+//   conformer.conform = [](RoadDecalPoint* points, size_t count, void*) { /* set points[i].y */ };
+//   RoadDecalMesh mesh;
+//   BuildRoadDecalStrokeMesh(stroke, conformer, mesh);
+//
+
+struct RoadDecalVertex
+{
+    float x;
+    float y;
+    float z;
+    uint32_t diffuse;   // D3D ARGB.
+};
+static_assert(sizeof(RoadDecalVertex) == 16, "RoadDecalVertex must match D3DFVF_XYZ | D3DFVF_DIFFUSE");
+
+// Indexed triangle list with 16-bit indices, the only kind D3D7 takes.
+struct RoadDecalMesh
+{
+    static constexpr uint32_t kMaxVertices = 65535;
+
+    std::vector<RoadDecalVertex> vertices;
+    std::vector<uint16_t> indices;
+
+    void Clear()
+    {
+        vertices.clear();
+        indices.clear();
+    }
+
+    [[nodiscard]] bool Empty() const { return indices.empty(); }
+};
+
+struct RoadDecalConformer
+{
+    // Sets the height of every point from its x/z. Points keep their heights when this is null.
+    void (*conform)(RoadDecalPoint* points, size_t count, void* userData) = nullptr;
+    void* userData = nullptr;
+    // True if conform may run on several threads at once.
+    bool threadSafe = false;
+
+    void operator()(std::vector<RoadDecalPoint>& points) const
+    {
+        if (conform && !points.empty()) {
+            conform(points.data(), points.size(), userData);
+        }
+    }
+};
+
+// The path a line stroke follows: centripetal Catmull-Rom through its points, straight next to hard corners. Each
+// segment gets as many samples as its bend needs to stay within 2 cm of the curve, so straights get one sample per 8 m
+// and tight curves up to 48. Fewer than three points are returned unchanged.
+void BuildRoadDecalSmoothedPath(const std::vector<RoadDecalPoint>& points, std::vector<RoadDecalPoint>& outPoints);
+
+// Appends the triangles of one stroke. Invisible strokes and unsupported types append nothing. Geometry that would
+// take the mesh past kMaxVertices is dropped.
+void BuildRoadDecalStrokeMesh(const RoadMarkupStroke& stroke,
+                              const RoadDecalConformer& conformer,
+                              RoadDecalMesh& outMesh);
+
+// Appends a flat quad of `width` around the segment a-b, at the heights of its ends.
+void EmitRoadDecalSegment(const RoadDecalPoint& a,
+                          const RoadDecalPoint& b,
+                          float width,
+                          uint32_t color,
+                          RoadDecalMesh& outMesh);
@@ -0,0 +1,454 @@
+#include "RoadDecalGeometryCache.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+namespace
+{
+    constexpr uint64_t kFnvOffset = 0xCBF29CE484222325ull;
+    constexpr uint64_t kFnvPrime = 0x100000001B3ull;
+
+    uint64_t HashBytes(uint64_t hash, const void* data, const size_t size)
+    {
+        const auto* bytes = static_cast<const uint8_t*>(data);
+        for (size_t i = 0; i < size; ++i) {
+            hash = (hash ^ bytes[i]) * kFnvPrime;
+        }
+        return hash;
+    }
+
+    template <typename T>
+    uint64_t HashValue(const uint64_t hash, const T& value)
+    {
+        return HashBytes(hash, &value, sizeof(value));
+    }
+
+    constexpr CullBox kEmptyBounds{1.0e30f, 1.0e30f, 1.0e30f, -1.0e30f, -1.0e30f, -1.0e30f};
+
+    void Extend(CullBox& box, const CullBox& other)
+    {
+        box.minX = (std::min)(box.minX, other.minX);
+        box.minY = (std::min)(box.minY, other.minY);
+        box.minZ = (std::min)(box.minZ, other.minZ);
+        box.maxX = (std::max)(box.maxX, other.maxX);
+        box.maxY = (std::max)(box.maxY, other.maxY);
+        box.maxZ = (std::max)(box.maxZ, other.maxZ);
+    }
+
+    CullBox BoundsOf(const RoadDecalVertex* vertices, const uint32_t count)
+    {
+        CullBox box = kEmptyBounds;
+        for (uint32_t i = 0; i < count; ++i) {
+            const RoadDecalVertex& v = vertices[i];
+            Extend(box, {v.x, v.y, v.z, v.x, v.y, v.z});
+        }
+        return box;
+    }
+}
+
+uint64_t HashRoadMarkupStroke(const RoadMarkupStroke& stroke)
+{
+    uint64_t hash = kFnvOffset;
+    hash = HashValue(hash, stroke.type);
+    hash = HashValue(hash, stroke.width);
+    hash = HashValue(hash, stroke.length);
+    hash = HashValue(hash, stroke.rotation);
+    hash = HashValue(hash, stroke.dashed);
+    hash = HashValue(hash, stroke.dashLength);
+    hash = HashValue(hash, stroke.gapLength);
+    hash = HashValue(hash, stroke.color);
+    hash = HashValue(hash, stroke.opacity);
+    hash = HashValue(hash, stroke.visible);
+    hash = HashValue(hash, static_cast<uint32_t>(stroke.points.size()));
+    // Field by field: RoadDecalPoint has padding after hardCorner.
+    for (const auto& point : stroke.points) {
+        hash = HashValue(hash, point.x);
+        hash = HashValue(hash, point.y);
+        hash = HashValue(hash, point.z);
+        hash = HashValue(hash, point.hardCorner);
+    }
+    return hash;
+}
+
+RoadDecalGeometryCache::RoadDecalGeometryCache(const float chunkSize)
+    : invChunkSize_(1.0f / (std::max)(chunkSize, 1.0f))
+{
+}
+
+void RoadDecalGeometryCache::BeginRebuild(const uint64_t environmentKey)
+{
+    if (++rebuild_ == 0) {
+        rebuild_ = 1;
+    }
+    if (environmentKey == 0 || environmentKey != environmentKey_) {
+        Clear();
+        environmentKey_ = environmentKey;
+    }
+
+    stats_ = {};
+    for (auto& layout : layouts_) {
+        layout.nextSlots.clear();
+        layout.keptVertices = 0;
+        layout.keptIndices = 0;
+        layout.diverged = false;
+        layout.nextBounds = kEmptyBounds;
+    }
+}
+
+void RoadDecalGeometryCache::AddStroke(const RoadMarkupStroke& stroke, const RoadDecalConformer& conformer)
+{
+    if (!stroke.visible || stroke.points.empty()) {
+        return;
+    }
+
+    const uint64_t hash = HashRoadMarkupStroke(stroke);
+    auto [it, inserted] = entries_.try_emplace(hash);
+    if (inserted) {
+        scratch_.Clear();
+        BuildRoadDecalStrokeMesh(stroke, conformer, scratch_);
+        Store(it->second, scratch_.vertices.data(), static_cast<uint32_t>(scratch_.vertices.size()),
+              scratch_.indices.data(), static_cast<uint32_t>(scratch_.indices.size()));
+    }
+    Place(stroke, it->second);
+}
+
+void RoadDecalGeometryCache::AddStrokes(const RoadMarkupStroke* strokes,
+                                        const size_t count,
+                                        const RoadDecalConformer& conformer,
+                                        RoadDecalWorkerPool* pool)
+{
+    // Look everything up first, so each new stroke is tessellated once even if it appears twice.
+    batchEntries_.assign(count, nullptr);
+    misses_.clear();
+    for (size_t i = 0; i < count; ++i) {
+        const RoadMarkupStroke& stroke = strokes[i];
+        if (!stroke.visible || stroke.points.empty()) {
+            continue;
+        }
+        auto [it, inserted] = entries_.try_emplace(HashRoadMarkupStroke(stroke));
+        batchEntries_[i] = &it->second;
+        if (inserted) {
+            misses_.push_back(i);
+        }
+    }
+
+    if (!pool || !conformer.threadSafe || pool->Workers() <= 1 || misses_.size() < kMinParallelStrokes) {
+        for (const size_t i : misses_) {
+            scratch_.Clear();
+            BuildRoadDecalStrokeMesh(strokes[i], conformer, scratch_);
+            Store(*batchEntries_[i], scratch_.vertices.data(), static_cast<uint32_t>(scratch_.vertices.size()),
+                  scratch_.indices.data(), static_cast<uint32_t>(scratch_.indices.size()));
+        }
+    }
+    else {
+        // Tessellation is a pure function of the stroke and the terrain, so workers can run it in any order. Each
+        // appends to its own arena; storing and placing stay serial and in order, so the result is the same.
+        const unsigned workers = pool->Workers();
+        arenas_.resize(workers);
+        for (auto& arena : arenas_) {
+            arena.mesh.Clear();
+        }
+        arenaRanges_.assign(misses_.size(), {});
+        pool->Run(misses_.size(), [&](const unsigned worker, const size_t miss) {
+            Arena& arena = arenas_[worker];
+            arena.scratch.Clear();
+            BuildRoadDecalStrokeMesh(strokes[misses_[miss]], conformer, arena.scratch);
+            ArenaRange& range = arenaRanges_[miss];
+            range.worker = worker;
+            range.firstVertex = static_cast<uint32_t>(arena.mesh.vertices.size());
+            range.vertexCount = static_cast<uint32_t>(arena.scratch.vertices.size());
+            range.firstIndex = static_cast<uint32_t>(arena.mesh.indices.size());
+            range.indexCount = static_cast<uint32_t>(arena.scratch.indices.size());
+            arena.mesh.vertices.insert(arena.mesh.vertices.end(), arena.scratch.vertices.begin(),
+                                       arena.scratch.vertices.end());
+            arena.mesh.indices.insert(arena.mesh.indices.end(), arena.scratch.indices.begin(),
+                                      arena.scratch.indices.end());
+        });
+        for (size_t miss = 0; miss < misses_.size(); ++miss) {
+            const ArenaRange& range = arenaRanges_[miss];
+            const RoadDecalMesh& mesh = arenas_[range.worker].mesh;
+            Store(*batchEntries_[misses_[miss]], mesh.vertices.data() + range.firstVertex, range.vertexCount,
+                  mesh.indices.data() + range.firstIndex, range.indexCount);
+        }
+    }
+
+    for (size_t i = 0; i < count; ++i) {
+        if (batchEntries_[i]) {
+            Place(strokes[i], *batchEntries_[i]);
+        }
+    }
+}
+
+void RoadDecalGeometryCache::Store(Entry& entry,
+                                   const RoadDecalVertex* vertices,
+                                   const uint32_t vertexCount,
+                                   const uint16_t* indices,
+                                   const uint32_t indexCount)
+{
+    entry.range = Allocate(vertexCount, indexCount);
+    entry.bounds = BoundsOf(vertices, vertexCount);
+    if (vertexCount > 0) {
+        Page& page = pages_[entry.range.page];
+        std::memcpy(page.vertices.data() + entry.range.firstVertex, vertices, vertexCount * sizeof(RoadDecalVertex));
+        std::memcpy(page.indices.data() + entry.range.firstIndex, indices, indexCount * sizeof(uint16_t));
+    }
+    entry.serial = ++nextSerial_;
+    ++stats_.tessellated;
+}
+
+void RoadDecalGeometryCache::Place(const RoadMarkupStroke& stroke, Entry& entry)
+{
+    ++stats_.strokes;
+    entry.lastUsed = rebuild_;
+
+    const size_t chunkIndex = ChunkIndexFor(ChunkKeyOf(stroke.points.front()));
+    RoadDecalChunk& chunk = chunks_[chunkIndex];
+    ChunkLayout& layout = layouts_[chunkIndex];
+    layout.lastUsed = rebuild_;
+    Extend(layout.nextBounds, entry.bounds);
+
+    const Range& range = entry.range;
+    const size_t index = layout.nextSlots.size();
+    layout.nextSlots.push_back({entry.serial, range.vertexCount, range.indexCount});
+    if (!layout.diverged && index < layout.slots.size() && layout.slots[index].entry == entry.serial) {
+        layout.keptVertices += range.vertexCount;
+        layout.keptIndices += range.indexCount;
+        ++stats_.keptInPlace;
+        return;
+    }
+    if (!layout.diverged) {
+        layout.diverged = true;
+        TruncateChunk(chunk, layout.keptVertices, layout.keptIndices);
+    }
+    if (range.vertexCount > 0) {
+        const Page& page = pages_[range.page];
+        AppendToChunk(chunk, page.vertices.data() + range.firstVertex, range.vertexCount,
+                      page.indices.data() + range.firstIndex, range.indexCount);
+    }
+}
+
+void RoadDecalGeometryCache::EndRebuild()
+{
+    for (size_t i = chunks_.size(); i-- > 0;) {
+        RoadDecalChunk& chunk = chunks_[i];
+        ChunkLayout& layout = layouts_[i];
+        if (layout.lastUsed != rebuild_) {
+            // No strokes left; the last chunk takes its place.
+            ++stats_.changedChunks;
+            chunkIndex_.erase(chunk.key);
+            if (i + 1 != chunks_.size()) {
+                chunks_[i] = std::move(chunks_.back());
+                chunkBounds_[i] = chunkBounds_.back();
+                layouts_[i] = std::move(layouts_.back());
+                chunkIndex_[chunks_[i].key] = i;
+            }
+            chunks_.pop_back();
+            chunkBounds_.pop_back();
+            layouts_.pop_back();
+            continue;
+        }
+
+        if (layout.diverged || layout.nextSlots.size() != layout.slots.size()) {
+            if (!layout.diverged) {
+                // Only strokes at the end went away.
+                TruncateChunk(chunk, layout.keptVertices, layout.keptIndices);
+            }
+            // Versions come from one counter, so a chunk dropped and recreated never repeats one.
+            if (++version_ == 0) {
+                version_ = 1;
+            }
+            chunk.version = version_;
+            ++stats_.changedChunks;
+        }
+        layout.slots.swap(layout.nextSlots);
+        chunkBounds_[i] = layout.nextBounds;
+    }
+
+    for (auto it = entries_.begin(); it != entries_.end();) {
+        if (it->second.lastUsed != rebuild_) {
+            Free(it->second.range);
+            it = entries_.erase(it);
+            ++stats_.evicted;
+        }
+        else {
+            ++it;
+        }
+    }
+    CompactIfFragmented();
+
+    stats_.pages = static_cast<uint32_t>(pages_.size());
+    stats_.cachedVertices = 0;
+    for (const auto& page : pages_) {
+        stats_.cachedVertices += page.live;
+    }
+    stats_.chunks = static_cast<uint32_t>(chunks_.size());
+    stats_.vertices = 0;
+    stats_.indices = 0;
+    for (const auto& chunk : chunks_) {
+        stats_.vertices += chunk.vertices.size();
+        stats_.indices += chunk.indices.size();
+    }
+}
+
+size_t RoadDecalGeometryCache::InvalidateWhere(const uint64_t fromKey, const uint64_t toKey, const RegionTest test,
+                                               void* userData)
+{
+    if (fromKey == 0 || toKey == 0 || fromKey != environmentKey_) {
+        return 0; // Built against something else; the next BeginRebuild(toKey) drops it all anyway.
+    }
+    environmentKey_ = toKey;
+
+    // Chunk slots name entries by serial, so a re-tessellated stroke never matches its stale slot.
+    size_t dropped = 0;
+    for (auto it = entries_.begin(); it != entries_.end();) {
+        if (test(it->second.bounds, userData)) {
+            Free(it->second.range);
+            it = entries_.erase(it);
+            ++dropped;
+        }
+        else {
+            ++it;
+        }
+    }
+    return dropped;
+}
+
+void RoadDecalGeometryCache::Clear()
+{
+    pages_.clear();
+    deadVertices_ = 0;
+    entries_.clear();
+    chunks_.clear();
+    chunkBounds_.clear();
+    layouts_.clear();
+    chunkIndex_.clear();
+    environmentKey_ = 0;
+}
+
+uint64_t RoadDecalGeometryCache::ChunkKeyOf(const RoadDecalPoint& point) const
+{
+    const auto cx = static_cast<int32_t>(std::floor(point.x * invChunkSize_));
+    const auto cz = static_cast<int32_t>(std::floor(point.z * invChunkSize_));
+    return (static_cast<uint64_t>(static_cast<uint32_t>(cx)) << 32) | static_cast<uint32_t>(cz);
+}
+
+size_t RoadDecalGeometryCache::ChunkIndexFor(const uint64_t key)
+{
+    const auto [it, inserted] = chunkIndex_.try_emplace(key, chunks_.size());
+    if (inserted) {
+        chunks_.emplace_back().key = key;
+        chunkBounds_.push_back(kEmptyBounds);
+        layouts_.emplace_back().nextBounds = kEmptyBounds;
+    }
+    return it->second;
+}
+
+void RoadDecalGeometryCache::TruncateChunk(RoadDecalChunk& chunk, const size_t vertexCount, const size_t indexCount)
+{
+    chunk.vertices.resize(vertexCount);
+    chunk.indices.resize(indexCount);
+    while (!chunk.runs.empty() && chunk.runs.back().firstVertex >= vertexCount) {
+        chunk.runs.pop_back();
+    }
+    if (!chunk.runs.empty()) {
+        RoadDecalChunkRun& last = chunk.runs.back();
+        last.vertexCount = static_cast<uint32_t>(vertexCount - last.firstVertex);
+        last.indexCount = static_cast<uint32_t>(indexCount - last.firstIndex);
+    }
+}
+
+void RoadDecalGeometryCache::AppendToChunk(RoadDecalChunk& chunk,
+                                           const RoadDecalVertex* vertices,
+                                           const uint32_t vertexCount,
+                                           const uint16_t* indices,
+                                           const uint32_t indexCount)
+{
+    // Strokes never straddle runs, so a run's indices stay within 16 bits.
+    if (chunk.runs.empty() || chunk.runs.back().vertexCount + vertexCount > RoadDecalMesh::kMaxVertices) {
+        chunk.runs.push_back({static_cast<uint32_t>(chunk.vertices.size()), 0,
+                              static_cast<uint32_t>(chunk.indices.size()), 0});
+    }
+    RoadDecalChunkRun& run = chunk.runs.back();
+    const auto base = static_cast<uint16_t>(run.vertexCount);
+    chunk.vertices.insert(chunk.vertices.end(), vertices, vertices + vertexCount);
+    for (uint32_t i = 0; i < indexCount; ++i) {
+        chunk.indices.push_back(static_cast<uint16_t>(indices[i] + base));
+    }
+    run.vertexCount += vertexCount;
+    run.indexCount += indexCount;
+}
+
+RoadDecalGeometryCache::Range RoadDecalGeometryCache::Allocate(const uint32_t vertexCount, const uint32_t indexCount)
+{
+    if (vertexCount == 0) {
+        return {};
+    }
+
+    size_t pageIndex = pages_.size();
+    for (size_t i = pages_.size(); i-- > 0;) {
+        const Page& page = pages_[i];
+        if (page.vertices.size() - page.usedVertices >= vertexCount &&
+            page.indices.size() - page.usedIndices >= indexCount) {
+            pageIndex = i;
+            break;
+        }
+    }
+    if (pageIndex == pages_.size()) {
+        // Strokes bigger than a page get a page of their own.
+        Page& page = pages_.emplace_back();
+        page.vertices.resize((std::max)(vertexCount, kPageVertices));
+        page.indices.resize((std::max)(indexCount, kPageIndices));
+    }
+
+    Page& page = pages_[pageIndex];
+    const Range range{static_cast<uint32_t>(pageIndex), page.usedVertices, vertexCount, page.usedIndices, indexCount};
+    page.usedVertices += vertexCount;
+    page.usedIndices += indexCount;
+    page.live += vertexCount;
+    return range;
+}
+
+void RoadDecalGeometryCache::Free(const Range& range)
+{
+    if (range.vertexCount == 0) {
+        return;
+    }
+    Page& page = pages_[range.page];
+    page.live -= range.vertexCount;
+    deadVertices_ += range.vertexCount;
+    if (page.live == 0) {
+        // Nothing left on the page; rewind it for reuse.
+        deadVertices_ -= page.usedVertices;
+        page.usedVertices = 0;
+        page.usedIndices = 0;
+    }
+}
+
+void RoadDecalGeometryCache::CompactIfFragmented()
+{
+    size_t live = 0;
+    for (const auto& page : pages_) {
+        live += page.live;
+    }
+    if (deadVertices_ <= kPageVertices || deadVertices_ <= live) {
+        return;
+    }
+
+    // More dead than live vertices: repack the live ranges into fresh pages.
+    std::vector<Page> old;
+    old.swap(pages_);
+    deadVertices_ = 0;
+    for (auto& [hash, entry] : entries_) {
+        if (entry.range.vertexCount == 0) {
+            continue;
+        }
+        const Range from = entry.range;
+        entry.range = Allocate(from.vertexCount, from.indexCount);
+        Page& to = pages_[entry.range.page];
+        std::memcpy(to.vertices.data() + entry.range.firstVertex, old[from.page].vertices.data() + from.firstVertex,
+                    from.vertexCount * sizeof(RoadDecalVertex));
+        std::memcpy(to.indices.data() + entry.range.firstIndex, old[from.page].indices.data() + from.firstIndex,
+                    from.indexCount * sizeof(uint16_t));
+    }
+}
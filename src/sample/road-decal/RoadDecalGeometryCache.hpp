@@ -0,0 +1,211 @@
+#pragma once
+
+#include "RoadDecalGeometry.hpp"
+#include "RoadDecalWorkerPool.hpp"
+#include "public/ViewFrustum.h"
+
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+// Tessellated strokes kept between rebuilds, so an edit only re-tessellates the strokes it changed.
+//
+// Every rebuild walks the strokes in draw order. Each stroke is looked up by a hash of everything that shapes its
+// geometry. A hit copies the cached mesh, a miss tessellates the stroke once and caches it. Cached meshes live in
+// 16K-vertex pages, so the cache never moves a stroke's vertices when another one is added or evicted. Strokes not
+// seen in a rebuild are evicted at its end.
+//
+// The output is split into square chunks of the map (4x4 city tiles by default), each with its own vertices and
+// bounds, so the renderer can cull whole chunks and re-upload only the ones an edit touched. A stroke belongs to the
+// chunk holding its first point; its bounds still cover all of it. Within a chunk, strokes keep the order they were
+// added in. Each chunk's buffer is patched rather than rebuilt: the leading strokes that did not change keep their
+// vertices in place, and only the rest is copied from the pages. A chunk's version changes only when its vertices do.
+//
+// A chunk is split into runs of at most RoadDecalMesh::kMaxVertices vertices, so each run can go into one vertex
+// buffer and be drawn with 16-bit indices. A run's indices are relative to its first vertex.
+//
+// A rebuild that has many new strokes, such as the first one after loading a file, can pass them all to AddStrokes
+// with a worker pool. New strokes are then tessellated in parallel, each worker into its own arena, and stored and
+// placed in order afterwards, so the chunks come out bit-identical to adding the strokes one by one.
+//
+// Conformed heights depend on the terrain, so BeginRebuild takes the terrain version and drops everything when it
+// changes. When the caller knows where the terrain changed, InvalidateWhere moves to the new version first and drops
+// only the strokes over those places; the rest keep their geometry and their chunks are not re-uploaded.
+//
+// Example usage:
+//   RoadDecalGeometryCache cache;
+//   cache.BeginRebuild(heightfieldVersion);
+//   for (const RoadMarkupStroke& stroke : strokes) {
+//       cache.AddStroke(stroke, conformer);
+//   }
+//   cache.EndRebuild();
+//   for (const RoadDecalChunk& chunk : cache.Chunks()) {
+//       for (const RoadDecalChunkRun& run : chunk.runs) {
+//           DrawIndexed(chunk.vertices.data() + run.firstVertex, run.vertexCount,
+//                       chunk.indices.data() + run.firstIndex, run.indexCount);
+//       }
+//   }
+//
+
+struct RoadDecalGeometryCacheStats
+{
+    uint32_t strokes = 0;           // Added in the last rebuild.
+    uint32_t tessellated = 0;       // Of those, cache misses.
+    uint32_t keptInPlace = 0;       // Unchanged leading strokes whose vertices were not even copied.
+    uint32_t evicted = 0;
+    uint32_t chunks = 0;
+    uint32_t changedChunks = 0;     // Chunks whose vertices changed, including ones created or emptied.
+    size_t vertices = 0;            // In all chunks.
+    size_t indices = 0;
+    uint32_t pages = 0;
+    size_t cachedVertices = 0;      // Live vertices in the pages.
+};
+
+struct RoadDecalChunkRun
+{
+    uint32_t firstVertex = 0;
+    uint32_t vertexCount = 0;
+    uint32_t firstIndex = 0;
+    uint32_t indexCount = 0;
+};
+
+struct RoadDecalChunk
+{
+    uint64_t key = 0;               // Packed chunk column and row; stable while the chunk has strokes.
+    uint32_t version = 0;           // Changes whenever the geometry does; never repeats for the same key.
+    std::vector<RoadDecalVertex> vertices;
+    std::vector<uint16_t> indices;
+    std::vector<RoadDecalChunkRun> runs;
+};
+
+class RoadDecalGeometryCache
+{
+public:
+    static constexpr uint32_t kPageVertices = 16384;
+    // A strip quad adds two vertices and six indices, so pages hold three indices per vertex.
+    static constexpr uint32_t kPageIndices = 3 * kPageVertices;
+    // Fewer new strokes than this are not worth waking the workers for.
+    static constexpr size_t kMinParallelStrokes = 64;
+
+    explicit RoadDecalGeometryCache(float chunkSize = 64.0f);
+
+    using RegionTest = bool (*)(const CullBox& bounds, void* userData);
+
+    // A key of 0 means the terrain version is unknown; nothing survives such a rebuild.
+    void BeginRebuild(uint64_t environmentKey);
+    // If the cache was built against fromKey, drops the strokes whose bounds pass test and relabels the rest as built
+    // against toKey. Call between rebuilds. Returns the number of strokes dropped.
+    size_t InvalidateWhere(uint64_t fromKey, uint64_t toKey, RegionTest test, void* userData);
+    void AddStroke(const RoadMarkupStroke& stroke, const RoadDecalConformer& conformer);
+    // Same result as AddStroke on each stroke in order. New strokes are tessellated on pool's workers when there are
+    // enough of them and the conformer is thread-safe; pool may be null.
+    void AddStrokes(const RoadMarkupStroke* strokes, size_t count, const RoadDecalConformer& conformer,
+                    RoadDecalWorkerPool* pool);
+    // Drops chunks left without strokes; the order of the remaining chunks may change.
+    void EndRebuild();
+
+    void Clear();
+    [[nodiscard]] const std::vector<RoadDecalChunk>& Chunks() const { return chunks_; }
+    // Parallel to Chunks(), ready for CullBoxes.
+    [[nodiscard]] const std::vector<CullBox>& ChunkBounds() const { return chunkBounds_; }
+    [[nodiscard]] const RoadDecalGeometryCacheStats& Stats() const { return stats_; }
+
+private:
+    struct Range
+    {
+        uint32_t page = 0;
+        uint32_t firstVertex = 0;
+        uint32_t vertexCount = 0;
+        uint32_t firstIndex = 0;
+        uint32_t indexCount = 0;
+    };
+
+    struct Entry
+    {
+        Range range;
+        CullBox bounds{};
+        uint64_t serial = 0;        // Unique per tessellation, unlike the hash.
+        uint32_t lastUsed = 0;
+    };
+
+    struct Page
+    {
+        std::vector<RoadDecalVertex> vertices;
+        std::vector<uint16_t> indices;
+        uint32_t usedVertices = 0;  // Bump pointers.
+        uint32_t usedIndices = 0;
+        uint32_t live = 0;          // Vertices of entries still cached.
+    };
+
+    // Where one stroke's mesh sits in a chunk's buffers.
+    struct Slot
+    {
+        uint64_t entry = 0;         // Entry serial.
+        uint32_t vertexCount = 0;
+        uint32_t indexCount = 0;
+    };
+
+    // Rebuild bookkeeping for one chunk, parallel to chunks_.
+    struct ChunkLayout
+    {
+        std::vector<Slot> slots;            // Layout of the chunk's vertices.
+        std::vector<Slot> nextSlots;
+        size_t keptVertices = 0;            // Prefix of the chunk that still matches the strokes added so far.
+        size_t keptIndices = 0;
+        bool diverged = false;
+        uint32_t lastUsed = 0;
+        CullBox nextBounds{};
+    };
+
+    // One worker's output during AddStrokes.
+    struct Arena
+    {
+        RoadDecalMesh mesh;         // Every stroke this worker tessellated, indices relative to each stroke.
+        RoadDecalMesh scratch;
+    };
+
+    struct ArenaRange
+    {
+        unsigned worker = 0;
+        uint32_t firstVertex = 0;
+        uint32_t vertexCount = 0;
+        uint32_t firstIndex = 0;
+        uint32_t indexCount = 0;
+    };
+
+    void Store(Entry& entry, const RoadDecalVertex* vertices, uint32_t vertexCount, const uint16_t* indices,
+               uint32_t indexCount);
+    void Place(const RoadMarkupStroke& stroke, Entry& entry);
+    [[nodiscard]] uint64_t ChunkKeyOf(const RoadDecalPoint& point) const;
+    size_t ChunkIndexFor(uint64_t key);
+    static void TruncateChunk(RoadDecalChunk& chunk, size_t vertexCount, size_t indexCount);
+    static void AppendToChunk(RoadDecalChunk& chunk, const RoadDecalVertex* vertices, uint32_t vertexCount,
+                              const uint16_t* indices, uint32_t indexCount);
+    Range Allocate(uint32_t vertexCount, uint32_t indexCount);
+    void Free(const Range& range);
+    void CompactIfFragmented();
+
+    float invChunkSize_;
+    std::vector<Page> pages_{};
+    size_t deadVertices_ = 0;
+    std::unordered_map<uint64_t, Entry> entries_{};
+
+    std::vector<RoadDecalChunk> chunks_{};
+    std::vector<CullBox> chunkBounds_{};
+    std::vector<ChunkLayout> layouts_{};
+    std::unordered_map<uint64_t, size_t> chunkIndex_{};
+
+    RoadDecalMesh scratch_{};
+    std::vector<Entry*> batchEntries_{};    // AddStrokes: entry of each stroke, null if skipped.
+    std::vector<size_t> misses_{};
+    std::vector<Arena> arenas_{};
+    std::vector<ArenaRange> arenaRanges_{};  // Parallel to misses_.
+    uint64_t environmentKey_ = 0;
+    uint32_t rebuild_ = 0;
+    uint32_t version_ = 0;
+    uint64_t nextSerial_ = 0;
+    RoadDecalGeometryCacheStats stats_{};
+};
+
+// 64-bit hash of every stroke field that affects its geometry.
+uint64_t HashRoadMarkupStroke(const RoadMarkupStroke& stroke);
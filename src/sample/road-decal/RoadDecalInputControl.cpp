@@ -92,6 +92,7 @@ RoadDecalInputControl::RoadDecalInputControl()
     , autoAlign_(true)
     , color_(GetRoadMarkupProperties(RoadMarkupType::SolidWhiteLine).defaultColor)
     , onCancel_()
+    , cameraService_(nullptr)
 {
 }
 
@@ -194,7 +195,6 @@ bool RoadDecalInputControl::OnMouseDownR(int32_t, int32_t, uint32_t)
         EndStroke_(true);
     } else {
         ClearAllStrokes_();
-        RebuildRoadDecalGeometry();
         RequestFullRedraw_();
     }
     return true;
@@ -226,8 +226,13 @@ bool RoadDecalInputControl::OnKeyDown(int32_t vkCode, uint32_t modifiers)
     }
 
     if (vkCode == 'Z' && IsCtrlModifierActive(modifiers)) {
-        UndoLastStroke_();
-        RebuildRoadDecalGeometry();
+        UndoLastEdit_();
+        RequestFullRedraw_();
+        return true;
+    }
+
+    if (vkCode == 'Y' && IsCtrlModifierActive(modifiers)) {
+        RedoLastEdit_();
         RequestFullRedraw_();
         return true;
     }
@@ -239,7 +244,6 @@ bool RoadDecalInputControl::OnKeyDown(int32_t vkCode, uint32_t modifiers)
             CancelStroke_();
             ClearAllStrokes_();
         }
-        RebuildRoadDecalGeometry();
         RequestFullRedraw_();
         return true;
     }
@@ -318,13 +322,24 @@ void RoadDecalInputControl::SetOnCancel(std::function<void()> onCancel)
     onCancel_ = std::move(onCancel);
 }
 
+void RoadDecalInputControl::SetCameraService(cIGZS3DCameraService* cameraService)
+{
+    cameraService_ = cameraService;
+}
+
 bool RoadDecalInputControl::PickWorld_(int32_t screenX, int32_t screenZ, RoadDecalPoint& outPoint)
 {
     if (!view3D) {
         return false;
     }
     float worldCoords[3] = {0.0f, 0.0f, 0.0f};
-    if (!view3D->PickTerrain(screenX, screenZ, worldCoords, false)) {
+    S3DTerrainPick pick{};
+    const S3DCameraHandle camera = cameraService_ ? cameraService_->WrapActiveRendererCamera()
+                                                  : S3DCameraHandle{nullptr, 0, false};
+    if (camera.ptr && cameraService_->PickTerrain(camera, screenX, screenZ, pick)) {
+        std::copy(pick.position, pick.position + 3, worldCoords);
+    }
+    else if (!view3D->PickTerrain(screenX, screenZ, worldCoords, false)) {
         return false;
     }
     outPoint.x = SnapToSubgrid(worldCoords[0]);
@@ -439,7 +454,6 @@ bool RoadDecalInputControl::EndStroke_(bool commit)
         const bool valid = singlePoint ? !currentStroke_.points.empty() : currentStroke_.points.size() >= 2;
         if (valid) {
             AddRoadMarkupStrokeToActiveLayer(currentStroke_);
-            RebuildRoadDecalGeometry();
         }
     }
 
@@ -607,9 +621,14 @@ void RoadDecalInputControl::RequestFullRedraw_()
     return;
 }
 
-void RoadDecalInputControl::UndoLastStroke_()
+void RoadDecalInputControl::UndoLastEdit_()
+{
+    UndoRoadMarkupEdit();
+}
+
+void RoadDecalInputControl::RedoLastEdit_()
 {
-    UndoLastRoadMarkupStroke();
+    RedoRoadMarkupEdit();
 }
 
 void RoadDecalInputControl::ClearAllStrokes_()
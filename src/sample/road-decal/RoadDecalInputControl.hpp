@@ -2,6 +2,7 @@
 
 #include "RoadDecalData.hpp"
 #include "cSC4BaseViewInputControl.h"
+#include "public/cIGZS3DCameraService.h"
 
 #include <cstdint>
 #include <functional>
@@ -38,6 +39,7 @@ public:
     void SetColor(uint32_t color);
     void SetOnRotationChanged(std::function<void(float)> onRotationChanged);
     void SetOnCancel(std::function<void()> onCancel);
+    void SetCameraService(cIGZS3DCameraService* cameraService);
 
 private:
     bool BeginStroke_(int32_t screenX, int32_t screenZ, uint32_t modifiers);
@@ -53,7 +55,8 @@ private:
     void RefreshActiveStroke_();
     void RefreshRotationPreview_();
     void RequestFullRedraw_();
-    void UndoLastStroke_();
+    void UndoLastEdit_();
+    void RedoLastEdit_();
     void ClearAllStrokes_();
 
 private:
@@ -80,4 +83,5 @@ private:
     std::function<void(float)> onRotationChanged_;
 
     std::function<void()> onCancel_;
+    cIGZS3DCameraService* cameraService_;
 };
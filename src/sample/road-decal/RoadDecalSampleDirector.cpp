@@ -4,8 +4,12 @@
 #include "imgui.h"
 #include "public/ImGuiPanelAdapter.h"
 #include "public/ImGuiServiceIds.h"
+#include "public/S3DCameraServiceIds.h"
+#include "public/TerrainServiceIds.h"
 #include "public/cIGZDrawService.h"
 #include "public/cIGZImGuiService.h"
+#include "public/cIGZS3DCameraService.h"
+#include "public/cIGZTerrainService.h"
 #include "sample/road-decal/RoadDecalData.hpp"
 #include "sample/road-decal/RoadDecalInputControl.hpp"
 #include "utils/Logger.h"
@@ -21,6 +25,8 @@ namespace
     constexpr uint32_t kRoadDecalPanelId = 0x9B4A7A11;
 
     RoadDecalInputControl* gRoadDecalTool = nullptr;
+    cIGZS3DCameraService* gCameraService = nullptr;
+    cIGZTerrainService* gTerrainService = nullptr;
     std::atomic<bool> gRoadDecalToolEnabled{false};
 
     RoadMarkupType gSelectedType = RoadMarkupType::SolidWhiteLine;
@@ -37,6 +43,7 @@ namespace
     float gEditMoveStep = 2.0f;
     float gEditRotateStepDeg = 15.0f;
     char gSavePath[260] = "road_markups.dat";
+    constexpr const char* kAutosavePath = "road_markups_autosave.dat";
 
     ImVec4 ColorToImVec4(uint32_t argb)
     {
@@ -94,6 +101,7 @@ namespace
                 gRotationDeg = radians * 180.0f / 3.1415926f;
             });
             gRoadDecalTool->SetOnCancel([]() {});
+            gRoadDecalTool->SetCameraService(gCameraService);
             gRoadDecalTool->Activate();
         }
         SyncToolSettings();
@@ -335,34 +343,24 @@ namespace
                 }
                 if (gActiveLayerIndex >= 0 && gActiveLayerIndex < static_cast<int>(gRoadMarkupLayers.size())) {
                     ImGui::SameLine();
-                    if (ImGui::Button("Up") && gActiveLayerIndex > 0) {
-                        std::swap(gRoadMarkupLayers[gActiveLayerIndex], gRoadMarkupLayers[gActiveLayerIndex - 1]);
-                        --gActiveLayerIndex;
-                        for (size_t i = 0; i < gRoadMarkupLayers.size(); ++i) {
-                            gRoadMarkupLayers[i].renderOrder = static_cast<int>(i);
-                        }
-                        RebuildRoadDecalGeometry();
+                    if (ImGui::Button("Up")) {
+                        MoveActiveRoadMarkupLayer(-1);
                     }
                     ImGui::SameLine();
-                    if (ImGui::Button("Down") && gActiveLayerIndex + 1 < static_cast<int>(gRoadMarkupLayers.size())) {
-                        std::swap(gRoadMarkupLayers[gActiveLayerIndex], gRoadMarkupLayers[gActiveLayerIndex + 1]);
-                        ++gActiveLayerIndex;
-                        for (size_t i = 0; i < gRoadMarkupLayers.size(); ++i) {
-                            gRoadMarkupLayers[i].renderOrder = static_cast<int>(i);
-                        }
-                        RebuildRoadDecalGeometry();
+                    if (ImGui::Button("Down")) {
+                        MoveActiveRoadMarkupLayer(1);
                     }
                 }
             }
 
             ImGui::Separator();
             if (ImGui::CollapsingHeader("Selection / Edit", ImGuiTreeNodeFlags_DefaultOpen)) {
-                RoadMarkupStroke* selectedStroke = GetSelectedRoadMarkupStroke();
-                if (!selectedStroke) {
+                RoadMarkupStroke selectedStroke;
+                if (!GetSelectedRoadMarkupStroke(selectedStroke)) {
                     ImGui::TextUnformatted("Ctrl+LMB on a marking to select it.");
                 } else {
-                    ImGui::Text("Selected Layer: %d  Stroke: %d", gSelectedLayerIndex + 1, gSelectedStrokeIndex + 1);
-                    ImGui::Text("Type: %s", GetRoadMarkupProperties(selectedStroke->type).displayName);
+                    ImGui::Text("Selected Stroke: #%u", selectedStroke.id);
+                    ImGui::Text("Type: %s", GetRoadMarkupProperties(selectedStroke.type).displayName);
 
                     ImGui::SliderFloat("Move Step", &gEditMoveStep, 0.25f, 8.0f, "%.2f m");
                     ImGui::SliderFloat("Rotate Step", &gEditRotateStepDeg, 1.0f, 90.0f, "%.0f deg");
@@ -391,6 +389,20 @@ namespace
                         RotateSelectedRoadMarkupStroke(gEditRotateStepDeg * 3.1415926f / 180.0f);
                     }
                     ImGui::SameLine();
+                    if (ImGui::Button("Apply Style")) {
+                        RoadMarkupStrokeStyle style;
+                        style.width = gWidth;
+                        style.length = gLength;
+                        style.dashed = gDashed;
+                        style.dashLength = gDashLength;
+                        style.gapLength = gGapLength;
+                        style.color = gUseTypeDefaultColor ? GetRoadMarkupProperties(selectedStroke.type).defaultColor
+                                                           : gCustomColor;
+                        style.opacity = selectedStroke.opacity;
+                        style.visible = selectedStroke.visible;
+                        SetSelectedRoadMarkupStrokeStyle(style);
+                    }
+                    ImGui::SameLine();
                     if (ImGui::Button("Delete Selected")) {
                         DeleteSelectedRoadMarkupStroke();
                     }
@@ -402,18 +414,25 @@ namespace
             }
 
             ImGui::Separator();
+            ImGui::BeginDisabled(!CanUndoRoadMarkupEdit());
             if (ImGui::Button("Undo")) {
-                UndoLastRoadMarkupStroke();
-                RebuildRoadDecalGeometry();
+                UndoRoadMarkupEdit();
+            }
+            ImGui::EndDisabled();
+            ImGui::SameLine();
+            ImGui::BeginDisabled(!CanRedoRoadMarkupEdit());
+            if (ImGui::Button("Redo")) {
+                RedoRoadMarkupEdit();
             }
+            ImGui::EndDisabled();
             ImGui::SameLine();
             if (ImGui::Button("Clear All")) {
                 ClearAllRoadMarkupStrokes();
-                RebuildRoadDecalGeometry();
             }
 
             if (ImGui::CollapsingHeader("Persistence")) {
-                ImGui::TextUnformatted("Format: cIGZSerializable stream (POC)");
+                ImGui::TextUnformatted("Format: chunked v2 (v1 files still load)");
+                ImGui::Text("Autosave: %s", kAutosavePath);
                 ImGui::InputText("File", gSavePath, sizeof(gSavePath));
                 if (ImGui::Button("Save")) {
                     SaveMarkupsToFile(gSavePath);
@@ -426,7 +445,7 @@ namespace
 
             ImGui::Text("Markings: %u", static_cast<uint32_t>(GetTotalRoadMarkupStrokeCount()));
             ImGui::TextUnformatted("LMB: place/draw  Ctrl+LMB: select  RMB: finish/clear  Del: delete selected/all");
-            ImGui::TextUnformatted("ESC: cancel  Ctrl+Z: undo");
+            ImGui::TextUnformatted("ESC: cancel  Ctrl+Z: undo  Ctrl+Y: redo");
 
             SyncToolSettings();
             ImGui::End();
@@ -478,6 +497,32 @@ public:
         panelRegistered_ = true;
         gImGuiServiceForD3DOverlay.store(imguiService_, std::memory_order_release);
 
+        // Optional: picking falls back to the game's ray cast and drawing skips culling without it.
+        if (mpFrameWork->GetSystemService(kS3DCameraServiceID,
+                                          GZIID_cIGZS3DCameraService,
+                                          reinterpret_cast<void**>(&gCameraService))) {
+            if (gRoadDecalTool) {
+                gRoadDecalTool->SetCameraService(gCameraService);
+            }
+            SetRoadDecalCameraService(gCameraService);
+        }
+        else {
+            LOG_WARN("RoadMarkup: camera service not available, using game terrain picking");
+        }
+
+        // Optional: conforming falls back to per-point terrain queries without it.
+        if (mpFrameWork->GetSystemService(kTerrainServiceID,
+                                          GZIID_cIGZTerrainService,
+                                          reinterpret_cast<void**>(&gTerrainService))) {
+            SetRoadDecalTerrainService(gTerrainService);
+        }
+        else {
+            LOG_WARN("RoadMarkup: terrain service not available, sampling the game terrain directly");
+        }
+
+        // Brings back what a crashed session left unsaved, then keeps the autosave current.
+        StartRoadMarkupAutosave(kAutosavePath);
+
         if (!mpFrameWork->GetSystemService(kDrawServiceID,
                                            GZIID_cIGZDrawService,
                                            reinterpret_cast<void**>(&drawService_))) {
@@ -485,6 +530,7 @@ public:
             return true;
         }
 
+        SetRoadDecalDrawService(drawService_);
         drawService_->RegisterDrawPassCallback(DrawServicePass::PreDynamic,
                                                &DrawPassRoadDecalCallback,
                                                nullptr,
@@ -499,13 +545,27 @@ public:
                 drawService_->UnregisterDrawPassCallback(drawPassCallbackToken_);
                 drawPassCallbackToken_ = 0;
             }
+            SetRoadDecalDrawService(nullptr);
             drawService_->Release();
             drawService_ = nullptr;
         }
 
         DestroyRoadDecalTool();
+        StopRoadMarkupAutosave();
         gImGuiServiceForD3DOverlay.store(nullptr, std::memory_order_release);
 
+        if (gCameraService) {
+            SetRoadDecalCameraService(nullptr);
+            gCameraService->Release();
+            gCameraService = nullptr;
+        }
+
+        if (gTerrainService) {
+            SetRoadDecalTerrainService(nullptr);
+            gTerrainService->Release();
+            gTerrainService = nullptr;
+        }
+
         if (imguiService_) {
             imguiService_->UnregisterPanel(kRoadDecalPanelId);
             imguiService_->Release();
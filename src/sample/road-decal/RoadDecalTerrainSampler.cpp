@@ -0,0 +1,194 @@
+#include "RoadDecalTerrainSampler.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+namespace
+{
+    uint64_t VertexKey(const int32_t x, const int32_t z)
+    {
+        return (static_cast<uint64_t>(static_cast<uint32_t>(x)) << 32) | static_cast<uint32_t>(z);
+    }
+}
+
+void RoadDecalTerrainSampler::BeginSnapshot(const TerrainHeightfieldView& view)
+{
+    End();
+    mode_ = Mode::Snapshot;
+    view_ = view;
+}
+
+void RoadDecalTerrainSampler::BeginQueries(const AltitudeFn altitudeAt, void* userData, const float gridSpacing)
+{
+    End();
+    if (!altitudeAt || gridSpacing <= 0.0f) {
+        return;
+    }
+    mode_ = Mode::Queries;
+    altitudeAt_ = altitudeAt;
+    userData_ = userData;
+    gridSpacing_ = gridSpacing;
+}
+
+void RoadDecalTerrainSampler::End()
+{
+    mode_ = Mode::None;
+    view_ = {};
+    altitudeAt_ = nullptr;
+    userData_ = nullptr;
+    vertexHeights_.clear();
+    stats_ = {};
+}
+
+void RoadDecalTerrainSampler::Conform(RoadDecalPoint* points, const size_t count, const float yOffset)
+{
+    if (count == 0) {
+        return;
+    }
+    stats_.points += count;
+
+    if (mode_ == Mode::Snapshot) {
+        SampleHeightfieldBatch(view_, &points->x, count, sizeof(RoadDecalPoint), yOffset);
+        return;
+    }
+    if (mode_ != Mode::Queries) {
+        return;
+    }
+
+    // Same cell choice and blend as a direct per-point query, so cached and uncached heights match exactly. Points
+    // along a path mostly stay in the cell of the one before, so the corners are only looked up on a change of cell.
+    int32_t lastX = 0;
+    int32_t lastZ = 0;
+    bool haveCell = false;
+    float h00 = 0.0f;
+    float h10 = 0.0f;
+    float h01 = 0.0f;
+    float h11 = 0.0f;
+    for (size_t i = 0; i < count; ++i) {
+        RoadDecalPoint& p = points[i];
+        const float cellX = std::floor(p.x / gridSpacing_);
+        const float cellZ = std::floor(p.z / gridSpacing_);
+        const float x0 = cellX * gridSpacing_;
+        const float z0 = cellZ * gridSpacing_;
+        const float tx = std::clamp((p.x - x0) / gridSpacing_, 0.0f, 1.0f);
+        const float tz = std::clamp((p.z - z0) / gridSpacing_, 0.0f, 1.0f);
+
+        const auto ix = static_cast<int32_t>(cellX);
+        const auto iz = static_cast<int32_t>(cellZ);
+        if (!haveCell || ix != lastX || iz != lastZ) {
+            h00 = VertexHeight(ix, iz);
+            h10 = VertexHeight(ix + 1, iz);
+            h01 = VertexHeight(ix, iz + 1);
+            h11 = VertexHeight(ix + 1, iz + 1);
+            lastX = ix;
+            lastZ = iz;
+            haveCell = true;
+        }
+        const float hx0 = h00 + (h10 - h00) * tx;
+        const float hx1 = h01 + (h11 - h01) * tx;
+        p.y = hx0 + (hx1 - hx0) * tz + yOffset;
+    }
+}
+
+float RoadDecalTerrainSampler::VertexHeight(const int32_t cellX, const int32_t cellZ)
+{
+    const auto [it, inserted] = vertexHeights_.try_emplace(VertexKey(cellX, cellZ), 0.0f);
+    if (inserted) {
+        it->second = altitudeAt_(static_cast<float>(cellX) * gridSpacing_, static_cast<float>(cellZ) * gridSpacing_,
+                                 userData_);
+        ++stats_.altitudeQueries;
+    }
+    return it->second;
+}
+
+bool RoadDecalTerrainSnapshot::Update(const TerrainHeightfieldView& view, const float regionSize)
+{
+    const bool comparable = !heights_.empty() && view.verticesX == verticesX_ && view.verticesZ == verticesZ_ &&
+                            view.gridSpacing == gridSpacing_ && regionSize == regionSize_;
+
+    if (!comparable) {
+        verticesX_ = view.verticesX;
+        verticesZ_ = view.verticesZ;
+        gridSpacing_ = view.gridSpacing;
+        regionSize_ = (std::max)(regionSize, gridSpacing_);
+        const float extentX = static_cast<float>(verticesX_ > 0 ? verticesX_ - 1 : 0) * gridSpacing_;
+        const float extentZ = static_cast<float>(verticesZ_ > 0 ? verticesZ_ - 1 : 0) * gridSpacing_;
+        regionsX_ = static_cast<uint32_t>(std::floor(extentX / regionSize_)) + 1;
+        regionsZ_ = static_cast<uint32_t>(std::floor(extentZ / regionSize_)) + 1;
+        heights_.resize(static_cast<size_t>(verticesX_) * verticesZ_);
+    }
+    changed_.assign(static_cast<size_t>(regionsX_) * regionsZ_, comparable ? 0 : 1);
+    changedCount_ = comparable ? 0 : changed_.size();
+
+    // Compare row by row and only look at single vertices in rows that differ.
+    for (uint32_t z = 0; z < verticesZ_; ++z) {
+        const float* row = view.heights + static_cast<size_t>(z) * view.rowStride;
+        float* stored = heights_.data() + static_cast<size_t>(z) * verticesX_;
+        if (comparable && std::memcmp(row, stored, verticesX_ * sizeof(float)) != 0) {
+            for (uint32_t x = 0; x < verticesX_; ++x) {
+                if (row[x] != stored[x]) {
+                    MarkAround(x, z);
+                }
+            }
+        }
+        std::memcpy(stored, row, verticesX_ * sizeof(float));
+    }
+    version_ = view.version;
+    return comparable;
+}
+
+void RoadDecalTerrainSnapshot::Clear()
+{
+    heights_.clear();
+    verticesX_ = 0;
+    verticesZ_ = 0;
+    version_ = 0;
+    changed_.clear();
+    changedCount_ = 0;
+}
+
+bool RoadDecalTerrainSnapshot::Overlaps(const CullBox& box) const
+{
+    if (changedCount_ == 0) {
+        return false;
+    }
+    // Points off the grid sample its border, so clamp to the edge regions rather than skipping them.
+    const auto regionOf = [&](const float v, const uint32_t regions) {
+        const float r = std::floor(v / regionSize_);
+        return static_cast<uint32_t>(std::clamp(r, 0.0f, static_cast<float>(regions - 1)));
+    };
+    const uint32_t x0 = regionOf(box.minX, regionsX_);
+    const uint32_t x1 = regionOf(box.maxX, regionsX_);
+    const uint32_t z0 = regionOf(box.minZ, regionsZ_);
+    const uint32_t z1 = regionOf(box.maxZ, regionsZ_);
+    for (uint32_t z = z0; z <= z1; ++z) {
+        for (uint32_t x = x0; x <= x1; ++x) {
+            if (changed_[static_cast<size_t>(z) * regionsX_ + x]) {
+                return true;
+            }
+        }
+    }
+    return false;
+}
+
+void RoadDecalTerrainSnapshot::MarkAround(const uint32_t vertexX, const uint32_t vertexZ)
+{
+    // A vertex shapes the four cells around it.
+    const float wx = static_cast<float>(vertexX) * gridSpacing_;
+    const float wz = static_cast<float>(vertexZ) * gridSpacing_;
+    const auto regionOf = [&](const float v, const uint32_t regions) {
+        return static_cast<uint32_t>(std::clamp(std::floor(v / regionSize_), 0.0f, static_cast<float>(regions - 1)));
+    };
+    const uint32_t x0 = regionOf(wx - gridSpacing_, regionsX_);
+    const uint32_t x1 = regionOf(wx + gridSpacing_, regionsX_);
+    const uint32_t z0 = regionOf(wz - gridSpacing_, regionsZ_);
+    const uint32_t z1 = regionOf(wz + gridSpacing_, regionsZ_);
+    for (uint32_t z = z0; z <= z1; ++z) {
+        for (uint32_t x = x0; x <= x1; ++x) {
+            uint8_t& flag = changed_[static_cast<size_t>(z) * regionsX_ + x];
+            changedCount_ += flag == 0;
+            flag = 1;
+        }
+    }
+}
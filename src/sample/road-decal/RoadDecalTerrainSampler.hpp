@@ -0,0 +1,107 @@
+#pragma once
+
+#include "RoadDecalData.hpp"
+#include "public/TerrainHeightfield.h"
+#include "public/ViewFrustum.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+// Terrain heights for conforming road decals, sampled once per pass instead of once per point.
+//
+// A pass covers one batch of conforming, typically a whole rebuild. With a heightfield snapshot the sampler reads the
+// pinned grid with the SSE2 batch sampler. Without one it falls back to a per-vertex altitude query (the game's
+// GetAltitudeAtNearestGrid) and remembers every grid vertex it fetched until the pass ends, so neighbouring points on
+// the same cells share their four corner queries. Both paths give the same bilinear surface.
+//
+// Example usage:
+//   RoadDecalTerrainSampler sampler;
+//   sampler.BeginSnapshot(view);                  // or BeginQueries(&AltitudeAt, terrain, 16.0f)
+//   sampler.Conform(points.data(), points.size(), 0.05f);
+//   sampler.End();
+//
+
+struct RoadDecalTerrainSamplerStats
+{
+    size_t points = 0;              // Conformed in the current pass.
+    size_t altitudeQueries = 0;     // Calls to the altitude function in the current pass.
+};
+
+class RoadDecalTerrainSampler
+{
+public:
+    // Altitude of the grid vertex nearest to (x, z).
+    using AltitudeFn = float (*)(float x, float z, void* userData);
+
+    // The view must stay pinned until End.
+    void BeginSnapshot(const TerrainHeightfieldView& view);
+    void BeginQueries(AltitudeFn altitudeAt, void* userData, float gridSpacing);
+    void End();
+
+    [[nodiscard]] bool Active() const { return mode_ != Mode::None; }
+    [[nodiscard]] const RoadDecalTerrainSamplerStats& Stats() const { return stats_; }
+
+    // Sets y of every point to the terrain height plus yOffset. Does nothing outside a pass.
+    void Conform(RoadDecalPoint* points, size_t count, float yOffset);
+
+private:
+    enum class Mode
+    {
+        None,
+        Snapshot,
+        Queries
+    };
+
+    float VertexHeight(int32_t cellX, int32_t cellZ);
+
+    Mode mode_ = Mode::None;
+    TerrainHeightfieldView view_{};
+    AltitudeFn altitudeAt_ = nullptr;
+    void* userData_ = nullptr;
+    float gridSpacing_ = 16.0f;
+    std::unordered_map<uint64_t, float> vertexHeights_{};
+    RoadDecalTerrainSamplerStats stats_{};
+};
+
+// The heights committed decals were last conformed to, kept to find where a newer heightfield differs.
+//
+// Update compares a view with the stored copy and marks the square regions whose surface changed: every region within
+// one grid cell of a vertex whose height moved, since bilinear sampling reads that far. Strokes whose bounds miss all
+// marked regions keep their conformed geometry.
+//
+// Example usage:
+//   if (view.version != snapshot.Version() && snapshot.Update(view, 64.0f)) {
+//       cache.InvalidateWhere(oldVersion, view.version, &ChangedUnder, &snapshot);
+//   }
+//
+class RoadDecalTerrainSnapshot
+{
+public:
+    // Marks what changed since the stored copy, then stores view. Returns false if there was nothing to compare
+    // against (first use, or the grid size changed); treat everything as changed then.
+    bool Update(const TerrainHeightfieldView& view, float regionSize);
+    void Clear();
+
+    [[nodiscard]] uint32_t Version() const { return version_; }
+    // True if the XZ extent of box touches a region marked by the last Update.
+    [[nodiscard]] bool Overlaps(const CullBox& box) const;
+    [[nodiscard]] size_t ChangedRegionCount() const { return changedCount_; }
+    [[nodiscard]] size_t RegionCount() const { return changed_.size(); }
+
+private:
+    void MarkAround(uint32_t vertexX, uint32_t vertexZ);
+
+    std::vector<float> heights_{};      // verticesZ_ rows of verticesX_, tightly packed.
+    uint32_t verticesX_ = 0;
+    uint32_t verticesZ_ = 0;
+    float gridSpacing_ = 0.0f;
+    uint32_t version_ = 0;
+
+    float regionSize_ = 64.0f;
+    uint32_t regionsX_ = 0;
+    uint32_t regionsZ_ = 0;
+    std::vector<uint8_t> changed_{};
+    size_t changedCount_ = 0;
+};
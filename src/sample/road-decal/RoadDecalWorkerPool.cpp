@@ -0,0 +1,131 @@
+#include "RoadDecalWorkerPool.hpp"
+
+#include <algorithm>
+
+namespace
+{
+    constexpr unsigned kMaxWorkers = 8;
+    // Items taken per grab: enough to keep the shared counters cool, few enough to balance uneven strokes.
+    constexpr size_t kGrabsPerBlock = 16;
+}
+
+RoadDecalWorkerPool::~RoadDecalWorkerPool()
+{
+    Stop();
+}
+
+unsigned RoadDecalWorkerPool::DefaultWorkerCount()
+{
+    return std::clamp(std::thread::hardware_concurrency(), 1u, kMaxWorkers);
+}
+
+void RoadDecalWorkerPool::Start(const unsigned workerCount)
+{
+    if (workers_ > 0) {
+        return;
+    }
+    workers_ = std::clamp(workerCount, 1u, kMaxWorkers);
+    blocks_ = std::make_unique<Block[]>(workers_);
+    stopRequested_ = false;
+    for (unsigned worker = 1; worker < workers_; ++worker) {
+        threads_.emplace_back(&RoadDecalWorkerPool::WorkerLoop, this, worker);
+    }
+}
+
+void RoadDecalWorkerPool::Stop()
+{
+    if (workers_ == 0) {
+        return;
+    }
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stopRequested_ = true;
+    }
+    wake_.notify_all();
+    for (auto& thread : threads_) {
+        if (thread.joinable()) {
+            thread.join();
+        }
+    }
+    threads_.clear();
+    blocks_.reset();
+    workers_ = 0;
+}
+
+void RoadDecalWorkerPool::Run(const size_t count, const Job& job)
+{
+    if (count == 0) {
+        return;
+    }
+    if (workers_ <= 1) {
+        for (size_t item = 0; item < count; ++item) {
+            job(0, item);
+        }
+        return;
+    }
+
+    // Contiguous blocks, one per worker.
+    for (unsigned worker = 0; worker < workers_; ++worker) {
+        blocks_[worker].next.store(count * worker / workers_, std::memory_order_relaxed);
+        blocks_[worker].end = count * (worker + 1) / workers_;
+    }
+    grain_ = (std::max)(size_t{1}, count / (static_cast<size_t>(workers_) * kGrabsPerBlock));
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        job_ = &job;
+        busy_ = workers_ - 1;
+        ++generation_;
+    }
+    wake_.notify_all();
+
+    Drain(0);
+
+    std::unique_lock<std::mutex> lock(mutex_);
+    done_.wait(lock, [this] { return busy_ == 0; });
+    job_ = nullptr;
+}
+
+void RoadDecalWorkerPool::WorkerLoop(const unsigned worker)
+{
+    size_t seen = 0;
+    for (;;) {
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            wake_.wait(lock, [&] { return stopRequested_ || generation_ != seen; });
+            if (stopRequested_) {
+                return;
+            }
+            seen = generation_;
+        }
+
+        Drain(worker);
+
+        bool last = false;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            last = --busy_ == 0;
+        }
+        if (last) {
+            done_.notify_one();
+        }
+    }
+}
+
+void RoadDecalWorkerPool::Drain(const unsigned worker)
+{
+    const Job& job = *job_;
+    // Own block first, then the others in turn.
+    for (unsigned k = 0; k < workers_; ++k) {
+        Block& block = blocks_[(worker + k) % workers_];
+        for (;;) {
+            const size_t first = block.next.fetch_add(grain_, std::memory_order_relaxed);
+            if (first >= block.end) {
+                break;
+            }
+            const size_t last = (std::min)(first + grain_, block.end);
+            for (size_t item = first; item < last; ++item) {
+                job(worker, item);
+            }
+        }
+    }
+}
@@ -0,0 +1,77 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// A few worker threads that split one batch of independent items with the calling thread, for rebuilds too large to
+// tessellate on one core.
+//
+// Run hands every worker a contiguous block of the items. A worker takes items from its own block a few at a time, and
+// once that is empty takes from the other blocks, so a block of expensive strokes does not hold up the batch. Each
+// call of the job learns which worker runs it, so it can write into that worker's own arena without locking. Run
+// returns once every item is done. Which worker ran an item changes from run to run; results must only depend on the
+// item.
+//
+// Example usage:
+//   RoadDecalWorkerPool pool;
+//   pool.Start(RoadDecalWorkerPool::DefaultWorkerCount());
+//   std::vector<RoadDecalMesh> arenas(pool.Workers());
+//   pool.Run(strokes.size(), [&](unsigned worker, size_t item) { Tessellate(strokes[item], arenas[worker]); });
+//   pool.Stop();
+//
+
+class RoadDecalWorkerPool
+{
+public:
+    using Job = std::function<void(unsigned worker, size_t item)>;
+
+    RoadDecalWorkerPool() = default;
+    ~RoadDecalWorkerPool();
+
+    RoadDecalWorkerPool(const RoadDecalWorkerPool&) = delete;
+    RoadDecalWorkerPool& operator=(const RoadDecalWorkerPool&) = delete;
+
+    // Hardware threads, at most 8.
+    static unsigned DefaultWorkerCount();
+
+    // Starts workerCount - 1 threads; the thread calling Run is worker 0. Does nothing if already started.
+    void Start(unsigned workerCount);
+    // Joins the threads. Must not be called during Run.
+    void Stop();
+
+    [[nodiscard]] bool Started() const { return workers_ > 0; }
+    // Workers including the calling thread, 1 when not started.
+    [[nodiscard]] unsigned Workers() const { return workers_ > 0 ? workers_ : 1; }
+
+    // Runs job for every item in [0, count), spread over all workers, and returns when all are done. Not reentrant.
+    void Run(size_t count, const Job& job);
+
+private:
+    struct alignas(64) Block
+    {
+        std::atomic<size_t> next{0};
+        size_t end = 0;
+    };
+
+    void WorkerLoop(unsigned worker);
+    void Drain(unsigned worker);
+
+    unsigned workers_ = 0;
+    std::vector<std::thread> threads_{};
+    std::unique_ptr<Block[]> blocks_{};
+    const Job* job_ = nullptr;
+    size_t grain_ = 1;
+
+    std::mutex mutex_{};
+    std::condition_variable wake_{};
+    std::condition_variable done_{};
+    size_t generation_ = 0;
+    unsigned busy_ = 0;
+    bool stopRequested_ = false;
+};
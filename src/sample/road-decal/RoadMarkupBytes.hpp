@@ -0,0 +1,111 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+
+// Byte-level encoding shared by the markup file (RoadMarkupFile) and the edit journal (RoadMarkupJournal): the stroke
+// flag bits, LEB128 varints, and a bounds-checked little-endian reader. Both formats are only ever written and read on
+// x86, so values are copied as they are in memory.
+//
+// Example usage:
+//   uint8_t bytes[kRoadMarkupMaxVarintBytes];
+//   const size_t size = static_cast<size_t>(PutRoadMarkupVarint(bytes, count) - bytes);
+//
+//   RoadMarkupByteReader in(bytes, size);
+//   uint32_t decoded = 0;
+//   if (!in.GetVarint32(decoded)) {
+//       return false;
+//   }
+//
+
+constexpr uint8_t kRoadMarkupFlagDashed = 1u << 0;
+constexpr uint8_t kRoadMarkupFlagVisible = 1u << 1;
+constexpr size_t kRoadMarkupMaxVarintBytes = 10;
+
+inline uint8_t MakeRoadMarkupFlags(const bool dashed, const bool visible)
+{
+    return static_cast<uint8_t>((dashed ? kRoadMarkupFlagDashed : 0) | (visible ? kRoadMarkupFlagVisible : 0));
+}
+
+// Writes v at `at`, which must have room for kRoadMarkupMaxVarintBytes, and returns the end of what was written.
+inline uint8_t* PutRoadMarkupVarint(uint8_t* at, uint64_t v)
+{
+    while (v >= 0x80u) {
+        *at++ = static_cast<uint8_t>(v | 0x80u);
+        v >>= 7;
+    }
+    *at++ = static_cast<uint8_t>(v);
+    return at;
+}
+
+// Every read past the end fails and leaves the reader failed.
+class RoadMarkupByteReader
+{
+public:
+    RoadMarkupByteReader(const uint8_t* data, const size_t size)
+        : at_(data), end_(data + size)
+    {
+    }
+
+    template <typename T>
+    bool Get(T& v)
+    {
+        if (static_cast<size_t>(end_ - at_) < sizeof(T)) {
+            return Fail();
+        }
+        std::memcpy(&v, at_, sizeof(T));
+        at_ += sizeof(T);
+        return true;
+    }
+
+    bool GetVarint(uint64_t& v)
+    {
+        v = 0;
+        for (int shift = 0; shift < 64; shift += 7) {
+            if (at_ == end_) {
+                return Fail();
+            }
+            const uint8_t byte = *at_++;
+            v |= static_cast<uint64_t>(byte & 0x7Fu) << shift;
+            if ((byte & 0x80u) == 0) {
+                return true;
+            }
+        }
+        return Fail();
+    }
+
+    bool GetVarint32(uint32_t& v)
+    {
+        uint64_t wide = 0;
+        if (!GetVarint(wide) || wide > (std::numeric_limits<uint32_t>::max)()) {
+            return Fail();
+        }
+        v = static_cast<uint32_t>(wide);
+        return true;
+    }
+
+    const uint8_t* Take(const size_t size)
+    {
+        if (static_cast<size_t>(end_ - at_) < size) {
+            Fail();
+            return nullptr;
+        }
+        const uint8_t* taken = at_;
+        at_ += size;
+        return taken;
+    }
+
+    [[nodiscard]] size_t Remaining() const { return static_cast<size_t>(end_ - at_); }
+
+private:
+    bool Fail()
+    {
+        at_ = end_;
+        return false;
+    }
+
+    const uint8_t* at_;
+    const uint8_t* end_;
+};
@@ -0,0 +1,553 @@
+#include "RoadMarkupFile.hpp"
+#include "RoadMarkupBytes.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstring>
+#include <limits>
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace
+{
+    constexpr size_t kHeaderSize = 12 * sizeof(uint32_t);
+    constexpr size_t kLayerRecordSize = 4 * sizeof(uint32_t) + 2;
+    constexpr size_t kChunkRecordSize = 12 * sizeof(uint32_t);
+    // Every point takes at least one byte per axis, which bounds the point count a chunk can claim.
+    constexpr size_t kMinPointBytes = 3;
+
+    // Slicing-by-4 tables: table k advances the CRC of a byte followed by k zero bytes.
+    constexpr std::array<std::array<uint32_t, 256>, 4> kCrcTables = [] {
+        std::array<std::array<uint32_t, 256>, 4> tables{};
+        for (uint32_t i = 0; i < 256; ++i) {
+            uint32_t c = i;
+            for (int k = 0; k < 8; ++k) {
+                c = (c & 1u) ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+            }
+            tables[0][i] = c;
+        }
+        for (uint32_t i = 0; i < 256; ++i) {
+            for (size_t k = 1; k < 4; ++k) {
+                tables[k][i] = tables[0][tables[k - 1][i] & 0xFFu] ^ (tables[k - 1][i] >> 8);
+            }
+        }
+        return tables;
+    }();
+
+    uint32_t Crc32(const uint8_t* data, size_t size)
+    {
+        uint32_t crc = 0xFFFFFFFFu;
+        for (; size >= 4; data += 4, size -= 4) {
+            uint32_t word = 0;
+            std::memcpy(&word, data, sizeof(word));
+            crc ^= word;
+            crc = kCrcTables[3][crc & 0xFFu] ^ kCrcTables[2][(crc >> 8) & 0xFFu] ^
+                  kCrcTables[1][(crc >> 16) & 0xFFu] ^ kCrcTables[0][crc >> 24];
+        }
+        for (; size > 0; ++data, --size) {
+            crc = kCrcTables[0][(crc ^ *data) & 0xFFu] ^ (crc >> 8);
+        }
+        return ~crc;
+    }
+
+    uint64_t ZigZag(const int64_t v)
+    {
+        return (static_cast<uint64_t>(v) << 1) ^ static_cast<uint64_t>(v >> 63);
+    }
+
+    int64_t UnZigZag(const uint64_t v)
+    {
+        return static_cast<int64_t>(v >> 1) ^ -static_cast<int64_t>(v & 1u);
+    }
+
+    constexpr double kInversePointScale = 1.0 / kRoadMarkupFilePointScale;
+    // Layer, order and type varints, flags, colour, six floats and the point count.
+    constexpr size_t kMaxStrokeBytes = 4 * kRoadMarkupMaxVarintBytes + 1 + 7 * sizeof(uint32_t);
+
+    // Rounds half away from zero; llround is a library call on MSVC and dominates the save otherwise.
+    int32_t Quantize(const float v)
+    {
+        const double scaled = static_cast<double>(v) * kRoadMarkupFilePointScale;
+        return static_cast<int32_t>(scaled < 0.0 ? scaled - 0.5 : scaled + 0.5);
+    }
+
+    float Dequantize(const int64_t q)
+    {
+        return static_cast<float>(static_cast<double>(q) * kInversePointScale);
+    }
+
+    int64_t FloorDiv(const int64_t a, const int64_t b)
+    {
+        const int64_t q = a / b;
+        return (a % b != 0 && (a < 0) != (b < 0)) ? q - 1 : q;
+    }
+
+    // Writes into memory the caller has already sized. Little-endian, as the file is only ever written and read on
+    // x86.
+    class ByteWriter
+    {
+    public:
+        explicit ByteWriter(uint8_t* at)
+            : at_(at)
+        {
+        }
+
+        template <typename T>
+        void Put(const T v)
+        {
+            std::memcpy(at_, &v, sizeof(T));
+            at_ += sizeof(T);
+        }
+
+        void PutVarint(const uint64_t v)
+        {
+            at_ = PutRoadMarkupVarint(at_, v);
+        }
+
+        void PutBytes(const void* data, const size_t size)
+        {
+            std::memcpy(at_, data, size);
+            at_ += size;
+        }
+
+        [[nodiscard]] uint8_t* At() const { return at_; }
+
+    private:
+        uint8_t* at_;
+    };
+
+    void Grow(CullBox& box, const float x, const float y, const float z)
+    {
+        box.minX = (std::min)(box.minX, x);
+        box.minY = (std::min)(box.minY, y);
+        box.minZ = (std::min)(box.minZ, z);
+        box.maxX = (std::max)(box.maxX, x);
+        box.maxY = (std::max)(box.maxY, y);
+        box.maxZ = (std::max)(box.maxZ, z);
+    }
+}
+
+uint32_t ComputeRoadMarkupChecksum(const uint8_t* data, const size_t size)
+{
+    return Crc32(data, size);
+}
+
+uint32_t PeekRoadMarkupFileVersion(const uint8_t* data, const size_t size)
+{
+    RoadMarkupByteReader in(data, size);
+    uint32_t magic = 0;
+    uint32_t version = 0;
+    if (!in.Get(magic) || !in.Get(version) || magic != kRoadMarkupFileMagic) {
+        return 0;
+    }
+    return version;
+}
+
+RoadMarkupFileWriter::RoadMarkupFileWriter(const float tileSize)
+    : tileSize_(tileSize > 0.0f ? tileSize : 128.0f),
+      tileSteps_((std::max)(1, Quantize(tileSize_)))
+{
+}
+
+void RoadMarkupFileWriter::BeginLayer(const RoadMarkupLayer& layer)
+{
+    RoadMarkupLayer& copy = layers_.emplace_back();
+    copy.id = layer.id;
+    copy.name = layer.name;
+    copy.visible = layer.visible;
+    copy.locked = layer.locked;
+    copy.renderOrder = layer.renderOrder;
+}
+
+void RoadMarkupFileWriter::AddStroke(const RoadMarkupStroke& stroke)
+{
+    if (layers_.empty()) {
+        return;
+    }
+    RoadMarkupLayer& layer = layers_.back();
+
+    // The tile comes from the quantized points, so a loaded file saves back to the same chunks.
+    points_.clear();
+    int64_t minX = 0;
+    int64_t maxX = 0;
+    int64_t minZ = 0;
+    int64_t maxZ = 0;
+    for (const RoadDecalPoint& p : stroke.points) {
+        const Point q{Quantize(p.x), Quantize(p.y), Quantize(p.z), p.hardCorner};
+        if (points_.empty()) {
+            minX = maxX = q.x;
+            minZ = maxZ = q.z;
+        }
+        minX = (std::min)(minX, static_cast<int64_t>(q.x));
+        maxX = (std::max)(maxX, static_cast<int64_t>(q.x));
+        minZ = (std::min)(minZ, static_cast<int64_t>(q.z));
+        maxZ = (std::max)(maxZ, static_cast<int64_t>(q.z));
+        points_.push_back(q);
+    }
+    const auto tileX = static_cast<int32_t>(FloorDiv(minX + maxX, 2 * static_cast<int64_t>(tileSteps_)));
+    const auto tileZ = static_cast<int32_t>(FloorDiv(minZ + maxZ, 2 * static_cast<int64_t>(tileSteps_)));
+
+    // Encoded straight into its tile, in the order added: by layer, then draw order.
+    const uint64_t key = static_cast<uint64_t>(static_cast<uint32_t>(tileZ)) << 32 | static_cast<uint32_t>(tileX);
+    const auto [it, inserted] = tileByKey_.try_emplace(key, static_cast<uint32_t>(tiles_.size()));
+    if (inserted) {
+        Tile& created = tiles_.emplace_back();
+        created.tileX = tileX;
+        created.tileZ = tileZ;
+        created.bounds = {std::numeric_limits<float>::max(), std::numeric_limits<float>::max(),
+                          std::numeric_limits<float>::max(), std::numeric_limits<float>::lowest(),
+                          std::numeric_limits<float>::lowest(), std::numeric_limits<float>::lowest()};
+    }
+    Tile& tile = tiles_[it->second];
+    ++tile.strokeCount;
+
+    const size_t start = tile.payload.size();
+    tile.payload.resize(start + kMaxStrokeBytes + points_.size() * 3 * kRoadMarkupMaxVarintBytes);
+    ByteWriter out(tile.payload.data() + start);
+    out.PutVarint(layers_.size() - 1);
+    out.PutVarint(layer.strokeIds.size());
+    out.PutVarint(static_cast<uint32_t>(stroke.type));
+    out.Put(MakeRoadMarkupFlags(stroke.dashed, stroke.visible));
+    out.Put(stroke.color);
+    out.Put(stroke.width);
+    out.Put(stroke.length);
+    out.Put(stroke.rotation);
+    out.Put(stroke.dashLength);
+    out.Put(stroke.gapLength);
+    out.Put(stroke.opacity);
+    out.PutVarint(points_.size());
+
+    int64_t prevX = static_cast<int64_t>(tileX) * tileSteps_;
+    int64_t prevY = 0;
+    int64_t prevZ = static_cast<int64_t>(tileZ) * tileSteps_;
+    for (const Point& q : points_) {
+        // The hard-corner flag rides in the low bit of the x delta.
+        out.PutVarint(ZigZag(q.x - prevX) << 1 | (q.hardCorner ? 1u : 0u));
+        out.PutVarint(ZigZag(q.y - prevY));
+        out.PutVarint(ZigZag(q.z - prevZ));
+        prevX = q.x;
+        prevY = q.y;
+        prevZ = q.z;
+        Grow(tile.bounds, Dequantize(q.x), Dequantize(q.y), Dequantize(q.z));
+    }
+    tile.payload.resize(static_cast<size_t>(out.At() - tile.payload.data()));
+    layer.strokeIds.push_back(0); // Only counted.
+}
+
+void RoadMarkupFileWriter::Finish(const RoadMarkupFileInfo& info, std::vector<uint8_t>& out)
+{
+    std::sort(tiles_.begin(), tiles_.end(), [](const Tile& a, const Tile& b) {
+        return a.tileZ != b.tileZ ? a.tileZ < b.tileZ : a.tileX < b.tileX;
+    });
+
+    size_t tablesSize = tiles_.size() * kChunkRecordSize;
+    size_t strokeCount = 0;
+    for (const RoadMarkupLayer& layer : layers_) {
+        tablesSize += kLayerRecordSize + layer.name.size();
+        strokeCount += layer.strokeIds.size();
+    }
+    size_t fileSize = kHeaderSize + tablesSize;
+    for (const Tile& tile : tiles_) {
+        fileSize += tile.payload.size();
+    }
+
+    out.resize(fileSize);
+    ByteWriter header(out.data());
+    header.Put(kRoadMarkupFileMagic);
+    header.Put(kRoadMarkupFileVersion);
+    header.Put(tileSize_);
+    header.Put(kRoadMarkupFilePointScale);
+    header.Put(static_cast<uint32_t>(layers_.size()));
+    header.Put(static_cast<uint32_t>(tiles_.size()));
+    header.Put(static_cast<uint32_t>(strokeCount));
+    header.Put(info.activeLayerIndex);
+    header.Put(info.selectedLayerIndex);
+    header.Put(info.selectedStrokeIndex);
+    header.Put(static_cast<uint32_t>(tablesSize));
+    header.Put(uint32_t{0}); // Tables checksum, filled in last.
+
+    for (const RoadMarkupLayer& layer : layers_) {
+        header.Put(layer.id);
+        header.Put(static_cast<int32_t>(layer.renderOrder));
+        header.Put(static_cast<uint32_t>(layer.name.size()));
+        header.Put(static_cast<uint32_t>(layer.strokeIds.size()));
+        header.Put(static_cast<uint8_t>(layer.visible ? 1 : 0));
+        header.Put(static_cast<uint8_t>(layer.locked ? 1 : 0));
+        header.PutBytes(layer.name.data(), layer.name.size());
+    }
+
+    ByteWriter payload(out.data() + kHeaderSize + tablesSize);
+    for (Tile& tile : tiles_) {
+        if (tile.bounds.minX > tile.bounds.maxX) {
+            tile.bounds = {}; // Only strokes without points.
+        }
+        const auto offset = static_cast<uint32_t>(payload.At() - out.data());
+        const auto size = static_cast<uint32_t>(tile.payload.size());
+        header.Put(tile.tileX);
+        header.Put(tile.tileZ);
+        header.Put(tile.bounds);
+        header.Put(tile.strokeCount);
+        header.Put(offset);
+        header.Put(size);
+        header.Put(Crc32(tile.payload.data(), size));
+        payload.PutBytes(tile.payload.data(), size);
+    }
+
+    const uint32_t tablesChecksum = Crc32(out.data() + kHeaderSize, tablesSize);
+    std::memcpy(out.data() + kHeaderSize - sizeof(uint32_t), &tablesChecksum, sizeof(tablesChecksum));
+
+    layers_.clear();
+    tiles_.clear();
+    tileByKey_.clear();
+}
+
+bool RoadMarkupFileReader::Open(const uint8_t* data, const size_t size)
+{
+    Close();
+    RoadMarkupByteReader in(data, size);
+    uint32_t magic = 0;
+    uint32_t version = 0;
+    float pointScale = 0.0f;
+    uint32_t layerCount = 0;
+    uint32_t chunkCount = 0;
+    uint32_t strokeCount = 0;
+    uint32_t tablesSize = 0;
+    uint32_t tablesChecksum = 0;
+    if (!in.Get(magic) || !in.Get(version) || !in.Get(tileSize_) || !in.Get(pointScale) || !in.Get(layerCount) ||
+        !in.Get(chunkCount) || !in.Get(strokeCount) || !in.Get(info_.activeLayerIndex) ||
+        !in.Get(info_.selectedLayerIndex) || !in.Get(info_.selectedStrokeIndex) || !in.Get(tablesSize) ||
+        !in.Get(tablesChecksum) || magic != kRoadMarkupFileMagic || version != kRoadMarkupFileVersion ||
+        !(tileSize_ > 0.0f) || pointScale != kRoadMarkupFilePointScale || tablesSize > in.Remaining()) {
+        Close();
+        return false;
+    }
+
+    const uint8_t* tables = in.Take(tablesSize);
+    if (Crc32(tables, tablesSize) != tablesChecksum) {
+        Close();
+        return false;
+    }
+
+    RoadMarkupByteReader table(tables, tablesSize);
+    size_t layerStrokes = 0;
+    layers_.reserve((std::min)(static_cast<size_t>(layerCount), tablesSize / kLayerRecordSize));
+    for (uint32_t i = 0; i < layerCount; ++i) {
+        RoadMarkupLayer& layer = layers_.emplace_back();
+        int32_t renderOrder = 0;
+        uint32_t nameLen = 0;
+        uint32_t layerStrokeCount = 0;
+        uint8_t visible = 0;
+        uint8_t locked = 0;
+        const uint8_t* name = nullptr;
+        if (!table.Get(layer.id) || !table.Get(renderOrder) || !table.Get(nameLen) || !table.Get(layerStrokeCount) ||
+            !table.Get(visible) || !table.Get(locked) || !(name = table.Take(nameLen)) ||
+            layerStrokeCount > strokeCount) {
+            Close();
+            return false;
+        }
+        layer.renderOrder = renderOrder;
+        layer.visible = visible != 0;
+        layer.locked = locked != 0;
+        layer.name.assign(reinterpret_cast<const char*>(name), nameLen);
+        layer.strokeIds.assign(layerStrokeCount, 0);
+        layerStrokes += layerStrokeCount;
+    }
+
+    size_t chunkStrokes = 0;
+    if (table.Remaining() != static_cast<size_t>(chunkCount) * kChunkRecordSize) {
+        Close();
+        return false;
+    }
+    chunks_.resize(chunkCount);
+    for (RoadMarkupFileChunk& chunk : chunks_) {
+        table.Get(chunk.tileX);
+        table.Get(chunk.tileZ);
+        table.Get(chunk.bounds);
+        table.Get(chunk.strokeCount);
+        table.Get(chunk.offset);
+        table.Get(chunk.size);
+        table.Get(chunk.checksum);
+        if (chunk.offset < kHeaderSize + tablesSize || chunk.offset > size || chunk.size > size - chunk.offset) {
+            Close();
+            return false;
+        }
+        chunkStrokes += chunk.strokeCount;
+    }
+    if (layerStrokes != strokeCount || chunkStrokes != strokeCount) {
+        Close();
+        return false;
+    }
+
+    data_ = data;
+    size_ = size;
+    strokeCount_ = strokeCount;
+    return true;
+}
+
+void RoadMarkupFileReader::Close()
+{
+    data_ = nullptr;
+    size_ = 0;
+    strokeCount_ = 0;
+    info_ = {};
+    layers_.clear();
+    chunks_.clear();
+}
+
+bool RoadMarkupFileReader::DecodeChunk(const size_t index, const StrokeFn fn, void* userData) const
+{
+    if (!data_ || index >= chunks_.size()) {
+        return false;
+    }
+    const RoadMarkupFileChunk& chunk = chunks_[index];
+    const uint8_t* payload = data_ + chunk.offset;
+    if (Crc32(payload, chunk.size) != chunk.checksum) {
+        return false;
+    }
+
+    const int64_t tileSteps = (std::max)(1, Quantize(tileSize_));
+    const int64_t originX = chunk.tileX * tileSteps;
+    const int64_t originZ = chunk.tileZ * tileSteps;
+    RoadMarkupByteReader in(payload, chunk.size);
+    RoadMarkupStroke& stroke = scratch_;
+    for (uint32_t s = 0; s < chunk.strokeCount; ++s) {
+        uint32_t layer = 0;
+        uint32_t order = 0;
+        uint32_t type = 0;
+        uint8_t flags = 0;
+        uint32_t pointCount = 0;
+        if (!in.GetVarint32(layer) || !in.GetVarint32(order) || !in.GetVarint32(type) || !in.Get(flags) ||
+            !in.Get(stroke.color) || !in.Get(stroke.width) || !in.Get(stroke.length) || !in.Get(stroke.rotation) ||
+            !in.Get(stroke.dashLength) || !in.Get(stroke.gapLength) || !in.Get(stroke.opacity) ||
+            !in.GetVarint32(pointCount) || layer >= layers_.size() || order >= layers_[layer].strokeIds.size() ||
+            type > static_cast<uint32_t>(RoadMarkupType::TextBusOnly) ||
+            pointCount > in.Remaining() / kMinPointBytes) {
+            return false;
+        }
+        stroke.type = static_cast<RoadMarkupType>(type);
+        stroke.dashed = (flags & kRoadMarkupFlagDashed) != 0;
+        stroke.visible = (flags & kRoadMarkupFlagVisible) != 0;
+        stroke.layerId = layers_[layer].id;
+        stroke.id = 0;
+        stroke.points.resize(pointCount);
+
+        int64_t x = originX;
+        int64_t y = 0;
+        int64_t z = originZ;
+        for (RoadDecalPoint& point : stroke.points) {
+            uint64_t dx = 0;
+            uint64_t dy = 0;
+            uint64_t dz = 0;
+            if (!in.GetVarint(dx) || !in.GetVarint(dy) || !in.GetVarint(dz)) {
+                return false;
+            }
+            x += UnZigZag(dx >> 1);
+            y += UnZigZag(dy);
+            z += UnZigZag(dz);
+            point.x = Dequantize(x);
+            point.y = Dequantize(y);
+            point.z = Dequantize(z);
+            point.hardCorner = (dx & 1u) != 0;
+        }
+        fn(layer, order, stroke, userData);
+    }
+    return in.Remaining() == 0;
+}
+
+RoadMarkupMappedFile::~RoadMarkupMappedFile()
+{
+    Close();
+}
+
+#ifdef _WIN32
+bool RoadMarkupMappedFile::Open(const char* path)
+{
+    Close();
+    HANDLE file = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL,
+                              nullptr);
+    if (file == INVALID_HANDLE_VALUE) {
+        return false;
+    }
+    LARGE_INTEGER size{};
+    if (!GetFileSizeEx(file, &size) || size.QuadPart <= 0 ||
+        static_cast<uint64_t>(size.QuadPart) > (std::numeric_limits<uint32_t>::max)()) {
+        CloseHandle(file);
+        return false;
+    }
+    HANDLE mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    const void* view = mapping ? MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0) : nullptr;
+    if (!view) {
+        if (mapping) {
+            CloseHandle(mapping);
+        }
+        CloseHandle(file);
+        return false;
+    }
+    file_ = file;
+    mapping_ = mapping;
+    data_ = static_cast<const uint8_t*>(view);
+    size_ = static_cast<size_t>(size.QuadPart);
+    return true;
+}
+
+void RoadMarkupMappedFile::Close()
+{
+    if (data_) {
+        UnmapViewOfFile(data_);
+    }
+    if (mapping_) {
+        CloseHandle(mapping_);
+    }
+    if (file_) {
+        CloseHandle(file_);
+    }
+    data_ = nullptr;
+    size_ = 0;
+    mapping_ = nullptr;
+    file_ = nullptr;
+}
+#else
+bool RoadMarkupMappedFile::Open(const char* path)
+{
+    Close();
+    const int fd = open(path, O_RDONLY);
+    if (fd < 0) {
+        return false;
+    }
+    struct stat info{};
+    void* view = MAP_FAILED;
+    if (fstat(fd, &info) == 0 && info.st_size > 0) {
+        view = mmap(nullptr, static_cast<size_t>(info.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+    }
+    close(fd);
+    if (view == MAP_FAILED) {
+        return false;
+    }
+    data_ = static_cast<const uint8_t*>(view);
+    size_ = static_cast<size_t>(info.st_size);
+    return true;
+}
+
+void RoadMarkupMappedFile::Close()
+{
+    if (data_) {
+        munmap(const_cast<uint8_t*>(data_), size_);
+    }
+    data_ = nullptr;
+    size_ = 0;
+}
+#endif
@@ -0,0 +1,160 @@
+#pragma once
+
+#include "RoadDecalData.hpp"
+#include "public/ViewFrustum.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+// Version 2 of the road markup file, laid out so it can be read straight from a memory map.
+//
+// A fixed header and the layer table come first, then a table of chunks. Each chunk holds the strokes whose bounds
+// are centred in one square tile, with the tile's bounds, so a loader can decode the chunks in view first and the rest
+// later. Points are stored as deltas from the previous point, quantized to 1/1024 m and varint-coded, which keeps a
+// typical point to about 7 bytes instead of 13. Every chunk and the tables carry a CRC-32; a damaged chunk is rejected
+// on its own without losing the others.
+//
+// Version 1 files (one field at a time through cIGZOStream) start with the same magic and are told apart by the
+// version that follows it.
+//
+// Example usage:
+//   RoadMarkupFileWriter writer;
+//   writer.BeginLayer(layer);
+//   writer.AddStroke(stroke);
+//   writer.Finish(info, bytes);
+//
+//   RoadMarkupMappedFile file;
+//   RoadMarkupFileReader reader;
+//   if (file.Open(path) && reader.Open(file.Data(), file.Size())) {
+//       for (size_t i = 0; i < reader.Chunks().size(); ++i) {
+//           reader.DecodeChunk(i, &OnStroke, nullptr);
+//       }
+//   }
+//
+
+constexpr uint32_t kRoadMarkupFileMagic = 0x4B4D4452; // RDMK
+constexpr uint32_t kRoadMarkupFileVersion = 2;
+constexpr float kRoadMarkupFilePointScale = 1024.0f;    // Quantization steps per metre.
+
+struct RoadMarkupFileInfo
+{
+    int32_t activeLayerIndex = 0;
+    int32_t selectedLayerIndex = -1;    // Selection as a layer index and a position in that layer, or -1.
+    int32_t selectedStrokeIndex = -1;
+};
+
+struct RoadMarkupFileChunk
+{
+    int32_t tileX = 0;
+    int32_t tileZ = 0;
+    CullBox bounds{};                   // Of every point of every stroke in the chunk.
+    uint32_t strokeCount = 0;
+    uint32_t offset = 0;                // Of the payload, from the start of the file.
+    uint32_t size = 0;
+    uint32_t checksum = 0;              // CRC-32 of the payload.
+};
+
+// CRC-32 (IEEE) of the bytes, as stored in the file.
+uint32_t ComputeRoadMarkupChecksum(const uint8_t* data, size_t size);
+
+// Version of a markup file from its first 8 bytes, or 0 if it is not one.
+uint32_t PeekRoadMarkupFileVersion(const uint8_t* data, size_t size);
+
+class RoadMarkupFileWriter
+{
+public:
+    explicit RoadMarkupFileWriter(float tileSize = 128.0f);
+
+    // Starts a layer; the strokes added after it belong to it, in draw order. The layer's strokeIds are not read.
+    void BeginLayer(const RoadMarkupLayer& layer);
+    void AddStroke(const RoadMarkupStroke& stroke);
+
+    // Encodes everything added so far into out, replacing its contents, and empties the writer.
+    void Finish(const RoadMarkupFileInfo& info, std::vector<uint8_t>& out);
+
+private:
+    struct Point
+    {
+        int32_t x;                      // In quantization steps.
+        int32_t y;
+        int32_t z;
+        bool hardCorner;
+    };
+
+    // One chunk's strokes, encoded as they are added.
+    struct Tile
+    {
+        int32_t tileX = 0;
+        int32_t tileZ = 0;
+        uint32_t strokeCount = 0;
+        CullBox bounds{};
+        std::vector<uint8_t> payload{};
+    };
+
+    float tileSize_;
+    int32_t tileSteps_;                 // Tile size in quantization steps.
+    std::vector<RoadMarkupLayer> layers_{};
+    std::vector<Tile> tiles_{};
+    std::unordered_map<uint64_t, uint32_t> tileByKey_{};
+    std::vector<Point> points_{};       // Of the stroke being added.
+};
+
+class RoadMarkupFileReader
+{
+public:
+    // Called once per decoded stroke; order is the stroke's position in its layer.
+    using StrokeFn = void (*)(uint32_t layerIndex, uint32_t order, const RoadMarkupStroke& stroke, void* userData);
+
+    // Checks the header and both tables of a version 2 file. The bytes are not copied and must outlive the reader.
+    bool Open(const uint8_t* data, size_t size);
+    void Close();
+
+    [[nodiscard]] const RoadMarkupFileInfo& Info() const { return info_; }
+    // Layers in file order. Each one's strokeIds holds a 0 per stroke, for the caller to fill in as chunks decode.
+    [[nodiscard]] const std::vector<RoadMarkupLayer>& Layers() const { return layers_; }
+    [[nodiscard]] const std::vector<RoadMarkupFileChunk>& Chunks() const { return chunks_; }
+    [[nodiscard]] size_t StrokeCount() const { return strokeCount_; }
+
+    // Decodes one chunk, in any order and any number of times. Returns false without calling fn if the chunk fails
+    // its checksum, or part way through if it is malformed.
+    bool DecodeChunk(size_t index, StrokeFn fn, void* userData) const;
+
+private:
+    const uint8_t* data_ = nullptr;
+    size_t size_ = 0;
+    float tileSize_ = 0.0f;
+    size_t strokeCount_ = 0;
+    RoadMarkupFileInfo info_{};
+    std::vector<RoadMarkupLayer> layers_{};
+    std::vector<RoadMarkupFileChunk> chunks_{};
+    mutable RoadMarkupStroke scratch_{};
+};
+
+// A whole file mapped read-only into memory.
+class RoadMarkupMappedFile
+{
+public:
+    RoadMarkupMappedFile() = default;
+    ~RoadMarkupMappedFile();
+
+    RoadMarkupMappedFile(const RoadMarkupMappedFile&) = delete;
+    RoadMarkupMappedFile& operator=(const RoadMarkupMappedFile&) = delete;
+
+    // Closes any file already open. Fails for missing and empty files.
+    bool Open(const char* path);
+    void Close();
+
+    [[nodiscard]] bool IsOpen() const { return data_ != nullptr; }
+    [[nodiscard]] const uint8_t* Data() const { return data_; }
+    [[nodiscard]] size_t Size() const { return size_; }
+
+private:
+    const uint8_t* data_ = nullptr;
+    size_t size_ = 0;
+#ifdef _WIN32
+    void* file_ = nullptr;
+    void* mapping_ = nullptr;
+#endif
+};
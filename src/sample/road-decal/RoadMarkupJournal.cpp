@@ -0,0 +1,561 @@
+#include "RoadMarkupJournal.hpp"
+#include "RoadMarkupBytes.hpp"
+#include "RoadMarkupFile.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <filesystem>
+#include <system_error>
+
+#ifdef _WIN32
+#include <io.h>
+#else
+#include <unistd.h>
+#endif
+
+namespace
+{
+    constexpr uint32_t kJournalMagic = 0x4C4A4452; // RDJL
+    constexpr uint32_t kJournalVersion = 1;
+    constexpr size_t kJournalHeaderSize = 4 * sizeof(uint32_t);
+    // Size and CRC-32 of the body, which is a flags byte and the encoded edit.
+    constexpr size_t kRecordHeaderSize = 2 * sizeof(uint32_t);
+    constexpr uint8_t kRecordRevert = 1u << 0;
+    constexpr uint8_t kFlagLocked = 1u << 2;
+    // Smallest encodings, which bound the counts a damaged record can claim.
+    constexpr size_t kMinStrokeBytes = 2 + 6 * sizeof(float) + sizeof(uint32_t) + 2;
+    constexpr size_t kPointBytes = 3 * sizeof(float) + 1;
+    // The journal is not compacted below this, however small the snapshot.
+    constexpr size_t kMinCompactionBytes = 1u << 20;
+
+    std::string OpenMarkPath(const std::string& snapshotPath)
+    {
+        return snapshotPath + ".open";
+    }
+    constexpr auto kSyncInterval = std::chrono::seconds(1);
+
+    template <typename T>
+    void Put(std::vector<uint8_t>& out, const T v)
+    {
+        const size_t at = out.size();
+        out.resize(at + sizeof(T));
+        std::memcpy(out.data() + at, &v, sizeof(T));
+    }
+
+    void PutVarint(std::vector<uint8_t>& out, const uint64_t v)
+    {
+        const size_t at = out.size();
+        out.resize(at + kRoadMarkupMaxVarintBytes);
+        out.resize(static_cast<size_t>(PutRoadMarkupVarint(out.data() + at, v) - out.data()));
+    }
+
+    void PutStyle(std::vector<uint8_t>& out, const RoadMarkupStrokeStyle& style)
+    {
+        Put(out, style.width);
+        Put(out, style.length);
+        Put(out, style.dashLength);
+        Put(out, style.gapLength);
+        Put(out, style.opacity);
+        Put(out, style.color);
+        Put(out, MakeRoadMarkupFlags(style.dashed, style.visible));
+    }
+
+    void PutStrokes(std::vector<uint8_t>& out, const std::vector<RoadMarkupStroke>& strokes)
+    {
+        PutVarint(out, strokes.size());
+        for (const auto& stroke : strokes) {
+            PutVarint(out, static_cast<uint32_t>(stroke.type));
+            PutVarint(out, stroke.layerId);
+            Put(out, stroke.width);
+            Put(out, stroke.length);
+            Put(out, stroke.rotation);
+            Put(out, stroke.dashLength);
+            Put(out, stroke.gapLength);
+            Put(out, stroke.opacity);
+            Put(out, stroke.color);
+            Put(out, MakeRoadMarkupFlags(stroke.dashed, stroke.visible));
+            PutVarint(out, stroke.points.size());
+            for (const auto& p : stroke.points) {
+                Put(out, p.x);
+                Put(out, p.y);
+                Put(out, p.z);
+                Put(out, static_cast<uint8_t>(p.hardCorner ? 1 : 0));
+            }
+        }
+    }
+
+    bool GetStyle(RoadMarkupByteReader& in, RoadMarkupStrokeStyle& style)
+    {
+        uint8_t flags = 0;
+        if (!in.Get(style.width) || !in.Get(style.length) || !in.Get(style.dashLength) || !in.Get(style.gapLength) ||
+            !in.Get(style.opacity) || !in.Get(style.color) || !in.Get(flags)) {
+            return false;
+        }
+        style.dashed = (flags & kRoadMarkupFlagDashed) != 0;
+        style.visible = (flags & kRoadMarkupFlagVisible) != 0;
+        return true;
+    }
+
+    bool GetStrokes(RoadMarkupByteReader& in, std::vector<RoadMarkupStroke>& strokes)
+    {
+        uint32_t count = 0;
+        if (!in.GetVarint32(count) || count > in.Remaining() / kMinStrokeBytes) {
+            return false;
+        }
+        strokes.resize(count);
+        for (auto& stroke : strokes) {
+            uint32_t type = 0;
+            uint8_t flags = 0;
+            uint32_t pointCount = 0;
+            if (!in.GetVarint32(type) || !in.GetVarint32(stroke.layerId) || !in.Get(stroke.width) ||
+                !in.Get(stroke.length) || !in.Get(stroke.rotation) || !in.Get(stroke.dashLength) ||
+                !in.Get(stroke.gapLength) || !in.Get(stroke.opacity) || !in.Get(stroke.color) || !in.Get(flags) ||
+                !in.GetVarint32(pointCount) || pointCount > in.Remaining() / kPointBytes) {
+                return false;
+            }
+            stroke.type = static_cast<RoadMarkupType>(type);
+            stroke.dashed = (flags & kRoadMarkupFlagDashed) != 0;
+            stroke.visible = (flags & kRoadMarkupFlagVisible) != 0;
+            stroke.id = 0;
+            stroke.points.resize(pointCount);
+            for (auto& p : stroke.points) {
+                uint8_t hardCorner = 0;
+                in.Get(p.x);
+                in.Get(p.y);
+                in.Get(p.z);
+                in.Get(hardCorner);
+                p.hardCorner = hardCorner != 0;
+            }
+        }
+        return true;
+    }
+
+    bool SyncFile(std::FILE* file)
+    {
+        if (std::fflush(file) != 0) {
+            return false;
+        }
+#ifdef _WIN32
+        return _commit(_fileno(file)) == 0;
+#else
+        return fsync(fileno(file)) == 0;
+#endif
+    }
+}
+
+void EncodeRoadMarkupEdit(const RoadMarkupEdit& edit, std::vector<uint8_t>& out)
+{
+    out.push_back(static_cast<uint8_t>(edit.kind));
+    PutVarint(out, edit.layerId);
+    PutVarint(out, edit.index);
+    switch (edit.kind) {
+    case RoadMarkupEditKind::AddStroke:
+    case RoadMarkupEditKind::DeleteStroke:
+    case RoadMarkupEditKind::ClearStrokes:
+        PutStrokes(out, edit.strokes);
+        break;
+    case RoadMarkupEditKind::MoveStroke:
+        Put(out, edit.deltaX);
+        Put(out, edit.deltaZ);
+        break;
+    case RoadMarkupEditKind::RotateStroke:
+        Put(out, edit.radians);
+        break;
+    case RoadMarkupEditKind::SetStrokeStyle:
+        PutStyle(out, edit.before);
+        PutStyle(out, edit.after);
+        break;
+    case RoadMarkupEditKind::AddLayer:
+    case RoadMarkupEditKind::DeleteLayer:
+        PutVarint(out, edit.layer.name.size());
+        out.insert(out.end(), edit.layer.name.begin(), edit.layer.name.end());
+        Put(out, static_cast<uint8_t>(MakeRoadMarkupFlags(false, edit.layer.visible) |
+                                      (edit.layer.locked ? kFlagLocked : 0)));
+        Put(out, static_cast<int32_t>(edit.layer.renderOrder));
+        PutStrokes(out, edit.strokes);
+        break;
+    case RoadMarkupEditKind::MoveLayer:
+        PutVarint(out, edit.toIndex);
+        break;
+    }
+}
+
+bool DecodeRoadMarkupEdit(const uint8_t* data, const size_t size, RoadMarkupEdit& out)
+{
+    RoadMarkupByteReader in(data, size);
+    uint8_t kind = 0;
+    if (!in.Get(kind) || kind > static_cast<uint8_t>(RoadMarkupEditKind::ClearStrokes) ||
+        !in.GetVarint32(out.layerId) || !in.GetVarint32(out.index)) {
+        return false;
+    }
+    out.kind = static_cast<RoadMarkupEditKind>(kind);
+    out.toIndex = 0;
+    out.deltaX = 0.0f;
+    out.deltaZ = 0.0f;
+    out.radians = 0.0f;
+    out.strokes.clear();
+
+    bool ok = true;
+    switch (out.kind) {
+    case RoadMarkupEditKind::AddStroke:
+    case RoadMarkupEditKind::DeleteStroke:
+        ok = GetStrokes(in, out.strokes) && out.strokes.size() == 1;
+        break;
+    case RoadMarkupEditKind::ClearStrokes:
+        ok = GetStrokes(in, out.strokes);
+        break;
+    case RoadMarkupEditKind::MoveStroke:
+        ok = in.Get(out.deltaX) && in.Get(out.deltaZ);
+        break;
+    case RoadMarkupEditKind::RotateStroke:
+        ok = in.Get(out.radians);
+        break;
+    case RoadMarkupEditKind::SetStrokeStyle:
+        ok = GetStyle(in, out.before) && GetStyle(in, out.after);
+        break;
+    case RoadMarkupEditKind::AddLayer:
+    case RoadMarkupEditKind::DeleteLayer: {
+        uint32_t nameLength = 0;
+        uint8_t flags = 0;
+        int32_t renderOrder = 0;
+        const uint8_t* name = in.GetVarint32(nameLength) ? in.Take(nameLength) : nullptr;
+        ok = name && in.Get(flags) && in.Get(renderOrder) && GetStrokes(in, out.strokes);
+        if (ok) {
+            out.layer.id = out.layerId;
+            out.layer.name.assign(reinterpret_cast<const char*>(name), nameLength);
+            out.layer.strokeIds.clear();
+            out.layer.visible = (flags & kRoadMarkupFlagVisible) != 0;
+            out.layer.locked = (flags & kFlagLocked) != 0;
+            out.layer.renderOrder = renderOrder;
+        }
+        break;
+    }
+    case RoadMarkupEditKind::MoveLayer:
+        ok = in.GetVarint32(out.toIndex);
+        break;
+    }
+    return ok && in.Remaining() == 0;
+}
+
+RoadMarkupJournal::RoadMarkupJournal(const size_t historyBytes)
+    : historyBudget_(historyBytes)
+{
+}
+
+RoadMarkupJournal::~RoadMarkupJournal()
+{
+    StopAutosave();
+}
+
+void RoadMarkupJournal::Record(const RoadMarkupEdit& edit)
+{
+    scratch_.clear();
+    EncodeRoadMarkupEdit(edit, scratch_);
+    Append(scratch_, false);
+
+    while (history_.size() > undoCount_) {
+        historyBytes_ -= history_.back().size();
+        history_.pop_back();
+    }
+    if (scratch_.size() > historyBudget_) {
+        ClearHistory();
+        return;
+    }
+    history_.push_back(scratch_);
+    historyBytes_ += scratch_.size();
+    ++undoCount_;
+    while (historyBytes_ > historyBudget_) {
+        historyBytes_ -= history_.front().size();
+        history_.pop_front();
+        --undoCount_;
+    }
+}
+
+bool RoadMarkupJournal::Undo(RoadMarkupEdit& out)
+{
+    if (!CanUndo()) {
+        return false;
+    }
+    const std::vector<uint8_t>& record = history_[undoCount_ - 1];
+    if (!DecodeRoadMarkupEdit(record.data(), record.size(), out)) {
+        ClearHistory();
+        return false;
+    }
+    --undoCount_;
+    Append(record, true);
+    return true;
+}
+
+bool RoadMarkupJournal::Redo(RoadMarkupEdit& out)
+{
+    if (!CanRedo()) {
+        return false;
+    }
+    const std::vector<uint8_t>& record = history_[undoCount_];
+    if (!DecodeRoadMarkupEdit(record.data(), record.size(), out)) {
+        ClearHistory();
+        return false;
+    }
+    ++undoCount_;
+    Append(record, false);
+    return true;
+}
+
+void RoadMarkupJournal::ClearHistory()
+{
+    history_.clear();
+    undoCount_ = 0;
+    historyBytes_ = 0;
+}
+
+bool RoadMarkupJournal::StartAutosave(const char* path)
+{
+    StopAutosave();
+    if (!path || !path[0]) {
+        return false;
+    }
+    snapshotPath_ = path;
+    journalPath_ = snapshotPath_ + ".journal";
+    hasSnapshot_ = false;
+    snapshotBytes_ = 0;
+    journalBytes_ = 0;
+    queued_.clear();
+    queuedSnapshot_.clear();
+    snapshotQueued_ = false;
+    stopRequested_ = false;
+    failed_.store(false, std::memory_order_relaxed);
+    std::FILE* mark = std::fopen(OpenMarkPath(snapshotPath_).c_str(), "wb");
+    if (mark) {
+        std::fclose(mark);
+    }
+    else {
+        failed_.store(true, std::memory_order_relaxed);
+    }
+    writer_ = std::thread(&RoadMarkupJournal::WriterLoop, this);
+    return true;
+}
+
+void RoadMarkupJournal::StopAutosave()
+{
+    if (!writer_.joinable()) {
+        return;
+    }
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stopRequested_ = true;
+    }
+    wake_.notify_one();
+    writer_.join();
+    hasSnapshot_ = false;
+}
+
+// Removes the mark first: a crash part way through leaves files that are not recovered, and are replaced by the next
+// autosave.
+void RoadMarkupJournal::FinishAutosave()
+{
+    if (!AutosaveActive()) {
+        return;
+    }
+    StopAutosave();
+    std::error_code error;
+    std::filesystem::remove(OpenMarkPath(snapshotPath_), error);
+    std::filesystem::remove(snapshotPath_, error);
+    std::filesystem::remove(journalPath_, error);
+}
+
+bool RoadMarkupJournal::AutosaveLeftOpen(const char* path)
+{
+    if (!path || !path[0]) {
+        return false;
+    }
+    std::error_code error;
+    return std::filesystem::exists(OpenMarkPath(path), error);
+}
+
+bool RoadMarkupJournal::WantsSnapshot() const
+{
+    return AutosaveActive() && (!hasSnapshot_ || journalBytes_ > (std::max)(kMinCompactionBytes, snapshotBytes_));
+}
+
+void RoadMarkupJournal::RequestSnapshot()
+{
+    hasSnapshot_ = false;
+}
+
+void RoadMarkupJournal::Snapshot(std::vector<uint8_t>&& bytes)
+{
+    if (!AutosaveActive()) {
+        return;
+    }
+    hasSnapshot_ = true;
+    snapshotBytes_ = bytes.size();
+    journalBytes_ = 0;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        queuedSnapshot_ = std::move(bytes);
+        snapshotQueued_ = true;
+        queued_.clear();
+    }
+    wake_.notify_one();
+}
+
+size_t RoadMarkupJournal::Replay(const uint8_t* snapshot, const size_t snapshotSize, const uint8_t* journal,
+                                 const size_t journalSize, const ReplayFn fn, void* userData)
+{
+    RoadMarkupByteReader in(journal, journalSize);
+    uint32_t magic = 0;
+    uint32_t version = 0;
+    uint32_t size = 0;
+    uint32_t checksum = 0;
+    if (!in.Get(magic) || !in.Get(version) || !in.Get(size) || !in.Get(checksum) || magic != kJournalMagic ||
+        version != kJournalVersion || size != snapshotSize || checksum != ComputeRoadMarkupChecksum(snapshot, size)) {
+        return 0;
+    }
+
+    // A crash can leave the last record torn; it and anything after it are ignored.
+    RoadMarkupEdit edit;
+    size_t replayed = 0;
+    while (in.Remaining() >= kRecordHeaderSize) {
+        uint32_t bodySize = 0;
+        uint32_t bodyChecksum = 0;
+        in.Get(bodySize);
+        in.Get(bodyChecksum);
+        const uint8_t* body = bodySize > 0 ? in.Take(bodySize) : nullptr;
+        if (!body || ComputeRoadMarkupChecksum(body, bodySize) != bodyChecksum ||
+            !DecodeRoadMarkupEdit(body + 1, bodySize - 1, edit) ||
+            !fn(edit, (body[0] & kRecordRevert) != 0, userData)) {
+            break;
+        }
+        ++replayed;
+    }
+    return replayed;
+}
+
+void RoadMarkupJournal::Append(const std::vector<uint8_t>& record, const bool revert)
+{
+    if (!AutosaveActive() || !hasSnapshot_) {
+        return;
+    }
+    const auto bodySize = static_cast<uint32_t>(record.size() + 1);
+    journalBytes_ += kRecordHeaderSize + bodySize;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        const size_t at = queued_.size();
+        queued_.resize(at + kRecordHeaderSize + bodySize);
+        uint8_t* body = queued_.data() + at + kRecordHeaderSize;
+        body[0] = revert ? kRecordRevert : 0;
+        std::memcpy(body + 1, record.data(), record.size());
+        const uint32_t checksum = ComputeRoadMarkupChecksum(body, bodySize);
+        std::memcpy(queued_.data() + at, &bodySize, sizeof(bodySize));
+        std::memcpy(queued_.data() + at + sizeof(bodySize), &checksum, sizeof(checksum));
+    }
+    wake_.notify_one();
+}
+
+void RoadMarkupJournal::WriterLoop()
+{
+    using Clock = std::chrono::steady_clock;
+    std::vector<uint8_t> records;
+    std::vector<uint8_t> snapshot;
+    bool unsynced = false;                  // Records handed to the OS but not yet flushed to the disk.
+    Clock::time_point syncDue{};
+
+    std::unique_lock<std::mutex> lock(mutex_);
+    for (;;) {
+        const auto ready = [this] { return stopRequested_ || snapshotQueued_ || !queued_.empty(); };
+        if (unsynced) {
+            wake_.wait_until(lock, syncDue, ready);
+        }
+        else {
+            wake_.wait(lock, ready);
+        }
+        const bool stopping = stopRequested_;
+        const bool hasSnapshot = snapshotQueued_;
+        if (hasSnapshot) {
+            snapshot.swap(queuedSnapshot_);
+            queuedSnapshot_.clear();
+            snapshotQueued_ = false;
+        }
+        records.swap(queued_);
+        queued_.clear();
+        lock.unlock();
+
+        if (hasSnapshot && WriteSnapshot(snapshot)) {
+            unsynced = false;
+        }
+        if (!records.empty() && journalFile_) {
+            // Once written the records survive the game crashing; the sync is for the system going down.
+            if (std::fwrite(records.data(), 1, records.size(), journalFile_) != records.size() ||
+                std::fflush(journalFile_) != 0) {
+                failed_.store(true, std::memory_order_relaxed);
+            }
+            else if (!unsynced) {
+                unsynced = true;
+                syncDue = Clock::now() + kSyncInterval;
+            }
+        }
+        if (unsynced && (stopping || Clock::now() >= syncDue)) {
+            if (!SyncFile(journalFile_)) {
+                failed_.store(true, std::memory_order_relaxed);
+            }
+            unsynced = false;
+        }
+        records.clear();
+        snapshot.clear();
+
+        lock.lock();
+        if (stopping && !snapshotQueued_ && queued_.empty()) {
+            break;
+        }
+    }
+    lock.unlock();
+
+    if (journalFile_) {
+        std::fclose(journalFile_);
+        journalFile_ = nullptr;
+    }
+}
+
+// Writes the snapshot beside the old one and renames it over it, then starts an empty journal for it. A crash at any
+// point leaves either the old pair or a snapshot whose journal is ignored for belonging to the old one.
+bool RoadMarkupJournal::WriteSnapshot(const std::vector<uint8_t>& bytes)
+{
+    if (journalFile_) {
+        std::fclose(journalFile_);
+        journalFile_ = nullptr;
+    }
+
+    const std::string temporaryPath = snapshotPath_ + ".tmp";
+    std::FILE* file = std::fopen(temporaryPath.c_str(), "wb");
+    if (!file) {
+        failed_.store(true, std::memory_order_relaxed);
+        return false;
+    }
+    const bool written = std::fwrite(bytes.data(), 1, bytes.size(), file) == bytes.size() && SyncFile(file);
+    std::fclose(file);
+    std::error_code error;
+    if (written) {
+        std::filesystem::rename(temporaryPath, snapshotPath_, error);
+    }
+    if (!written || error) {
+        failed_.store(true, std::memory_order_relaxed);
+        return false;
+    }
+
+    journalFile_ = std::fopen(journalPath_.c_str(), "wb");
+    if (!journalFile_) {
+        failed_.store(true, std::memory_order_relaxed);
+        return false;
+    }
+    const uint32_t header[] = {kJournalMagic, kJournalVersion, static_cast<uint32_t>(bytes.size()),
+                               ComputeRoadMarkupChecksum(bytes.data(), bytes.size())};
+    static_assert(sizeof(header) == kJournalHeaderSize);
+    if (std::fwrite(header, 1, sizeof(header), journalFile_) != sizeof(header) || !SyncFile(journalFile_)) {
+        std::fclose(journalFile_);
+        journalFile_ = nullptr;
+        failed_.store(true, std::memory_order_relaxed);
+        return false;
+    }
+    return true;
+}
@@ -0,0 +1,165 @@
+#pragma once
+
+#include "RoadDecalData.hpp"
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Edits to the road markings as compact records, for multi-level undo and redo and for an autosave that costs what
+// the edit costs rather than what all the markings cost.
+//
+// Every edit carries what it takes both to apply it and to revert it: an added or deleted stroke carries the stroke, a
+// move its offset, a style change the style before and after. Strokes and layers are addressed by layer id and their
+// position in it rather than by store id, so a record means the same thing when it is replayed onto the markings of a
+// snapshot loaded in another session.
+//
+// The history keeps the newest records within a byte budget and drops the oldest past it. The autosave is a snapshot
+// (a version 2 markup file) plus a journal file next to it that only ever grows by whole records: each edit, undo and
+// redo appends one. A background thread appends them as they come and flushes them to the disk at least once a second.
+// Once the journal outgrows the snapshot the caller is asked for a new snapshot, which replaces both files. A journal
+// that does not belong to the snapshot beside it, or its torn or damaged tail after a crash, is ignored on replay.
+// While the autosave runs, a mark file beside it says it is in use. A clean shutdown finishes the autosave, which
+// deletes the files and the mark, so only a session that ended without one leaves an autosave to recover.
+//
+// Example usage:
+//   RoadMarkupJournal journal;
+//   if (RoadMarkupJournal::AutosaveLeftOpen("road_markups_autosave.dat")) {
+//       RecoverFromTheAutosave();
+//   }
+//   journal.StartAutosave("road_markups_autosave.dat");
+//   if (journal.WantsSnapshot()) {
+//       journal.Snapshot(EncodeEverything());
+//   }
+//   journal.Record(edit);
+//   RoadMarkupEdit undo;
+//   if (journal.Undo(undo)) {
+//       Revert(undo);
+//   }
+//   journal.FinishAutosave();       // on a clean shutdown
+//
+
+enum class RoadMarkupEditKind : uint8_t
+{
+    AddStroke,
+    DeleteStroke,
+    MoveStroke,
+    RotateStroke,
+    SetStrokeStyle,
+    AddLayer,
+    DeleteLayer,
+    MoveLayer,
+    ClearStrokes
+};
+
+struct RoadMarkupEdit
+{
+    RoadMarkupEditKind kind = RoadMarkupEditKind::AddStroke;
+    uint32_t layerId = 0;                   // Of the stroke or layer; ClearStrokes uses 0 for every layer.
+    uint32_t index = 0;                     // Of the stroke in its layer, or of the layer in the draw order.
+    uint32_t toIndex = 0;                   // MoveLayer only.
+    float deltaX = 0.0f;                    // MoveStroke only.
+    float deltaZ = 0.0f;
+    float radians = 0.0f;                   // RotateStroke only.
+    RoadMarkupStrokeStyle before{};         // SetStrokeStyle only.
+    RoadMarkupStrokeStyle after{};
+    RoadMarkupLayer layer{};                // AddLayer and DeleteLayer; strokeIds are not recorded.
+    // AddStroke and DeleteStroke: the stroke. DeleteLayer: the layer's strokes in order. ClearStrokes: every cleared
+    // stroke, grouped by layerId, each group in order. Store ids are not recorded.
+    std::vector<RoadMarkupStroke> strokes{};
+};
+
+// Encodes edit onto the end of out.
+void EncodeRoadMarkupEdit(const RoadMarkupEdit& edit, std::vector<uint8_t>& out);
+// Decodes one edit into out, reusing its capacity. Fails on malformed or trailing bytes.
+bool DecodeRoadMarkupEdit(const uint8_t* data, size_t size, RoadMarkupEdit& out);
+
+class RoadMarkupJournal
+{
+public:
+    // Called per replayed record, in order; revert is set for the records of an undo. Returning false stops the replay.
+    using ReplayFn = bool (*)(const RoadMarkupEdit& edit, bool revert, void* userData);
+
+    static constexpr size_t kDefaultHistoryBytes = 8u << 20;
+
+    explicit RoadMarkupJournal(size_t historyBytes = kDefaultHistoryBytes);
+    ~RoadMarkupJournal();
+
+    RoadMarkupJournal(const RoadMarkupJournal&) = delete;
+    RoadMarkupJournal& operator=(const RoadMarkupJournal&) = delete;
+
+    // Adds an edit that has just been applied, dropping anything that could have been redone. An edit larger than the
+    // whole budget empties the history instead, and cannot be undone.
+    void Record(const RoadMarkupEdit& edit);
+    // Decodes the edit to revert or apply again into out and moves through the history. The caller must then do it.
+    bool Undo(RoadMarkupEdit& out);
+    bool Redo(RoadMarkupEdit& out);
+    void ClearHistory();
+
+    [[nodiscard]] bool CanUndo() const { return undoCount_ > 0; }
+    [[nodiscard]] bool CanRedo() const { return undoCount_ < history_.size(); }
+    [[nodiscard]] size_t HistoryBytes() const { return historyBytes_; }
+
+    // Starts the writer thread for the snapshot at path and the journal at path + ".journal", and marks the autosave
+    // as in use with path + ".open". Nothing else is written until the first snapshot. Stops any autosave already
+    // running.
+    bool StartAutosave(const char* path);
+    // Writes everything queued and joins the writer thread. The files and the in-use mark stay.
+    void StopAutosave();
+    // For a clean shutdown: stops a running autosave and deletes its mark, snapshot and journal.
+    void FinishAutosave();
+    // True if the autosave at path is marked as in use, which after a restart means its session did not finish it.
+    static bool AutosaveLeftOpen(const char* path);
+    [[nodiscard]] bool AutosaveActive() const { return writer_.joinable(); }
+    // Set once a write has failed; the autosave keeps trying with the next snapshot.
+    [[nodiscard]] bool AutosaveFailed() const { return failed_.load(std::memory_order_relaxed); }
+
+    // True while autosaving without a snapshot, and once the journal has grown past the last snapshot.
+    [[nodiscard]] bool WantsSnapshot() const;
+    // For when the markings are replaced as a whole, as by loading a file. Records wait for the next snapshot.
+    void RequestSnapshot();
+    // Queues a snapshot of the markings as they are now, with every recorded edit applied. Records queued before it
+    // are dropped, as it already holds them.
+    void Snapshot(std::vector<uint8_t>&& bytes);
+
+    // Replays a journal file onto the markings just loaded from the snapshot file beside it, if it belongs to that
+    // snapshot. Stops at a torn or damaged record. Returns the number of records replayed.
+    static size_t Replay(const uint8_t* snapshot, size_t snapshotSize, const uint8_t* journal, size_t journalSize,
+                         ReplayFn fn, void* userData);
+
+private:
+    void Append(const std::vector<uint8_t>& record, bool revert);
+    void WriterLoop();
+    bool WriteSnapshot(const std::vector<uint8_t>& bytes);
+
+    // Encoded edits, oldest first; the first undoCount_ have been applied.
+    std::deque<std::vector<uint8_t>> history_{};
+    size_t undoCount_ = 0;
+    size_t historyBytes_ = 0;
+    size_t historyBudget_;
+    std::vector<uint8_t> scratch_{};
+
+    // Editing thread only.
+    bool hasSnapshot_ = false;
+    size_t snapshotBytes_ = 0;
+    size_t journalBytes_ = 0;           // Appended since the last snapshot.
+
+    std::string snapshotPath_{};
+    std::string journalPath_{};
+    std::thread writer_{};
+    std::mutex mutex_{};
+    std::condition_variable wake_{};
+    std::vector<uint8_t> queued_{};     // Framed records not written yet.
+    std::vector<uint8_t> queuedSnapshot_{};
+    bool snapshotQueued_ = false;
+    bool stopRequested_ = false;
+    std::atomic<bool> failed_{false};
+    std::FILE* journalFile_ = nullptr;  // Writer thread only.
+};
@@ -0,0 +1,222 @@
+#include "RoadMarkupSpatialIndex.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+namespace
+{
+    constexpr uint64_t kFnvOffset = 0xCBF29CE484222325ull;
+    constexpr uint64_t kFnvPrime = 0x100000001B3ull;
+    // Widens each row's span a little so rounding never drops a cell the segment only grazes.
+    constexpr float kCellSlack = 1.0e-3f;
+
+    uint64_t HashFloat(const uint64_t hash, const float value)
+    {
+        uint32_t bits = 0;
+        static_assert(sizeof(bits) == sizeof(value));
+        std::memcpy(&bits, &value, sizeof(bits));
+        return (hash ^ bits) * kFnvPrime;
+    }
+
+    uint64_t HashShapeXZ(const RoadDecalPoint* points, const size_t count)
+    {
+        uint64_t hash = (kFnvOffset ^ count) * kFnvPrime;
+        for (size_t i = 0; i < count; ++i) {
+            hash = HashFloat(hash, points[i].x);
+            hash = HashFloat(hash, points[i].z);
+        }
+        return hash;
+    }
+
+    uint64_t CellKey(const int32_t cx, const int32_t cz)
+    {
+        return (static_cast<uint64_t>(static_cast<uint32_t>(cx)) << 32) | static_cast<uint32_t>(cz);
+    }
+
+    float DistanceSquaredToSegment(const float px, const float pz,
+                                   const float ax, const float az, const float bx, const float bz)
+    {
+        const float abX = bx - ax;
+        const float abZ = bz - az;
+        const float apX = px - ax;
+        const float apZ = pz - az;
+        const float abLen2 = abX * abX + abZ * abZ;
+        if (abLen2 <= 1.0e-6f) {
+            return apX * apX + apZ * apZ;
+        }
+        const float t = std::clamp((apX * abX + apZ * abZ) / abLen2, 0.0f, 1.0f);
+        const float dx = px - (ax + abX * t);
+        const float dz = pz - (az + abZ * t);
+        return dx * dx + dz * dz;
+    }
+}
+
+RoadMarkupSpatialIndex::RoadMarkupSpatialIndex(const float cellSize)
+    : cellSize_((std::max)(cellSize, 1.0f))
+    , invCellSize_(1.0f / cellSize_)
+{
+}
+
+bool RoadMarkupSpatialIndex::Update(const uint32_t key, const RoadDecalPoint* points, const size_t count)
+{
+    if (key == 0) {
+        return false;
+    }
+
+    const uint64_t shapeHash = HashShapeXZ(points, count);
+    auto [it, inserted] = strokes_.try_emplace(key);
+    Stroke& stroke = it->second;
+    if (!inserted && stroke.shapeHash == shapeHash) {
+        return false;
+    }
+
+    RemoveSegments(stroke);
+    stroke.shapeHash = shapeHash;
+    AddSegments(key, stroke, points, count);
+    return true;
+}
+
+void RoadMarkupSpatialIndex::Remove(const uint32_t key)
+{
+    const auto it = strokes_.find(key);
+    if (it == strokes_.end()) {
+        return;
+    }
+    RemoveSegments(it->second);
+    strokes_.erase(it);
+}
+
+void RoadMarkupSpatialIndex::Clear()
+{
+    segments_.clear();
+    freeSegments_.clear();
+    strokes_.clear();
+    cells_.clear();
+}
+
+uint32_t RoadMarkupSpatialIndex::FindNearest(const float x,
+                                             const float z,
+                                             const float maxDistance,
+                                             const AcceptFn accept,
+                                             void* userData,
+                                             float* outDistance2) const
+{
+    const float radius = (std::max)(maxDistance, 0.0f);
+    const auto cx0 = static_cast<int32_t>(std::floor((x - radius) * invCellSize_));
+    const auto cx1 = static_cast<int32_t>(std::floor((x + radius) * invCellSize_));
+    const auto cz0 = static_cast<int32_t>(std::floor((z - radius) * invCellSize_));
+    const auto cz1 = static_cast<int32_t>(std::floor((z + radius) * invCellSize_));
+
+    float bestDistance2 = radius * radius;
+    uint32_t bestKey = 0;
+    for (int32_t cz = cz0; cz <= cz1; ++cz) {
+        for (int32_t cx = cx0; cx <= cx1; ++cx) {
+            const auto cell = cells_.find(CellKey(cx, cz));
+            if (cell == cells_.end()) {
+                continue;
+            }
+            for (const uint32_t index : cell->second) {
+                const Segment& s = segments_[index];
+                const float distance2 = DistanceSquaredToSegment(x, z, s.ax, s.az, s.bx, s.bz);
+                if (distance2 > bestDistance2 || (distance2 == bestDistance2 && s.key <= bestKey)) {
+                    continue;
+                }
+                if (accept && !accept(s.key, userData)) {
+                    continue;
+                }
+                bestDistance2 = distance2;
+                bestKey = s.key;
+            }
+        }
+    }
+
+    if (outDistance2 && bestKey != 0) {
+        *outDistance2 = bestDistance2;
+    }
+    return bestKey;
+}
+
+template <typename Fn>
+void RoadMarkupSpatialIndex::ForEachCell(const Segment& segment, Fn&& fn) const
+{
+    // Walk the rows the segment spans and, per row, only the columns of the part inside that row.
+    const float dz = segment.bz - segment.az;
+    const auto cz0 = static_cast<int32_t>(std::floor((std::min)(segment.az, segment.bz) * invCellSize_));
+    const auto cz1 = static_cast<int32_t>(std::floor((std::max)(segment.az, segment.bz) * invCellSize_));
+    for (int32_t cz = cz0; cz <= cz1; ++cz) {
+        float t0 = 0.0f;
+        float t1 = 1.0f;
+        if (std::fabs(dz) > 1.0e-6f) {
+            const float rowZ0 = static_cast<float>(cz) * cellSize_;
+            const float ta = (rowZ0 - segment.az) / dz;
+            const float tb = (rowZ0 + cellSize_ - segment.az) / dz;
+            t0 = std::clamp((std::min)(ta, tb), 0.0f, 1.0f);
+            t1 = std::clamp((std::max)(ta, tb), 0.0f, 1.0f);
+        }
+        const float xa = segment.ax + (segment.bx - segment.ax) * t0;
+        const float xb = segment.ax + (segment.bx - segment.ax) * t1;
+        const auto cx0 = static_cast<int32_t>(std::floor(((std::min)(xa, xb) - kCellSlack) * invCellSize_));
+        const auto cx1 = static_cast<int32_t>(std::floor(((std::max)(xa, xb) + kCellSlack) * invCellSize_));
+        for (int32_t cx = cx0; cx <= cx1; ++cx) {
+            fn(CellKey(cx, cz));
+        }
+    }
+}
+
+void RoadMarkupSpatialIndex::AddSegments(const uint32_t key,
+                                         Stroke& stroke,
+                                         const RoadDecalPoint* points,
+                                         const size_t count)
+{
+    if (count == 0) {
+        return;
+    }
+
+    // A single point is a zero-length segment, so arrows placed with one click stay pickable.
+    const size_t segmentCount = count == 1 ? 1 : count - 1;
+    stroke.segments.reserve(segmentCount);
+    for (size_t i = 0; i < segmentCount; ++i) {
+        const RoadDecalPoint& a = points[i];
+        const RoadDecalPoint& b = points[count == 1 ? i : i + 1];
+
+        uint32_t index = 0;
+        if (!freeSegments_.empty()) {
+            index = freeSegments_.back();
+            freeSegments_.pop_back();
+        }
+        else {
+            index = static_cast<uint32_t>(segments_.size());
+            segments_.emplace_back();
+        }
+        segments_[index] = {a.x, a.z, b.x, b.z, key};
+        stroke.segments.push_back(index);
+
+        ForEachCell(segments_[index], [&](const uint64_t cell) {
+            cells_[cell].push_back(index);
+        });
+    }
+}
+
+void RoadMarkupSpatialIndex::RemoveSegments(Stroke& stroke)
+{
+    for (const uint32_t index : stroke.segments) {
+        ForEachCell(segments_[index], [&](const uint64_t cell) {
+            const auto it = cells_.find(cell);
+            if (it == cells_.end()) {
+                return;
+            }
+            auto& entries = it->second;
+            const auto entry = std::find(entries.begin(), entries.end(), index);
+            if (entry != entries.end()) {
+                *entry = entries.back();
+                entries.pop_back();
+            }
+            if (entries.empty()) {
+                cells_.erase(it);
+            }
+        });
+        freeSegments_.push_back(index);
+    }
+    stroke.segments.clear();
+}
@@ -0,0 +1,78 @@
+#pragma once
+
+#include "RoadDecalData.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+// Uniform grid over stroke segments in the XZ plane, for picking strokes without scanning them all.
+//
+// Each segment is bucketed into every cell it crosses, so a nearest-stroke query only looks at the cells within its
+// radius. Strokes are identified by a caller-chosen non-zero key. The owner keeps the index current per edit: Update
+// when a stroke is added or its points change, Remove when it is deleted. Update re-buckets a stroke only when its
+// points moved in XZ.
+//
+// Example usage:
+//   RoadMarkupSpatialIndex index;
+//   index.Update(id, points.data(), points.size());       // stroke added
+//   index.Update(id, moved.data(), moved.size());         // stroke moved or rotated
+//   index.Remove(id);                                     // stroke deleted
+//   const uint32_t picked = index.FindNearest(x, z, 2.5f, nullptr, nullptr);
+//
+
+class RoadMarkupSpatialIndex
+{
+public:
+    // Returns false to skip a stroke, for example one on a hidden layer.
+    using AcceptFn = bool (*)(uint32_t key, void* userData);
+
+    explicit RoadMarkupSpatialIndex(float cellSize = 16.0f);
+
+    // Adds the stroke, or re-buckets it if its points moved. Returns true if the index changed.
+    bool Update(uint32_t key, const RoadDecalPoint* points, size_t count);
+    void Remove(uint32_t key);
+    void Clear();
+
+    // Key of the accepted stroke nearest to (x, z) within maxDistance, or 0 if there is none. Ties go to the higher
+    // key.
+    [[nodiscard]] uint32_t FindNearest(float x,
+                                       float z,
+                                       float maxDistance,
+                                       AcceptFn accept,
+                                       void* userData,
+                                       float* outDistance2 = nullptr) const;
+
+    [[nodiscard]] size_t StrokeCount() const { return strokes_.size(); }
+    [[nodiscard]] size_t SegmentCount() const { return segments_.size() - freeSegments_.size(); }
+    [[nodiscard]] size_t CellCount() const { return cells_.size(); }
+
+private:
+    struct Segment
+    {
+        float ax = 0.0f;
+        float az = 0.0f;
+        float bx = 0.0f;
+        float bz = 0.0f;
+        uint32_t key = 0;
+    };
+
+    struct Stroke
+    {
+        uint64_t shapeHash = 0;
+        std::vector<uint32_t> segments;
+    };
+
+    void AddSegments(uint32_t key, Stroke& stroke, const RoadDecalPoint* points, size_t count);
+    void RemoveSegments(Stroke& stroke);
+    template <typename Fn>
+    void ForEachCell(const Segment& segment, Fn&& fn) const;
+
+    float cellSize_;
+    float invCellSize_;
+    std::vector<Segment> segments_{};
+    std::vector<uint32_t> freeSegments_{};
+    std::unordered_map<uint32_t, Stroke> strokes_{};
+    std::unordered_map<uint64_t, std::vector<uint32_t>> cells_{};
+};
@@ -0,0 +1,262 @@
+#include "RoadMarkupStore.hpp"
+
+#include <algorithm>
+
+namespace
+{
+    constexpr size_t kMinCompactPoints = 4096;
+
+    template <typename T>
+    void MoveLastInto(std::vector<T>& column, const size_t row)
+    {
+        column[row] = column.back();
+        column.pop_back();
+    }
+}
+
+uint32_t RoadMarkupStore::Add(const RoadMarkupStroke& stroke)
+{
+    if (slotById_.empty()) {
+        slotById_.push_back(kNoSlot); // Id 0 means no stroke.
+    }
+    const auto id = static_cast<uint32_t>(slotById_.size());
+    slotById_.push_back(static_cast<uint32_t>(ids_.size()));
+
+    ids_.push_back(id);
+    types_.push_back(stroke.type);
+    widths_.push_back(stroke.width);
+    lengths_.push_back(stroke.length);
+    rotations_.push_back(stroke.rotation);
+    dashLengths_.push_back(stroke.dashLength);
+    gapLengths_.push_back(stroke.gapLength);
+    colors_.push_back(stroke.color);
+    opacities_.push_back(stroke.opacity);
+    flags_.push_back(static_cast<uint8_t>((stroke.dashed ? kFlagDashed : 0) | (stroke.visible ? kFlagVisible : 0)));
+    layerIds_.push_back(stroke.layerId);
+    pointOffsets_.push_back(AppendPoints(stroke.points));
+    pointCounts_.push_back(static_cast<uint32_t>(stroke.points.size()));
+    return id;
+}
+
+bool RoadMarkupStore::Remove(const uint32_t id)
+{
+    const uint32_t slot = SlotOf(id);
+    if (slot == kNoSlot) {
+        return false;
+    }
+    ReleasePoints(slot);
+
+    // The last row takes the freed one, so rows stay dense.
+    slotById_[ids_.back()] = slot;
+    slotById_[id] = kNoSlot;
+    MoveLastInto(ids_, slot);
+    MoveLastInto(types_, slot);
+    MoveLastInto(widths_, slot);
+    MoveLastInto(lengths_, slot);
+    MoveLastInto(rotations_, slot);
+    MoveLastInto(dashLengths_, slot);
+    MoveLastInto(gapLengths_, slot);
+    MoveLastInto(colors_, slot);
+    MoveLastInto(opacities_, slot);
+    MoveLastInto(flags_, slot);
+    MoveLastInto(layerIds_, slot);
+    MoveLastInto(pointOffsets_, slot);
+    MoveLastInto(pointCounts_, slot);
+    CompactIfFragmented();
+    return true;
+}
+
+void RoadMarkupStore::Clear()
+{
+    for (const uint32_t id : ids_) {
+        slotById_[id] = kNoSlot;
+    }
+    ids_.clear();
+    types_.clear();
+    widths_.clear();
+    lengths_.clear();
+    rotations_.clear();
+    dashLengths_.clear();
+    gapLengths_.clear();
+    colors_.clear();
+    opacities_.clear();
+    flags_.clear();
+    layerIds_.clear();
+    pointOffsets_.clear();
+    pointCounts_.clear();
+    points_.clear();
+    deadPoints_ = 0;
+}
+
+size_t RoadMarkupStore::MemoryBytes() const
+{
+    const size_t perRow = sizeof(uint32_t) * 5 + sizeof(RoadMarkupType) + sizeof(float) * 6 + sizeof(uint8_t);
+    return ids_.capacity() * perRow + slotById_.capacity() * sizeof(uint32_t) +
+           points_.capacity() * sizeof(RoadDecalPoint);
+}
+
+bool RoadMarkupStore::Get(const uint32_t id, RoadMarkupStroke& out) const
+{
+    const uint32_t slot = SlotOf(id);
+    if (slot == kNoSlot) {
+        return false;
+    }
+    out.type = types_[slot];
+    out.width = widths_[slot];
+    out.length = lengths_[slot];
+    out.rotation = rotations_[slot];
+    out.dashed = (flags_[slot] & kFlagDashed) != 0;
+    out.dashLength = dashLengths_[slot];
+    out.gapLength = gapLengths_[slot];
+    out.color = colors_[slot];
+    out.opacity = opacities_[slot];
+    out.visible = (flags_[slot] & kFlagVisible) != 0;
+    out.layerId = layerIds_[slot];
+    out.id = id;
+    const RoadDecalPoint* first = points_.data() + pointOffsets_[slot];
+    out.points.assign(first, first + pointCounts_[slot]);
+    return true;
+}
+
+std::span<const RoadDecalPoint> RoadMarkupStore::Points(const uint32_t id) const
+{
+    const uint32_t slot = SlotOf(id);
+    if (slot == kNoSlot) {
+        return {};
+    }
+    return {points_.data() + pointOffsets_[slot], pointCounts_[slot]};
+}
+
+std::span<RoadDecalPoint> RoadMarkupStore::MutablePoints(const uint32_t id)
+{
+    const uint32_t slot = SlotOf(id);
+    if (slot == kNoSlot) {
+        return {};
+    }
+    return {points_.data() + pointOffsets_[slot], pointCounts_[slot]};
+}
+
+bool RoadMarkupStore::SetPoints(const uint32_t id, const std::span<const RoadDecalPoint> points)
+{
+    const uint32_t slot = SlotOf(id);
+    if (slot == kNoSlot) {
+        return false;
+    }
+    if (points.size() == pointCounts_[slot]) {
+        std::copy(points.begin(), points.end(), points_.begin() + pointOffsets_[slot]);
+        return true;
+    }
+    ReleasePoints(slot);
+    pointOffsets_[slot] = AppendPoints(points);
+    pointCounts_[slot] = static_cast<uint32_t>(points.size());
+    CompactIfFragmented();
+    return true;
+}
+
+RoadMarkupType RoadMarkupStore::Type(const uint32_t id) const
+{
+    const uint32_t slot = SlotOf(id);
+    return slot != kNoSlot ? types_[slot] : RoadMarkupType::SolidWhiteLine;
+}
+
+uint32_t RoadMarkupStore::LayerId(const uint32_t id) const
+{
+    const uint32_t slot = SlotOf(id);
+    return slot != kNoSlot ? layerIds_[slot] : 0;
+}
+
+bool RoadMarkupStore::Visible(const uint32_t id) const
+{
+    const uint32_t slot = SlotOf(id);
+    return slot != kNoSlot && (flags_[slot] & kFlagVisible) != 0;
+}
+
+float RoadMarkupStore::Rotation(const uint32_t id) const
+{
+    const uint32_t slot = SlotOf(id);
+    return slot != kNoSlot ? rotations_[slot] : 0.0f;
+}
+
+void RoadMarkupStore::SetRotation(const uint32_t id, const float rotation)
+{
+    const uint32_t slot = SlotOf(id);
+    if (slot != kNoSlot) {
+        rotations_[slot] = rotation;
+    }
+}
+
+RoadMarkupStrokeStyle RoadMarkupStore::Style(const uint32_t id) const
+{
+    const uint32_t slot = SlotOf(id);
+    if (slot == kNoSlot) {
+        return {};
+    }
+    RoadMarkupStrokeStyle style;
+    style.width = widths_[slot];
+    style.length = lengths_[slot];
+    style.dashed = (flags_[slot] & kFlagDashed) != 0;
+    style.dashLength = dashLengths_[slot];
+    style.gapLength = gapLengths_[slot];
+    style.color = colors_[slot];
+    style.opacity = opacities_[slot];
+    style.visible = (flags_[slot] & kFlagVisible) != 0;
+    return style;
+}
+
+void RoadMarkupStore::SetStyle(const uint32_t id, const RoadMarkupStrokeStyle& style)
+{
+    const uint32_t slot = SlotOf(id);
+    if (slot == kNoSlot) {
+        return;
+    }
+    widths_[slot] = style.width;
+    lengths_[slot] = style.length;
+    dashLengths_[slot] = style.dashLength;
+    gapLengths_[slot] = style.gapLength;
+    colors_[slot] = style.color;
+    opacities_[slot] = style.opacity;
+    flags_[slot] = static_cast<uint8_t>((style.dashed ? kFlagDashed : 0) | (style.visible ? kFlagVisible : 0));
+}
+
+uint32_t RoadMarkupStore::SlotOf(const uint32_t id) const
+{
+    return id < slotById_.size() ? slotById_[id] : kNoSlot;
+}
+
+uint32_t RoadMarkupStore::AppendPoints(const std::span<const RoadDecalPoint> points)
+{
+    const auto offset = static_cast<uint32_t>(points_.size());
+    points_.insert(points_.end(), points.begin(), points.end());
+    return offset;
+}
+
+void RoadMarkupStore::ReleasePoints(const uint32_t slot)
+{
+    const uint32_t offset = pointOffsets_[slot];
+    const uint32_t count = pointCounts_[slot];
+    if (offset + count == points_.size()) {
+        points_.resize(offset); // The newest stroke gives its points straight back, as undo does.
+    }
+    else {
+        deadPoints_ += count;
+    }
+    pointCounts_[slot] = 0;
+}
+
+void RoadMarkupStore::CompactIfFragmented()
+{
+    if (deadPoints_ < kMinCompactPoints || deadPoints_ * 2 < points_.size()) {
+        return;
+    }
+
+    // Repack in row order.
+    std::vector<RoadDecalPoint> packed;
+    packed.reserve(points_.size() - deadPoints_);
+    for (size_t slot = 0; slot < ids_.size(); ++slot) {
+        const uint32_t offset = pointOffsets_[slot];
+        pointOffsets_[slot] = static_cast<uint32_t>(packed.size());
+        packed.insert(packed.end(), points_.begin() + offset, points_.begin() + offset + pointCounts_[slot]);
+    }
+    points_.swap(packed);
+    deadPoints_ = 0;
+}
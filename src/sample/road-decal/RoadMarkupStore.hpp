@@ -0,0 +1,89 @@
+#pragma once
+
+#include "RoadDecalData.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <vector>
+
+// All committed road markings, stored as columns with every point in one shared pool.
+//
+// RoadMarkupStroke stays the type strokes are built and tessellated as; the store is where they live once committed.
+// Each stroke is a row across the metadata columns plus an offset and count into the point pool, so a stroke costs no
+// allocation of its own and walking many of them stays in a few contiguous arrays. Strokes are addressed by an id that
+// never changes and is never reused; rows move when other strokes are removed, ids do not.
+//
+// The point pool only appends. Removed or resized strokes leave dead points behind, which are compacted away once they
+// outnumber the live ones.
+//
+// Example usage:
+//   RoadMarkupStore store;
+//   const uint32_t id = store.Add(stroke);
+//   for (RoadDecalPoint& p : store.MutablePoints(id)) {
+//       p.x += 1.0f;
+//   }
+//   RoadMarkupStroke copy;
+//   store.Get(id, copy);
+//
+
+class RoadMarkupStore
+{
+public:
+    // Copies the stroke in and returns its id, which is never 0.
+    uint32_t Add(const RoadMarkupStroke& stroke);
+    bool Remove(uint32_t id);
+    // Removes every stroke. Ids already handed out stay unused.
+    void Clear();
+
+    [[nodiscard]] bool Contains(uint32_t id) const { return SlotOf(id) != kNoSlot; }
+    [[nodiscard]] size_t Size() const { return ids_.size(); }
+    [[nodiscard]] uint32_t IdAt(size_t row) const { return ids_[row]; }
+    [[nodiscard]] size_t LivePointCount() const { return points_.size() - deadPoints_; }
+    [[nodiscard]] size_t MemoryBytes() const;
+
+    // Copies the stroke out, reusing the capacity of out.points. Returns false for an unknown id.
+    bool Get(uint32_t id, RoadMarkupStroke& out) const;
+
+    // Valid until the next Add, Remove or SetPoints.
+    [[nodiscard]] std::span<const RoadDecalPoint> Points(uint32_t id) const;
+    [[nodiscard]] std::span<RoadDecalPoint> MutablePoints(uint32_t id);
+    bool SetPoints(uint32_t id, std::span<const RoadDecalPoint> points);
+
+    [[nodiscard]] RoadMarkupType Type(uint32_t id) const;
+    [[nodiscard]] uint32_t LayerId(uint32_t id) const;
+    [[nodiscard]] bool Visible(uint32_t id) const;
+    [[nodiscard]] float Rotation(uint32_t id) const;
+    void SetRotation(uint32_t id, float rotation);
+    [[nodiscard]] RoadMarkupStrokeStyle Style(uint32_t id) const;
+    void SetStyle(uint32_t id, const RoadMarkupStrokeStyle& style);
+
+private:
+    static constexpr uint32_t kNoSlot = 0xFFFFFFFFu;
+    static constexpr uint8_t kFlagDashed = 1u << 0;
+    static constexpr uint8_t kFlagVisible = 1u << 1;
+
+    [[nodiscard]] uint32_t SlotOf(uint32_t id) const;
+    uint32_t AppendPoints(std::span<const RoadDecalPoint> points);
+    void ReleasePoints(uint32_t slot);
+    void CompactIfFragmented();
+
+    // One row per stroke.
+    std::vector<uint32_t> ids_{};
+    std::vector<RoadMarkupType> types_{};
+    std::vector<float> widths_{};
+    std::vector<float> lengths_{};
+    std::vector<float> rotations_{};
+    std::vector<float> dashLengths_{};
+    std::vector<float> gapLengths_{};
+    std::vector<uint32_t> colors_{};
+    std::vector<float> opacities_{};
+    std::vector<uint8_t> flags_{};
+    std::vector<uint32_t> layerIds_{};
+    std::vector<uint32_t> pointOffsets_{};
+    std::vector<uint32_t> pointCounts_{};
+
+    std::vector<uint32_t> slotById_{};      // Indexed by id; kNoSlot once removed.
+    std::vector<RoadDecalPoint> points_{};
+    size_t deadPoints_ = 0;
+};
@@ -0,0 +1,343 @@
+#include "sample/world-projection/WorldBillboardLayer.hpp"
+
+#include <algorithm>
+#include <cstring>
+
+namespace {
+    constexpr uint32_t kImagePadding = 1;   // Extruded border around every image.
+    constexpr uint32_t kMaxVertices16 = 0xFFFF;
+}
+
+WorldBillboardLayer::WorldBillboardLayer() = default;
+
+WorldBillboardLayer::~WorldBillboardLayer() {
+    Shutdown();
+}
+
+bool WorldBillboardLayer::Init(cIGZImGuiService* imguiService) {
+    Shutdown();
+    imguiService_ = imguiService;
+    return imguiService_ != nullptr;
+}
+
+void WorldBillboardLayer::Shutdown() {
+    pages_.clear();
+    images_.clear();
+    Clear();
+    imguiService_ = nullptr;
+}
+
+WorldBillboardLayer::ImageId WorldBillboardLayer::AddImage(const void* rgbaPixels, const uint32_t width,
+                                                           const uint32_t height) {
+    if (!rgbaPixels || width == 0 || height == 0 || width + 2 * kImagePadding > kPageSize ||
+        height + 2 * kImagePadding > kPageSize) {
+        return kInvalidImage;
+    }
+
+    const auto* rgba = static_cast<const uint8_t*>(rgbaPixels);
+    Image image{};
+    if (pages_.empty() || !PackImage(rgba, width, height, image)) {
+        pages_.emplace_back();
+        pages_.back().pixels.assign(static_cast<size_t>(kPageSize) * kPageSize * 4, 0);
+        if (!PackImage(rgba, width, height, image)) {
+            return kInvalidImage;
+        }
+    }
+    images_.push_back(image);
+    return static_cast<ImageId>(images_.size());
+}
+
+bool WorldBillboardLayer::PackImage(const uint8_t* rgba, const uint32_t width, const uint32_t height,
+                                    Image& outImage) {
+    // Shelf packing into the newest page: images fill a row left to right, and a new row starts below the tallest
+    // image of the previous one.
+    Page& page = pages_.back();
+    const uint32_t paddedWidth = width + 2 * kImagePadding;
+    const uint32_t paddedHeight = height + 2 * kImagePadding;
+    uint32_t x = page.shelfX;
+    uint32_t y = page.shelfY;
+    uint32_t shelfHeight = page.shelfHeight;
+    if (x + paddedWidth > kPageSize) {
+        x = 0;
+        y += shelfHeight;
+        shelfHeight = 0;
+    }
+    if (y + paddedHeight > kPageSize) {
+        return false;
+    }
+
+    // Copy with the image's edge pixels repeated into the padding.
+    for (uint32_t row = 0; row < paddedHeight; ++row) {
+        const uint32_t srcY = std::clamp<int64_t>(static_cast<int64_t>(row) - kImagePadding, 0, height - 1);
+        uint8_t* dst = page.pixels.data() + ((static_cast<size_t>(y) + row) * kPageSize + x) * 4;
+        const uint8_t* src = rgba + static_cast<size_t>(srcY) * width * 4;
+        std::memcpy(dst, src, 4);
+        std::memcpy(dst + kImagePadding * 4, src, static_cast<size_t>(width) * 4);
+        std::memcpy(dst + (kImagePadding + width) * 4, src + (width - 1) * 4, 4);
+    }
+
+    page.shelfX = x + paddedWidth;
+    page.shelfY = y;
+    page.shelfHeight = (std::max)(shelfHeight, paddedHeight);
+    page.dirty = true;
+
+    constexpr float kTexel = 1.0f / static_cast<float>(kPageSize);
+    outImage.page = static_cast<uint32_t>(pages_.size() - 1);
+    outImage.uv0 = ImVec2(static_cast<float>(x + kImagePadding) * kTexel,
+                          static_cast<float>(y + kImagePadding) * kTexel);
+    outImage.uv1 = ImVec2(static_cast<float>(x + kImagePadding + width) * kTexel,
+                          static_cast<float>(y + kImagePadding + height) * kTexel);
+    outImage.aspect = static_cast<float>(height) / static_cast<float>(width);
+    return true;
+}
+
+WorldBillboardLayer::SpriteId WorldBillboardLayer::Add(const WorldBillboardDesc& desc) {
+    if (nextId_ == kInvalidSprite) {
+        ++nextId_;
+    }
+    const SpriteId id = nextId_++;
+    indexOfId_.emplace(id, static_cast<uint32_t>(ids_.size()));
+    ids_.push_back(id);
+    sprites_.emplace_back().desc = desc;
+    return id;
+}
+
+bool WorldBillboardLayer::Update(const SpriteId id, const WorldBillboardDesc& desc) {
+    const auto it = indexOfId_.find(id);
+    if (it == indexOfId_.end()) {
+        return false;
+    }
+    Sprite& sprite = sprites_[it->second];
+    sprite.desc = desc;
+    sprite.draped = false;
+    return true;
+}
+
+bool WorldBillboardLayer::SetPosition(const SpriteId id, const float x, const float y, const float z) {
+    const auto it = indexOfId_.find(id);
+    if (it == indexOfId_.end()) {
+        return false;
+    }
+    Sprite& sprite = sprites_[it->second];
+    sprite.desc.position[0] = x;
+    sprite.desc.position[1] = y;
+    sprite.desc.position[2] = z;
+    sprite.draped = false;
+    return true;
+}
+
+bool WorldBillboardLayer::Remove(const SpriteId id) {
+    const auto it = indexOfId_.find(id);
+    if (it == indexOfId_.end()) {
+        return false;
+    }
+
+    // Swap with the last sprite to keep storage dense.
+    const uint32_t index = it->second;
+    const auto last = static_cast<uint32_t>(ids_.size() - 1);
+    if (index != last) {
+        sprites_[index] = sprites_[last];
+        ids_[index] = ids_[last];
+        indexOfId_[ids_[index]] = index;
+    }
+    sprites_.pop_back();
+    ids_.pop_back();
+    indexOfId_.erase(it);
+    return true;
+}
+
+void WorldBillboardLayer::Clear() {
+    sprites_.clear();
+    ids_.clear();
+    indexOfId_.clear();
+}
+
+void WorldBillboardLayer::Drape(Sprite& sprite, const WorldBillboardDrawOptions& options) const {
+    const WorldBillboardDesc& desc = sprite.desc;
+    const float x = desc.position[0] + desc.offsetX;
+    const float z = desc.position[2] + desc.offsetY;
+    const float half = desc.size * 0.5f;
+    const float corners[4][2] = {
+        {x - half, z - half}, {x + half, z - half}, {x + half, z + half}, {x - half, z + half}
+    };
+    for (int c = 0; c < 4; ++c) {
+        float* corner = sprite.corners + c * 3;
+        corner[0] = corners[c][0];
+        corner[1] = desc.position[1];
+        corner[2] = corners[c][1];
+        if (options.heightfield && HeightfieldContains(*options.heightfield, corner[0], corner[2])) {
+            corner[1] = options.snapToGrid ? SampleHeightfieldNearest(*options.heightfield, corner[0], corner[2])
+                                           : SampleHeightfield(*options.heightfield, corner[0], corner[2]);
+        }
+    }
+    sprite.draped = true;
+}
+
+bool WorldBillboardLayer::UploadPage(Page& page) {
+    if (!page.texture.Create(imguiService_, kPageSize, kPageSize, page.pixels.data())) {
+        return false;
+    }
+    page.dirty = false;
+    return true;
+}
+
+void WorldBillboardLayer::Draw(cIGZS3DCameraService* cameraService, const S3DCameraHandle camera,
+                               ImDrawList* drawList, const WorldBillboardDrawOptions& options) {
+    stats_ = {};
+    stats_.total = static_cast<uint32_t>(sprites_.size());
+    if (!cameraService || !camera.ptr || !drawList || !imguiService_ || sprites_.empty()) {
+        return;
+    }
+
+    const uint32_t heightfieldVersion = options.heightfield ? options.heightfield->version : 0;
+    if (heightfieldVersion != drapeVersion_ || options.snapToGrid != drapeSnap_) {
+        for (Sprite& sprite : sprites_) {
+            sprite.draped = false;
+        }
+        drapeVersion_ = heightfieldVersion;
+        drapeSnap_ = options.snapToGrid;
+    }
+
+    // One point per screen sprite and four per ground sprite, all projected in one call.
+    const size_t count = sprites_.size();
+    points_.clear();
+    firstPoint_.resize(count);
+    for (size_t i = 0; i < count; ++i) {
+        Sprite& sprite = sprites_[i];
+        firstPoint_[i] = static_cast<uint32_t>(points_.size() / 3);
+        if (sprite.desc.mode == WorldBillboardMode::Ground) {
+            if (!sprite.draped) {
+                Drape(sprite, options);
+                ++stats_.draped;
+            }
+            points_.insert(points_.end(), sprite.corners, sprite.corners + 12);
+        }
+        else {
+            points_.insert(points_.end(), sprite.desc.position, sprite.desc.position + 3);
+        }
+    }
+
+    const size_t pointCount = points_.size() / 3;
+    projected_.resize(points_.size());
+    inFront_.resize(pointCount);
+    if (!cameraService->ProjectBatch(camera, points_.data(), pointCount, projected_.data(), inFront_.data())) {
+        return;
+    }
+
+    visible_.clear();
+    for (uint32_t i = 0; i < count; ++i) {
+        const WorldBillboardDesc& desc = sprites_[i].desc;
+        if (desc.image == kInvalidImage || desc.image > images_.size()) {
+            continue;
+        }
+        const Image& image = images_[desc.image - 1];
+        const uint32_t first = firstPoint_[i];
+        const float* screen = projected_.data() + static_cast<size_t>(first) * 3;
+
+        Visible sprite{};
+        sprite.index = i;
+        sprite.page = image.page;
+        if (desc.mode == WorldBillboardMode::Ground) {
+            if (!inFront_[first] || !inFront_[first + 1] || !inFront_[first + 2] || !inFront_[first + 3]) {
+                continue;
+            }
+            for (int c = 0; c < 4; ++c) {
+                sprite.points[c] = ImVec2(screen[c * 3 + 0], screen[c * 3 + 1]);
+                sprite.depth += screen[c * 3 + 2] * 0.25f;
+            }
+        }
+        else {
+            if (!inFront_[first]) {
+                continue;
+            }
+            const float cx = screen[0] + desc.offsetX;
+            const float cy = screen[1] + desc.offsetY;
+            const float halfWidth = desc.size * 0.5f;
+            const float halfHeight = halfWidth * image.aspect;
+            sprite.points[0] = ImVec2(cx - halfWidth, cy - halfHeight);
+            sprite.points[1] = ImVec2(cx + halfWidth, cy - halfHeight);
+            sprite.points[2] = ImVec2(cx + halfWidth, cy + halfHeight);
+            sprite.points[3] = ImVec2(cx - halfWidth, cy + halfHeight);
+            sprite.depth = screen[2];
+        }
+
+        float minX = sprite.points[0].x;
+        float maxX = minX;
+        float minY = sprite.points[0].y;
+        float maxY = minY;
+        for (int c = 1; c < 4; ++c) {
+            minX = (std::min)(minX, sprite.points[c].x);
+            maxX = (std::max)(maxX, sprite.points[c].x);
+            minY = (std::min)(minY, sprite.points[c].y);
+            maxY = (std::max)(maxY, sprite.points[c].y);
+        }
+        if (maxX <= 0.0f || maxY <= 0.0f || minX >= options.displayWidth || minY >= options.displayHeight) {
+            continue;
+        }
+        visible_.push_back(sprite);
+    }
+    stats_.visible = static_cast<uint32_t>(visible_.size());
+    if (visible_.empty()) {
+        return;
+    }
+
+    std::sort(visible_.begin(), visible_.end(), [](const Visible& a, const Visible& b) { return a.depth > b.depth; });
+
+    // Without vertex offsets a draw list with 16-bit indices cannot address more than 64K vertices; drop the farthest.
+    if (sizeof(ImDrawIdx) == 2 && !(drawList->Flags & ImDrawListFlags_AllowVtxOffset)) {
+        const uint32_t used = (std::min)(drawList->_VtxCurrentIdx, kMaxVertices16);
+        const size_t budget = (kMaxVertices16 - used) / 4;
+        if (visible_.size() > budget) {
+            visible_.erase(visible_.begin(), visible_.end() - static_cast<ptrdiff_t>(budget));
+            stats_.vertexLimitReached = true;
+        }
+    }
+
+    // Stable counting sort by page keeps the far-to-near order within each page. Sprites on different pages do not
+    // interleave, so images that overlap in the world should share a page.
+    pageStarts_.assign(pages_.size() + 1, 0);
+    for (const Visible& sprite : visible_) {
+        ++pageStarts_[sprite.page + 1];
+    }
+    for (size_t p = 1; p < pageStarts_.size(); ++p) {
+        pageStarts_[p] += pageStarts_[p - 1];
+    }
+    byPage_.resize(visible_.size());
+    for (const Visible& sprite : visible_) {
+        byPage_[pageStarts_[sprite.page]++] = sprite;
+    }
+
+    uint32_t begin = 0;
+    for (size_t p = 0; p < pages_.size(); ++p) {
+        const uint32_t end = pageStarts_[p];
+        const uint32_t pageCount = end - begin;
+        const uint32_t pageBegin = begin;
+        begin = end;
+        if (pageCount == 0) {
+            continue;
+        }
+
+        Page& page = pages_[p];
+        void* textureId = page.dirty ? nullptr : page.texture.GetID();
+        if (!textureId && UploadPage(page)) {
+            textureId = page.texture.GetID();
+        }
+        if (!textureId) {
+            continue;
+        }
+
+        drawList->PushTextureID(textureId);
+        drawList->PrimReserve(static_cast<int>(pageCount * 6), static_cast<int>(pageCount * 4));
+        for (uint32_t s = pageBegin; s < end; ++s) {
+            const Visible& sprite = byPage_[s];
+            const WorldBillboardDesc& desc = sprites_[sprite.index].desc;
+            const Image& image = images_[desc.image - 1];
+            drawList->PrimQuadUV(sprite.points[0], sprite.points[1], sprite.points[2], sprite.points[3], image.uv0,
+                                 ImVec2(image.uv1.x, image.uv0.y), image.uv1, ImVec2(image.uv0.x, image.uv1.y),
+                                 desc.tint);
+        }
+        drawList->PopTextureID();
+        stats_.drawn += pageCount;
+        ++stats_.pages;
+    }
+}
@@ -0,0 +1,163 @@
+#pragma once
+
+#include "imgui.h"
+#include "public/ImGuiTexture.h"
+#include "public/TerrainHeightfield.h"
+#include "public/cIGZS3DCameraService.h"
+
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+// Retained world-anchored sprites whose images are packed into shared atlas pages.
+//
+// Images are copied into 1024x1024 pages once, with a one pixel extruded border so bilinear filtering does not bleed
+// between neighbours. Sprites reference an image and are added, updated and removed by ID. Every frame the layer
+// projects all sprites with one ProjectBatch call, culls those behind the camera or off screen, sorts the rest far to
+// near and emits every sprite of a page under a single texture, which ImGui turns into one draw command per page.
+// Ground sprites are quads lying on the terrain; their corner heights come from the shared heightfield and are cached
+// until its version changes.
+//
+// Render thread only.
+//
+// Example usage:
+//   WorldBillboardLayer billboards;
+//   billboards.Init(imguiService);
+//   const WorldBillboardLayer::ImageId icon = billboards.AddImage(rgbaPixels, 32, 32);
+//   WorldBillboardDesc desc{};
+//   desc.position[0] = x; desc.position[1] = y; desc.position[2] = z;
+//   desc.image = icon;
+//   const WorldBillboardLayer::SpriteId id = billboards.Add(desc);
+//
+//   // Every frame:
+//   WorldBillboardDrawOptions options{};
+//   options.displayWidth = io.DisplaySize.x;
+//   options.displayHeight = io.DisplaySize.y;
+//   options.heightfield = heightfield;  // Optional; ground sprites stay flat without it.
+//   billboards.Draw(cameraService, cameraHandle, ImGui::GetBackgroundDrawList(), options);
+//
+
+enum class WorldBillboardMode : uint8_t {
+    Screen,     // Camera-facing, `size` pixels wide, centered on the projected anchor plus the pixel offset.
+    Ground,     // Lying on the terrain, `size` world units wide, centered on the anchor plus the world x/z offset.
+};
+
+struct WorldBillboardDesc {
+    float position[3]{};
+    uint32_t image = 0;         // From WorldBillboardLayer::AddImage.
+    float size = 32.0f;
+    float offsetX = 0.0f;
+    float offsetY = 0.0f;       // Screen y for Screen sprites, world z for Ground sprites.
+    ImU32 tint = IM_COL32_WHITE;
+    WorldBillboardMode mode = WorldBillboardMode::Screen;
+};
+
+struct WorldBillboardDrawOptions {
+    float displayWidth = 0.0f;
+    float displayHeight = 0.0f;
+    /// Drapes ground sprites. Must stay acquired until Draw returns.
+    const TerrainHeightfieldView* heightfield = nullptr;
+    bool snapToGrid = false;    // Ground corners take the nearest vertex height instead of interpolating.
+};
+
+struct WorldBillboardFrameStats {
+    uint32_t total = 0;
+    uint32_t visible = 0;       // In front of the camera and on screen.
+    uint32_t drawn = 0;
+    uint32_t pages = 0;         // Atlas pages drawn, one draw command each.
+    uint32_t draped = 0;        // Ground sprites whose corner heights were sampled this frame.
+    bool vertexLimitReached = false;    // The farthest sprites were dropped to stay within 16-bit indices.
+};
+
+class WorldBillboardLayer {
+public:
+    using SpriteId = uint32_t;
+    using ImageId = uint32_t;
+    static constexpr SpriteId kInvalidSprite = 0;
+    static constexpr ImageId kInvalidImage = 0;
+    static constexpr uint32_t kPageSize = 1024;
+
+    WorldBillboardLayer();
+    ~WorldBillboardLayer();
+
+    WorldBillboardLayer(const WorldBillboardLayer&) = delete;
+    WorldBillboardLayer& operator=(const WorldBillboardLayer&) = delete;
+
+    bool Init(cIGZImGuiService* imguiService);
+    /// Releases the pages and forgets all images and sprites.
+    void Shutdown();
+
+    /// Copies RGBA32 pixels into an atlas page, opening a new page when the current ones are full. Returns
+    /// kInvalidImage if the image does not fit on an empty page. Pages upload on the next Draw.
+    ImageId AddImage(const void* rgbaPixels, uint32_t width, uint32_t height);
+    [[nodiscard]] size_t PageCount() const { return pages_.size(); }
+
+    SpriteId Add(const WorldBillboardDesc& desc);
+    bool Update(SpriteId id, const WorldBillboardDesc& desc);
+    bool SetPosition(SpriteId id, float x, float y, float z);
+    bool Remove(SpriteId id);
+    void Clear();
+    [[nodiscard]] size_t Size() const { return ids_.size(); }
+
+    void Draw(cIGZS3DCameraService* cameraService, S3DCameraHandle camera, ImDrawList* drawList,
+              const WorldBillboardDrawOptions& options);
+    [[nodiscard]] const WorldBillboardFrameStats& Stats() const { return stats_; }
+
+private:
+    struct Page {
+        std::vector<uint8_t> pixels;
+        ImGuiTexture texture;
+        uint32_t shelfX = 0;        // Next free column on the current shelf.
+        uint32_t shelfY = 0;        // Top of the current shelf.
+        uint32_t shelfHeight = 0;
+        bool dirty = true;          // Pixels changed since the last upload.
+    };
+
+    struct Image {
+        uint32_t page;
+        ImVec2 uv0;
+        ImVec2 uv1;
+        float aspect;               // Height over width, for screen sprites.
+    };
+
+    struct Sprite {
+        WorldBillboardDesc desc;
+        float corners[12]{};        // Ground corners, xyz; heights valid when draped.
+        bool draped = false;
+    };
+
+    struct Visible {
+        uint32_t index;
+        uint32_t page;
+        float depth;
+        ImVec2 points[4];           // Screen quad, clockwise from the top left of the image.
+    };
+
+    bool PackImage(const uint8_t* rgba, uint32_t width, uint32_t height, Image& outImage);
+    void Drape(Sprite& sprite, const WorldBillboardDrawOptions& options) const;
+    bool UploadPage(Page& page);
+
+    cIGZImGuiService* imguiService_ = nullptr;
+    std::vector<Page> pages_{};
+    std::vector<Image> images_{};   // ImageId - 1.
+
+    std::vector<Sprite> sprites_{};
+    std::vector<SpriteId> ids_{};
+    std::unordered_map<SpriteId, uint32_t> indexOfId_{};
+    SpriteId nextId_ = 1;
+
+    // Heightfield the cached ground corners were sampled from.
+    uint32_t drapeVersion_ = 0;
+    bool drapeSnap_ = false;
+
+    // Per-frame scratch, reused to avoid reallocating.
+    std::vector<float> points_{};
+    std::vector<uint32_t> firstPoint_{};
+    std::vector<float> projected_{};
+    std::vector<uint8_t> inFront_{};
+    std::vector<Visible> visible_{};
+    std::vector<Visible> byPage_{};
+    std::vector<uint32_t> pageStarts_{};
+
+    WorldBillboardFrameStats stats_{};
+};
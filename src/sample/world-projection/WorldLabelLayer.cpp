@@ -0,0 +1,568 @@
+#include "sample/world-projection/WorldLabelLayer.hpp"
+
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+
+namespace {
+    constexpr int kOutlineRadius = 1;                       // Pixels the baked outline extends around each glyph.
+    constexpr int kGlyphPadding = 2 * kOutlineRadius + 1;   // Keeps neighbouring dilated glyphs apart in the atlas.
+    constexpr float kShadowOffset = 2.0f;
+    constexpr ImVec2 kBackgroundPad(4.0f, 2.0f);
+    constexpr float kLeaderThickness = 1.5f;
+    constexpr float kDeclutterCellSize = 64.0f;
+    constexpr float kOcclusionClearance = 8.0f;    // Sight line start, so ground labels are not hidden by their own cell.
+    constexpr float kOcclusionBias = 2.0f;         // Terrain must rise this far above the sight line to hide a label.
+    constexpr uint32_t kMaxOcclusionSteps = 256;
+    constexpr uint32_t kMaxVertices16 = 0xFFFF;
+
+    // Decodes one UTF-8 code point; malformed input yields U+FFFD and advances one byte.
+    const char* DecodeUtf8(const char* text, const char* end, uint32_t& outCodepoint) {
+        const auto lead = static_cast<uint8_t>(*text);
+        const uint32_t length = lead < 0x80            ? 1
+                                : (lead >> 5) == 0x6   ? 2
+                                : (lead >> 4) == 0xE   ? 3
+                                : (lead >> 3) == 0x1E  ? 4
+                                                       : 0;
+        if (length == 0 || text + length > end) {
+            outCodepoint = 0xFFFD;
+            return text + 1;
+        }
+        uint32_t codepoint = length == 1 ? lead : lead & (0x7Fu >> length);
+        for (uint32_t i = 1; i < length; ++i) {
+            const auto next = static_cast<uint8_t>(text[i]);
+            if ((next & 0xC0) != 0x80) {
+                outCodepoint = 0xFFFD;
+                return text + 1;
+            }
+            codepoint = (codepoint << 6) | (next & 0x3F);
+        }
+        outCodepoint = codepoint;
+        return text + length;
+    }
+
+    ImU32 ScaleAlpha(const ImU32 color, const float scale) {
+        const auto alpha = static_cast<uint32_t>(static_cast<float>((color >> IM_COL32_A_SHIFT) & 0xFF) * scale + 0.5f);
+        return (color & ~IM_COL32_A_MASK) | ((std::min)(alpha, 255u) << IM_COL32_A_SHIFT);
+    }
+
+    bool Overlaps(const ImVec4& a, const ImVec4& b) {
+        return a.x < b.z && b.x < a.z && a.y < b.w && b.y < a.w;
+    }
+}
+
+WorldLabelLayer::WorldLabelLayer() = default;
+
+WorldLabelLayer::~WorldLabelLayer() {
+    Shutdown();
+}
+
+bool WorldLabelLayer::Init(cIGZImGuiService* imguiService, const float fontSize) {
+    Shutdown();
+    if (!imguiService) {
+        return false;
+    }
+
+    fontAtlas_ = IM_NEW(ImFontAtlas)();
+    fontAtlas_->TexGlyphPadding = kGlyphPadding;
+    ImFontConfig config;
+    config.SizePixels = (std::max)(fontSize, 6.0f);
+    font_ = fontAtlas_->AddFontDefault(&config);
+    if (!font_ || !fontAtlas_->Build()) {
+        Shutdown();
+        return false;
+    }
+
+    unsigned char* alpha = nullptr;
+    int width = 0;
+    int height = 0;
+    fontAtlas_->GetTexDataAsAlpha8(&alpha, &width, &height);
+    if (!alpha || width <= 0 || height <= 0) {
+        Shutdown();
+        return false;
+    }
+
+    // Glyphs in the top half, the same glyphs dilated by kOutlineRadius in the bottom half. Both halves share the
+    // atlas layout, so a glyph's outline is its own UV rectangle shifted down by half the texture.
+    const auto w = static_cast<size_t>(width);
+    const auto h = static_cast<size_t>(height);
+    fontPixels_.assign(w * h * 2 * 4, 255);
+    for (size_t y = 0; y < h; ++y) {
+        for (size_t x = 0; x < w; ++x) {
+            uint8_t dilated = 0;
+            for (int dy = -kOutlineRadius; dy <= kOutlineRadius; ++dy) {
+                for (int dx = -kOutlineRadius; dx <= kOutlineRadius; ++dx) {
+                    const auto sx = static_cast<ptrdiff_t>(x) + dx;
+                    const auto sy = static_cast<ptrdiff_t>(y) + dy;
+                    if (sx >= 0 && sy >= 0 && sx < width && sy < height) {
+                        dilated = (std::max)(dilated, alpha[static_cast<size_t>(sy) * w + static_cast<size_t>(sx)]);
+                    }
+                }
+            }
+            fontPixels_[(y * w + x) * 4 + 3] = alpha[y * w + x];
+            fontPixels_[((y + h) * w + x) * 4 + 3] = dilated;
+        }
+    }
+
+    fontWidth_ = static_cast<uint32_t>(width);
+    fontHeight_ = static_cast<uint32_t>(height);
+    whiteUv_ = ImVec2(fontAtlas_->TexUvWhitePixel.x, fontAtlas_->TexUvWhitePixel.y * 0.5f);
+    imguiService_ = imguiService;
+    ++fontBuild_;
+    fontTexture_.Create(imguiService_, fontWidth_, fontHeight_ * 2, fontPixels_.data());
+    return true;
+}
+
+void WorldLabelLayer::Shutdown() {
+    fontTexture_.Release();
+    if (fontAtlas_) {
+        IM_DELETE(fontAtlas_);
+        fontAtlas_ = nullptr;
+    }
+    font_ = nullptr;
+    fontPixels_.clear();
+    fontWidth_ = 0;
+    fontHeight_ = 0;
+    imguiService_ = nullptr;
+}
+
+WorldLabelLayer::LabelId WorldLabelLayer::Add(const WorldLabelDesc& desc) {
+    if (nextId_ == kInvalidLabel) {
+        ++nextId_;
+    }
+    const LabelId id = nextId_++;
+    indexOfId_.emplace(id, static_cast<uint32_t>(ids_.size()));
+    ids_.push_back(id);
+    labels_.emplace_back();
+    positions_.insert(positions_.end(), desc.position, desc.position + 3);
+    Assign(labels_.back(), desc);
+    return id;
+}
+
+bool WorldLabelLayer::Update(const LabelId id, const WorldLabelDesc& desc) {
+    const auto it = indexOfId_.find(id);
+    if (it == indexOfId_.end()) {
+        return false;
+    }
+    std::copy(desc.position, desc.position + 3, positions_.begin() + static_cast<ptrdiff_t>(it->second) * 3);
+    Assign(labels_[it->second], desc);
+    return true;
+}
+
+bool WorldLabelLayer::SetPosition(const LabelId id, const float x, const float y, const float z) {
+    const auto it = indexOfId_.find(id);
+    if (it == indexOfId_.end()) {
+        return false;
+    }
+    float* position = positions_.data() + static_cast<size_t>(it->second) * 3;
+    position[0] = x;
+    position[1] = y;
+    position[2] = z;
+    return true;
+}
+
+bool WorldLabelLayer::Remove(const LabelId id) {
+    const auto it = indexOfId_.find(id);
+    if (it == indexOfId_.end()) {
+        return false;
+    }
+
+    // Swap with the last label to keep storage dense.
+    const uint32_t index = it->second;
+    const auto last = static_cast<uint32_t>(ids_.size() - 1);
+    if (index != last) {
+        labels_[index] = std::move(labels_[last]);
+        std::copy_n(positions_.begin() + static_cast<ptrdiff_t>(last) * 3, 3,
+                    positions_.begin() + static_cast<ptrdiff_t>(index) * 3);
+        ids_[index] = ids_[last];
+        indexOfId_[ids_[index]] = index;
+    }
+    labels_.pop_back();
+    positions_.resize(positions_.size() - 3);
+    ids_.pop_back();
+    indexOfId_.erase(it);
+    return true;
+}
+
+void WorldLabelLayer::Clear() {
+    labels_.clear();
+    positions_.clear();
+    ids_.clear();
+    indexOfId_.clear();
+}
+
+void WorldLabelLayer::Draw(cIGZS3DCameraService* cameraService, const S3DCameraHandle camera, ImDrawList* drawList,
+                           const WorldLabelDrawOptions& options) {
+    stats_ = {};
+    stats_.total = static_cast<uint32_t>(labels_.size());
+    if (!cameraService || !camera.ptr || !drawList || !font_ || labels_.empty()) {
+        return;
+    }
+
+    void* textureId = fontTexture_.GetID();
+    if (!textureId && !fontPixels_.empty()) {
+        fontTexture_.Create(imguiService_, fontWidth_, fontHeight_ * 2, fontPixels_.data());
+        textureId = fontTexture_.GetID();
+    }
+    if (!textureId) {
+        return;
+    }
+
+    const size_t count = labels_.size();
+    projected_.resize(count * 3);
+    inFront_.resize(count);
+    if (!cameraService->ProjectBatch(camera, positions_.data(), count, projected_.data(), inFront_.data())) {
+        return;
+    }
+
+    candidates_.clear();
+    for (uint32_t i = 0; i < count; ++i) {
+        if (!inFront_[i]) {
+            continue;
+        }
+        ++stats_.inFront;
+
+        Label& label = labels_[i];
+        if (label.measuredFor != fontBuild_) {
+            Measure(label);
+        }
+        if (label.glyphs == 0) {
+            continue;
+        }
+
+        Candidate candidate{};
+        candidate.index = i;
+        candidate.screenX = projected_[i * 3 + 0];
+        candidate.screenY = projected_[i * 3 + 1];
+        candidate.depth = projected_[i * 3 + 2];
+        candidate.textPos = ImVec2(std::floor(candidate.screenX + label.offsetX - label.width * 0.5f + 0.5f),
+                                   std::floor(candidate.screenY + label.offsetY - label.height + 0.5f));
+
+        const ImVec2 pad = (label.flags & kWorldLabelBackground) ? kBackgroundPad
+                           : (label.flags & kWorldLabelOutline) ? ImVec2(kOutlineRadius, kOutlineRadius)
+                                                                : ImVec2(0.0f, 0.0f);
+        const float shadow = (label.flags & kWorldLabelShadow) ? kShadowOffset : 0.0f;
+        candidate.boundsMin = ImVec2(candidate.textPos.x - pad.x, candidate.textPos.y - pad.y);
+        candidate.boundsMax = ImVec2(candidate.textPos.x + label.width + (std::max)(pad.x, shadow),
+                                     candidate.textPos.y + label.height + (std::max)(pad.y, shadow));
+        if (candidate.boundsMax.x <= 0.0f || candidate.boundsMax.y <= 0.0f ||
+            candidate.boundsMin.x >= options.displayWidth || candidate.boundsMin.y >= options.displayHeight) {
+            continue;
+        }
+        ++stats_.onScreen;
+        candidates_.push_back(candidate);
+    }
+
+    // Terrain occlusion: march the sight line from each anchor toward the near plane, which UnProjectBatch gives for
+    // all labels in one call.
+    if (options.heightfield && !candidates_.empty()) {
+        UpdateHeightfieldMax(*options.heightfield);
+        nearInput_.resize(candidates_.size() * 3);
+        nearOutput_.resize(candidates_.size() * 3);
+        nearValid_.resize(candidates_.size());
+        for (size_t c = 0; c < candidates_.size(); ++c) {
+            nearInput_[c * 3 + 0] = candidates_[c].screenX;
+            nearInput_[c * 3 + 1] = candidates_[c].screenY;
+            nearInput_[c * 3 + 2] = 0.0f;
+        }
+        if (cameraService->UnProjectBatch(camera, nearInput_.data(), candidates_.size(), nearOutput_.data(),
+                                          nearValid_.data())) {
+            size_t kept = 0;
+            for (size_t c = 0; c < candidates_.size(); ++c) {
+                const Candidate& candidate = candidates_[c];
+                const bool occluded = nearValid_[c] && !(labels_[candidate.index].flags & kWorldLabelNoOcclusion) &&
+                                      IsOccluded(*options.heightfield,
+                                                 positions_.data() + static_cast<size_t>(candidate.index) * 3,
+                                                 nearOutput_.data() + c * 3);
+                if (occluded) {
+                    ++stats_.occluded;
+                    continue;
+                }
+                candidates_[kept++] = candidate;
+            }
+            candidates_.resize(kept);
+        }
+    }
+
+    if (options.declutter) {
+        Declutter(options);
+    }
+
+    // Without vertex offsets a draw list with 16-bit indices cannot address more than 64K vertices. Over budget, the
+    // lowest priority and then farthest labels go first.
+    if (sizeof(ImDrawIdx) == 2 && !(drawList->Flags & ImDrawListFlags_AllowVtxOffset)) {
+        uint32_t vertices = drawList->_VtxCurrentIdx;
+        for (const Candidate& candidate : candidates_) {
+            vertices += QuadCount(candidate) * 4;
+        }
+        if (vertices > kMaxVertices16) {
+            SortByImportance();
+            vertices = drawList->_VtxCurrentIdx;
+            size_t kept = 0;
+            while (kept < candidates_.size() && vertices + QuadCount(candidates_[kept]) * 4 <= kMaxVertices16) {
+                vertices += QuadCount(candidates_[kept++]) * 4;
+            }
+            candidates_.resize(kept);
+            stats_.vertexLimitReached = true;
+        }
+    }
+
+    // Far to near, so nearer labels draw on top where they still overlap.
+    std::sort(candidates_.begin(), candidates_.end(),
+              [](const Candidate& a, const Candidate& b) { return a.depth > b.depth; });
+    Emit(drawList, textureId, options);
+}
+
+void WorldLabelLayer::Assign(Label& label, const WorldLabelDesc& desc) {
+    const char* text = desc.text ? desc.text : "";
+    if (label.text != text) {
+        label.text = text;
+        label.measuredFor = 0;
+    }
+    label.color = desc.color;
+    label.priority = desc.priority;
+    label.offsetX = desc.offsetX;
+    label.offsetY = desc.offsetY;
+    label.flags = desc.flags;
+}
+
+void WorldLabelLayer::Measure(Label& label) const {
+    const char* begin = label.text.c_str();
+    const char* end = begin + label.text.size();
+    const ImVec2 size = font_->CalcTextSizeA(font_->FontSize, FLT_MAX, 0.0f, begin, end);
+    label.width = size.x;
+    label.height = size.y;
+    label.glyphs = 0;
+    for (const char* p = begin; p < end;) {
+        uint32_t codepoint = 0;
+        p = DecodeUtf8(p, end, codepoint);
+        if (codepoint == '\n' || codepoint == '\r') {
+            continue;
+        }
+        const ImFontGlyph* glyph = font_->FindGlyph(static_cast<ImWchar>(codepoint));
+        label.glyphs += glyph && glyph->Visible ? 1 : 0;
+    }
+    label.measuredFor = fontBuild_;
+}
+
+bool WorldLabelLayer::IsOccluded(const TerrainHeightfieldView& heightfield, const float* anchor,
+                                 const float* nearPoint) const {
+    float direction[3] = {nearPoint[0] - anchor[0], nearPoint[1] - anchor[1], nearPoint[2] - anchor[2]};
+    const float length = std::sqrt(direction[0] * direction[0] + direction[1] * direction[1] +
+                                   direction[2] * direction[2]);
+    if (!(length > kOcclusionClearance)) {
+        return false;
+    }
+    for (float& d : direction) {
+        d /= length;
+    }
+
+    // Once the sight line climbs above the highest vertex nothing further along can block it.
+    float end = length;
+    if (direction[1] > 1.0e-4f) {
+        end = (std::min)(end, (heightfieldMax_ + kOcclusionBias - anchor[1]) / direction[1]);
+    }
+
+    const float step = heightfield.gridSpacing > 0.0f ? heightfield.gridSpacing : 16.0f;
+    uint32_t steps = 0;
+    for (float t = kOcclusionClearance; t <= end && steps < kMaxOcclusionSteps; t += step, ++steps) {
+        const float x = anchor[0] + direction[0] * t;
+        const float y = anchor[1] + direction[1] * t;
+        const float z = anchor[2] + direction[2] * t;
+        if (HeightfieldContains(heightfield, x, z) && y < SampleHeightfield(heightfield, x, z) - kOcclusionBias) {
+            return true;
+        }
+    }
+    return false;
+}
+
+bool WorldLabelLayer::HasLeader(const Candidate& candidate, const Label& label) {
+    const float dx = candidate.textPos.x + label.width * 0.5f - candidate.screenX;
+    const float dy = candidate.textPos.y + label.height - candidate.screenY;
+    return (label.flags & kWorldLabelLeaderLine) && dx * dx + dy * dy > 1.0f;
+}
+
+uint32_t WorldLabelLayer::QuadCount(const Candidate& candidate) const {
+    const Label& label = labels_[candidate.index];
+    const uint32_t glyphCopies = 1 + ((label.flags & kWorldLabelOutline) ? 1 : 0) +
+                                 ((label.flags & kWorldLabelShadow) ? 1 : 0);
+    return label.glyphs * glyphCopies + ((label.flags & kWorldLabelBackground) ? 1 : 0) +
+           (HasLeader(candidate, label) ? 1 : 0);
+}
+
+// Priority first, then nearer labels; stable so equal labels keep a consistent order from frame to frame.
+void WorldLabelLayer::SortByImportance() {
+    std::stable_sort(candidates_.begin(), candidates_.end(), [this](const Candidate& a, const Candidate& b) {
+        const int32_t pa = labels_[a.index].priority;
+        const int32_t pb = labels_[b.index].priority;
+        return pa != pb ? pa > pb : a.depth < b.depth;
+    });
+}
+
+void WorldLabelLayer::Declutter(const WorldLabelDrawOptions& options) {
+    const auto columns = static_cast<int>(std::ceil((std::max)(options.displayWidth, 1.0f) / kDeclutterCellSize));
+    const auto rows = static_cast<int>(std::ceil((std::max)(options.displayHeight, 1.0f) / kDeclutterCellSize));
+    gridCells_.resize(static_cast<size_t>(columns) * rows);
+    for (auto& cell : gridCells_) {
+        cell.clear();
+    }
+    placed_.clear();
+
+    SortByImportance();
+
+    const float pad = options.declutterPadding;
+    const auto cellOf = [](const float v, const int count) {
+        return std::clamp(static_cast<int>(std::floor(v / kDeclutterCellSize)), 0, count - 1);
+    };
+
+    size_t kept = 0;
+    for (size_t c = 0; c < candidates_.size(); ++c) {
+        const Candidate& candidate = candidates_[c];
+        if (labels_[candidate.index].flags & kWorldLabelNoDeclutter) {
+            candidates_[kept++] = candidate;
+            continue;
+        }
+
+        const ImVec4 rect(candidate.boundsMin.x - pad, candidate.boundsMin.y - pad, candidate.boundsMax.x + pad,
+                          candidate.boundsMax.y + pad);
+        const int x0 = cellOf(rect.x, columns);
+        const int x1 = cellOf(rect.z, columns);
+        const int y0 = cellOf(rect.y, rows);
+        const int y1 = cellOf(rect.w, rows);
+
+        bool blocked = false;
+        for (int y = y0; y <= y1 && !blocked; ++y) {
+            for (int x = x0; x <= x1 && !blocked; ++x) {
+                for (const uint32_t other : gridCells_[static_cast<size_t>(y) * columns + x]) {
+                    if (Overlaps(rect, placed_[other])) {
+                        blocked = true;
+                        break;
+                    }
+                }
+            }
+        }
+        if (blocked) {
+            ++stats_.decluttered;
+            continue;
+        }
+
+        const auto placedIndex = static_cast<uint32_t>(placed_.size());
+        placed_.push_back(rect);
+        for (int y = y0; y <= y1; ++y) {
+            for (int x = x0; x <= x1; ++x) {
+                gridCells_[static_cast<size_t>(y) * columns + x].push_back(placedIndex);
+            }
+        }
+        candidates_[kept++] = candidate;
+    }
+    candidates_.resize(kept);
+}
+
+void WorldLabelLayer::Emit(ImDrawList* drawList, void* textureId, const WorldLabelDrawOptions& options) {
+    drawList->PushTextureID(textureId);
+    for (const Candidate& candidate : candidates_) {
+        const Label& label = labels_[candidate.index];
+        const bool background = (label.flags & kWorldLabelBackground) != 0;
+        const bool outline = (label.flags & kWorldLabelOutline) != 0;
+        const bool shadow = (label.flags & kWorldLabelShadow) != 0;
+        const ImVec2 textAnchor(candidate.textPos.x + label.width * 0.5f, candidate.textPos.y + label.height);
+        const bool leader = HasLeader(candidate, label);
+        const uint32_t quads = QuadCount(candidate);
+
+        float fade = 1.0f;
+        if (options.depthFadeScale > 0.0f) {
+            fade = std::clamp(1.0f / (1.0f + candidate.depth * options.depthFadeScale), 0.2f, 1.0f);
+        }
+
+        drawList->PrimReserve(static_cast<int>(quads * 6), static_cast<int>(quads * 4));
+        uint32_t emitted = 0;
+        if (leader) {
+            const float leaderDx = textAnchor.x - candidate.screenX;
+            const float leaderDy = textAnchor.y - candidate.screenY;
+            const float leaderLength = std::sqrt(leaderDx * leaderDx + leaderDy * leaderDy);
+            const float nx = -leaderDy / leaderLength * (kLeaderThickness * 0.5f);
+            const float ny = leaderDx / leaderLength * (kLeaderThickness * 0.5f);
+            drawList->PrimQuadUV(ImVec2(candidate.screenX + nx, candidate.screenY + ny),
+                                 ImVec2(textAnchor.x + nx, textAnchor.y + ny),
+                                 ImVec2(textAnchor.x - nx, textAnchor.y - ny),
+                                 ImVec2(candidate.screenX - nx, candidate.screenY - ny),
+                                 whiteUv_, whiteUv_, whiteUv_, whiteUv_, ScaleAlpha(options.leaderColor, fade));
+            ++emitted;
+        }
+        if (background) {
+            drawList->PrimRectUV(ImVec2(candidate.textPos.x - kBackgroundPad.x, candidate.textPos.y - kBackgroundPad.y),
+                                 ImVec2(candidate.textPos.x + label.width + kBackgroundPad.x,
+                                        candidate.textPos.y + label.height + kBackgroundPad.y),
+                                 whiteUv_, whiteUv_, ScaleAlpha(options.backgroundColor, fade));
+            ++emitted;
+        }
+        if (shadow) {
+            emitted += EmitText(drawList, candidate, label, kShadowOffset, kShadowOffset,
+                                ScaleAlpha(options.shadowColor, fade), false);
+        }
+        if (outline) {
+            emitted += EmitText(drawList, candidate, label, 0.0f, 0.0f, ScaleAlpha(options.outlineColor, fade), true);
+        }
+        emitted += EmitText(drawList, candidate, label, 0.0f, 0.0f, ScaleAlpha(label.color, fade), false);
+
+        if (emitted < quads) {
+            drawList->PrimUnreserve(static_cast<int>((quads - emitted) * 6), static_cast<int>((quads - emitted) * 4));
+        }
+        stats_.vertices += emitted * 4;
+        ++stats_.drawn;
+    }
+    drawList->PopTextureID();
+}
+
+uint32_t WorldLabelLayer::EmitText(ImDrawList* drawList, const Candidate& candidate, const Label& label,
+                                   const float dx, const float dy, const ImU32 color, const bool outline) {
+    const float grow = outline ? static_cast<float>(kOutlineRadius) : 0.0f;
+    const float du = grow / static_cast<float>(fontWidth_);
+    const float dv = grow / static_cast<float>(fontHeight_ * 2);
+    const float vOffset = outline ? 0.5f : 0.0f;
+
+    const char* text = label.text.c_str();
+    const char* end = text + label.text.size();
+    const float lineStart = candidate.textPos.x + dx;
+    float x = lineStart;
+    float y = candidate.textPos.y + dy;
+    uint32_t emitted = 0;
+    while (text < end && emitted < label.glyphs) {
+        uint32_t codepoint = 0;
+        text = DecodeUtf8(text, end, codepoint);
+        if (codepoint == '\n') {
+            x = lineStart;
+            y += font_->FontSize;
+            continue;
+        }
+        if (codepoint == '\r') {
+            continue;
+        }
+        const ImFontGlyph* glyph = font_->FindGlyph(static_cast<ImWchar>(codepoint));
+        if (!glyph) {
+            continue;
+        }
+        if (glyph->Visible) {
+            drawList->PrimRectUV(ImVec2(x + glyph->X0 - grow, y + glyph->Y0 - grow),
+                                 ImVec2(x + glyph->X1 + grow, y + glyph->Y1 + grow),
+                                 ImVec2(glyph->U0 - du, glyph->V0 * 0.5f + vOffset - dv),
+                                 ImVec2(glyph->U1 + du, glyph->V1 * 0.5f + vOffset + dv), color);
+            ++emitted;
+        }
+        x += glyph->AdvanceX;
+    }
+    return emitted;
+}
+
+void WorldLabelLayer::UpdateHeightfieldMax(const TerrainHeightfieldView& heightfield) {
+    if (heightfield.version == heightfieldMaxVersion_) {
+        return;
+    }
+    float highest = -FLT_MAX;
+    for (uint32_t z = 0; z < heightfield.verticesZ; ++z) {
+        const float* row = heightfield.heights + static_cast<size_t>(z) * heightfield.rowStride;
+        highest = (std::max)(highest, *std::max_element(row, row + heightfield.verticesX));
+    }
+    heightfieldMax_ = highest;
+    heightfieldMaxVersion_ = heightfield.version;
+}
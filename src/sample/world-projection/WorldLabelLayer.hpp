@@ -0,0 +1,177 @@
+#pragma once
+
+#include "imgui.h"
+#include "public/ImGuiTexture.h"
+#include "public/TerrainHeightfield.h"
+#include "public/cIGZS3DCameraService.h"
+
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// Retained world-anchored text labels, drawn in one batch per frame.
+//
+// Labels are registered once and then updated or removed by ID. Every frame the layer projects all anchors with one
+// ProjectBatch call, drops labels that are behind the camera or off screen, optionally hides labels whose line of
+// sight to the camera passes below the terrain, and resolves overlaps on a screen-space grid so higher priority (then
+// nearer) labels win. The survivors are emitted as textured quads from a private font atlas that also carries a
+// pre-dilated copy of every glyph, so outline, shadow, background plate, leader line and text of every label share a
+// single texture and end up in a single draw command.
+//
+// Render thread only.
+//
+// Example usage:
+//   WorldLabelLayer labels;
+//   labels.Init(imguiService);
+//   WorldLabelDesc desc{};
+//   desc.position[0] = x; desc.position[1] = y; desc.position[2] = z;
+//   desc.text = "Lot 42";
+//   const WorldLabelLayer::LabelId id = labels.Add(desc);
+//
+//   // Every frame:
+//   WorldLabelDrawOptions options{};
+//   options.displayWidth = io.DisplaySize.x;
+//   options.displayHeight = io.DisplaySize.y;
+//   labels.Draw(cameraService, cameraHandle, ImGui::GetBackgroundDrawList(), options);
+//
+
+enum WorldLabelFlags : uint32_t {
+    kWorldLabelOutline = 1u << 0,
+    kWorldLabelShadow = 1u << 1,
+    kWorldLabelBackground = 1u << 2,
+    kWorldLabelLeaderLine = 1u << 3,   // Drawn from the anchor to the text when the label has a screen offset.
+    kWorldLabelNoOcclusion = 1u << 4,  // Never hidden behind terrain.
+    kWorldLabelNoDeclutter = 1u << 5,  // Neither hidden by nor hides other labels.
+};
+
+struct WorldLabelDesc {
+    float position[3]{};
+    const char* text = "";
+    ImU32 color = IM_COL32_WHITE;
+    int32_t priority = 0;       // Higher priority labels win overlaps.
+    float offsetX = 0.0f;       // Screen offset of the text's bottom center from the anchor, in pixels.
+    float offsetY = 0.0f;
+    uint32_t flags = kWorldLabelOutline;
+};
+
+struct WorldLabelDrawOptions {
+    float displayWidth = 0.0f;
+    float displayHeight = 0.0f;
+    /// Enables terrain occlusion. Must stay acquired until Draw returns.
+    const TerrainHeightfieldView* heightfield = nullptr;
+    bool declutter = true;
+    float declutterPadding = 2.0f;  // Extra pixels kept free around each label.
+    float depthFadeScale = 0.0f;    // Alpha *= 1 / (1 + depth * scale), at least 0.2; 0 disables fading.
+    ImU32 outlineColor = IM_COL32(0, 0, 0, 210);
+    ImU32 shadowColor = IM_COL32(0, 0, 0, 160);
+    ImU32 backgroundColor = IM_COL32(0, 0, 0, 140);
+    ImU32 leaderColor = IM_COL32(0, 0, 0, 180);
+};
+
+struct WorldLabelFrameStats {
+    uint32_t total = 0;
+    uint32_t inFront = 0;       // Projected in front of the camera.
+    uint32_t onScreen = 0;      // Of those, overlapping the display.
+    uint32_t occluded = 0;      // Hidden behind terrain.
+    uint32_t decluttered = 0;   // Hidden by a higher priority label.
+    uint32_t drawn = 0;
+    uint32_t vertices = 0;
+    bool vertexLimitReached = false;    // Some labels were dropped to stay within 16-bit draw list indices.
+};
+
+class WorldLabelLayer {
+public:
+    using LabelId = uint32_t;
+    static constexpr LabelId kInvalidLabel = 0;
+
+    WorldLabelLayer();
+    ~WorldLabelLayer();
+
+    WorldLabelLayer(const WorldLabelLayer&) = delete;
+    WorldLabelLayer& operator=(const WorldLabelLayer&) = delete;
+
+    /// Bakes the outlined font at `fontSize` pixels. Labels can be added before or after.
+    bool Init(cIGZImGuiService* imguiService, float fontSize = 13.0f);
+    void Shutdown();
+
+    LabelId Add(const WorldLabelDesc& desc);
+    bool Update(LabelId id, const WorldLabelDesc& desc);
+    /// Moves a label without touching its text; the cheap path for labels that follow moving objects.
+    bool SetPosition(LabelId id, float x, float y, float z);
+    bool Remove(LabelId id);
+    void Clear();
+    [[nodiscard]] size_t Size() const { return ids_.size(); }
+
+    void Draw(cIGZS3DCameraService* cameraService, S3DCameraHandle camera, ImDrawList* drawList,
+              const WorldLabelDrawOptions& options);
+    [[nodiscard]] const WorldLabelFrameStats& Stats() const { return stats_; }
+
+private:
+    struct Label {
+        std::string text;
+        ImU32 color = IM_COL32_WHITE;
+        int32_t priority = 0;
+        float offsetX = 0.0f;
+        float offsetY = 0.0f;
+        uint32_t flags = 0;
+        float width = 0.0f;         // Text extent at the baked size; valid when measuredFor == fontBuild_.
+        float height = 0.0f;
+        uint32_t glyphs = 0;        // Visible glyphs, for vertex budgeting.
+        uint32_t measuredFor = 0;
+    };
+
+    struct Candidate {
+        uint32_t index;
+        float depth;
+        float screenX;              // Anchor.
+        float screenY;
+        ImVec2 textPos;             // Top left of the text, snapped to whole pixels.
+        ImVec2 boundsMin;           // Everything the label draws, for culling and declutter.
+        ImVec2 boundsMax;
+    };
+
+    void Assign(Label& label, const WorldLabelDesc& desc);
+    void Measure(Label& label) const;
+    bool IsOccluded(const TerrainHeightfieldView& heightfield, const float* anchor, const float* nearPoint) const;
+    static bool HasLeader(const Candidate& candidate, const Label& label);
+    uint32_t QuadCount(const Candidate& candidate) const;
+    void SortByImportance();
+    void Declutter(const WorldLabelDrawOptions& options);
+    void Emit(ImDrawList* drawList, void* textureId, const WorldLabelDrawOptions& options);
+    uint32_t EmitText(ImDrawList* drawList, const Candidate& candidate, const Label& label, float dx, float dy,
+                      ImU32 color, bool outline);
+    void UpdateHeightfieldMax(const TerrainHeightfieldView& heightfield);
+
+    cIGZImGuiService* imguiService_ = nullptr;
+    ImFontAtlas* fontAtlas_ = nullptr;
+    ImFont* font_ = nullptr;
+    ImGuiTexture fontTexture_{};
+    std::vector<uint8_t> fontPixels_{};     // RGBA: glyphs in the top half, dilated glyphs in the bottom half.
+    uint32_t fontWidth_ = 0;
+    uint32_t fontHeight_ = 0;               // Of the baked atlas; the texture is twice as tall.
+    uint32_t fontBuild_ = 0;                // Bumped on every bake so labels re-measure.
+    ImVec2 whiteUv_{};
+
+    // Dense label storage; positions are xyz triples in the same order, ready for ProjectBatch.
+    std::vector<Label> labels_{};
+    std::vector<float> positions_{};
+    std::vector<LabelId> ids_{};
+    std::unordered_map<LabelId, uint32_t> indexOfId_{};
+    LabelId nextId_ = 1;
+
+    // Per-frame scratch, reused to avoid reallocating.
+    std::vector<float> projected_{};
+    std::vector<uint8_t> inFront_{};
+    std::vector<Candidate> candidates_{};
+    std::vector<float> nearInput_{};
+    std::vector<float> nearOutput_{};
+    std::vector<uint8_t> nearValid_{};
+    std::vector<std::vector<uint32_t>> gridCells_{};
+    std::vector<ImVec4> placed_{};
+
+    uint32_t heightfieldMaxVersion_ = 0;
+    float heightfieldMax_ = 0.0f;
+
+    WorldLabelFrameStats stats_{};
+};
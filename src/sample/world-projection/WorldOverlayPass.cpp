@@ -0,0 +1,322 @@
+#include "sample/world-projection/WorldOverlayPass.hpp"
+
+#include "public/cIGZImGuiService.h"
+
+#include <algorithm>
+#include <cmath>
+
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <d3d.h>
+#include <ddraw.h>
+
+namespace {
+    constexpr uint32_t kWorldOverlayFVF = D3DFVF_XYZ | D3DFVF_DIFFUSE | D3DFVF_TEX1;
+    constexpr uint32_t kRingVertices = 8192;
+
+    // ImGui packs colors as ABGR, D3D as ARGB.
+    uint32_t ToD3DColor(const ImU32 color) {
+        return (color & 0xFF00FF00u) | ((color & 0x000000FFu) << 16) | ((color & 0x00FF0000u) >> 16);
+    }
+
+    // Saves the device state the overlay touches and restores it on scope exit, so the game's pass continues with
+    // the state it set up.
+    class OverlayStateGuard {
+    public:
+        explicit OverlayStateGuard(IDirect3DDevice7* device) : device_(device) {
+            for (size_t i = 0; i < std::size(kRenderStates); ++i) {
+                renderOk_[i] = SUCCEEDED(device_->GetRenderState(kRenderStates[i], &renderValues_[i]));
+            }
+            for (size_t i = 0; i < std::size(kStage0States); ++i) {
+                stage0Ok_[i] = SUCCEEDED(device_->GetTextureStageState(0, kStage0States[i], &stage0Values_[i]));
+            }
+            stage1ColorOk_ = SUCCEEDED(device_->GetTextureStageState(1, D3DTSS_COLOROP, &stage1ColorOp_));
+            stage1AlphaOk_ = SUCCEEDED(device_->GetTextureStageState(1, D3DTSS_ALPHAOP, &stage1AlphaOp_));
+            textureOk_ = SUCCEEDED(device_->GetTexture(0, &texture_));
+        }
+
+        ~OverlayStateGuard() {
+            for (size_t i = 0; i < std::size(kRenderStates); ++i) {
+                if (renderOk_[i]) device_->SetRenderState(kRenderStates[i], renderValues_[i]);
+            }
+            for (size_t i = 0; i < std::size(kStage0States); ++i) {
+                if (stage0Ok_[i]) device_->SetTextureStageState(0, kStage0States[i], stage0Values_[i]);
+            }
+            if (stage1ColorOk_) device_->SetTextureStageState(1, D3DTSS_COLOROP, stage1ColorOp_);
+            if (stage1AlphaOk_) device_->SetTextureStageState(1, D3DTSS_ALPHAOP, stage1AlphaOp_);
+            if (textureOk_) device_->SetTexture(0, texture_);
+            if (texture_) texture_->Release();
+        }
+
+        OverlayStateGuard(const OverlayStateGuard&) = delete;
+        OverlayStateGuard& operator=(const OverlayStateGuard&) = delete;
+
+    private:
+        static constexpr D3DRENDERSTATETYPE kRenderStates[] = {
+            D3DRENDERSTATE_ZENABLE, D3DRENDERSTATE_ZWRITEENABLE, D3DRENDERSTATE_ZFUNC, D3DRENDERSTATE_ZBIAS,
+            D3DRENDERSTATE_LIGHTING, D3DRENDERSTATE_CULLMODE, D3DRENDERSTATE_FOGENABLE, D3DRENDERSTATE_STENCILENABLE,
+            D3DRENDERSTATE_ALPHABLENDENABLE, D3DRENDERSTATE_SRCBLEND, D3DRENDERSTATE_DESTBLEND,
+            D3DRENDERSTATE_ALPHATESTENABLE,
+        };
+        static constexpr D3DTEXTURESTAGESTATETYPE kStage0States[] = {
+            D3DTSS_COLOROP, D3DTSS_COLORARG1, D3DTSS_COLORARG2, D3DTSS_ALPHAOP, D3DTSS_ALPHAARG1, D3DTSS_ALPHAARG2,
+            D3DTSS_TEXCOORDINDEX, D3DTSS_ADDRESS, D3DTSS_MINFILTER, D3DTSS_MAGFILTER, D3DTSS_MIPFILTER,
+        };
+
+        IDirect3DDevice7* device_;
+        DWORD renderValues_[std::size(kRenderStates)]{};
+        bool renderOk_[std::size(kRenderStates)]{};
+        DWORD stage0Values_[std::size(kStage0States)]{};
+        bool stage0Ok_[std::size(kStage0States)]{};
+        DWORD stage1ColorOp_ = 0;
+        DWORD stage1AlphaOp_ = 0;
+        bool stage1ColorOk_ = false;
+        bool stage1AlphaOk_ = false;
+        IDirectDrawSurface7* texture_ = nullptr;
+        bool textureOk_ = false;
+    };
+
+    void SetTextureStage(IDirect3DDevice7* device, void* texture) {
+        device->SetTexture(0, static_cast<IDirectDrawSurface7*>(texture));
+        if (texture) {
+            device->SetTextureStageState(0, D3DTSS_COLOROP, D3DTOP_MODULATE);
+            device->SetTextureStageState(0, D3DTSS_ALPHAOP, D3DTOP_MODULATE);
+        }
+        else {
+            device->SetTextureStageState(0, D3DTSS_COLOROP, D3DTOP_SELECTARG2);
+            device->SetTextureStageState(0, D3DTSS_ALPHAOP, D3DTOP_SELECTARG2);
+        }
+    }
+}
+
+void WorldOverlayDrawList::Clear() {
+    vertices_.clear();
+    indices_.clear();
+    commands_.clear();
+    texture_ = nullptr;
+    vertexLimitReached_ = false;
+}
+
+void WorldOverlayDrawList::SetTexture(void* imguiTextureId) {
+    texture_ = imguiTextureId;
+}
+
+WorldOverlayVertex* WorldOverlayDrawList::ReserveQuad(const ImU32 color) {
+    if (vertices_.size() + 4 > kMaxVertices) {
+        vertexLimitReached_ = true;
+        return nullptr;
+    }
+
+    if (commands_.empty() || commands_.back().texture != texture_) {
+        commands_.push_back({texture_, static_cast<uint32_t>(indices_.size()), 0});
+    }
+    commands_.back().indexCount += 6;
+
+    const auto base = static_cast<uint16_t>(vertices_.size());
+    for (const uint16_t offset : {0, 1, 2, 0, 2, 3}) {
+        indices_.push_back(static_cast<uint16_t>(base + offset));
+    }
+
+    const size_t first = vertices_.size();
+    vertices_.resize(first + 4);
+    WorldOverlayVertex* quad = vertices_.data() + first;
+    const uint32_t diffuse = ToD3DColor(color);
+    for (int i = 0; i < 4; ++i) {
+        quad[i].diffuse = diffuse;
+    }
+    return quad;
+}
+
+bool WorldOverlayDrawList::AddQuad(const float* corners, const ImU32 color) {
+    return AddImageQuad(corners, ImVec2(0.0f, 0.0f), ImVec2(1.0f, 1.0f), color);
+}
+
+bool WorldOverlayDrawList::AddImageQuad(const float* corners, const ImVec2& uv0, const ImVec2& uv1,
+                                        const ImU32 color) {
+    WorldOverlayVertex* quad = ReserveQuad(color);
+    if (!quad) {
+        return false;
+    }
+
+    const float us[4] = {uv0.x, uv1.x, uv1.x, uv0.x};
+    const float vs[4] = {uv0.y, uv0.y, uv1.y, uv1.y};
+    for (int i = 0; i < 4; ++i) {
+        quad[i].x = corners[i * 3 + 0];
+        quad[i].y = corners[i * 3 + 1];
+        quad[i].z = corners[i * 3 + 2];
+        quad[i].u = us[i];
+        quad[i].v = vs[i];
+    }
+    return true;
+}
+
+bool WorldOverlayDrawList::AddLine(const float* a, const float* b, const float width, const ImU32 color) {
+    const float dx = b[0] - a[0];
+    const float dz = b[2] - a[2];
+    const float length = std::sqrt(dx * dx + dz * dz);
+    if (length <= 1.0e-6f) {
+        return true;
+    }
+
+    const float halfWidth = width * 0.5f;
+    const float nx = -dz / length * halfWidth;
+    const float nz = dx / length * halfWidth;
+    const float corners[12] = {
+        a[0] + nx, a[1], a[2] + nz,
+        b[0] + nx, b[1], b[2] + nz,
+        b[0] - nx, b[1], b[2] - nz,
+        a[0] - nx, a[1], a[2] - nz,
+    };
+    return AddQuad(corners, color);
+}
+
+WorldOverlayPass::~WorldOverlayPass() {
+    Shutdown();
+}
+
+bool WorldOverlayPass::Init(cIGZImGuiService* imguiService, cIGZDrawService* drawService,
+                            const DrawServicePass pass) {
+    Shutdown();
+    if (!imguiService || !drawService) {
+        return false;
+    }
+
+    imguiService_ = imguiService;
+    drawService_ = drawService;
+    if (!drawService_->RegisterDrawPassCallback(pass, &WorldOverlayPass::DrawPassCallback, this,
+                                                &callbackToken_)) {
+        callbackToken_ = 0;
+        Shutdown();
+        return false;
+    }
+    return true;
+}
+
+void WorldOverlayPass::Shutdown() {
+    if (drawService_) {
+        if (callbackToken_ != 0) {
+            drawService_->UnregisterDrawPassCallback(callbackToken_);
+            callbackToken_ = 0;
+        }
+        if (buffer_.id != 0) {
+            drawService_->ReleaseDrawBuffer(buffer_);
+            buffer_ = DrawBufferHandle{0};
+        }
+    }
+    drawService_ = nullptr;
+    imguiService_ = nullptr;
+    list_.Clear();
+    lastDraws_ = 0;
+}
+
+WorldOverlayDrawList& WorldOverlayPass::Begin() {
+    list_.Clear();
+    listGeneration_ = imguiService_ ? imguiService_->GetDeviceGeneration() : 0;
+    return list_;
+}
+
+void WorldOverlayPass::SetZBias(const int zBias) {
+    zBias_ = std::clamp(zBias, 0, kMaxZBias);
+}
+
+WorldOverlayFrameStats WorldOverlayPass::Stats() const {
+    WorldOverlayFrameStats stats{};
+    stats.vertices = static_cast<uint32_t>(list_.vertices_.size());
+    stats.indices = static_cast<uint32_t>(list_.indices_.size());
+    stats.commands = static_cast<uint32_t>(list_.commands_.size());
+    stats.draws = lastDraws_;
+    stats.vertexLimitReached = list_.vertexLimitReached_;
+    return stats;
+}
+
+void WorldOverlayPass::DrawPassCallback(DrawServicePass, const bool begin, void* userData) {
+    if (!begin && userData) {
+        static_cast<WorldOverlayPass*>(userData)->Render();
+    }
+}
+
+void WorldOverlayPass::Render() {
+    lastDraws_ = 0;
+    if (list_.Empty() || !imguiService_ || !imguiService_->IsDeviceReady()) {
+        return;
+    }
+
+    IDirect3DDevice7* device = nullptr;
+    IDirectDraw7* dd = nullptr;
+    if (!imguiService_->AcquireD3DInterfaces(&device, &dd)) {
+        return;
+    }
+    if (dd) {
+        dd->Release();
+    }
+    if (!device) {
+        return;
+    }
+
+    // Textures recorded against a previous device are gone; untextured geometry is still fine.
+    const bool texturesValid = listGeneration_ == imguiService_->GetDeviceGeneration();
+    const auto vertexCount = static_cast<uint32_t>(list_.vertices_.size());
+
+    if (buffer_.id == 0) {
+        const DrawBufferDesc desc{DrawBufferUsage::Dynamic, kWorldOverlayFVF, sizeof(WorldOverlayVertex),
+                                  kRingVertices};
+        buffer_ = drawService_->CreateDrawBuffer(desc);
+    }
+    uint32_t startVertex = 0;
+    const bool buffered = buffer_.id != 0 &&
+                          drawService_->WriteDrawBuffer(buffer_, list_.vertices_.data(), vertexCount, &startVertex) &&
+                          drawService_->SetDrawBufferIndices(buffer_, list_.indices_.data(),
+                                                             static_cast<uint32_t>(list_.indices_.size()));
+
+    {
+        OverlayStateGuard state(device);
+        device->SetRenderState(D3DRENDERSTATE_ZENABLE, depthTest_ ? TRUE : FALSE);
+        device->SetRenderState(D3DRENDERSTATE_ZFUNC, D3DCMP_LESSEQUAL);
+        device->SetRenderState(D3DRENDERSTATE_ZWRITEENABLE, FALSE);
+        device->SetRenderState(D3DRENDERSTATE_ZBIAS, static_cast<DWORD>(zBias_));
+        device->SetRenderState(D3DRENDERSTATE_LIGHTING, FALSE);
+        device->SetRenderState(D3DRENDERSTATE_CULLMODE, D3DCULL_NONE);
+        device->SetRenderState(D3DRENDERSTATE_FOGENABLE, FALSE);
+        device->SetRenderState(D3DRENDERSTATE_STENCILENABLE, FALSE);
+        device->SetRenderState(D3DRENDERSTATE_ALPHABLENDENABLE, TRUE);
+        device->SetRenderState(D3DRENDERSTATE_SRCBLEND, D3DBLEND_SRCALPHA);
+        device->SetRenderState(D3DRENDERSTATE_DESTBLEND, D3DBLEND_INVSRCALPHA);
+        device->SetRenderState(D3DRENDERSTATE_ALPHATESTENABLE, FALSE);
+        device->SetTextureStageState(0, D3DTSS_COLORARG1, D3DTA_TEXTURE);
+        device->SetTextureStageState(0, D3DTSS_COLORARG2, D3DTA_DIFFUSE);
+        device->SetTextureStageState(0, D3DTSS_ALPHAARG1, D3DTA_TEXTURE);
+        device->SetTextureStageState(0, D3DTSS_ALPHAARG2, D3DTA_DIFFUSE);
+        device->SetTextureStageState(0, D3DTSS_TEXCOORDINDEX, 0);
+        device->SetTextureStageState(0, D3DTSS_ADDRESS, D3DTADDRESS_CLAMP);
+        device->SetTextureStageState(0, D3DTSS_MINFILTER, D3DTFN_LINEAR);
+        device->SetTextureStageState(0, D3DTSS_MAGFILTER, D3DTFG_LINEAR);
+        device->SetTextureStageState(0, D3DTSS_MIPFILTER, D3DTFP_NONE);
+        device->SetTextureStageState(1, D3DTSS_COLOROP, D3DTOP_DISABLE);
+        device->SetTextureStageState(1, D3DTSS_ALPHAOP, D3DTOP_DISABLE);
+
+        for (const WorldOverlayDrawList::Command& command : list_.commands_) {
+            if (command.texture && !texturesValid) {
+                continue;
+            }
+            SetTextureStage(device, command.texture);
+
+            bool drawn = buffered &&
+                         drawService_->DrawBufferIndexedPrimitives(buffer_, D3DPT_TRIANGLELIST, startVertex,
+                                                                   vertexCount, command.firstIndex,
+                                                                   command.indexCount);
+            if (!drawn) {
+                // No pooled buffer (or a lost one): send the geometry from system memory instead.
+                drawn = SUCCEEDED(device->DrawIndexedPrimitive(D3DPT_TRIANGLELIST, kWorldOverlayFVF,
+                                                               list_.vertices_.data(), vertexCount,
+                                                               list_.indices_.data() + command.firstIndex,
+                                                               command.indexCount, 0));
+            }
+            if (drawn) {
+                ++lastDraws_;
+            }
+        }
+    }
+
+    device->Release();
+}
@@ -0,0 +1,129 @@
+#pragma once
+
+#include "imgui.h"
+#include "public/cIGZDrawService.h"
+
+#include <cstdint>
+#include <vector>
+
+class cIGZImGuiService;
+
+// World-space overlay geometry drawn inside a game render pass, so the game's z-buffer hides it behind buildings
+// and terrain.
+//
+// ImGui draw lists are screen space and render at EndScene with no depth test. Vertices added here keep their world
+// positions and go through the game's view and projection transforms instead, so occlusion costs nothing and needs no
+// depth readback. The list is retained: record it from the ImGui frame and the next pass draws it, a frame later,
+// which is invisible for world-anchored geometry. Colors are ImGui colors; textures are ImGui texture IDs.
+//
+// Render thread only.
+//
+// Example usage:
+//   WorldOverlayPass overlay;
+//   overlay.Init(imguiService, drawService);
+//
+//   // Every ImGui frame:
+//   WorldOverlayDrawList& list = overlay.Begin();
+//   list.AddLine(a, b, 2.0f, IM_COL32(0, 255, 0, 200));
+//   list.SetTexture(iconTexture.GetID());
+//   list.AddQuad(corners, IM_COL32_WHITE);
+//
+
+struct WorldOverlayVertex {
+    float x;
+    float y;
+    float z;
+    uint32_t diffuse;           // D3D ARGB.
+    float u;
+    float v;
+};
+static_assert(sizeof(WorldOverlayVertex) == 24, "WorldOverlayVertex must match kWorldOverlayFVF");
+
+struct WorldOverlayFrameStats {
+    uint32_t vertices = 0;
+    uint32_t indices = 0;
+    uint32_t commands = 0;      // One per texture change.
+    uint32_t draws = 0;         // Issued in the last pass.
+    bool vertexLimitReached = false;    // Geometry was dropped to stay within 16-bit indices.
+};
+
+class WorldOverlayDrawList {
+public:
+    static constexpr uint32_t kMaxVertices = 0xFFFF;
+
+    void Clear();
+    /// Texture for the geometry that follows; nullptr draws vertex colors only. The texture must stay alive until
+    /// the list is cleared.
+    void SetTexture(void* imguiTextureId);
+
+    /// Quad from four xyz corners in winding order, with the texture's full UV range.
+    bool AddQuad(const float* corners, ImU32 color);
+    bool AddImageQuad(const float* corners, const ImVec2& uv0, const ImVec2& uv1, ImU32 color);
+    /// Flat ribbon `width` world units wide in the x/z plane, following the heights of both ends.
+    bool AddLine(const float* a, const float* b, float width, ImU32 color);
+
+    [[nodiscard]] bool Empty() const { return indices_.empty(); }
+    [[nodiscard]] uint32_t VertexCount() const { return static_cast<uint32_t>(vertices_.size()); }
+    [[nodiscard]] bool VertexLimitReached() const { return vertexLimitReached_; }
+
+private:
+    friend class WorldOverlayPass;
+
+    struct Command {
+        void* texture;
+        uint32_t firstIndex;
+        uint32_t indexCount;
+    };
+
+    WorldOverlayVertex* ReserveQuad(ImU32 color);
+
+    std::vector<WorldOverlayVertex> vertices_{};
+    std::vector<uint16_t> indices_{};
+    std::vector<Command> commands_{};
+    void* texture_ = nullptr;
+    bool vertexLimitReached_ = false;
+};
+
+class WorldOverlayPass {
+public:
+    static constexpr int kMaxZBias = 16;    // D3D7 clamps ZBIAS to 0..16.
+
+    WorldOverlayPass() = default;
+    ~WorldOverlayPass();
+
+    WorldOverlayPass(const WorldOverlayPass&) = delete;
+    WorldOverlayPass& operator=(const WorldOverlayPass&) = delete;
+
+    /// Registers the draw callback. PreDynamic runs after terrain and buildings have filled the z-buffer and before
+    /// the game's translucent and UI geometry, with the world transforms the road decals also rely on.
+    bool Init(cIGZImGuiService* imguiService, cIGZDrawService* drawService,
+              DrawServicePass pass = DrawServicePass::PreDynamic);
+    void Shutdown();
+    [[nodiscard]] bool IsReady() const { return callbackToken_ != 0; }
+
+    /// Clears the list for recording. Textured geometry recorded before a device reset is skipped.
+    WorldOverlayDrawList& Begin();
+
+    /// Pulls the overlay toward the camera to win depth ties with coplanar ground, 0..kMaxZBias.
+    void SetZBias(int zBias);
+    [[nodiscard]] int ZBias() const { return zBias_; }
+    /// Without the depth test the overlay draws over everything, like the ImGui background list.
+    void SetDepthTest(bool enabled) { depthTest_ = enabled; }
+    [[nodiscard]] bool DepthTest() const { return depthTest_; }
+
+    [[nodiscard]] WorldOverlayFrameStats Stats() const;
+
+private:
+    static void DrawPassCallback(DrawServicePass pass, bool begin, void* userData);
+    void Render();
+
+    cIGZImGuiService* imguiService_ = nullptr;
+    cIGZDrawService* drawService_ = nullptr;
+    uint32_t callbackToken_ = 0;
+    DrawBufferHandle buffer_{0};
+    WorldOverlayDrawList list_{};
+    int zBias_ = 1;
+    bool depthTest_ = true;
+    uint32_t listGeneration_ = 0;   // Device generation the list was recorded against.
+    uint32_t lastDraws_ = 0;
+};
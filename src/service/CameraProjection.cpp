@@ -0,0 +1,266 @@
+#include "CameraProjection.h"
+
+#include <cmath>
+#include <cstring>
+#include <utility>
+
+#if defined(_M_IX86) || defined(_M_X64) || defined(__SSE__)
+#define CAMERA_PROJECTION_SSE 1
+#include <xmmintrin.h>
+#endif
+
+namespace {
+    constexpr size_t kUnknowns = 15;    // 4x4 matrix with the w row's constant term fixed to 1.
+    constexpr float kMinW = 1.0e-6f;
+
+    // Solves a x = b in place with partial pivoting. `a` is n x n row-major.
+    bool SolveLinear(double* a, double* b, const size_t n) {
+        for (size_t col = 0; col < n; ++col) {
+            size_t pivot = col;
+            for (size_t row = col + 1; row < n; ++row) {
+                if (std::fabs(a[row * n + col]) > std::fabs(a[pivot * n + col])) {
+                    pivot = row;
+                }
+            }
+            if (std::fabs(a[pivot * n + col]) < 1.0e-12) {
+                return false;
+            }
+            if (pivot != col) {
+                for (size_t k = 0; k < n; ++k) {
+                    std::swap(a[col * n + k], a[pivot * n + k]);
+                }
+                std::swap(b[col], b[pivot]);
+            }
+            for (size_t row = 0; row < n; ++row) {
+                if (row == col) {
+                    continue;
+                }
+                const double factor = a[row * n + col] / a[col * n + col];
+                if (factor == 0.0) {
+                    continue;
+                }
+                for (size_t k = col; k < n; ++k) {
+                    a[row * n + k] -= factor * a[col * n + k];
+                }
+                b[row] -= factor * b[col];
+            }
+        }
+        for (size_t row = 0; row < n; ++row) {
+            b[row] /= a[row * n + row];
+        }
+        return true;
+    }
+
+    bool Invert4x4(const double (&m)[4][4], double (&out)[4][4]) {
+        double a[4][8];
+        for (int r = 0; r < 4; ++r) {
+            for (int c = 0; c < 4; ++c) {
+                a[r][c] = m[r][c];
+                a[r][c + 4] = r == c ? 1.0 : 0.0;
+            }
+        }
+        for (int col = 0; col < 4; ++col) {
+            int pivot = col;
+            for (int row = col + 1; row < 4; ++row) {
+                if (std::fabs(a[row][col]) > std::fabs(a[pivot][col])) {
+                    pivot = row;
+                }
+            }
+            if (std::fabs(a[pivot][col]) < 1.0e-15) {
+                return false;
+            }
+            if (pivot != col) {
+                for (int k = 0; k < 8; ++k) {
+                    std::swap(a[col][k], a[pivot][k]);
+                }
+            }
+            const double inv = 1.0 / a[col][col];
+            for (int k = 0; k < 8; ++k) {
+                a[col][k] *= inv;
+            }
+            for (int row = 0; row < 4; ++row) {
+                if (row != col && a[row][col] != 0.0) {
+                    const double factor = a[row][col];
+                    for (int k = 0; k < 8; ++k) {
+                        a[row][k] -= factor * a[col][k];
+                    }
+                }
+            }
+        }
+        for (int r = 0; r < 4; ++r) {
+            for (int c = 0; c < 4; ++c) {
+                out[r][c] = a[r][c + 4];
+            }
+        }
+        return true;
+    }
+
+    // out = (columns * ((p - inOffset) * inScale, 1)).xyz / w * outScale + outOffset
+    void TransformPoints(const float (&columns)[4][4], const float* inOffset, const float inScale,
+                         const float* outOffset, const float outScale, const bool requirePositiveW,
+                         const float* xyz, const size_t count, float* outXYZ, uint8_t* outFlags) {
+#if CAMERA_PROJECTION_SSE
+        const __m128 c0 = _mm_loadu_ps(columns[0]);
+        const __m128 c1 = _mm_loadu_ps(columns[1]);
+        const __m128 c2 = _mm_loadu_ps(columns[2]);
+        const __m128 c3 = _mm_loadu_ps(columns[3]);
+        const __m128 offsetIn = _mm_setr_ps(inOffset[0], inOffset[1], inOffset[2], 0.0f);
+        const __m128 scaleIn = _mm_set1_ps(inScale);
+        const __m128 offsetOut = _mm_setr_ps(outOffset[0], outOffset[1], outOffset[2], 0.0f);
+        const __m128 scaleOut = _mm_set1_ps(outScale);
+        for (size_t i = 0; i < count; ++i) {
+            const float* p = xyz + i * 3;
+            const __m128 local = _mm_mul_ps(_mm_sub_ps(_mm_setr_ps(p[0], p[1], p[2], 0.0f), offsetIn), scaleIn);
+            const __m128 x = _mm_shuffle_ps(local, local, _MM_SHUFFLE(0, 0, 0, 0));
+            const __m128 y = _mm_shuffle_ps(local, local, _MM_SHUFFLE(1, 1, 1, 1));
+            const __m128 z = _mm_shuffle_ps(local, local, _MM_SHUFFLE(2, 2, 2, 2));
+            const __m128 r = _mm_add_ps(_mm_add_ps(_mm_mul_ps(c0, x), _mm_mul_ps(c1, y)),
+                                        _mm_add_ps(_mm_mul_ps(c2, z), c3));
+            const float w = _mm_cvtss_f32(_mm_shuffle_ps(r, r, _MM_SHUFFLE(3, 3, 3, 3)));
+            const bool ok = requirePositiveW ? w > kMinW : std::fabs(w) > kMinW;
+            const __m128 invW = _mm_set1_ps(std::fabs(w) > kMinW ? 1.0f / w : 0.0f);
+            float result[4];
+            _mm_storeu_ps(result, _mm_add_ps(_mm_mul_ps(_mm_mul_ps(r, invW), scaleOut), offsetOut));
+            std::memcpy(outXYZ + i * 3, result, sizeof(float) * 3);
+            if (outFlags) {
+                outFlags[i] = ok ? 1 : 0;
+            }
+        }
+#else
+        for (size_t i = 0; i < count; ++i) {
+            const float* p = xyz + i * 3;
+            const float lx = (p[0] - inOffset[0]) * inScale;
+            const float ly = (p[1] - inOffset[1]) * inScale;
+            const float lz = (p[2] - inOffset[2]) * inScale;
+            float r[4];
+            for (int k = 0; k < 4; ++k) {
+                r[k] = columns[0][k] * lx + columns[1][k] * ly + columns[2][k] * lz + columns[3][k];
+            }
+            const float w = r[3];
+            const bool ok = requirePositiveW ? w > kMinW : std::fabs(w) > kMinW;
+            const float invW = std::fabs(w) > kMinW ? 1.0f / w : 0.0f;
+            for (int k = 0; k < 3; ++k) {
+                outXYZ[i * 3 + k] = r[k] * invW * outScale + outOffset[k];
+            }
+            if (outFlags) {
+                outFlags[i] = ok ? 1 : 0;
+            }
+        }
+#endif
+    }
+}
+
+void GetCameraProjectionFitPoints(const float* center, const float halfExtent,
+                                  float (&outPoints)[kCameraProjectionFitPoints][3]) {
+    outPoints[0][0] = center[0];
+    outPoints[0][1] = center[1];
+    outPoints[0][2] = center[2];
+    for (size_t i = 0; i < 8; ++i) {
+        outPoints[i + 1][0] = center[0] + ((i & 1) ? halfExtent : -halfExtent);
+        outPoints[i + 1][1] = center[1] + ((i & 2) ? halfExtent : -halfExtent);
+        outPoints[i + 1][2] = center[2] + ((i & 4) ? halfExtent : -halfExtent);
+    }
+}
+
+bool FitCameraProjection(const float (*world)[3], const float (*screen)[3], const size_t count, const float* origin,
+                         const float scale, CameraProjection& out) {
+    out.valid = false;
+    if (count < 5 || !(scale > 0.0f)) {
+        return false;
+    }
+
+    // Unknowns: rows 0-2 of the matrix (12) then the first three entries of the w row. With w's constant fixed to 1,
+    // each point gives three equations: row_k . X - s_k * (w_xyz . X) = s_k.
+    double ata[kUnknowns * kUnknowns]{};
+    double atb[kUnknowns]{};
+    const double invScale = 1.0 / scale;
+    for (size_t i = 0; i < count; ++i) {
+        const double x[4] = {
+            (world[i][0] - origin[0]) * invScale,
+            (world[i][1] - origin[1]) * invScale,
+            (world[i][2] - origin[2]) * invScale,
+            1.0
+        };
+        for (int k = 0; k < 3; ++k) {
+            double row[kUnknowns]{};
+            for (int c = 0; c < 4; ++c) {
+                row[k * 4 + c] = x[c];
+            }
+            for (int c = 0; c < 3; ++c) {
+                row[12 + c] = -screen[i][k] * x[c];
+            }
+            const double rhs = screen[i][k];
+            for (size_t r = 0; r < kUnknowns; ++r) {
+                for (size_t c = 0; c < kUnknowns; ++c) {
+                    ata[r * kUnknowns + c] += row[r] * row[c];
+                }
+                atb[r] += row[r] * rhs;
+            }
+        }
+    }
+    if (!SolveLinear(ata, atb, kUnknowns)) {
+        return false;
+    }
+
+    double m[4][4];
+    for (int r = 0; r < 3; ++r) {
+        for (int c = 0; c < 4; ++c) {
+            m[r][c] = atb[r * 4 + c];
+        }
+    }
+    m[3][0] = atb[12];
+    m[3][1] = atb[13];
+    m[3][2] = atb[14];
+    m[3][3] = 1.0;
+
+    double inverse[4][4];
+    if (!Invert4x4(m, inverse)) {
+        return false;
+    }
+
+    for (int r = 0; r < 4; ++r) {
+        for (int c = 0; c < 4; ++c) {
+            out.columns[c][r] = static_cast<float>(m[r][c]);
+            out.inverse[c][r] = static_cast<float>(inverse[r][c]);
+        }
+    }
+    std::memcpy(out.origin, origin, sizeof(out.origin));
+    out.invScale = static_cast<float>(invScale);
+    out.valid = true;
+    return true;
+}
+
+bool ProjectPoint(const CameraProjection& projection, const float* world, float* outScreen) {
+    uint8_t visible = 0;
+    ProjectPoints(projection, world, 1, outScreen, &visible);
+    return visible != 0;
+}
+
+bool UnProjectPoint(const CameraProjection& projection, const float* screen, float* outWorld) {
+    uint8_t valid = 0;
+    UnProjectPoints(projection, screen, 1, outWorld, &valid);
+    return valid != 0;
+}
+
+void ProjectPoints(const CameraProjection& projection, const float* xyz, const size_t count, float* outXYZ,
+                   uint8_t* outVisible) {
+    constexpr float kZero[3] = {0.0f, 0.0f, 0.0f};
+    TransformPoints(projection.columns, projection.origin, projection.invScale, kZero, 1.0f, true,
+                    xyz, count, outXYZ, outVisible);
+}
+
+void UnProjectPoints(const CameraProjection& projection, const float* xyz, const size_t count, float* outXYZ,
+                     uint8_t* outValid) {
+    constexpr float kZero[3] = {0.0f, 0.0f, 0.0f};
+    TransformPoints(projection.inverse, kZero, 1.0f, projection.origin, 1.0f / projection.invScale, false,
+                    xyz, count, outXYZ, outValid);
+}
+
+bool CameraProjectionMatches(const float* expected, const float* actual) {
+    for (int k = 0; k < 2; ++k) {
+        if (!(std::fabs(expected[k] - actual[k]) <= 0.05f + 1.0e-5f * std::fabs(expected[k]))) {
+            return false;
+        }
+    }
+    return std::fabs(expected[2] - actual[2]) <= 1.0e-4f + 1.0e-4f * std::fabs(expected[2]);
+}
@@ -0,0 +1,41 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+// Native copy of a camera's world -> screen mapping, used by the batch Project/UnProject paths.
+//
+// The game's Project is a projective transform (view, projection and viewport folded together), but cS3DCamera only
+// hands out its matrices as opaque pointers. Instead of guessing their layout, the service feeds a handful of points
+// through the game's Project and solves for the 4x4 matrix that reproduces them. Points are expressed relative to
+// `origin` and scaled by `invScale` so the fit stays well conditioned at city coordinates.
+struct CameraProjection {
+    float columns[4][4]{};      // columns[c] = contribution of local x, y, z, 1 to screen (x, y, depth, w).
+    float inverse[4][4]{};      // Same layout for screen (x, y, depth, 1) -> local (x, y, z, w).
+    float origin[3]{};
+    float invScale = 1.0f;
+    bool valid = false;
+};
+
+/// Points used by FitCameraProjection: a box of half-size `halfExtent` around `center` plus its center.
+constexpr size_t kCameraProjectionFitPoints = 9;
+void GetCameraProjectionFitPoints(const float* center, float halfExtent,
+                                  float (&outPoints)[kCameraProjectionFitPoints][3]);
+
+/// Solves for the projective matrix mapping `world[i]` to `screen[i]`. Needs at least 5 points in general position.
+bool FitCameraProjection(const float (*world)[3], const float (*screen)[3], size_t count, const float* origin,
+                         float scale, CameraProjection& out);
+
+/// Single point helpers. Return false when the point maps to or from infinity (behind the camera for Project).
+bool ProjectPoint(const CameraProjection& projection, const float* world, float* outScreen);
+bool UnProjectPoint(const CameraProjection& projection, const float* screen, float* outWorld);
+
+/// Batch transforms over xyz triples. outVisible/outValid are optional; entries are 1 if the point is in front of the
+/// camera (Project) or has a finite world position (UnProject). Uses SSE when available.
+void ProjectPoints(const CameraProjection& projection, const float* xyz, size_t count, float* outXYZ,
+                   uint8_t* outVisible);
+void UnProjectPoints(const CameraProjection& projection, const float* xyz, size_t count, float* outXYZ,
+                     uint8_t* outValid);
+
+/// True if `actual` is within a sub-pixel tolerance of `expected` (screen xy absolute, depth relative).
+bool CameraProjectionMatches(const float* expected, const float* actual);
@@ -0,0 +1,315 @@
+#include "DrawBufferPool.h"
+
+#include "DX7InterfaceHook.h"
+#include "utils/Logger.h"
+
+#include <algorithm>
+#include <bit>
+#include <cstring>
+
+#include <d3d.h>
+#include <ddraw.h>
+
+namespace {
+    // DX7 caps vertex buffers (and primitive vertex counts) at D3DMAXNUMVERTICES.
+    constexpr uint32_t kMaxVertices = D3DMAXNUMVERTICES;
+}
+
+DrawBufferHandle DrawBufferPool::Create(const DrawBufferDesc& desc) {
+    if (desc.fvf == 0 || desc.vertexStride == 0 || desc.vertexCapacity == 0 || desc.vertexCapacity > kMaxVertices ||
+        (desc.usage != DrawBufferUsage::Static && desc.usage != DrawBufferUsage::Dynamic)) {
+        LOG_ERROR("DrawBufferPool: invalid buffer desc (fvf=0x{:X}, stride={}, capacity={})",
+                  desc.fvf, desc.vertexStride, desc.vertexCapacity);
+        return {0};
+    }
+
+    const uint32_t id = nextBufferId_++;
+    if (id == 0) {
+        LOG_ERROR("DrawBufferPool: buffer ID space exhausted");
+        return {0};
+    }
+
+    ManagedBuffer buffer;
+    buffer.desc = desc;
+    buffers_.emplace(id, std::move(buffer));
+    return {id};
+}
+
+void DrawBufferPool::Release(const DrawBufferHandle handle) {
+    const auto it = buffers_.find(handle.id);
+    if (it == buffers_.end()) {
+        return;
+    }
+    if (it->second.vb) {
+        it->second.vb->Release();
+    }
+    buffers_.erase(it);
+}
+
+bool DrawBufferPool::Write(const DrawBufferHandle handle, const void* vertices, const uint32_t vertexCount,
+                           uint32_t* outStartVertex) {
+    ManagedBuffer* buffer = Find_(handle);
+    if (!buffer || (!vertices && vertexCount != 0) || vertexCount > kMaxVertices) {
+        return false;
+    }
+
+    const size_t byteCount = static_cast<size_t>(vertexCount) * buffer->desc.vertexStride;
+    if (buffer->desc.usage == DrawBufferUsage::Static) {
+        const auto* bytes = static_cast<const uint8_t*>(vertices);
+        buffer->retained.assign(bytes, bytes + byteCount);
+        buffer->retainedCount = vertexCount;
+        if (outStartVertex) {
+            *outStartVertex = 0;
+        }
+        // Upload now if possible; otherwise the next Draw uploads from the retained copy.
+        if (vertexCount > 0 && AcquireDevice_()) {
+            UploadStatic_(*buffer);
+        }
+        return true;
+    }
+
+    if (vertexCount == 0) {
+        if (outStartVertex) {
+            *outStartVertex = buffer->ringCursor;
+        }
+        return true;
+    }
+
+    if (!AcquireDevice_()) {
+        return false;
+    }
+    if (!buffer->vb || buffer->vbCapacity < vertexCount) {
+        const uint32_t capacity = std::min(kMaxVertices,
+                                           std::max(buffer->desc.vertexCapacity, std::bit_ceil(vertexCount)));
+        if (!CreateVertexBuffer_(*buffer, capacity)) {
+            return false;
+        }
+    }
+
+    DWORD lockFlags = DDLOCK_WRITEONLY | DDLOCK_WAIT | DDLOCK_NOOVERWRITE;
+    if (buffer->ringCursor + vertexCount > buffer->vbCapacity) {
+        lockFlags = DDLOCK_WRITEONLY | DDLOCK_WAIT | DDLOCK_DISCARDCONTENTS;
+        buffer->ringCursor = 0;
+    }
+
+    void* data = nullptr;
+    const HRESULT hr = buffer->vb->Lock(lockFlags, &data, nullptr);
+    if (FAILED(hr) || !data) {
+        LOG_WARN("DrawBufferPool: Lock failed (hr=0x{:08X}, id={})", static_cast<uint32_t>(hr), handle.id);
+        OnDeviceError_(hr);
+        return false;
+    }
+    std::memcpy(static_cast<uint8_t*>(data) + static_cast<size_t>(buffer->ringCursor) * buffer->desc.vertexStride,
+                vertices, byteCount);
+    buffer->vb->Unlock();
+
+    if (outStartVertex) {
+        *outStartVertex = buffer->ringCursor;
+    }
+    buffer->ringCursor += vertexCount;
+    return true;
+}
+
+bool DrawBufferPool::SetIndices(const DrawBufferHandle handle, const uint16_t* indices, const uint32_t indexCount) {
+    ManagedBuffer* buffer = Find_(handle);
+    if (!buffer || (!indices && indexCount != 0)) {
+        return false;
+    }
+    buffer->indices.assign(indices, indices + indexCount);
+    buffer->maxIndex = indexCount > 0 ? *std::max_element(buffer->indices.begin(), buffer->indices.end()) : 0;
+    return true;
+}
+
+bool DrawBufferPool::Draw(const DrawBufferHandle handle, const uint32_t primType, const uint32_t startVertex,
+                          const uint32_t vertexCount) {
+    ManagedBuffer* buffer = Find_(handle);
+    if (!buffer || vertexCount == 0) {
+        return false;
+    }
+
+    IDirect3DDevice7* device = AcquireDevice_();
+    if (!device || !EnsureResident_(*buffer) || !IsDrawableRange_(*buffer, startVertex, vertexCount)) {
+        return false;
+    }
+
+    const HRESULT hr = device->DrawPrimitiveVB(static_cast<D3DPRIMITIVETYPE>(primType), buffer->vb,
+                                               startVertex, vertexCount, 0);
+    if (FAILED(hr)) {
+        LOG_WARN("DrawBufferPool: DrawPrimitiveVB failed (hr=0x{:08X}, id={})", static_cast<uint32_t>(hr), handle.id);
+        OnDeviceError_(hr);
+        return false;
+    }
+    return true;
+}
+
+bool DrawBufferPool::DrawIndexed(const DrawBufferHandle handle, const uint32_t primType, const uint32_t startVertex,
+                                 const uint32_t vertexCount, const uint32_t startIndex, const uint32_t indexCount) {
+    ManagedBuffer* buffer = Find_(handle);
+    if (!buffer || vertexCount == 0 || indexCount == 0 ||
+        static_cast<size_t>(startIndex) + indexCount > buffer->indices.size() ||
+        !AreIndicesInRange_(*buffer, startIndex, indexCount, vertexCount)) {
+        return false;
+    }
+
+    IDirect3DDevice7* device = AcquireDevice_();
+    if (!device || !EnsureResident_(*buffer) || !IsDrawableRange_(*buffer, startVertex, vertexCount)) {
+        return false;
+    }
+
+    // Indices are relative to startVertex.
+    const HRESULT hr = device->DrawIndexedPrimitiveVB(static_cast<D3DPRIMITIVETYPE>(primType), buffer->vb,
+                                                      startVertex, vertexCount,
+                                                      buffer->indices.data() + startIndex, indexCount, 0);
+    if (FAILED(hr)) {
+        LOG_WARN("DrawBufferPool: DrawIndexedPrimitiveVB failed (hr=0x{:08X}, id={})",
+                 static_cast<uint32_t>(hr), handle.id);
+        OnDeviceError_(hr);
+        return false;
+    }
+    return true;
+}
+
+void DrawBufferPool::InvalidateAll() {
+    for (auto& [id, buffer] : buffers_) {
+        if (buffer.vb) {
+            buffer.vb->Release();
+            buffer.vb = nullptr;
+        }
+        buffer.vbCapacity = 0;
+        buffer.ringCursor = 0;
+    }
+}
+
+void DrawBufferPool::Clear() {
+    InvalidateAll();
+    buffers_.clear();
+    device_ = nullptr;
+    deviceLost_ = false;
+}
+
+IDirect3DDevice7* DrawBufferPool::AcquireDevice_() {
+    auto* d3dx = DX7InterfaceHook::GetD3DXInterface();
+    if (!d3dx) {
+        return nullptr;
+    }
+    IDirect3DDevice7* device = d3dx->GetD3DDevice();
+    IDirectDraw7* dd = d3dx->GetDD();
+    if (!device || !dd) {
+        return nullptr;
+    }
+
+    if (device != device_) {
+        // The game recreated its device; buffers created on the old one are unusable.
+        InvalidateAll();
+        device_ = device;
+        deviceLost_ = false;
+
+        D3DDEVICEDESC7 caps{};
+        useSystemMemory_ = FAILED(device->GetCaps(&caps)) || caps.deviceGUID != IID_IDirect3DTnLHalDevice;
+        LOG_INFO("DrawBufferPool: bound to device, vertex buffers in {} memory",
+                 useSystemMemory_ ? "system" : "video");
+    }
+
+    if (deviceLost_) {
+        if (FAILED(dd->TestCooperativeLevel())) {
+            return nullptr;
+        }
+        deviceLost_ = false;
+        InvalidateAll();
+        LOG_INFO("DrawBufferPool: device restored, buffers will be recreated on use");
+    }
+    return device;
+}
+
+bool DrawBufferPool::CreateVertexBuffer_(ManagedBuffer& buffer, const uint32_t vertexCapacity) {
+    auto* d3dx = DX7InterfaceHook::GetD3DXInterface();
+    IDirect3D7* d3d = d3dx ? d3dx->GetD3D() : nullptr;
+    if (!d3d) {
+        return false;
+    }
+
+    D3DVERTEXBUFFERDESC vbDesc{};
+    vbDesc.dwSize = sizeof(vbDesc);
+    vbDesc.dwCaps = D3DVBCAPS_WRITEONLY | (useSystemMemory_ ? D3DVBCAPS_SYSTEMMEMORY : 0);
+    vbDesc.dwFVF = buffer.desc.fvf;
+    vbDesc.dwNumVertices = vertexCapacity;
+
+    IDirect3DVertexBuffer7* vb = nullptr;
+    const HRESULT hr = d3d->CreateVertexBuffer(&vbDesc, &vb, 0);
+    if (FAILED(hr) || !vb) {
+        LOG_ERROR("DrawBufferPool: CreateVertexBuffer failed (hr=0x{:08X}, vertices={})",
+                  static_cast<uint32_t>(hr), vertexCapacity);
+        OnDeviceError_(hr);
+        return false;
+    }
+
+    if (buffer.vb) {
+        buffer.vb->Release();
+    }
+    buffer.vb = vb;
+    buffer.vbCapacity = vertexCapacity;
+    buffer.ringCursor = 0;
+    return true;
+}
+
+bool DrawBufferPool::UploadStatic_(ManagedBuffer& buffer) {
+    if (buffer.retainedCount == 0) {
+        return false;
+    }
+    if (!buffer.vb || buffer.vbCapacity < buffer.retainedCount) {
+        if (!CreateVertexBuffer_(buffer, std::max(buffer.desc.vertexCapacity, buffer.retainedCount))) {
+            return false;
+        }
+    }
+
+    void* data = nullptr;
+    const HRESULT hr = buffer.vb->Lock(DDLOCK_WRITEONLY | DDLOCK_WAIT | DDLOCK_DISCARDCONTENTS, &data, nullptr);
+    if (FAILED(hr) || !data) {
+        LOG_WARN("DrawBufferPool: static upload Lock failed (hr=0x{:08X})", static_cast<uint32_t>(hr));
+        OnDeviceError_(hr);
+        return false;
+    }
+    std::memcpy(data, buffer.retained.data(), buffer.retained.size());
+    buffer.vb->Unlock();
+    return true;
+}
+
+bool DrawBufferPool::EnsureResident_(ManagedBuffer& buffer) {
+    if (buffer.vb) {
+        return true;
+    }
+    // Dynamic contents did not survive; the caller rewrites them next frame.
+    return buffer.desc.usage == DrawBufferUsage::Static && UploadStatic_(buffer);
+}
+
+bool DrawBufferPool::IsDrawableRange_(const ManagedBuffer& buffer, const uint32_t startVertex,
+                                      const uint32_t vertexCount) {
+    // A static vb can be larger than what was last written; only the written vertices are defined.
+    const uint32_t limit = buffer.desc.usage == DrawBufferUsage::Static ? buffer.retainedCount : buffer.vbCapacity;
+    return limit > 0 && static_cast<uint64_t>(startVertex) + vertexCount <= limit;
+}
+
+bool DrawBufferPool::AreIndicesInRange_(const ManagedBuffer& buffer, const uint32_t startIndex,
+                                        const uint32_t indexCount, const uint32_t vertexCount) {
+    if (buffer.maxIndex < vertexCount) {
+        return true;
+    }
+    // Indices are relative to startVertex and must stay within the vertexCount vertices D3D is told about.
+    const auto begin = buffer.indices.begin() + startIndex;
+    return std::all_of(begin, begin + indexCount, [vertexCount](const uint16_t index) {
+        return index < vertexCount;
+    });
+}
+
+void DrawBufferPool::OnDeviceError_(const long hr) {
+    if (hr == DDERR_SURFACELOST && !deviceLost_) {
+        LOG_WARN("DrawBufferPool: device lost, releasing vertex buffers");
+        deviceLost_ = true;
+        InvalidateAll();
+    }
+}
+
+DrawBufferPool::ManagedBuffer* DrawBufferPool::Find_(const DrawBufferHandle handle) {
+    const auto it = buffers_.find(handle.id);
+    return it != buffers_.end() ? &it->second : nullptr;
+}
@@ -0,0 +1,69 @@
+#pragma once
+
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+#include "public/cIGZDrawService.h"
+
+struct IDirect3DDevice7;
+struct IDirect3DVertexBuffer7;
+
+// Owns the IDirect3DVertexBuffer7 objects handed out by DrawService::CreateDrawBuffer.
+//
+// Static buffers keep a system-memory copy of their vertices and are recreated from it after device loss or a device
+// change. Dynamic buffers are rings: writes append with DDLOCK_NOOVERWRITE and wrap with DDLOCK_DISCARDCONTENTS, so
+// the driver never has to stall on a vertex range the GPU may still be reading. Their contents are not retained;
+// callers rewrite them every frame anyway.
+//
+// DX7 has no index buffer objects. Indices are retained per buffer and passed to DrawIndexedPrimitiveVB.
+//
+// Thread safety: render thread only, like the ImGui texture API.
+class DrawBufferPool {
+public:
+    DrawBufferPool() = default;
+
+    DrawBufferPool(const DrawBufferPool&) = delete;
+    DrawBufferPool& operator=(const DrawBufferPool&) = delete;
+
+    DrawBufferHandle Create(const DrawBufferDesc& desc);
+    void Release(DrawBufferHandle handle);
+    bool Write(DrawBufferHandle handle, const void* vertices, uint32_t vertexCount, uint32_t* outStartVertex);
+    bool SetIndices(DrawBufferHandle handle, const uint16_t* indices, uint32_t indexCount);
+    bool Draw(DrawBufferHandle handle, uint32_t primType, uint32_t startVertex, uint32_t vertexCount);
+    bool DrawIndexed(DrawBufferHandle handle, uint32_t primType, uint32_t startVertex, uint32_t vertexCount,
+                     uint32_t startIndex, uint32_t indexCount);
+
+    // Releases every D3D object; retained data stays so buffers come back on next use.
+    void InvalidateAll();
+    // Releases everything, including retained data. Called from DrawService::Shutdown.
+    void Clear();
+
+private:
+    struct ManagedBuffer {
+        DrawBufferDesc desc{};
+        IDirect3DVertexBuffer7* vb = nullptr;
+        uint32_t vbCapacity = 0;            // Vertices the current vb can hold.
+        uint32_t ringCursor = 0;            // Dynamic: next free vertex.
+        std::vector<uint8_t> retained{};    // Static: vertex bytes used to recreate vb.
+        uint32_t retainedCount = 0;
+        std::vector<uint16_t> indices{};
+        uint16_t maxIndex = 0;              // Largest of indices; draws covering more vertices skip the range scan.
+    };
+
+    IDirect3DDevice7* AcquireDevice_();
+    bool CreateVertexBuffer_(ManagedBuffer& buffer, uint32_t vertexCapacity);
+    bool UploadStatic_(ManagedBuffer& buffer);
+    bool EnsureResident_(ManagedBuffer& buffer);
+    static bool IsDrawableRange_(const ManagedBuffer& buffer, uint32_t startVertex, uint32_t vertexCount);
+    static bool AreIndicesInRange_(const ManagedBuffer& buffer, uint32_t startIndex, uint32_t indexCount,
+                                   uint32_t vertexCount);
+    void OnDeviceError_(long hr);
+    ManagedBuffer* Find_(DrawBufferHandle handle);
+
+    std::unordered_map<uint32_t, ManagedBuffer> buffers_{};
+    uint32_t nextBufferId_ = 1;
+    IDirect3DDevice7* device_ = nullptr;    // Device the current vertex buffers belong to; not AddRef'd.
+    bool deviceLost_ = false;
+    bool useSystemMemory_ = false;
+};
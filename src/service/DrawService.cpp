@@ -1,6 +1,7 @@
 #include "DrawService.h"
 
 #include "cISC43DRender.h"
+#include "public/DrawCommandList.h"
 #include "cISC4View3DWin.h"
 #include "SC4UI.h"
 #include "utils/Logger.h"
@@ -8,7 +9,10 @@
 
 #include <algorithm>
 #include <array>
+#include <bit>
 #include <cstring>
+#include <limits>
+#include <utility>
 #include <windows.h>
 
 namespace {
@@ -26,12 +30,150 @@ namespace {
         }
     }
 
+    constexpr std::array kAllPasses{
+        DrawServicePass::PreStatic, DrawServicePass::Static, DrawServicePass::PostStatic,
+        DrawServicePass::PreDynamic, DrawServicePass::Dynamic, DrawServicePass::PostDynamic,
+    };
+
     struct cS3DVector4 {
         float x;
         float y;
         float z;
         float w;
     };
+
+    constexpr size_t kInvalidPayloadSize = (std::numeric_limits<size_t>::max)();
+
+    size_t GetCommandPayloadSize(const DrawCommandOp op) {
+        using namespace DrawCommandPayload;
+        switch (op) {
+        case DrawCommandOp::SetHighlightColor: return sizeof(HighlightColor);
+        case DrawCommandOp::SetRenderStateHighlight: return sizeof(RenderStateHighlight);
+        case DrawCommandOp::SetModelTransform: return sizeof(ModelTransform);
+        case DrawCommandOp::SetShade: return sizeof(Color);
+        case DrawCommandOp::RenderMesh: return sizeof(Pointer);
+        case DrawCommandOp::RenderModelInstance: return sizeof(ModelInstance);
+        case DrawCommandOp::SetTexWrapModes:
+        case DrawCommandOp::SetTexFiltering: return sizeof(StagePair);
+        case DrawCommandOp::SetTexture:
+        case DrawCommandOp::EnableTextureStateFlag:
+        case DrawCommandOp::SetTexEnvMode:
+        case DrawCommandOp::SetTexCoord: return sizeof(StageValue);
+        case DrawCommandOp::SetTexColor: return sizeof(Color);
+        case DrawCommandOp::EnableBlendStateFlag:
+        case DrawCommandOp::EnableAlphaTestFlag:
+        case DrawCommandOp::EnableColorMaskFlag:
+        case DrawCommandOp::EnableCullFaceFlag:
+        case DrawCommandOp::EnableDepthMaskFlag:
+        case DrawCommandOp::EnableDepthTestFlag:
+        case DrawCommandOp::SetLighting: return sizeof(Flag);
+        case DrawCommandOp::SetBlendFunc: return sizeof(BlendFunc);
+        case DrawCommandOp::SetAlphaFunc: return sizeof(AlphaFunc);
+        case DrawCommandOp::SetDepthFunc:
+        case DrawCommandOp::SetDepthOffset: return sizeof(Value);
+        case DrawCommandOp::SetFog: return sizeof(Fog);
+        case DrawCommandOp::DrawBoundingBox: return sizeof(BoundingBox);
+        case DrawCommandOp::DrawPrims: return sizeof(Prims);
+        case DrawCommandOp::DrawPrimsIndexed: return sizeof(PrimsIndexed);
+        case DrawCommandOp::DrawBufferPrimitives: return sizeof(BufferPrims);
+        case DrawCommandOp::DrawBufferIndexedPrimitives: return sizeof(BufferPrimsIndexed);
+        case DrawCommandOp::ResetModelViewTransform:
+        case DrawCommandOp::ResetShade:
+        case DrawCommandOp::SetDefaultRenderState:
+        case DrawCommandOp::SetDefaultRenderStateUnilaterally:
+        case DrawCommandOp::SetTransparency:
+        case DrawCommandOp::ResetTransparency: return 0;
+        default:
+            return kInvalidPayloadSize;
+        }
+    }
+
+    // Checks every header once at submission so replay can decode without bounds checks.
+    bool ValidateCommandList(const uint8_t* bytes, const size_t size, size_t& badOffsetOut) {
+        size_t offset = 0;
+        while (offset < size) {
+            DrawCommandHeader header{};
+            if (size - offset < sizeof(header)) {
+                badOffsetOut = offset;
+                return false;
+            }
+            std::memcpy(&header, bytes + offset, sizeof(header));
+            const size_t payloadSize = GetCommandPayloadSize(header.op);
+            if (payloadSize == kInvalidPayloadSize || header.size != sizeof(header) + payloadSize ||
+                size - offset < header.size) {
+                badOffsetOut = offset;
+                return false;
+            }
+            offset += header.size;
+        }
+        return true;
+    }
+
+    template <typename T>
+    T ReadCommandPayload(const uint8_t* payload) {
+        T value;
+        std::memcpy(&value, payload, sizeof(T));
+        return value;
+    }
+
+    // Capture payload builders. Pointees with a known size are inlined so the trace is self-contained;
+    // null arguments are recorded as zeros.
+    uint32_t TracePointer(const void* ptr) {
+        return static_cast<uint32_t>(reinterpret_cast<uintptr_t>(ptr));
+    }
+
+    template <size_t N>
+    void CopyFloats(float (&dst)[N], const void* src) {
+        if (src) {
+            std::memcpy(dst, src, sizeof(dst));
+        }
+    }
+
+    DrawCommandPayload::ModelTransform MakeMatrixRecord(const void* transform4x4) {
+        DrawCommandPayload::ModelTransform record{};
+        CopyFloats(record.matrix, transform4x4);
+        return record;
+    }
+
+    DrawCommandPayload::Color MakeColorRecord(const float* rgba) {
+        DrawCommandPayload::Color record{};
+        CopyFloats(record.rgba, rgba);
+        return record;
+    }
+
+    DrawTracePayload::ModelShade MakeModelShadeRecord(const void* modelInstance, const float* rgba) {
+        DrawTracePayload::ModelShade record{TracePointer(modelInstance), {}};
+        CopyFloats(record.rgba, rgba);
+        return record;
+    }
+
+    DrawTracePayload::TexTransform MakeTexTransformRecord(const void* transform4x4, const int stage) {
+        DrawTracePayload::TexTransform record{{}, stage};
+        CopyFloats(record.matrix, transform4x4);
+        return record;
+    }
+
+    DrawCommandPayload::Fog MakeFogRecord(const bool enableFog, const float* fogColorRgb,
+                                          const float fogStart, const float fogEnd) {
+        DrawCommandPayload::Fog record{enableFog ? 1u : 0u, {}, fogStart, fogEnd};
+        CopyFloats(record.rgb, fogColorRgb);
+        return record;
+    }
+
+    DrawCommandPayload::BoundingBox MakeBoundingBoxRecord(const float* bbox6, const float r, const float g,
+                                                          const float b, const float a) {
+        DrawCommandPayload::BoundingBox record{{}, {r, g, b, a}};
+        CopyFloats(record.bbox, bbox6);
+        return record;
+    }
+
+    DrawTracePayload::Rect MakeRectRecord(const void* drawTarget, const int* rect) {
+        DrawTracePayload::Rect record{TracePointer(drawTarget), {}};
+        if (rect) {
+            std::memcpy(record.rect, rect, sizeof(record.rect));
+        }
+        return record;
+    }
 }
 
 DrawService* DrawService::activeInstance_ = nullptr;
@@ -181,11 +323,7 @@ void DrawService::UnregisterDrawPassCallback(const uint32_t token) {
     const DrawServicePass pass = it->pass;
     passCallbacks_.erase(it);
 
-    const bool passStillInUse = std::any_of(passCallbacks_.begin(), passCallbacks_.end(),
-                                            [pass](const DrawPassCallbackRegistration& reg) {
-                                                return reg.pass == pass;
-                                            });
-    if (!passStillInUse) {
+    if (!IsPassInUseLocked_(pass)) {
         UninstallPassCallSitePatchesLocked_(pass);
     }
 }
@@ -196,6 +334,8 @@ void DrawService::SetHighlightColor(const SC4DrawContextHandle handle, const int
     if (!drawContext || !thunks_.setHighlightColor) {
         return;
     }
+    Capture_(DrawCommandOp::SetHighlightColor, drawContext,
+             DrawCommandPayload::HighlightColor{highlightType, {r, g, b, a}});
     const cS3DVector4 color{r, g, b, a};
     thunks_.setHighlightColor(drawContext, highlightType, &color);
 }
@@ -203,7 +343,10 @@ void DrawService::SetHighlightColor(const SC4DrawContextHandle handle, const int
 void DrawService::SetRenderStateHighlight(const SC4DrawContextHandle handle, const int highlightType) {
     auto* drawContext = Validate(handle);
     if (drawContext && thunks_.setRenderStateHighlightSimple) {
+        Capture_(DrawCommandOp::SetRenderStateHighlight, drawContext,
+                 DrawCommandPayload::RenderStateHighlight{highlightType});
         thunks_.setRenderStateHighlightSimple(drawContext, highlightType);
+        InvalidateStateCache_(drawContext);
     }
 }
 
@@ -211,13 +354,17 @@ void DrawService::SetRenderStateHighlight(const SC4DrawContextHandle handle,
                                           const void* material, const void* highlightDesc) {
     auto* drawContext = Validate(handle);
     if (drawContext && thunks_.setRenderStateHighlightMaterial) {
+        Capture_(DrawTraceOp::SetRenderStateHighlightMaterial, drawContext,
+                 DrawTracePayload::HighlightMaterial{TracePointer(material), TracePointer(highlightDesc)});
         thunks_.setRenderStateHighlightMaterial(drawContext, material, highlightDesc);
+        InvalidateStateCache_(drawContext);
     }
 }
 
 void DrawService::SetModelTransform(const SC4DrawContextHandle handle, const void* transform4x4) {
     auto* drawContext = Validate(handle);
     if (drawContext && thunks_.setModelTransform) {
+        Capture_(DrawTraceOp::SetModelTransformRaw, drawContext, MakeMatrixRecord(transform4x4));
         thunks_.setModelTransform(drawContext, transform4x4);
     }
 }
@@ -225,6 +372,7 @@ void DrawService::SetModelTransform(const SC4DrawContextHandle handle, const voi
 void DrawService::SetModelTransform(const SC4DrawContextHandle handle, float* transform4x4) {
     auto* drawContext = Validate(handle);
     if (drawContext && thunks_.setModelTransformFloats) {
+        Capture_(DrawCommandOp::SetModelTransform, drawContext, MakeMatrixRecord(transform4x4));
         thunks_.setModelTransformFloats(drawContext, transform4x4);
     }
 }
@@ -232,6 +380,8 @@ void DrawService::SetModelTransform(const SC4DrawContextHandle handle, float* tr
 void DrawService::SetModelViewTransformChanged(const SC4DrawContextHandle handle, const int changed) {
     auto* drawContext = Validate(handle);
     if (drawContext && thunks_.setModelViewTransformChanged) {
+        Capture_(DrawTraceOp::SetModelViewTransformChanged, drawContext,
+                 DrawCommandPayload::Value{static_cast<uint32_t>(changed)});
         thunks_.setModelViewTransformChanged(drawContext, changed);
     }
 }
@@ -239,6 +389,7 @@ void DrawService::SetModelViewTransformChanged(const SC4DrawContextHandle handle
 void DrawService::ResetModelViewTransform(const SC4DrawContextHandle handle) {
     auto* drawContext = Validate(handle);
     if (drawContext && thunks_.resetModelViewTransform) {
+        Capture_(DrawCommandOp::ResetModelViewTransform, drawContext);
         thunks_.resetModelViewTransform(drawContext);
     }
 }
@@ -246,6 +397,7 @@ void DrawService::ResetModelViewTransform(const SC4DrawContextHandle handle) {
 void DrawService::GetModelViewMatrix(const SC4DrawContextHandle handle, void* outMatrix4x4) {
     auto* drawContext = Validate(handle);
     if (drawContext && thunks_.getModelViewMatrix) {
+        Capture_(DrawTraceOp::GetModelViewMatrix, drawContext);
         thunks_.getModelViewMatrix(drawContext, outMatrix4x4);
     }
 }
@@ -253,6 +405,7 @@ void DrawService::GetModelViewMatrix(const SC4DrawContextHandle handle, void* ou
 void DrawService::SetModelShade(const SC4DrawContextHandle handle, void* modelInstance, const float* rgba) {
     auto* drawContext = Validate(handle);
     if (drawContext && thunks_.setModelShade) {
+        Capture_(DrawTraceOp::SetModelShade, drawContext, MakeModelShadeRecord(modelInstance, rgba));
         thunks_.setModelShade(drawContext, modelInstance, rgba);
     }
 }
@@ -260,6 +413,7 @@ void DrawService::SetModelShade(const SC4DrawContextHandle handle, void* modelIn
 void DrawService::SetShade(const SC4DrawContextHandle handle, const float* rgba) {
     auto* drawContext = Validate(handle);
     if (drawContext && thunks_.setShade) {
+        Capture_(DrawCommandOp::SetShade, drawContext, MakeColorRecord(rgba));
         thunks_.setShade(drawContext, rgba);
     }
 }
@@ -267,6 +421,7 @@ void DrawService::SetShade(const SC4DrawContextHandle handle, const float* rgba)
 void DrawService::SetSelfLitShade(const SC4DrawContextHandle handle, void* selfLitShade) {
     auto* drawContext = Validate(handle);
     if (drawContext && thunks_.setSelfLitShade) {
+        Capture_(DrawTraceOp::SetSelfLitShade, drawContext, DrawTracePayload::Pointer{TracePointer(selfLitShade)});
         thunks_.setSelfLitShade(drawContext, selfLitShade);
     }
 }
@@ -274,6 +429,7 @@ void DrawService::SetSelfLitShade(const SC4DrawContextHandle handle, void* selfL
 void DrawService::ResetShade(const SC4DrawContextHandle handle) {
     auto* drawContext = Validate(handle);
     if (drawContext && thunks_.resetShade) {
+        Capture_(DrawCommandOp::ResetShade, drawContext);
         thunks_.resetShade(drawContext);
     }
 }
@@ -281,42 +437,56 @@ void DrawService::ResetShade(const SC4DrawContextHandle handle) {
 void DrawService::SetRenderState(const SC4DrawContextHandle handle, void* packedRenderState, void* materialState) {
     auto* drawContext = Validate(handle);
     if (drawContext && thunks_.setRenderState) {
+        Capture_(DrawTraceOp::SetRenderState, drawContext,
+                 DrawTracePayload::RenderState{TracePointer(packedRenderState), TracePointer(materialState)});
         thunks_.setRenderState(drawContext, packedRenderState, materialState);
+        InvalidateStateCache_(drawContext);
     }
 }
 
 void DrawService::SetRenderState(const SC4DrawContextHandle handle, uint32_t* packedRenderState) {
     auto* drawContext = Validate(handle);
     if (drawContext && thunks_.setRenderStatePacked) {
+        Capture_(DrawTraceOp::SetRenderStatePacked, drawContext,
+                 DrawTracePayload::Pointer{TracePointer(packedRenderState)});
         thunks_.setRenderStatePacked(drawContext, packedRenderState);
+        InvalidateStateCache_(drawContext);
     }
 }
 
 void DrawService::SetDefaultRenderState(const SC4DrawContextHandle handle) {
     auto* drawContext = Validate(handle);
     if (drawContext && thunks_.setDefaultRenderState) {
+        Capture_(DrawCommandOp::SetDefaultRenderState, drawContext);
         thunks_.setDefaultRenderState(drawContext);
+        InvalidateStateCache_(drawContext);
     }
 }
 
 void DrawService::SetDefaultRenderStateUnilaterally(const SC4DrawContextHandle handle) {
     auto* drawContext = Validate(handle);
     if (drawContext && thunks_.setDefaultRenderStateUnilaterally) {
+        Capture_(DrawCommandOp::SetDefaultRenderStateUnilaterally, drawContext);
         thunks_.setDefaultRenderStateUnilaterally(drawContext);
+        InvalidateStateCache_(drawContext);
     }
 }
 
 void DrawService::SetEmulatedSecondStageRenderState(const SC4DrawContextHandle handle) {
     auto* drawContext = Validate(handle);
     if (drawContext && thunks_.setEmulatedSecondStageRenderState) {
+        Capture_(DrawTraceOp::SetEmulatedSecondStageRenderState, drawContext);
         thunks_.setEmulatedSecondStageRenderState(drawContext);
+        InvalidateStateCache_(drawContext);
     }
 }
 
 void DrawService::RenderMesh(const SC4DrawContextHandle handle, void* mesh) {
     auto* drawContext = Validate(handle);
     if (drawContext && thunks_.renderMesh) {
+        Capture_(DrawCommandOp::RenderMesh, drawContext, DrawCommandPayload::Pointer{mesh});
         thunks_.renderMesh(drawContext, mesh);
+        InvalidateStateCache_(drawContext);
     }
 }
 
@@ -324,35 +494,54 @@ void DrawService::RenderModelInstance(const SC4DrawContextHandle handle, int* mo
                                       int* modelList, uint8_t* drawInfo, const bool previewOnly) {
     auto* drawContext = Validate(handle);
     if (drawContext && thunks_.renderModelInstance) {
+        Capture_(DrawCommandOp::RenderModelInstance, drawContext,
+                 DrawCommandPayload::ModelInstance{modelCount, modelList, drawInfo, previewOnly ? 1u : 0u});
         thunks_.renderModelInstance(drawContext, modelCount, modelList, drawInfo, previewOnly);
+        InvalidateStateCache_(drawContext);
     }
 }
 
 void DrawService::SetTexWrapModes(const SC4DrawContextHandle handle, const int uMode, const int vMode, const int stage) {
     auto* drawContext = Validate(handle);
     if (drawContext && thunks_.setTexWrapModes) {
-        thunks_.setTexWrapModes(drawContext, uMode, vMode, stage);
+        Capture_(DrawCommandOp::SetTexWrapModes, drawContext, DrawCommandPayload::StagePair{uMode, vMode, stage});
+        const std::array<uint32_t, 2> values{static_cast<uint32_t>(uMode), static_cast<uint32_t>(vMode)};
+        if (!SkipRedundantState_(drawContext, StageSlot_(stage, kStageSlotWrapModes), values)) {
+            thunks_.setTexWrapModes(drawContext, uMode, vMode, stage);
+        }
     }
 }
 
 void DrawService::SetTexFiltering(const SC4DrawContextHandle handle, const int minFilter, const int magFilter, const int stage) {
     auto* drawContext = Validate(handle);
     if (drawContext && thunks_.setTexFiltering) {
-        thunks_.setTexFiltering(drawContext, minFilter, magFilter, stage);
+        Capture_(DrawCommandOp::SetTexFiltering, drawContext,
+                 DrawCommandPayload::StagePair{minFilter, magFilter, stage});
+        const std::array<uint32_t, 2> values{static_cast<uint32_t>(minFilter), static_cast<uint32_t>(magFilter)};
+        if (!SkipRedundantState_(drawContext, StageSlot_(stage, kStageSlotFiltering), values)) {
+            thunks_.setTexFiltering(drawContext, minFilter, magFilter, stage);
+        }
     }
 }
 
 void DrawService::SetTexture(const SC4DrawContextHandle handle, const uint32_t texture, const int stage) {
     auto* drawContext = Validate(handle);
     if (drawContext && thunks_.setTexture) {
-        thunks_.setTexture(drawContext, texture, stage);
+        Capture_(DrawCommandOp::SetTexture, drawContext, DrawCommandPayload::StageValue{texture, stage});
+        if (!SkipRedundantState_(drawContext, StageSlot_(stage, kStageSlotTexture), texture)) {
+            thunks_.setTexture(drawContext, texture, stage);
+        }
     }
 }
 
 void DrawService::EnableTextureStateFlag(const SC4DrawContextHandle handle, const bool enable, const int stage) {
     auto* drawContext = Validate(handle);
     if (drawContext && thunks_.enableTextureStateFlag) {
-        thunks_.enableTextureStateFlag(drawContext, enable ? 1 : 0, stage);
+        Capture_(DrawCommandOp::EnableTextureStateFlag, drawContext,
+                 DrawCommandPayload::StageValue{enable ? 1u : 0u, stage});
+        if (!SkipRedundantState_(drawContext, StageSlot_(stage, kStageSlotTextureEnable), enable ? 1u : 0u)) {
+            thunks_.enableTextureStateFlag(drawContext, enable ? 1 : 0, stage);
+        }
     }
 }
 
@@ -361,6 +550,12 @@ void DrawService::SetTexColor(const SC4DrawContextHandle handle, const float r,
     if (!drawContext || !thunks_.setTexColor) {
         return;
     }
+    Capture_(DrawCommandOp::SetTexColor, drawContext, DrawCommandPayload::Color{{r, g, b, a}});
+    const std::array values{std::bit_cast<uint32_t>(r), std::bit_cast<uint32_t>(g),
+                            std::bit_cast<uint32_t>(b), std::bit_cast<uint32_t>(a)};
+    if (SkipRedundantState_(drawContext, kSlotTexColor, values)) {
+        return;
+    }
     const cS3DVector4 color{r, g, b, a};
     thunks_.setTexColor(drawContext, &color);
 }
@@ -368,20 +563,27 @@ void DrawService::SetTexColor(const SC4DrawContextHandle handle, const float r,
 void DrawService::SetTexCombiner(const SC4DrawContextHandle handle, void* combinerState, const int stage) {
     auto* drawContext = Validate(handle);
     if (drawContext && thunks_.setTexCombiner) {
+        Capture_(DrawTraceOp::SetTexCombiner, drawContext,
+                 DrawTracePayload::StagePointer{TracePointer(combinerState), stage});
         thunks_.setTexCombiner(drawContext, combinerState, stage);
+        InvalidateStateCache_(drawContext);
     }
 }
 
 void DrawService::SetTexEnvMode(const SC4DrawContextHandle handle, const uint32_t envMode, const int stage) {
     auto* drawContext = Validate(handle);
     if (drawContext && thunks_.setTexEnvMode) {
-        thunks_.setTexEnvMode(drawContext, envMode, stage);
+        Capture_(DrawCommandOp::SetTexEnvMode, drawContext, DrawCommandPayload::StageValue{envMode, stage});
+        if (!SkipRedundantState_(drawContext, StageSlot_(stage, kStageSlotEnvMode), envMode)) {
+            thunks_.setTexEnvMode(drawContext, envMode, stage);
+        }
     }
 }
 
 void DrawService::SetTexTransform4(const SC4DrawContextHandle handle, void* transform4x4, const int stage) {
     auto* drawContext = Validate(handle);
     if (drawContext && thunks_.setTexTransform4) {
+        Capture_(DrawTraceOp::SetTexTransform4, drawContext, MakeTexTransformRecord(transform4x4, stage));
         thunks_.setTexTransform4(drawContext, transform4x4, stage);
     }
 }
@@ -389,6 +591,7 @@ void DrawService::SetTexTransform4(const SC4DrawContextHandle handle, void* tran
 void DrawService::ClearTexTransform(const SC4DrawContextHandle handle, const int stage) {
     auto* drawContext = Validate(handle);
     if (drawContext && thunks_.clearTexTransform) {
+        Capture_(DrawTraceOp::ClearTexTransform, drawContext, DrawTracePayload::Stage{stage});
         thunks_.clearTexTransform(drawContext, stage);
     }
 }
@@ -396,13 +599,18 @@ void DrawService::ClearTexTransform(const SC4DrawContextHandle handle, const int
 void DrawService::SetTexCoord(const SC4DrawContextHandle handle, const int texCoord, const int stage) {
     auto* drawContext = Validate(handle);
     if (drawContext && thunks_.setTexCoord) {
-        thunks_.setTexCoord(drawContext, texCoord, stage);
+        Capture_(DrawCommandOp::SetTexCoord, drawContext,
+                 DrawCommandPayload::StageValue{static_cast<uint32_t>(texCoord), stage});
+        if (!SkipRedundantState_(drawContext, StageSlot_(stage, kStageSlotTexCoord), static_cast<uint32_t>(texCoord))) {
+            thunks_.setTexCoord(drawContext, texCoord, stage);
+        }
     }
 }
 
 void DrawService::SetVertexBuffer(const SC4DrawContextHandle handle) {
     auto* drawContext = Validate(handle);
     if (drawContext && thunks_.setVertexBuffer) {
+        Capture_(DrawTraceOp::SetVertexBuffer, drawContext);
         thunks_.setVertexBuffer(drawContext);
     }
 }
@@ -410,6 +618,7 @@ void DrawService::SetVertexBuffer(const SC4DrawContextHandle handle) {
 void DrawService::SetIndexBuffer(const SC4DrawContextHandle handle, const uint32_t indexBuffer, const uint32_t indexFormat) {
     auto* drawContext = Validate(handle);
     if (drawContext && thunks_.setIndexBuffer) {
+        Capture_(DrawTraceOp::SetIndexBuffer, drawContext, DrawTracePayload::IndexBuffer{indexBuffer, indexFormat});
         thunks_.setIndexBuffer(drawContext, indexBuffer, indexFormat);
     }
 }
@@ -417,96 +626,140 @@ void DrawService::SetIndexBuffer(const SC4DrawContextHandle handle, const uint32
 void DrawService::EnableBlendStateFlag(const SC4DrawContextHandle handle, const bool enabled) {
     auto* drawContext = Validate(handle);
     if (drawContext && thunks_.enableBlendStateFlag) {
-        thunks_.enableBlendStateFlag(drawContext, enabled ? 1 : 0);
+        Capture_(DrawCommandOp::EnableBlendStateFlag, drawContext, DrawCommandPayload::Flag{enabled ? 1u : 0u});
+        if (!SkipRedundantState_(drawContext, kSlotBlendEnable, enabled ? 1u : 0u)) {
+            thunks_.enableBlendStateFlag(drawContext, enabled ? 1 : 0);
+        }
     }
 }
 
 void DrawService::EnableAlphaTestFlag(const SC4DrawContextHandle handle, const bool enabled) {
     auto* drawContext = Validate(handle);
     if (drawContext && thunks_.enableAlphaTestFlag) {
-        thunks_.enableAlphaTestFlag(drawContext, enabled);
+        Capture_(DrawCommandOp::EnableAlphaTestFlag, drawContext, DrawCommandPayload::Flag{enabled ? 1u : 0u});
+        if (!SkipRedundantState_(drawContext, kSlotAlphaTestEnable, enabled ? 1u : 0u)) {
+            thunks_.enableAlphaTestFlag(drawContext, enabled);
+        }
     }
 }
 
 void DrawService::EnableColorMaskFlag(const SC4DrawContextHandle handle, const bool enabled) {
     auto* drawContext = Validate(handle);
     if (drawContext && thunks_.enableColorMaskFlag) {
-        thunks_.enableColorMaskFlag(drawContext, enabled);
+        Capture_(DrawCommandOp::EnableColorMaskFlag, drawContext, DrawCommandPayload::Flag{enabled ? 1u : 0u});
+        if (!SkipRedundantState_(drawContext, kSlotColorMaskEnable, enabled ? 1u : 0u)) {
+            thunks_.enableColorMaskFlag(drawContext, enabled);
+        }
     }
 }
 
 void DrawService::EnableCullFaceFlag(const SC4DrawContextHandle handle, const bool enabled) {
     auto* drawContext = Validate(handle);
     if (drawContext && thunks_.enableCullFaceFlag) {
-        thunks_.enableCullFaceFlag(drawContext, enabled ? 1 : 0);
+        Capture_(DrawCommandOp::EnableCullFaceFlag, drawContext, DrawCommandPayload::Flag{enabled ? 1u : 0u});
+        if (!SkipRedundantState_(drawContext, kSlotCullFaceEnable, enabled ? 1u : 0u)) {
+            thunks_.enableCullFaceFlag(drawContext, enabled ? 1 : 0);
+        }
     }
 }
 
 void DrawService::EnableDepthMaskFlag(const SC4DrawContextHandle handle, const bool enabled) {
     auto* drawContext = Validate(handle);
     if (drawContext && thunks_.enableDepthMaskFlag) {
-        thunks_.enableDepthMaskFlag(drawContext, enabled);
+        Capture_(DrawCommandOp::EnableDepthMaskFlag, drawContext, DrawCommandPayload::Flag{enabled ? 1u : 0u});
+        if (!SkipRedundantState_(drawContext, kSlotDepthMaskEnable, enabled ? 1u : 0u)) {
+            thunks_.enableDepthMaskFlag(drawContext, enabled);
+        }
     }
 }
 
 void DrawService::EnableDepthTestFlag(const SC4DrawContextHandle handle, const bool enabled) {
     auto* drawContext = Validate(handle);
     if (drawContext && thunks_.enableDepthTestFlag) {
-        thunks_.enableDepthTestFlag(drawContext, enabled ? 1 : 0);
+        Capture_(DrawCommandOp::EnableDepthTestFlag, drawContext, DrawCommandPayload::Flag{enabled ? 1u : 0u});
+        if (!SkipRedundantState_(drawContext, kSlotDepthTestEnable, enabled ? 1u : 0u)) {
+            thunks_.enableDepthTestFlag(drawContext, enabled ? 1 : 0);
+        }
     }
 }
 
 void DrawService::SetBlendFunc(const SC4DrawContextHandle handle, const uint32_t srcFactor, const uint32_t dstFactor) {
     auto* drawContext = Validate(handle);
     if (drawContext && thunks_.setBlendFunc) {
-        thunks_.setBlendFunc(drawContext, srcFactor, dstFactor);
+        Capture_(DrawCommandOp::SetBlendFunc, drawContext, DrawCommandPayload::BlendFunc{srcFactor, dstFactor});
+        const std::array<uint32_t, 2> values{srcFactor, dstFactor};
+        if (!SkipRedundantState_(drawContext, kSlotBlendFunc, values)) {
+            thunks_.setBlendFunc(drawContext, srcFactor, dstFactor);
+        }
     }
 }
 
 void DrawService::SetAlphaFunc(const SC4DrawContextHandle handle, const uint32_t alphaFunc, const float alphaRef) {
     auto* drawContext = Validate(handle);
     if (drawContext && thunks_.setAlphaFunc) {
-        thunks_.setAlphaFunc(drawContext, alphaFunc, alphaRef);
+        Capture_(DrawCommandOp::SetAlphaFunc, drawContext, DrawCommandPayload::AlphaFunc{alphaFunc, alphaRef});
+        const std::array<uint32_t, 2> values{alphaFunc, std::bit_cast<uint32_t>(alphaRef)};
+        if (!SkipRedundantState_(drawContext, kSlotAlphaFunc, values)) {
+            thunks_.setAlphaFunc(drawContext, alphaFunc, alphaRef);
+        }
     }
 }
 
 void DrawService::SetDepthFunc(const SC4DrawContextHandle handle, const uint32_t depthFunc) {
     auto* drawContext = Validate(handle);
     if (drawContext && thunks_.setDepthFunc) {
-        thunks_.setDepthFunc(drawContext, depthFunc);
+        Capture_(DrawCommandOp::SetDepthFunc, drawContext, DrawCommandPayload::Value{depthFunc});
+        if (!SkipRedundantState_(drawContext, kSlotDepthFunc, depthFunc)) {
+            thunks_.setDepthFunc(drawContext, depthFunc);
+        }
     }
 }
 
 void DrawService::SetDepthOffset(const SC4DrawContextHandle handle, const int depthOffset) {
     auto* drawContext = Validate(handle);
     if (drawContext && thunks_.setDepthOffset) {
-        thunks_.setDepthOffset(drawContext, depthOffset);
+        Capture_(DrawCommandOp::SetDepthOffset, drawContext,
+                 DrawCommandPayload::Value{static_cast<uint32_t>(depthOffset)});
+        if (!SkipRedundantState_(drawContext, kSlotDepthOffset, static_cast<uint32_t>(depthOffset))) {
+            thunks_.setDepthOffset(drawContext, depthOffset);
+        }
     }
 }
 
 void DrawService::SetTransparency(const SC4DrawContextHandle handle) {
     auto* drawContext = Validate(handle);
     if (drawContext && thunks_.setTransparency) {
+        Capture_(DrawCommandOp::SetTransparency, drawContext);
         thunks_.setTransparency(drawContext);
+        InvalidateStateCache_(drawContext);
     }
 }
 
 void DrawService::ResetTransparency(const SC4DrawContextHandle handle) {
     auto* drawContext = Validate(handle);
     if (drawContext && thunks_.resetTransparency) {
+        Capture_(DrawCommandOp::ResetTransparency, drawContext);
         thunks_.resetTransparency(drawContext);
+        InvalidateStateCache_(drawContext);
     }
 }
 
 bool DrawService::GetLighting(const SC4DrawContextHandle handle) {
     auto* drawContext = Validate(handle);
-    return drawContext && thunks_.getLighting ? thunks_.getLighting(drawContext) != 0 : false;
+    if (!drawContext || !thunks_.getLighting) {
+        return false;
+    }
+    Capture_(DrawTraceOp::GetLighting, drawContext);
+    return thunks_.getLighting(drawContext) != 0;
 }
 
 void DrawService::SetLighting(const SC4DrawContextHandle handle, const bool enableLighting) {
     auto* drawContext = Validate(handle);
     if (drawContext && thunks_.setLighting) {
-        thunks_.setLighting(drawContext, enableLighting);
+        Capture_(DrawCommandOp::SetLighting, drawContext, DrawCommandPayload::Flag{enableLighting ? 1u : 0u});
+        if (!SkipRedundantState_(drawContext, kSlotLighting, enableLighting ? 1u : 0u)) {
+            thunks_.setLighting(drawContext, enableLighting);
+        }
     }
 }
 
@@ -514,6 +767,7 @@ void DrawService::SetFog(const SC4DrawContextHandle handle, const bool enableFog
                          const float fogStart, const float fogEnd) {
     auto* drawContext = Validate(handle);
     if (drawContext && thunks_.setFog) {
+        Capture_(DrawCommandOp::SetFog, drawContext, MakeFogRecord(enableFog, fogColorRgb, fogStart, fogEnd));
         thunks_.setFog(drawContext, enableFog, fogColorRgb, fogStart, fogEnd);
     }
 }
@@ -521,6 +775,7 @@ void DrawService::SetFog(const SC4DrawContextHandle handle, const bool enableFog
 void DrawService::SetCamera(const SC4DrawContextHandle handle, const int camera) {
     auto* drawContext = Validate(handle);
     if (drawContext && thunks_.setCamera) {
+        Capture_(DrawTraceOp::SetCamera, drawContext, DrawCommandPayload::Value{static_cast<uint32_t>(camera)});
         thunks_.setCamera(drawContext, camera);
     }
 }
@@ -528,14 +783,18 @@ void DrawService::SetCamera(const SC4DrawContextHandle handle, const int camera)
 void DrawService::InitContext(const SC4DrawContextHandle handle) {
     auto* drawContext = Validate(handle);
     if (drawContext && thunks_.initContext) {
+        Capture_(DrawTraceOp::InitContext, drawContext);
         thunks_.initContext(drawContext);
+        InvalidateStateCache_(drawContext);
     }
 }
 
 void DrawService::ShutdownContext(const SC4DrawContextHandle handle) {
     auto* drawContext = Validate(handle);
     if (drawContext && thunks_.shutdownContext) {
+        Capture_(DrawTraceOp::ShutdownContext, drawContext);
         thunks_.shutdownContext(drawContext);
+        InvalidateStateCache_(drawContext);
     }
 }
 
@@ -545,14 +804,18 @@ void DrawService::DrawBoundingBox(const SC4DrawContextHandle handle, float* bbox
     if (!drawContext || !thunks_.drawBoundingBox) {
         return;
     }
+    Capture_(DrawCommandOp::DrawBoundingBox, drawContext, MakeBoundingBoxRecord(bbox6, r, g, b, a));
     const cS3DVector4 color{r, g, b, a};
     thunks_.drawBoundingBox(drawContext, bbox6, &color);
+    InvalidateStateCache_(drawContext);
 }
 
 void DrawService::DrawPrims(const SC4DrawContextHandle handle, const uint32_t primType, const uint32_t startVertex,
                             const uint32_t primitiveCount, const uint32_t flags) {
     auto* drawContext = Validate(handle);
     if (drawContext && thunks_.drawPrims) {
+        Capture_(DrawCommandOp::DrawPrims, drawContext,
+                 DrawCommandPayload::Prims{primType, startVertex, primitiveCount, flags});
         thunks_.drawPrims(drawContext, primType, startVertex, primitiveCount, flags);
     }
 }
@@ -561,6 +824,9 @@ void DrawService::DrawPrimsIndexed(const SC4DrawContextHandle handle, const uint
                                    const long indexStart, const long indexCount) {
     auto* drawContext = Validate(handle);
     if (drawContext && thunks_.drawPrimsIndexed) {
+        Capture_(DrawCommandOp::DrawPrimsIndexed, drawContext,
+                 DrawCommandPayload::PrimsIndexed{primType, static_cast<int32_t>(indexStart),
+                                                  static_cast<int32_t>(indexCount)});
         thunks_.drawPrimsIndexed(drawContext, primType, indexStart, indexCount);
     }
 }
@@ -569,6 +835,8 @@ void DrawService::DrawPrimsIndexedRaw(const SC4DrawContextHandle handle, const u
                                       const uint32_t indexBuffer, const uint32_t indexCount, const uint32_t flags) {
     auto* drawContext = Validate(handle);
     if (drawContext && thunks_.drawPrimsIndexedRaw) {
+        Capture_(DrawTraceOp::DrawPrimsIndexedRaw, drawContext,
+                 DrawTracePayload::PrimsIndexedRaw{primType, indexBuffer, indexCount, flags});
         thunks_.drawPrimsIndexedRaw(drawContext, primType, indexBuffer, indexCount, flags);
     }
 }
@@ -576,10 +844,156 @@ void DrawService::DrawPrimsIndexedRaw(const SC4DrawContextHandle handle, const u
 void DrawService::DrawRect(const SC4DrawContextHandle handle, void* drawTarget, int* rect) {
     auto* drawContext = Validate(handle);
     if (drawContext && thunks_.drawRect) {
+        Capture_(DrawTraceOp::DrawRect, drawContext, MakeRectRecord(drawTarget, rect));
         thunks_.drawRect(drawContext, drawTarget, rect);
+        InvalidateStateCache_(drawContext);
+    }
+}
+
+void DrawService::SetStateFilterEnabled(const bool enabled) {
+    stateFilterEnabled_.store(enabled, std::memory_order_relaxed);
+}
+
+bool DrawService::IsStateFilterEnabled() const {
+    return stateFilterEnabled_.load(std::memory_order_relaxed);
+}
+
+DrawStateFilterStats DrawService::GetStateFilterStats() const {
+    return {lastFrameForwardedCalls_.load(std::memory_order_relaxed),
+            lastFrameElidedCalls_.load(std::memory_order_relaxed)};
+}
+
+bool DrawService::SubmitDrawCommandList(const DrawServicePass pass, const uint32_t listId, const bool replayAtBegin,
+                                        const void* data, const uint32_t sizeBytes) {
+    if (versionTag_ != 641 || !IsValidPass(pass) || (!data && sizeBytes != 0)) {
+        return false;
+    }
+
+    const auto* bytes = static_cast<const uint8_t*>(data);
+    size_t badOffset = 0;
+    if (!ValidateCommandList(bytes, sizeBytes, badOffset)) {
+        LOG_WARN("DrawService: rejected command list {} (malformed command at offset {})", listId, badOffset);
+        return false;
+    }
+
+    // Copy outside the lock; buffers displaced below are released after the lock is dropped.
+    CommandBuffer buffer = std::make_shared<const std::vector<uint8_t>>(bytes, bytes + sizeBytes);
+    CommandBuffer retiredPending;
+    CommandBuffer retiredActive;
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!IsPassInstalledLocked_(pass) && !InstallPassCallSitePatchesLocked_(pass)) {
+        LOG_WARN("DrawService: failed to install hook for draw pass {}", static_cast<int>(pass));
+        return false;
+    }
+
+    auto it = std::find_if(commandLists_.begin(), commandLists_.end(),
+                           [listId](const CommandListSlot& slot) {
+                               return slot.listId == listId;
+                           });
+    if (it == commandLists_.end()) {
+        commandLists_.push_back({listId, pass, replayAtBegin, std::move(buffer), nullptr});
+        return true;
+    }
+
+    const DrawServicePass previousPass = it->pass;
+    retiredPending = std::move(it->pending);
+    it->pending = std::move(buffer);
+    it->replayAtBegin = replayAtBegin;
+    if (previousPass != pass) {
+        retiredActive = std::move(it->active);
+        it->pass = pass;
+        if (!IsPassInUseLocked_(previousPass)) {
+            UninstallPassCallSitePatchesLocked_(previousPass);
+        }
+    }
+    return true;
+}
+
+void DrawService::ClearDrawCommandList(const uint32_t listId) {
+    CommandListSlot retired;
+    std::lock_guard<std::mutex> lock(mutex_);
+    const auto it = std::find_if(commandLists_.begin(), commandLists_.end(),
+                                 [listId](const CommandListSlot& slot) {
+                                     return slot.listId == listId;
+                                 });
+    if (it == commandLists_.end()) {
+        return;
+    }
+
+    retired = std::move(*it);
+    commandLists_.erase(it);
+    if (!IsPassInUseLocked_(retired.pass)) {
+        UninstallPassCallSitePatchesLocked_(retired.pass);
+    }
+}
+
+bool DrawService::StartDrawCapture(const char* path) {
+    if (versionTag_ != 641 || !path || !*path) {
+        return false;
+    }
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (captureRequested_) {
+        return false;
+    }
+    for (const auto pass : kAllPasses) {
+        if (!IsPassInstalledLocked_(pass) && !InstallPassCallSitePatchesLocked_(pass)) {
+            LOG_WARN("DrawService: capture could not hook draw pass {}", static_cast<int>(pass));
+        }
+    }
+    captureRequested_ = true;
+    captureStartPending_ = true;
+    captureStopPending_ = false;
+    pendingCapturePath_ = path;
+    LOG_INFO("DrawService: draw capture requested, starting next frame");
+    return true;
+}
+
+void DrawService::StopDrawCapture() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (captureRequested_) {
+        captureStopPending_ = true;
     }
 }
 
+bool DrawService::IsDrawCaptureActive() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return captureRequested_;
+}
+
+DrawBufferHandle DrawService::CreateDrawBuffer(const DrawBufferDesc& desc) {
+    if (versionTag_ != 641) {
+        return {0};
+    }
+    return bufferPool_.Create(desc);
+}
+
+void DrawService::ReleaseDrawBuffer(const DrawBufferHandle buffer) {
+    bufferPool_.Release(buffer);
+}
+
+bool DrawService::WriteDrawBuffer(const DrawBufferHandle buffer, const void* vertices, const uint32_t vertexCount,
+                                  uint32_t* outStartVertex) {
+    return bufferPool_.Write(buffer, vertices, vertexCount, outStartVertex);
+}
+
+bool DrawService::SetDrawBufferIndices(const DrawBufferHandle buffer, const uint16_t* indices,
+                                       const uint32_t indexCount) {
+    return bufferPool_.SetIndices(buffer, indices, indexCount);
+}
+
+bool DrawService::DrawBufferPrimitives(const DrawBufferHandle buffer, const uint32_t primType,
+                                       const uint32_t startVertex, const uint32_t vertexCount) {
+    return bufferPool_.Draw(buffer, primType, startVertex, vertexCount);
+}
+
+bool DrawService::DrawBufferIndexedPrimitives(const DrawBufferHandle buffer, const uint32_t primType,
+                                              const uint32_t startVertex, const uint32_t vertexCount,
+                                              const uint32_t startIndex, const uint32_t indexCount) {
+    return bufferPool_.DrawIndexed(buffer, primType, startVertex, vertexCount, startIndex, indexCount);
+}
+
 void __fastcall DrawService::HookPreStatic(void* self, void*) {
     if (auto* service = GetActiveInstance()) {
         service->OnPassHook(DrawServicePass::PreStatic, self);
@@ -712,6 +1126,18 @@ void DrawService::UninstallPassCallSitePatchesLocked_(const DrawServicePass pass
     }
 }
 
+bool DrawService::IsPassInUseLocked_(const DrawServicePass pass) const {
+    return captureRequested_ ||
+           std::any_of(passCallbacks_.begin(), passCallbacks_.end(),
+                       [pass](const DrawPassCallbackRegistration& reg) {
+                           return reg.pass == pass;
+                       }) ||
+           std::any_of(commandLists_.begin(), commandLists_.end(),
+                       [pass](const CommandListSlot& slot) {
+                           return slot.pass == pass;
+                       });
+}
+
 bool DrawService::IsPassInstalledLocked_(const DrawServicePass pass) const {
     bool found = false;
     for (const auto& patch : callSitePatches_) {
@@ -746,6 +1172,8 @@ void DrawService::DispatchDrawPassCallbacksLocked_(const DrawServicePass pass, c
 void DrawService::OnPassHook(const DrawServicePass pass, void* self) {
     uintptr_t originalTarget = 0;
     std::vector<DrawPassCallbackRegistration> callbacks;
+    std::vector<CommandBuffer> beginLists;
+    std::vector<CommandBuffer> endLists;
     {
         std::lock_guard<std::mutex> lock(mutex_);
         originalTarget = GetOriginalTargetForPassLocked_(pass);
@@ -755,17 +1183,46 @@ void DrawService::OnPassHook(const DrawServicePass pass, void* self) {
                 callbacks.push_back(reg);
             }
         }
+        for (auto& slot : commandLists_) {
+            if (slot.pass != pass) {
+                continue;
+            }
+            if (slot.pending) {
+                slot.active = std::move(slot.pending);
+            }
+            if (slot.active && !slot.active->empty()) {
+                (slot.replayAtBegin ? beginLists : endLists).push_back(slot.active);
+            }
+        }
     }
+    if (AdvanceStateFilterFrame_(pass)) {
+        ApplyCaptureRequest_();
+    }
+
+    // The game changes state behind our back between callbacks, so every boundary starts with a cold cache.
+    InvalidateAllStateCaches_();
+    CapturePassMarker_(pass, DrawTracePassPhase::Begin);
+    stateFilterScopeActive_ = true;
     for (const auto& reg : callbacks) {
         reg.callback(pass, true, reg.userData);
     }
+    ReplayCommandLists_(beginLists);
+    stateFilterScopeActive_ = false;
+    CapturePassMarker_(pass, DrawTracePassPhase::Game);
     if (originalTarget) {
         const auto fn = reinterpret_cast<void(__thiscall*)(void*)>(originalTarget);
         fn(self);
     }
+    InvalidateAllStateCaches_();
+    CapturePassMarker_(pass, DrawTracePassPhase::End);
+    stateFilterScopeActive_ = true;
+    ReplayCommandLists_(endLists);
     for (const auto& reg : callbacks) {
         reg.callback(pass, false, reg.userData);
     }
+    stateFilterScopeActive_ = false;
+    InvalidateAllStateCaches_();
+    CapturePassMarker_(pass, DrawTracePassPhase::Done);
 }
 
 void DrawService::UninstallAllPassHooksLocked_() {
@@ -774,6 +1231,280 @@ void DrawService::UninstallAllPassHooksLocked_() {
     }
 }
 
+uint32_t DrawService::StageSlot_(const int stage, const StageSlot slot) {
+    if (stage < 0 || static_cast<uint32_t>(stage) >= kStateCacheStageCount) {
+        return kStateSlotCount;
+    }
+    return kSlotStageBase + static_cast<uint32_t>(stage) * kStageSlotCount + slot;
+}
+
+bool DrawService::SkipRedundantState_(void* drawContext, const uint32_t slot, const std::span<const uint32_t> values) {
+    if (!stateFilterEnabled_.load(std::memory_order_relaxed) || !stateFilterScopeActive_ ||
+        slot + values.size() > kStateSlotCount) {
+        frameForwardedCalls_.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+
+    auto it = std::find_if(stateCaches_.begin(), stateCaches_.end(),
+                           [drawContext](const DrawStateCache& cache) {
+                               return cache.drawContext == drawContext;
+                           });
+    if (it == stateCaches_.end()) {
+        it = stateCaches_.insert(stateCaches_.end(), DrawStateCache{drawContext});
+    }
+
+    const uint64_t mask = ((uint64_t{1} << values.size()) - 1) << slot;
+    if ((it->validMask & mask) == mask && std::equal(values.begin(), values.end(), it->values.begin() + slot)) {
+        frameElidedCalls_.fetch_add(1, std::memory_order_relaxed);
+        return true;
+    }
+
+    std::copy(values.begin(), values.end(), it->values.begin() + slot);
+    it->validMask |= mask;
+    frameForwardedCalls_.fetch_add(1, std::memory_order_relaxed);
+    return false;
+}
+
+bool DrawService::SkipRedundantState_(void* drawContext, const uint32_t slot, const uint32_t value) {
+    return SkipRedundantState_(drawContext, slot, std::span<const uint32_t>(&value, 1));
+}
+
+void DrawService::InvalidateStateCache_(void* drawContext) {
+    for (auto& cache : stateCaches_) {
+        if (cache.drawContext == drawContext) {
+            cache.validMask = 0;
+        }
+    }
+}
+
+void DrawService::InvalidateAllStateCaches_() {
+    for (auto& cache : stateCaches_) {
+        cache.validMask = 0;
+    }
+}
+
+bool DrawService::AdvanceStateFilterFrame_(const DrawServicePass pass) {
+    // Passes run in enum order, so a pass that does not come after the previous one starts a new frame.
+    const bool newFrame = static_cast<uint8_t>(pass) <= static_cast<uint8_t>(lastHookedPass_);
+    if (newFrame) {
+        lastFrameForwardedCalls_.store(frameForwardedCalls_.exchange(0, std::memory_order_relaxed),
+                                       std::memory_order_relaxed);
+        lastFrameElidedCalls_.store(frameElidedCalls_.exchange(0, std::memory_order_relaxed),
+                                    std::memory_order_relaxed);
+    }
+    lastHookedPass_ = pass;
+    return newFrame;
+}
+
+void DrawService::ApplyCaptureRequest_() {
+    bool start = false;
+    bool stop = false;
+    std::string path;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        start = std::exchange(captureStartPending_, false);
+        stop = std::exchange(captureStopPending_, false);
+        path = std::move(pendingCapturePath_);
+        pendingCapturePath_.clear();
+    }
+
+    if (start && !stop && trace_.Start(std::filesystem::path(path))) {
+        return;
+    }
+    if (!start && !stop) {
+        return;
+    }
+
+    trace_.Stop();
+    std::lock_guard<std::mutex> lock(mutex_);
+    captureRequested_ = false;
+    for (const auto pass : kAllPasses) {
+        if (!IsPassInUseLocked_(pass)) {
+            UninstallPassCallSitePatchesLocked_(pass);
+        }
+    }
+}
+
+void DrawService::CapturePassMarker_(const DrawServicePass pass, const DrawTracePassPhase phase) {
+    Capture_(DrawTraceOp::PassMarker, nullptr, DrawTracePayload::PassMarker{static_cast<uint32_t>(pass), phase});
+}
+
+void DrawService::ReplayCommandLists_(const std::vector<CommandBuffer>& lists) {
+    if (lists.empty()) {
+        return;
+    }
+
+    const SC4DrawContextHandle handle = WrapRendererDrawContextInternal();
+    if (!handle.ptr) {
+        return;
+    }
+    for (const auto& list : lists) {
+        ReplayCommandList_(handle, *list);
+    }
+}
+
+void DrawService::ReplayCommandList_(const SC4DrawContextHandle handle, const std::vector<uint8_t>& bytes) {
+    using namespace DrawCommandPayload;
+
+    size_t offset = 0;
+    while (offset < bytes.size()) {
+        DrawCommandHeader header{};
+        std::memcpy(&header, bytes.data() + offset, sizeof(header));
+        const uint8_t* payload = bytes.data() + offset + sizeof(header);
+        offset += header.size;
+
+        switch (header.op) {
+        case DrawCommandOp::SetHighlightColor: {
+            const auto p = ReadCommandPayload<HighlightColor>(payload);
+            SetHighlightColor(handle, p.highlightType, p.rgba[0], p.rgba[1], p.rgba[2], p.rgba[3]);
+            break;
+        }
+        case DrawCommandOp::SetRenderStateHighlight:
+            SetRenderStateHighlight(handle, ReadCommandPayload<RenderStateHighlight>(payload).highlightType);
+            break;
+        case DrawCommandOp::SetModelTransform: {
+            auto p = ReadCommandPayload<ModelTransform>(payload);
+            SetModelTransform(handle, p.matrix);
+            break;
+        }
+        case DrawCommandOp::ResetModelViewTransform:
+            ResetModelViewTransform(handle);
+            break;
+        case DrawCommandOp::SetShade:
+            SetShade(handle, ReadCommandPayload<Color>(payload).rgba);
+            break;
+        case DrawCommandOp::ResetShade:
+            ResetShade(handle);
+            break;
+        case DrawCommandOp::SetDefaultRenderState:
+            SetDefaultRenderState(handle);
+            break;
+        case DrawCommandOp::SetDefaultRenderStateUnilaterally:
+            SetDefaultRenderStateUnilaterally(handle);
+            break;
+        case DrawCommandOp::RenderMesh:
+            RenderMesh(handle, ReadCommandPayload<Pointer>(payload).ptr);
+            break;
+        case DrawCommandOp::RenderModelInstance: {
+            const auto p = ReadCommandPayload<ModelInstance>(payload);
+            RenderModelInstance(handle, p.modelCount, p.modelList, p.drawInfo, p.previewOnly != 0);
+            break;
+        }
+        case DrawCommandOp::SetTexWrapModes: {
+            const auto p = ReadCommandPayload<StagePair>(payload);
+            SetTexWrapModes(handle, p.first, p.second, p.stage);
+            break;
+        }
+        case DrawCommandOp::SetTexFiltering: {
+            const auto p = ReadCommandPayload<StagePair>(payload);
+            SetTexFiltering(handle, p.first, p.second, p.stage);
+            break;
+        }
+        case DrawCommandOp::SetTexture: {
+            const auto p = ReadCommandPayload<StageValue>(payload);
+            SetTexture(handle, p.value, p.stage);
+            break;
+        }
+        case DrawCommandOp::EnableTextureStateFlag: {
+            const auto p = ReadCommandPayload<StageValue>(payload);
+            EnableTextureStateFlag(handle, p.value != 0, p.stage);
+            break;
+        }
+        case DrawCommandOp::SetTexColor: {
+            const auto p = ReadCommandPayload<Color>(payload);
+            SetTexColor(handle, p.rgba[0], p.rgba[1], p.rgba[2], p.rgba[3]);
+            break;
+        }
+        case DrawCommandOp::SetTexEnvMode: {
+            const auto p = ReadCommandPayload<StageValue>(payload);
+            SetTexEnvMode(handle, p.value, p.stage);
+            break;
+        }
+        case DrawCommandOp::SetTexCoord: {
+            const auto p = ReadCommandPayload<StageValue>(payload);
+            SetTexCoord(handle, static_cast<int>(p.value), p.stage);
+            break;
+        }
+        case DrawCommandOp::EnableBlendStateFlag:
+            EnableBlendStateFlag(handle, ReadCommandPayload<Flag>(payload).enabled != 0);
+            break;
+        case DrawCommandOp::EnableAlphaTestFlag:
+            EnableAlphaTestFlag(handle, ReadCommandPayload<Flag>(payload).enabled != 0);
+            break;
+        case DrawCommandOp::EnableColorMaskFlag:
+            EnableColorMaskFlag(handle, ReadCommandPayload<Flag>(payload).enabled != 0);
+            break;
+        case DrawCommandOp::EnableCullFaceFlag:
+            EnableCullFaceFlag(handle, ReadCommandPayload<Flag>(payload).enabled != 0);
+            break;
+        case DrawCommandOp::EnableDepthMaskFlag:
+            EnableDepthMaskFlag(handle, ReadCommandPayload<Flag>(payload).enabled != 0);
+            break;
+        case DrawCommandOp::EnableDepthTestFlag:
+            EnableDepthTestFlag(handle, ReadCommandPayload<Flag>(payload).enabled != 0);
+            break;
+        case DrawCommandOp::SetBlendFunc: {
+            const auto p = ReadCommandPayload<BlendFunc>(payload);
+            SetBlendFunc(handle, p.srcFactor, p.dstFactor);
+            break;
+        }
+        case DrawCommandOp::SetAlphaFunc: {
+            const auto p = ReadCommandPayload<AlphaFunc>(payload);
+            SetAlphaFunc(handle, p.alphaFunc, p.alphaRef);
+            break;
+        }
+        case DrawCommandOp::SetDepthFunc:
+            SetDepthFunc(handle, ReadCommandPayload<Value>(payload).value);
+            break;
+        case DrawCommandOp::SetDepthOffset:
+            SetDepthOffset(handle, static_cast<int>(ReadCommandPayload<Value>(payload).value));
+            break;
+        case DrawCommandOp::SetTransparency:
+            SetTransparency(handle);
+            break;
+        case DrawCommandOp::ResetTransparency:
+            ResetTransparency(handle);
+            break;
+        case DrawCommandOp::SetLighting:
+            SetLighting(handle, ReadCommandPayload<Flag>(payload).enabled != 0);
+            break;
+        case DrawCommandOp::SetFog: {
+            auto p = ReadCommandPayload<Fog>(payload);
+            SetFog(handle, p.enabled != 0, p.rgb, p.start, p.end);
+            break;
+        }
+        case DrawCommandOp::DrawBoundingBox: {
+            auto p = ReadCommandPayload<BoundingBox>(payload);
+            DrawBoundingBox(handle, p.bbox, p.rgba[0], p.rgba[1], p.rgba[2], p.rgba[3]);
+            break;
+        }
+        case DrawCommandOp::DrawPrims: {
+            const auto p = ReadCommandPayload<Prims>(payload);
+            DrawPrims(handle, p.primType, p.startVertex, p.primitiveCount, p.flags);
+            break;
+        }
+        case DrawCommandOp::DrawPrimsIndexed: {
+            const auto p = ReadCommandPayload<PrimsIndexed>(payload);
+            DrawPrimsIndexed(handle, static_cast<uint8_t>(p.primType), p.indexStart, p.indexCount);
+            break;
+        }
+        case DrawCommandOp::DrawBufferPrimitives: {
+            const auto p = ReadCommandPayload<BufferPrims>(payload);
+            DrawBufferPrimitives(DrawBufferHandle{p.bufferId}, p.primType, p.startVertex, p.vertexCount);
+            break;
+        }
+        case DrawCommandOp::DrawBufferIndexedPrimitives: {
+            const auto p = ReadCommandPayload<BufferPrimsIndexed>(payload);
+            DrawBufferIndexedPrimitives(DrawBufferHandle{p.bufferId}, p.primType, p.startVertex, p.vertexCount,
+                                        p.startIndex, p.indexCount);
+            break;
+        }
+        default:
+            break;
+        }
+    }
+}
+
 bool DrawService::Init() {
     if (versionTag_ != 641) {
         LOG_WARN("DrawService: not registering, game version {} != 641", versionTag_);
@@ -852,8 +1583,15 @@ bool DrawService::Shutdown() {
     {
         std::lock_guard<std::mutex> lock(mutex_);
         passCallbacks_.clear();
+        commandLists_.clear();
+        captureRequested_ = false;
+        captureStartPending_ = false;
+        captureStopPending_ = false;
         UninstallAllPassHooksLocked_();
     }
+    trace_.Stop();
+    bufferPool_.Clear();
+    stateCaches_.clear();
     if (activeInstance_ == this) {
         activeInstance_ = nullptr;
     }
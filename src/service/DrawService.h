@@ -1,10 +1,17 @@
 #pragma once
 
 #include <array>
+#include <atomic>
 #include <cstdint>
+#include <memory>
 #include <mutex>
+#include <span>
+#include <string>
+#include <type_traits>
 #include <vector>
 
+#include "DrawBufferPool.h"
+#include "DrawTraceWriter.h"
 #include "cRZBaseSystemService.h"
 #include "public/cIGZDrawService.h"
 #include "utils/VersionDetection.h"
@@ -95,6 +102,26 @@ public:
                              uint32_t indexCount, uint32_t flags) override;
     void DrawRect(SC4DrawContextHandle handle, void* drawTarget, int* rect) override;
 
+    void SetStateFilterEnabled(bool enabled) override;
+    [[nodiscard]] bool IsStateFilterEnabled() const override;
+    [[nodiscard]] DrawStateFilterStats GetStateFilterStats() const override;
+
+    bool SubmitDrawCommandList(DrawServicePass pass, uint32_t listId, bool replayAtBegin,
+                               const void* data, uint32_t sizeBytes) override;
+    void ClearDrawCommandList(uint32_t listId) override;
+    bool StartDrawCapture(const char* path) override;
+    void StopDrawCapture() override;
+    [[nodiscard]] bool IsDrawCaptureActive() const override;
+    DrawBufferHandle CreateDrawBuffer(const DrawBufferDesc& desc) override;
+    void ReleaseDrawBuffer(DrawBufferHandle buffer) override;
+    bool WriteDrawBuffer(DrawBufferHandle buffer, const void* vertices, uint32_t vertexCount,
+                         uint32_t* outStartVertex) override;
+    bool SetDrawBufferIndices(DrawBufferHandle buffer, const uint16_t* indices, uint32_t indexCount) override;
+    bool DrawBufferPrimitives(DrawBufferHandle buffer, uint32_t primType, uint32_t startVertex,
+                              uint32_t vertexCount) override;
+    bool DrawBufferIndexedPrimitives(DrawBufferHandle buffer, uint32_t primType, uint32_t startVertex,
+                                     uint32_t vertexCount, uint32_t startIndex, uint32_t indexCount) override;
+
     // Lifecycle
     bool Init();
     bool Shutdown();
@@ -110,6 +137,56 @@ private:
         void* userData = nullptr;
     };
 
+    // Slots of the per-context redundant state cache. Multi-value setters occupy consecutive slots,
+    // texture stage setters are repeated for each of the first kStateCacheStageCount stages.
+    enum StateSlot : uint32_t {
+        kSlotBlendEnable = 0,
+        kSlotAlphaTestEnable,
+        kSlotColorMaskEnable,
+        kSlotCullFaceEnable,
+        kSlotDepthMaskEnable,
+        kSlotDepthTestEnable,
+        kSlotBlendFunc,
+        kSlotAlphaFunc = kSlotBlendFunc + 2,
+        kSlotDepthFunc = kSlotAlphaFunc + 2,
+        kSlotDepthOffset,
+        kSlotLighting,
+        kSlotTexColor,
+        kSlotStageBase = kSlotTexColor + 4,
+    };
+
+    enum StageSlot : uint32_t {
+        kStageSlotTexture = 0,
+        kStageSlotTextureEnable,
+        kStageSlotWrapModes,
+        kStageSlotFiltering = kStageSlotWrapModes + 2,
+        kStageSlotEnvMode = kStageSlotFiltering + 2,
+        kStageSlotTexCoord,
+        kStageSlotCount,
+    };
+
+    static constexpr uint32_t kStateCacheStageCount = 4;
+    static constexpr uint32_t kStateSlotCount = kSlotStageBase + kStateCacheStageCount * kStageSlotCount;
+    static_assert(kStateSlotCount <= 64, "validMask must cover every state slot");
+
+    struct DrawStateCache {
+        void* drawContext = nullptr;
+        uint64_t validMask = 0;
+        std::array<uint32_t, kStateSlotCount> values{};
+    };
+
+    using CommandBuffer = std::shared_ptr<const std::vector<uint8_t>>;
+
+    // Submissions land in `pending` from any thread; the render thread promotes them to `active` at the start of
+    // the pass, so recording frame N+1 never touches the buffer that is replaying frame N.
+    struct CommandListSlot {
+        uint32_t listId = 0;
+        DrawServicePass pass = DrawServicePass::PreStatic;
+        bool replayAtBegin = false;
+        CommandBuffer pending{};
+        CommandBuffer active{};
+    };
+
     struct CallSitePatch {
         const char* name = nullptr;
         DrawServicePass pass = DrawServicePass::PreStatic;
@@ -134,11 +211,40 @@ private:
     bool InstallPassCallSitePatchesLocked_(DrawServicePass pass);
     void UninstallPassCallSitePatchesLocked_(DrawServicePass pass);
     bool IsPassInstalledLocked_(DrawServicePass pass) const;
+    bool IsPassInUseLocked_(DrawServicePass pass) const;
     uintptr_t GetOriginalTargetForPassLocked_(DrawServicePass pass) const;
     void DispatchDrawPassCallbacksLocked_(DrawServicePass pass, bool begin);
     void OnPassHook(DrawServicePass pass, void* self);
     void UninstallAllPassHooksLocked_();
 
+    [[nodiscard]] static uint32_t StageSlot_(int stage, StageSlot slot);
+    bool SkipRedundantState_(void* drawContext, uint32_t slot, std::span<const uint32_t> values);
+    bool SkipRedundantState_(void* drawContext, uint32_t slot, uint32_t value);
+    void InvalidateStateCache_(void* drawContext);
+    void InvalidateAllStateCaches_();
+    bool AdvanceStateFilterFrame_(DrawServicePass pass);
+
+    void ApplyCaptureRequest_();
+    void CapturePassMarker_(DrawServicePass pass, DrawTracePassPhase phase);
+
+    template <typename Op, typename T>
+    void Capture_(const Op op, const void* drawContext, const T& payload) {
+        static_assert(std::is_trivially_copyable_v<T>, "capture payloads must be PODs");
+        if (trace_.IsActive()) {
+            trace_.Append(static_cast<uint16_t>(op), drawContext, &payload, static_cast<uint16_t>(sizeof(T)));
+        }
+    }
+
+    template <typename Op>
+    void Capture_(const Op op, const void* drawContext) {
+        if (trace_.IsActive()) {
+            trace_.Append(static_cast<uint16_t>(op), drawContext, nullptr, 0);
+        }
+    }
+
+    void ReplayCommandLists_(const std::vector<CommandBuffer>& lists);
+    void ReplayCommandList_(SC4DrawContextHandle handle, const std::vector<uint8_t>& bytes);
+
     struct Thunks {
         void* (__thiscall* getDrawContext)(void* renderer);
         uint32_t (__thiscall* rendererDraw)(void* renderer);
@@ -217,4 +323,26 @@ private:
     std::vector<DrawPassCallbackRegistration> passCallbacks_{};
     mutable std::mutex mutex_{};
     uint32_t nextCallbackToken_ = 1;
+    std::vector<CommandListSlot> commandLists_{};
+
+    // Redundant state filter. The cache is only touched on the render thread (pass hooks and setters).
+    std::vector<DrawStateCache> stateCaches_{};
+    std::atomic<bool> stateFilterEnabled_{false};
+    bool stateFilterScopeActive_ = false;
+    DrawServicePass lastHookedPass_ = DrawServicePass::PostDynamic;
+    std::atomic<uint32_t> frameForwardedCalls_{0};
+    std::atomic<uint32_t> frameElidedCalls_{0};
+    std::atomic<uint32_t> lastFrameForwardedCalls_{0};
+    std::atomic<uint32_t> lastFrameElidedCalls_{0};
+
+    // Frame capture. Start/stop requests are queued under mutex_ and applied by the render thread at the next frame
+    // boundary, so the writer is only ever fed from one thread and captures always contain whole frames.
+    DrawTraceWriter trace_{};
+    bool captureRequested_ = false;
+    bool captureStartPending_ = false;
+    bool captureStopPending_ = false;
+    std::string pendingCapturePath_{};
+
+    // Render thread only.
+    DrawBufferPool bufferPool_{};
 };
@@ -0,0 +1,74 @@
+#pragma once
+
+#include <cstdint>
+
+#include "public/DrawCommandFormat.h"
+
+// Binary layout of DrawService frame captures (.dstrace).
+//
+// File = DrawTraceFileHeader followed by records. Each record is a DrawTraceRecordHeader followed by its payload;
+// `size` covers both. Opcodes below 0x100 are DrawCommandOp values and reuse the DrawCommandPayload layouts.
+// Opcodes from 0x100 upwards are capture-only calls and markers described here. Pointers are stored as 32-bit
+// values (the game is a 32-bit process); their pointees are inlined where the size is known.
+
+constexpr uint32_t kDrawTraceMagic = 0x52545344; // "DSTR"
+constexpr uint16_t kDrawTraceVersion = 1;
+
+struct DrawTraceFileHeader {
+    uint32_t magic;
+    uint16_t version;
+    uint16_t pointerSize;
+};
+
+struct DrawTraceRecordHeader {
+    uint16_t op;
+    uint16_t size;
+    uint32_t context;     ///< Draw context pointer, 0 for markers.
+    uint32_t timestampUs; ///< Microseconds since capture start.
+};
+
+enum class DrawTraceOp : uint16_t {
+    PassMarker = 0x100,
+    SetModelTransformRaw,
+    SetModelViewTransformChanged,
+    GetModelViewMatrix,
+    SetModelShade,
+    SetSelfLitShade,
+    SetRenderState,
+    SetRenderStatePacked,
+    SetEmulatedSecondStageRenderState,
+    SetTexCombiner,
+    SetTexTransform4,
+    ClearTexTransform,
+    SetVertexBuffer,
+    SetIndexBuffer,
+    GetLighting,
+    SetCamera,
+    InitContext,
+    ShutdownContext,
+    DrawPrimsIndexedRaw,
+    DrawRect,
+    SetRenderStateHighlightMaterial,
+};
+
+/// Phases reported by DrawTraceOp::PassMarker.
+enum class DrawTracePassPhase : uint32_t {
+    Begin = 0,    ///< Pass hook entered, begin callbacks about to run.
+    Game,         ///< Begin callbacks done, game pass about to run.
+    End,          ///< Game pass done, end callbacks about to run.
+    Done,         ///< End callbacks done.
+};
+
+namespace DrawTracePayload {
+    struct PassMarker { uint32_t pass; DrawTracePassPhase phase; };
+    struct Pointer { uint32_t ptr; };
+    struct ModelShade { uint32_t modelInstance; float rgba[4]; };
+    struct RenderState { uint32_t packedRenderState; uint32_t materialState; };
+    struct HighlightMaterial { uint32_t material; uint32_t highlightDesc; };
+    struct StagePointer { uint32_t ptr; int32_t stage; };
+    struct TexTransform { float matrix[16]; int32_t stage; };
+    struct Stage { int32_t stage; };
+    struct IndexBuffer { uint32_t indexBuffer; uint32_t indexFormat; };
+    struct PrimsIndexedRaw { uint32_t primType; uint32_t indexBuffer; uint32_t indexCount; uint32_t flags; };
+    struct Rect { uint32_t drawTarget; int32_t rect[4]; };
+}
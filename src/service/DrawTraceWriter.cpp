@@ -0,0 +1,133 @@
+#include "DrawTraceWriter.h"
+
+#include "utils/Logger.h"
+
+#include <cstring>
+
+DrawTraceWriter::~DrawTraceWriter() {
+    Stop();
+}
+
+bool DrawTraceWriter::Start(const std::filesystem::path& path) {
+    if (IsActive()) {
+        return false;
+    }
+
+    file_.open(path, std::ios::binary | std::ios::trunc);
+    if (!file_) {
+        LOG_ERROR("DrawTraceWriter: failed to open {}", path.string());
+        return false;
+    }
+
+    const DrawTraceFileHeader header{kDrawTraceMagic, kDrawTraceVersion, static_cast<uint16_t>(sizeof(void*))};
+    file_.write(reinterpret_cast<const char*>(&header), sizeof(header));
+
+    recordCount_.store(0, std::memory_order_relaxed);
+    droppedChunks_.store(0, std::memory_order_relaxed);
+    startTime_ = std::chrono::steady_clock::now();
+    current_.clear();
+    current_.reserve(kChunkBytes);
+    {
+        std::lock_guard<std::mutex> lock(queueMutex_);
+        stopRequested_ = false;
+    }
+    thread_ = std::thread(&DrawTraceWriter::WriterLoop_, this);
+    active_.store(true, std::memory_order_relaxed);
+    LOG_INFO("DrawTraceWriter: capturing to {}", path.string());
+    return true;
+}
+
+void DrawTraceWriter::Stop() {
+    if (!IsActive()) {
+        return;
+    }
+
+    active_.store(false, std::memory_order_relaxed);
+    SubmitCurrentChunk_();
+    {
+        std::lock_guard<std::mutex> lock(queueMutex_);
+        stopRequested_ = true;
+    }
+    queueCv_.notify_one();
+    if (thread_.joinable()) {
+        thread_.join();
+    }
+    file_.close();
+    freeChunks_.clear();
+
+    LOG_INFO("DrawTraceWriter: capture stopped ({} records, {} dropped chunks)",
+             recordCount_.load(std::memory_order_relaxed), droppedChunks_.load(std::memory_order_relaxed));
+}
+
+void DrawTraceWriter::Append(const uint16_t op, const void* context, const void* payload, const uint16_t payloadSize) {
+    if (!IsActive()) {
+        return;
+    }
+
+    const auto elapsed = std::chrono::steady_clock::now() - startTime_;
+    const DrawTraceRecordHeader header{
+        op,
+        static_cast<uint16_t>(sizeof(DrawTraceRecordHeader) + payloadSize),
+        static_cast<uint32_t>(reinterpret_cast<uintptr_t>(context)),
+        static_cast<uint32_t>(std::chrono::duration_cast<std::chrono::microseconds>(elapsed).count()),
+    };
+
+    if (current_.size() + header.size > kChunkBytes) {
+        SubmitCurrentChunk_();
+    }
+
+    const size_t offset = current_.size();
+    current_.resize(offset + header.size);
+    std::memcpy(current_.data() + offset, &header, sizeof(header));
+    if (payloadSize > 0) {
+        std::memcpy(current_.data() + offset + sizeof(header), payload, payloadSize);
+    }
+    recordCount_.fetch_add(1, std::memory_order_relaxed);
+}
+
+void DrawTraceWriter::SubmitCurrentChunk_() {
+    if (current_.empty()) {
+        return;
+    }
+
+    std::vector<uint8_t> next;
+    {
+        std::lock_guard<std::mutex> lock(queueMutex_);
+        if (queue_.size() >= kMaxQueuedChunks) {
+            droppedChunks_.fetch_add(1, std::memory_order_relaxed);
+            current_.clear();
+            return;
+        }
+        queue_.push_back(std::move(current_));
+        if (!freeChunks_.empty()) {
+            next = std::move(freeChunks_.back());
+            freeChunks_.pop_back();
+        }
+    }
+    queueCv_.notify_one();
+
+    next.clear();
+    next.reserve(kChunkBytes);
+    current_ = std::move(next);
+}
+
+void DrawTraceWriter::WriterLoop_() {
+    for (;;) {
+        std::vector<uint8_t> chunk;
+        {
+            std::unique_lock<std::mutex> lock(queueMutex_);
+            queueCv_.wait(lock, [this] { return stopRequested_ || !queue_.empty(); });
+            if (queue_.empty()) {
+                return;
+            }
+            chunk = std::move(queue_.front());
+            queue_.pop_front();
+        }
+
+        file_.write(reinterpret_cast<const char*>(chunk.data()), static_cast<std::streamsize>(chunk.size()));
+
+        chunk.clear();
+        std::lock_guard<std::mutex> lock(queueMutex_);
+        freeChunks_.push_back(std::move(chunk));
+    }
+}
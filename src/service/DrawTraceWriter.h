@@ -0,0 +1,59 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <filesystem>
+#include <fstream>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "DrawTraceFormat.h"
+
+// Streams DrawService capture records to disk. Records are appended into fixed-size chunks on the calling (render)
+// thread; full chunks are handed to a background thread that owns the file, so capture never blocks on I/O.
+// If the writer falls behind by more than kMaxQueuedChunks the newest chunk is dropped and counted instead.
+class DrawTraceWriter {
+public:
+    DrawTraceWriter() = default;
+    ~DrawTraceWriter();
+
+    DrawTraceWriter(const DrawTraceWriter&) = delete;
+    DrawTraceWriter& operator=(const DrawTraceWriter&) = delete;
+
+    bool Start(const std::filesystem::path& path);
+    void Stop();
+
+    [[nodiscard]] bool IsActive() const noexcept { return active_.load(std::memory_order_relaxed); }
+    [[nodiscard]] uint64_t GetRecordCount() const noexcept { return recordCount_.load(std::memory_order_relaxed); }
+    [[nodiscard]] uint32_t GetDroppedChunkCount() const noexcept { return droppedChunks_.load(std::memory_order_relaxed); }
+
+    // Render thread only.
+    void Append(uint16_t op, const void* context, const void* payload, uint16_t payloadSize);
+
+private:
+    static constexpr size_t kChunkBytes = 64 * 1024;
+    static constexpr size_t kMaxQueuedChunks = 256;
+
+    void SubmitCurrentChunk_();
+    void WriterLoop_();
+
+    std::atomic<bool> active_{false};
+    std::atomic<uint64_t> recordCount_{0};
+    std::atomic<uint32_t> droppedChunks_{0};
+    std::chrono::steady_clock::time_point startTime_{};
+
+    std::vector<uint8_t> current_{};
+
+    std::mutex queueMutex_{};
+    std::condition_variable queueCv_{};
+    std::deque<std::vector<uint8_t>> queue_{};
+    std::vector<std::vector<uint8_t>> freeChunks_{};
+    bool stopRequested_ = false;
+
+    std::ofstream file_{};
+    std::thread thread_{};
+};
@@ -0,0 +1,115 @@
+#include "HeightfieldPublisher.h"
+
+#include <new>
+
+namespace {
+    constexpr std::align_val_t kBufferAlignment{64};
+    constexpr int kAcquireAttempts = 8;
+}
+
+void HeightfieldPublisher::AlignedDelete::operator()(float* p) const {
+    ::operator delete[](p, kBufferAlignment);
+}
+
+float* HeightfieldPublisher::BeginPublish(const uint32_t verticesX, const uint32_t verticesZ, const float gridSpacing,
+                                          uint32_t& outRowStride) {
+    const uint32_t rowStride = (verticesX + kRowAlignment - 1) / kRowAlignment * kRowAlignment;
+    const size_t floats = static_cast<size_t>(rowStride) * verticesZ;
+    const uint32_t published = published_.load(std::memory_order_relaxed);
+    writing_ = kNoSlot;
+    for (uint32_t i = 0; i < kSlotCount && writing_ == kNoSlot; ++i) {
+        if (i == published) {
+            continue;
+        }
+        // Retire the slot before checking for readers: a reader that pins it after the check sees version 0 and
+        // backs off. Retiring a slot that is still pinned is harmless, its data stays untouched.
+        Slot& slot = slots_[i];
+        slot.version.store(0);
+        if (slot.readers.load() == 0) {
+            writing_ = i;
+        }
+    }
+    if (writing_ == kNoSlot) {
+        return nullptr;
+    }
+
+    Slot& slot = slots_[writing_];
+    if (slot.capacity < floats) {
+        slot.heights.reset(static_cast<float*>(::operator new[](floats * sizeof(float), kBufferAlignment)));
+        slot.capacity = floats;
+    }
+    slot.verticesX = verticesX;
+    slot.verticesZ = verticesZ;
+    slot.rowStride = rowStride;
+    slot.gridSpacing = gridSpacing;
+    outRowStride = rowStride;
+    return slot.heights.get();
+}
+
+uint32_t HeightfieldPublisher::EndPublish() {
+    if (writing_ == kNoSlot) {
+        return 0;
+    }
+    const uint32_t version = nextVersion_;
+    nextVersion_ = nextVersion_ + 1 != 0 ? nextVersion_ + 1 : 1;
+    slots_[writing_].version.store(version, std::memory_order_release);
+    published_.store(writing_, std::memory_order_release);
+    publishedVersion_.store(version, std::memory_order_release);
+    writing_ = kNoSlot;
+    return version;
+}
+
+void HeightfieldPublisher::Unpublish() {
+    published_.store(kNoSlot, std::memory_order_release);
+    publishedVersion_.store(0, std::memory_order_release);
+}
+
+void HeightfieldPublisher::Reset() {
+    Unpublish();
+    for (Slot& slot : slots_) {
+        slot.version.store(0);
+        slot.heights.reset();
+        slot.capacity = 0;
+    }
+    writing_ = kNoSlot;
+}
+
+bool HeightfieldPublisher::Acquire(TerrainHeightfieldView& outView) {
+    outView = {};
+    for (int attempt = 0; attempt < kAcquireAttempts; ++attempt) {
+        const uint32_t index = published_.load(std::memory_order_acquire);
+        if (index == kNoSlot) {
+            return false;
+        }
+        Slot& slot = slots_[index];
+        const uint32_t version = slot.version.load(std::memory_order_acquire);
+        if (version == 0) {
+            continue;
+        }
+        slot.readers.fetch_add(1);
+        if (slot.version.load() != version) {
+            // Recycled since the index was read; the writer has published a newer slot.
+            slot.readers.fetch_sub(1, std::memory_order_release);
+            continue;
+        }
+        outView.heights = slot.heights.get();
+        outView.verticesX = slot.verticesX;
+        outView.verticesZ = slot.verticesZ;
+        outView.rowStride = slot.rowStride;
+        outView.gridSpacing = slot.gridSpacing;
+        outView.version = version;
+        outView.slot = index;
+        return true;
+    }
+    return false;
+}
+
+void HeightfieldPublisher::Release(const TerrainHeightfieldView& view) {
+    if (view.version != 0 && view.slot < kSlotCount) {
+        slots_[view.slot].readers.fetch_sub(1, std::memory_order_release);
+    }
+}
+
+uint32_t HeightfieldPublisher::Version() const {
+    return publishedVersion_.load(std::memory_order_acquire);
+}
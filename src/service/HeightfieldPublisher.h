@@ -0,0 +1,66 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+#include "public/TerrainHeightfield.h"
+
+// Publishes immutable copies of a heightfield to lock-free readers.
+//
+// One writer fills a spare slot and publishes it as a new version; readers pin the published slot by bumping its
+// reader count and re-checking its version, so the writer never recycles a slot while anyone holds it and readers
+// never see a slot that is being rewritten. With kSlotCount slots the writer always finds a spare one unless readers
+// pin several old versions at once; BeginPublish then fails and the caller tries again next tick.
+class HeightfieldPublisher {
+public:
+    static constexpr uint32_t kSlotCount = 4;
+    static constexpr uint32_t kRowAlignment = 16;    // Floats; one 64-byte cache line.
+
+    HeightfieldPublisher() = default;
+    HeightfieldPublisher(const HeightfieldPublisher&) = delete;
+    HeightfieldPublisher& operator=(const HeightfieldPublisher&) = delete;
+
+    // Writer, one thread at a time.
+
+    /// Returns a buffer for `verticesZ` rows of `verticesX` heights, `outRowStride` floats apart, or nullptr if no
+    /// spare slot is free. The buffer holds stale data; write every row, then call EndPublish.
+    float* BeginPublish(uint32_t verticesX, uint32_t verticesZ, float gridSpacing, uint32_t& outRowStride);
+    /// Publishes the buffer from the last successful BeginPublish and returns its version.
+    uint32_t EndPublish();
+    /// Withdraws the published heightfield. Views already acquired stay valid until released.
+    void Unpublish();
+    /// Frees all buffers. Only call when no reader can still hold a view.
+    void Reset();
+
+    // Readers, any thread.
+
+    bool Acquire(TerrainHeightfieldView& outView);
+    void Release(const TerrainHeightfieldView& view);
+    [[nodiscard]] uint32_t Version() const;
+
+private:
+    struct AlignedDelete {
+        void operator()(float* p) const;
+    };
+
+    struct Slot {
+        std::atomic<uint32_t> readers{0};
+        std::atomic<uint32_t> version{0};    // 0 while free or being written.
+        std::unique_ptr<float[], AlignedDelete> heights{};
+        size_t capacity = 0;
+        uint32_t verticesX = 0;
+        uint32_t verticesZ = 0;
+        uint32_t rowStride = 0;
+        float gridSpacing = 0.0f;
+    };
+
+    static constexpr uint32_t kNoSlot = 0xFFFFFFFFu;
+    std::array<Slot, kSlotCount> slots_{};
+    std::atomic<uint32_t> published_{kNoSlot};
+    std::atomic<uint32_t> publishedVersion_{0};
+    uint32_t nextVersion_ = 1;
+    uint32_t writing_ = kNoSlot;
+};
@@ -1,6 +1,7 @@
 #include "DrawService.h"
 #include "ImGuiService.h"
 #include "S3DCameraService.h"
+#include "TerrainService.h"
 
 #include "cIGZFrameWork.h"
 #include "cRZCOMDllDirector.h"
@@ -136,10 +137,29 @@ public:
             LOG_INFO("RenderServicesDirector: ImGuiService disabled by settings");
         }
 
+        // Register terrain service (641-gated inside Init)
+        bool terrainRegistered = false;
+        if (settings.GetEnableTerrainService()) {
+            if (terrainService_.Init()) {
+                mpFrameWork->AddSystemService(&terrainService_);
+                mpFrameWork->AddToTick(&terrainService_);
+                terrainRegistered = true;
+                LOG_INFO("RenderServicesDirector: TerrainService registered");
+            } else {
+                LOG_WARN("RenderServicesDirector: TerrainService not registered (version check failed)");
+            }
+        } else {
+            LOG_INFO("RenderServicesDirector: TerrainService disabled by settings");
+        }
+
         // Register camera service (641-gated inside Init)
         if (settings.GetEnableS3DCameraService()) {
             if (cameraService_.Init()) {
+                if (terrainRegistered) {
+                    cameraService_.SetTerrainService(&terrainService_);
+                }
                 mpFrameWork->AddSystemService(&cameraService_);
+                mpFrameWork->AddToTick(&cameraService_);
                 LOG_INFO("RenderServicesDirector: S3DCameraService registered");
             } else {
                 LOG_WARN("RenderServicesDirector: S3DCameraService not registered (version check failed)");
@@ -151,6 +171,7 @@ public:
         // Register draw service (641-gated inside Init)
         if (settings.GetEnableDrawService()) {
             if (drawService_.Init()) {
+                drawService_.SetStateFilterEnabled(settings.GetDrawStateFilter());
                 mpFrameWork->AddSystemService(&drawService_);
                 LOG_INFO("RenderServicesDirector: DrawService registered");
             } else {
@@ -169,13 +190,17 @@ public:
         if (mpFrameWork) {
             mpFrameWork->RemoveFromTick(&imguiService_);
             mpFrameWork->RemoveSystemService(&imguiService_);
+            mpFrameWork->RemoveFromTick(&cameraService_);
             mpFrameWork->RemoveSystemService(&cameraService_);
+            mpFrameWork->RemoveFromTick(&terrainService_);
+            mpFrameWork->RemoveSystemService(&terrainService_);
             mpFrameWork->RemoveSystemService(&drawService_);
             mpFrameWork->RemoveHook(this);
         }
 
         imguiService_.Shutdown();
         cameraService_.Shutdown();
+        terrainService_.Shutdown();
         drawService_.Shutdown();
         return true;
     }
@@ -230,6 +255,7 @@ private:
 
     ImGuiService imguiService_;
     S3DCameraService cameraService_;
+    TerrainService terrainService_;
     DrawService drawService_;
     DemoPanelState demoPanelState_{true};
 };
@@ -2,13 +2,81 @@
 
 #include <Windows.h>
 
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+#include <d3d.h>
+
+#include "DX7InterfaceHook.h"
+#include "cISC4App.h"
+#include "cISC4City.h"
+#include "cISTETerrain.h"
 #include "cISC43DRender.h"
 #include "cISC4View3DWin.h"
 #include "SC4UI.h"
 #include "public/S3DCameraServiceIds.h"
+#include "public/cIGZTerrainService.h"
 #include "utils/Logger.h"
 #include "utils/VersionDetection.h"
 
+namespace {
+    // Half-size of the box of points pushed through the game's Project when fitting the batch transform. Small enough
+    // to stay on screen around a visible point, large enough to keep the solve well conditioned.
+    constexpr float kProjectionFitHalfExtent = 32.0f;
+
+    cS3DVector3 ToVector(const float* xyz) {
+        return {xyz[0], xyz[1], xyz[2]};
+    }
+
+    constexpr uint32_t kTerrainRowsPerTick = 8;
+    constexpr float kMaxPickDistance = 100000.0f;
+    constexpr float kTerrainHeightTolerance = 0.01f;
+
+    cISTETerrain* GetActiveTerrain(uint32_t& cellsX, uint32_t& cellsZ) {
+        cISC4AppPtr app;
+        cISC4City* city = app ? app->GetCity() : nullptr;
+        cISTETerrain* terrain = city ? city->GetTerrain() : nullptr;
+        if (!terrain) {
+            return nullptr;
+        }
+        cellsX = static_cast<uint32_t>(city->SizeX() / TerrainHeightGrid::kGridSpacing);
+        cellsZ = static_cast<uint32_t>(city->SizeZ() / TerrainHeightGrid::kGridSpacing);
+        return cellsX && cellsZ ? terrain : nullptr;
+    }
+
+    bool SameVector(const cS3DVector3& a, const cS3DVector3& b) {
+        return a.fX == b.fX && a.fY == b.fY && a.fZ == b.fZ;
+    }
+
+    size_t PickMemoSlot(const int32_t screenX, const int32_t screenY, const size_t slots) {
+        return ((static_cast<uint32_t>(screenX) * 73856093u) ^ (static_cast<uint32_t>(screenY) * 19349663u)) % slots;
+    }
+
+    // FNV-1a; only used to tell whether the camera state changed between ticks.
+    uint64_t HashBytes(const void* data, const size_t size) {
+        const auto* bytes = static_cast<const uint8_t*>(data);
+        uint64_t hash = 0xCBF29CE484222325ull;
+        for (size_t i = 0; i < size; ++i) {
+            hash = (hash ^ bytes[i]) * 0x100000001B3ull;
+        }
+        return hash;
+    }
+
+    // Screen space of the game's 3D view, used for the per-tick snapshot.
+    bool GetRenderViewportSize(float& width, float& height) {
+        auto* d3dx = DX7InterfaceHook::GetD3DXInterface();
+        IDirect3DDevice7* device = d3dx ? d3dx->GetD3DDevice() : nullptr;
+        D3DVIEWPORT7 viewport{};
+        if (!device || FAILED(device->GetViewport(&viewport)) || viewport.dwWidth == 0 || viewport.dwHeight == 0) {
+            return false;
+        }
+        width = static_cast<float>(viewport.dwWidth);
+        height = static_cast<float>(viewport.dwHeight);
+        return true;
+    }
+}
+
 S3DCameraService::S3DCameraService()
     : cRZBaseSystemService(kS3DCameraServiceID, 0)
       , versionTag_(VersionDetection::GetInstance().GetGameVersion()) {}
@@ -34,6 +102,54 @@ bool S3DCameraService::QueryInterface(const uint32_t riid, void** ppvObj) {
     return cRZBaseSystemService::QueryInterface(riid, ppvObj);
 }
 
+bool S3DCameraService::OnTick(uint32_t) {
+    if (!thunks_.project) {
+        return true;
+    }
+
+    ++pickEpoch_;
+    if (!terrainGrid_.Empty() && SyncTerrainGrid() && !terrainService_) {
+        const uint32_t rows = terrainGrid_.VerticesZ();
+        const uint32_t first = gridRefreshRow_ % rows;
+        const uint32_t last = (std::min)(first + kTerrainRowsPerTick, rows) - 1;
+        CopyTerrainRows(first, last);
+        gridRefreshRow_ = last + 1;
+    }
+
+    const S3DCameraHandle handle = WrapRendererCameraInternal(false);
+    float width = 0.0f;
+    float height = 0.0f;
+    if (!handle.ptr || !GetRenderViewportSize(width, height)) {
+        return true;
+    }
+
+    // A static camera keeps the published snapshot unless CaptureSnapshot replaced it with another camera since.
+    auto* cam = static_cast<cS3DCamera*>(handle.ptr);
+    const bool changed = UpdateCameraGeneration(cam, width, height);
+    if (changed || tickSnapshotSequence_ == 0 || tickSnapshotSequence_ != snapshotSequence_) {
+        if (CaptureSnapshot(handle, width, height)) {
+            tickSnapshotSequence_ = snapshotSequence_;
+        }
+    }
+
+    if (changed) {
+        std::vector<ChangedCallbackRegistration> callbacks;
+        {
+            std::lock_guard<std::mutex> lock(changedCallbacksMutex_);
+            callbacks = changedCallbacks_;
+        }
+        const uint32_t generation = cameraGeneration_.load(std::memory_order_relaxed);
+        for (const auto& reg : callbacks) {
+            reg.callback(generation, reg.userData);
+        }
+    }
+    return true;
+}
+
+bool S3DCameraService::OnIdle(uint32_t) {
+    return OnTick(0);
+}
+
 uint32_t S3DCameraService::GetServiceID() const {
     return kS3DCameraServiceID;
 }
@@ -190,6 +306,241 @@ int S3DCameraService::GetViewState(const S3DCameraHandle handle) {
     return cam ? thunks_.getViewState(cam) : -1;
 }
 
+bool S3DCameraService::GetViewFrustum(const S3DCameraHandle handle, const float viewportWidth,
+                                      const float viewportHeight, ViewFrustum& outFrustum) {
+    auto* cam = Validate(handle);
+    if (!cam || !(viewportWidth > 0.0f) || !(viewportHeight > 0.0f)) {
+        return false;
+    }
+
+    // The camera's matrices are not exposed in a known layout, so derive the planes from the game's own eye rays.
+    const cS3DVector2 corners[4] = {
+        {0.0f, 0.0f}, {viewportWidth, 0.0f}, {viewportWidth, viewportHeight}, {0.0f, viewportHeight}
+    };
+    float origins[4][3];
+    float directions[4][3];
+    for (int i = 0; i < 4; ++i) {
+        cS3DVector3 origin{};
+        cS3DVector3 direction{};
+        thunks_.getEyeRay(cam, corners[i], origin, direction);
+        origins[i][0] = origin.fX;
+        origins[i][1] = origin.fY;
+        origins[i][2] = origin.fZ;
+        directions[i][0] = direction.fX;
+        directions[i][1] = direction.fY;
+        directions[i][2] = direction.fZ;
+    }
+
+    cS3DVector3 centerOrigin{};
+    cS3DVector3 centerDirection{};
+    thunks_.getEyeRay(cam, cS3DVector2{viewportWidth * 0.5f, viewportHeight * 0.5f}, centerOrigin, centerDirection);
+    const float centerO[3] = {centerOrigin.fX, centerOrigin.fY, centerOrigin.fZ};
+    const float centerD[3] = {centerDirection.fX, centerDirection.fY, centerDirection.fZ};
+    return BuildViewFrustumFromRays(origins, directions, centerO, centerD, outFrustum);
+}
+
+bool S3DCameraService::ProjectBatch(const S3DCameraHandle handle, const float* xyz, const size_t count, float* outXYZ,
+                                    uint8_t* outVisible) {
+    auto* cam = Validate(handle);
+    if (!cam || (count > 0 && (!xyz || !outXYZ))) {
+        return false;
+    }
+    if (count == 0) {
+        return true;
+    }
+
+    if (!ProbeProjectionCache(cam, xyz, count) &&
+        !FitProjectionCache(cam, xyz) &&
+        !FitProjectionCache(cam, xyz + (count / 2) * 3)) {
+        for (size_t i = 0; i < count; ++i) {
+            cS3DVector3 screen{};
+            const bool visible = thunks_.project(cam, ToVector(xyz + i * 3), screen);
+            outXYZ[i * 3 + 0] = screen.fX;
+            outXYZ[i * 3 + 1] = screen.fY;
+            outXYZ[i * 3 + 2] = screen.fZ;
+            if (outVisible) {
+                outVisible[i] = visible ? 1 : 0;
+            }
+        }
+        return true;
+    }
+
+    ProjectPoints(projection_, xyz, count, outXYZ, outVisible);
+    return true;
+}
+
+bool S3DCameraService::UnProjectBatch(const S3DCameraHandle handle, const float* xyz, const size_t count,
+                                      float* outXYZ, uint8_t* outValid) {
+    auto* cam = Validate(handle);
+    if (!cam || (count > 0 && (!xyz || !outXYZ))) {
+        return false;
+    }
+    if (count == 0) {
+        return true;
+    }
+
+    if (!ProbeProjectionCache(cam, nullptr, 0)) {
+        // Fit around the world position of the first screen point.
+        cS3DVector3 world{};
+        const bool fitted = thunks_.unProject(cam, ToVector(xyz), world) &&
+            FitProjectionCache(cam, &world.fX);
+        if (!fitted) {
+            for (size_t i = 0; i < count; ++i) {
+                cS3DVector3 result{};
+                const bool valid = thunks_.unProject(cam, ToVector(xyz + i * 3), result);
+                outXYZ[i * 3 + 0] = result.fX;
+                outXYZ[i * 3 + 1] = result.fY;
+                outXYZ[i * 3 + 2] = result.fZ;
+                if (outValid) {
+                    outValid[i] = valid ? 1 : 0;
+                }
+            }
+            return true;
+        }
+    }
+
+    UnProjectPoints(projection_, xyz, count, outXYZ, outValid);
+    return true;
+}
+
+bool S3DCameraService::CaptureSnapshot(const S3DCameraHandle handle, const float viewportWidth,
+                                       const float viewportHeight) {
+    auto* cam = Validate(handle);
+    if (!cam || !(viewportWidth > 0.0f) || !(viewportHeight > 0.0f)) {
+        return false;
+    }
+
+    if (!ProbeProjectionCache(cam, nullptr, 0)) {
+        // Fit around a world point under the middle of the screen: mid-depth first, then along the center eye ray.
+        const cS3DVector3 screenCenter{viewportWidth * 0.5f, viewportHeight * 0.5f, 0.5f};
+        cS3DVector3 world{};
+        bool fitted = thunks_.unProject(cam, screenCenter, world) && FitProjectionCache(cam, &world.fX);
+        if (!fitted) {
+            cS3DVector3 rayOrigin{};
+            cS3DVector3 rayDirection{};
+            thunks_.getEyeRay(cam, cS3DVector2{screenCenter.fX, screenCenter.fY}, rayOrigin, rayDirection);
+            for (const float distance : {500.0f, 2000.0f}) {
+                const float point[3] = {
+                    rayOrigin.fX + rayDirection.fX * distance,
+                    rayOrigin.fY + rayDirection.fY * distance,
+                    rayOrigin.fZ + rayDirection.fZ * distance
+                };
+                if (FitProjectionCache(cam, point)) {
+                    fitted = true;
+                    break;
+                }
+            }
+        }
+        if (!fitted) {
+            return false;
+        }
+    }
+
+    S3DCameraSnapshot snapshot{};
+    if (!GetViewFrustum(handle, viewportWidth, viewportHeight, snapshot.frustum)) {
+        return false;
+    }
+    cS3DVector3 position{};
+    cS3DVector3 lookAt{};
+    thunks_.getPosition(cam, position);
+    thunks_.getLookAt(cam, lookAt);
+    std::memcpy(snapshot.position, &position.fX, sizeof(snapshot.position));
+    std::memcpy(snapshot.lookAt, &lookAt.fX, sizeof(snapshot.lookAt));
+    snapshot.viewportWidth = viewportWidth;
+    snapshot.viewportHeight = viewportHeight;
+    std::memcpy(snapshot.worldToScreen, projection_.columns, sizeof(snapshot.worldToScreen));
+    std::memcpy(snapshot.screenToWorld, projection_.inverse, sizeof(snapshot.screenToWorld));
+    std::memcpy(snapshot.origin, projection_.origin, sizeof(snapshot.origin));
+    snapshot.invScale = projection_.invScale;
+    PublishSnapshot(snapshot);
+    return true;
+}
+
+bool S3DCameraService::GetLatestSnapshot(S3DCameraSnapshot& outSnapshot) {
+    for (int attempt = 0; attempt < 4; ++attempt) {
+        const uint32_t index = publishedSnapshot_.load(std::memory_order_acquire);
+        if (index == kNoSnapshot) {
+            return false;
+        }
+        const SnapshotSlot& slot = snapshotSlots_[index];
+        const uint32_t version = slot.version.load(std::memory_order_acquire);
+        if (version & 1u) {
+            continue;
+        }
+        std::memcpy(&outSnapshot, &slot.snapshot, sizeof(outSnapshot));
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (slot.version.load(std::memory_order_relaxed) == version) {
+            return true;
+        }
+    }
+    return false;
+}
+
+uint32_t S3DCameraService::GetCameraGeneration() const {
+    return cameraGeneration_.load(std::memory_order_acquire);
+}
+
+bool S3DCameraService::RegisterCameraChangedCallback(S3DCameraChangedCallback callback, void* userData,
+                                                     uint32_t* outToken) {
+    if (!callback || !outToken || versionTag_ != 641) {
+        return false;
+    }
+
+    std::lock_guard<std::mutex> lock(changedCallbacksMutex_);
+    const uint32_t token = nextCallbackToken_++;
+    if (token == 0) {
+        LOG_ERROR("S3DCameraService: callback token space exhausted");
+        return false;
+    }
+    changedCallbacks_.push_back({token, callback, userData});
+    *outToken = token;
+    return true;
+}
+
+void S3DCameraService::UnregisterCameraChangedCallback(const uint32_t token) {
+    if (!token) {
+        return;
+    }
+
+    std::lock_guard<std::mutex> lock(changedCallbacksMutex_);
+    std::erase_if(changedCallbacks_, [token](const ChangedCallbackRegistration& reg) {
+        return reg.token == token;
+    });
+}
+
+bool S3DCameraService::PickTerrain(const S3DCameraHandle handle, const int32_t screenX, const int32_t screenY,
+                                   S3DTerrainPick& outPick) {
+    auto* cam = Validate(handle);
+    if (!cam || !SyncTerrainGrid()) {
+        return false;
+    }
+
+    // The eye ray is cheap and identifies the camera state, so the memo stays correct if the camera moves mid-tick.
+    cS3DVector3 origin{};
+    cS3DVector3 direction{};
+    thunks_.getEyeRay(cam, cS3DVector2{static_cast<float>(screenX), static_cast<float>(screenY)}, origin, direction);
+    PickMemoEntry& entry = pickMemo_[PickMemoSlot(screenX, screenY, pickMemo_.size())];
+    if (entry.epoch == pickEpoch_ && entry.screenX == screenX && entry.screenY == screenY &&
+        SameVector(entry.rayOrigin, origin) && SameVector(entry.rayDirection, direction)) {
+        if (entry.hit) {
+            outPick = entry.pick;
+        }
+        return entry.hit;
+    }
+
+    TerrainRayHit hit{};
+    const bool found = RaycastTerrainGrid(origin, direction, hit);
+    // Raycasting may have refreshed rows and bumped the epoch; the entry is stamped with the current one.
+    entry = {pickEpoch_, screenX, screenY, origin, direction, found, {}};
+    if (found) {
+        std::memcpy(entry.pick.position, hit.position, sizeof(entry.pick.position));
+        std::memcpy(entry.pick.normal, hit.normal, sizeof(entry.pick.normal));
+        entry.pick.distance = hit.distance;
+        outPick = entry.pick;
+    }
+    return found;
+}
+
 bool S3DCameraService::Init() {
     if (versionTag_ != 641) {
         LOG_WARN("S3DCameraService: not registering, game version {} != 641", versionTag_);
@@ -231,9 +582,19 @@ bool S3DCameraService::Init() {
 }
 
 bool S3DCameraService::Shutdown() {
+    std::lock_guard<std::mutex> lock(changedCallbacksMutex_);
+    changedCallbacks_.clear();
+    terrainGrid_.Clear();
+    gridTerrain_ = nullptr;
+    terrainService_ = nullptr;
     return true;
 }
 
+void S3DCameraService::SetTerrainService(cIGZTerrainService* terrainService) {
+    terrainService_ = terrainService;
+    gridHeightfieldVersion_ = 0;
+}
+
 cS3DCamera* S3DCameraService::Validate(const S3DCameraHandle handle) const {
     if (!handle.ptr || handle.version != versionTag_) {
         return nullptr;
@@ -241,20 +602,256 @@ cS3DCamera* S3DCameraService::Validate(const S3DCameraHandle handle) const {
     return static_cast<cS3DCamera*>(handle.ptr);
 }
 
-S3DCameraHandle S3DCameraService::WrapRendererCameraInternal() {
+bool S3DCameraService::ProbeProjectionCache(cS3DCamera* cam, const float* xyz, const size_t count) {
+    if (!projection_.valid || projectionCamera_ != cam) {
+        return false;
+    }
+
+    // Two thunk calls per batch instead of one per point. The fit center must still match; the first batch point is
+    // checked too when the game accepts it, which catches camera changes far from the fit region.
+    const auto matches = [&](const float* world, const bool required) {
+        cS3DVector3 expected{};
+        if (!thunks_.project(cam, ToVector(world), expected)) {
+            return !required;
+        }
+        float actual[3];
+        return ProjectPoint(projection_, world, actual) && CameraProjectionMatches(&expected.fX, actual);
+    };
+    if (!matches(projectionProbe_, true) || (count > 0 && !matches(xyz, false))) {
+        projection_.valid = false;
+        return false;
+    }
+    return true;
+}
+
+bool S3DCameraService::FitProjectionCache(cS3DCamera* cam, const float* center) {
+    projection_.valid = false;
+    projectionCamera_ = nullptr;
+
+    float world[kCameraProjectionFitPoints][3];
+    float screen[kCameraProjectionFitPoints][3];
+    GetCameraProjectionFitPoints(center, kProjectionFitHalfExtent, world);
+    for (size_t i = 0; i < kCameraProjectionFitPoints; ++i) {
+        cS3DVector3 result{};
+        if (!thunks_.project(cam, ToVector(world[i]), result)) {
+            return false;
+        }
+        screen[i][0] = result.fX;
+        screen[i][1] = result.fY;
+        screen[i][2] = result.fZ;
+    }
+    if (!FitCameraProjection(world, screen, kCameraProjectionFitPoints, center, kProjectionFitHalfExtent,
+                             projection_)) {
+        return false;
+    }
+
+    // Check a point that was not part of the fit before trusting it.
+    const float check[3] = {
+        center[0] + kProjectionFitHalfExtent * 0.5f,
+        center[1] - kProjectionFitHalfExtent * 0.25f,
+        center[2] + kProjectionFitHalfExtent * 0.75f
+    };
+    cS3DVector3 expected{};
+    float actual[3];
+    if (!thunks_.project(cam, ToVector(check), expected) || !ProjectPoint(projection_, check, actual) ||
+        !CameraProjectionMatches(&expected.fX, actual)) {
+        projection_.valid = false;
+        return false;
+    }
+
+    projectionCamera_ = cam;
+    projectionProbe_[0] = center[0];
+    projectionProbe_[1] = center[1];
+    projectionProbe_[2] = center[2];
+    return true;
+}
+
+void S3DCameraService::PublishSnapshot(const S3DCameraSnapshot& snapshot) {
+    const uint32_t published = publishedSnapshot_.load(std::memory_order_relaxed);
+    const uint32_t target = published == kNoSnapshot ? 0 : (published + 1) % snapshotSlots_.size();
+    SnapshotSlot& slot = snapshotSlots_[target];
+
+    const uint32_t version = slot.version.load(std::memory_order_relaxed);
+    slot.version.store(version + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    std::memcpy(&slot.snapshot, &snapshot, sizeof(snapshot));
+    slot.snapshot.sequence = ++snapshotSequence_;
+    slot.version.store(version + 2, std::memory_order_release);
+    publishedSnapshot_.store(target, std::memory_order_release);
+}
+
+uint64_t S3DCameraService::HashCameraState(cS3DCamera* cam, const float viewportWidth,
+                                           const float viewportHeight) const {
+    // Everything the game folds into Project, read through the getters: the view transform follows position and
+    // look-at, the projection follows its type, state and view volume. All fields are 4 bytes, so no padding.
+    struct CameraState {
+        cS3DVector3 position;
+        cS3DVector3 lookAt;
+        float volume[4];
+        int volumeNear;
+        int volumeFar;
+        int projectionType;
+        int projectionState;
+        int viewState;
+        float viewport[2];
+    } state{};
+    thunks_.getPosition(cam, state.position);
+    thunks_.getLookAt(cam, state.lookAt);
+    thunks_.getViewVolume(cam, &state.volume[0], &state.volume[1], &state.volume[2], &state.volume[3],
+                          &state.volumeNear, &state.volumeFar);
+    state.projectionType = thunks_.getProjectionType(cam);
+    state.projectionState = thunks_.getProjectionState(cam);
+    state.viewState = thunks_.getViewState(cam);
+    state.viewport[0] = viewportWidth;
+    state.viewport[1] = viewportHeight;
+    return HashBytes(&state, sizeof(state));
+}
+
+bool S3DCameraService::UpdateCameraGeneration(cS3DCamera* cam, const float viewportWidth,
+                                              const float viewportHeight) {
+    const uint64_t hash = HashCameraState(cam, viewportWidth, viewportHeight);
+    if (cam == hashedCamera_ && hash == cameraStateHash_ && cameraGeneration_.load(std::memory_order_relaxed) != 0) {
+        return false;
+    }
+    hashedCamera_ = cam;
+    cameraStateHash_ = hash;
+    uint32_t generation = cameraGeneration_.load(std::memory_order_relaxed) + 1;
+    if (generation == 0) {
+        generation = 1;
+    }
+    cameraGeneration_.store(generation, std::memory_order_release);
+    return true;
+}
+
+bool S3DCameraService::SyncTerrainGrid() {
+    uint32_t cellsX = 0;
+    uint32_t cellsZ = 0;
+    cISTETerrain* terrain = GetActiveTerrain(cellsX, cellsZ);
+    if (!terrain) {
+        if (!terrainGrid_.Empty()) {
+            terrainGrid_.Clear();
+            gridTerrain_ = nullptr;
+            ++pickEpoch_;
+        }
+        return false;
+    }
+    if (terrain != gridTerrain_ || terrainGrid_.CellsX() != cellsX || terrainGrid_.CellsZ() != cellsZ) {
+        terrainGrid_.Reset(cellsX, cellsZ);
+        gridTerrain_ = terrain;
+        gridRefreshRow_ = 0;
+        gridHeightfieldVersion_ = 0;
+        CopyTerrainRows(0, terrainGrid_.VerticesZ() - 1);
+    }
+    if (terrainService_) {
+        CopyHeightfield();
+    }
+    return true;
+}
+
+void S3DCameraService::CopyTerrainRows(const uint32_t firstRow, const uint32_t lastRow) {
+    bool changed = false;
+    for (uint32_t z = firstRow; z <= lastRow; ++z) {
+        float* row = terrainGrid_.Row(z);
+        const float worldZ = static_cast<float>(z) * TerrainHeightGrid::kGridSpacing;
+        for (uint32_t x = 0; x < terrainGrid_.VerticesX(); ++x) {
+            const float height = gridTerrain_->GetAltitudeAtNearestGrid(
+                static_cast<float>(x) * TerrainHeightGrid::kGridSpacing, worldZ);
+            changed |= row[x] != height;
+            row[x] = height;
+        }
+    }
+    if (changed) {
+        terrainGrid_.UpdateBounds(firstRow, lastRow);
+        ++pickEpoch_;
+    }
+}
+
+void S3DCameraService::CopyHeightfield() {
+    if (terrainService_->GetHeightfieldVersion() == gridHeightfieldVersion_) {
+        return;
+    }
+    TerrainHeightfieldView view{};
+    if (!terrainService_->AcquireHeightfield(view)) {
+        return;
+    }
+    // A heightfield of another size belongs to a city that is loading or closing; keep the grid until they agree.
+    if (view.verticesX == terrainGrid_.VerticesX() && view.verticesZ == terrainGrid_.VerticesZ()) {
+        for (uint32_t z = 0; z < view.verticesZ; ++z) {
+            std::memcpy(terrainGrid_.Row(z), view.heights + static_cast<size_t>(z) * view.rowStride,
+                        view.verticesX * sizeof(float));
+        }
+        terrainGrid_.UpdateBounds(0, terrainGrid_.VerticesZ() - 1);
+        gridHeightfieldVersion_ = view.version;
+        ++pickEpoch_;
+    }
+    terrainService_->ReleaseHeightfield(view);
+}
+
+bool S3DCameraService::RaycastTerrainGrid(const cS3DVector3& origin, const cS3DVector3& direction,
+                                          TerrainRayHit& outHit) {
+    const float length = std::sqrt(direction.fX * direction.fX + direction.fY * direction.fY +
+                                   direction.fZ * direction.fZ);
+    if (!(length > 0.0f)) {
+        return false;
+    }
+    const float unit[3] = {direction.fX / length, direction.fY / length, direction.fZ / length};
+
+    // The rolling refresh can lag behind terraforming. Check the hit cell against the live terrain and, if it moved,
+    // recopy the rows around it and cast again.
+    for (int attempt = 0; attempt < 2; ++attempt) {
+        if (!terrainGrid_.Raycast(&origin.fX, unit, kMaxPickDistance, outHit)) {
+            return false;
+        }
+        bool current = true;
+        for (uint32_t dz = 0; dz <= 1 && current; ++dz) {
+            for (uint32_t dx = 0; dx <= 1 && current; ++dx) {
+                const uint32_t x = outHit.cellX + dx;
+                const uint32_t z = outHit.cellZ + dz;
+                const float live = gridTerrain_->GetAltitudeAtNearestGrid(
+                    static_cast<float>(x) * TerrainHeightGrid::kGridSpacing,
+                    static_cast<float>(z) * TerrainHeightGrid::kGridSpacing);
+                current = std::fabs(live - terrainGrid_.GetHeight(x, z)) <= kTerrainHeightTolerance;
+            }
+        }
+        if (current) {
+            return true;
+        }
+        const uint32_t first = outHit.cellZ > TerrainHeightGrid::kBlockCells
+                                   ? outHit.cellZ - TerrainHeightGrid::kBlockCells
+                                   : 0;
+        const uint32_t last = (std::min)(outHit.cellZ + 1 + TerrainHeightGrid::kBlockCells,
+                                         terrainGrid_.VerticesZ() - 1);
+        CopyTerrainRows(first, last);
+        if (terrainService_) {
+            // Let the shared copy catch up too; until it publishes, the grid keeps the rows read here.
+            constexpr float kMargin = TerrainHeightGrid::kGridSpacing * TerrainHeightGrid::kBlockCells;
+            terrainService_->MarkTerrainDirty(outHit.position[0] - kMargin, outHit.position[2] - kMargin,
+                                              outHit.position[0] + kMargin, outHit.position[2] + kMargin);
+        }
+    }
+    return terrainGrid_.Raycast(&origin.fX, unit, kMaxPickDistance, outHit);
+}
+
+S3DCameraHandle S3DCameraService::WrapRendererCameraInternal(const bool logFailures) {
     const auto view3DWin = SC4UI::GetView3DWin();
     if (!view3DWin) {
-        LOG_WARN("S3DCameraService: WrapActiveRendererCamera failed, View3DWin missing");
+        if (logFailures) {
+            LOG_WARN("S3DCameraService: WrapActiveRendererCamera failed, View3DWin missing");
+        }
         return {nullptr, 0, false};
     }
     cISC43DRender* renderer = view3DWin->GetRenderer();
     if (!renderer) {
-        LOG_WARN("S3DCameraService: WrapActiveRendererCamera failed, renderer missing");
+        if (logFailures) {
+            LOG_WARN("S3DCameraService: WrapActiveRendererCamera failed, renderer missing");
+        }
         return {nullptr, 0, false};
     }
     cS3DCamera* camera = renderer->GetCamera();
     if (!camera) {
-        LOG_WARN("S3DCameraService: WrapActiveRendererCamera failed, camera missing");
+        if (logFailures) {
+            LOG_WARN("S3DCameraService: WrapActiveRendererCamera failed, camera missing");
+        }
         return {nullptr, 0, false};
     }
     return WrapCamera(camera);
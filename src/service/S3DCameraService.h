@@ -1,12 +1,21 @@
 #pragma once
 
+#include <array>
+#include <atomic>
 #include <cstdint>
+#include <mutex>
+#include <vector>
 
 #include "cRZBaseSystemService.h"
+#include "CameraProjection.h"
+#include "TerrainHeightGrid.h"
 #include "cS3DCamera.h"
 #include "public/cIGZS3DCameraService.h"
 #include "utils/VersionDetection.h"
 
+class cISTETerrain;
+class cIGZTerrainService;
+
 // ReSharper disable once CppPolymorphicClassWithNonVirtualPublicDestructor
 class S3DCameraService final : public cRZBaseSystemService, public cIGZS3DCameraService {
 public:
@@ -18,6 +27,10 @@ public:
     uint32_t Release() override;
     bool QueryInterface(uint32_t riid, void** ppvObj) override;
 
+    // cRZBaseSystemService
+    bool OnTick(uint32_t unknown1) override;
+    bool OnIdle(uint32_t unknown1) override;
+
     // cIGZS3DCameraService
     [[nodiscard]] uint32_t GetServiceID() const override;
 
@@ -52,11 +65,28 @@ public:
     cS3DVector3& outRayDirection) override;
     void SetDepthOffset(S3DCameraHandle handle, float offset) override;
     int GetViewState(S3DCameraHandle handle) override;
+    bool GetViewFrustum(S3DCameraHandle handle, float viewportWidth, float viewportHeight,
+                        ViewFrustum& outFrustum) override;
+    bool ProjectBatch(S3DCameraHandle handle, const float* xyz, size_t count, float* outXYZ,
+                      uint8_t* outVisible) override;
+    bool UnProjectBatch(S3DCameraHandle handle, const float* xyz, size_t count, float* outXYZ,
+                        uint8_t* outValid) override;
+    bool CaptureSnapshot(S3DCameraHandle handle, float viewportWidth, float viewportHeight) override;
+    bool GetLatestSnapshot(S3DCameraSnapshot& outSnapshot) override;
+    [[nodiscard]] uint32_t GetCameraGeneration() const override;
+    bool RegisterCameraChangedCallback(S3DCameraChangedCallback callback, void* userData,
+                                       uint32_t* outToken) override;
+    void UnregisterCameraChangedCallback(uint32_t token) override;
+    bool PickTerrain(S3DCameraHandle handle, int32_t screenX, int32_t screenY, S3DTerrainPick& outPick) override;
 
     // Lifecycle
     bool Init();
     bool Shutdown();
 
+    /// Feeds the picking grid from the shared heightfield instead of polling the terrain. Optional; pass nullptr to
+    /// go back to polling.
+    void SetTerrainService(cIGZTerrainService* terrainService);
+
 private:
     struct Thunks {
         cS3DCamera* (__cdecl* create)();
@@ -86,9 +116,70 @@ private:
     };
 
     [[nodiscard]] cS3DCamera* Validate(S3DCameraHandle handle) const;
-    S3DCameraHandle WrapRendererCameraInternal();
+    S3DCameraHandle WrapRendererCameraInternal(bool logFailures = true);
+    bool ProbeProjectionCache(cS3DCamera* cam, const float* xyz, size_t count);
+    bool FitProjectionCache(cS3DCamera* cam, const float* center);
+    void PublishSnapshot(const S3DCameraSnapshot& snapshot);
+    [[nodiscard]] uint64_t HashCameraState(cS3DCamera* cam, float viewportWidth, float viewportHeight) const;
+    bool UpdateCameraGeneration(cS3DCamera* cam, float viewportWidth, float viewportHeight);
+    bool SyncTerrainGrid();
+    void CopyTerrainRows(uint32_t firstRow, uint32_t lastRow);
+    void CopyHeightfield();
+    bool RaycastTerrainGrid(const cS3DVector3& origin, const cS3DVector3& direction, TerrainRayHit& outHit);
 
 private:
     Thunks thunks_{};
+    // Fitted world -> screen transform for the batch paths; render/main thread only, like the camera itself.
+    cS3DCamera* projectionCamera_ = nullptr;
+    CameraProjection projection_{};
+    float projectionProbe_[3]{};    // Fit center; Project accepted it when the cache was built.
+
+    // Snapshot triple buffer. Captures come from the main thread only and write the slot after the published one.
+    // Readers copy the published slot and retry if its version changed while copying, so a reader that stalls for
+    // two whole captures retries instead of returning a torn copy.
+    struct SnapshotSlot {
+        std::atomic<uint32_t> version{0};    // Odd while the slot is being written.
+        S3DCameraSnapshot snapshot{};
+    };
+    static constexpr uint32_t kNoSnapshot = 0xFFFFFFFFu;
+    std::array<SnapshotSlot, 3> snapshotSlots_{};
+    std::atomic<uint32_t> publishedSnapshot_{kNoSnapshot};
+    uint32_t snapshotSequence_ = 0;
+    uint32_t tickSnapshotSequence_ = 0;    // Sequence of the last per-tick capture; differs after CaptureSnapshot.
+
+    // Change detection for the active renderer camera, updated once per tick.
+    struct ChangedCallbackRegistration {
+        uint32_t token = 0;
+        S3DCameraChangedCallback callback = nullptr;
+        void* userData = nullptr;
+    };
+    std::atomic<uint32_t> cameraGeneration_{0};
+    cS3DCamera* hashedCamera_ = nullptr;
+    uint64_t cameraStateHash_ = 0;
+    std::vector<ChangedCallbackRegistration> changedCallbacks_{};
+    std::mutex changedCallbacksMutex_{};
+    uint32_t nextCallbackToken_ = 1;
+
+    // Terrain picking. The grid is copied from the active city on first use, then kept current from the terrain
+    // service's heightfield (or, without one, refreshed a few rows per tick) and checked around every hit, so terrain
+    // edits show up within a second or two. Main thread only.
+    struct PickMemoEntry {
+        uint32_t epoch = 0;
+        int32_t screenX = 0;
+        int32_t screenY = 0;
+        cS3DVector3 rayOrigin{};
+        cS3DVector3 rayDirection{};
+        bool hit = false;
+        S3DTerrainPick pick{};
+    };
+    static constexpr size_t kPickMemoSize = 64;
+    TerrainHeightGrid terrainGrid_{};
+    cISTETerrain* gridTerrain_ = nullptr;
+    uint32_t gridRefreshRow_ = 0;
+    cIGZTerrainService* terrainService_ = nullptr;
+    uint32_t gridHeightfieldVersion_ = 0;    // Heightfield version last copied into the grid.
+    uint32_t pickEpoch_ = 1;    // Bumped every tick and whenever the grid changes; older memo entries are stale.
+    std::array<PickMemoEntry, kPickMemoSize> pickMemo_{};
+
     uint16_t versionTag_{};
 };
@@ -0,0 +1,261 @@
+#include "TerrainHeightGrid.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+namespace {
+    constexpr double kInfinity = std::numeric_limits<double>::infinity();
+
+    // Narrows [tStart, tEnd] to the part of the ray with lo <= o + d t <= hi.
+    bool ClipSlab(const double o, const double d, const double lo, const double hi, double& tStart, double& tEnd) {
+        if (d == 0.0) {
+            return o >= lo && o <= hi;
+        }
+        double t0 = (lo - o) / d;
+        double t1 = (hi - o) / d;
+        if (t0 > t1) {
+            std::swap(t0, t1);
+        }
+        tStart = (std::max)(tStart, t0);
+        tEnd = (std::min)(tEnd, t1);
+        return tStart <= tEnd;
+    }
+
+    // 2D DDA over square cells in xz. Calls visit(x, z, tEnter, tExit) for each cell the ray crosses between tStart
+    // and tEnd, in order, until visit returns true.
+    template <typename Visit>
+    bool WalkCells(const double* o, const double* d, const double tStart, const double tEnd, const double cellSize,
+                   const int64_t countX, const int64_t countZ, Visit&& visit) {
+        const auto startCell = [&](const double p, const int64_t count) {
+            return std::clamp(static_cast<int64_t>(std::floor(p / cellSize)), int64_t{0}, count - 1);
+        };
+        int64_t x = startCell(o[0] + d[0] * tStart, countX);
+        int64_t z = startCell(o[2] + d[2] * tStart, countZ);
+        const int64_t stepX = d[0] > 0.0 ? 1 : -1;
+        const int64_t stepZ = d[2] > 0.0 ? 1 : -1;
+        const double deltaX = d[0] != 0.0 ? cellSize / std::fabs(d[0]) : kInfinity;
+        const double deltaZ = d[2] != 0.0 ? cellSize / std::fabs(d[2]) : kInfinity;
+        const auto firstBoundary = [&](const int64_t cell, const int64_t step, const double p, const double dir) {
+            return dir != 0.0 ? (static_cast<double>(cell + (step > 0 ? 1 : 0)) * cellSize - p) / dir : kInfinity;
+        };
+        double nextX = firstBoundary(x, stepX, o[0], d[0]);
+        double nextZ = firstBoundary(z, stepZ, o[2], d[2]);
+
+        double t = tStart;
+        while (true) {
+            const double exit = (std::min)({nextX, nextZ, tEnd});
+            if (visit(x, z, t, (std::max)(exit, t))) {
+                return true;
+            }
+            if (exit >= tEnd) {
+                return false;
+            }
+            if (nextX < nextZ) {
+                x += stepX;
+                t = nextX;
+                nextX += deltaX;
+            }
+            else {
+                z += stepZ;
+                t = nextZ;
+                nextZ += deltaZ;
+            }
+            if (x < 0 || x >= countX || z < 0 || z >= countZ) {
+                return false;
+            }
+        }
+    }
+}
+
+void TerrainHeightGrid::Reset(const uint32_t cellsX, const uint32_t cellsZ) {
+    cellsX_ = cellsX;
+    cellsZ_ = cellsZ;
+    blocksX_ = (cellsX + kBlockCells - 1) / kBlockCells;
+    blocksZ_ = (cellsZ + kBlockCells - 1) / kBlockCells;
+    heights_.assign(static_cast<size_t>(VerticesX()) * VerticesZ(), 0.0f);
+    blockMax_.assign(static_cast<size_t>(blocksX_) * blocksZ_, 0.0f);
+    maxHeight_ = 0.0f;
+    if (Empty()) {
+        Clear();
+    }
+}
+
+void TerrainHeightGrid::Clear() {
+    cellsX_ = 0;
+    cellsZ_ = 0;
+    blocksX_ = 0;
+    blocksZ_ = 0;
+    heights_.clear();
+    blockMax_.clear();
+    maxHeight_ = 0.0f;
+}
+
+float* TerrainHeightGrid::Row(const uint32_t z) {
+    return heights_.data() + static_cast<size_t>(z) * VerticesX();
+}
+
+const float* TerrainHeightGrid::Row(const uint32_t z) const {
+    return heights_.data() + static_cast<size_t>(z) * VerticesX();
+}
+
+void TerrainHeightGrid::UpdateBounds(const uint32_t firstRow, const uint32_t lastRow) {
+    if (Empty() || firstRow > lastRow) {
+        return;
+    }
+    // Vertex row r is shared by the blocks on both sides of a block edge.
+    const uint32_t firstBlock = firstRow > 0 ? (firstRow - 1) / kBlockCells : 0;
+    const uint32_t lastBlock = (std::min)(lastRow / kBlockCells, blocksZ_ - 1);
+    for (uint32_t bz = firstBlock; bz <= lastBlock; ++bz) {
+        for (uint32_t bx = 0; bx < blocksX_; ++bx) {
+            UpdateBlock(bx, bz);
+        }
+    }
+    maxHeight_ = *std::max_element(blockMax_.begin(), blockMax_.end());
+}
+
+float TerrainHeightGrid::GetHeight(const uint32_t x, const uint32_t z) const {
+    return heights_[static_cast<size_t>(z) * VerticesX() + x];
+}
+
+float TerrainHeightGrid::SampleHeight(const float worldX, const float worldZ) const {
+    if (Empty()) {
+        return 0.0f;
+    }
+    const float fx = std::clamp(worldX / kGridSpacing, 0.0f, static_cast<float>(cellsX_));
+    const float fz = std::clamp(worldZ / kGridSpacing, 0.0f, static_cast<float>(cellsZ_));
+    const uint32_t x = (std::min)(static_cast<uint32_t>(fx), cellsX_ - 1);
+    const uint32_t z = (std::min)(static_cast<uint32_t>(fz), cellsZ_ - 1);
+    const float tx = fx - static_cast<float>(x);
+    const float tz = fz - static_cast<float>(z);
+    const float* row0 = Row(z);
+    const float* row1 = Row(z + 1);
+    const float h0 = row0[x] + (row0[x + 1] - row0[x]) * tx;
+    const float h1 = row1[x] + (row1[x + 1] - row1[x]) * tx;
+    return h0 + (h1 - h0) * tz;
+}
+
+bool TerrainHeightGrid::Raycast(const float* origin, const float* direction, const float maxDistance,
+                                TerrainRayHit& outHit) const {
+    if (Empty() || !(maxDistance > 0.0f)) {
+        return false;
+    }
+    const double o[3] = {origin[0], origin[1], origin[2]};
+    const double d[3] = {direction[0], direction[1], direction[2]};
+
+    // Only the part of the ray over the grid and below its highest vertex can hit anything.
+    double tStart = 0.0;
+    double tEnd = maxDistance;
+    if (!ClipSlab(o[0], d[0], 0.0, cellsX_ * static_cast<double>(kGridSpacing), tStart, tEnd) ||
+        !ClipSlab(o[2], d[2], 0.0, cellsZ_ * static_cast<double>(kGridSpacing), tStart, tEnd) ||
+        !ClipSlab(o[1], d[1], -kInfinity, maxHeight_, tStart, tEnd)) {
+        return false;
+    }
+
+    const auto lowestY = [&](const double ta, const double tb) {
+        return (std::min)(o[1] + d[1] * ta, o[1] + d[1] * tb);
+    };
+    constexpr double kBlockSize = static_cast<double>(kGridSpacing) * kBlockCells;
+    return WalkCells(o, d, tStart, tEnd, kBlockSize, blocksX_, blocksZ_,
+                     [&](const int64_t bx, const int64_t bz, const double ta, const double tb) {
+                         if (lowestY(ta, tb) > blockMax_[static_cast<size_t>(bz) * blocksX_ + bx]) {
+                             return false;
+                         }
+                         return WalkCells(o, d, ta, tb, kGridSpacing, cellsX_, cellsZ_,
+                                          [&](const int64_t x, const int64_t z, const double ca, const double cb) {
+                                              return IntersectCell(static_cast<uint32_t>(x),
+                                                                   static_cast<uint32_t>(z), o, d, ca, cb, outHit);
+                                          });
+                     });
+}
+
+bool TerrainHeightGrid::IntersectCell(const uint32_t x, const uint32_t z, const double* origin,
+                                      const double* direction, const double tStart, const double tEnd,
+                                      TerrainRayHit& outHit) const {
+    const float* row0 = Row(z);
+    const float* row1 = Row(z + 1);
+    const double h00 = row0[x];
+    const double h10 = row0[x + 1];
+    const double h01 = row1[x];
+    const double h11 = row1[x + 1];
+    const double cellMax = (std::max)({h00, h10, h01, h11});
+    if ((std::min)(origin[1] + direction[1] * tStart, origin[1] + direction[1] * tEnd) > cellMax) {
+        return false;
+    }
+
+    // Along the segment, s = t - tStart, the bilinear height is quadratic in s:
+    // h(u, v) = h00 + e u + g v + k u v with u = u0 + bu s and v = v0 + bv s.
+    const double e = h10 - h00;
+    const double g = h01 - h00;
+    const double k = h00 - h10 - h01 + h11;
+    const double u0 = (origin[0] + direction[0] * tStart) / kGridSpacing - x;
+    const double v0 = (origin[2] + direction[2] * tStart) / kGridSpacing - z;
+    const double bu = direction[0] / kGridSpacing;
+    const double bv = direction[2] / kGridSpacing;
+    const double c0 = h00 + e * u0 + g * v0 + k * u0 * v0;
+    const double c1 = e * bu + g * bv + k * (u0 * bv + bu * v0);
+    const double c2 = k * bu * bv;
+
+    // f(s) = ray height - terrain height; the hit is its first root, where the ray goes from above to below.
+    const double a = -c2;
+    const double b = direction[1] - c1;
+    const double c = origin[1] + direction[1] * tStart - c0;
+    const double length = (std::max)(tEnd - tStart, 0.0);
+    double s = -1.0;
+    if (c <= 0.0) {
+        s = 0.0;
+    }
+    else if (std::fabs(a) <= 1.0e-12 * (std::fabs(b) + std::fabs(c))) {
+        if (b < 0.0) {
+            s = -c / b;
+        }
+    }
+    else {
+        const double discriminant = b * b - 4.0 * a * c;
+        if (discriminant >= 0.0) {
+            const double root = std::sqrt(discriminant);
+            const double q = -0.5 * (b + (b < 0.0 ? -root : root));
+            const double r0 = q / a;
+            const double r1 = q != 0.0 ? c / q : kInfinity;
+            for (const double r : {(std::min)(r0, r1), (std::max)(r0, r1)}) {
+                if (r >= 0.0) {
+                    s = r;
+                    break;
+                }
+            }
+        }
+    }
+    if (s < 0.0 || s > length) {
+        return false;
+    }
+
+    const double t = tStart + s;
+    const double u = std::clamp(u0 + bu * s, 0.0, 1.0);
+    const double v = std::clamp(v0 + bv * s, 0.0, 1.0);
+    const double dhdx = (e + k * v) / kGridSpacing;
+    const double dhdz = (g + k * u) / kGridSpacing;
+    const double invLength = 1.0 / std::sqrt(dhdx * dhdx + 1.0 + dhdz * dhdz);
+    outHit.position[0] = static_cast<float>(origin[0] + direction[0] * t);
+    outHit.position[1] = static_cast<float>(origin[1] + direction[1] * t);
+    outHit.position[2] = static_cast<float>(origin[2] + direction[2] * t);
+    outHit.normal[0] = static_cast<float>(-dhdx * invLength);
+    outHit.normal[1] = static_cast<float>(invLength);
+    outHit.normal[2] = static_cast<float>(-dhdz * invLength);
+    outHit.distance = static_cast<float>(t);
+    outHit.cellX = x;
+    outHit.cellZ = z;
+    return true;
+}
+
+void TerrainHeightGrid::UpdateBlock(const uint32_t blockX, const uint32_t blockZ) {
+    const uint32_t x0 = blockX * kBlockCells;
+    const uint32_t z0 = blockZ * kBlockCells;
+    const uint32_t x1 = (std::min)(x0 + kBlockCells, cellsX_);
+    const uint32_t z1 = (std::min)(z0 + kBlockCells, cellsZ_);
+    float highest = -std::numeric_limits<float>::infinity();
+    for (uint32_t z = z0; z <= z1; ++z) {
+        const float* row = Row(z);
+        highest = (std::max)(highest, *std::max_element(row + x0, row + x1 + 1));
+    }
+    blockMax_[static_cast<size_t>(blockZ) * blocksX_ + blockX] = highest;
+}
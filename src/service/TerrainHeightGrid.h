@@ -0,0 +1,61 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Native copy of the city terrain's height grid, used to pick terrain without the game's ray cast.
+//
+// Heights are stored per grid vertex, kGridSpacing world units apart, and each cell is treated as a bilinear patch
+// (the same interpolation the road-decal conformer samples with). Rays march the grid with a two-level DDA: blocks of
+// kBlockCells x kBlockCells cells keep their highest vertex, so a ray passing over a block skips all of its cells, and
+// cells that may be hit are solved exactly as a quadratic along the ray.
+struct TerrainRayHit {
+    float position[3];
+    float normal[3];        // Unit surface normal, y up.
+    float distance;         // Along the ray, in units of the direction's length.
+    uint32_t cellX;
+    uint32_t cellZ;
+};
+
+class TerrainHeightGrid {
+public:
+    static constexpr float kGridSpacing = 16.0f;
+    static constexpr uint32_t kBlockCells = 8;
+
+    /// Resizes the grid to `cellsX` x `cellsZ` cells (one more vertex each way) with all heights zero.
+    void Reset(uint32_t cellsX, uint32_t cellsZ);
+    void Clear();
+
+    [[nodiscard]] bool Empty() const { return cellsX_ == 0 || cellsZ_ == 0; }
+    [[nodiscard]] uint32_t CellsX() const { return cellsX_; }
+    [[nodiscard]] uint32_t CellsZ() const { return cellsZ_; }
+    [[nodiscard]] uint32_t VerticesX() const { return cellsX_ + 1; }
+    [[nodiscard]] uint32_t VerticesZ() const { return cellsZ_ + 1; }
+
+    /// Mutable vertex row `z` (VerticesX() heights). Call UpdateBounds after writing before the next Raycast.
+    float* Row(uint32_t z);
+    [[nodiscard]] const float* Row(uint32_t z) const;
+    /// Recomputes the block maxima for vertex rows [firstRow, lastRow].
+    void UpdateBounds(uint32_t firstRow, uint32_t lastRow);
+
+    [[nodiscard]] float GetHeight(uint32_t x, uint32_t z) const;
+    /// Bilinear height at a world position, clamped to the grid.
+    [[nodiscard]] float SampleHeight(float worldX, float worldZ) const;
+
+    /// First intersection of the ray with the terrain within `maxDistance`. `direction` need not be normalized.
+    bool Raycast(const float* origin, const float* direction, float maxDistance, TerrainRayHit& outHit) const;
+
+private:
+    bool IntersectCell(uint32_t x, uint32_t z, const double* origin, const double* direction, double tStart,
+                       double tEnd, TerrainRayHit& outHit) const;
+    void UpdateBlock(uint32_t blockX, uint32_t blockZ);
+
+    uint32_t cellsX_ = 0;
+    uint32_t cellsZ_ = 0;
+    uint32_t blocksX_ = 0;
+    uint32_t blocksZ_ = 0;
+    std::vector<float> heights_{};      // VerticesZ() rows of VerticesX() heights.
+    std::vector<float> blockMax_{};     // Highest vertex of each block, including its shared edges.
+    float maxHeight_ = 0.0f;
+};
@@ -0,0 +1,206 @@
+#include "TerrainService.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+#include "cISC4App.h"
+#include "cISC4City.h"
+#include "cISTETerrain.h"
+#include "GZServPtrs.h"
+#include "public/TerrainServiceIds.h"
+#include "utils/Logger.h"
+
+namespace {
+    constexpr float kGridSpacing = 16.0f;
+    // A full pass over a large city takes a little over a second; edits reported through MarkTerrainDirty are picked
+    // up on the next tick.
+    constexpr uint32_t kRowsPerTick = 8;
+    constexpr uint32_t kDirtyTileCells = 8;
+
+    cISTETerrain* GetActiveTerrain(uint32_t& cellsX, uint32_t& cellsZ) {
+        cISC4AppPtr app;
+        cISC4City* city = app ? app->GetCity() : nullptr;
+        cISTETerrain* terrain = city ? city->GetTerrain() : nullptr;
+        if (!terrain) {
+            return nullptr;
+        }
+        cellsX = static_cast<uint32_t>(city->SizeX() / kGridSpacing);
+        cellsZ = static_cast<uint32_t>(city->SizeZ() / kGridSpacing);
+        return cellsX && cellsZ ? terrain : nullptr;
+    }
+
+    // Vertex range of the dirty tiles covering [minWorld, maxWorld], clamped to `cells`.
+    bool TileRange(const float minWorld, const float maxWorld, const uint32_t cells, uint32_t& first, uint32_t& last) {
+        const float lo = std::floor((std::min)(minWorld, maxWorld) / (kGridSpacing * kDirtyTileCells));
+        const float hi = std::floor((std::max)(minWorld, maxWorld) / (kGridSpacing * kDirtyTileCells)) + 1.0f;
+        if (!(hi > 0.0f) || !(lo * kDirtyTileCells <= static_cast<float>(cells))) {
+            return false;
+        }
+        first = static_cast<uint32_t>((std::max)(lo, 0.0f)) * kDirtyTileCells;
+        last = static_cast<uint32_t>((std::min)(hi * kDirtyTileCells, static_cast<float>(cells)));
+        return true;
+    }
+}
+
+TerrainService::TerrainService()
+    : cRZBaseSystemService(kTerrainServiceID, 0)
+      , versionTag_(VersionDetection::GetInstance().GetGameVersion()) {}
+
+uint32_t TerrainService::AddRef() {
+    return cRZBaseSystemService::AddRef();
+}
+
+uint32_t TerrainService::Release() {
+    return cRZBaseSystemService::Release();
+}
+
+bool TerrainService::QueryInterface(const uint32_t riid, void** ppvObj) {
+    if (!ppvObj) {
+        return false;
+    }
+
+    if (riid == GZIID_cIGZTerrainService) {
+        *ppvObj = static_cast<cIGZTerrainService*>(this);
+        AddRef();
+        return true;
+    }
+    return cRZBaseSystemService::QueryInterface(riid, ppvObj);
+}
+
+bool TerrainService::OnTick(uint32_t) {
+    uint32_t cellsX = 0;
+    uint32_t cellsZ = 0;
+    cISTETerrain* terrain = GetActiveTerrain(cellsX, cellsZ);
+    if (!terrain) {
+        if (terrain_) {
+            terrain_ = nullptr;
+            staging_.clear();
+            stagingChanged_ = false;
+            publisher_.Unpublish();
+        }
+        return true;
+    }
+
+    const uint32_t verticesX = cellsX + 1;
+    const uint32_t verticesZ = cellsZ + 1;
+    if (terrain != terrain_ || cellsX != cellsX_ || cellsZ != cellsZ_) {
+        terrain_ = terrain;
+        cellsX_ = cellsX;
+        cellsZ_ = cellsZ;
+        staging_.assign(static_cast<size_t>(verticesX) * verticesZ, 0.0f);
+        refreshRow_ = 0;
+        {
+            std::lock_guard<std::mutex> lock(pendingDirtyMutex_);
+            pendingDirty_.clear();
+        }
+        ReadVertices(0, 0, cellsX, cellsZ);
+        stagingChanged_ = true;
+        LOG_DEBUG("TerrainService: copied {}x{} height grid", verticesX, verticesZ);
+    }
+    else {
+        std::vector<DirtyRect> dirty;
+        {
+            std::lock_guard<std::mutex> lock(pendingDirtyMutex_);
+            dirty.swap(pendingDirty_);
+        }
+        for (const DirtyRect& rect : dirty) {
+            stagingChanged_ |= ReadDirtyTiles(rect);
+        }
+        const uint32_t first = refreshRow_ % verticesZ;
+        const uint32_t last = (std::min)(first + kRowsPerTick, verticesZ) - 1;
+        stagingChanged_ |= ReadVertices(0, first, cellsX, last);
+        refreshRow_ = last + 1;
+    }
+
+    if (stagingChanged_ && Publish()) {
+        stagingChanged_ = false;
+    }
+    return true;
+}
+
+bool TerrainService::OnIdle(uint32_t) {
+    return OnTick(0);
+}
+
+uint32_t TerrainService::GetServiceID() const {
+    return kTerrainServiceID;
+}
+
+bool TerrainService::AcquireHeightfield(TerrainHeightfieldView& outView) {
+    return publisher_.Acquire(outView);
+}
+
+void TerrainService::ReleaseHeightfield(const TerrainHeightfieldView& view) {
+    publisher_.Release(view);
+}
+
+uint32_t TerrainService::GetHeightfieldVersion() const {
+    return publisher_.Version();
+}
+
+void TerrainService::MarkTerrainDirty(const float minX, const float minZ, const float maxX, const float maxZ) {
+    std::lock_guard<std::mutex> lock(pendingDirtyMutex_);
+    pendingDirty_.push_back({minX, minZ, maxX, maxZ});
+}
+
+bool TerrainService::Init() {
+    if (versionTag_ != 641) {
+        LOG_WARN("TerrainService: not registering, game version {} != 641", versionTag_);
+        return false;
+    }
+
+    LOG_INFO("TerrainService: registered");
+    return true;
+}
+
+bool TerrainService::Shutdown() {
+    std::lock_guard<std::mutex> lock(pendingDirtyMutex_);
+    pendingDirty_.clear();
+    publisher_.Reset();
+    staging_.clear();
+    terrain_ = nullptr;
+    return true;
+}
+
+bool TerrainService::ReadVertices(const uint32_t x0, const uint32_t z0, const uint32_t x1, const uint32_t z1) {
+    const uint32_t verticesX = cellsX_ + 1;
+    bool changed = false;
+    for (uint32_t z = z0; z <= z1; ++z) {
+        float* row = staging_.data() + static_cast<size_t>(z) * verticesX;
+        const float worldZ = static_cast<float>(z) * kGridSpacing;
+        for (uint32_t x = x0; x <= x1; ++x) {
+            const float height = terrain_->GetAltitudeAtNearestGrid(static_cast<float>(x) * kGridSpacing, worldZ);
+            changed |= row[x] != height;
+            row[x] = height;
+        }
+    }
+    return changed;
+}
+
+bool TerrainService::ReadDirtyTiles(const DirtyRect& rect) {
+    uint32_t x0 = 0;
+    uint32_t x1 = 0;
+    uint32_t z0 = 0;
+    uint32_t z1 = 0;
+    if (!TileRange(rect.minX, rect.maxX, cellsX_, x0, x1) || !TileRange(rect.minZ, rect.maxZ, cellsZ_, z0, z1)) {
+        return false;
+    }
+    return ReadVertices(x0, z0, x1, z1);
+}
+
+bool TerrainService::Publish() {
+    const uint32_t verticesX = cellsX_ + 1;
+    const uint32_t verticesZ = cellsZ_ + 1;
+    uint32_t rowStride = 0;
+    float* heights = publisher_.BeginPublish(verticesX, verticesZ, kGridSpacing, rowStride);
+    if (!heights) {
+        return false;
+    }
+    for (uint32_t z = 0; z < verticesZ; ++z) {
+        std::memcpy(heights + static_cast<size_t>(z) * rowStride, staging_.data() + static_cast<size_t>(z) * verticesX,
+                    verticesX * sizeof(float));
+    }
+    publisher_.EndPublish();
+    return true;
+}
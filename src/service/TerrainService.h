@@ -0,0 +1,67 @@
+#pragma once
+
+#include <cstdint>
+#include <mutex>
+#include <vector>
+
+#include "HeightfieldPublisher.h"
+#include "cRZBaseSystemService.h"
+#include "public/cIGZTerrainService.h"
+#include "utils/VersionDetection.h"
+
+class cISTETerrain;
+
+// ReSharper disable once CppPolymorphicClassWithNonVirtualPublicDestructor
+class TerrainService final : public cRZBaseSystemService, public cIGZTerrainService {
+public:
+    TerrainService();
+    ~TerrainService() = default;
+
+    // IUnknown
+    uint32_t AddRef() override;
+    uint32_t Release() override;
+    bool QueryInterface(uint32_t riid, void** ppvObj) override;
+
+    // cRZBaseSystemService
+    bool OnTick(uint32_t unknown1) override;
+    bool OnIdle(uint32_t unknown1) override;
+
+    // cIGZTerrainService
+    [[nodiscard]] uint32_t GetServiceID() const override;
+    bool AcquireHeightfield(TerrainHeightfieldView& outView) override;
+    void ReleaseHeightfield(const TerrainHeightfieldView& view) override;
+    [[nodiscard]] uint32_t GetHeightfieldVersion() const override;
+    void MarkTerrainDirty(float minX, float minZ, float maxX, float maxZ) override;
+
+    // Lifecycle
+    bool Init();
+    bool Shutdown();
+
+private:
+    struct DirtyRect {
+        float minX;
+        float minZ;
+        float maxX;
+        float maxZ;
+    };
+
+    bool ReadVertices(uint32_t x0, uint32_t z0, uint32_t x1, uint32_t z1);
+    bool ReadDirtyTiles(const DirtyRect& rect);
+    bool Publish();
+
+private:
+    // Main thread copy of the game's heights, VerticesZ rows of VerticesX, packed. Published to readers as a whole
+    // whenever a refresh changed it.
+    HeightfieldPublisher publisher_{};
+    cISTETerrain* terrain_ = nullptr;
+    uint32_t cellsX_ = 0;
+    uint32_t cellsZ_ = 0;
+    std::vector<float> staging_{};
+    uint32_t refreshRow_ = 0;
+    bool stagingChanged_ = false;    // Staging differs from the published copy; set until a publish succeeds.
+
+    std::vector<DirtyRect> pendingDirty_{};
+    std::mutex pendingDirtyMutex_{};
+
+    uint16_t versionTag_{};
+};
@@ -27,6 +27,8 @@ namespace {
     constexpr bool kDefaultEnableImGuiService = true;
     constexpr bool kDefaultEnableS3DCameraService = true;
     constexpr bool kDefaultEnableDrawService = true;
+    constexpr bool kDefaultEnableTerrainService = true;
+    constexpr bool kDefaultDrawStateFilter = false;
 
     const std::string kDefaultTheme = "dark";
     const std::string kSectionName = "SC4RenderServices";
@@ -112,7 +114,9 @@ Settings::Settings()
     , showDemoPanel_(kDefaultShowDemoPanel)
     , enableImGuiService_(kDefaultEnableImGuiService)
     , enableS3DCameraService_(kDefaultEnableS3DCameraService)
-    , enableDrawService_(kDefaultEnableDrawService) {}
+    , enableDrawService_(kDefaultEnableDrawService)
+    , enableTerrainService_(kDefaultEnableTerrainService)
+    , drawStateFilter_(kDefaultDrawStateFilter) {}
 
 void Settings::Load(const std::filesystem::path& settingsFilePath) {
     // Reset to defaults
@@ -278,6 +282,28 @@ void Settings::Load(const std::filesystem::path& settingsFilePath) {
                 LOG_ERROR("Invalid EnableDrawService value '{}' in {}. Using default true.", text, settingsFilePath.string());
             }
         }
+
+        // EnableTerrainService
+        if (section.has("EnableTerrainService")) {
+            bool valid = false;
+            const std::string text = section.get("EnableTerrainService");
+            enableTerrainService_ = ParseBool(text, valid);
+            if (!valid) {
+                enableTerrainService_ = kDefaultEnableTerrainService;
+                LOG_ERROR("Invalid EnableTerrainService value '{}' in {}. Using default true.", text, settingsFilePath.string());
+            }
+        }
+
+        // DrawStateFilter
+        if (section.has("DrawStateFilter")) {
+            bool valid = false;
+            const std::string text = section.get("DrawStateFilter");
+            drawStateFilter_ = ParseBool(text, valid);
+            if (!valid) {
+                drawStateFilter_ = kDefaultDrawStateFilter;
+                LOG_ERROR("Invalid DrawStateFilter value '{}' in {}. Using default false.", text, settingsFilePath.string());
+            }
+        }
     }
     catch (const std::exception& e) {
         LOG_ERROR("Error reading settings file {}: {}", settingsFilePath.string(), e.what());
@@ -297,3 +323,5 @@ bool Settings::GetShowDemoPanel() const noexcept { return showDemoPanel_; }
 bool Settings::GetEnableImGuiService() const noexcept { return enableImGuiService_; }
 bool Settings::GetEnableS3DCameraService() const noexcept { return enableS3DCameraService_; }
 bool Settings::GetEnableDrawService() const noexcept { return enableDrawService_; }
+bool Settings::GetEnableTerrainService() const noexcept { return enableTerrainService_; }
+bool Settings::GetDrawStateFilter() const noexcept { return drawStateFilter_; }
@@ -29,6 +29,10 @@ public:
     [[nodiscard]] bool GetEnableImGuiService() const noexcept;
     [[nodiscard]] bool GetEnableS3DCameraService() const noexcept;
     [[nodiscard]] bool GetEnableDrawService() const noexcept;
+    [[nodiscard]] bool GetEnableTerrainService() const noexcept;
+
+    // Draw service tuning
+    [[nodiscard]] bool GetDrawStateFilter() const noexcept;
 
 private:
     spdlog::level::level_enum logLevel_;
@@ -43,4 +47,6 @@ private:
     bool enableImGuiService_;
     bool enableS3DCameraService_;
     bool enableDrawService_;
+    bool enableTerrainService_;
+    bool drawStateFilter_;
 };
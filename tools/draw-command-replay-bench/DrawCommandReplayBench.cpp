@@ -0,0 +1,664 @@
+// Correctness check and benchmark for deferred draw command lists (src/public/DrawCommandList.h).
+//
+// Records a frame's worth of object draws the way a plugin would (transform, texture, shade and blend state, then a
+// primitive or pooled-buffer draw per object), validates it like SubmitDrawCommandList does, and replays it through
+// a stand-in executor whose switch mirrors DrawService::ReplayCommandList_. The executor's calls only hash their
+// arguments, so the timings are the cost of the list itself: recording, validation and decode/dispatch, against
+// making the same calls directly. Exits non-zero if the replay does not reproduce the direct calls or if malformed
+// lists are accepted.
+//
+// Usage: draw-command-replay-bench [object-count] [iterations]
+
+#include "public/DrawCommandList.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <limits>
+#include <random>
+#include <vector>
+
+namespace {
+    int gFailures = 0;
+
+    void Expect(const bool condition, const char* what) {
+        if (!condition) {
+            std::fprintf(stderr, "FAIL: %s\n", what);
+            ++gFailures;
+        }
+    }
+
+    // Stands in for the DrawService setters the replay calls. Virtual like the service's own, and out of line, so
+    // every command pays a real call; each call folds its opcode and arguments into a hash.
+    class ReplayTarget {
+    public:
+        virtual ~ReplayTarget() = default;
+
+        [[nodiscard]] uint64_t Hash() const { return hash_; }
+        [[nodiscard]] uint32_t Calls() const { return calls_; }
+        void ResetHash() {
+            hash_ = 14695981039346656037ull;
+            calls_ = 0;
+        }
+
+        virtual void SetHighlightColor(SC4DrawContextHandle, int highlightType, float r, float g, float b, float a);
+        virtual void SetRenderStateHighlight(SC4DrawContextHandle, int highlightType);
+        virtual void SetModelTransform(SC4DrawContextHandle, float* transform4x4);
+        virtual void ResetModelViewTransform(SC4DrawContextHandle);
+        virtual void SetShade(SC4DrawContextHandle, const float* rgba);
+        virtual void ResetShade(SC4DrawContextHandle);
+        virtual void SetDefaultRenderState(SC4DrawContextHandle);
+        virtual void SetDefaultRenderStateUnilaterally(SC4DrawContextHandle);
+        virtual void RenderMesh(SC4DrawContextHandle, void* mesh);
+        virtual void RenderModelInstance(SC4DrawContextHandle, int* modelCount, int* modelList, uint8_t* drawInfo,
+                                         bool previewOnly);
+        virtual void SetTexWrapModes(SC4DrawContextHandle, int uMode, int vMode, int stage);
+        virtual void SetTexFiltering(SC4DrawContextHandle, int minFilter, int magFilter, int stage);
+        virtual void SetTexture(SC4DrawContextHandle, uint32_t texture, int stage);
+        virtual void EnableTextureStateFlag(SC4DrawContextHandle, bool enable, int stage);
+        virtual void SetTexColor(SC4DrawContextHandle, float r, float g, float b, float a);
+        virtual void SetTexEnvMode(SC4DrawContextHandle, uint32_t envMode, int stage);
+        virtual void SetTexCoord(SC4DrawContextHandle, int texCoord, int stage);
+        virtual void EnableFlag(DrawCommandOp op, SC4DrawContextHandle, bool enabled);
+        virtual void SetBlendFunc(SC4DrawContextHandle, uint32_t srcFactor, uint32_t dstFactor);
+        virtual void SetAlphaFunc(SC4DrawContextHandle, uint32_t alphaFunc, float alphaRef);
+        virtual void SetDepthFunc(SC4DrawContextHandle, uint32_t depthFunc);
+        virtual void SetDepthOffset(SC4DrawContextHandle, int depthOffset);
+        virtual void SetTransparency(SC4DrawContextHandle);
+        virtual void ResetTransparency(SC4DrawContextHandle);
+        virtual void SetFog(SC4DrawContextHandle, bool enableFog, float* fogColorRgb, float fogStart, float fogEnd);
+        virtual void DrawBoundingBox(SC4DrawContextHandle, float* bbox6, float r, float g, float b, float a);
+        virtual void DrawPrims(SC4DrawContextHandle, uint32_t primType, uint32_t startVertex, uint32_t primitiveCount,
+                               uint32_t flags);
+        virtual void DrawPrimsIndexed(SC4DrawContextHandle, uint8_t primType, long indexStart, long indexCount);
+        virtual bool DrawBufferPrimitives(DrawBufferHandle buffer, uint32_t primType, uint32_t startVertex,
+                                          uint32_t vertexCount);
+        virtual bool DrawBufferIndexedPrimitives(DrawBufferHandle buffer, uint32_t primType, uint32_t startVertex,
+                                                 uint32_t vertexCount, uint32_t startIndex, uint32_t indexCount);
+
+    private:
+        void Mix_(const DrawCommandOp op) {
+            Bytes_(&op, sizeof(op));
+            ++calls_;
+        }
+        template <typename... Args>
+        void Mix_(const DrawCommandOp op, const Args&... args) {
+            Mix_(op);
+            (Bytes_(&args, sizeof(args)), ...);
+        }
+        // FNV-1a over 32-bit words, so hashing a matrix does not outweigh the call it stands in for.
+        void Bytes_(const void* data, const size_t size) {
+            const auto* bytes = static_cast<const uint8_t*>(data);
+            size_t i = 0;
+            for (; i + 4 <= size; i += 4) {
+                uint32_t word;
+                std::memcpy(&word, bytes + i, sizeof(word));
+                hash_ = (hash_ ^ word) * 1099511628211ull;
+            }
+            for (; i < size; ++i) {
+                hash_ = (hash_ ^ bytes[i]) * 1099511628211ull;
+            }
+        }
+
+        uint64_t hash_ = 14695981039346656037ull;
+        uint32_t calls_ = 0;
+    };
+
+    void ReplayTarget::SetHighlightColor(SC4DrawContextHandle, const int highlightType, const float r, const float g,
+                                         const float b, const float a) {
+        Mix_(DrawCommandOp::SetHighlightColor, highlightType, r, g, b, a);
+    }
+    void ReplayTarget::SetRenderStateHighlight(SC4DrawContextHandle, const int highlightType) {
+        Mix_(DrawCommandOp::SetRenderStateHighlight, highlightType);
+    }
+    void ReplayTarget::SetModelTransform(SC4DrawContextHandle, float* transform4x4) {
+        Mix_(DrawCommandOp::SetModelTransform);
+        Bytes_(transform4x4, 16 * sizeof(float));
+    }
+    void ReplayTarget::ResetModelViewTransform(SC4DrawContextHandle) { Mix_(DrawCommandOp::ResetModelViewTransform); }
+    void ReplayTarget::SetShade(SC4DrawContextHandle, const float* rgba) {
+        Mix_(DrawCommandOp::SetShade);
+        Bytes_(rgba, 4 * sizeof(float));
+    }
+    void ReplayTarget::ResetShade(SC4DrawContextHandle) { Mix_(DrawCommandOp::ResetShade); }
+    void ReplayTarget::SetDefaultRenderState(SC4DrawContextHandle) { Mix_(DrawCommandOp::SetDefaultRenderState); }
+    void ReplayTarget::SetDefaultRenderStateUnilaterally(SC4DrawContextHandle) {
+        Mix_(DrawCommandOp::SetDefaultRenderStateUnilaterally);
+    }
+    void ReplayTarget::RenderMesh(SC4DrawContextHandle, void* mesh) { Mix_(DrawCommandOp::RenderMesh, mesh); }
+    void ReplayTarget::RenderModelInstance(SC4DrawContextHandle, int* modelCount, int* modelList, uint8_t* drawInfo,
+                                           const bool previewOnly) {
+        Mix_(DrawCommandOp::RenderModelInstance, modelCount, modelList, drawInfo, previewOnly);
+    }
+    void ReplayTarget::SetTexWrapModes(SC4DrawContextHandle, const int uMode, const int vMode, const int stage) {
+        Mix_(DrawCommandOp::SetTexWrapModes, uMode, vMode, stage);
+    }
+    void ReplayTarget::SetTexFiltering(SC4DrawContextHandle, const int minFilter, const int magFilter,
+                                       const int stage) {
+        Mix_(DrawCommandOp::SetTexFiltering, minFilter, magFilter, stage);
+    }
+    void ReplayTarget::SetTexture(SC4DrawContextHandle, const uint32_t texture, const int stage) {
+        Mix_(DrawCommandOp::SetTexture, texture, stage);
+    }
+    void ReplayTarget::EnableTextureStateFlag(SC4DrawContextHandle, const bool enable, const int stage) {
+        Mix_(DrawCommandOp::EnableTextureStateFlag, enable, stage);
+    }
+    void ReplayTarget::SetTexColor(SC4DrawContextHandle, const float r, const float g, const float b, const float a) {
+        Mix_(DrawCommandOp::SetTexColor, r, g, b, a);
+    }
+    void ReplayTarget::SetTexEnvMode(SC4DrawContextHandle, const uint32_t envMode, const int stage) {
+        Mix_(DrawCommandOp::SetTexEnvMode, envMode, stage);
+    }
+    void ReplayTarget::SetTexCoord(SC4DrawContextHandle, const int texCoord, const int stage) {
+        Mix_(DrawCommandOp::SetTexCoord, texCoord, stage);
+    }
+    void ReplayTarget::EnableFlag(const DrawCommandOp op, SC4DrawContextHandle, const bool enabled) {
+        Mix_(op, enabled);
+    }
+    void ReplayTarget::SetBlendFunc(SC4DrawContextHandle, const uint32_t srcFactor, const uint32_t dstFactor) {
+        Mix_(DrawCommandOp::SetBlendFunc, srcFactor, dstFactor);
+    }
+    void ReplayTarget::SetAlphaFunc(SC4DrawContextHandle, const uint32_t alphaFunc, const float alphaRef) {
+        Mix_(DrawCommandOp::SetAlphaFunc, alphaFunc, alphaRef);
+    }
+    void ReplayTarget::SetDepthFunc(SC4DrawContextHandle, const uint32_t depthFunc) {
+        Mix_(DrawCommandOp::SetDepthFunc, depthFunc);
+    }
+    void ReplayTarget::SetDepthOffset(SC4DrawContextHandle, const int depthOffset) {
+        Mix_(DrawCommandOp::SetDepthOffset, depthOffset);
+    }
+    void ReplayTarget::SetTransparency(SC4DrawContextHandle) { Mix_(DrawCommandOp::SetTransparency); }
+    void ReplayTarget::ResetTransparency(SC4DrawContextHandle) { Mix_(DrawCommandOp::ResetTransparency); }
+    void ReplayTarget::SetFog(SC4DrawContextHandle, const bool enableFog, float* fogColorRgb, const float fogStart,
+                              const float fogEnd) {
+        Mix_(DrawCommandOp::SetFog, enableFog, fogStart, fogEnd);
+        Bytes_(fogColorRgb, 3 * sizeof(float));
+    }
+    void ReplayTarget::DrawBoundingBox(SC4DrawContextHandle, float* bbox6, const float r, const float g, const float b,
+                                       const float a) {
+        Mix_(DrawCommandOp::DrawBoundingBox, r, g, b, a);
+        Bytes_(bbox6, 6 * sizeof(float));
+    }
+    void ReplayTarget::DrawPrims(SC4DrawContextHandle, const uint32_t primType, const uint32_t startVertex,
+                                 const uint32_t primitiveCount, const uint32_t flags) {
+        Mix_(DrawCommandOp::DrawPrims, primType, startVertex, primitiveCount, flags);
+    }
+    void ReplayTarget::DrawPrimsIndexed(SC4DrawContextHandle, const uint8_t primType, const long indexStart,
+                                        const long indexCount) {
+        Mix_(DrawCommandOp::DrawPrimsIndexed, primType, indexStart, indexCount);
+    }
+    bool ReplayTarget::DrawBufferPrimitives(const DrawBufferHandle buffer, const uint32_t primType,
+                                            const uint32_t startVertex, const uint32_t vertexCount) {
+        Mix_(DrawCommandOp::DrawBufferPrimitives, buffer.id, primType, startVertex, vertexCount);
+        return buffer.id != 0;
+    }
+    bool ReplayTarget::DrawBufferIndexedPrimitives(const DrawBufferHandle buffer, const uint32_t primType,
+                                                   const uint32_t startVertex, const uint32_t vertexCount,
+                                                   const uint32_t startIndex, const uint32_t indexCount) {
+        Mix_(DrawCommandOp::DrawBufferIndexedPrimitives, buffer.id, primType, startVertex, vertexCount, startIndex,
+             indexCount);
+        return buffer.id != 0;
+    }
+
+    // Same as GetCommandPayloadSize / ValidateCommandList in DrawService.cpp.
+    constexpr size_t kInvalidPayloadSize = (std::numeric_limits<size_t>::max)();
+
+    size_t GetCommandPayloadSize(const DrawCommandOp op) {
+        using namespace DrawCommandPayload;
+        switch (op) {
+        case DrawCommandOp::SetHighlightColor: return sizeof(HighlightColor);
+        case DrawCommandOp::SetRenderStateHighlight: return sizeof(RenderStateHighlight);
+        case DrawCommandOp::SetModelTransform: return sizeof(ModelTransform);
+        case DrawCommandOp::SetShade: return sizeof(Color);
+        case DrawCommandOp::RenderMesh: return sizeof(Pointer);
+        case DrawCommandOp::RenderModelInstance: return sizeof(ModelInstance);
+        case DrawCommandOp::SetTexWrapModes:
+        case DrawCommandOp::SetTexFiltering: return sizeof(StagePair);
+        case DrawCommandOp::SetTexture:
+        case DrawCommandOp::EnableTextureStateFlag:
+        case DrawCommandOp::SetTexEnvMode:
+        case DrawCommandOp::SetTexCoord: return sizeof(StageValue);
+        case DrawCommandOp::SetTexColor: return sizeof(Color);
+        case DrawCommandOp::EnableBlendStateFlag:
+        case DrawCommandOp::EnableAlphaTestFlag:
+        case DrawCommandOp::EnableColorMaskFlag:
+        case DrawCommandOp::EnableCullFaceFlag:
+        case DrawCommandOp::EnableDepthMaskFlag:
+        case DrawCommandOp::EnableDepthTestFlag:
+        case DrawCommandOp::SetLighting: return sizeof(Flag);
+        case DrawCommandOp::SetBlendFunc: return sizeof(BlendFunc);
+        case DrawCommandOp::SetAlphaFunc: return sizeof(AlphaFunc);
+        case DrawCommandOp::SetDepthFunc:
+        case DrawCommandOp::SetDepthOffset: return sizeof(Value);
+        case DrawCommandOp::SetFog: return sizeof(Fog);
+        case DrawCommandOp::DrawBoundingBox: return sizeof(BoundingBox);
+        case DrawCommandOp::DrawPrims: return sizeof(Prims);
+        case DrawCommandOp::DrawPrimsIndexed: return sizeof(PrimsIndexed);
+        case DrawCommandOp::DrawBufferPrimitives: return sizeof(BufferPrims);
+        case DrawCommandOp::DrawBufferIndexedPrimitives: return sizeof(BufferPrimsIndexed);
+        case DrawCommandOp::ResetModelViewTransform:
+        case DrawCommandOp::ResetShade:
+        case DrawCommandOp::SetDefaultRenderState:
+        case DrawCommandOp::SetDefaultRenderStateUnilaterally:
+        case DrawCommandOp::SetTransparency:
+        case DrawCommandOp::ResetTransparency: return 0;
+        default:
+            return kInvalidPayloadSize;
+        }
+    }
+
+    bool ValidateCommandList(const uint8_t* bytes, const size_t size) {
+        size_t offset = 0;
+        while (offset < size) {
+            DrawCommandHeader header{};
+            if (size - offset < sizeof(header)) {
+                return false;
+            }
+            std::memcpy(&header, bytes + offset, sizeof(header));
+            const size_t payloadSize = GetCommandPayloadSize(header.op);
+            if (payloadSize == kInvalidPayloadSize || header.size != sizeof(header) + payloadSize ||
+                size - offset < header.size) {
+                return false;
+            }
+            offset += header.size;
+        }
+        return true;
+    }
+
+    template <typename T>
+    T ReadCommandPayload(const uint8_t* payload) {
+        T value;
+        std::memcpy(&value, payload, sizeof(T));
+        return value;
+    }
+
+    // Mirrors DrawService::ReplayCommandList_; the flag setters share one stand-in.
+    void ReplayCommandList(ReplayTarget& target, const SC4DrawContextHandle handle,
+                           const std::vector<uint8_t>& bytes) {
+        using namespace DrawCommandPayload;
+
+        size_t offset = 0;
+        while (offset < bytes.size()) {
+            DrawCommandHeader header{};
+            std::memcpy(&header, bytes.data() + offset, sizeof(header));
+            const uint8_t* payload = bytes.data() + offset + sizeof(header);
+            offset += header.size;
+
+            switch (header.op) {
+            case DrawCommandOp::SetHighlightColor: {
+                const auto p = ReadCommandPayload<HighlightColor>(payload);
+                target.SetHighlightColor(handle, p.highlightType, p.rgba[0], p.rgba[1], p.rgba[2], p.rgba[3]);
+                break;
+            }
+            case DrawCommandOp::SetRenderStateHighlight:
+                target.SetRenderStateHighlight(handle, ReadCommandPayload<RenderStateHighlight>(payload).highlightType);
+                break;
+            case DrawCommandOp::SetModelTransform: {
+                auto p = ReadCommandPayload<ModelTransform>(payload);
+                target.SetModelTransform(handle, p.matrix);
+                break;
+            }
+            case DrawCommandOp::ResetModelViewTransform:
+                target.ResetModelViewTransform(handle);
+                break;
+            case DrawCommandOp::SetShade:
+                target.SetShade(handle, ReadCommandPayload<Color>(payload).rgba);
+                break;
+            case DrawCommandOp::ResetShade:
+                target.ResetShade(handle);
+                break;
+            case DrawCommandOp::SetDefaultRenderState:
+                target.SetDefaultRenderState(handle);
+                break;
+            case DrawCommandOp::SetDefaultRenderStateUnilaterally:
+                target.SetDefaultRenderStateUnilaterally(handle);
+                break;
+            case DrawCommandOp::RenderMesh:
+                target.RenderMesh(handle, ReadCommandPayload<Pointer>(payload).ptr);
+                break;
+            case DrawCommandOp::RenderModelInstance: {
+                const auto p = ReadCommandPayload<ModelInstance>(payload);
+                target.RenderModelInstance(handle, p.modelCount, p.modelList, p.drawInfo, p.previewOnly != 0);
+                break;
+            }
+            case DrawCommandOp::SetTexWrapModes: {
+                const auto p = ReadCommandPayload<StagePair>(payload);
+                target.SetTexWrapModes(handle, p.first, p.second, p.stage);
+                break;
+            }
+            case DrawCommandOp::SetTexFiltering: {
+                const auto p = ReadCommandPayload<StagePair>(payload);
+                target.SetTexFiltering(handle, p.first, p.second, p.stage);
+                break;
+            }
+            case DrawCommandOp::SetTexture: {
+                const auto p = ReadCommandPayload<StageValue>(payload);
+                target.SetTexture(handle, p.value, p.stage);
+                break;
+            }
+            case DrawCommandOp::EnableTextureStateFlag: {
+                const auto p = ReadCommandPayload<StageValue>(payload);
+                target.EnableTextureStateFlag(handle, p.value != 0, p.stage);
+                break;
+            }
+            case DrawCommandOp::SetTexColor: {
+                const auto p = ReadCommandPayload<Color>(payload);
+                target.SetTexColor(handle, p.rgba[0], p.rgba[1], p.rgba[2], p.rgba[3]);
+                break;
+            }
+            case DrawCommandOp::SetTexEnvMode: {
+                const auto p = ReadCommandPayload<StageValue>(payload);
+                target.SetTexEnvMode(handle, p.value, p.stage);
+                break;
+            }
+            case DrawCommandOp::SetTexCoord: {
+                const auto p = ReadCommandPayload<StageValue>(payload);
+                target.SetTexCoord(handle, static_cast<int>(p.value), p.stage);
+                break;
+            }
+            case DrawCommandOp::EnableBlendStateFlag:
+            case DrawCommandOp::EnableAlphaTestFlag:
+            case DrawCommandOp::EnableColorMaskFlag:
+            case DrawCommandOp::EnableCullFaceFlag:
+            case DrawCommandOp::EnableDepthMaskFlag:
+            case DrawCommandOp::EnableDepthTestFlag:
+            case DrawCommandOp::SetLighting:
+                target.EnableFlag(header.op, handle, ReadCommandPayload<Flag>(payload).enabled != 0);
+                break;
+            case DrawCommandOp::SetBlendFunc: {
+                const auto p = ReadCommandPayload<BlendFunc>(payload);
+                target.SetBlendFunc(handle, p.srcFactor, p.dstFactor);
+                break;
+            }
+            case DrawCommandOp::SetAlphaFunc: {
+                const auto p = ReadCommandPayload<AlphaFunc>(payload);
+                target.SetAlphaFunc(handle, p.alphaFunc, p.alphaRef);
+                break;
+            }
+            case DrawCommandOp::SetDepthFunc:
+                target.SetDepthFunc(handle, ReadCommandPayload<Value>(payload).value);
+                break;
+            case DrawCommandOp::SetDepthOffset:
+                target.SetDepthOffset(handle, static_cast<int>(ReadCommandPayload<Value>(payload).value));
+                break;
+            case DrawCommandOp::SetTransparency:
+                target.SetTransparency(handle);
+                break;
+            case DrawCommandOp::ResetTransparency:
+                target.ResetTransparency(handle);
+                break;
+            case DrawCommandOp::SetFog: {
+                auto p = ReadCommandPayload<Fog>(payload);
+                target.SetFog(handle, p.enabled != 0, p.rgb, p.start, p.end);
+                break;
+            }
+            case DrawCommandOp::DrawBoundingBox: {
+                auto p = ReadCommandPayload<BoundingBox>(payload);
+                target.DrawBoundingBox(handle, p.bbox, p.rgba[0], p.rgba[1], p.rgba[2], p.rgba[3]);
+                break;
+            }
+            case DrawCommandOp::DrawPrims: {
+                const auto p = ReadCommandPayload<Prims>(payload);
+                target.DrawPrims(handle, p.primType, p.startVertex, p.primitiveCount, p.flags);
+                break;
+            }
+            case DrawCommandOp::DrawPrimsIndexed: {
+                const auto p = ReadCommandPayload<PrimsIndexed>(payload);
+                target.DrawPrimsIndexed(handle, static_cast<uint8_t>(p.primType), p.indexStart, p.indexCount);
+                break;
+            }
+            case DrawCommandOp::DrawBufferPrimitives: {
+                const auto p = ReadCommandPayload<BufferPrims>(payload);
+                target.DrawBufferPrimitives(DrawBufferHandle{p.bufferId}, p.primType, p.startVertex, p.vertexCount);
+                break;
+            }
+            case DrawCommandOp::DrawBufferIndexedPrimitives: {
+                const auto p = ReadCommandPayload<BufferPrimsIndexed>(payload);
+                target.DrawBufferIndexedPrimitives(DrawBufferHandle{p.bufferId}, p.primType, p.startVertex,
+                                                   p.vertexCount, p.startIndex, p.indexCount);
+                break;
+            }
+            default:
+                break;
+            }
+        }
+    }
+
+    // One object of a plugin overlay: where it is, what it looks like and how it is drawn.
+    struct SceneObject {
+        float transform[16];
+        float shade[4];
+        uint32_t texture;
+        uint32_t drawKind;      // 0 DrawPrims, 1 DrawPrimsIndexed, 2 pooled buffer, 3 pooled buffer indexed.
+        uint32_t bufferId;
+        uint32_t start;
+        uint32_t count;
+        bool translucent;
+    };
+
+    constexpr uint32_t kTriangleList = 4;
+    constexpr uint32_t kBlendSrcAlpha = 5;
+    constexpr uint32_t kBlendInvSrcAlpha = 6;
+    constexpr uint32_t kBlendOne = 2;
+    constexpr uint32_t kBlendZero = 1;
+
+    std::vector<SceneObject> MakeScene(const uint32_t count) {
+        std::mt19937 rng(12345);
+        std::uniform_real_distribution<float> position(-2000.0f, 2000.0f);
+        std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+        std::uniform_int_distribution<uint32_t> texture(1, 64);
+        std::uniform_int_distribution<uint32_t> kind(0, 3);
+        std::uniform_int_distribution<uint32_t> buffer(1, 16);
+        std::uniform_int_distribution<uint32_t> vertices(4, 2000);
+
+        std::vector<SceneObject> objects(count);
+        for (auto& object : objects) {
+            std::memset(object.transform, 0, sizeof(object.transform));
+            object.transform[0] = object.transform[5] = object.transform[10] = object.transform[15] = 1.0f;
+            object.transform[12] = position(rng);
+            object.transform[13] = unit(rng) * 50.0f;
+            object.transform[14] = position(rng);
+            object.shade[0] = unit(rng);
+            object.shade[1] = unit(rng);
+            object.shade[2] = unit(rng);
+            object.shade[3] = 1.0f;
+            object.texture = texture(rng);
+            object.drawKind = kind(rng);
+            object.bufferId = buffer(rng);
+            object.start = vertices(rng);
+            object.count = vertices(rng);
+            object.translucent = unit(rng) < 0.25f;
+        }
+        return objects;
+    }
+
+    // The pass prologue and the per-object commands, as both a recording and as direct calls.
+    void RecordScene(DrawCommandList& list, const std::vector<SceneObject>& objects) {
+        float fogColor[3] = {0.6f, 0.7f, 0.8f};
+        list.SetDefaultRenderState();
+        list.EnableDepthTestFlag(true);
+        list.EnableDepthMaskFlag(false);
+        list.SetDepthOffset(1);
+        list.SetFog(true, fogColor, 500.0f, 4000.0f);
+        list.SetTexFiltering(2, 2, 0);
+        list.SetTexWrapModes(1, 1, 0);
+        list.EnableTextureStateFlag(true, 0);
+        for (const auto& object : objects) {
+            list.SetModelTransform(object.transform);
+            list.SetShade(object.shade);
+            list.SetTexture(object.texture, 0);
+            list.EnableBlendStateFlag(object.translucent);
+            if (object.translucent) {
+                list.SetBlendFunc(kBlendSrcAlpha, kBlendInvSrcAlpha);
+            }
+            switch (object.drawKind) {
+            case 0:
+                list.DrawPrims(kTriangleList, object.start, object.count / 3, 0);
+                break;
+            case 1:
+                list.DrawPrimsIndexed(kTriangleList, static_cast<long>(object.start), static_cast<long>(object.count));
+                break;
+            case 2:
+                list.DrawBufferPrimitives(DrawBufferHandle{object.bufferId}, kTriangleList, object.start, object.count);
+                break;
+            default:
+                list.DrawBufferIndexedPrimitives(DrawBufferHandle{object.bufferId}, kTriangleList, object.start,
+                                                 object.count, 0, object.count);
+                break;
+            }
+        }
+        list.SetBlendFunc(kBlendOne, kBlendZero);
+        list.ResetShade();
+        list.ResetModelViewTransform();
+    }
+
+    void CallScene(ReplayTarget& target, const SC4DrawContextHandle handle, const std::vector<SceneObject>& objects) {
+        float fogColor[3] = {0.6f, 0.7f, 0.8f};
+        target.SetDefaultRenderState(handle);
+        target.EnableFlag(DrawCommandOp::EnableDepthTestFlag, handle, true);
+        target.EnableFlag(DrawCommandOp::EnableDepthMaskFlag, handle, false);
+        target.SetDepthOffset(handle, 1);
+        target.SetFog(handle, true, fogColor, 500.0f, 4000.0f);
+        target.SetTexFiltering(handle, 2, 2, 0);
+        target.SetTexWrapModes(handle, 1, 1, 0);
+        target.EnableTextureStateFlag(handle, true, 0);
+        for (const auto& object : objects) {
+            float transform[16];
+            std::memcpy(transform, object.transform, sizeof(transform));
+            target.SetModelTransform(handle, transform);
+            target.SetShade(handle, object.shade);
+            target.SetTexture(handle, object.texture, 0);
+            target.EnableFlag(DrawCommandOp::EnableBlendStateFlag, handle, object.translucent);
+            if (object.translucent) {
+                target.SetBlendFunc(handle, kBlendSrcAlpha, kBlendInvSrcAlpha);
+            }
+            switch (object.drawKind) {
+            case 0:
+                target.DrawPrims(handle, kTriangleList, object.start, object.count / 3, 0);
+                break;
+            case 1:
+                target.DrawPrimsIndexed(handle, kTriangleList, static_cast<long>(object.start),
+                                        static_cast<long>(object.count));
+                break;
+            case 2:
+                target.DrawBufferPrimitives(DrawBufferHandle{object.bufferId}, kTriangleList, object.start,
+                                            object.count);
+                break;
+            default:
+                target.DrawBufferIndexedPrimitives(DrawBufferHandle{object.bufferId}, kTriangleList, object.start,
+                                                   object.count, 0, object.count);
+                break;
+            }
+        }
+        target.SetBlendFunc(handle, kBlendOne, kBlendZero);
+        target.ResetShade(handle);
+        target.ResetModelViewTransform(handle);
+    }
+
+    std::vector<uint8_t> CopyList(const DrawCommandList& list) {
+        const auto* bytes = static_cast<const uint8_t*>(list.Data());
+        return {bytes, bytes + list.SizeBytes()};
+    }
+
+    void CheckMalformedLists(const DrawCommandList& list) {
+        const std::vector<uint8_t> bytes = CopyList(list);
+        Expect(ValidateCommandList(bytes.data(), bytes.size()), "validate: recorded list accepted");
+        Expect(ValidateCommandList(bytes.data(), 0), "validate: empty list accepted");
+        Expect(!ValidateCommandList(bytes.data(), 2), "validate: partial header rejected");
+
+        std::vector<uint8_t> badOp = bytes;
+        const auto invalid = static_cast<uint16_t>(0x7FFF);
+        std::memcpy(badOp.data(), &invalid, sizeof(invalid));
+        Expect(!ValidateCommandList(badOp.data(), badOp.size()), "validate: unknown opcode rejected");
+
+        DrawCommandList one;
+        one.DrawBufferIndexedPrimitives(DrawBufferHandle{3}, kTriangleList, 0, 3, 0, 3);
+        std::vector<uint8_t> badSize = CopyList(one);
+        Expect(!ValidateCommandList(badSize.data(), badSize.size() - 4), "validate: truncated payload rejected");
+        const auto shortSize =
+            static_cast<uint16_t>(sizeof(DrawCommandHeader) + sizeof(DrawCommandPayload::BufferPrims));
+        std::memcpy(badSize.data() + sizeof(uint16_t), &shortSize, sizeof(shortSize));
+        Expect(!ValidateCommandList(badSize.data(), badSize.size()), "validate: wrong payload size rejected");
+    }
+
+    template <typename Fn>
+    double TimeMs(const int iterations, Fn&& fn) {
+        const auto start = std::chrono::steady_clock::now();
+        for (int i = 0; i < iterations; ++i) {
+            fn();
+        }
+        const auto end = std::chrono::steady_clock::now();
+        return std::chrono::duration<double, std::milli>(end - start).count() / iterations;
+    }
+}
+
+int main(const int argc, char** argv) {
+    const uint32_t count = argc > 1 ? static_cast<uint32_t>(std::strtoul(argv[1], nullptr, 10)) : 2000;
+    const int iterations = argc > 2 ? std::atoi(argv[2]) : 500;
+    if (count == 0 || iterations <= 0) {
+        std::fprintf(stderr, "usage: %s [object-count] [iterations]\n", argv[0]);
+        return 2;
+    }
+
+    const std::vector<SceneObject> objects = MakeScene(count);
+    const SC4DrawContextHandle handle{reinterpret_cast<void*>(0x1000), 1};
+
+    DrawCommandList list;
+    RecordScene(list, objects);
+    const uint32_t commands = list.CommandCount();
+    const std::vector<uint8_t> bytes = CopyList(list);
+    CheckMalformedLists(list);
+
+    // Called through a pointer the compiler cannot see through, so neither path gets devirtualized or inlined.
+    ReplayTarget storage;
+    ReplayTarget* volatile opaqueTarget = &storage;
+    ReplayTarget* target = opaqueTarget;
+    CallScene(*target, handle, objects);
+    const uint64_t directHash = target->Hash();
+    const uint32_t directCalls = target->Calls();
+    target->ResetHash();
+    ReplayCommandList(*target, handle, bytes);
+    Expect(target->Calls() == commands, "replay: one call per recorded command");
+    Expect(directCalls == commands, "direct: one call per recorded command");
+    Expect(target->Hash() == directHash, "replay: same calls and arguments as direct calls");
+
+    const double recordMs = TimeMs(iterations, [&] {
+        list.Reset();
+        RecordScene(list, objects);
+    });
+    std::vector<uint8_t> submitted;
+    submitted.reserve(bytes.size());
+    volatile bool valid = true;
+    const double submitMs = TimeMs(iterations, [&] {
+        const auto* data = static_cast<const uint8_t*>(list.Data());
+        submitted.assign(data, data + list.SizeBytes());
+        valid = ValidateCommandList(submitted.data(), submitted.size());
+    });
+    const double replayMs = TimeMs(iterations, [&] {
+        ReplayCommandList(*target, handle, bytes);
+    });
+    const double directMs = TimeMs(iterations, [&] {
+        CallScene(*target, handle, objects);
+    });
+    Expect(valid, "submit: recorded list accepted");
+
+    std::printf("objects: %u, commands: %u, list: %u bytes (%.1f bytes/command), iterations: %d\n", count, commands,
+                static_cast<uint32_t>(bytes.size()), static_cast<double>(bytes.size()) / commands, iterations);
+    std::printf("\n%-24s %10s %12s\n", "test", "us/list", "ns/command");
+    const auto row = [commands](const char* name, const double ms) {
+        std::printf("%-24s %10.2f %12.2f\n", name, ms * 1.0e3, ms * 1.0e6 / commands);
+    };
+    row("record", recordMs);
+    row("submit (copy+validate)", submitMs);
+    row("replay", replayMs);
+    row("direct calls", directMs);
+    row("replay overhead", replayMs - directMs);
+
+    if (gFailures != 0) {
+        std::fprintf(stderr, "%d check(s) failed\n", gFailures);
+        return 1;
+    }
+    std::printf("\nall checks passed\n");
+    return 0;
+}
@@ -0,0 +1,388 @@
+// Offline analyzer for DrawService frame captures (cIGZDrawService::StartDrawCapture).
+//
+// Replays a .dstrace file against a counting stand-in for the draw context and reports per-opcode call counts,
+// how many state setter calls actually changed state versus repeated the current value, and draw counts per pass.
+// Redundancy is tracked with the same rules as the service's state filter: state is forgotten at every pass
+// boundary and after calls that rewrite render state wholesale.
+//
+// Usage: draw-trace-analyzer <capture.dstrace>
+
+#include "service/DrawTraceFormat.h"
+
+#include <algorithm>
+#include <array>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <map>
+#include <tuple>
+#include <vector>
+
+namespace {
+    constexpr size_t kPassCount = 6;
+    constexpr std::array<const char*, kPassCount> kPassNames{
+        "PreStatic", "Static", "PostStatic", "PreDynamic", "Dynamic", "PostDynamic",
+    };
+
+    const char* GetOpName(const uint16_t op) {
+        switch (op) {
+        case static_cast<uint16_t>(DrawCommandOp::SetHighlightColor): return "SetHighlightColor";
+        case static_cast<uint16_t>(DrawCommandOp::SetRenderStateHighlight): return "SetRenderStateHighlight";
+        case static_cast<uint16_t>(DrawCommandOp::SetModelTransform): return "SetModelTransform";
+        case static_cast<uint16_t>(DrawCommandOp::ResetModelViewTransform): return "ResetModelViewTransform";
+        case static_cast<uint16_t>(DrawCommandOp::SetShade): return "SetShade";
+        case static_cast<uint16_t>(DrawCommandOp::ResetShade): return "ResetShade";
+        case static_cast<uint16_t>(DrawCommandOp::SetDefaultRenderState): return "SetDefaultRenderState";
+        case static_cast<uint16_t>(DrawCommandOp::SetDefaultRenderStateUnilaterally):
+            return "SetDefaultRenderStateUnilaterally";
+        case static_cast<uint16_t>(DrawCommandOp::RenderMesh): return "RenderMesh";
+        case static_cast<uint16_t>(DrawCommandOp::RenderModelInstance): return "RenderModelInstance";
+        case static_cast<uint16_t>(DrawCommandOp::SetTexWrapModes): return "SetTexWrapModes";
+        case static_cast<uint16_t>(DrawCommandOp::SetTexFiltering): return "SetTexFiltering";
+        case static_cast<uint16_t>(DrawCommandOp::SetTexture): return "SetTexture";
+        case static_cast<uint16_t>(DrawCommandOp::EnableTextureStateFlag): return "EnableTextureStateFlag";
+        case static_cast<uint16_t>(DrawCommandOp::SetTexColor): return "SetTexColor";
+        case static_cast<uint16_t>(DrawCommandOp::SetTexEnvMode): return "SetTexEnvMode";
+        case static_cast<uint16_t>(DrawCommandOp::SetTexCoord): return "SetTexCoord";
+        case static_cast<uint16_t>(DrawCommandOp::EnableBlendStateFlag): return "EnableBlendStateFlag";
+        case static_cast<uint16_t>(DrawCommandOp::EnableAlphaTestFlag): return "EnableAlphaTestFlag";
+        case static_cast<uint16_t>(DrawCommandOp::EnableColorMaskFlag): return "EnableColorMaskFlag";
+        case static_cast<uint16_t>(DrawCommandOp::EnableCullFaceFlag): return "EnableCullFaceFlag";
+        case static_cast<uint16_t>(DrawCommandOp::EnableDepthMaskFlag): return "EnableDepthMaskFlag";
+        case static_cast<uint16_t>(DrawCommandOp::EnableDepthTestFlag): return "EnableDepthTestFlag";
+        case static_cast<uint16_t>(DrawCommandOp::SetBlendFunc): return "SetBlendFunc";
+        case static_cast<uint16_t>(DrawCommandOp::SetAlphaFunc): return "SetAlphaFunc";
+        case static_cast<uint16_t>(DrawCommandOp::SetDepthFunc): return "SetDepthFunc";
+        case static_cast<uint16_t>(DrawCommandOp::SetDepthOffset): return "SetDepthOffset";
+        case static_cast<uint16_t>(DrawCommandOp::SetTransparency): return "SetTransparency";
+        case static_cast<uint16_t>(DrawCommandOp::ResetTransparency): return "ResetTransparency";
+        case static_cast<uint16_t>(DrawCommandOp::SetLighting): return "SetLighting";
+        case static_cast<uint16_t>(DrawCommandOp::SetFog): return "SetFog";
+        case static_cast<uint16_t>(DrawCommandOp::DrawBoundingBox): return "DrawBoundingBox";
+        case static_cast<uint16_t>(DrawCommandOp::DrawPrims): return "DrawPrims";
+        case static_cast<uint16_t>(DrawCommandOp::DrawPrimsIndexed): return "DrawPrimsIndexed";
+        case static_cast<uint16_t>(DrawTraceOp::PassMarker): return "PassMarker";
+        case static_cast<uint16_t>(DrawTraceOp::SetModelTransformRaw): return "SetModelTransform(raw)";
+        case static_cast<uint16_t>(DrawTraceOp::SetModelViewTransformChanged): return "SetModelViewTransformChanged";
+        case static_cast<uint16_t>(DrawTraceOp::GetModelViewMatrix): return "GetModelViewMatrix";
+        case static_cast<uint16_t>(DrawTraceOp::SetModelShade): return "SetModelShade";
+        case static_cast<uint16_t>(DrawTraceOp::SetSelfLitShade): return "SetSelfLitShade";
+        case static_cast<uint16_t>(DrawTraceOp::SetRenderState): return "SetRenderState";
+        case static_cast<uint16_t>(DrawTraceOp::SetRenderStatePacked): return "SetRenderState(packed)";
+        case static_cast<uint16_t>(DrawTraceOp::SetEmulatedSecondStageRenderState):
+            return "SetEmulatedSecondStageRenderState";
+        case static_cast<uint16_t>(DrawTraceOp::SetTexCombiner): return "SetTexCombiner";
+        case static_cast<uint16_t>(DrawTraceOp::SetTexTransform4): return "SetTexTransform4";
+        case static_cast<uint16_t>(DrawTraceOp::ClearTexTransform): return "ClearTexTransform";
+        case static_cast<uint16_t>(DrawTraceOp::SetVertexBuffer): return "SetVertexBuffer";
+        case static_cast<uint16_t>(DrawTraceOp::SetIndexBuffer): return "SetIndexBuffer";
+        case static_cast<uint16_t>(DrawTraceOp::GetLighting): return "GetLighting";
+        case static_cast<uint16_t>(DrawTraceOp::SetCamera): return "SetCamera";
+        case static_cast<uint16_t>(DrawTraceOp::InitContext): return "InitContext";
+        case static_cast<uint16_t>(DrawTraceOp::ShutdownContext): return "ShutdownContext";
+        case static_cast<uint16_t>(DrawTraceOp::DrawPrimsIndexedRaw): return "DrawPrimsIndexedRaw";
+        case static_cast<uint16_t>(DrawTraceOp::DrawRect): return "DrawRect";
+        case static_cast<uint16_t>(DrawTraceOp::SetRenderStateHighlightMaterial):
+            return "SetRenderStateHighlight(material)";
+        default: return nullptr;
+        }
+    }
+
+    // Setters whose payload fully describes the resulting state, so repeating the payload is a no-op.
+    // Texture stage setters carry the stage as their last 32-bit field.
+    enum class OpKind { Other, State, StageState, Draw, Invalidate };
+
+    OpKind GetOpKind(const uint16_t op) {
+        switch (op) {
+        case static_cast<uint16_t>(DrawCommandOp::SetHighlightColor):
+        case static_cast<uint16_t>(DrawCommandOp::SetModelTransform):
+        case static_cast<uint16_t>(DrawCommandOp::SetShade):
+        case static_cast<uint16_t>(DrawCommandOp::SetTexColor):
+        case static_cast<uint16_t>(DrawCommandOp::EnableBlendStateFlag):
+        case static_cast<uint16_t>(DrawCommandOp::EnableAlphaTestFlag):
+        case static_cast<uint16_t>(DrawCommandOp::EnableColorMaskFlag):
+        case static_cast<uint16_t>(DrawCommandOp::EnableCullFaceFlag):
+        case static_cast<uint16_t>(DrawCommandOp::EnableDepthMaskFlag):
+        case static_cast<uint16_t>(DrawCommandOp::EnableDepthTestFlag):
+        case static_cast<uint16_t>(DrawCommandOp::SetBlendFunc):
+        case static_cast<uint16_t>(DrawCommandOp::SetAlphaFunc):
+        case static_cast<uint16_t>(DrawCommandOp::SetDepthFunc):
+        case static_cast<uint16_t>(DrawCommandOp::SetDepthOffset):
+        case static_cast<uint16_t>(DrawCommandOp::SetLighting):
+        case static_cast<uint16_t>(DrawCommandOp::SetFog):
+        case static_cast<uint16_t>(DrawTraceOp::SetModelTransformRaw):
+        case static_cast<uint16_t>(DrawTraceOp::SetIndexBuffer):
+        case static_cast<uint16_t>(DrawTraceOp::SetCamera):
+            return OpKind::State;
+        case static_cast<uint16_t>(DrawCommandOp::SetTexWrapModes):
+        case static_cast<uint16_t>(DrawCommandOp::SetTexFiltering):
+        case static_cast<uint16_t>(DrawCommandOp::SetTexture):
+        case static_cast<uint16_t>(DrawCommandOp::EnableTextureStateFlag):
+        case static_cast<uint16_t>(DrawCommandOp::SetTexEnvMode):
+        case static_cast<uint16_t>(DrawCommandOp::SetTexCoord):
+        case static_cast<uint16_t>(DrawTraceOp::SetTexTransform4):
+            return OpKind::StageState;
+        case static_cast<uint16_t>(DrawCommandOp::DrawPrims):
+        case static_cast<uint16_t>(DrawCommandOp::DrawPrimsIndexed):
+        case static_cast<uint16_t>(DrawTraceOp::DrawPrimsIndexedRaw):
+            return OpKind::Draw;
+        case static_cast<uint16_t>(DrawCommandOp::RenderMesh):
+        case static_cast<uint16_t>(DrawCommandOp::RenderModelInstance):
+        case static_cast<uint16_t>(DrawCommandOp::DrawBoundingBox):
+        case static_cast<uint16_t>(DrawTraceOp::DrawRect):
+            // Draw calls implemented by the game that also rewrite render state.
+            return OpKind::Invalidate;
+        case static_cast<uint16_t>(DrawCommandOp::SetRenderStateHighlight):
+        case static_cast<uint16_t>(DrawCommandOp::SetDefaultRenderState):
+        case static_cast<uint16_t>(DrawCommandOp::SetDefaultRenderStateUnilaterally):
+        case static_cast<uint16_t>(DrawCommandOp::SetTransparency):
+        case static_cast<uint16_t>(DrawCommandOp::ResetTransparency):
+        case static_cast<uint16_t>(DrawTraceOp::SetRenderState):
+        case static_cast<uint16_t>(DrawTraceOp::SetRenderStatePacked):
+        case static_cast<uint16_t>(DrawTraceOp::SetEmulatedSecondStageRenderState):
+        case static_cast<uint16_t>(DrawTraceOp::SetTexCombiner):
+        case static_cast<uint16_t>(DrawTraceOp::InitContext):
+        case static_cast<uint16_t>(DrawTraceOp::ShutdownContext):
+        case static_cast<uint16_t>(DrawTraceOp::SetRenderStateHighlightMaterial):
+            return OpKind::Invalidate;
+        default:
+            return OpKind::Other;
+        }
+    }
+
+    bool IsDrawOp(const uint16_t op) {
+        return GetOpKind(op) == OpKind::Draw ||
+               op == static_cast<uint16_t>(DrawCommandOp::RenderMesh) ||
+               op == static_cast<uint16_t>(DrawCommandOp::RenderModelInstance) ||
+               op == static_cast<uint16_t>(DrawCommandOp::DrawBoundingBox) ||
+               op == static_cast<uint16_t>(DrawTraceOp::DrawRect);
+    }
+
+    struct OpStats {
+        uint64_t calls = 0;
+        uint64_t changes = 0;
+        uint64_t redundant = 0;
+    };
+
+    struct PassStats {
+        uint64_t calls = 0;
+        uint64_t draws = 0;
+        uint64_t redundant = 0;
+        uint64_t gameTimeUs = 0;
+        uint64_t runs = 0;
+    };
+
+    // Stand-in draw context: remembers the last payload of every state slot and counts what a real device would
+    // have been asked to do.
+    class CountingDrawContext {
+    public:
+        void Execute(const DrawTraceRecordHeader& header, const uint8_t* payload, const size_t payloadSize) {
+            auto& op = opStats_[header.op];
+            ++op.calls;
+            if (currentPass_ < kPassCount) {
+                ++passStats_[currentPass_].calls;
+            }
+
+            if (IsDrawOp(header.op) && currentPass_ < kPassCount) {
+                ++passStats_[currentPass_].draws;
+            }
+
+            switch (GetOpKind(header.op)) {
+            case OpKind::State:
+            case OpKind::StageState: {
+                int32_t stage = -1;
+                if (GetOpKind(header.op) == OpKind::StageState && payloadSize >= sizeof(int32_t)) {
+                    std::memcpy(&stage, payload + payloadSize - sizeof(int32_t), sizeof(stage));
+                }
+                auto& slot = state_[{header.context, header.op, stage}];
+                if (slot.size() == payloadSize && std::equal(slot.begin(), slot.end(), payload)) {
+                    ++op.redundant;
+                    if (currentPass_ < kPassCount) {
+                        ++passStats_[currentPass_].redundant;
+                    }
+                }
+                else {
+                    ++op.changes;
+                    slot.assign(payload, payload + payloadSize);
+                }
+                break;
+            }
+            case OpKind::Invalidate:
+                InvalidateContext_(header.context);
+                break;
+            default:
+                break;
+            }
+        }
+
+        void OnPassMarker(const DrawTracePayload::PassMarker& marker, const uint32_t timestampUs) {
+            const size_t pass = marker.pass;
+            if (pass >= kPassCount) {
+                return;
+            }
+
+            switch (marker.phase) {
+            case DrawTracePassPhase::Begin:
+                if (pass <= lastPass_) {
+                    ++frameCount_;
+                }
+                lastPass_ = pass;
+                currentPass_ = pass;
+                state_.clear();
+                break;
+            case DrawTracePassPhase::Game:
+                gameStartUs_ = timestampUs;
+                break;
+            case DrawTracePassPhase::End:
+                passStats_[pass].gameTimeUs += timestampUs - gameStartUs_;
+                ++passStats_[pass].runs;
+                state_.clear();
+                break;
+            case DrawTracePassPhase::Done:
+                currentPass_ = kPassCount;
+                break;
+            }
+        }
+
+        [[nodiscard]] uint64_t GetFrameCount() const { return frameCount_; }
+        [[nodiscard]] const std::map<uint16_t, OpStats>& GetOpStats() const { return opStats_; }
+        [[nodiscard]] const std::array<PassStats, kPassCount>& GetPassStats() const { return passStats_; }
+
+    private:
+        void InvalidateContext_(const uint32_t context) {
+            std::erase_if(state_, [context](const auto& entry) { return std::get<0>(entry.first) == context; });
+        }
+
+        std::map<std::tuple<uint32_t, uint16_t, int32_t>, std::vector<uint8_t>> state_{};
+        std::map<uint16_t, OpStats> opStats_{};
+        std::array<PassStats, kPassCount> passStats_{};
+        size_t currentPass_ = kPassCount;
+        size_t lastPass_ = kPassCount;
+        uint64_t frameCount_ = 0;
+        uint32_t gameStartUs_ = 0;
+    };
+
+    bool ReadFile(const char* path, std::vector<uint8_t>& bytes) {
+        std::ifstream file(path, std::ios::binary | std::ios::ate);
+        if (!file) {
+            return false;
+        }
+        const auto size = static_cast<size_t>(file.tellg());
+        bytes.resize(size);
+        file.seekg(0);
+        return static_cast<bool>(file.read(reinterpret_cast<char*>(bytes.data()), static_cast<std::streamsize>(size)));
+    }
+
+    double Percent(const uint64_t part, const uint64_t total) {
+        return total ? 100.0 * static_cast<double>(part) / static_cast<double>(total) : 0.0;
+    }
+}
+
+int main(const int argc, char** argv) {
+    if (argc != 2) {
+        std::fprintf(stderr, "usage: %s <capture.dstrace>\n", argv[0]);
+        return 2;
+    }
+
+    std::vector<uint8_t> bytes;
+    if (!ReadFile(argv[1], bytes)) {
+        std::fprintf(stderr, "error: cannot read %s\n", argv[1]);
+        return 1;
+    }
+
+    DrawTraceFileHeader fileHeader{};
+    if (bytes.size() < sizeof(fileHeader)) {
+        std::fprintf(stderr, "error: %s is too small to be a draw trace\n", argv[1]);
+        return 1;
+    }
+    std::memcpy(&fileHeader, bytes.data(), sizeof(fileHeader));
+    if (fileHeader.magic != kDrawTraceMagic || fileHeader.version != kDrawTraceVersion) {
+        std::fprintf(stderr, "error: %s is not a version %u draw trace\n", argv[1], kDrawTraceVersion);
+        return 1;
+    }
+
+    CountingDrawContext context;
+    uint64_t recordCount = 0;
+    uint32_t firstTimestampUs = 0;
+    uint32_t lastTimestampUs = 0;
+    size_t offset = sizeof(fileHeader);
+    while (offset + sizeof(DrawTraceRecordHeader) <= bytes.size()) {
+        DrawTraceRecordHeader header{};
+        std::memcpy(&header, bytes.data() + offset, sizeof(header));
+        if (header.size < sizeof(header) || offset + header.size > bytes.size()) {
+            std::fprintf(stderr, "warning: truncated record at offset %zu, stopping\n", offset);
+            break;
+        }
+
+        const uint8_t* payload = bytes.data() + offset + sizeof(header);
+        const size_t payloadSize = header.size - sizeof(header);
+        if (recordCount++ == 0) {
+            firstTimestampUs = header.timestampUs;
+        }
+        lastTimestampUs = header.timestampUs;
+
+        if (header.op == static_cast<uint16_t>(DrawTraceOp::PassMarker)) {
+            if (payloadSize >= sizeof(DrawTracePayload::PassMarker)) {
+                DrawTracePayload::PassMarker marker{};
+                std::memcpy(&marker, payload, sizeof(marker));
+                context.OnPassMarker(marker, header.timestampUs);
+            }
+        }
+        else {
+            context.Execute(header, payload, payloadSize);
+        }
+        offset += header.size;
+    }
+
+    const uint64_t frames = std::max<uint64_t>(context.GetFrameCount(), 1);
+    const double durationMs = static_cast<double>(lastTimestampUs - firstTimestampUs) / 1000.0;
+    std::printf("%s: %llu records, %llu frames, %.1f ms (pointer size %u)\n\n", argv[1],
+                static_cast<unsigned long long>(recordCount), static_cast<unsigned long long>(context.GetFrameCount()),
+                durationMs, fileHeader.pointerSize);
+
+    std::vector<std::pair<uint16_t, OpStats>> ops;
+    for (const auto& [op, stats] : context.GetOpStats()) {
+        ops.emplace_back(op, stats);
+    }
+    std::ranges::sort(ops, [](const auto& a, const auto& b) { return a.second.calls > b.second.calls; });
+
+    uint64_t totalChanges = 0;
+    uint64_t totalRedundant = 0;
+    std::printf("%-36s %12s %10s %12s %12s %9s\n", "call", "total", "per frame", "changes", "redundant", "redund%");
+    for (const auto& [op, stats] : ops) {
+        const char* name = GetOpName(op);
+        char unknownName[32];
+        if (!name) {
+            std::snprintf(unknownName, sizeof(unknownName), "op 0x%04X", op);
+            name = unknownName;
+        }
+        std::printf("%-36s %12llu %10.1f", name, static_cast<unsigned long long>(stats.calls),
+                    static_cast<double>(stats.calls) / static_cast<double>(frames));
+        if (stats.changes + stats.redundant > 0) {
+            std::printf(" %12llu %12llu %8.1f%%", static_cast<unsigned long long>(stats.changes),
+                        static_cast<unsigned long long>(stats.redundant),
+                        Percent(stats.redundant, stats.changes + stats.redundant));
+        }
+        std::printf("\n");
+        totalChanges += stats.changes;
+        totalRedundant += stats.redundant;
+    }
+    std::printf("\nstate setters: %llu changes, %llu redundant (%.1f%%)\n\n",
+                static_cast<unsigned long long>(totalChanges), static_cast<unsigned long long>(totalRedundant),
+                Percent(totalRedundant, totalChanges + totalRedundant));
+
+    std::printf("%-12s %12s %12s %12s %14s\n", "pass", "calls/frame", "draws/frame", "redundant", "game ms/run");
+    const auto& passes = context.GetPassStats();
+    for (size_t i = 0; i < kPassCount; ++i) {
+        const auto& pass = passes[i];
+        if (pass.runs == 0 && pass.calls == 0) {
+            continue;
+        }
+        std::printf("%-12s %12.1f %12.1f %12llu %14.3f\n", kPassNames[i],
+                    static_cast<double>(pass.calls) / static_cast<double>(frames),
+                    static_cast<double>(pass.draws) / static_cast<double>(frames),
+                    static_cast<unsigned long long>(pass.redundant),
+                    pass.runs ? static_cast<double>(pass.gameTimeUs) / 1000.0 / static_cast<double>(pass.runs) : 0.0);
+    }
+    return 0;
+}
@@ -0,0 +1,192 @@
+// Correctness check and benchmark for the batch frustum tests in src/public/ViewFrustum.h.
+//
+// Checks both frustum builders against hand-placed boxes, cross-checks CullBoxes/CullSpheres against the scalar
+// per-object tests on random data, then times culling 100k boxes and spheres. Exits non-zero on any mismatch.
+//
+// Usage: frustum-cull-bench [object-count] [iterations]
+
+#include "public/ViewFrustum.h"
+
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <vector>
+
+namespace {
+    int gFailures = 0;
+
+    void Expect(const bool condition, const char* what) {
+        if (!condition) {
+            std::fprintf(stderr, "FAIL: %s\n", what);
+            ++gFailures;
+        }
+    }
+
+    CullBox BoxAt(const float x, const float y, const float z, const float halfSize) {
+        return {x - halfSize, y - halfSize, z - halfSize, x + halfSize, y + halfSize, z + halfSize};
+    }
+
+    // Left-handed D3D perspective looking down +Z from the origin; row-vector convention.
+    ViewFrustum MakePerspectiveFrustum() {
+        constexpr float fovY = 60.0f * 3.14159265f / 180.0f;
+        constexpr float aspect = 16.0f / 9.0f;
+        constexpr float zn = 1.0f;
+        constexpr float zf = 1000.0f;
+        const float ys = 1.0f / std::tan(fovY * 0.5f);
+        const float xs = ys / aspect;
+        const float q = zf / (zf - zn);
+        const float m[16] = {
+            xs, 0.0f, 0.0f, 0.0f,
+            0.0f, ys, 0.0f, 0.0f,
+            0.0f, 0.0f, q, 1.0f,
+            0.0f, 0.0f, -zn * q, 0.0f,
+        };
+        ViewFrustum frustum{};
+        BuildViewFrustumFromMatrix(m, frustum);
+        return frustum;
+    }
+
+    // Orthographic camera 100 units above the ground looking straight down, like a zoomed-in city view.
+    bool MakeOrthoRayFrustum(ViewFrustum& frustum) {
+        const float origins[4][3] = {
+            {-50.0f, 100.0f, 30.0f}, {50.0f, 100.0f, 30.0f}, {50.0f, 100.0f, -30.0f}, {-50.0f, 100.0f, -30.0f}
+        };
+        const float directions[4][3] = {
+            {0.0f, -1.0f, 0.0f}, {0.0f, -1.0f, 0.0f}, {0.0f, -1.0f, 0.0f}, {0.0f, -1.0f, 0.0f}
+        };
+        const float centerOrigin[3] = {0.0f, 100.0f, 0.0f};
+        const float centerDirection[3] = {0.0f, -1.0f, 0.0f};
+        return BuildViewFrustumFromRays(origins, directions, centerOrigin, centerDirection, frustum);
+    }
+
+    void CheckKnownCases() {
+        const ViewFrustum perspective = MakePerspectiveFrustum();
+        Expect(TestViewFrustumBox(perspective, BoxAt(0.0f, 0.0f, 10.0f, 1.0f)), "perspective: box ahead visible");
+        Expect(!TestViewFrustumBox(perspective, BoxAt(0.0f, 0.0f, -10.0f, 1.0f)), "perspective: box behind culled");
+        Expect(!TestViewFrustumBox(perspective, BoxAt(100.0f, 0.0f, 10.0f, 1.0f)), "perspective: box right culled");
+        Expect(!TestViewFrustumBox(perspective, BoxAt(0.0f, 100.0f, 10.0f, 1.0f)), "perspective: box above culled");
+        Expect(!TestViewFrustumBox(perspective, BoxAt(0.0f, 0.0f, 2000.0f, 1.0f)), "perspective: box past far culled");
+        Expect(TestViewFrustumBox(perspective, BoxAt(0.0f, 0.0f, 1000.0f, 5.0f)), "perspective: box on far visible");
+        Expect(TestViewFrustumSphere(perspective, {0.0f, 0.0f, 0.5f, 1.0f}), "perspective: sphere on near visible");
+        Expect(!TestViewFrustumSphere(perspective, {-100.0f, 0.0f, 10.0f, 1.0f}), "perspective: sphere left culled");
+
+        ViewFrustum ortho{};
+        Expect(MakeOrthoRayFrustum(ortho), "ortho: rays build a frustum");
+        Expect(TestViewFrustumBox(ortho, BoxAt(0.0f, 0.0f, 0.0f, 1.0f)), "ortho: ground box visible");
+        Expect(TestViewFrustumBox(ortho, BoxAt(0.0f, -5000.0f, 0.0f, 1.0f)), "ortho: far plane open");
+        Expect(TestViewFrustumBox(ortho, BoxAt(50.5f, 0.0f, 0.0f, 1.0f)), "ortho: box straddling edge visible");
+        Expect(!TestViewFrustumBox(ortho, BoxAt(60.0f, 0.0f, 0.0f, 1.0f)), "ortho: box right culled");
+        Expect(!TestViewFrustumBox(ortho, BoxAt(0.0f, 0.0f, -40.0f, 1.0f)), "ortho: box bottom culled");
+        Expect(!TestViewFrustumBox(ortho, BoxAt(0.0f, 200.0f, 0.0f, 1.0f)), "ortho: box behind camera culled");
+
+        const float zero[4][3] = {};
+        const float center[3] = {0.0f, 0.0f, 0.0f};
+        ViewFrustum degenerate{};
+        Expect(!BuildViewFrustumFromRays(zero, zero, center, center, degenerate), "rays: zero directions rejected");
+
+        // Bit layout across a partial trailing word.
+        std::vector<CullBox> boxes;
+        for (int i = 0; i < 70; ++i) {
+            boxes.push_back(BoxAt(0.0f, 0.0f, i % 3 == 0 ? -10.0f : 10.0f, 1.0f));
+        }
+        std::vector<uint32_t> bits(ViewFrustumBitWords(static_cast<uint32_t>(boxes.size())));
+        const uint32_t visible = CullBoxes(perspective, boxes.data(), static_cast<uint32_t>(boxes.size()),
+                                           bits.data());
+        Expect(visible == 46, "batch: visible count over 70 boxes");
+        bool layoutOk = true;
+        for (uint32_t i = 0; i < boxes.size(); ++i) {
+            layoutOk &= IsViewFrustumBitSet(bits.data(), i) == (i % 3 != 0);
+        }
+        Expect(layoutOk, "batch: bit i matches box i");
+        Expect((bits[2] >> 6) == 0, "batch: bits past count are clear");
+    }
+
+    template <typename Fn>
+    double TimeMs(const int iterations, Fn&& fn) {
+        const auto start = std::chrono::steady_clock::now();
+        for (int i = 0; i < iterations; ++i) {
+            fn();
+        }
+        const auto end = std::chrono::steady_clock::now();
+        return std::chrono::duration<double, std::milli>(end - start).count() / iterations;
+    }
+}
+
+int main(const int argc, char** argv) {
+    const uint32_t count = argc > 1 ? static_cast<uint32_t>(std::strtoul(argv[1], nullptr, 10)) : 100000;
+    const int iterations = argc > 2 ? std::atoi(argv[2]) : 200;
+    if (count == 0 || iterations <= 0) {
+        std::fprintf(stderr, "usage: %s [object-count] [iterations]\n", argv[0]);
+        return 2;
+    }
+
+    CheckKnownCases();
+
+    std::mt19937 rng(12345);
+    std::uniform_real_distribution<float> position(-1500.0f, 1500.0f);
+    std::uniform_real_distribution<float> size(0.5f, 20.0f);
+    std::vector<CullBox> boxes(count);
+    std::vector<CullSphere> spheres(count);
+    for (uint32_t i = 0; i < count; ++i) {
+        const float x = position(rng);
+        const float y = position(rng);
+        const float z = position(rng);
+        const float s = size(rng);
+        boxes[i] = BoxAt(x, y, z, s);
+        spheres[i] = {x, y, z, s};
+    }
+
+    const ViewFrustum frustum = MakePerspectiveFrustum();
+    std::vector<uint32_t> bits(ViewFrustumBitWords(count));
+    std::vector<uint8_t> reference(count);
+
+    const uint32_t visibleBoxes = CullBoxes(frustum, boxes.data(), count, bits.data());
+    uint32_t mismatches = 0;
+    for (uint32_t i = 0; i < count; ++i) {
+        mismatches += IsViewFrustumBitSet(bits.data(), i) != TestViewFrustumBox(frustum, boxes[i]);
+    }
+    Expect(mismatches == 0, "random: CullBoxes matches TestViewFrustumBox");
+
+    const uint32_t visibleSpheres = CullSpheres(frustum, spheres.data(), count, bits.data());
+    mismatches = 0;
+    for (uint32_t i = 0; i < count; ++i) {
+        mismatches += IsViewFrustumBitSet(bits.data(), i) != TestViewFrustumSphere(frustum, spheres[i]);
+    }
+    Expect(mismatches == 0, "random: CullSpheres matches TestViewFrustumSphere");
+
+    volatile uint32_t sink = 0;
+    const double batchBoxMs = TimeMs(iterations, [&] {
+        sink = CullBoxes(frustum, boxes.data(), count, bits.data());
+    });
+    const double scalarBoxMs = TimeMs(iterations, [&] {
+        uint32_t visible = 0;
+        for (uint32_t i = 0; i < count; ++i) {
+            reference[i] = TestViewFrustumBox(frustum, boxes[i]) ? 1 : 0;
+            visible += reference[i];
+        }
+        sink = visible;
+    });
+    const double batchSphereMs = TimeMs(iterations, [&] {
+        sink = CullSpheres(frustum, spheres.data(), count, bits.data());
+    });
+
+    std::printf("objects: %u, iterations: %d\n", count, iterations);
+    std::printf("boxes visible:   %u (%.1f%%)\n", visibleBoxes, 100.0 * visibleBoxes / count);
+    std::printf("spheres visible: %u (%.1f%%)\n", visibleSpheres, 100.0 * visibleSpheres / count);
+    std::printf("\n%-24s %10s %12s\n", "test", "ms/batch", "ns/object");
+    const auto row = [count](const char* name, const double ms) {
+        std::printf("%-24s %10.3f %12.2f\n", name, ms, ms * 1.0e6 / count);
+    };
+    row("CullBoxes", batchBoxMs);
+    row("TestViewFrustumBox loop", scalarBoxMs);
+    row("CullSpheres", batchSphereMs);
+
+    if (gFailures != 0) {
+        std::fprintf(stderr, "%d check(s) failed\n", gFailures);
+        return 1;
+    }
+    std::printf("\nall checks passed\n");
+    return 0;
+}
@@ -0,0 +1,264 @@
+// Correctness check and benchmark for the shared heightfield behind cIGZTerrainService.
+//
+// Sampling: fills a heightfield the size of a large city (257 x 257 vertices) and checks that SampleHeightfieldBatch
+// returns exactly what SampleHeightfield does, for xyz triples and for a larger vertex struct, including points off
+// the map, and that both agree with the picking grid's bilinear surface. Then times the batch, the scalar helper and
+// the old path of four virtual GetAltitudeAtNearestGrid-style calls per point.
+//
+// Publishing: one writer publishes versions whose heights all equal the version number while reader threads acquire,
+// scan and release views. Exits non-zero if a reader ever sees a mixed or changing view.
+//
+// Usage: heightfield-bench [points] [seconds-of-stress]
+
+#include "public/TerrainHeightfield.h"
+#include "service/HeightfieldPublisher.h"
+#include "service/TerrainHeightGrid.h"
+
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <thread>
+#include <vector>
+
+namespace {
+    constexpr uint32_t kCells = 256;
+    constexpr float kSpacing = 16.0f;
+    constexpr float kMapSize = kCells * kSpacing;
+
+    struct DecalPoint {
+        float x;
+        float y;
+        float z;
+        bool hardCorner;
+    };
+
+    float Terrain(const float x, const float z) {
+        return 250.0f + 60.0f * std::sin(x * 0.004f) * std::cos(z * 0.003f) + 25.0f * std::sin((x + z) * 0.011f);
+    }
+
+    // Stand-in for cISTETerrain: one virtual call per vertex height, as SampleTerrainHeight used to make.
+    class VirtualTerrain {
+    public:
+        explicit VirtualTerrain(const TerrainHeightfieldView& view) : view_(view) {}
+        virtual ~VirtualTerrain() = default;
+        virtual float GetAltitudeAtNearestGrid(const float x, const float z) {
+            return SampleHeightfieldNearest(view_, x, z);
+        }
+
+    private:
+        TerrainHeightfieldView view_;
+    };
+
+    float SampleVirtual(VirtualTerrain& terrain, const float x, const float z) {
+        const float x0 = std::floor(x / kSpacing) * kSpacing;
+        const float z0 = std::floor(z / kSpacing) * kSpacing;
+        const float tx = std::fmin(std::fmax((x - x0) / kSpacing, 0.0f), 1.0f);
+        const float tz = std::fmin(std::fmax((z - z0) / kSpacing, 0.0f), 1.0f);
+        const float h00 = terrain.GetAltitudeAtNearestGrid(x0, z0);
+        const float h10 = terrain.GetAltitudeAtNearestGrid(x0 + kSpacing, z0);
+        const float h01 = terrain.GetAltitudeAtNearestGrid(x0, z0 + kSpacing);
+        const float h11 = terrain.GetAltitudeAtNearestGrid(x0 + kSpacing, z0 + kSpacing);
+        const float hx0 = h00 + (h10 - h00) * tx;
+        const float hx1 = h01 + (h11 - h01) * tx;
+        return hx0 + (hx1 - hx0) * tz;
+    }
+
+    bool Publish(HeightfieldPublisher& publisher, const std::vector<float>& heights) {
+        uint32_t rowStride = 0;
+        float* out = publisher.BeginPublish(kCells + 1, kCells + 1, kSpacing, rowStride);
+        if (!out) {
+            return false;
+        }
+        for (uint32_t z = 0; z <= kCells; ++z) {
+            std::copy_n(heights.data() + static_cast<size_t>(z) * (kCells + 1), kCells + 1,
+                        out + static_cast<size_t>(z) * rowStride);
+        }
+        publisher.EndPublish();
+        return true;
+    }
+
+    template <typename Fn>
+    double NanosecondsPerPoint(const size_t points, const int iterations, Fn&& fn) {
+        const auto start = std::chrono::steady_clock::now();
+        for (int it = 0; it < iterations; ++it) {
+            fn();
+        }
+        const auto end = std::chrono::steady_clock::now();
+        return std::chrono::duration<double, std::nano>(end - start).count() /
+               (static_cast<double>(points) * iterations);
+    }
+
+    bool CheckSampling(const uint32_t count) {
+        std::vector<float> heights(static_cast<size_t>(kCells + 1) * (kCells + 1));
+        TerrainHeightGrid grid;
+        grid.Reset(kCells, kCells);
+        for (uint32_t z = 0; z <= kCells; ++z) {
+            for (uint32_t x = 0; x <= kCells; ++x) {
+                const float h = Terrain(x * kSpacing, z * kSpacing);
+                heights[static_cast<size_t>(z) * (kCells + 1) + x] = h;
+                grid.Row(z)[x] = h;
+            }
+        }
+        HeightfieldPublisher publisher;
+        TerrainHeightfieldView view{};
+        if (!Publish(publisher, heights) || !publisher.Acquire(view)) {
+            std::fprintf(stderr, "FAIL could not publish the test heightfield\n");
+            return false;
+        }
+        const bool aligned = reinterpret_cast<uintptr_t>(view.heights) % 64 == 0 && view.rowStride % 16 == 0;
+
+        std::mt19937 rng(7);
+        std::uniform_real_distribution<float> coordinate(-64.0f, kMapSize + 64.0f);
+        std::vector<float> xyz(static_cast<size_t>(count) * 3);
+        std::vector<DecalPoint> decal(count);
+        for (uint32_t i = 0; i < count; ++i) {
+            const float x = i < 8 ? static_cast<float>(i % 2) * kMapSize : coordinate(rng);
+            const float z = i < 8 ? static_cast<float>(i / 4) * kMapSize : coordinate(rng);
+            xyz[i * 3] = x;
+            xyz[i * 3 + 2] = z;
+            decal[i] = {x, 0.0f, z, false};
+        }
+
+        SampleHeightfieldBatch(view, xyz.data(), count, sizeof(float) * 3);
+        SampleHeightfieldBatch(view, &decal[0].x, count, sizeof(DecalPoint), 0.05f);
+        uint32_t mismatches = 0;
+        double maxGridError = 0.0;
+        for (uint32_t i = 0; i < count; ++i) {
+            const float x = xyz[i * 3];
+            const float z = xyz[i * 3 + 2];
+            const float scalar = SampleHeightfield(view, x, z);
+            mismatches += xyz[i * 3 + 1] != scalar ? 1 : 0;
+            mismatches += decal[i].y != scalar + 0.05f ? 1 : 0;
+            maxGridError = std::fmax(maxGridError, std::fabs(scalar - grid.SampleHeight(x, z)));
+        }
+
+        VirtualTerrain terrain(view);
+        volatile float sink = 0.0f;
+        const int iterations = 50;
+        const double batchNs = NanosecondsPerPoint(count, iterations, [&] {
+            SampleHeightfieldBatch(view, xyz.data(), count, sizeof(float) * 3);
+            sink = xyz[1];
+        });
+        const double scalarNs = NanosecondsPerPoint(count, iterations, [&] {
+            for (uint32_t i = 0; i < count; ++i) {
+                xyz[i * 3 + 1] = SampleHeightfield(view, xyz[i * 3], xyz[i * 3 + 2]);
+            }
+            sink = xyz[1];
+        });
+        const double virtualNs = NanosecondsPerPoint(count, iterations, [&] {
+            for (uint32_t i = 0; i < count; ++i) {
+                xyz[i * 3 + 1] = SampleVirtual(terrain, xyz[i * 3], xyz[i * 3 + 2]);
+            }
+            sink = xyz[1];
+        });
+        publisher.Release(view);
+
+        std::printf("sampling: %u points, %s, batch %s\n", count, aligned ? "rows 64-byte aligned" : "ROWS MISALIGNED",
+                    TERRAIN_HEIGHTFIELD_SSE2 ? "SSE2" : "scalar");
+        std::printf("  batch vs scalar mismatches %u, max difference to picking grid %.6f\n", mismatches,
+                    maxGridError);
+        std::printf("  ns/point: batch %.2f   scalar %.2f   4 virtual calls %.2f\n", batchNs, scalarNs, virtualNs);
+        const bool ok = aligned && mismatches == 0 && maxGridError <= 1.0e-3;
+        if (!ok) {
+            std::fprintf(stderr, "FAIL sampling: batch and scalar disagree or the layout is wrong\n");
+        }
+        return ok;
+    }
+
+    bool StressPublisher(const double seconds) {
+        HeightfieldPublisher publisher;
+        std::atomic<bool> stop{false};
+        std::atomic<uint64_t> torn{0};
+        std::atomic<uint64_t> acquired{0};
+        std::atomic<uint64_t> held{0};
+
+        std::vector<std::thread> readers;
+        const unsigned readerCount = (std::max)(2u, std::thread::hardware_concurrency() - 1);
+        for (unsigned r = 0; r < readerCount; ++r) {
+            readers.emplace_back([&, r] {
+                std::vector<TerrainHeightfieldView> pinned;
+                uint64_t count = 0;
+                while (!stop.load(std::memory_order_relaxed)) {
+                    TerrainHeightfieldView view{};
+                    if (!publisher.Acquire(view)) {
+                        continue;
+                    }
+                    ++count;
+                    const auto expected = static_cast<float>(view.version);
+                    for (uint32_t z = 0; z < view.verticesZ; z += 17) {
+                        for (uint32_t x = 0; x < view.verticesX; ++x) {
+                            torn += GetHeightfieldVertex(view, x, z) != expected ? 1 : 0;
+                        }
+                    }
+                    // Some readers keep an old view pinned for a while, forcing the writer onto other slots.
+                    if (r % 2 == 0 && pinned.size() < 2) {
+                        pinned.push_back(view);
+                        continue;
+                    }
+                    publisher.Release(view);
+                    for (const auto& old : pinned) {
+                        const auto oldExpected = static_cast<float>(old.version);
+                        torn += GetHeightfieldVertex(old, old.verticesX - 1, old.verticesZ - 1) != oldExpected ? 1 : 0;
+                        publisher.Release(old);
+                    }
+                    held += pinned.size();
+                    pinned.clear();
+                }
+                for (const auto& old : pinned) {
+                    publisher.Release(old);
+                }
+                acquired += count;
+            });
+        }
+
+        uint64_t published = 0;
+        uint64_t skipped = 0;
+        std::vector<float> heights(static_cast<size_t>(kCells + 1) * (kCells + 1));
+        const auto deadline = std::chrono::steady_clock::now() + std::chrono::duration<double>(seconds);
+        while (std::chrono::steady_clock::now() < deadline) {
+            std::fill(heights.begin(), heights.end(), static_cast<float>(publisher.Version() + 1));
+            // The next version is Version() + 1 because only this thread publishes.
+            if (Publish(publisher, heights)) {
+                ++published;
+            }
+            else {
+                ++skipped;
+            }
+        }
+        stop = true;
+        for (auto& reader : readers) {
+            reader.join();
+        }
+
+        std::printf("publishing: %u readers, %llu versions published, %llu skipped (all slots pinned), %llu views "
+                    "acquired, %llu held across publishes, %llu torn reads\n",
+                    readerCount, static_cast<unsigned long long>(published), static_cast<unsigned long long>(skipped),
+                    static_cast<unsigned long long>(acquired.load()), static_cast<unsigned long long>(held.load()),
+                    static_cast<unsigned long long>(torn.load()));
+        const bool ok = torn == 0 && published > 0 && acquired > 0;
+        if (!ok) {
+            std::fprintf(stderr, "FAIL publishing: readers saw heights from another version\n");
+        }
+        return ok;
+    }
+}
+
+int main(const int argc, char** argv) {
+    const uint32_t count = argc > 1 ? static_cast<uint32_t>(std::strtoul(argv[1], nullptr, 10)) : 100000;
+    const double seconds = argc > 2 ? std::atof(argv[2]) : 2.0;
+    if (count < 8 || !(seconds > 0.0)) {
+        std::fprintf(stderr, "usage: %s [points >= 8] [seconds-of-stress > 0]\n", argv[0]);
+        return 2;
+    }
+
+    bool ok = CheckSampling(count);
+    ok &= StressPublisher(seconds);
+    if (!ok) {
+        return 1;
+    }
+    std::printf("\nall checks passed\n");
+    return 0;
+}
@@ -0,0 +1,289 @@
+// Accuracy check and benchmark for the batch camera projection used by cIGZS3DCameraService::ProjectBatch.
+//
+// The game's Project cannot run on the host, so a double-precision reference camera stands in for the thunk: a
+// look-at view, a perspective or orthographic projection, and a pixel viewport with 0..1 depth. The check fits a
+// CameraProjection from nine reference projections, exactly as the service does, then compares ProjectPoints and
+// UnProjectPoints against the reference over random city-sized point sets. Exits non-zero if any visible point is off
+// by more than the tolerance the service uses to accept a fit. The same fit is copied into an S3DCameraSnapshot to
+// check that the header-only snapshot helpers agree with the batch path and that their eye rays reproject correctly.
+//
+// Usage: projection-batch-check [point-count] [iterations]
+
+#include "public/S3DCameraSnapshot.h"
+#include "service/CameraProjection.h"
+
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <vector>
+
+namespace {
+    // Stand-in for the per-point thunk; virtual so the timing includes an indirect call like the service interface.
+    class ReferenceCamera {
+    public:
+        ReferenceCamera(const bool orthographic, const double yawDegrees, const double pitchDegrees,
+                        const double distance) {
+            constexpr double kDegrees = 3.14159265358979323846 / 180.0;
+            const double yaw = yawDegrees * kDegrees;
+            const double pitch = pitchDegrees * kDegrees;
+            const double target[3] = {2048.0, 280.0, 2048.0};
+            const double forward[3] = {
+                std::cos(pitch) * std::sin(yaw), -std::sin(pitch), std::cos(pitch) * std::cos(yaw)
+            };
+            for (int k = 0; k < 3; ++k) {
+                eye_[k] = target[k] - forward[k] * distance;
+                forward_[k] = forward[k];
+            }
+            // right = up x forward, up' = forward x right (left-handed, y up).
+            right_[0] = forward[2];
+            right_[1] = 0.0;
+            right_[2] = -forward[0];
+            Normalize(right_);
+            up_[0] = forward[1] * right_[2] - forward[2] * right_[1];
+            up_[1] = forward[2] * right_[0] - forward[0] * right_[2];
+            up_[2] = forward[0] * right_[1] - forward[1] * right_[0];
+            orthographic_ = orthographic;
+        }
+        virtual ~ReferenceCamera() = default;
+
+        virtual bool Project(const float* world, float* outScreen) const {
+            double v[3];
+            for (int k = 0; k < 3; ++k) {
+                v[k] = world[k] - eye_[k];
+            }
+            const double vx = Dot(v, right_);
+            const double vy = Dot(v, up_);
+            const double vz = Dot(v, forward_);
+            double nx, ny, nz;
+            if (orthographic_) {
+                nx = vx / (kOrthoWidth * 0.5);
+                ny = vy / (kOrthoWidth * 0.5 / kAspect);
+                nz = (vz - kNear) / (kFar - kNear);
+            }
+            else {
+                if (vz <= 1.0e-6) {
+                    return false;
+                }
+                const double ys = 1.0 / std::tan(kFovY * 0.5);
+                nx = vx * ys / kAspect / vz;
+                ny = vy * ys / vz;
+                nz = (kFar / (kFar - kNear)) * (vz - kNear) / vz;
+            }
+            outScreen[0] = static_cast<float>((nx * 0.5 + 0.5) * kWidth);
+            outScreen[1] = static_cast<float>((0.5 - ny * 0.5) * kHeight);
+            outScreen[2] = static_cast<float>(nz);
+            return true;
+        }
+
+    private:
+        static constexpr double kWidth = 1920.0;
+        static constexpr double kHeight = 1080.0;
+        static constexpr double kAspect = kWidth / kHeight;
+        static constexpr double kFovY = 0.5;
+        static constexpr double kNear = 10.0;
+        static constexpr double kFar = 20000.0;
+        static constexpr double kOrthoWidth = 1500.0;
+
+        static double Dot(const double* a, const double* b) { return a[0] * b[0] + a[1] * b[1] + a[2] * b[2]; }
+        static void Normalize(double* v) {
+            const double l = std::sqrt(Dot(v, v));
+            v[0] /= l;
+            v[1] /= l;
+            v[2] /= l;
+        }
+
+        double eye_[3]{};
+        double forward_[3]{};
+        double right_[3]{};
+        double up_[3]{};
+        bool orthographic_ = false;
+    };
+
+    struct CaseResult {
+        bool ok = true;
+        double maxScreenError = 0.0;
+        double maxDepthError = 0.0;
+        double maxRoundTripError = 0.0;
+        double maxSnapshotError = 0.0;
+        double batchNsPerPoint = 0.0;
+        double referenceNsPerPoint = 0.0;
+    };
+
+    CaseResult RunCase(const char* name, const ReferenceCamera& camera, const uint32_t count, const int iterations) {
+        CaseResult result;
+
+        // Fit exactly like S3DCameraService::FitProjectionCache.
+        constexpr float kHalfExtent = 32.0f;
+        const float center[3] = {2048.0f, 280.0f, 2048.0f};
+        float world[kCameraProjectionFitPoints][3];
+        float screen[kCameraProjectionFitPoints][3];
+        GetCameraProjectionFitPoints(center, kHalfExtent, world);
+        for (size_t i = 0; i < kCameraProjectionFitPoints; ++i) {
+            camera.Project(world[i], screen[i]);
+        }
+        CameraProjection projection{};
+        if (!FitCameraProjection(world, screen, kCameraProjectionFitPoints, center, kHalfExtent, projection)) {
+            std::fprintf(stderr, "FAIL %s: fit failed\n", name);
+            result.ok = false;
+            return result;
+        }
+
+        std::mt19937 rng(777);
+        std::uniform_real_distribution<float> horizontal(0.0f, 4096.0f);
+        std::uniform_real_distribution<float> height(0.0f, 800.0f);
+        std::vector<float> points(static_cast<size_t>(count) * 3);
+        for (uint32_t i = 0; i < count; ++i) {
+            points[i * 3 + 0] = horizontal(rng);
+            points[i * 3 + 1] = height(rng);
+            points[i * 3 + 2] = horizontal(rng);
+        }
+
+        std::vector<float> batch(points.size());
+        std::vector<uint8_t> visible(count);
+        ProjectPoints(projection, points.data(), count, batch.data(), visible.data());
+
+        std::vector<float> reference(points.size());
+        uint32_t mismatches = 0;
+        uint32_t onScreen = 0;
+        for (uint32_t i = 0; i < count; ++i) {
+            const bool expectedVisible = camera.Project(&points[i * 3], &reference[i * 3]);
+            // Points within a hair of the camera plane project to infinity; either answer is acceptable there.
+            if (expectedVisible && std::fabs(reference[i * 3]) > 1.0e7f) {
+                continue;
+            }
+            if (expectedVisible != (visible[i] != 0)) {
+                ++mismatches;
+                continue;
+            }
+            if (!expectedVisible) {
+                continue;
+            }
+            const float* e = &reference[i * 3];
+            const float* a = &batch[i * 3];
+            // Judge accuracy where it matters: points that land on or near the screen.
+            if (e[0] < -1920.0f || e[0] > 3840.0f || e[1] < -1080.0f || e[1] > 2160.0f) {
+                continue;
+            }
+            ++onScreen;
+            result.maxScreenError = std::fmax(result.maxScreenError,
+                                              std::fmax(std::fabs(e[0] - a[0]), std::fabs(e[1] - a[1])));
+            result.maxDepthError = std::fmax(result.maxDepthError, std::fabs(e[2] - a[2]));
+            if (!CameraProjectionMatches(e, a)) {
+                ++mismatches;
+            }
+        }
+
+        // Round trip on-screen points back to world space.
+        std::vector<float> roundTrip(points.size());
+        UnProjectPoints(projection, batch.data(), count, roundTrip.data(), nullptr);
+        for (uint32_t i = 0; i < count; ++i) {
+            const float* e = &reference[i * 3];
+            if (!visible[i] || e[0] < 0.0f || e[0] > 1920.0f || e[1] < 0.0f || e[1] > 1080.0f) {
+                continue;
+            }
+            for (int k = 0; k < 3; ++k) {
+                result.maxRoundTripError = std::fmax(result.maxRoundTripError,
+                                                     std::fabs(roundTrip[i * 3 + k] - points[i * 3 + k]));
+            }
+        }
+
+        // Snapshot helpers: same transform, scalar code, plus eye rays through a grid of pixels.
+        S3DCameraSnapshot snapshot{};
+        std::memcpy(snapshot.worldToScreen, projection.columns, sizeof(snapshot.worldToScreen));
+        std::memcpy(snapshot.screenToWorld, projection.inverse, sizeof(snapshot.screenToWorld));
+        std::memcpy(snapshot.origin, projection.origin, sizeof(snapshot.origin));
+        snapshot.invScale = projection.invScale;
+        for (uint32_t i = 0; i < count; ++i) {
+            const float* e = &batch[i * 3];
+            if (!visible[i] || e[0] < 0.0f || e[0] > 1920.0f || e[1] < 0.0f || e[1] > 1080.0f) {
+                continue;
+            }
+            float s[3];
+            if (!SnapshotProject(snapshot, &points[i * 3], s)) {
+                ++mismatches;
+                continue;
+            }
+            result.maxSnapshotError = std::fmax(result.maxSnapshotError,
+                                                std::fmax(std::fabs(e[0] - s[0]), std::fabs(e[1] - s[1])));
+        }
+        for (float sy = 0.0f; sy <= 1080.0f; sy += 135.0f) {
+            for (float sx = 0.0f; sx <= 1920.0f; sx += 240.0f) {
+                float origin[3];
+                float direction[3];
+                float reprojected[3];
+                if (!SnapshotGetEyeRay(snapshot, sx, sy, origin, direction)) {
+                    ++mismatches;
+                    continue;
+                }
+                const float along[3] = {
+                    origin[0] + direction[0] * 200.0f,
+                    origin[1] + direction[1] * 200.0f,
+                    origin[2] + direction[2] * 200.0f
+                };
+                if (!camera.Project(along, reprojected)) {
+                    ++mismatches;
+                    continue;
+                }
+                result.maxSnapshotError = std::fmax(result.maxSnapshotError,
+                                                    std::fmax(std::fabs(reprojected[0] - sx),
+                                                              std::fabs(reprojected[1] - sy)));
+            }
+        }
+
+        volatile float sink = 0.0f;
+        const auto start = std::chrono::steady_clock::now();
+        for (int it = 0; it < iterations; ++it) {
+            ProjectPoints(projection, points.data(), count, batch.data(), visible.data());
+            sink = batch[it % count];
+        }
+        const auto middle = std::chrono::steady_clock::now();
+        for (int it = 0; it < iterations; ++it) {
+            for (uint32_t i = 0; i < count; ++i) {
+                camera.Project(&points[i * 3], &reference[i * 3]);
+            }
+            sink = reference[it % count];
+        }
+        const auto end = std::chrono::steady_clock::now();
+        static_cast<void>(sink);
+        const double denom = static_cast<double>(count) * iterations;
+        result.batchNsPerPoint = std::chrono::duration<double, std::nano>(middle - start).count() / denom;
+        result.referenceNsPerPoint = std::chrono::duration<double, std::nano>(end - middle).count() / denom;
+
+        result.ok = mismatches == 0 && result.maxRoundTripError < 1.0 && result.maxSnapshotError < 0.1;
+        std::printf("%-26s %8u %10.4f %10.6f %10.4f %10.4f %10.2f %10.2f %s\n", name, onScreen,
+                    result.maxScreenError, result.maxDepthError, result.maxRoundTripError, result.maxSnapshotError,
+                    result.batchNsPerPoint,
+                    result.referenceNsPerPoint, result.ok ? "ok" : "FAIL");
+        if (mismatches != 0) {
+            std::fprintf(stderr, "FAIL %s: %u point(s) outside tolerance or with different visibility\n", name,
+                         mismatches);
+        }
+        return result;
+    }
+}
+
+int main(const int argc, char** argv) {
+    const uint32_t count = argc > 1 ? static_cast<uint32_t>(std::strtoul(argv[1], nullptr, 10)) : 100000;
+    const int iterations = argc > 2 ? std::atoi(argv[2]) : 50;
+    if (count == 0 || iterations <= 0) {
+        std::fprintf(stderr, "usage: %s [point-count] [iterations]\n", argv[0]);
+        return 2;
+    }
+
+    std::printf("%-26s %8s %10s %10s %10s %10s %10s %10s\n", "camera", "checked", "max px", "max depth",
+                "max world", "snap px", "batch ns", "ref ns");
+    bool ok = true;
+    ok &= RunCase("ortho, city view", ReferenceCamera(true, -22.5, 45.0, 3000.0), count, iterations).ok;
+    ok &= RunCase("ortho, steep", ReferenceCamera(true, 67.5, 80.0, 3000.0), count, iterations).ok;
+    ok &= RunCase("perspective, close", ReferenceCamera(false, 10.0, 35.0, 600.0), count, iterations).ok;
+    ok &= RunCase("perspective, far", ReferenceCamera(false, -45.0, 50.0, 4000.0), count, iterations).ok;
+
+    if (!ok) {
+        return 1;
+    }
+    std::printf("\nall checks passed\n");
+    return 0;
+}
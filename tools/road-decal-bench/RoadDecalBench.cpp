@@ -0,0 +1,315 @@
+// Correctness check and benchmark for the per-stroke road decal geometry cache behind RebuildRoadDecalGeometry.
+//
+// Builds a city's worth of markings (lane lines with and without dashes, double yellows, arrows and crosswalks) on a
+// synthetic rolling surface and times a full re-tessellation against cached rebuilds: cold, after moving one stroke in
+// the middle, after moving the last one, after appending one and after deleting one. After every cached rebuild each
+// chunk's triangles are compared with a full re-tessellation of the strokes that belong to it, and its bounds and
+// 16-bit index runs are checked. Reports the vertices and upload bytes of the indexed meshes against the same
+// triangles sent as a plain triangle list. Finally culls the chunks against a zoomed-in view and reports how much is
+// left to draw. Exits non-zero if any check fails.
+//
+// Usage: road-decal-bench [stroke-count] [edits]
+
+#include "sample/road-decal/RoadDecalGeometryCache.hpp"
+
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <map>
+#include <random>
+#include <vector>
+
+namespace {
+    constexpr float kMapSize = 4096.0f;
+    constexpr float kChunkSize = 64.0f;
+
+    void ConformToSurface(RoadDecalPoint* points, const size_t count, void*) {
+        for (size_t i = 0; i < count; ++i) {
+            const float x = points[i].x;
+            const float z = points[i].z;
+            points[i].y = 250.0f + 40.0f * std::sin(x * 0.004f) * std::cos(z * 0.003f) + 0.05f;
+        }
+    }
+
+    constexpr RoadDecalConformer kSurface{&ConformToSurface, nullptr};
+
+    RoadMarkupStroke MakeStroke(std::mt19937& rng) {
+        std::uniform_real_distribution<float> position(16.0f, kMapSize - 16.0f);
+        std::uniform_real_distribution<float> angle(0.0f, 6.2831853f);
+        std::uniform_int_distribution<int> kind(0, 9);
+
+        RoadMarkupStroke stroke;
+        const float x = position(rng);
+        const float z = position(rng);
+        const float heading = angle(rng);
+        const float dx = std::cos(heading);
+        const float dz = std::sin(heading);
+
+        switch (kind(rng)) {
+        case 0:
+        case 1:
+        case 2:
+            stroke.type = RoadMarkupType::SolidWhiteLine;
+            break;
+        case 3:
+        case 4:
+            stroke.type = RoadMarkupType::DashedWhiteLine;
+            stroke.dashed = true;
+            break;
+        case 5:
+            stroke.type = RoadMarkupType::DoubleSolidYellow;
+            break;
+        case 6:
+            stroke.type = RoadMarkupType::ArrowStraight;
+            break;
+        case 7:
+            stroke.type = RoadMarkupType::ArrowLeft;
+            break;
+        case 8:
+            stroke.type = RoadMarkupType::ZebraCrosswalk;
+            stroke.width = 3.0f;
+            break;
+        default:
+            stroke.type = RoadMarkupType::StopBar;
+            stroke.width = 0.4f;
+            break;
+        }
+        stroke.color = stroke.type == RoadMarkupType::DoubleSolidYellow ? 0xFFFFC000u : 0xFFFFFFFFu;
+
+        // Lines follow a gently bending road of 2 to 6 points; everything else is placed with two.
+        const bool line = stroke.type == RoadMarkupType::SolidWhiteLine ||
+                          stroke.type == RoadMarkupType::DashedWhiteLine ||
+                          stroke.type == RoadMarkupType::DoubleSolidYellow;
+        const int count = line ? std::uniform_int_distribution<int>(2, 6)(rng) : 2;
+        const float step = line ? 24.0f : 4.0f;
+        float px = x;
+        float pz = z;
+        float bend = 0.0f;
+        for (int i = 0; i < count; ++i) {
+            stroke.points.push_back({px, 0.0f, pz, false});
+            bend += std::uniform_real_distribution<float>(-0.3f, 0.3f)(rng);
+            px += (dx * std::cos(bend) - dz * std::sin(bend)) * step;
+            pz += (dz * std::cos(bend) + dx * std::sin(bend)) * step;
+        }
+        return stroke;
+    }
+
+    uint64_t ChunkKey(const RoadDecalPoint& point) {
+        const auto cx = static_cast<int32_t>(std::floor(point.x / kChunkSize));
+        const auto cz = static_cast<int32_t>(std::floor(point.z / kChunkSize));
+        return (static_cast<uint64_t>(static_cast<uint32_t>(cx)) << 32) | static_cast<uint32_t>(cz);
+    }
+
+    // Every triangle of the mesh as three vertices, the way they were drawn before meshes were indexed.
+    void AppendTriangleList(const RoadDecalVertex* vertices, const uint16_t* indices, const size_t indexCount,
+                            std::vector<RoadDecalVertex>& out) {
+        for (size_t i = 0; i < indexCount; ++i) {
+            out.push_back(vertices[indices[i]]);
+        }
+    }
+
+    struct FullBuildResult {
+        size_t vertices = 0;
+        size_t indices = 0;
+    };
+
+    FullBuildResult FullBuild(const std::vector<RoadMarkupStroke>& strokes) {
+        FullBuildResult result;
+        RoadDecalMesh mesh;
+        for (const auto& stroke : strokes) {
+            mesh.Clear();
+            BuildRoadDecalStrokeMesh(stroke, kSurface, mesh);
+            result.vertices += mesh.vertices.size();
+            result.indices += mesh.indices.size();
+        }
+        return result;
+    }
+
+    void CachedBuild(RoadDecalGeometryCache& cache, const std::vector<RoadMarkupStroke>& strokes) {
+        cache.BeginRebuild(1);
+        for (const auto& stroke : strokes) {
+            cache.AddStroke(stroke, kSurface);
+        }
+        cache.EndRebuild();
+    }
+
+    bool Matches(const RoadDecalGeometryCache& cache, const std::vector<RoadMarkupStroke>& strokes) {
+        std::map<uint64_t, std::vector<RoadDecalVertex>> reference;
+        RoadDecalMesh mesh;
+        for (const auto& stroke : strokes) {
+            mesh.Clear();
+            BuildRoadDecalStrokeMesh(stroke, kSurface, mesh);
+            if (!mesh.vertices.empty()) {
+                AppendTriangleList(mesh.vertices.data(), mesh.indices.data(), mesh.indices.size(),
+                                   reference[ChunkKey(stroke.points.front())]);
+            }
+        }
+
+        size_t nonEmpty = 0;
+        std::vector<RoadDecalVertex> triangles;
+        for (size_t i = 0; i < cache.Chunks().size(); ++i) {
+            const RoadDecalChunk& chunk = cache.Chunks()[i];
+            const CullBox& box = cache.ChunkBounds()[i];
+            if (chunk.vertices.empty()) {
+                continue;
+            }
+            ++nonEmpty;
+            triangles.clear();
+            size_t runVertices = 0;
+            for (const RoadDecalChunkRun& run : chunk.runs) {
+                if (run.vertexCount > RoadDecalMesh::kMaxVertices || run.firstVertex != runVertices) {
+                    return false;
+                }
+                runVertices += run.vertexCount;
+                for (uint32_t k = 0; k < run.indexCount; ++k) {
+                    if (chunk.indices[run.firstIndex + k] >= run.vertexCount) {
+                        return false;
+                    }
+                }
+                AppendTriangleList(chunk.vertices.data() + run.firstVertex, chunk.indices.data() + run.firstIndex,
+                                   run.indexCount, triangles);
+            }
+            const auto it = reference.find(chunk.key);
+            if (runVertices != chunk.vertices.size() || it == reference.end() ||
+                it->second.size() != triangles.size() ||
+                std::memcmp(it->second.data(), triangles.data(), triangles.size() * sizeof(RoadDecalVertex)) != 0) {
+                return false;
+            }
+            for (const auto& v : chunk.vertices) {
+                if (v.x < box.minX || v.y < box.minY || v.z < box.minZ ||
+                    v.x > box.maxX || v.y > box.maxY || v.z > box.maxZ) {
+                    return false;
+                }
+            }
+        }
+        return nonEmpty == reference.size();
+    }
+
+    // Looks straight down on a square of the map: four side planes facing inward, near and far open.
+    ViewFrustum TopDownView(const float x0, const float z0, const float size) {
+        ViewFrustum frustum{};
+        frustum.planes[kViewFrustumLeft] = {1.0f, 0.0f, 0.0f, -x0};
+        frustum.planes[kViewFrustumRight] = {-1.0f, 0.0f, 0.0f, x0 + size};
+        frustum.planes[kViewFrustumBottom] = {0.0f, 0.0f, 1.0f, -z0};
+        frustum.planes[kViewFrustumTop] = {0.0f, 0.0f, -1.0f, z0 + size};
+        frustum.planes[kViewFrustumNear] = kViewFrustumOpenPlane;
+        frustum.planes[kViewFrustumFar] = kViewFrustumOpenPlane;
+        return frustum;
+    }
+
+    double Milliseconds(const std::chrono::steady_clock::time_point start) {
+        return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    }
+
+    void Report(const char* name, const double ms, const RoadDecalGeometryCacheStats& stats) {
+        std::printf("%-20s %10.3f %9u %9u %9u %7u %10zu %9u\n", name, ms, stats.tessellated, stats.keptInPlace,
+                    stats.evicted, stats.pages, stats.cachedVertices, stats.changedChunks);
+    }
+}
+
+int main(const int argc, char** argv) {
+    const int strokeCount = argc > 1 ? std::atoi(argv[1]) : 10000;
+    const int edits = argc > 2 ? std::atoi(argv[2]) : 200;
+    if (strokeCount < 2 || edits < 1) {
+        std::fprintf(stderr, "usage: %s [stroke-count >= 2] [edits >= 1]\n", argv[0]);
+        return 2;
+    }
+
+    std::mt19937 rng(0xDECA1u);
+    std::vector<RoadMarkupStroke> strokes;
+    strokes.reserve(static_cast<size_t>(strokeCount) + 1);
+    for (int i = 0; i < strokeCount; ++i) {
+        strokes.push_back(MakeStroke(rng));
+    }
+
+    bool ok = true;
+    const auto check = [&](const char* name, const RoadDecalGeometryCache& cache) {
+        if (!Matches(cache, strokes)) {
+            std::fprintf(stderr, "FAIL %s: chunk buffers differ from a full re-tessellation\n", name);
+            ok = false;
+        }
+    };
+
+    const auto start = std::chrono::steady_clock::now();
+    const FullBuildResult full = FullBuild(strokes);
+    const double fullMs = Milliseconds(start);
+    // Static buffers upload vertices only; D3D7 has no index buffers, so indices are passed from system memory.
+    constexpr double kMB = 1024.0 * 1024.0;
+    std::printf("%d strokes, %zu triangles\n", strokeCount, full.indices / 3);
+    std::printf("  triangle list: %9zu vertices, %6.1f MB uploaded\n", full.indices,
+                full.indices * sizeof(RoadDecalVertex) / kMB);
+    std::printf("  indexed:       %9zu vertices, %6.1f MB uploaded, %6.1f MB of indices (%.2fx fewer vertices, "
+                "%.0f%% less upload)\n\n",
+                full.vertices, full.vertices * sizeof(RoadDecalVertex) / kMB, full.indices * sizeof(uint16_t) / kMB,
+                static_cast<double>(full.indices) / static_cast<double>(full.vertices),
+                100.0 * (1.0 - static_cast<double>(full.vertices) / static_cast<double>(full.indices)));
+    std::printf("%-20s %10s %9s %9s %9s %7s %10s %9s\n", "rebuild", "ms", "tessel.", "in place", "evicted", "pages",
+                "cached", "chunks");
+    std::printf("%-20s %10.3f\n", "full re-tessellation", fullMs);
+
+    RoadDecalGeometryCache cache;
+    const auto rebuild = [&](const char* name) {
+        const auto begin = std::chrono::steady_clock::now();
+        CachedBuild(cache, strokes);
+        Report(name, Milliseconds(begin), cache.Stats());
+        check(name, cache);
+    };
+
+    rebuild("cold");
+    rebuild("unchanged");
+
+    // Move a stroke from the middle third each time; only the first edit and the last are verified, to keep the run
+    // short.
+    std::uniform_int_distribution<int> middle(strokeCount / 3, 2 * strokeCount / 3);
+    double editMs = 0.0;
+    for (int i = 0; i < edits; ++i) {
+        auto& stroke = strokes[static_cast<size_t>(middle(rng))];
+        for (auto& p : stroke.points) {
+            p.x += 0.5f;
+        }
+        const auto begin = std::chrono::steady_clock::now();
+        CachedBuild(cache, strokes);
+        editMs += Milliseconds(begin);
+        if (i == 0 || i == edits - 1) {
+            check("edit middle", cache);
+        }
+    }
+    Report("edit middle (avg)", editMs / edits, cache.Stats());
+
+    strokes.back().points.front().z += 1.0f;
+    rebuild("edit last");
+
+    strokes.push_back(MakeStroke(rng));
+    rebuild("append");
+
+    strokes.erase(strokes.begin() + strokeCount / 2);
+    rebuild("delete middle");
+
+    strokes.pop_back();
+    rebuild("delete last");
+
+    // A zoomed-in view covers a few hundred metres of the map.
+    const ViewFrustum view = TopDownView(kMapSize * 0.4f, kMapSize * 0.4f, 512.0f);
+    const auto& chunks = cache.Chunks();
+    const auto chunkCount = static_cast<uint32_t>(chunks.size());
+    std::vector<uint32_t> bits(ViewFrustumBitWords(chunkCount));
+    const auto cullStart = std::chrono::steady_clock::now();
+    const uint32_t visible = CullBoxes(view, cache.ChunkBounds().data(), chunkCount, bits.data());
+    const double cullMs = Milliseconds(cullStart);
+    size_t visibleVertices = 0;
+    for (uint32_t i = 0; i < chunkCount; ++i) {
+        if (IsViewFrustumBitSet(bits.data(), i)) {
+            visibleVertices += chunks[i].vertices.size();
+        }
+    }
+    std::printf("\n512 m view: %u of %u chunks, %zu of %zu vertices, culled in %.3f ms\n", visible, chunkCount,
+                visibleVertices, cache.Stats().vertices, cullMs);
+
+    if (!ok) {
+        return 1;
+    }
+    std::printf("\nall checks passed\n");
+    return 0;
+}
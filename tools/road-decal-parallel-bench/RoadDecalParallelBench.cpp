@@ -0,0 +1,187 @@
+// Determinism check and benchmark for parallel road decal rebuilds.
+//
+// Builds a large markup file's worth of strokes on a large city heightfield and rebuilds cold, as after loading the
+// file: once with AddStroke per stroke on one thread, then with AddStrokes on worker pools of 2, 4 and all hardware
+// threads, several times each. Every parallel result must be bit-identical to the serial one: the same chunks in the
+// same order, with the same versions, bounds, runs, vertices and indices. Then edits 5% of the strokes and checks an
+// incremental rebuild the same way. Reports the time of each. Exits non-zero if any result differs.
+//
+// Usage: road-decal-parallel-bench [stroke-count] [repeats]
+
+#include "public/TerrainHeightfield.h"
+#include "sample/road-decal/RoadDecalGeometryCache.hpp"
+
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <vector>
+
+namespace {
+    constexpr uint32_t kVertices = 257;
+    constexpr float kSpacing = 16.0f;
+    constexpr float kMapSize = kSpacing * static_cast<float>(kVertices - 1);
+    constexpr float kChunkSize = 64.0f;
+
+    void ConformToView(RoadDecalPoint* points, const size_t count, void* userData) {
+        SampleHeightfieldBatch(*static_cast<const TerrainHeightfieldView*>(userData), &points->x, count,
+                               sizeof(RoadDecalPoint), 0.05f);
+    }
+
+    RoadMarkupStroke MakeStroke(std::mt19937& rng) {
+        std::uniform_real_distribution<float> position(16.0f, kMapSize - 16.0f);
+        std::uniform_real_distribution<float> angle(0.0f, 6.2831853f);
+        std::uniform_int_distribution<int> kind(0, 9);
+
+        RoadMarkupStroke stroke;
+        const int k = kind(rng);
+        const bool line = k < 6;
+        stroke.type = k < 3 ? RoadMarkupType::SolidWhiteLine
+                    : k < 5 ? RoadMarkupType::DashedWhiteLine
+                    : k < 6 ? RoadMarkupType::DoubleSolidYellow
+                    : k < 8 ? RoadMarkupType::ArrowStraight
+                            : RoadMarkupType::ZebraCrosswalk;
+        stroke.dashed = stroke.type == RoadMarkupType::DashedWhiteLine;
+        if (stroke.type == RoadMarkupType::ZebraCrosswalk) {
+            stroke.width = 3.0f;
+        }
+
+        const int count = line ? std::uniform_int_distribution<int>(2, 8)(rng) : 2;
+        const float step = line ? 24.0f : 4.0f;
+        float px = position(rng);
+        float pz = position(rng);
+        float heading = angle(rng);
+        for (int i = 0; i < count; ++i) {
+            stroke.points.push_back({px, 0.0f, pz, false});
+            heading += std::uniform_real_distribution<float>(-0.5f, 0.5f)(rng);
+            px += std::cos(heading) * step;
+            pz += std::sin(heading) * step;
+        }
+        return stroke;
+    }
+
+    bool SameOutput(const RoadDecalGeometryCache& a, const RoadDecalGeometryCache& b) {
+        if (a.Chunks().size() != b.Chunks().size() ||
+            std::memcmp(a.ChunkBounds().data(), b.ChunkBounds().data(), a.ChunkBounds().size() * sizeof(CullBox)) !=
+                0 ||
+            a.Stats().tessellated != b.Stats().tessellated || a.Stats().changedChunks != b.Stats().changedChunks) {
+            return false;
+        }
+        for (size_t i = 0; i < a.Chunks().size(); ++i) {
+            const RoadDecalChunk& x = a.Chunks()[i];
+            const RoadDecalChunk& y = b.Chunks()[i];
+            if (x.key != y.key || x.version != y.version || x.vertices.size() != y.vertices.size() ||
+                x.indices != y.indices || x.runs.size() != y.runs.size() ||
+                std::memcmp(x.runs.data(), y.runs.data(), x.runs.size() * sizeof(RoadDecalChunkRun)) != 0 ||
+                std::memcmp(x.vertices.data(), y.vertices.data(), x.vertices.size() * sizeof(RoadDecalVertex)) != 0) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    double Milliseconds(const std::chrono::steady_clock::time_point start) {
+        return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    }
+}
+
+int main(const int argc, char** argv) {
+    const int strokeCount = argc > 1 ? std::atoi(argv[1]) : 50000;
+    const int repeats = argc > 2 ? std::atoi(argv[2]) : 3;
+    if (strokeCount < 1 || repeats < 1) {
+        std::fprintf(stderr, "usage: %s [stroke-count >= 1] [repeats >= 1]\n", argv[0]);
+        return 2;
+    }
+
+    std::vector<float> heights(static_cast<size_t>(kVertices) * kVertices);
+    for (uint32_t z = 0; z < kVertices; ++z) {
+        for (uint32_t x = 0; x < kVertices; ++x) {
+            heights[static_cast<size_t>(z) * kVertices + x] =
+                250.0f + 40.0f * std::sin(static_cast<float>(x) * 0.07f) * std::cos(static_cast<float>(z) * 0.05f);
+        }
+    }
+    TerrainHeightfieldView view{heights.data(), kVertices, kVertices, kVertices, kSpacing, 1, 0};
+    const RoadDecalConformer conformer{&ConformToView, &view, true};
+
+    std::mt19937 rng(0x48u);
+    std::vector<RoadMarkupStroke> strokes;
+    for (int i = 0; i < strokeCount; ++i) {
+        strokes.push_back(MakeStroke(rng));
+    }
+
+    // Cold, then incremental after moving every 20th stroke.
+    std::vector<RoadMarkupStroke> edited = strokes;
+    for (size_t i = 0; i < edited.size(); i += 20) {
+        for (auto& p : edited[i].points) {
+            p.x += 3.0f;
+        }
+    }
+
+    const auto serialRebuild = [&](RoadDecalGeometryCache& cache, const std::vector<RoadMarkupStroke>& set) {
+        cache.BeginRebuild(1);
+        for (const auto& stroke : set) {
+            cache.AddStroke(stroke, conformer);
+        }
+        cache.EndRebuild();
+    };
+    const auto batchRebuild = [&](RoadDecalGeometryCache& cache, const std::vector<RoadMarkupStroke>& set,
+                                  RoadDecalWorkerPool* pool) {
+        cache.BeginRebuild(1);
+        cache.AddStrokes(set.data(), set.size(), conformer, pool);
+        cache.EndRebuild();
+    };
+
+    RoadDecalGeometryCache serial(kChunkSize);
+    auto start = std::chrono::steady_clock::now();
+    serialRebuild(serial, strokes);
+    const double serialColdMs = Milliseconds(start);
+    RoadDecalGeometryCache serialEdited(kChunkSize);
+    serialRebuild(serialEdited, strokes);
+    start = std::chrono::steady_clock::now();
+    serialRebuild(serialEdited, edited);
+    const double serialEditMs = Milliseconds(start);
+
+    std::printf("%d strokes, %zu chunks, %zu vertices\n\n", strokeCount, serial.Chunks().size(),
+                serial.Stats().vertices);
+    std::printf("%-10s %12s %9s %14s %9s\n", "workers", "cold (ms)", "speedup", "5% edit (ms)", "speedup");
+    std::printf("%-10s %12.1f %9s %14.1f %9s\n", "serial", serialColdMs, "1.00x", serialEditMs, "1.00x");
+
+    int failures = 0;
+    const unsigned counts[] = {1, 2, 4, RoadDecalWorkerPool::DefaultWorkerCount()};
+    for (const unsigned workers : counts) {
+        RoadDecalWorkerPool pool;
+        pool.Start(workers);
+        double coldMs = 0.0;
+        double editMs = 0.0;
+        for (int r = 0; r < repeats; ++r) {
+            RoadDecalGeometryCache cache(kChunkSize);
+            start = std::chrono::steady_clock::now();
+            batchRebuild(cache, strokes, &pool);
+            coldMs += Milliseconds(start);
+            if (!SameOutput(cache, serial)) {
+                std::fprintf(stderr, "FAIL: %u workers, cold rebuild %d differs from serial\n", workers, r);
+                ++failures;
+            }
+            start = std::chrono::steady_clock::now();
+            batchRebuild(cache, edited, &pool);
+            editMs += Milliseconds(start);
+            if (!SameOutput(cache, serialEdited)) {
+                std::fprintf(stderr, "FAIL: %u workers, edited rebuild %d differs from serial\n", workers, r);
+                ++failures;
+            }
+        }
+        coldMs /= repeats;
+        editMs /= repeats;
+        std::printf("%-10u %12.1f %8.2fx %14.1f %8.2fx\n", pool.Workers(), coldMs, serialColdMs / coldMs, editMs,
+                    serialEditMs / editMs);
+    }
+
+    if (failures > 0) {
+        std::fprintf(stderr, "FAIL: %d rebuild(s) differ from serial\n", failures);
+        return 1;
+    }
+    std::printf("\nall parallel rebuilds bit-identical to serial\n");
+    return 0;
+}
@@ -0,0 +1,326 @@
+// Correctness check and benchmark for the curve smoothing behind road decal lines.
+//
+// Draws four synthetic road networks as line strokes: grid avenues (straight, 24 to 48 m between clicks), highway
+// sweeps (150 to 400 m radius), tight corners and roundabouts (6 to 15 m radius, a click every few metres) and winding
+// country roads. Each is smoothed with BuildRoadDecalSmoothedPath and with the fixed 3 to 12 steps per segment it
+// replaced. Reports path points, line mesh vertices, smoothing time and how far each path strays in XZ from the exact
+// curve, sampled densely. Exits non-zero if the adaptive path strays past its tolerance or drops a control point.
+//
+// Usage: road-decal-smoothing-bench [strokes-per-network]
+
+#include "sample/road-decal/RoadDecalGeometry.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <vector>
+
+namespace {
+    constexpr float kTolerance = 0.02f;     // What BuildRoadDecalSmoothedPath promises.
+    constexpr int kReferenceSteps = 256;
+
+    struct Vec3 {
+        double x;
+        double y;
+        double z;
+    };
+
+    // The evaluation BuildRoadDecalSmoothedPath replaced: the Barry-Goldman pyramid with three pow per sample. The
+    // old path ran it in float; the reference runs it in double, since extrapolating from the near-zero knot step at
+    // a line's ends cancels away centimetres in float at city coordinates.
+    template <typename Real>
+    Vec3 LerpByT(const Vec3& a, const Vec3& b, const Real ta, const Real tb, const Real t) {
+        const Real denom = tb - ta;
+        if (std::fabs(denom) < Real(1.0e-5)) {
+            return b;
+        }
+        const Real wa = (tb - t) / denom;
+        const Real wb = (t - ta) / denom;
+        return {Real(wa * Real(a.x) + wb * Real(b.x)), Real(wa * Real(a.y) + wb * Real(b.y)),
+                Real(wa * Real(a.z) + wb * Real(b.z))};
+    }
+
+    template <typename Real>
+    Real Distance3(const Vec3& a, const Vec3& b) {
+        const Real dx = Real(b.x) - Real(a.x);
+        const Real dy = Real(b.y) - Real(a.y);
+        const Real dz = Real(b.z) - Real(a.z);
+        return std::sqrt(dx * dx + dy * dy + dz * dz);
+    }
+
+    // The old path also clamped every sample to the box of p1-p2, which flattens arcs wherever they bulge past it.
+    template <typename Real>
+    RoadDecalPoint CatmullRomPoint(const RoadDecalPoint& q0, const RoadDecalPoint& q1, const RoadDecalPoint& q2,
+                                   const RoadDecalPoint& q3, const Real u, const bool clampToBox) {
+        const Vec3 p0{q0.x, q0.y, q0.z};
+        const Vec3 p1{q1.x, q1.y, q1.z};
+        const Vec3 p2{q2.x, q2.y, q2.z};
+        const Vec3 p3{q3.x, q3.y, q3.z};
+        const Real t1 = std::pow((std::max)(Distance3<Real>(p0, p1), Real(1.0e-4)), Real(0.5));
+        const Real t2 = t1 + std::pow((std::max)(Distance3<Real>(p1, p2), Real(1.0e-4)), Real(0.5));
+        const Real t3 = t2 + std::pow((std::max)(Distance3<Real>(p2, p3), Real(1.0e-4)), Real(0.5));
+        const Real t = t1 + (t2 - t1) * u;
+        const Vec3 a1 = LerpByT<Real>(p0, p1, Real(0), t1, t);
+        const Vec3 a2 = LerpByT<Real>(p1, p2, t1, t2, t);
+        const Vec3 a3 = LerpByT<Real>(p2, p3, t2, t3, t);
+        const Vec3 b1 = LerpByT<Real>(a1, a2, Real(0), t2, t);
+        const Vec3 b2 = LerpByT<Real>(a2, a3, t1, t3, t);
+        const Vec3 c = LerpByT<Real>(b1, b2, t1, t2, t);
+        RoadDecalPoint p{static_cast<float>(c.x), static_cast<float>(c.y), static_cast<float>(c.z), false};
+        if (!clampToBox) {
+            return p;
+        }
+        p.x = std::clamp(p.x, (std::min)(q1.x, q2.x), (std::max)(q1.x, q2.x));
+        p.z = std::clamp(p.z, (std::min)(q1.z, q2.z), (std::max)(q1.z, q2.z));
+        return p;
+    }
+
+    // The old path with fixedSteps == 0: ceil(length) steps clamped to 3..12, in float, samples clamped to the
+    // segment box. Otherwise the exact curve at fixedSteps per segment.
+    void SmoothFixed(const std::vector<RoadDecalPoint>& points, const int fixedSteps,
+                     std::vector<RoadDecalPoint>& out) {
+        out.clear();
+        if (points.size() < 3) {
+            out = points;
+            return;
+        }
+        out.push_back(points.front());
+        for (size_t i = 0; i + 1 < points.size(); ++i) {
+            const auto& p0 = points[i == 0 ? i : i - 1];
+            const auto& p1 = points[i];
+            const auto& p2 = points[i + 1];
+            const auto& p3 = points[i + 2 < points.size() ? i + 2 : i + 1];
+            const float length = std::hypot(p2.x - p1.x, p2.z - p1.z);
+            const int steps = fixedSteps > 0 ? fixedSteps
+                                             : std::clamp(static_cast<int>(std::ceil(length)), 3, 12);
+            for (int step = 1; step <= steps; ++step) {
+                if (fixedSteps == 0) {
+                    const float u = static_cast<float>(step) / static_cast<float>(steps);
+                    out.push_back(CatmullRomPoint<float>(p0, p1, p2, p3, u, true));
+                }
+                else {
+                    const double u = static_cast<double>(step) / static_cast<double>(steps);
+                    out.push_back(CatmullRomPoint<double>(p0, p1, p2, p3, u, false));
+                }
+            }
+        }
+    }
+
+    float DistanceToSegmentXZ(const RoadDecalPoint& p, const RoadDecalPoint& a, const RoadDecalPoint& b) {
+        const float abX = b.x - a.x;
+        const float abZ = b.z - a.z;
+        const float len2 = abX * abX + abZ * abZ;
+        const float t = len2 > 1.0e-12f ? std::clamp(((p.x - a.x) * abX + (p.z - a.z) * abZ) / len2, 0.0f, 1.0f)
+                                        : 0.0f;
+        return std::hypot(p.x - (a.x + abX * t), p.z - (a.z + abZ * t));
+    }
+
+    // Largest XZ distance from the dense reference to the path. Both run the same way, so a cursor that only moves
+    // forward finds the nearest piece.
+    float MaxDeviation(const std::vector<RoadDecalPoint>& reference, const std::vector<RoadDecalPoint>& path) {
+        if (path.size() < 2) {
+            return 0.0f;
+        }
+        float worst = 0.0f;
+        size_t cursor = 0;
+        for (const auto& p : reference) {
+            float best = DistanceToSegmentXZ(p, path[cursor], path[cursor + 1]);
+            for (size_t j = cursor + 1; j + 1 < path.size() && j < cursor + 64; ++j) {
+                const float d = DistanceToSegmentXZ(p, path[j], path[j + 1]);
+                if (d < best) {
+                    best = d;
+                    cursor = j;
+                }
+            }
+            worst = (std::max)(worst, best);
+        }
+        return worst;
+    }
+
+    bool ContainsControlPoints(const std::vector<RoadDecalPoint>& points, const std::vector<RoadDecalPoint>& path) {
+        size_t j = 0;
+        for (const auto& p : points) {
+            while (j < path.size() && (path[j].x != p.x || path[j].z != p.z)) {
+                ++j;
+            }
+            if (j == path.size()) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    enum class Network { Grid, Highway, Corners, Country };
+
+    std::vector<RoadDecalPoint> MakeRoad(const Network network, std::mt19937& rng) {
+        std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+        std::vector<RoadDecalPoint> points;
+        const float x0 = 200.0f + 3600.0f * unit(rng);
+        const float z0 = 200.0f + 3600.0f * unit(rng);
+        float heading = 6.2831853f * unit(rng);
+
+        if (network == Network::Grid) {
+            heading = std::round(heading / 1.5707963f) * 1.5707963f;
+            const int count = 4 + static_cast<int>(unit(rng) * 5.0f);
+            float along = 0.0f;
+            for (int i = 0; i < count; ++i) {
+                const float wobble = (unit(rng) - 0.5f) * 0.02f; // Clicks are never quite in line.
+                points.push_back({x0 + std::cos(heading) * along - std::sin(heading) * wobble, 0.0f,
+                                  z0 + std::sin(heading) * along + std::cos(heading) * wobble, false});
+                along += 24.0f + 24.0f * unit(rng);
+            }
+            return points;
+        }
+
+        float radius = 0.0f;
+        float spacing = 0.0f;
+        int count = 0;
+        if (network == Network::Highway) {
+            radius = 150.0f + 250.0f * unit(rng);
+            spacing = 20.0f + 10.0f * unit(rng);
+            count = 5 + static_cast<int>(unit(rng) * 6.0f);
+        }
+        else if (network == Network::Corners) {
+            radius = 6.0f + 9.0f * unit(rng);
+            spacing = 2.5f + 3.0f * unit(rng);
+            // Up to three quarters of a turn, so the path never comes back past itself.
+            count = (std::min)(4 + static_cast<int>(unit(rng) * 8.0f), 1 + static_cast<int>(4.7f * radius / spacing));
+        }
+        if (network != Network::Country) {
+            const float side = unit(rng) < 0.5f ? 1.0f : -1.0f;
+            const float step = spacing / radius;
+            for (int i = 0; i < count; ++i) {
+                const float a = heading + side * step * static_cast<float>(i);
+                points.push_back({x0 + radius * std::cos(a), 0.0f, z0 + radius * std::sin(a), false});
+            }
+            return points;
+        }
+
+        count = 4 + static_cast<int>(unit(rng) * 8.0f);
+        float x = x0;
+        float z = z0;
+        for (int i = 0; i < count; ++i) {
+            points.push_back({x, 0.0f, z, false});
+            heading += (unit(rng) - 0.5f) * 1.2f;
+            const float step = 12.0f + 12.0f * unit(rng);
+            x += std::cos(heading) * step;
+            z += std::sin(heading) * step;
+        }
+        return points;
+    }
+
+    void Flat(RoadDecalPoint* points, const size_t count, void*) {
+        for (size_t i = 0; i < count; ++i) {
+            points[i].y = 0.05f;
+        }
+    }
+
+    size_t LineVertices(const std::vector<RoadDecalPoint>& path) {
+        RoadMarkupStroke stroke;
+        stroke.type = RoadMarkupType::SolidWhiteLine;
+        stroke.points = path;
+        for (auto& p : stroke.points) {
+            p.hardCorner = true; // Draw the path as given, without smoothing it again.
+        }
+        RoadDecalMesh mesh;
+        BuildRoadDecalStrokeMesh(stroke, {&Flat, nullptr}, mesh);
+        return mesh.vertices.size();
+    }
+
+    double Microseconds(const std::chrono::steady_clock::time_point start) {
+        return std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count();
+    }
+}
+
+int main(const int argc, char** argv) {
+    const int strokeCount = argc > 1 ? std::atoi(argv[1]) : 2000;
+    if (strokeCount < 1) {
+        std::fprintf(stderr, "usage: %s [strokes-per-network >= 1]\n", argv[0]);
+        return 2;
+    }
+
+    struct NetworkInfo {
+        Network network;
+        const char* name;
+    };
+    const NetworkInfo networks[] = {
+        {Network::Grid, "grid avenues"},
+        {Network::Highway, "highway sweeps"},
+        {Network::Corners, "tight corners"},
+        {Network::Country, "country roads"},
+    };
+
+    int failures = 0;
+    std::printf("%-15s %-9s %9s %9s %10s %10s %9s\n", "network", "path", "points", "vertices", "max dev", "mean dev",
+                "us/line");
+    for (const NetworkInfo& info : networks) {
+        std::mt19937 rng(0x5A0u + static_cast<unsigned>(info.network));
+        std::vector<std::vector<RoadDecalPoint>> roads;
+        for (int i = 0; i < strokeCount; ++i) {
+            roads.push_back(MakeRoad(info.network, rng));
+        }
+
+        struct Totals {
+            size_t points = 0;
+            size_t vertices = 0;
+            float maxDeviation = 0.0f;
+            double sumDeviation = 0.0;
+            double us = 0.0;
+        };
+        Totals fixed;
+        Totals adaptive;
+        std::vector<RoadDecalPoint> path;
+        std::vector<RoadDecalPoint> reference;
+        for (const auto& road : roads) {
+            SmoothFixed(road, kReferenceSteps, reference);
+
+            auto start = std::chrono::steady_clock::now();
+            SmoothFixed(road, 0, path);
+            fixed.us += Microseconds(start);
+            float deviation = MaxDeviation(reference, path);
+            fixed.points += path.size();
+            fixed.vertices += LineVertices(path);
+            fixed.maxDeviation = (std::max)(fixed.maxDeviation, deviation);
+            fixed.sumDeviation += deviation;
+
+            start = std::chrono::steady_clock::now();
+            BuildRoadDecalSmoothedPath(road, path);
+            adaptive.us += Microseconds(start);
+            deviation = MaxDeviation(reference, path);
+            adaptive.points += path.size();
+            adaptive.vertices += LineVertices(path);
+            adaptive.maxDeviation = (std::max)(adaptive.maxDeviation, deviation);
+            adaptive.sumDeviation += deviation;
+
+            if (!ContainsControlPoints(road, path)) {
+                if (++failures <= 5) {
+                    std::fprintf(stderr, "FAIL %s: smoothed path skips a control point\n", info.name);
+                }
+            }
+            // The reference is itself piecewise linear, so allow for its own chord error on the tightest curves.
+            if (deviation > kTolerance * 1.25f) {
+                if (++failures <= 5) {
+                    std::fprintf(stderr, "FAIL %s: adaptive path strays %.1f cm from the curve\n", info.name,
+                                 deviation * 100.0f);
+                }
+            }
+        }
+
+        const auto row = [&](const char* label, const Totals& t) {
+            std::printf("%-15s %-9s %9zu %9zu %8.1fcm %8.2fcm %9.2f\n", info.name, label, t.points, t.vertices,
+                        t.maxDeviation * 100.0f, t.sumDeviation * 100.0 / strokeCount, t.us / strokeCount);
+        };
+        row("fixed", fixed);
+        row("adaptive", adaptive);
+    }
+
+    if (failures > 0) {
+        std::fprintf(stderr, "FAIL: %d check(s) failed\n", failures);
+        return 1;
+    }
+    std::printf("\nall checks passed\n");
+    return 0;
+}
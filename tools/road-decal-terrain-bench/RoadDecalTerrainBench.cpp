@@ -0,0 +1,292 @@
+// Correctness check and benchmark for conforming road decals to the terrain during RebuildRoadDecalGeometry.
+//
+// Builds a city's worth of markings on a large city heightfield (257 x 257 vertices, 16 m apart) and counts the
+// terrain calls of one full rebuild three ways: the old per-point path (four GetAltitudeAtNearestGrid-style calls per
+// point), RoadDecalTerrainSampler's per-vertex cache over the same calls, and a heightfield snapshot pinned once per
+// rebuild. The cached path must give bit-identical meshes.
+//
+// Then terraforms small areas, diffs the heightfield with RoadDecalTerrainSnapshot and invalidates only the strokes
+// over changed regions. Reports how many strokes are re-conformed against the full drop a version change used to
+// cause, and checks every chunk against a cache built cold on the new terrain. Exits non-zero if any check fails.
+//
+// Usage: road-decal-terrain-bench [stroke-count]
+
+#include "sample/road-decal/RoadDecalGeometryCache.hpp"
+#include "sample/road-decal/RoadDecalTerrainSampler.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <map>
+#include <random>
+#include <vector>
+
+namespace {
+    constexpr uint32_t kVertices = 257;
+    constexpr float kSpacing = 16.0f;
+    constexpr float kMapSize = kSpacing * static_cast<float>(kVertices - 1);
+    constexpr float kChunkSize = 64.0f;
+    constexpr float kOffset = 0.05f;
+
+    struct Terrain {
+        std::vector<float> heights;
+        uint32_t version = 1;
+
+        Terrain() : heights(static_cast<size_t>(kVertices) * kVertices) {
+            for (uint32_t z = 0; z < kVertices; ++z) {
+                for (uint32_t x = 0; x < kVertices; ++x) {
+                    const float wx = static_cast<float>(x) * kSpacing;
+                    const float wz = static_cast<float>(z) * kSpacing;
+                    heights[static_cast<size_t>(z) * kVertices + x] =
+                        250.0f + 40.0f * std::sin(wx * 0.004f) * std::cos(wz * 0.003f);
+                }
+            }
+        }
+
+        [[nodiscard]] TerrainHeightfieldView View() const {
+            return {heights.data(), kVertices, kVertices, kVertices, kSpacing, version, 0};
+        }
+
+        // Raises a square of vertices, like the terraform tool does.
+        void Raise(const uint32_t x0, const uint32_t z0, const uint32_t size, const float amount) {
+            for (uint32_t z = z0; z < (std::min)(z0 + size, kVertices); ++z) {
+                for (uint32_t x = x0; x < (std::min)(x0 + size, kVertices); ++x) {
+                    heights[static_cast<size_t>(z) * kVertices + x] += amount;
+                }
+            }
+            ++version;
+        }
+    };
+
+    struct QueryCounter {
+        const Terrain* terrain = nullptr;
+        size_t calls = 0;
+    };
+
+    // GetAltitudeAtNearestGrid on the synthetic terrain, counted.
+    float AltitudeAt(const float x, const float z, void* userData) {
+        auto& counter = *static_cast<QueryCounter*>(userData);
+        ++counter.calls;
+        const auto ix = static_cast<uint32_t>(std::clamp(std::round(x / kSpacing), 0.0f, kVertices - 1.0f));
+        const auto iz = static_cast<uint32_t>(std::clamp(std::round(z / kSpacing), 0.0f, kVertices - 1.0f));
+        return counter.terrain->heights[static_cast<size_t>(iz) * kVertices + ix];
+    }
+
+    // The conforming RoadDecalData used before: four queries and a blend per point.
+    void ConformPerPoint(RoadDecalPoint* points, const size_t count, void* userData) {
+        for (size_t i = 0; i < count; ++i) {
+            RoadDecalPoint& p = points[i];
+            const float cellX = std::floor(p.x / kSpacing);
+            const float cellZ = std::floor(p.z / kSpacing);
+            const float x0 = cellX * kSpacing;
+            const float z0 = cellZ * kSpacing;
+            const float tx = std::clamp((p.x - x0) / kSpacing, 0.0f, 1.0f);
+            const float tz = std::clamp((p.z - z0) / kSpacing, 0.0f, 1.0f);
+            const float h00 = AltitudeAt(x0, z0, userData);
+            const float h10 = AltitudeAt(x0 + kSpacing, z0, userData);
+            const float h01 = AltitudeAt(x0, z0 + kSpacing, userData);
+            const float h11 = AltitudeAt(x0 + kSpacing, z0 + kSpacing, userData);
+            const float hx0 = h00 + (h10 - h00) * tx;
+            const float hx1 = h01 + (h11 - h01) * tx;
+            p.y = hx0 + (hx1 - hx0) * tz + kOffset;
+        }
+    }
+
+    struct SamplerConformer {
+        RoadDecalTerrainSampler* sampler = nullptr;
+        size_t calls = 0;   // Conformer invocations; each used to acquire and release the heightfield.
+    };
+
+    void ConformWithSampler(RoadDecalPoint* points, const size_t count, void* userData) {
+        auto& conformer = *static_cast<SamplerConformer*>(userData);
+        ++conformer.calls;
+        conformer.sampler->Conform(points, count, kOffset);
+    }
+
+    RoadMarkupStroke MakeStroke(std::mt19937& rng) {
+        std::uniform_real_distribution<float> position(16.0f, kMapSize - 16.0f);
+        std::uniform_real_distribution<float> angle(0.0f, 6.2831853f);
+        std::uniform_int_distribution<int> kind(0, 9);
+
+        RoadMarkupStroke stroke;
+        const int k = kind(rng);
+        const bool line = k < 6;
+        stroke.type = k < 3 ? RoadMarkupType::SolidWhiteLine
+                    : k < 5 ? RoadMarkupType::DashedWhiteLine
+                    : k < 6 ? RoadMarkupType::DoubleSolidYellow
+                    : k < 8 ? RoadMarkupType::ArrowStraight
+                            : RoadMarkupType::ZebraCrosswalk;
+        stroke.dashed = stroke.type == RoadMarkupType::DashedWhiteLine;
+        if (stroke.type == RoadMarkupType::ZebraCrosswalk) {
+            stroke.width = 3.0f;
+        }
+
+        const int count = line ? std::uniform_int_distribution<int>(2, 6)(rng) : 2;
+        const float step = line ? 24.0f : 4.0f;
+        float px = position(rng);
+        float pz = position(rng);
+        float heading = angle(rng);
+        for (int i = 0; i < count; ++i) {
+            stroke.points.push_back({px, 0.0f, pz, false});
+            heading += std::uniform_real_distribution<float>(-0.3f, 0.3f)(rng);
+            px += std::cos(heading) * step;
+            pz += std::sin(heading) * step;
+        }
+        return stroke;
+    }
+
+    void Rebuild(RoadDecalGeometryCache& cache, const uint64_t key, const std::vector<RoadMarkupStroke>& strokes,
+                 const RoadDecalConformer& conformer) {
+        cache.BeginRebuild(key);
+        for (const auto& stroke : strokes) {
+            cache.AddStroke(stroke, conformer);
+        }
+        cache.EndRebuild();
+    }
+
+    bool SameChunks(const RoadDecalGeometryCache& a, const RoadDecalGeometryCache& b) {
+        std::map<uint64_t, const RoadDecalChunk*> byKey;
+        for (const auto& chunk : b.Chunks()) {
+            byKey[chunk.key] = &chunk;
+        }
+        if (byKey.size() != a.Chunks().size()) {
+            return false;
+        }
+        for (const auto& chunk : a.Chunks()) {
+            const auto it = byKey.find(chunk.key);
+            if (it == byKey.end()) {
+                return false;
+            }
+            const RoadDecalChunk& other = *it->second;
+            if (chunk.vertices.size() != other.vertices.size() || chunk.indices != other.indices ||
+                std::memcmp(chunk.vertices.data(), other.vertices.data(),
+                            chunk.vertices.size() * sizeof(RoadDecalVertex)) != 0) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    double Milliseconds(const std::chrono::steady_clock::time_point start) {
+        return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    }
+}
+
+int main(const int argc, char** argv) {
+    const int strokeCount = argc > 1 ? std::atoi(argv[1]) : 10000;
+    if (strokeCount < 1) {
+        std::fprintf(stderr, "usage: %s [stroke-count >= 1]\n", argv[0]);
+        return 2;
+    }
+
+    std::mt19937 rng(0x7E44u);
+    std::vector<RoadMarkupStroke> strokes;
+    strokes.reserve(static_cast<size_t>(strokeCount));
+    for (int i = 0; i < strokeCount; ++i) {
+        strokes.push_back(MakeStroke(rng));
+    }
+
+    Terrain terrain;
+    int failures = 0;
+
+    // One full rebuild through each path, on cold caches so every stroke is conformed.
+    QueryCounter perPoint{&terrain};
+    RoadDecalGeometryCache perPointCache(kChunkSize);
+    auto start = std::chrono::steady_clock::now();
+    Rebuild(perPointCache, 0, strokes, {&ConformPerPoint, &perPoint});
+    const double perPointMs = Milliseconds(start);
+
+    QueryCounter cached{&terrain};
+    RoadDecalTerrainSampler sampler;
+    SamplerConformer queries{&sampler};
+    RoadDecalGeometryCache queryCache(kChunkSize);
+    start = std::chrono::steady_clock::now();
+    sampler.BeginQueries(&AltitudeAt, &cached, kSpacing);
+    Rebuild(queryCache, 0, strokes, {&ConformWithSampler, &queries});
+    const size_t conformedPoints = sampler.Stats().points;
+    sampler.End();
+    const double cachedMs = Milliseconds(start);
+    if (!SameChunks(queryCache, perPointCache)) {
+        std::fprintf(stderr, "FAIL: cached vertex queries changed the conformed meshes\n");
+        ++failures;
+    }
+
+    SamplerConformer snapshot{&sampler};
+    RoadDecalGeometryCache snapshotCache(kChunkSize);
+    start = std::chrono::steady_clock::now();
+    sampler.BeginSnapshot(terrain.View());
+    Rebuild(snapshotCache, terrain.version, strokes, {&ConformWithSampler, &snapshot});
+    sampler.End();
+    const double snapshotMs = Milliseconds(start);
+
+    std::printf("%d strokes, %zu points conformed per full rebuild\n\n", strokeCount, conformedPoints);
+    std::printf("%-34s %14s %10s\n", "terrain calls per rebuild", "calls", "ms");
+    std::printf("%-34s %14zu %10.2f\n", "per point (4 altitude queries)", perPoint.calls, perPointMs);
+    std::printf("%-34s %14zu %10.2f\n", "per grid vertex (cached queries)", cached.calls, cachedMs);
+    std::printf("%-34s %14zu %10.2f\n", "heightfield acquires, per conform", snapshot.calls, snapshotMs);
+    std::printf("%-34s %14d\n", "heightfield acquires, per rebuild", 1);
+    std::printf("\nvertex cache: %.1fx fewer altitude queries\n\n",
+                static_cast<double>(perPoint.calls) / static_cast<double>((std::max)(cached.calls, size_t{1})));
+
+    // Terraform, then rebuild the way RebuildRoadDecalGeometry does: diff, invalidate, rebuild on the new version.
+    RoadDecalTerrainSnapshot history;
+    history.Update(terrain.View(), kChunkSize);
+
+    struct Edit {
+        const char* name;
+        uint32_t x;
+        uint32_t z;
+        uint32_t size;
+    };
+    const Edit edits[] = {
+        {"raise one vertex", 128, 128, 1},
+        {"raise 5x5 vertices", 40, 200, 5},
+        {"raise at map corner", 0, 0, 3},
+        {"raise 32x32 vertices", 100, 60, 32},
+    };
+    std::printf("%-22s %9s %13s %13s %10s %10s\n", "terrain edit", "regions", "re-conformed", "full drop", "chunks",
+                "ms");
+    for (const Edit& edit : edits) {
+        const uint64_t previous = terrain.version;
+        terrain.Raise(edit.x, edit.z, edit.size, 6.0f);
+
+        start = std::chrono::steady_clock::now();
+        if (!history.Update(terrain.View(), kChunkSize)) {
+            std::fprintf(stderr, "FAIL %s: snapshot could not be compared\n", edit.name);
+            ++failures;
+        }
+        snapshotCache.InvalidateWhere(previous, terrain.version,
+                                      [](const CullBox& bounds, void* userData) {
+                                          return static_cast<const RoadDecalTerrainSnapshot*>(userData)->Overlaps(
+                                              bounds);
+                                      },
+                                      &history);
+        sampler.BeginSnapshot(terrain.View());
+        Rebuild(snapshotCache, terrain.version, strokes, {&ConformWithSampler, &snapshot});
+        sampler.End();
+        const double ms = Milliseconds(start);
+        const RoadDecalGeometryCacheStats stats = snapshotCache.Stats();
+
+        RoadDecalGeometryCache reference(kChunkSize);
+        sampler.BeginSnapshot(terrain.View());
+        Rebuild(reference, terrain.version, strokes, {&ConformWithSampler, &snapshot});
+        sampler.End();
+        if (!SameChunks(snapshotCache, reference)) {
+            std::fprintf(stderr, "FAIL %s: chunks differ from a cold rebuild on the new terrain\n", edit.name);
+            ++failures;
+        }
+
+        std::printf("%-22s %4zu/%-4zu %13u %13u %5u/%-4u %10.2f\n", edit.name, history.ChangedRegionCount(),
+                    history.RegionCount(), stats.tessellated, stats.strokes, stats.changedChunks, stats.chunks, ms);
+    }
+
+    if (failures > 0) {
+        std::fprintf(stderr, "FAIL: %d check(s) failed\n", failures);
+        return 1;
+    }
+    std::printf("\nall checks passed\n");
+    return 0;
+}
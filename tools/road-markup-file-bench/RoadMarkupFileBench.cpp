@@ -0,0 +1,450 @@
+// Correctness check and save/load benchmark for the version 2 road markup file.
+//
+// Builds a city's worth of markings on four layers and saves and loads them in both formats: version 1, written and
+// read one field at a time through a virtual stream interface as RoadMarkupSerializable does, and version 2 through
+// RoadMarkupFileWriter and a memory-mapped RoadMarkupFileReader. Also times how soon the chunks around one 512 m view
+// are decoded, which is what the game shows after the first frame of a load.
+//
+// Checks that a version 2 round trip keeps every layer and stroke field exactly and every point to within half a
+// quantization step, that saving the loaded markings again gives the same bytes, that a flipped byte fails only its
+// own chunk, and that damaged tables or a truncated file are refused. Exits non-zero if any check fails.
+//
+// Usage: road-markup-file-bench [stroke-count] [repeats]
+
+#include "sample/road-decal/RoadMarkupFile.hpp"
+#include "sample/road-decal/RoadMarkupStore.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace {
+    constexpr float kMapSize = 4096.0f;
+    constexpr float kTileSize = 128.0f;
+    constexpr float kViewSize = 512.0f;
+    constexpr uint32_t kVersion1 = 1;
+    constexpr float kPointTolerance = 0.5f / kRoadMarkupFilePointScale + 1.0e-4f;
+
+    struct Markups {
+        std::vector<RoadMarkupLayer> layers;
+        RoadMarkupStore store;
+        RoadMarkupFileInfo info;
+    };
+
+    void MakeMarkups(const int count, std::mt19937& rng, Markups& out) {
+        for (uint32_t i = 0; i < 4; ++i) {
+            out.layers.push_back({i + 1, "Layer " + std::to_string(i + 1), {}, i != 3, i == 2, static_cast<int>(i)});
+        }
+        std::uniform_real_distribution<float> position(0.0f, kMapSize);
+        std::uniform_real_distribution<float> angle(0.0f, 6.2831853f);
+        std::uniform_int_distribution<int> kind(0, 9);
+        std::uniform_int_distribution<uint32_t> layerOf(0, 3);
+        std::uniform_int_distribution<uint32_t> colorOf;
+
+        RoadMarkupStroke stroke;
+        for (int i = 0; i < count; ++i) {
+            const int k = kind(rng);
+            const bool line = k < 6;
+            stroke.type = line ? static_cast<RoadMarkupType>(k) : static_cast<RoadMarkupType>(6 + k);
+            stroke.width = line ? 0.15f : 3.0f;
+            stroke.length = line ? 3.0f : 6.0f;
+            stroke.rotation = line ? 0.0f : angle(rng);
+            stroke.dashed = k == 1 || k == 3;
+            stroke.dashLength = 3.0f;
+            stroke.gapLength = 9.0f;
+            stroke.color = colorOf(rng);
+            stroke.opacity = k == 5 ? 0.5f : 1.0f;
+            stroke.visible = k != 9;
+
+            stroke.points.clear();
+            const int points = line ? std::uniform_int_distribution<int>(2, 8)(rng) : 2;
+            const float step = line ? 24.0f : 4.0f;
+            float x = position(rng);
+            float z = position(rng);
+            float heading = angle(rng);
+            for (int p = 0; p < points; ++p) {
+                const float y = 250.0f + 40.0f * std::sin(x * 0.004f) * std::cos(z * 0.003f);
+                stroke.points.push_back({x, y, z, p > 0 && p + 1 < points && k == 0});
+                heading += std::uniform_real_distribution<float>(-0.5f, 0.5f)(rng);
+                x += std::cos(heading) * step;
+                z += std::sin(heading) * step;
+            }
+
+            RoadMarkupLayer& layer = out.layers[layerOf(rng)];
+            stroke.layerId = layer.id;
+            layer.strokeIds.push_back(out.store.Add(stroke));
+        }
+        out.info = {1, 0, static_cast<int32_t>(out.layers[0].strokeIds.size() / 2)};
+    }
+
+    // The version 1 stream, one virtual call per field as through cIGZOStream and cIGZIStream.
+    class FieldWriter {
+    public:
+        explicit FieldWriter(std::ofstream& out) : out_(out) {}
+        virtual ~FieldWriter() = default;
+        virtual bool SetUint8(const uint8_t v) { return Write(&v, sizeof(v)); }
+        virtual bool SetUint32(const uint32_t v) { return Write(&v, sizeof(v)); }
+        virtual bool SetSint32(const int32_t v) { return Write(&v, sizeof(v)); }
+        virtual bool SetFloat32(const float v) { return Write(&v, sizeof(v)); }
+        virtual bool SetVoid(const void* data, const uint32_t size) { return Write(data, size); }
+
+    private:
+        bool Write(const void* data, const uint32_t size) {
+            out_.write(static_cast<const char*>(data), size);
+            return out_.good();
+        }
+
+        std::ofstream& out_;
+    };
+
+    class FieldReader {
+    public:
+        explicit FieldReader(std::ifstream& in) : in_(in) {}
+        virtual ~FieldReader() = default;
+        virtual bool GetUint8(uint8_t& v) { return Read(&v, sizeof(v)); }
+        virtual bool GetUint32(uint32_t& v) { return Read(&v, sizeof(v)); }
+        virtual bool GetSint32(int32_t& v) { return Read(&v, sizeof(v)); }
+        virtual bool GetFloat32(float& v) { return Read(&v, sizeof(v)); }
+        virtual bool GetVoid(void* data, const uint32_t size) { return Read(data, size); }
+
+    private:
+        bool Read(void* data, const uint32_t size) {
+            in_.read(static_cast<char*>(data), size);
+            return in_.good();
+        }
+
+        std::ifstream& in_;
+    };
+
+    bool SaveVersion1(const Markups& markups, const std::filesystem::path& path) {
+        std::ofstream file(path, std::ios::binary | std::ios::trunc);
+        FieldWriter out(file);
+        bool ok = out.SetUint32(kRoadMarkupFileMagic) && out.SetUint32(kVersion1) &&
+                  out.SetUint32(static_cast<uint32_t>(markups.layers.size())) &&
+                  out.SetSint32(markups.info.activeLayerIndex) && out.SetSint32(markups.info.selectedLayerIndex) &&
+                  out.SetSint32(markups.info.selectedStrokeIndex);
+        RoadMarkupStroke stroke;
+        for (const auto& layer : markups.layers) {
+            const auto nameLen = static_cast<uint32_t>(layer.name.size());
+            ok = ok && out.SetUint32(layer.id) && out.SetUint32(nameLen) && out.SetUint8(layer.visible) &&
+                 out.SetUint8(layer.locked) && out.SetSint32(layer.renderOrder) &&
+                 out.SetUint32(static_cast<uint32_t>(layer.strokeIds.size())) &&
+                 out.SetVoid(layer.name.data(), nameLen);
+            for (const uint32_t id : layer.strokeIds) {
+                ok = ok && markups.store.Get(id, stroke) && out.SetUint32(static_cast<uint32_t>(stroke.type)) &&
+                     out.SetUint32(static_cast<uint32_t>(stroke.points.size())) && out.SetFloat32(stroke.width) &&
+                     out.SetFloat32(stroke.length) && out.SetFloat32(stroke.rotation) && out.SetUint8(stroke.dashed) &&
+                     out.SetFloat32(stroke.dashLength) && out.SetFloat32(stroke.gapLength) &&
+                     out.SetUint32(stroke.color) && out.SetFloat32(stroke.opacity) && out.SetUint8(stroke.visible) &&
+                     out.SetUint32(stroke.layerId);
+                for (const auto& p : stroke.points) {
+                    ok = ok && out.SetFloat32(p.x) && out.SetFloat32(p.y) && out.SetFloat32(p.z) &&
+                         out.SetUint8(p.hardCorner);
+                }
+            }
+        }
+        return ok;
+    }
+
+    bool LoadVersion1(const std::filesystem::path& path, Markups& out) {
+        std::ifstream file(path, std::ios::binary);
+        FieldReader in(file);
+        uint32_t magic = 0;
+        uint32_t version = 0;
+        uint32_t layerCount = 0;
+        if (!in.GetUint32(magic) || !in.GetUint32(version) || !in.GetUint32(layerCount) ||
+            !in.GetSint32(out.info.activeLayerIndex) || !in.GetSint32(out.info.selectedLayerIndex) ||
+            !in.GetSint32(out.info.selectedStrokeIndex) || magic != kRoadMarkupFileMagic || version != kVersion1) {
+            return false;
+        }
+        std::vector<std::vector<RoadMarkupStroke>> layerStrokes(layerCount);
+        out.layers.resize(layerCount);
+        for (uint32_t i = 0; i < layerCount; ++i) {
+            auto& layer = out.layers[i];
+            uint32_t nameLen = 0;
+            uint8_t visible = 0;
+            uint8_t locked = 0;
+            uint32_t strokeCount = 0;
+            if (!in.GetUint32(layer.id) || !in.GetUint32(nameLen) || !in.GetUint8(visible) || !in.GetUint8(locked) ||
+                !in.GetSint32(layer.renderOrder) || !in.GetUint32(strokeCount)) {
+                return false;
+            }
+            layer.visible = visible != 0;
+            layer.locked = locked != 0;
+            layer.name.assign(nameLen, '\0');
+            if (nameLen > 0 && !in.GetVoid(layer.name.data(), nameLen)) {
+                return false;
+            }
+            for (uint32_t s = 0; s < strokeCount; ++s) {
+                RoadMarkupStroke stroke{};
+                uint32_t type = 0;
+                uint32_t pointCount = 0;
+                uint8_t dashed = 0;
+                uint8_t strokeVisible = 0;
+                if (!in.GetUint32(type) || !in.GetUint32(pointCount) || !in.GetFloat32(stroke.width) ||
+                    !in.GetFloat32(stroke.length) || !in.GetFloat32(stroke.rotation) || !in.GetUint8(dashed) ||
+                    !in.GetFloat32(stroke.dashLength) || !in.GetFloat32(stroke.gapLength) ||
+                    !in.GetUint32(stroke.color) || !in.GetFloat32(stroke.opacity) || !in.GetUint8(strokeVisible) ||
+                    !in.GetUint32(stroke.layerId)) {
+                    return false;
+                }
+                stroke.type = static_cast<RoadMarkupType>(type);
+                stroke.dashed = dashed != 0;
+                stroke.visible = strokeVisible != 0;
+                stroke.points.reserve(pointCount);
+                for (uint32_t p = 0; p < pointCount; ++p) {
+                    RoadDecalPoint point{};
+                    uint8_t hard = 0;
+                    if (!in.GetFloat32(point.x) || !in.GetFloat32(point.y) || !in.GetFloat32(point.z) ||
+                        !in.GetUint8(hard)) {
+                        return false;
+                    }
+                    point.hardCorner = hard != 0;
+                    stroke.points.push_back(point);
+                }
+                layerStrokes[i].push_back(std::move(stroke));
+            }
+        }
+        for (uint32_t i = 0; i < layerCount; ++i) {
+            for (const auto& stroke : layerStrokes[i]) {
+                out.layers[i].strokeIds.push_back(out.store.Add(stroke));
+            }
+        }
+        return true;
+    }
+
+    bool SaveVersion2(const Markups& markups, const std::filesystem::path& path, std::vector<uint8_t>& bytes) {
+        RoadMarkupFileWriter writer(kTileSize);
+        RoadMarkupStroke stroke;
+        for (const auto& layer : markups.layers) {
+            writer.BeginLayer(layer);
+            for (const uint32_t id : layer.strokeIds) {
+                if (!markups.store.Get(id, stroke)) {
+                    return false;
+                }
+                writer.AddStroke(stroke);
+            }
+        }
+        writer.Finish(markups.info, bytes);
+        std::ofstream file(path, std::ios::binary | std::ios::trunc);
+        file.write(reinterpret_cast<const char*>(bytes.data()), static_cast<std::streamsize>(bytes.size()));
+        return file.good();
+    }
+
+    void AddDecoded(const uint32_t layerIndex, const uint32_t order, const RoadMarkupStroke& stroke, void* userData) {
+        auto& out = *static_cast<Markups*>(userData);
+        out.layers[layerIndex].strokeIds[order] = out.store.Add(stroke);
+    }
+
+    bool OverlapsView(const CullBox& box) {
+        constexpr float lo = 0.5f * (kMapSize - kViewSize);
+        constexpr float hi = 0.5f * (kMapSize + kViewSize);
+        return box.maxX >= lo && box.minX <= hi && box.maxZ >= lo && box.minZ <= hi;
+    }
+
+    // Decodes the chunks overlapping the view, or all of them. Returns the number of chunks that failed.
+    int LoadVersion2(const std::filesystem::path& path, Markups& out, const bool viewOnly) {
+        RoadMarkupMappedFile file;
+        RoadMarkupFileReader reader;
+        if (!file.Open(path.string().c_str()) || !reader.Open(file.Data(), file.Size())) {
+            return -1;
+        }
+        out.layers = reader.Layers();
+        out.info = reader.Info();
+        int failed = 0;
+        for (size_t i = 0; i < reader.Chunks().size(); ++i) {
+            if ((!viewOnly || OverlapsView(reader.Chunks()[i].bounds)) && !reader.DecodeChunk(i, &AddDecoded, &out)) {
+                ++failed;
+            }
+        }
+        return failed;
+    }
+
+    int Compare(const Markups& a, const Markups& b, const float tolerance) {
+        int mismatches = 0;
+        const auto fail = [&](const char* what, const size_t layer, const size_t stroke) {
+            if (++mismatches <= 5) {
+                std::fprintf(stderr, "FAIL: %s differs at layer %zu stroke %zu\n", what, layer, stroke);
+            }
+        };
+        if (a.layers.size() != b.layers.size() || a.info.activeLayerIndex != b.info.activeLayerIndex ||
+            a.info.selectedLayerIndex != b.info.selectedLayerIndex ||
+            a.info.selectedStrokeIndex != b.info.selectedStrokeIndex) {
+            fail("header", 0, 0);
+            return mismatches;
+        }
+        RoadMarkupStroke x;
+        RoadMarkupStroke y;
+        for (size_t l = 0; l < a.layers.size(); ++l) {
+            const auto& la = a.layers[l];
+            const auto& lb = b.layers[l];
+            if (la.id != lb.id || la.name != lb.name || la.visible != lb.visible || la.locked != lb.locked ||
+                la.renderOrder != lb.renderOrder || la.strokeIds.size() != lb.strokeIds.size()) {
+                fail("layer", l, 0);
+                continue;
+            }
+            for (size_t s = 0; s < la.strokeIds.size(); ++s) {
+                if (!a.store.Get(la.strokeIds[s], x) || !b.store.Get(lb.strokeIds[s], y)) {
+                    fail("presence", l, s);
+                    continue;
+                }
+                if (x.type != y.type || x.width != y.width || x.length != y.length || x.rotation != y.rotation ||
+                    x.dashed != y.dashed || x.dashLength != y.dashLength || x.gapLength != y.gapLength ||
+                    x.color != y.color || x.opacity != y.opacity || x.visible != y.visible ||
+                    x.layerId != y.layerId || x.points.size() != y.points.size()) {
+                    fail("stroke fields", l, s);
+                    continue;
+                }
+                for (size_t p = 0; p < x.points.size(); ++p) {
+                    const auto& pa = x.points[p];
+                    const auto& pb = y.points[p];
+                    if (std::abs(pa.x - pb.x) > tolerance || std::abs(pa.y - pb.y) > tolerance ||
+                        std::abs(pa.z - pb.z) > tolerance || pa.hardCorner != pb.hardCorner) {
+                        fail("point", l, s);
+                        break;
+                    }
+                }
+            }
+        }
+        return mismatches;
+    }
+
+    double Milliseconds(const std::chrono::steady_clock::time_point start) {
+        return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    }
+
+    template <typename Fn>
+    double Best(const int repeats, Fn&& fn) {
+        double best = 1.0e30;
+        for (int r = 0; r < repeats; ++r) {
+            const auto start = std::chrono::steady_clock::now();
+            fn();
+            best = (std::min)(best, Milliseconds(start));
+        }
+        return best;
+    }
+}
+
+int main(const int argc, char** argv) {
+    const int strokeCount = argc > 1 ? std::atoi(argv[1]) : 100000;
+    const int repeats = argc > 2 ? std::atoi(argv[2]) : 3;
+    if (strokeCount < 1 || repeats < 1) {
+        std::fprintf(stderr, "usage: %s [stroke-count >= 1] [repeats >= 1]\n", argv[0]);
+        return 2;
+    }
+
+    std::mt19937 rng(0x49u);
+    Markups markups;
+    MakeMarkups(strokeCount, rng, markups);
+
+    const auto dir = std::filesystem::temp_directory_path();
+    const auto v1Path = dir / "road-markup-file-bench-v1.dat";
+    const auto v2Path = dir / "road-markup-file-bench-v2.dat";
+    const auto damagedPath = dir / "road-markup-file-bench-damaged.dat";
+
+    int failures = 0;
+    std::vector<uint8_t> bytes;
+    const double v1SaveMs = Best(repeats, [&] { failures += !SaveVersion1(markups, v1Path); });
+    const double v2SaveMs = Best(repeats, [&] { failures += !SaveVersion2(markups, v2Path, bytes); });
+
+    Markups v1Loaded;
+    Markups v2Loaded;
+    Markups viewLoaded;
+    const double v1LoadMs = Best(repeats, [&] {
+        v1Loaded = {};
+        failures += !LoadVersion1(v1Path, v1Loaded);
+    });
+    const double v2LoadMs = Best(repeats, [&] {
+        v2Loaded = {};
+        failures += LoadVersion2(v2Path, v2Loaded, false) != 0;
+    });
+    const double viewLoadMs = Best(repeats, [&] {
+        viewLoaded = {};
+        failures += LoadVersion2(v2Path, viewLoaded, true) != 0;
+    });
+    if (failures > 0) {
+        std::fprintf(stderr, "FAIL: %d save or load call(s) failed\n", failures);
+    }
+
+    const double v1Mb = static_cast<double>(std::filesystem::file_size(v1Path)) / (1024.0 * 1024.0);
+    const double v2Mb = static_cast<double>(std::filesystem::file_size(v2Path)) / (1024.0 * 1024.0);
+    RoadMarkupFileReader reader;
+    reader.Open(bytes.data(), bytes.size());
+    size_t viewChunks = 0;
+    for (const auto& chunk : reader.Chunks()) {
+        viewChunks += OverlapsView(chunk.bounds);
+    }
+
+    std::printf("%d strokes, %zu points, %zu chunks of %.0f m\n\n", strokeCount, markups.store.LivePointCount(),
+                reader.Chunks().size(), kTileSize);
+    std::printf("%-8s %10s %10s %10s\n", "format", "size (MB)", "save (ms)", "load (ms)");
+    std::printf("%-8s %10.2f %10.1f %10.1f\n", "v1", v1Mb, v1SaveMs, v1LoadMs);
+    std::printf("%-8s %10.2f %10.1f %10.1f\n", "v2", v2Mb, v2SaveMs, v2LoadMs);
+    std::printf("%-8s %9.2fx %9.2fx %9.2fx\n", "v1/v2", v1Mb / v2Mb, v1SaveMs / v2SaveMs, v1LoadMs / v2LoadMs);
+    std::printf("\nv2 chunks in a %.0f m view: %zu, decoded in %.2f ms (%.1f%% of a full load)\n", kViewSize, viewChunks,
+                viewLoadMs, 100.0 * viewLoadMs / v2LoadMs);
+
+    // Round trips.
+    failures += Compare(markups, v1Loaded, 0.0f);
+    failures += Compare(markups, v2Loaded, kPointTolerance);
+    std::vector<uint8_t> again;
+    SaveVersion2(v2Loaded, damagedPath, again);
+    if (again != bytes) {
+        std::fprintf(stderr, "FAIL: saving a loaded version 2 file again changed its bytes\n");
+        ++failures;
+    }
+    if (PeekRoadMarkupFileVersion(reinterpret_cast<const uint8_t*>("RDMK"), 4) != 0) {
+        std::fprintf(stderr, "FAIL: a 4-byte file has a version\n");
+        ++failures;
+    }
+
+    // Damage: one payload byte fails its chunk only; a table byte or a cut-off file fails the whole file.
+    if (!reader.Chunks().empty()) {
+        const size_t target = reader.Chunks().size() / 2;
+        std::vector<uint8_t> damaged = bytes;
+        damaged[reader.Chunks()[target].offset + reader.Chunks()[target].size / 2] ^= 0x10u;
+        RoadMarkupFileReader damagedReader;
+        Markups sink;
+        if (!damagedReader.Open(damaged.data(), damaged.size())) {
+            std::fprintf(stderr, "FAIL: a damaged chunk made the whole file unreadable\n");
+            ++failures;
+        }
+        else {
+            sink.layers = damagedReader.Layers();
+            for (size_t i = 0; i < damagedReader.Chunks().size(); ++i) {
+                if (damagedReader.DecodeChunk(i, &AddDecoded, &sink) != (i != target)) {
+                    std::fprintf(stderr, "FAIL: chunk %zu %s its checksum\n", i, i == target ? "passed" : "failed");
+                    ++failures;
+                }
+            }
+        }
+
+        damaged = bytes;
+        damaged[12 * sizeof(uint32_t) + 2] ^= 0x01u;
+        if (damagedReader.Open(damaged.data(), damaged.size())) {
+            std::fprintf(stderr, "FAIL: a damaged layer table was accepted\n");
+            ++failures;
+        }
+        if (damagedReader.Open(bytes.data(), reader.Chunks().back().offset + reader.Chunks().back().size - 1)) {
+            std::fprintf(stderr, "FAIL: a truncated file was accepted\n");
+            ++failures;
+        }
+    }
+
+    std::filesystem::remove(v1Path);
+    std::filesystem::remove(v2Path);
+    std::filesystem::remove(damagedPath);
+    if (failures > 0) {
+        std::fprintf(stderr, "FAIL: %d check(s) failed\n", failures);
+        return 1;
+    }
+    std::printf("all checks passed\n");
+    return 0;
+}
@@ -0,0 +1,599 @@
+// Correctness check and benchmark for the road markup edit journal.
+//
+// Builds a city's worth of markings, starts an autosave in a temporary directory and makes a long run of random edits:
+// strokes added, deleted, moved, rotated and restyled, layers added, moved and deleted, with undos and redos mixed in.
+// Each edit is applied to the markings and recorded, as RoadDecalData does. The time and bytes the autosave costs per
+// edit are set against a full save of the same markings, and the time until an edit reaches the journal file is
+// measured.
+//
+// Checks that the history stays within its budget, that undoing everything it holds and redoing it all again comes
+// back to the same markings, that replaying the journal onto its snapshot reproduces the markings exactly, and that a
+// torn last record or a damaged one part way through stops the replay there. Exits non-zero if any check fails.
+//
+// Usage: road-markup-journal-bench [stroke-count] [edit-count]
+
+#include "sample/road-decal/RoadMarkupFile.hpp"
+#include "sample/road-decal/RoadMarkupJournal.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+    constexpr float kMapSize = 4096.0f;
+    constexpr float kTileSize = 128.0f;
+    constexpr size_t kHistoryBytes = 1u << 20;
+    constexpr float kUndoTolerance = 1.0e-2f;
+
+    struct Layer {
+        RoadMarkupLayer info;
+        std::vector<RoadMarkupStroke> strokes;
+    };
+
+    using Markups = std::vector<Layer>;
+
+    double Milliseconds(const std::chrono::steady_clock::time_point start) {
+        return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    }
+
+    RoadMarkupStroke MakeStroke(std::mt19937& rng, const uint32_t layerId) {
+        std::uniform_real_distribution<float> position(16.0f, kMapSize - 16.0f);
+        std::uniform_real_distribution<float> angle(0.0f, 6.2831853f);
+        std::uniform_int_distribution<int> kind(0, 9);
+
+        RoadMarkupStroke stroke;
+        const int k = kind(rng);
+        const bool line = k < 6;
+        stroke.type = line ? static_cast<RoadMarkupType>(k) : static_cast<RoadMarkupType>(6 + k);
+        stroke.width = line ? 0.15f : 3.0f;
+        stroke.length = line ? 3.0f : 6.0f;
+        stroke.rotation = line ? 0.0f : angle(rng);
+        stroke.dashed = k == 1 || k == 3;
+        stroke.color = std::uniform_int_distribution<uint32_t>()(rng);
+        stroke.layerId = layerId;
+
+        const int count = line ? std::uniform_int_distribution<int>(2, 8)(rng) : 2;
+        const float step = line ? 24.0f : 4.0f;
+        float px = position(rng);
+        float pz = position(rng);
+        float heading = angle(rng);
+        for (int i = 0; i < count; ++i) {
+            stroke.points.push_back({px, 250.0f, pz, i == count / 2});
+            heading += std::uniform_real_distribution<float>(-0.5f, 0.5f)(rng);
+            px += std::cos(heading) * step;
+            pz += std::sin(heading) * step;
+        }
+        return stroke;
+    }
+
+    Layer* FindLayer(Markups& markups, const uint32_t id) {
+        for (auto& layer : markups) {
+            if (layer.info.id == id) {
+                return &layer;
+            }
+        }
+        return nullptr;
+    }
+
+    // The same edits as ApplyRoadMarkupEdit in RoadDecalData.cpp, on plain vectors and without the terrain.
+    bool Apply(Markups& markups, const RoadMarkupEdit& edit, const bool revert) {
+        using Kind = RoadMarkupEditKind;
+        Kind kind = edit.kind;
+        if (revert) {
+            kind = kind == Kind::AddStroke    ? Kind::DeleteStroke
+                 : kind == Kind::DeleteStroke ? Kind::AddStroke
+                 : kind == Kind::AddLayer     ? Kind::DeleteLayer
+                 : kind == Kind::DeleteLayer  ? Kind::AddLayer
+                                              : kind;
+        }
+        const float sign = revert ? -1.0f : 1.0f;
+        Layer* layer = FindLayer(markups, edit.layerId);
+
+        switch (kind) {
+        case Kind::AddStroke:
+            if (!layer || edit.index > layer->strokes.size() || edit.strokes.size() != 1) {
+                return false;
+            }
+            layer->strokes.insert(layer->strokes.begin() + edit.index, edit.strokes.front());
+            return true;
+        case Kind::DeleteStroke:
+            if (!layer || edit.index >= layer->strokes.size()) {
+                return false;
+            }
+            layer->strokes.erase(layer->strokes.begin() + edit.index);
+            return true;
+        case Kind::MoveStroke:
+        case Kind::RotateStroke:
+        case Kind::SetStrokeStyle: {
+            if (!layer || edit.index >= layer->strokes.size()) {
+                return false;
+            }
+            RoadMarkupStroke& stroke = layer->strokes[edit.index];
+            if (kind == Kind::MoveStroke) {
+                for (auto& p : stroke.points) {
+                    p.x += sign * edit.deltaX;
+                    p.z += sign * edit.deltaZ;
+                }
+            }
+            else if (kind == Kind::RotateStroke) {
+                float centerX = 0.0f;
+                float centerZ = 0.0f;
+                for (const auto& p : stroke.points) {
+                    centerX += p.x;
+                    centerZ += p.z;
+                }
+                const float inv = 1.0f / static_cast<float>(stroke.points.size());
+                centerX *= inv;
+                centerZ *= inv;
+                const float s = std::sin(sign * edit.radians);
+                const float c = std::cos(sign * edit.radians);
+                for (auto& p : stroke.points) {
+                    const float x = p.x - centerX;
+                    const float z = p.z - centerZ;
+                    p.x = centerX + (x * c - z * s);
+                    p.z = centerZ + (x * s + z * c);
+                }
+                stroke.rotation += sign * edit.radians;
+            }
+            else {
+                const RoadMarkupStrokeStyle& style = revert ? edit.before : edit.after;
+                stroke.width = style.width;
+                stroke.length = style.length;
+                stroke.dashed = style.dashed;
+                stroke.dashLength = style.dashLength;
+                stroke.gapLength = style.gapLength;
+                stroke.color = style.color;
+                stroke.opacity = style.opacity;
+                stroke.visible = style.visible;
+            }
+            return true;
+        }
+        case Kind::AddLayer: {
+            if (layer || edit.index > markups.size()) {
+                return false;
+            }
+            Layer added{edit.layer, edit.strokes};
+            added.info.id = edit.layerId;
+            markups.insert(markups.begin() + edit.index, std::move(added));
+            return true;
+        }
+        case Kind::DeleteLayer:
+            if (!layer || markups.size() <= 1) {
+                return false;
+            }
+            markups.erase(markups.begin() + (layer - markups.data()));
+            return true;
+        case Kind::MoveLayer: {
+            const uint32_t from = revert ? edit.toIndex : edit.index;
+            const uint32_t to = revert ? edit.index : edit.toIndex;
+            if (from >= markups.size() || to >= markups.size()) {
+                return false;
+            }
+            Layer moved = std::move(markups[from]);
+            markups.erase(markups.begin() + from);
+            markups.insert(markups.begin() + to, std::move(moved));
+            for (size_t i = 0; i < markups.size(); ++i) {
+                markups[i].info.renderOrder = static_cast<int>(i);
+            }
+            return true;
+        }
+        case Kind::ClearStrokes:
+            if (!revert) {
+                for (auto& l : markups) {
+                    if (edit.layerId == 0 || l.info.id == edit.layerId) {
+                        l.strokes.clear();
+                    }
+                }
+                return true;
+            }
+            for (const auto& stroke : edit.strokes) {
+                Layer* owner = FindLayer(markups, stroke.layerId);
+                if (!owner) {
+                    return false;
+                }
+                owner->strokes.push_back(stroke);
+            }
+            return true;
+        }
+        return false;
+    }
+
+    bool Replay(const RoadMarkupEdit& edit, const bool revert, void* userData) {
+        return Apply(*static_cast<Markups*>(userData), edit, revert);
+    }
+
+    void Encode(const Markups& markups, std::vector<uint8_t>& out) {
+        RoadMarkupFileWriter writer(kTileSize);
+        for (const auto& layer : markups) {
+            writer.BeginLayer(layer.info);
+            for (const auto& stroke : layer.strokes) {
+                writer.AddStroke(stroke);
+            }
+        }
+        writer.Finish({}, out);
+    }
+
+    void AddDecoded(const uint32_t layerIndex, const uint32_t order, const RoadMarkupStroke& stroke, void* userData) {
+        auto& layer = (*static_cast<Markups*>(userData))[layerIndex];
+        layer.strokes[order] = stroke;
+        layer.strokes[order].id = 0;
+    }
+
+    bool Decode(const uint8_t* data, const size_t size, Markups& out) {
+        RoadMarkupFileReader reader;
+        if (!reader.Open(data, size)) {
+            return false;
+        }
+        out.clear();
+        for (const auto& info : reader.Layers()) {
+            Layer& layer = out.emplace_back();
+            layer.info = info;
+            layer.strokes.resize(info.strokeIds.size());
+            layer.info.strokeIds.clear();
+        }
+        for (size_t i = 0; i < reader.Chunks().size(); ++i) {
+            if (!reader.DecodeChunk(i, &AddDecoded, &out)) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    bool SameStroke(const RoadMarkupStroke& a, const RoadMarkupStroke& b, const float tolerance) {
+        if (a.type != b.type || a.width != b.width || a.length != b.length || a.dashed != b.dashed ||
+            a.dashLength != b.dashLength || a.gapLength != b.gapLength || a.color != b.color ||
+            a.opacity != b.opacity || a.visible != b.visible || a.layerId != b.layerId ||
+            std::fabs(a.rotation - b.rotation) > tolerance || a.points.size() != b.points.size()) {
+            return false;
+        }
+        for (size_t i = 0; i < a.points.size(); ++i) {
+            const RoadDecalPoint& p = a.points[i];
+            const RoadDecalPoint& q = b.points[i];
+            if (std::fabs(p.x - q.x) > tolerance || std::fabs(p.y - q.y) > tolerance ||
+                std::fabs(p.z - q.z) > tolerance || p.hardCorner != q.hardCorner) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    bool SameMarkups(const Markups& a, const Markups& b, const float tolerance) {
+        if (a.size() != b.size()) {
+            return false;
+        }
+        for (size_t l = 0; l < a.size(); ++l) {
+            const RoadMarkupLayer& x = a[l].info;
+            const RoadMarkupLayer& y = b[l].info;
+            if (x.id != y.id || x.name != y.name || x.visible != y.visible || x.locked != y.locked ||
+                x.renderOrder != y.renderOrder || a[l].strokes.size() != b[l].strokes.size()) {
+                return false;
+            }
+            for (size_t s = 0; s < a[l].strokes.size(); ++s) {
+                if (!SameStroke(a[l].strokes[s], b[l].strokes[s], tolerance)) {
+                    return false;
+                }
+            }
+        }
+        return true;
+    }
+
+    // A random edit of the markings as they are, for the editing thread to make.
+    RoadMarkupEdit MakeEdit(std::mt19937& rng, const Markups& markups, uint32_t& nextLayerId) {
+        std::uniform_int_distribution<int> percent(0, 99);
+        const auto pick = [&](const size_t count) {
+            return static_cast<uint32_t>(std::uniform_int_distribution<size_t>(0, count - 1)(rng));
+        };
+
+        RoadMarkupEdit edit;
+        const Layer& layer = markups[pick(markups.size())];
+        edit.layerId = layer.info.id;
+        const int r = percent(rng);
+        if (layer.strokes.empty() || r < 30) {
+            edit.kind = RoadMarkupEditKind::AddStroke;
+            edit.index = static_cast<uint32_t>(layer.strokes.size());
+            edit.strokes.push_back(MakeStroke(rng, layer.info.id));
+            return edit;
+        }
+        edit.index = pick(layer.strokes.size());
+        if (r < 45) {
+            edit.kind = RoadMarkupEditKind::DeleteStroke;
+            edit.strokes.push_back(layer.strokes[edit.index]);
+        }
+        else if (r < 65) {
+            edit.kind = RoadMarkupEditKind::MoveStroke;
+            edit.deltaX = std::uniform_real_distribution<float>(-8.0f, 8.0f)(rng);
+            edit.deltaZ = std::uniform_real_distribution<float>(-8.0f, 8.0f)(rng);
+        }
+        else if (r < 80) {
+            edit.kind = RoadMarkupEditKind::RotateStroke;
+            edit.radians = std::uniform_real_distribution<float>(-1.5f, 1.5f)(rng);
+        }
+        else if (r < 94 || markups.size() >= 8) {
+            const RoadMarkupStroke& stroke = layer.strokes[edit.index];
+            edit.kind = RoadMarkupEditKind::SetStrokeStyle;
+            edit.before = {stroke.width, stroke.length, stroke.dashed, stroke.dashLength, stroke.gapLength,
+                           stroke.color, stroke.opacity, stroke.visible};
+            edit.after = edit.before;
+            edit.after.width = std::uniform_real_distribution<float>(0.1f, 4.0f)(rng);
+            edit.after.color = std::uniform_int_distribution<uint32_t>()(rng);
+            edit.after.dashed = !stroke.dashed;
+        }
+        else if (r < 97) {
+            edit.kind = RoadMarkupEditKind::AddLayer;
+            edit.layerId = nextLayerId++;
+            edit.index = pick(markups.size() + 1);
+            edit.layer = {edit.layerId, "Layer " + std::to_string(edit.layerId), {}, true, false,
+                          static_cast<int>(markups.size())};
+        }
+        else if (r < 99 || markups.size() <= 2) {
+            edit.kind = RoadMarkupEditKind::MoveLayer;
+            edit.index = pick(markups.size());
+            edit.toIndex = pick(markups.size());
+        }
+        else {
+            edit.kind = RoadMarkupEditKind::DeleteLayer;
+            edit.index = static_cast<uint32_t>(&layer - markups.data());
+            edit.layer = layer.info;
+            edit.strokes = layer.strokes;
+        }
+        return edit;
+    }
+
+    std::vector<uint8_t> ReadFile(const std::filesystem::path& path) {
+        std::ifstream in(path, std::ios::binary);
+        return {std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>()};
+    }
+}
+
+int main(const int argc, char** argv) {
+    const int strokeCount = argc > 1 ? std::atoi(argv[1]) : 100000;
+    const int editCount = argc > 2 ? std::atoi(argv[2]) : 20000;
+    if (strokeCount < 1 || editCount < 1) {
+        std::fprintf(stderr, "usage: %s [stroke-count >= 1] [edit-count >= 1]\n", argv[0]);
+        return 2;
+    }
+
+    const std::filesystem::path directory = std::filesystem::temp_directory_path() / "road-markup-journal-bench";
+    std::filesystem::create_directories(directory);
+    const std::filesystem::path snapshotPath = directory / "autosave.dat";
+    const std::filesystem::path journalPath = directory / "autosave.dat.journal";
+    std::filesystem::remove(snapshotPath);
+    std::filesystem::remove(journalPath);
+    std::filesystem::remove(directory / "autosave.dat.open");
+
+    std::mt19937 rng(0x50u);
+    Markups markups;
+    for (uint32_t i = 0; i < 4; ++i) {
+        markups.push_back({{i + 1, "Layer " + std::to_string(i + 1), {}, true, false, static_cast<int>(i)}, {}});
+    }
+    for (int i = 0; i < strokeCount; ++i) {
+        Layer& layer = markups[static_cast<size_t>(i) % markups.size()];
+        layer.strokes.push_back(MakeStroke(rng, layer.info.id));
+    }
+    uint32_t nextLayerId = 5;
+
+    // What a full save of the markings costs, as SaveMarkupsToFile did after every change.
+    std::vector<uint8_t> bytes;
+    auto start = std::chrono::steady_clock::now();
+    Encode(markups, bytes);
+    {
+        std::ofstream out(directory / "full.dat", std::ios::binary | std::ios::trunc);
+        out.write(reinterpret_cast<const char*>(bytes.data()), static_cast<std::streamsize>(bytes.size()));
+    }
+    const double fullSaveMs = Milliseconds(start);
+    const size_t fullSaveBytes = bytes.size();
+
+    // The snapshot's own markings: quantized, and given every edit since, so a replay must match them exactly.
+    Markups reference;
+    RoadMarkupJournal journal(kHistoryBytes);
+    journal.StartAutosave(snapshotPath.string().c_str());
+    int snapshots = 0;
+    int recordsSinceSnapshot = 0;
+    const auto takeSnapshot = [&] {
+        std::vector<uint8_t> snapshot;
+        Encode(markups, snapshot);
+        Decode(snapshot.data(), snapshot.size(), reference);
+        journal.Snapshot(std::move(snapshot));
+        ++snapshots;
+        recordsSinceSnapshot = 0;
+    };
+    takeSnapshot();
+
+    int failures = 0;
+    const auto fail = [&](const char* what) {
+        std::fprintf(stderr, "FAIL: %s\n", what);
+        ++failures;
+    };
+
+    double recordMs = 0.0;
+    size_t records = 0;
+    size_t undos = 0;
+    size_t redos = 0;
+    size_t maxHistoryBytes = 0;
+    double maxLatencyMs = 0.0;
+    RoadMarkupEdit step;
+    std::uniform_int_distribution<int> percent(0, 99);
+    for (int e = 0; e < editCount; ++e) {
+        // Now and then, how long one edit takes to reach the journal file once the writer is idle.
+        const bool timeLatency = e % 2000 == 1999;
+        uintmax_t idleSize = 0;
+        if (timeLatency) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(20));
+            idleSize = std::filesystem::file_size(journalPath);
+        }
+
+        const int r = percent(rng);
+        if (r < 12 && journal.CanUndo()) {
+            start = std::chrono::steady_clock::now();
+            journal.Undo(step);
+            recordMs += Milliseconds(start);
+            if (!Apply(markups, step, true) || !Apply(reference, step, true)) {
+                fail("undo does not apply");
+            }
+            ++undos;
+        }
+        else if (r < 16 && journal.CanRedo()) {
+            start = std::chrono::steady_clock::now();
+            journal.Redo(step);
+            recordMs += Milliseconds(start);
+            if (!Apply(markups, step, false) || !Apply(reference, step, false)) {
+                fail("redo does not apply");
+            }
+            ++redos;
+        }
+        else {
+            const RoadMarkupEdit edit = MakeEdit(rng, markups, nextLayerId);
+            if (!Apply(markups, edit, false) || !Apply(reference, edit, false)) {
+                fail("edit does not apply");
+                continue;
+            }
+            start = std::chrono::steady_clock::now();
+            journal.Record(edit);
+            recordMs += Milliseconds(start);
+        }
+        ++records;
+        ++recordsSinceSnapshot;
+        maxHistoryBytes = (std::max)(maxHistoryBytes, journal.HistoryBytes());
+
+        if (timeLatency && !journal.WantsSnapshot()) {
+            start = std::chrono::steady_clock::now();
+            while (std::filesystem::file_size(journalPath) <= idleSize && Milliseconds(start) < 2000.0) {
+                std::this_thread::sleep_for(std::chrono::microseconds(100));
+            }
+            maxLatencyMs = (std::max)(maxLatencyMs, Milliseconds(start));
+        }
+        if (journal.WantsSnapshot()) {
+            takeSnapshot();
+        }
+    }
+    const size_t journalRecords = static_cast<size_t>(recordsSinceSnapshot);
+
+    if (maxHistoryBytes > kHistoryBytes) {
+        fail("history outgrew its budget");
+    }
+    if (maxLatencyMs >= 1000.0) {
+        fail("an edit took a second or more to reach the journal file");
+    }
+
+    journal.StopAutosave();
+    if (journal.AutosaveFailed()) {
+        fail("autosave write failed");
+    }
+    // Stopped without finishing, as a crash would leave it.
+    if (!RoadMarkupJournal::AutosaveLeftOpen(snapshotPath.string().c_str())) {
+        fail("an unfinished autosave is not marked as in use");
+    }
+    const std::vector<uint8_t> snapshot = ReadFile(snapshotPath);
+    const std::vector<uint8_t> log = ReadFile(journalPath);
+    const uintmax_t journalBytes = log.size();
+
+    // Recovery: the snapshot plus the whole journal.
+    Markups recovered;
+    size_t replayed = 0;
+    if (!Decode(snapshot.data(), snapshot.size(), recovered)) {
+        fail("snapshot does not load");
+    }
+    else {
+        replayed = RoadMarkupJournal::Replay(snapshot.data(), snapshot.size(), log.data(), log.size(), &Replay,
+                                             &recovered);
+        if (replayed != journalRecords) {
+            fail("replay stopped early");
+        }
+        if (!SameMarkups(recovered, reference, 0.0f)) {
+            fail("replayed markings differ from the markings");
+        }
+    }
+
+    // A crash part way through writing the last record.
+    if (journalRecords > 2) {
+        Markups torn;
+        Decode(snapshot.data(), snapshot.size(), torn);
+        if (RoadMarkupJournal::Replay(snapshot.data(), snapshot.size(), log.data(), log.size() - 3, &Replay, &torn) !=
+            journalRecords - 1) {
+            fail("torn last record not dropped alone");
+        }
+
+        // A flipped byte in the middle record.
+        std::vector<uint8_t> damaged = log;
+        size_t at = 4 * sizeof(uint32_t);
+        for (size_t i = 0; i < journalRecords / 2; ++i) {
+            uint32_t size = 0;
+            std::memcpy(&size, damaged.data() + at, sizeof(size));
+            at += 2 * sizeof(uint32_t) + size;
+        }
+        damaged[at + 2 * sizeof(uint32_t) + 1] ^= 0x40u;
+        Decode(snapshot.data(), snapshot.size(), torn);
+        if (RoadMarkupJournal::Replay(snapshot.data(), snapshot.size(), damaged.data(), damaged.size(), &Replay,
+                                      &torn) != journalRecords / 2) {
+            fail("damaged record not caught");
+        }
+    }
+
+    // A journal from another snapshot.
+    {
+        std::vector<uint8_t> other = snapshot;
+        other.back() ^= 0x01u;
+        Markups unused;
+        if (RoadMarkupJournal::Replay(other.data(), other.size(), log.data(), log.size(), &Replay, &unused) != 0) {
+            fail("journal replayed onto another snapshot");
+        }
+    }
+
+    // Everything the history holds undone, then redone.
+    const Markups before = markups;
+    size_t undone = 0;
+    while (journal.Undo(step)) {
+        if (!Apply(markups, step, true)) {
+            fail("undo does not apply");
+            break;
+        }
+        ++undone;
+    }
+    while (journal.Redo(step)) {
+        if (!Apply(markups, step, false)) {
+            fail("redo does not apply");
+            break;
+        }
+    }
+    if (!SameMarkups(markups, before, kUndoTolerance)) {
+        fail("undoing and redoing the whole history changes the markings");
+    }
+
+    // A clean shutdown leaves nothing to recover.
+    journal.StartAutosave(snapshotPath.string().c_str());
+    takeSnapshot();
+    journal.FinishAutosave();
+    if (RoadMarkupJournal::AutosaveLeftOpen(snapshotPath.string().c_str()) ||
+        std::filesystem::exists(snapshotPath) || std::filesystem::exists(journalPath)) {
+        fail("a finished autosave is left to recover");
+    }
+
+    std::printf("%d strokes, %zu layers after %d edits (%zu undos, %zu redos)\n\n", strokeCount, markups.size(),
+                editCount, undos, redos);
+    std::printf("full save           %9.2f ms  %9.1f KB\n", fullSaveMs, static_cast<double>(fullSaveBytes) / 1024.0);
+    std::printf("autosave per edit   %9.4f ms  %9.1f B   (%.0fx less time)\n", recordMs / static_cast<double>(records),
+                static_cast<double>(journalBytes - 16) / static_cast<double>((std::max)(journalRecords, size_t{1})),
+                fullSaveMs / (recordMs / static_cast<double>(records)));
+    std::printf("edit to journal     %9.2f ms  at most\n", maxLatencyMs);
+    std::printf("snapshots           %9d     (journal compacted once it outgrew the snapshot)\n", snapshots);
+    std::printf("history             %9zu steps undoable, %.1f of %.1f MB\n", undone,
+                static_cast<double>(maxHistoryBytes) / 1048576.0, static_cast<double>(kHistoryBytes) / 1048576.0);
+    std::printf("recovery            %9zu records replayed onto the snapshot\n", replayed);
+
+    std::filesystem::remove_all(directory);
+    if (failures > 0) {
+        std::fprintf(stderr, "FAIL: %d check(s) failed\n", failures);
+        return 1;
+    }
+    std::printf("\nall checks passed\n");
+    return 0;
+}
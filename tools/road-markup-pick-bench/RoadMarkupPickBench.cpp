@@ -0,0 +1,206 @@
+// Correctness check and benchmark for the grid behind SelectRoadMarkupStrokeAtPoint.
+//
+// Scatters strokes over a large city (lane lines of 2 to 6 points, long two-point lines, and single-click arrows) and
+// picks with the 2.5 m radius the input control uses, at points next to strokes and at random points. Every pick is
+// checked against a brute-force scan of all segments, and both are timed. Also times the per-edit Update/Remove calls
+// that keep the grid current as strokes are moved, deleted and added. Exits non-zero if any pick differs from the scan.
+//
+// Usage: road-markup-pick-bench [stroke-count] [pick-count]
+
+#include "sample/road-decal/RoadMarkupSpatialIndex.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <utility>
+#include <vector>
+
+namespace {
+    constexpr float kMapSize = 4096.0f;
+    constexpr float kPickRadius = 2.5f;
+    constexpr float kTileSize = 16.0f;
+
+    struct Pick {
+        float x;
+        float z;
+    };
+
+    std::vector<RoadMarkupStroke> MakeStrokes(const int count, std::mt19937& rng) {
+        std::uniform_real_distribution<float> position(0.0f, kMapSize);
+        std::uniform_real_distribution<float> angle(0.0f, 6.2831853f);
+        std::uniform_int_distribution<int> kind(0, 9);
+
+        std::vector<RoadMarkupStroke> strokes(static_cast<size_t>(count));
+        for (int i = 0; i < count; ++i) {
+            auto& stroke = strokes[static_cast<size_t>(i)];
+            stroke.id = static_cast<uint32_t>(i + 1);
+            const int k = kind(rng);
+            const int points = k < 6 ? std::uniform_int_distribution<int>(2, 6)(rng) : (k < 8 ? 2 : 1);
+            const float step = k < 6 ? 12.0f : 150.0f;
+            float x = position(rng);
+            float z = position(rng);
+            float heading = angle(rng);
+            for (int p = 0; p < points; ++p) {
+                stroke.points.push_back({x, 0.0f, z, false});
+                heading += std::uniform_real_distribution<float>(-0.4f, 0.4f)(rng);
+                x += std::cos(heading) * step;
+                z += std::sin(heading) * step;
+            }
+        }
+        return strokes;
+    }
+
+    float DistanceSquaredToSegment(const float px, const float pz, const RoadDecalPoint& a, const RoadDecalPoint& b) {
+        const float abX = b.x - a.x;
+        const float abZ = b.z - a.z;
+        const float apX = px - a.x;
+        const float apZ = pz - a.z;
+        const float abLen2 = abX * abX + abZ * abZ;
+        if (abLen2 <= 1.0e-6f) {
+            return apX * apX + apZ * apZ;
+        }
+        const float t = std::clamp((apX * abX + apZ * abZ) / abLen2, 0.0f, 1.0f);
+        const float dx = px - (a.x + abX * t);
+        const float dz = pz - (a.z + abZ * t);
+        return dx * dx + dz * dz;
+    }
+
+    // The scan the index replaces, with the same tie rule: the higher key wins.
+    uint32_t ScanNearest(const std::vector<RoadMarkupStroke>& strokes, const Pick& pick, float& outDistance2) {
+        float best = kPickRadius * kPickRadius;
+        uint32_t bestKey = 0;
+        for (const auto& stroke : strokes) {
+            const size_t count = stroke.points.size();
+            for (size_t i = 0; i < (count == 1 ? 1 : count - 1); ++i) {
+                const float d2 = DistanceSquaredToSegment(pick.x, pick.z, stroke.points[i],
+                                                          stroke.points[count == 1 ? i : i + 1]);
+                if (d2 < best || (d2 == best && stroke.id > bestKey)) {
+                    best = d2;
+                    bestKey = stroke.id;
+                }
+            }
+        }
+        outDistance2 = best;
+        return bestKey;
+    }
+
+    double Milliseconds(const std::chrono::steady_clock::time_point start) {
+        return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    }
+}
+
+int main(const int argc, char** argv) {
+    const int strokeCount = argc > 1 ? std::atoi(argv[1]) : 50000;
+    const int pickCount = argc > 2 ? std::atoi(argv[2]) : 2000;
+    if (strokeCount < 1 || pickCount < 1) {
+        std::fprintf(stderr, "usage: %s [stroke-count >= 1] [pick-count >= 1]\n", argv[0]);
+        return 2;
+    }
+
+    std::mt19937 rng(0x91C4u);
+    std::vector<RoadMarkupStroke> strokes = MakeStrokes(strokeCount, rng);
+
+    // Half the picks land next to a stroke point, like a click on a marking; the rest anywhere on the map.
+    std::vector<Pick> picks;
+    std::uniform_real_distribution<float> position(0.0f, kMapSize);
+    std::uniform_real_distribution<float> jitter(-3.0f, 3.0f);
+    std::uniform_int_distribution<size_t> anyStroke(0, strokes.size() - 1);
+    for (int i = 0; i < pickCount; ++i) {
+        if (i % 2 == 0) {
+            const auto& stroke = strokes[anyStroke(rng)];
+            const auto& p = stroke.points[std::uniform_int_distribution<size_t>(0, stroke.points.size() - 1)(rng)];
+            picks.push_back({p.x + jitter(rng), p.z + jitter(rng)});
+        }
+        else {
+            picks.push_back({position(rng), position(rng)});
+        }
+    }
+
+    RoadMarkupSpatialIndex index(kTileSize);
+    auto start = std::chrono::steady_clock::now();
+    for (const auto& stroke : strokes) {
+        index.Update(stroke.id, stroke.points.data(), stroke.points.size());
+    }
+    const double buildMs = Milliseconds(start);
+    std::printf("%d strokes, %zu segments in %zu cells, built in %.2f ms\n\n", strokeCount, index.SegmentCount(),
+                index.CellCount(), buildMs);
+
+    int mismatches = 0;
+    int hits = 0;
+    double indexUs = 0.0;
+    double scanUs = 0.0;
+    const auto check = [&](const char* phase) {
+        for (const Pick& pick : picks) {
+            float indexDistance2 = 0.0f;
+            float scanDistance2 = 0.0f;
+            auto begin = std::chrono::steady_clock::now();
+            const uint32_t indexKey = index.FindNearest(pick.x, pick.z, kPickRadius, nullptr, nullptr,
+                                                        &indexDistance2);
+            indexUs += Milliseconds(begin) * 1000.0;
+            begin = std::chrono::steady_clock::now();
+            const uint32_t scanKey = ScanNearest(strokes, pick, scanDistance2);
+            scanUs += Milliseconds(begin) * 1000.0;
+            hits += scanKey != 0;
+            if (indexKey != scanKey) {
+                if (++mismatches <= 5) {
+                    std::fprintf(stderr, "FAIL %s: pick (%.2f, %.2f) found %u, scan found %u\n", phase, pick.x,
+                                 pick.z, indexKey, scanKey);
+                }
+            }
+        }
+    };
+
+    check("initial");
+
+    // Edit the set the way the markup store does: one Update per moved or added stroke, one Remove per deleted one.
+    constexpr int kEdits = 200;
+    double moveUs = 0.0;
+    for (int i = 0; i < kEdits; ++i) {
+        auto& stroke = strokes[anyStroke(rng)];
+        for (auto& p : stroke.points) {
+            p.x += 4.0f;
+            p.z -= 2.0f;
+        }
+        start = std::chrono::steady_clock::now();
+        index.Update(stroke.id, stroke.points.data(), stroke.points.size());
+        moveUs += Milliseconds(start) * 1000.0;
+    }
+    double removeUs = 0.0;
+    for (int i = 0; i < kEdits && strokes.size() > 1; ++i) {
+        const size_t at = std::uniform_int_distribution<size_t>(0, strokes.size() - 1)(rng);
+        start = std::chrono::steady_clock::now();
+        index.Remove(strokes[at].id);
+        removeUs += Milliseconds(start) * 1000.0;
+        strokes[at] = std::move(strokes.back());
+        strokes.pop_back();
+    }
+    std::mt19937 addRng(0xADDu);
+    std::vector<RoadMarkupStroke> added = MakeStrokes(kEdits, addRng);
+    double addUs = 0.0;
+    for (auto& stroke : added) {
+        stroke.id += static_cast<uint32_t>(strokeCount);
+        start = std::chrono::steady_clock::now();
+        index.Update(stroke.id, stroke.points.data(), stroke.points.size());
+        addUs += Milliseconds(start) * 1000.0;
+        strokes.push_back(std::move(stroke));
+    }
+    check("after edits");
+
+    const double picksDone = 2.0 * pickCount;
+    std::printf("%-24s %12s %12s\n", "", "grid", "scan");
+    std::printf("%-24s %12.3f %12.3f\n", "pick (us)", indexUs / picksDone, scanUs / picksDone);
+    std::printf("%-24s %12.3f\n", "update after move (us)", moveUs / kEdits);
+    std::printf("%-24s %12.3f\n", "remove (us)", removeUs / kEdits);
+    std::printf("%-24s %12.3f\n", "update after add (us)", addUs / kEdits);
+    std::printf("\n%d of %.0f picks hit a stroke\n", hits, picksDone);
+
+    if (mismatches > 0) {
+        std::fprintf(stderr, "FAIL: %d pick(s) differ from the scan\n", mismatches);
+        return 1;
+    }
+    std::printf("all checks passed\n");
+    return 0;
+}
@@ -0,0 +1,262 @@
+// Correctness check and benchmark for the native terrain ray cast behind cIGZS3DCameraService::PickTerrain.
+//
+// Builds synthetic heightfields the size of a large city (256 x 256 cells) and casts camera-like rays at them: a random
+// target on the map, a random yaw, a pitch between 30 and 70 degrees and a distance up to 4000 units, the range of the
+// game's zoom levels. Each hit is checked against a brute-force reference that marches the same bilinear surface in
+// half-unit steps and bisects the first crossing. Exits non-zero if the DDA misses a surface the reference finds, lands
+// behind the reference hit, or reports a point that is neither on the surface nor on the map edge.
+//
+// Usage: terrain-pick-bench [ray-count] [iterations]
+
+#include "service/TerrainHeightGrid.h"
+
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <functional>
+#include <random>
+#include <vector>
+
+namespace {
+    constexpr uint32_t kCells = 256;
+    constexpr float kMapSize = kCells * TerrainHeightGrid::kGridSpacing;
+    constexpr float kMaxDistance = 20000.0f;
+    constexpr float kReferenceStep = 0.5f;
+    constexpr float kTolerance = 0.05f;
+
+    struct Ray {
+        float origin[3];
+        float direction[3];
+    };
+
+    void Fill(TerrainHeightGrid& grid, const std::function<float(float, float)>& height) {
+        grid.Reset(kCells, kCells);
+        for (uint32_t z = 0; z < grid.VerticesZ(); ++z) {
+            float* row = grid.Row(z);
+            for (uint32_t x = 0; x < grid.VerticesX(); ++x) {
+                row[x] = height(x * TerrainHeightGrid::kGridSpacing, z * TerrainHeightGrid::kGridSpacing);
+            }
+        }
+        grid.UpdateBounds(0, grid.VerticesZ() - 1);
+    }
+
+    // Smooth value noise in [0, 1], enough to give the fractal field some ridges and valleys.
+    float ValueNoise(const float x, const float z, const uint32_t seed) {
+        const auto lattice = [seed](const int32_t ix, const int32_t iz) {
+            uint32_t h = static_cast<uint32_t>(ix) * 374761393u + static_cast<uint32_t>(iz) * 668265263u + seed;
+            h = (h ^ (h >> 13)) * 1274126177u;
+            return static_cast<float>((h ^ (h >> 16)) & 0xFFFFu) / 65535.0f;
+        };
+        const float fx = std::floor(x);
+        const float fz = std::floor(z);
+        const auto ix = static_cast<int32_t>(fx);
+        const auto iz = static_cast<int32_t>(fz);
+        const float tx = (x - fx) * (x - fx) * (3.0f - 2.0f * (x - fx));
+        const float tz = (z - fz) * (z - fz) * (3.0f - 2.0f * (z - fz));
+        const float a = lattice(ix, iz) + (lattice(ix + 1, iz) - lattice(ix, iz)) * tx;
+        const float b = lattice(ix, iz + 1) + (lattice(ix + 1, iz + 1) - lattice(ix, iz + 1)) * tx;
+        return a + (b - a) * tz;
+    }
+
+    std::vector<Ray> MakeCameraRays(const uint32_t count, const uint32_t seed) {
+        constexpr float kDegrees = 3.14159265f / 180.0f;
+        std::mt19937 rng(seed);
+        std::uniform_real_distribution<float> target(0.0f, kMapSize);
+        std::uniform_real_distribution<float> yaw(0.0f, 360.0f * kDegrees);
+        std::uniform_real_distribution<float> pitch(30.0f * kDegrees, 70.0f * kDegrees);
+        std::uniform_real_distribution<float> distance(300.0f, 4000.0f);
+        std::vector<Ray> rays(count);
+        for (auto& ray : rays) {
+            const float p = pitch(rng);
+            const float y = yaw(rng);
+            const float d = distance(rng);
+            ray.direction[0] = std::cos(p) * std::sin(y);
+            ray.direction[1] = -std::sin(p);
+            ray.direction[2] = std::cos(p) * std::cos(y);
+            const float tx = target(rng);
+            const float tz = target(rng);
+            ray.origin[0] = tx - ray.direction[0] * d;
+            ray.origin[1] = 250.0f - ray.direction[1] * d;
+            ray.origin[2] = tz - ray.direction[2] * d;
+        }
+        return rays;
+    }
+
+    bool OverMap(const float x, const float z) {
+        return x >= 0.0f && x <= kMapSize && z >= 0.0f && z <= kMapSize;
+    }
+
+    bool OnMapEdge(const float x, const float z) {
+        constexpr float kEpsilon = 1.0e-3f;
+        return x <= kEpsilon || z <= kEpsilon || x >= kMapSize - kEpsilon || z >= kMapSize - kEpsilon;
+    }
+
+    // Brute force: fixed steps along the ray, bisecting the first step that ends below the surface.
+    bool ReferenceRaycast(const TerrainHeightGrid& grid, const Ray& ray, float& outDistance) {
+        const auto above = [&](const float t) {
+            const float x = ray.origin[0] + ray.direction[0] * t;
+            const float z = ray.origin[2] + ray.direction[2] * t;
+            return ray.origin[1] + ray.direction[1] * t - grid.SampleHeight(x, z);
+        };
+        bool wasOver = false;
+        const auto steps = static_cast<uint32_t>(kMaxDistance / kReferenceStep);
+        for (uint32_t step = 0; step <= steps; ++step) {
+            const float t = static_cast<float>(step) * kReferenceStep;
+            const bool over = OverMap(ray.origin[0] + ray.direction[0] * t, ray.origin[2] + ray.direction[2] * t);
+            if (over && above(t) <= 0.0f) {
+                float lo = wasOver ? t - kReferenceStep : t;
+                float hi = t;
+                for (int i = 0; i < 40 && wasOver; ++i) {
+                    const float mid = 0.5f * (lo + hi);
+                    (above(mid) > 0.0f ? lo : hi) = mid;
+                }
+                outDistance = hi;
+                return true;
+            }
+            wasOver = over;
+        }
+        return false;
+    }
+
+    bool RunCase(const char* name, const TerrainHeightGrid& grid, const std::vector<Ray>& rays,
+                 const int iterations) {
+        uint32_t hits = 0;
+        uint32_t skipped = 0;
+        uint32_t grazing = 0;
+        uint32_t failures = 0;
+        double maxError = 0.0;
+        for (const Ray& ray : rays) {
+            // Cameras are never inside the terrain; the generator does not know the heightfield, so drop those rays.
+            if (OverMap(ray.origin[0], ray.origin[2]) &&
+                ray.origin[1] <= grid.SampleHeight(ray.origin[0], ray.origin[2])) {
+                ++skipped;
+                continue;
+            }
+            TerrainRayHit hit{};
+            const bool native = grid.Raycast(ray.origin, ray.direction, kMaxDistance, hit);
+            float referenceDistance = 0.0f;
+            const bool reference = ReferenceRaycast(grid, ray, referenceDistance);
+            if (native) {
+                ++hits;
+                // Rays that enter through the map edge below the surface hit the edge skirt, not the surface.
+                const float residual = hit.position[1] - grid.SampleHeight(hit.position[0], hit.position[2]);
+                if (!OnMapEdge(hit.position[0], hit.position[2]) && std::fabs(residual) > kTolerance) {
+                    ++failures;
+                    continue;
+                }
+            }
+            if (reference && !native) {
+                ++failures;
+                continue;
+            }
+            if (!reference) {
+                // The reference steps over crossings thinner than its step; a native hit must still be on the surface.
+                grazing += native ? 1 : 0;
+                continue;
+            }
+            // The reference only finds edge entries to the nearest step.
+            const double error = hit.distance - referenceDistance;
+            if (OnMapEdge(hit.position[0], hit.position[2])) {
+                failures += std::fabs(error) > kReferenceStep ? 1 : 0;
+            }
+            else if (error > kTolerance) {
+                ++failures;
+            }
+            else if (error < -kTolerance) {
+                ++grazing;
+            }
+            else {
+                maxError = std::fmax(maxError, std::fabs(error));
+            }
+        }
+
+        volatile float sink = 0.0f;
+        const auto start = std::chrono::steady_clock::now();
+        for (int it = 0; it < iterations; ++it) {
+            for (const Ray& ray : rays) {
+                TerrainRayHit hit{};
+                if (grid.Raycast(ray.origin, ray.direction, kMaxDistance, hit)) {
+                    sink = hit.distance;
+                }
+            }
+        }
+        const auto middle = std::chrono::steady_clock::now();
+        for (size_t i = 0; i < rays.size() / 16; ++i) {
+            float distance = 0.0f;
+            if (ReferenceRaycast(grid, rays[i], distance)) {
+                sink = distance;
+            }
+        }
+        const auto end = std::chrono::steady_clock::now();
+        static_cast<void>(sink);
+        const double nativeNs = std::chrono::duration<double, std::nano>(middle - start).count() /
+                                (static_cast<double>(rays.size()) * iterations);
+        const double referenceNs = std::chrono::duration<double, std::nano>(end - middle).count() /
+                                   static_cast<double>(rays.size() / 16);
+
+        const bool ok = failures == 0;
+        std::printf("%-16s %7u %7u %7u %9.5f %10.1f %12.1f %s\n", name, hits, skipped, grazing, maxError, nativeNs,
+                    referenceNs, ok ? "ok" : "FAIL");
+        if (!ok) {
+            std::fprintf(stderr, "FAIL %s: %u ray(s) missed, overshot or left the surface\n", name, failures);
+        }
+        return ok;
+    }
+}
+
+int main(const int argc, char** argv) {
+    const uint32_t count = argc > 1 ? static_cast<uint32_t>(std::strtoul(argv[1], nullptr, 10)) : 4096;
+    const int iterations = argc > 2 ? std::atoi(argv[2]) : 20;
+    if (count < 16 || iterations <= 0) {
+        std::fprintf(stderr, "usage: %s [ray-count >= 16] [iterations]\n", argv[0]);
+        return 2;
+    }
+
+    const std::vector<Ray> rays = MakeCameraRays(count, 4242);
+    TerrainHeightGrid grid;
+    bool ok = true;
+
+    std::printf("%-16s %7s %7s %7s %9s %10s %12s\n", "heightfield", "hits", "skipped", "grazing", "max err",
+                "dda ns", "reference ns");
+
+    Fill(grid, [](float, float) { return 250.0f; });
+    ok &= RunCase("flat", grid, rays, iterations);
+
+    Fill(grid, [](const float x, const float z) {
+        return 250.0f + 60.0f * std::sin(x * 0.004f) * std::cos(z * 0.003f) + 25.0f * std::sin((x + z) * 0.011f);
+    });
+    ok &= RunCase("rolling hills", grid, rays, iterations);
+
+    Fill(grid, [](const float x, const float z) {
+        float h = 0.0f;
+        float amplitude = 400.0f;
+        float frequency = 1.0f / 900.0f;
+        for (uint32_t octave = 0; octave < 5; ++octave) {
+            h += amplitude * ValueNoise(x * frequency, z * frequency, 17u + octave);
+            amplitude *= 0.45f;
+            frequency *= 2.1f;
+        }
+        return 50.0f + h;
+    });
+    ok &= RunCase("fractal ridges", grid, rays, iterations);
+
+    Fill(grid, [](const float x, const float z) {
+        const float base = 200.0f + 300.0f * ValueNoise(x / 700.0f, z / 700.0f, 99u);
+        return std::floor(base / 40.0f) * 40.0f;
+    });
+    ok &= RunCase("terraced cliffs", grid, rays, iterations);
+
+    Fill(grid, [](const float x, const float z) {
+        const float dx = x - kMapSize * 0.5f;
+        const float dz = z - kMapSize * 0.5f;
+        return 250.0f + 1500.0f * std::exp(-(dx * dx + dz * dz) / (2.0f * 200.0f * 200.0f));
+    });
+    ok &= RunCase("central peak", grid, rays, iterations);
+
+    if (!ok) {
+        return 1;
+    }
+    std::printf("\nall checks passed\n");
+    return 0;
+}